@@ -0,0 +1,49 @@
+#include <QtCore>
+#include "dqasyncworker_p.h"
+#include "dqsql.h"
+
+_DQAsyncWorker::_DQAsyncWorker(DQConnection* base) : _DQCloneThread(base,"dqasync","async worker") {
+    startClone();
+}
+
+_DQAsyncWorker::~_DQAsyncWorker(){
+    stopClone();
+}
+
+void _DQAsyncWorker::submit(_DQAsyncJob* job){
+    QMutexLocker locker(&m_mutex);
+    if (m_stop) {
+        job->cancel();
+        delete job;
+        return;
+    }
+
+    m_jobs.enqueue(job);
+    m_wake.wakeAll();
+}
+
+void _DQAsyncWorker::process(){
+    m_mutex.lock();
+    for (;;) {
+        while (m_jobs.isEmpty() && !m_stop)
+            m_wake.wait(&m_mutex);
+
+        if (m_stop)
+            break;
+
+        _DQAsyncJob *job = m_jobs.dequeue();
+        m_mutex.unlock();
+
+        job->run();
+        delete job;
+
+        m_mutex.lock();
+    }
+
+    while (!m_jobs.isEmpty()) {
+        _DQAsyncJob *job = m_jobs.dequeue();
+        job->cancel();
+        delete job;
+    }
+    m_mutex.unlock();
+}
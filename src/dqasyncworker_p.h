@@ -0,0 +1,80 @@
+#ifndef DQASYNCWORKER_P_H
+#define DQASYNCWORKER_P_H
+
+#include <QQueue>
+#include <QFutureInterface>
+#include "dqclonethread_p.h"
+#include "dqsharedquery.h"
+
+/// A job run by _DQAsyncWorker
+class _DQAsyncJob {
+public:
+    virtual ~_DQAsyncJob() {
+    }
+
+    /// Run the job on the worker thread
+    virtual void run() = 0;
+
+    /// The job is discarded without running
+    virtual void cancel() = 0;
+};
+
+/// Run a DQSharedQuery function and report the result to a QFuture
+template <typename T>
+class _DQAsyncQueryJob : public _DQAsyncJob {
+public:
+    typedef T (*Function)(DQSharedQuery query,QString func,QStringList fields);
+
+    inline _DQAsyncQueryJob(DQSharedQuery query,Function function,QString func,QStringList fields) :
+        m_query(query) , m_function(function) , m_func(func) , m_fields(fields) {
+        m_future.reportStarted();
+    }
+
+    QFuture<T> future() {
+        return m_future.future();
+    }
+
+    void run() {
+        if (!m_future.isCanceled())
+            m_future.reportResult(m_function(m_query,m_func,m_fields));
+        m_future.reportFinished();
+    }
+
+    void cancel() {
+        m_future.reportCanceled();
+        m_future.reportFinished();
+    }
+
+    DQSharedQuery m_query;
+
+private:
+    Function m_function;
+    QString m_func;
+    QStringList m_fields;
+    QFutureInterface<T> m_future;
+};
+
+/// The worker thread of a connection for asynchronous query
+/**
+  The worker owns a clone of the connection's database (_DQCloneThread).
+  Jobs are run one by one in the order of submission.
+ */
+class _DQAsyncWorker : public _DQCloneThread {
+public:
+    /// Start the worker. It blocks until the database is cloned.
+    explicit _DQAsyncWorker(DQConnection* base);
+
+    /// Stop the worker. The pending jobs are canceled.
+    ~_DQAsyncWorker();
+
+    /// Queue a job. The ownership is taken.
+    void submit(_DQAsyncJob* job);
+
+protected:
+    void process();
+
+private:
+    QQueue<_DQAsyncJob*> m_jobs;
+};
+
+#endif // DQASYNCWORKER_P_H
@@ -2,8 +2,19 @@
 #include <QSharedData>
 #include <QString>
 #include <QtCore>
+#include "dqmodel.h"
+#include "dqmodelmetainfo.h"
+#include "dqfieldprofile_p.h"
 
-DQBaseField::DQBaseField()
+/* Test cases:
+
+  sqlitetests::deferredField()
+  sqlitetests::autoOnly()
+  sqlitetests::sharedCopy()
+
+ */
+
+DQBaseField::DQBaseField() : m_dirty(false) , m_deferred(false) , m_sampled(false) , m_offset(0)
 {
 }
 
@@ -11,39 +22,122 @@ DQBaseField::~DQBaseField()
 {
 }
 
-bool DQBaseField::set(QVariant val){
+DQClause DQBaseField::clause(){
+    return DQClause();
+}
+
+void DQBaseField::setDeferred(const DQAbstractModel *model){
+    m_deferred = true;
+    m_sampled = false;
+    m_offset = (const quint8*) this - (const quint8*) model;
+}
+
+void DQBaseField::setSampled(const DQAbstractModel *model){
+    m_deferred = true;
+    m_sampled = true;
+    m_offset = (const quint8*) this - (const quint8*) model;
+}
+
+void DQBaseField::loadDeferred() const{
+    bool sampled = m_sampled;
+    m_deferred = false;
+    m_sampled = false;
+
+    // DQModel is the only derived class of DQAbstractModel
+    DQModel *model = static_cast<DQModel*>((DQAbstractModel*) ((quint8*) this - m_offset));
+    DQModelMetaInfo *info = model->metaInfo();
+
+    int n = info->size();
+    for (int i = 0 ; i < n;i++) {
+        if (info->at(i)->offset != m_offset)
+            continue;
+
+        if (model->m_fieldProfile)
+            model->m_fieldProfile->access(i);
+
+        if (sampled)
+            return;
+
+        QString name = info->at(i)->name;
+        if (!model->loadFields(QStringList() << name)) {
+            qWarning() << QString("DQBaseField - Failed to load the deferred field %1 of %2").arg(name).arg(info->name());
+        }
+        return;
+    }
+}
+
+DQVariantField::DQVariantField()
+{
+}
+
+DQVariantField::DQVariantField(const DQVariantField& rhs) : DQBaseField(rhs) , m_value(rhs.m_value)
+{
+}
+
+DQVariantField& DQVariantField::operator=(const DQVariantField& rhs){
+    DQBaseField::operator=(rhs);
+    m_value = rhs.m_value;
+    return *this;
+}
+
+#ifdef Q_COMPILER_RVALUE_REFS
+DQVariantField::DQVariantField(DQVariantField&& rhs) : DQBaseField(rhs)
+{
+    m_value.swap(rhs.m_value);
+}
+
+DQVariantField& DQVariantField::operator=(DQVariantField&& rhs){
+    DQBaseField::operator=(rhs);
+    m_value.swap(rhs.m_value);
+    return *this;
+}
+#endif
+
+bool DQVariantField::set(QVariant val){
     m_value = val;
+    m_dirty = true;
+    m_deferred = false;
     return true;
 }
 
-QVariant DQBaseField::get(bool convert) const {
+QVariant DQVariantField::get(bool convert) const {
     Q_UNUSED(convert);
+    ensureLoaded();
     return m_value;
 }
 
-DQClause DQBaseField::clause(){
-    return DQClause();
-}
-
-QVariant DQBaseField::operator=(const QVariant &val){
+QVariant DQVariantField::operator=(const QVariant &val){
     m_value = val;
+    m_dirty = true;
+    m_deferred = false;
     return val;
 }
 
-QVariant* DQBaseField::operator->(){
+QVariant* DQVariantField::operator->(){
+    ensureLoaded();
+    m_dirty = true; // The value may be changed through the pointer
+    return &m_value;
+}
+
+const QVariant* DQVariantField::operator->() const {
+    ensureLoaded();
     return &m_value;
 }
 
-QVariant DQBaseField::operator() () const {
+QVariant DQVariantField::operator() () const {
+    ensureLoaded();
     return m_value;
 }
 
- DQBaseField::operator QVariant(){
+ DQVariantField::operator QVariant(){
+    ensureLoaded();
     return m_value;
 }
 
- void DQBaseField::clear(){
+ void DQVariantField::clear(){
     m_value.clear();
+    m_dirty = true;
+    m_deferred = false;
  }
 
  QDebug operator<<(QDebug dbg, const DQBaseField &field){
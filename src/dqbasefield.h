@@ -6,17 +6,28 @@
 #include <dqclause.h>
 
 class DQModel;
+class DQAbstractModel;
 
-/// The base class of DQField
+/// The base class of database field
+/**
+  DQBaseField is the interface used by DQModelMetaInfo to read and write
+  the fields of a model. It do not hold the value, only the dirty state. The
+  storage is provided by the derived class:
+
+  <ul>
+  <li> DQVariantField / DQField store the value in QVariant </li>
+  <li> DQTypedField store the value in its template type directly </li>
+  </ul>
+ */
 
 class DQBaseField
 {
 public:
     DQBaseField();
-    ~DQBaseField();
+    virtual ~DQBaseField();
 
     /// Assign value to the field
-    virtual bool set(QVariant value);
+    virtual bool set(QVariant value) = 0;
 
     /// Get the value of the field
     /**
@@ -25,17 +36,105 @@ public:
       Some data type like QStringList is not suitable for saving. User may override
       this function and convert its to other type.
      */
-    virtual QVariant get(bool convert = false) const;
+    virtual QVariant get(bool convert = false) const = 0;
 
     /// The default clause of that field type
     static DQClause clause();
 
+    /// TRUE if the value is changed since it is loaded from or saved to database
+    /**
+      The state is set by set() and the assignment operators. DQModel::save()
+      only write the dirty fields of an existing record.
+
+      The non-const DQField::operator->() marks the field as dirty , as the value
+      may be changed through the pointer. Use the const overload or operator()()
+      to read the value without changing the state.
+     */
+    inline bool isDirty() const {
+        return m_dirty;
+    }
+
+    /// Set the dirty state
+    inline void setDirty(bool dirty = true) {
+        m_dirty = dirty;
+    }
+
+    /// TRUE if the value is not loaded yet
+    /**
+      A deferred field is left out by the query ( DQSharedQuery::defer() or DQDeferred clause ).
+      It is loaded from database on first access of its value. Assigning a value
+      cancel the loading.
+     */
+    inline bool isDeferred() const {
+        return m_deferred && !m_sampled;
+    }
+
+    /// Mark the field of model as not loaded. (Internal use)
+    void setDeferred(const DQAbstractModel *model);
+
+    /// Mark the loaded field of model to record its first access. (Internal use)
+    /**
+      @see DQSharedQuery::autoOnly()
+     */
+    void setSampled(const DQAbstractModel *model);
+
+protected:
+    /// Load the value if it is deferred. It should be called by every reader of the value
+    inline void ensureLoaded() const {
+        if (m_deferred)
+            loadDeferred();
+    }
+
+    bool m_dirty;
+
+    mutable bool m_deferred;
+
+    /// The value is loaded. The first access is only recorded by the field profile of the model
+    mutable bool m_sampled;
+
+    /// The offset of field in model. Only valid for deferred field
+    int m_offset;
+
+private:
+    void loadDeferred() const;
+};
+
+/// The base class of DQField which store the value in QVariant
+
+class DQVariantField : public DQBaseField
+{
+public:
+    DQVariantField();
+
+    /// Copy constructor. The QVariant is implicitly shared , the value is not copied until it is changed.
+    DQVariantField(const DQVariantField& rhs);
+
+    /// Copy the value and state of other field
+    DQVariantField& operator=(const DQVariantField& rhs);
+
+#ifdef Q_COMPILER_RVALUE_REFS
+    /// Move constructor
+    DQVariantField(DQVariantField&& rhs);
+
+    /// Move assignment
+    DQVariantField& operator=(DQVariantField&& rhs);
+#endif
+
+    /// Assign value to the field
+    virtual bool set(QVariant value);
+
+    /// Get the value of the field
+    virtual QVariant get(bool convert = false) const;
+
     /// Assign the value from a QVariant type source.
     virtual QVariant operator=(const QVariant &val);
 
-    /// Provides access to stored QVariant value
+    /// Provides access to stored QVariant value. The field is marked as dirty
     QVariant* operator->();
 
+    /// Provides read only access to stored QVariant value
+    const QVariant* operator->() const;
+
     /// Get the value of the field
     QVariant operator() ()const;
 
@@ -0,0 +1,219 @@
+#include <QtCore>
+#include <string.h>
+#include <QSqlQuery>
+#include <QSqlError>
+#include "dqblobstream.h"
+#include "dqsqlite_p.h"
+#include "dqmodel.h"
+#include "dqsql.h"
+
+/* Test cases:
+
+  sqlitetests::blobStream()
+
+ */
+
+DQBlobStream::DQBlobStream(DQModel *model,QString field,QObject *parent) : QIODevice(parent) ,
+    m_connection(model->connection()) , m_metaInfo(model->metaInfo()) , m_field(field) , m_id(model->id.get()) ,
+    m_blob(0) , m_size(0) , m_written(false) {
+}
+
+DQBlobStream::DQBlobStream(DQConnection connection,DQModelMetaInfo *metaInfo,QString field,QVariant id,QObject *parent) :
+    QIODevice(parent) ,
+    m_connection(connection) , m_metaInfo(metaInfo) , m_field(field) , m_id(id) ,
+    m_blob(0) , m_size(0) , m_written(false) {
+}
+
+DQBlobStream::~DQBlobStream(){
+    close();
+}
+
+bool DQBlobStream::open(OpenMode mode){
+    if (isOpen()) {
+        qWarning() << "DQBlobStream::open() - The stream is already opened";
+        return false;
+    }
+
+    if (mode & (Append | Truncate)) {
+        qWarning() << "DQBlobStream::open() - Append and Truncate mode are not supported";
+        return false;
+    }
+
+    if (!m_metaInfo || m_metaInfo->indexOf(m_field) < 0 || m_id.isNull()) {
+        qWarning() << QString("DQBlobStream::open() - Invalid field %1 or the record is not saved").arg(m_field);
+        return false;
+    }
+
+#ifdef DQ_SQLITE_API
+    sqlite3 *handle = _dqSqliteHandle(m_connection.sql().database());
+    if (!handle) {
+        qWarning() << "DQBlobStream::open() - The connection is not opened by the QSQLITE driver";
+        return false;
+    }
+
+    QByteArray table = m_metaInfo->name().toUtf8();
+    QByteArray column = m_field.toUtf8();
+
+    int rc = sqlite3_blob_open(handle,"main",table.constData(),column.constData(),
+                               m_id.toLongLong(),(mode & WriteOnly) ? 1 : 0,&m_blob);
+    if (rc != SQLITE_OK) {
+        setErrorString(QString::fromUtf8(sqlite3_errmsg(handle)));
+        qWarning() << QString("DQBlobStream::open() - Failed to open %1.%2 of record %3 : %4")
+                      .arg(m_metaInfo->name()).arg(m_field).arg(m_id.toString()).arg(errorString());
+        if (m_blob) {
+            sqlite3_blob_close(m_blob);
+            m_blob = 0;
+        }
+        return false;
+    }
+
+    m_size = sqlite3_blob_bytes(m_blob);
+#else
+    // Without the C API the blob is accessed by substr() of SQL
+    QSqlQuery q = m_connection.query();
+    q.prepare(QString("SELECT length(%1) FROM %2 WHERE id = :id;").arg(m_field).arg(m_metaInfo->name()));
+    q.bindValue(":id",m_id);
+    if (!q.exec() || !q.next()) {
+        setErrorString(q.lastError().isValid() ? q.lastError().text() : QString("The record is not found"));
+        qWarning() << QString("DQBlobStream::open() - Failed to open %1.%2 of record %3 : %4")
+                      .arg(m_metaInfo->name()).arg(m_field).arg(m_id.toString()).arg(errorString());
+        return false;
+    }
+
+    m_size = q.value(0).toLongLong();
+#endif
+    m_written = false;
+
+    // The position is maintained by QIODevice. No buffer is needed for random access.
+    return QIODevice::open(mode | Unbuffered);
+}
+
+void DQBlobStream::close(){
+    if (!isOpen())
+        return;
+
+    QIODevice::close();
+
+#ifdef DQ_SQLITE_API
+    if (m_blob) {
+        sqlite3_blob_close(m_blob);
+        m_blob = 0;
+    }
+#endif
+
+    if (m_written) {
+        m_connection.sql().notifyTableChanged(m_metaInfo->name());
+        m_written = false;
+    }
+
+    m_size = 0;
+}
+
+qint64 DQBlobStream::size() const{
+    return m_size;
+}
+
+bool DQBlobStream::isSequential() const{
+    return false;
+}
+
+bool DQBlobStream::allocate(DQModel *model,QString field,qint64 size){
+    DQModelMetaInfo *info = model->metaInfo();
+    QVariant id = model->id.get();
+    if (info->indexOf(field) < 0 || id.isNull() || size < 0) {
+        qWarning() << QString("DQBlobStream::allocate() - Invalid field %1 or the record is not saved").arg(field);
+        return false;
+    }
+
+    DQConnection connection = model->connection();
+    QSqlQuery q = connection.query();
+    q.prepare(QString("UPDATE %1 SET %2 = zeroblob(:size) WHERE id = :id;").arg(info->name()).arg(field));
+    q.bindValue(":size",size);
+    q.bindValue(":id",id);
+
+    bool res = q.exec();
+    connection.setLastQuery(q);
+
+    if (!res) {
+        qWarning() << QString("DQBlobStream::allocate() - Failed : %1").arg(q.lastError().text());
+        return false;
+    }
+
+    connection.sql().notifyTableChanged(info->name());
+
+    return q.numRowsAffected() > 0;
+}
+
+qint64 DQBlobStream::readData(char *data,qint64 maxSize){
+#ifdef DQ_SQLITE_API
+    if (!m_blob)
+        return -1;
+#endif
+
+    qint64 offset = pos();
+    qint64 n = qMin(maxSize,m_size - offset);
+    if (n <= 0)
+        return 0;
+
+#ifdef DQ_SQLITE_API
+    if (sqlite3_blob_read(m_blob,data,(int) n,(int) offset) != SQLITE_OK) {
+        setErrorString("Failed to read the blob. The record may be changed.");
+        return -1;
+    }
+#else
+    QSqlQuery q = m_connection.query();
+    q.prepare(QString("SELECT substr(%1,:offset,:size) FROM %2 WHERE id = :id;").arg(m_field).arg(m_metaInfo->name()));
+    q.bindValue(":offset",offset + 1);
+    q.bindValue(":size",n);
+    q.bindValue(":id",m_id);
+
+    QByteArray chunk;
+    if (q.exec() && q.next())
+        chunk = q.value(0).toByteArray();
+    if (chunk.size() != n) {
+        setErrorString("Failed to read the blob. The record may be changed.");
+        return -1;
+    }
+    memcpy(data,chunk.constData(),n);
+#endif
+
+    return n;
+}
+
+qint64 DQBlobStream::writeData(const char *data,qint64 size){
+#ifdef DQ_SQLITE_API
+    if (!m_blob)
+        return -1;
+#endif
+
+    qint64 offset = pos();
+    qint64 n = qMin(size,m_size - offset);
+    if (n <= 0) {
+        setErrorString("The blob could not grow. Call DQBlobStream::allocate() to reserve the size.");
+        return -1;
+    }
+
+#ifdef DQ_SQLITE_API
+    if (sqlite3_blob_write(m_blob,data,(int) n,(int) offset) != SQLITE_OK) {
+        setErrorString("Failed to write the blob. The record may be changed.");
+        return -1;
+    }
+#else
+    // The concatenation of blobs is a text of the same bytes in a UTF-8 database , cast it back
+    QSqlQuery q = m_connection.query();
+    q.prepare(QString("UPDATE %1 SET %2 = CAST(substr(%2,1,:offset) || :data || substr(%2,:end) AS BLOB) "
+                      "WHERE id = :id AND length(%2) = :length;").arg(m_metaInfo->name()).arg(m_field));
+    q.bindValue(":offset",offset);
+    q.bindValue(":data",QByteArray(data,(int) n));
+    q.bindValue(":end",offset + n + 1);
+    q.bindValue(":id",m_id);
+    q.bindValue(":length",m_size);
+    if (!q.exec() || q.numRowsAffected() <= 0) {
+        setErrorString("Failed to write the blob. The record may be changed.");
+        return -1;
+    }
+#endif
+
+    m_written = true;
+    return n;
+}
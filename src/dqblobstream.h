@@ -0,0 +1,108 @@
+#ifndef DQBLOBSTREAM_H
+#define DQBLOBSTREAM_H
+
+#include <QIODevice>
+#include <QString>
+#include <QVariant>
+#include <dqconnection.h>
+
+class DQModel;
+class DQModelMetaInfo;
+struct sqlite3_blob;
+
+/// Incremental I/O device of a BLOB field
+/**
+  Reading a DQField<QByteArray> loads the whole value into the model , and
+  save() writes the whole value back. DQBlobStream reads and writes a BLOB
+  field of a saved record in place by SQLite incremental blob I/O
+  (sqlite3_blob_read() / sqlite3_blob_write()), so a large value could be
+  streamed in chunks without holding it in memory.
+
+  The size of a blob can't be changed by the stream. Call allocate() to
+  reserve a zero-filled blob of the final size before writing.
+
+  Example:
+
+\code
+    AllType record;
+    record.save(); // The record must be existed in database
+
+    QFile file("thumbnail.png");
+    file.open(QIODevice::ReadOnly);
+
+    DQBlobStream::allocate(&record,"data",file.size());
+
+    DQBlobStream stream(&record,"data");
+    stream.open(QIODevice::WriteOnly);
+    while (!file.atEnd())
+        stream.write(file.read(65536));
+    stream.close();
+\endcode
+
+  The field of the model is not changed by the stream. Reload it if the value is needed.
+
+  @remarks The incremental blob I/O requires DQuest built with CONFIG += dquest_sqlite_api and the QSQLITE driver
+  built with the same SQLite library (e.g Qt configured with -system-sqlite). Otherwise each read / write runs a
+  substr() statement on the field , which assumes the default UTF-8 encoding of database.
+  The stream must be used in the thread of the connection. The blob handle is expired if the row is changed by other statement, the successive read / write fail.
+ */
+class DQBlobStream : public QIODevice
+{
+public:
+    /// Construct a stream on a field of a saved record
+    /**
+      @param model The record. It must have an id. The connection of the model is used.
+      @param field The name of a BLOB field
+     */
+    DQBlobStream(DQModel *model,QString field,QObject *parent = 0);
+
+    /// Construct a stream on a field of record by id
+    DQBlobStream(DQConnection connection,DQModelMetaInfo *metaInfo,QString field,QVariant id,QObject *parent = 0);
+
+    /// Close the stream
+    ~DQBlobStream();
+
+    /// Open the blob
+    /**
+      @param mode ReadOnly , WriteOnly or ReadWrite. Append and Truncate are not supported.
+      @return FALSE if the record / field is not found , or the driver is not SQLite
+     */
+    virtual bool open(OpenMode mode);
+
+    /// Close the blob
+    /**
+      If anything is written , the result cache and identity map of the table are invalidated.
+     */
+    virtual void close();
+
+    /// The size of the blob in bytes
+    virtual qint64 size() const;
+
+    /// The stream is random access
+    virtual bool isSequential() const;
+
+    /// Reserve a zero-filled blob on the field
+    /**
+      It replaces the value of the field by "zeroblob(size)".
+      @return TRUE if the record is updated
+     */
+    static bool allocate(DQModel *model,QString field,qint64 size);
+
+protected:
+    virtual qint64 readData(char *data,qint64 maxSize);
+    virtual qint64 writeData(const char *data,qint64 size);
+
+private:
+    Q_DISABLE_COPY(DQBlobStream)
+
+    DQConnection m_connection;
+    DQModelMetaInfo *m_metaInfo;
+    QString m_field;
+    QVariant m_id;
+
+    sqlite3_blob *m_blob;
+    qint64 m_size;
+    bool m_written;
+};
+
+#endif // DQBLOBSTREAM_H
@@ -0,0 +1,143 @@
+#include <QtCore>
+#include <QSqlError>
+#include "dqbulkwriter.h"
+#include "dqlistwriter.h"
+#include "dqmodelmetainfo.h"
+#include "dqsql.h"
+#include "dqsqlstatement.h"
+#include "dqtransaction.h"
+
+/* Test cases:
+
+  sqlitetests::bulkWriter()
+
+ */
+
+DQBulkWriter::DQBulkWriter(DQModelMetaInfo* metaInfo,DQConnection connection,int batchSize) :
+    m_metaInfo(metaInfo) , m_connection(connection) , m_batchSize(batchSize) ,
+    m_current(0) , m_pending(0) , m_written(0) {
+
+    Q_ASSERT(m_metaInfo);
+
+    QStringList fields = m_metaInfo->writableFields(m_metaInfo->columnNameList());
+    fields.removeAll("id");
+    setFields(fields);
+}
+
+DQBulkWriter::~DQBulkWriter(){
+    close();
+}
+
+bool DQBulkWriter::setFields(QStringList fields){
+    foreach (QString field , fields) {
+        if (m_metaInfo->indexOf(field) < 0) {
+            qWarning() << QString("DQBulkWriter::setFields() - %1 is not a field of %2").arg(field).arg(m_metaInfo->name());
+            return false;
+        }
+    }
+
+    m_fields = fields;
+    m_columns = QVector<QVariantList>(m_fields.size());
+    clear();
+    return true;
+}
+
+QStringList DQBulkWriter::fields() const{
+    return m_fields;
+}
+
+void DQBulkWriter::append(QVariant value){
+    if (value.userType() == qMetaTypeId<DQListWriter::Next>()) {
+        if (m_current > 0)
+            endRow();
+        return;
+    }
+
+    if (m_fields.isEmpty())
+        return;
+
+    m_columns[m_current++] << value;
+
+    if (m_current >= m_fields.size())
+        endRow();
+}
+
+DQBulkWriter& DQBulkWriter::operator<< (const QVariant value){
+    append(value);
+    return *this;
+}
+
+QVariant DQBulkWriter::next(){
+    return DQListWriter::next();
+}
+
+void DQBulkWriter::endRow(){
+    int n = m_fields.size();
+    for (int i = m_current ; i < n ; i++)
+        m_columns[i] << QVariant();
+
+    m_current = 0;
+    m_pending++;
+
+    if (m_batchSize > 0 && m_pending >= m_batchSize)
+        flush();
+}
+
+void DQBulkWriter::clear(){
+    int n = m_columns.size();
+    for (int i = 0 ; i < n ; i++)
+        m_columns[i].clear();
+
+    m_current = 0;
+    m_pending = 0;
+}
+
+bool DQBulkWriter::flush(){
+    if (m_current > 0)
+        endRow();
+
+    if (m_pending == 0)
+        return true;
+
+    DQSql sql = m_connection.sql();
+    QSqlQuery q = sql.prepare(sql.statement()->insertInto(m_metaInfo,m_fields));
+
+    int n = m_fields.size();
+    for (int i = 0 ; i < n ; i++) {
+        q.bindValue(":" + m_fields.at(i) , m_columns.at(i));
+    }
+
+    DQTransaction transaction(m_connection);
+    bool res = transaction.isActive() && q.execBatch();
+    if (res)
+        res = transaction.commit();
+
+    m_connection.setLastQuery(q);
+
+    if (!res) {
+        qWarning() << QString("DQBulkWriter::flush() - Failed to write %1 rows to %2 : %3")
+                      .arg(m_pending).arg(m_metaInfo->name()).arg(q.lastError().text());
+        transaction.rollback();
+        clear();
+        return false;
+    }
+
+    sql.notifyTableChanged(m_metaInfo->name(),m_pending);
+
+    m_written += m_pending;
+    clear();
+
+    return true;
+}
+
+bool DQBulkWriter::close(){
+    return flush();
+}
+
+int DQBulkWriter::pendingRows() const{
+    return m_pending;
+}
+
+int DQBulkWriter::writtenRows() const{
+    return m_written;
+}
@@ -0,0 +1,122 @@
+#ifndef DQBULKWRITER_H
+#define DQBULKWRITER_H
+
+#include <QStringList>
+#include <QVector>
+#include <QVariant>
+#include <dqconnection.h>
+
+class DQModelMetaInfo;
+
+/// A stream interface to insert records to a table without creating models
+/**
+  DQListWriter creates a model for every record and the list is written by
+  DQSharedList::saveAll() afterward. DQBulkWriter accepts the values by the
+  same streaming interface , but it buffers them in columns and flushes every
+  batch by a single prepared statement (QSqlQuery::execBatch()) within a
+  transaction. No DQModel instance is created. It is suitable for CSV-like imports.
+
+  The values are written in the registration order of fields (except "id") , or
+  the order set by setFields().
+
+  Example:
+
+\code
+    DQBulkWriter writer(dqMetaInfo<HealthCheck>());
+
+    writer << "Tester 1" << 179 << 120.5
+           << "Tester 2" << 160 << writer.next(); // weight is null
+
+    writer.close(); // Write the remaining rows
+\endcode
+
+  @remarks The values are bound as is , the conversion of DQField::set() is not applied.
+  The result cache and identity map of the table are notified on every flush.
+ */
+class DQBulkWriter
+{
+public:
+    /// Construct a writer of a model
+    /**
+      @param metaInfo The meta info of the model
+      @param connection The database connection
+      @param batchSize No. of rows buffered before it is flushed automatically. Zero or negative value disables the automatic flush.
+     */
+    explicit DQBulkWriter(DQModelMetaInfo* metaInfo,
+                          DQConnection connection = DQConnection::defaultConnection(),
+                          int batchSize = 1000);
+
+    /// Flush the remaining rows and destroy the writer
+    ~DQBulkWriter();
+
+    /// Set the fields and their order of the written values
+    /**
+      It discards the buffered rows. The "id" field could be included to insert records with given id.
+      @return FALSE if any of the fields is not existed
+     */
+    bool setFields(QStringList fields);
+
+    /// The fields of the written values
+    QStringList fields() const;
+
+    /// Append a value to the current row
+    /**
+      The row is completed when the value of the last field is appended , or
+      next() is passed.
+     */
+    void append(QVariant value);
+
+    /// Append a value to the current row
+    /**
+      @remarks It is a wrapper of append().
+     */
+    DQBulkWriter& operator<< (const QVariant value);
+
+    /// A symbol to complete the current row. The remaining fields are null.
+    /**
+      It is equal to DQListWriter::next().
+     */
+    static QVariant next();
+
+    /// Write the buffered rows to database
+    /**
+      An incomplete row is completed with null values before writing.
+      @return FALSE if it is failed. The buffered rows are discarded in that case.
+     */
+    bool flush();
+
+    /// Flush the remaining rows
+    bool close();
+
+    /// No. of rows buffered and not flushed yet
+    int pendingRows() const;
+
+    /// No. of rows written to database successfully
+    int writtenRows() const;
+
+private:
+    Q_DISABLE_COPY(DQBulkWriter)
+
+    /// Complete the current row
+    void endRow();
+
+    /// Clear the buffer
+    void clear();
+
+    DQModelMetaInfo *m_metaInfo;
+    DQConnection m_connection;
+    int m_batchSize;
+
+    QStringList m_fields;
+
+    /// The buffered values per field
+    QVector<QVariantList> m_columns;
+
+    /// The index of field of the next value in current row
+    int m_current;
+
+    int m_pending;
+    int m_written;
+};
+
+#endif // DQBULKWRITER_H
@@ -0,0 +1,120 @@
+#include <QtCore>
+#include <stdlib.h>
+#include <algorithm>
+#if QT_VERSION >= 0x050A00
+#include <QRandomGenerator>
+#endif
+#include "dqbusyhandler_p.h"
+
+/* Test cases:
+
+  sqlitetests::busyRetry()
+
+ */
+
+static bool _dqBusyTimeGreaterThan(const DQQueryStats &a,const DQQueryStats &b) {
+    return a.busyTime > b.busyTime;
+}
+
+_DQBusyHandler::_DQBusyHandler(QSqlDatabase db,const DQRetryPolicy &policy) :
+    m_db(db) , m_handle(_dqSqliteHandle(db)) , m_policy(policy) {
+#ifdef DQ_SQLITE_API
+    if (m_handle)
+        sqlite3_busy_handler(m_handle,callback,this);
+#endif
+}
+
+_DQBusyHandler::~_DQBusyHandler(){
+#ifdef DQ_SQLITE_API
+    // The handle is released if the database is closed already
+    if (m_handle && _dqSqliteHandle(m_db) == m_handle)
+        sqlite3_busy_handler(m_handle,0,0);
+#endif
+}
+
+QList<DQQueryStats> _DQBusyHandler::stats(){
+    QMutexLocker locker(&m_mutex);
+    QList<DQQueryStats> res = m_stats.toList();
+    std::stable_sort(res.begin(),res.end(),_dqBusyTimeGreaterThan);
+    return res;
+}
+
+void _DQBusyHandler::reset(){
+    QMutexLocker locker(&m_mutex);
+    m_index.clear();
+    m_stats.clear();
+}
+
+#ifdef DQ_SQLITE_API
+/// A random number between 0 and 1 for the jitter
+static double _dqRandom() {
+#if QT_VERSION >= 0x050A00
+    return QRandomGenerator::global()->generateDouble();
+#else
+    return (double) qrand() / RAND_MAX;
+#endif
+}
+
+int _DQBusyHandler::callback(void* handler,int count){
+    return static_cast<_DQBusyHandler*>(handler)->retry(count);
+}
+
+int _DQBusyHandler::retry(int count){
+    if (count == 0) {
+        // A new busy wait
+        m_wait.start();
+        m_sql = DQQueryStats::normalize(blockedStatement());
+
+        QMutexLocker locker(&m_mutex);
+        current().calls++;
+    }
+
+    qint64 remaining = m_policy.timeout - m_wait.elapsed();
+    if (remaining <= 0) {
+        QMutexLocker locker(&m_mutex);
+        current().failures++;
+        return 0;
+    }
+
+    int delay = m_policy.delay(count,_dqRandom());
+    int slept = sqlite3_sleep((int) qMin((qint64) delay , remaining));
+
+    QMutexLocker locker(&m_mutex);
+    DQQueryStats &stats = current();
+    stats.retries++;
+    stats.busyTime += (qint64) slept * 1000;
+    stats.maxTime = qMax(stats.maxTime , m_wait.nsecsElapsed() / 1000);
+
+    return 1;
+}
+
+QString _DQBusyHandler::blockedStatement(){
+    sqlite3_stmt* blocked = 0;
+    for (sqlite3_stmt* stmt = sqlite3_next_stmt(m_handle,0) ; stmt ; stmt = sqlite3_next_stmt(m_handle,stmt)) {
+        if (!sqlite3_stmt_busy(stmt))
+            continue;
+        if (!sqlite3_stmt_readonly(stmt)) {
+            blocked = stmt;
+            break;
+        }
+        if (!blocked)
+            blocked = stmt;
+    }
+
+    if (!blocked)
+        return QString();
+    return QString::fromUtf8(sqlite3_sql(blocked));
+}
+#endif
+
+DQQueryStats& _DQBusyHandler::current(){
+    int index = m_index.value(m_sql,-1);
+    if (index < 0) {
+        index = m_stats.size();
+        DQQueryStats stats;
+        stats.sql = m_sql;
+        m_stats.append(stats);
+        m_index.insert(m_sql,index);
+    }
+    return m_stats[index];
+}
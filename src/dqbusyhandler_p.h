@@ -0,0 +1,75 @@
+#ifndef DQBUSYHANDLER_P_H
+#define DQBUSYHANDLER_P_H
+
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <QList>
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include "dqretrypolicy.h"
+#include "dqquerystats.h"
+#include "dqsqlite_p.h"
+
+/// The SQLite busy handler of DQRetryPolicy
+/**
+  The handler is called by SQLite in the thread stepping the blocked
+  statement. The statement is found by sqlite3_next_stmt() , the first
+  writing statement in progress is preferred.
+
+  A busy wait is counted as a call of the statement's DQQueryStats. The
+  retries and the time slept are added to DQQueryStats::retries and
+  DQQueryStats::busyTime , a wait ended by the timeout is a failure.
+
+  It is only installed with DQ_SQLITE_API. Otherwise DQConnection sets the
+  busy_timeout to the timeout of the policy.
+ */
+class _DQBusyHandler {
+public:
+    /// Install the handler on the database. It replaces the busy_timeout.
+    _DQBusyHandler(QSqlDatabase db,const DQRetryPolicy &policy);
+
+    /// Remove the handler
+    ~_DQBusyHandler();
+
+    /// The stats of the blocked statements sorted by the busy time in descending order
+    QList<DQQueryStats> stats();
+
+    /// Remove all the stats
+    void reset();
+
+private:
+    static int callback(void* handler,int count);
+
+    /// Sleep before the next retry
+    /**
+      @return 1 to retry , 0 to give up
+     */
+    int retry(int count);
+
+    /// The SQL of the blocked statement
+    QString blockedStatement();
+
+    /// The stats of the blocked statement. It must be called with m_mutex locked
+    DQQueryStats& current();
+
+    QSqlDatabase m_db;
+    sqlite3* m_handle;
+
+    DQRetryPolicy m_policy;
+
+    /// The time of the current busy wait
+    QElapsedTimer m_wait;
+
+    /// The normalized SQL of the current busy wait
+    QString m_sql;
+
+    /// Guard of m_index and m_stats
+    QMutex m_mutex;
+
+    QHash<QString,int> m_index;
+
+    QVector<DQQueryStats> m_stats;
+};
+
+#endif // DQBUSYHANDLER_P_H
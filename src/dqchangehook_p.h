@@ -0,0 +1,61 @@
+#ifndef DQCHANGEHOOK_P_H
+#define DQCHANGEHOOK_P_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include "dqchangenotifier.h"
+#include "dqsql.h"
+
+struct sqlite3;
+
+/// The SQLite update / commit / rollback hooks of a connection
+/**
+  The rows changed by sqlite3_update_hook() are collected until the
+  transaction is committed. The commit hook notifies the result cache and
+  identity map of DQSql immediately , and queues the changes to the
+  notifiers. The rollback hook discards them.
+
+  The hook callbacks run within the statement execution , they must not use
+  the connection.
+ */
+class _DQChangeHook {
+public:
+    _DQChangeHook(sqlite3 *handle,DQSql sql);
+
+    /// Remove the hooks and delete the notifiers
+    ~_DQChangeHook();
+
+    /// Create a notifier of the tables
+    DQChangeNotifier* watch(QStringList tables);
+
+    /// Delete a notifier. It returns FALSE if it is not created by this hook.
+    bool unwatch(DQChangeNotifier* notifier);
+
+    /// No. of notifiers
+    int size() const;
+
+private:
+    static void updateHook(void *data,int op,const char *database,const char *table,qint64 rowid);
+    static int commitHook(void *data);
+    static void rollbackHook(void *data);
+
+    /// Add a change to the current transaction
+    void add(DQChange change);
+
+    /// Dispatch the changes of the committed transaction
+    void commit();
+
+    sqlite3 *m_handle;
+    DQSql m_sql;
+
+    QList<DQChangeNotifier*> m_notifiers;
+
+    /// The changes of the current transaction
+    QList<DQChange> m_changes;
+
+    /// Index of the row in m_changes
+    QHash<QPair<QString,qint64> , int> m_index;
+};
+
+#endif // DQCHANGEHOOK_P_H
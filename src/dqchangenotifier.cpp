@@ -0,0 +1,168 @@
+#include <QtCore>
+#include "dqchangenotifier.h"
+#include "dqchangehook_p.h"
+#include "dqsqlite_p.h"
+
+/* Test cases:
+
+  sqlitetests::watch()
+
+ */
+
+DQChangeNotifier::DQChangeNotifier(QStringList tables,QObject *parent) : QObject(parent) , m_tables(tables) {
+    qRegisterMetaType<DQChange>();
+    qRegisterMetaType<QList<DQChange> >();
+}
+
+QStringList DQChangeNotifier::tables() const{
+    return m_tables;
+}
+
+void DQChangeNotifier::post(const QList<DQChange> &changes){
+    QMutexLocker locker(&m_mutex);
+    bool scheduled = !m_pending.isEmpty();
+
+    foreach (const DQChange &change , changes) {
+        if (m_tables.isEmpty() || m_tables.contains(change.table))
+            m_pending << change;
+    }
+
+    if (!scheduled && !m_pending.isEmpty())
+        QMetaObject::invokeMethod(this,"deliver",Qt::QueuedConnection);
+}
+
+void DQChangeNotifier::deliver(){
+    QMutexLocker locker(&m_mutex);
+    if (m_pending.isEmpty())
+        return;
+
+    QList<DQChange> changes = m_pending;
+    m_pending.clear();
+    locker.unlock();
+
+    emit changed(changes);
+}
+
+_DQChangeHook::_DQChangeHook(sqlite3 *handle,DQSql sql) : m_handle(handle) , m_sql(sql) {
+#ifdef DQ_SQLITE_API
+    sqlite3_update_hook(m_handle,updateHook,this);
+    sqlite3_commit_hook(m_handle,commitHook,this);
+    sqlite3_rollback_hook(m_handle,rollbackHook,this);
+#endif
+}
+
+_DQChangeHook::~_DQChangeHook(){
+#ifdef DQ_SQLITE_API
+    // The handle is released if the database is closed already
+    if (_dqSqliteHandle(m_sql.database()) == m_handle) {
+        sqlite3_update_hook(m_handle,0,0);
+        sqlite3_commit_hook(m_handle,0,0);
+        sqlite3_rollback_hook(m_handle,0,0);
+    }
+#endif
+
+    // It may be called within a slot of the notifier
+    foreach (DQChangeNotifier *notifier , m_notifiers)
+        notifier->deleteLater();
+}
+
+DQChangeNotifier* _DQChangeHook::watch(QStringList tables){
+    DQChangeNotifier *notifier = new DQChangeNotifier(tables);
+    m_notifiers << notifier;
+    return notifier;
+}
+
+bool _DQChangeHook::unwatch(DQChangeNotifier* notifier){
+    if (!m_notifiers.removeOne(notifier))
+        return false;
+
+    // It may be deleted within its own slot
+    notifier->deleteLater();
+    return true;
+}
+
+int _DQChangeHook::size() const{
+    return m_notifiers.size();
+}
+
+void _DQChangeHook::updateHook(void *data,int op,const char *database,const char *table,qint64 rowid){
+    Q_UNUSED(database);
+    _DQChangeHook *hook = static_cast<_DQChangeHook*>(data);
+
+    DQChange::Operation operation = DQChange::Update;
+#ifdef DQ_SQLITE_API
+    if (op == SQLITE_INSERT)
+        operation = DQChange::Insert;
+    else if (op == SQLITE_DELETE)
+        operation = DQChange::Delete;
+#else
+    Q_UNUSED(op);
+#endif
+
+    hook->add(DQChange(QString::fromUtf8(table),operation,rowid));
+}
+
+int _DQChangeHook::commitHook(void *data){
+    static_cast<_DQChangeHook*>(data)->commit();
+    return 0; // Don't abort the commit
+}
+
+void _DQChangeHook::rollbackHook(void *data){
+    _DQChangeHook *hook = static_cast<_DQChangeHook*>(data);
+    hook->m_changes.clear();
+    hook->m_index.clear();
+}
+
+void _DQChangeHook::add(DQChange change){
+    QPair<QString,qint64> key(change.table,change.rowid);
+
+    if (!m_index.contains(key)) {
+        m_index[key] = m_changes.size();
+        m_changes << change;
+        return;
+    }
+
+    DQChange &last = m_changes[m_index[key]];
+
+    if (last.operation == DQChange::Insert) {
+        if (change.operation == DQChange::Delete) {
+            // The row is not existed before or after the transaction
+            last.table.clear();
+            m_index.remove(key);
+        }
+        // Insert + Update is still an Insert
+    } else if (last.operation == DQChange::Delete) {
+        // The rowid is reused
+        if (change.operation == DQChange::Insert)
+            last.operation = DQChange::Update;
+    } else {
+        if (change.operation == DQChange::Delete)
+            last.operation = DQChange::Delete;
+    }
+}
+
+void _DQChangeHook::commit(){
+    QList<DQChange> changes;
+    changes.reserve(m_changes.size());
+    QSet<QString> tables;
+
+    foreach (const DQChange &change , m_changes) {
+        if (change.table.isEmpty())
+            continue;
+        changes << change;
+        tables << change.table;
+    }
+
+    m_changes.clear();
+    m_index.clear();
+
+    if (changes.isEmpty())
+        return;
+
+    // Push the invalidation to the caches. It includes the changes by raw SQL.
+    foreach (QString table , tables)
+        m_sql.notifyTableChanged(table);
+
+    foreach (DQChangeNotifier *notifier , m_notifiers)
+        notifier->post(changes);
+}
@@ -0,0 +1,96 @@
+#ifndef DQCHANGENOTIFIER_H
+#define DQCHANGENOTIFIER_H
+
+#include <QObject>
+#include <QList>
+#include <QStringList>
+#include <QMetaType>
+#include <QMutex>
+
+class _DQChangeHook;
+
+/// A row changed by a committed transaction
+class DQChange {
+public:
+    enum Operation {
+        Insert,
+        Update,
+        Delete
+    };
+
+    inline DQChange() : operation(Insert) , rowid(0) {
+    }
+
+    inline DQChange(QString table,Operation operation,qint64 rowid) :
+        table(table) , operation(operation) , rowid(rowid) {
+    }
+
+    /// The table name
+    QString table;
+
+    Operation operation;
+
+    /// The rowid (The "id" field of DQModel)
+    qint64 rowid;
+};
+
+Q_DECLARE_METATYPE(DQChange)
+Q_DECLARE_METATYPE(QList<DQChange>)
+
+/// The change notification of the tables of a connection
+/**
+  It is created by DQConnection::watch(). The changed() signal is emitted with
+  the rows changed by each committed transaction , the changes of a row within
+  a transaction are coalesced into a single DQChange (e.g An inserted and
+  updated row is reported as Insert).
+
+\code
+    DQChangeNotifier *notifier = connection.watch<User>();
+    QObject::connect(notifier,SIGNAL(changed(QList<DQChange>)),
+                     this,SLOT(onUserChanged(QList<DQChange>)));
+\endcode
+
+  The signal is emitted by the event loop of the notifier's thread after the
+  transaction is committed , so the slots could query the database.
+
+  @remarks Only the changes made through the connection are reported. The
+  writes by other connections (e.g clone() , the write-behind writer) or
+  processes are not detected. Like sqlite3_update_hook() , the rows removed by
+  "DELETE" without WHERE clause (the truncate optimization) or replaced by
+  "REPLACE" are not reported as Delete. The changes rolled back to a savepoint
+  are still reported.
+  @see DQConnection::watch()
+ */
+class DQChangeNotifier : public QObject
+{
+    Q_OBJECT
+public:
+    /// The watching tables. It is empty if all the tables are watched.
+    QStringList tables() const;
+
+signals:
+    /// The rows changed by a committed transaction
+    void changed(QList<DQChange> changes);
+
+private slots:
+    /// Emit the pending changes
+    void deliver();
+
+private:
+    explicit DQChangeNotifier(QStringList tables,QObject *parent = 0);
+
+    /// Queue the committed changes. It is called by the commit hook.
+    void post(const QList<DQChange> &changes);
+
+    QStringList m_tables;
+
+    /// The changes to be emitted
+    QList<DQChange> m_pending;
+
+    /// Guard of m_pending. The commit hook may run in other thread.
+    QMutex m_mutex;
+
+    friend class _DQChangeHook;
+};
+
+#endif // DQCHANGENOTIFIER_H
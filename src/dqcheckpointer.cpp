@@ -0,0 +1,117 @@
+#include <QtCore>
+#include <QSqlQuery>
+#include <QSqlError>
+#include "dqcheckpointer_p.h"
+
+/* Test cases:
+
+  sqlitetests::checkpoint()
+
+ */
+
+/// The statement name of the checkpoint stats
+#define DQ_CHECKPOINT_STATS_NAME "PRAGMA wal_checkpoint"
+
+_DQCheckpointer::_DQCheckpointer(){
+    m_stats.sql = DQ_CHECKPOINT_STATS_NAME;
+}
+
+bool _DQCheckpointer::checkpoint(QSqlDatabase db,int mode,int* logFrames,int* checkpointedFrames,QString* error){
+    int log = -1;
+    int checkpointed = -1;
+    QString message;
+
+    if (!db.isOpen() || db.driverName() != "QSQLITE") {
+        if (error)
+            *error = "The connection is not opened by the QSQLITE driver";
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+#ifdef DQ_SQLITE_API
+    sqlite3 *handle = _dqSqliteHandle(db);
+    int rc = handle ? sqlite3_wal_checkpoint_v2(handle,0,mode,&log,&checkpointed) : SQLITE_MISUSE;
+    bool res = rc == SQLITE_OK;
+    if (!res)
+        message = handle ? QString::fromUtf8(sqlite3_errmsg(handle)) : QString("Not a SQLite connection");
+#else
+    static const char* modes[] = { "PASSIVE" , "FULL" , "RESTART" , "TRUNCATE" };
+
+    // The first column is 1 if a blocking mode could not be completed (SQLITE_BUSY)
+    QSqlQuery q(db);
+    bool res = mode >= 0 && mode <= 3 &&
+               q.exec(QString("PRAGMA main.wal_checkpoint(%1);").arg(modes[qBound(0,mode,3)])) && q.next();
+    if (res) {
+        log = q.value(1).toInt();
+        checkpointed = q.value(2).toInt();
+        res = q.value(0).toInt() == 0;
+        if (!res)
+            message = "database is locked";
+    } else {
+        message = q.lastError().isValid() ? q.lastError().text() : QString("Invalid mode %1").arg(mode);
+    }
+#endif
+    qint64 usecs = timer.nsecsElapsed() / 1000;
+
+    if (logFrames)
+        *logFrames = log;
+    if (checkpointedFrames)
+        *checkpointedFrames = checkpointed;
+    if (error)
+        *error = message;
+
+    QMutexLocker locker(&m_mutex);
+    m_stats.calls++;
+    if (!res)
+        m_stats.failures++;
+    if (checkpointed > 0)
+        m_stats.rows += checkpointed;
+    m_stats.execTime += usecs;
+    m_stats.maxTime = qMax(m_stats.maxTime,usecs);
+    m_stats.histogram[DQQueryStats::bucketOf(usecs)]++;
+
+    return res;
+}
+
+DQQueryStats _DQCheckpointer::stats(){
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void _DQCheckpointer::reset(){
+    QMutexLocker locker(&m_mutex);
+    m_stats = DQQueryStats();
+    m_stats.sql = DQ_CHECKPOINT_STATS_NAME;
+}
+
+qint64 _DQCheckpointer::walSize(QSqlDatabase db){
+    QString file;
+#ifdef DQ_SQLITE_API
+    sqlite3 *handle = _dqSqliteHandle(db);
+    if (!handle)
+        return -1;
+    file = QString::fromUtf8(sqlite3_db_filename(handle,"main"));
+#else
+    if (!db.isOpen() || db.driverName() != "QSQLITE")
+        return -1;
+
+    // The columns are seq , name and file. The file of an in-memory database is empty
+    QSqlQuery q(db);
+    if (q.exec("PRAGMA database_list;")) {
+        while (q.next()) {
+            if (q.value(1).toString() == "main") {
+                file = q.value(2).toString();
+                break;
+            }
+        }
+    }
+#endif
+    if (file.isEmpty())
+        return -1;
+
+    QFileInfo info(file + "-wal");
+    if (!info.exists())
+        return 0;
+    return info.size();
+}
@@ -0,0 +1,45 @@
+#ifndef DQCHECKPOINTER_P_H
+#define DQCHECKPOINTER_P_H
+
+#include <QMutex>
+#include <QSqlDatabase>
+#include "dqquerystats.h"
+#include "dqsqlite_p.h"
+
+/// Run the WAL checkpoints of a connection and collect their timing
+/**
+  It is shared by DQConnection::checkpoint() and the maintenance thread ,
+  so the stats cover the checkpoints of both the connection and its clone.
+ */
+class _DQCheckpointer {
+public:
+    _DQCheckpointer();
+
+    /// Checkpoint the main database of a connection
+    /**
+      It calls sqlite3_wal_checkpoint_v2() with DQ_SQLITE_API , otherwise it runs "PRAGMA wal_checkpoint".
+
+      @param mode The value of DQConnection::CheckpointMode (The same as SQLITE_CHECKPOINT_*)
+      @param logFrames Return the no. of frames in WAL. It could be NULL.
+      @param checkpointedFrames Return the no. of frames written back to the database. It could be NULL.
+      @param error Return the error message on failure. It could be NULL.
+      @return FALSE if it is failed , or a blocking mode could not be completed
+     */
+    bool checkpoint(QSqlDatabase db,int mode,int* logFrames = 0,int* checkpointedFrames = 0,QString* error = 0);
+
+    /// The aggregated checkpoints
+    DQQueryStats stats();
+
+    /// Remove the collected stats
+    void reset();
+
+    /// The size of the WAL file of a connection in bytes. 0 if there is no WAL file, -1 for in-memory database
+    static qint64 walSize(QSqlDatabase db);
+
+private:
+    QMutex m_mutex;
+
+    DQQueryStats m_stats;
+};
+
+#endif // DQCHECKPOINTER_P_H
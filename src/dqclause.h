@@ -79,6 +79,16 @@ public:
         /* Extra */
         PRIMARY_KEY,
         FOREIGN_KEY,
+
+        /* Loading */
+        DEFERRED,
+
+        /* Search */
+        FULL_TEXT,
+
+        /* Computed */
+        GENERATED,
+        STORED,
         LAST
     };
 
@@ -132,6 +142,45 @@ private:
  */
 #define DQDefault(value) DQClause(DQClause::DEFAULT,value)
 
+/// The "Deferred" clause
+/** The field is not read by the queries of the model. It is loaded
+  on first access by a single column query of the record id. It is
+  suitable for large TEXT / BLOB field that is seldom used.
+
+  @remarks It do not change the column definition.
+  @see DQSharedQuery::defer()
+ */
+#define DQDeferred DQClause(DQClause::DEFERRED)
+
+/// The "Full Text" clause
+/** The TEXT field is indexed by a FTS5 virtual table named "<table>_fts".
+  The virtual table is created by DQConnection::createTables() with the
+  triggers to keep it in sync with the table , and it is searched by DQWhere::match().
+
+  @remarks It is supported by the SQLite driver built with FTS5 only. It do not change the column definition.
+  @see DQWhere::match()
+  @see DQSharedQuery::orderByRank()
+ */
+#define DQFullText DQClause(DQClause::FULL_TEXT)
+
+/// The "Generated" clause
+/** The field is a generated column computed from the other columns of the record
+  (e.g "lower(email)"). It is not stored , but computed on read. It could be
+  filtered and indexed like other fields , so a query on the expression could be served by an index.
+
+  The field is never written by save() or the bulk writers.
+
+  @remarks It requires SQLite 3.31 or above
+  @see DQStoredGenerated
+ */
+#define DQGenerated(expression) DQClause(DQClause::GENERATED,expression)
+
+/// The "Generated" clause of a stored column
+/** It is the same as DQGenerated , except the value is computed on write and stored in the table.
+  A stored generated column can't be added to an existing table by migration , the table is rebuilt.
+ */
+#define DQStoredGenerated(expression) (DQClause(DQClause::GENERATED,expression) | DQClause(DQClause::STORED))
+
 /// Encode the string
 QString dqEscape(QString val,bool trimStrings = false);
 
@@ -0,0 +1,69 @@
+#include <QtCore>
+#include <QSqlDatabase>
+#include "dqclonethread_p.h"
+#include "dqsql.h"
+
+/// Used to generate the connection name of clone
+static QAtomicInt _dqCloneThreadCounter;
+
+_DQCloneThread::_DQCloneThread(DQConnection* base,const QString &kind,const QString &description) :
+    m_stop(false) , m_base(base) , m_kind(kind) , m_description(description) , m_ready(false) {
+}
+
+_DQCloneThread::~_DQCloneThread(){
+    // The derived class should have stopped it , process() is not available here
+    Q_ASSERT(!isRunning());
+}
+
+DQConnection _DQCloneThread::connection(){
+    return m_connection;
+}
+
+void _DQCloneThread::startClone(QThread::Priority priority){
+    start(priority);
+
+    QMutexLocker locker(&m_mutex);
+    while (!m_ready)
+        m_wake.wait(&m_mutex);
+}
+
+void _DQCloneThread::stopClone(){
+    m_mutex.lock();
+    m_stop = true;
+    m_wake.wakeAll();
+    stopping();
+    m_mutex.unlock();
+
+    wait();
+}
+
+void _DQCloneThread::stopping(){
+}
+
+void _DQCloneThread::run(){
+    QString name = QString("%1_%2_%3")
+                   .arg(m_base->sql().database().connectionName())
+                   .arg(m_kind)
+                   .arg(_dqCloneThreadCounter.fetchAndAddOrdered(1));
+    DQConnection connection = m_base->clone(name);
+    if (!connection.isOpen())
+        qWarning() << QString("DQConnection - Failed to open the database of %1 %2").arg(m_description).arg(name);
+
+    m_mutex.lock();
+    m_connection = connection;
+    m_base = 0; // The caller is blocked until here
+    m_ready = true;
+    m_wake.wakeAll();
+    m_mutex.unlock();
+
+    process();
+
+    // The last reference of the database is released before it is removed
+    QSqlDatabase db = connection.sql().database();
+    connection.close();
+    m_connection = DQConnection();
+    connection = DQConnection();
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(name);
+}
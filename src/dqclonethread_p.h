@@ -0,0 +1,68 @@
+#ifndef DQCLONETHREAD_P_H
+#define DQCLONETHREAD_P_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include "dqconnection.h"
+
+/// A background thread working on its own clone of a connection
+/**
+  The database must be opened by the thread that use it. run() clones the
+  base connection , runs process() and then closes and removes the clone
+  within the thread. The clone could be failed to open , process() should
+  check m_connection.isOpen().
+
+  The derived class calls startClone() at the end of its constructor , which
+  blocks until the database is cloned , and stopClone() at the beginning of its
+  destructor , which blocks until the thread is finished.
+
+  m_mutex guards m_stop and the state of the derived class. m_wake is used to
+  wake up the thread.
+ */
+class _DQCloneThread : public QThread {
+public:
+    /**
+      @param base The connection to be cloned. It is only used until startClone() returns
+      @param kind The suffix of the connection name of clone , e.g "dqasync"
+      @param description The name of the thread in warnings , e.g "async worker"
+     */
+    _DQCloneThread(DQConnection* base,const QString &kind,const QString &description);
+
+    ~_DQCloneThread();
+
+    /// The cloned connection. It should only be used by the thread
+    DQConnection connection();
+
+protected:
+    /// Start the thread and block until the database is cloned
+    void startClone(QThread::Priority priority = QThread::InheritPriority);
+
+    /// Set m_stop , wake up the thread and block until it is finished
+    void stopClone();
+
+    /// The work of the thread. It should return once m_stop is set
+    virtual void process() = 0;
+
+    /// Wake up the other waiters of derived class on stop. It is called with m_mutex locked
+    virtual void stopping();
+
+    DQConnection m_connection;
+
+    QMutex m_mutex;
+
+    /// Wake up the thread
+    QWaitCondition m_wake;
+
+    bool m_stop;
+
+private:
+    void run();
+
+    DQConnection* m_base;
+    QString m_kind;
+    QString m_description;
+    bool m_ready;
+};
+
+#endif // DQCLONETHREAD_P_H
@@ -0,0 +1,227 @@
+#include <QtCore>
+#include <QSqlRecord>
+#include "dqcolumnarresult.h"
+#include "dqmodelmetainfo.h"
+
+/* Test cases:
+
+  sqlitetests::columnarResult()
+  sqlitetests::aggregate()
+
+ */
+
+/// The storage of a column in DQColumnarResult
+class _DQColumn {
+public:
+    QString name;
+    DQColumnarResult::Type type;
+
+    QVector<qint64> integers;
+    QVector<double> reals;
+    QVector<int> textIndex;
+    QStringList textPool;
+
+    /// Reverse lookup of textPool. It is only used during reading
+    QHash<QString,int> textPoolIndex;
+
+    QVector<quint32> nulls;
+};
+
+class DQColumnarResultPriv : public QSharedData {
+public:
+    DQColumnarResultPriv() {
+        rowCount = 0;
+    }
+
+    QVector<_DQColumn> columns;
+    int rowCount;
+};
+
+DQColumnarResult::Type DQColumnarResult::fieldType(DQModelMetaInfo* metaInfo,const QString& name) {
+    const DQModelMetaInfoField *field = 0;
+    if (metaInfo) {
+        int index = metaInfo->indexOf(name);
+        if (index >= 0)
+            field = metaInfo->at(index);
+    }
+
+    if (!field)
+        return DQColumnarResult::Text;
+
+    switch (field->type) {
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+        return DQColumnarResult::Integer;
+    case QVariant::Double:
+        return DQColumnarResult::Real;
+    default:
+        return DQColumnarResult::Text;
+    }
+}
+
+DQColumnarResult::DQColumnarResult() : d(new DQColumnarResultPriv){
+}
+
+DQColumnarResult::DQColumnarResult(const DQColumnarResult &other) : d(other.d){
+}
+
+DQColumnarResult &DQColumnarResult::operator=(const DQColumnarResult &rhs){
+    if (this != &rhs)
+        d.operator=(rhs.d);
+    return *this;
+}
+
+DQColumnarResult::~DQColumnarResult(){
+}
+
+int DQColumnarResult::rowCount() const{
+    return d->rowCount;
+}
+
+int DQColumnarResult::columnCount() const{
+    return d->columns.size();
+}
+
+QStringList DQColumnarResult::columnNames() const{
+    QStringList res;
+    foreach (const _DQColumn &column , d->columns) {
+        res << column.name;
+    }
+    return res;
+}
+
+int DQColumnarResult::indexOf(const QString& name) const {
+    int n = d->columns.size();
+    for (int i = 0 ; i < n;i++) {
+        if (d->columns.at(i).name == name)
+            return i;
+    }
+    return -1;
+}
+
+DQColumnarResult::Type DQColumnarResult::type(int column) const{
+    return d->columns.at(column).type;
+}
+
+bool DQColumnarResult::isNull(int column,int row) const{
+    const QVector<quint32> &nulls = d->columns.at(column).nulls;
+    return nulls.at(row / 32) & (1u << (row % 32));
+}
+
+const QVector<quint32>& DQColumnarResult::nullBitmap(int column) const{
+    return d->columns.at(column).nulls;
+}
+
+const QVector<qint64>& DQColumnarResult::integers(int column) const{
+    return d->columns.at(column).integers;
+}
+
+const QVector<double>& DQColumnarResult::reals(int column) const{
+    return d->columns.at(column).reals;
+}
+
+const QVector<int>& DQColumnarResult::textIndex(int column) const{
+    return d->columns.at(column).textIndex;
+}
+
+QStringList DQColumnarResult::textPool(int column) const{
+    return d->columns.at(column).textPool;
+}
+
+QString DQColumnarResult::text(int column,int row) const{
+    const _DQColumn &c = d->columns.at(column);
+    if (c.type != Text)
+        return value(column,row).toString();
+
+    int index = c.textIndex.at(row);
+    if (index < 0)
+        return QString();
+    return c.textPool.at(index);
+}
+
+QVariant DQColumnarResult::value(int column,int row) const{
+    if (isNull(column,row))
+        return QVariant();
+
+    const _DQColumn &c = d->columns.at(column);
+    switch (c.type) {
+    case Integer:
+        return c.integers.at(row);
+    case Real:
+        return c.reals.at(row);
+    default:
+        return c.textPool.at(c.textIndex.at(row));
+    }
+}
+
+void DQColumnarResult::read(QSqlQuery &query,DQModelMetaInfo* metaInfo){
+    read(query,metaInfo,QMap<QString,Type>());
+}
+
+void DQColumnarResult::read(QSqlQuery &query,DQModelMetaInfo* metaInfo,const QMap<QString,Type> &types){
+    d->columns.clear();
+    d->rowCount = 0;
+
+    QSqlRecord record = query.record();
+    int n = record.count();
+    d->columns.resize(n);
+
+    _DQColumn *columns = d->columns.data();
+    for (int i = 0 ; i < n;i++) {
+        columns[i].name = record.fieldName(i);
+        columns[i].type = types.value(columns[i].name,fieldType(metaInfo,columns[i].name));
+    }
+
+    int row = 0;
+    while (query.next()) {
+        int bit = row % 32;
+        if (bit == 0) {
+            for (int i = 0 ; i < n;i++)
+                columns[i].nulls.append(0);
+        }
+
+        for (int i = 0 ; i < n;i++) {
+            _DQColumn &column = columns[i];
+            QVariant value = query.value(i);
+            bool null = value.isNull();
+
+            if (null)
+                column.nulls.last() |= (1u << bit);
+
+            switch (column.type) {
+            case Integer:
+                column.integers.append(null ? 0 : value.toLongLong());
+                break;
+            case Real:
+                column.reals.append(null ? 0.0 : value.toDouble());
+                break;
+            default:
+                if (null) {
+                    column.textIndex.append(-1);
+                } else {
+                    QString str = value.toString();
+                    QHash<QString,int>::const_iterator iter = column.textPoolIndex.constFind(str);
+                    int index;
+                    if (iter == column.textPoolIndex.constEnd()) {
+                        index = column.textPool.size();
+                        column.textPool.append(str);
+                        column.textPoolIndex.insert(str,index);
+                    } else {
+                        index = iter.value();
+                    }
+                    column.textIndex.append(index);
+                }
+                break;
+            }
+        }
+        row++;
+    }
+
+    for (int i = 0 ; i < n;i++)
+        columns[i].textPoolIndex.clear();
+
+    d->rowCount = row;
+}
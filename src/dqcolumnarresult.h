@@ -0,0 +1,134 @@
+#ifndef DQCOLUMNARRESULT_H
+#define DQCOLUMNARRESULT_H
+
+#include <QSharedDataPointer>
+#include <QVector>
+#include <QStringList>
+#include <QSqlQuery>
+#include <QMap>
+
+class DQModelMetaInfo;
+class DQColumnarResultPriv;
+
+/// A column-oriented result set for analytic reads
+/**
+  DQSharedQuery::all() creates a model per record and each value is stored
+  by a QVariant. DQColumnarResult reads the selected fields into a contiguous
+  array per column instead. It is suitable to run aggregation over a large
+  no. of record in your code.
+
+  The storage of a column depends on the type of the field:
+
+  <ul>
+  <li> Integer - The value is stored in QVector<qint64> (integers()) </li>
+  <li> Real - The value is stored in QVector<double> (reals()) </li>
+  <li> Text - Distinct values are stored once in a string pool (textPool()) and the rows refer to it by index (textIndex()) </li>
+  </ul>
+
+  Null values are stored as zero (or index -1 for Text) and marked in a null bitmap.
+
+  Example:
+
+\code
+    DQQuery<HealthCheck> query;
+    DQColumnarResult result = query.filter(DQWhere("height") > 150).columns(QStringList() << "height" << "name");
+
+    const QVector<qint64> &height = result.integers(0);
+    qint64 total = 0;
+    for (int i = 0 ; i < height.size();i++) {
+        total += height[i];
+    }
+\endcode
+
+  @remarks It is an implicitly shared class
+ */
+class DQColumnarResult
+{
+public:
+    /// The storage type of a column
+    enum Type {
+        Integer,
+        Real,
+        Text
+    };
+
+    /// Default constructor. An empty result.
+    DQColumnarResult();
+
+    /// Copy constructor
+    DQColumnarResult(const DQColumnarResult &other);
+
+    /// Assignment operator overloading
+    DQColumnarResult &operator=(const DQColumnarResult &rhs);
+
+    ~DQColumnarResult();
+
+    /// No. of record
+    int rowCount() const;
+
+    /// No. of column
+    int columnCount() const;
+
+    /// The name of columns
+    QStringList columnNames() const;
+
+    /// Get the index of a column
+    /**
+      @return The index or -1 if it is not found
+     */
+    int indexOf(const QString& name) const;
+
+    /// The storage type of a column
+    Type type(int column) const;
+
+    /// TRUE if the value is null
+    bool isNull(int column,int row) const;
+
+    /// The null bitmap of a column
+    /**
+      The bit (row % 32) of the word (row / 32) is set if the value is null.
+     */
+    const QVector<quint32>& nullBitmap(int column) const;
+
+    /// The values of an Integer column. It is empty for other type.
+    const QVector<qint64>& integers(int column) const;
+
+    /// The values of a Real column. It is empty for other type.
+    const QVector<double>& reals(int column) const;
+
+    /// The index to textPool() of a Text column. -1 if the value is null. It is empty for other type.
+    const QVector<int>& textIndex(int column) const;
+
+    /// The distinct values of a Text column
+    QStringList textPool(int column) const;
+
+    /// Get the value of a Text column
+    QString text(int column,int row) const;
+
+    /// Get the value as QVariant. It is slow , use the typed array for bulk access.
+    QVariant value(int column,int row) const;
+
+protected:
+    /// Read all the records from an executed query
+    /**
+      @param query The executed query
+      @param metaInfo The meta info of the model. It determines the type of columns. The type of unknown column is Text.
+     */
+    void read(QSqlQuery &query,DQModelMetaInfo* metaInfo);
+
+    /// Read all the records with the type of some columns given
+    /**
+      @param types The storage type of the columns by name. It overrides the type determined by metaInfo.
+     */
+    void read(QSqlQuery &query,DQModelMetaInfo* metaInfo,const QMap<QString,Type> &types);
+
+    /// The storage type of a field. The numeric fields are Integer / Real , the others and unknown field are Text
+    static Type fieldType(DQModelMetaInfo* metaInfo,const QString& field);
+
+private:
+    QSharedDataPointer<DQColumnarResultPriv> d;
+
+    friend class DQSharedQuery;
+};
+
+#endif // DQCOLUMNARRESULT_H
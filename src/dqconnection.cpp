@@ -2,23 +2,64 @@
 #include <QSqlDatabase>
 #include <QCoreApplication>
 #include <QSqlError>
-#include <QMutex>
+#include <QThread>
 
 #include "dqmodel.h"
 #include "dqconnection.h"
-#include "dqsqlitestatement.h"
+#include "dqsqlstatement.h"
 #include "dqsql.h"
+#include "dqtransaction.h"
+#include "dqconnectionpool.h"
+#include "dqasyncworker_p.h"
+#include "dqwritebehind_p.h"
+#include "dqprofiler_p.h"
+#include "dqmaintenance_p.h"
+#include "dqcheckpointer_p.h"
+#include "dqbusyhandler_p.h"
+#include "dqwriterthread_p.h"
+#include "dqpersister_p.h"
+#include "dqsqlfunction_p.h"
+#include "dqsqlite_p.h"
+#include "dqchangehook_p.h"
 
 class DQConnectionPriv : public QSharedData
 {
   public:
     DQConnectionPriv() {
-        lastQuery = 0;
+        lastQueryEnabled = true;
+        schemaFingerprintEnabled = false;
+        asyncWorker = 0;
+        writeBehind = 0;
+        profiler = 0;
+        maintenance = 0;
+        persister = 0;
+        busyHandler = 0;
+        readerPool = 0;
+        indexAdvisor = 0;
+        changeHook = 0;
+        snapshot = false;
+        snapshotHandle = 0;
     }
 
     ~DQConnectionPriv() {
-        if (lastQuery)
-            delete lastQuery;
+        delete readerPool;
+        delete persister;
+        delete maintenance;
+        delete busyHandler;
+        delete writeBehind;
+        delete asyncWorker;
+        delete profiler;
+        delete changeHook;
+        releaseSnapshot();
+    }
+
+    /// Free the shared snapshot handle
+    void releaseSnapshot() {
+#ifdef SQLITE_ENABLE_SNAPSHOT
+        if (snapshotHandle)
+            sqlite3_snapshot_free(snapshotHandle);
+#endif
+        snapshotHandle = 0;
     }
 
     DQSql m_sql;
@@ -26,10 +67,74 @@ class DQConnectionPriv : public QSharedData
     /// Registered modeles
     QList<DQModelMetaInfo*> m_models;
 
-    /// The last query being used.
-    QSqlQuery *lastQuery;
+    /// Guard of lastQuery
+    QMutex lastQueryMutex;
+
+    /// The last query being used by each thread. They are released all together by close()
+    QHash<QThread*,QSqlQuery> lastQuery;
+
+    bool lastQueryEnabled;
+
+    /// TRUE if createTables() checks the schema fingerprint
+    bool schemaFingerprintEnabled;
+
+    /// The options applied on open
+    DQConnectionOptions options;
+
+    /// The worker thread of async query
+    _DQAsyncWorker* asyncWorker;
+
+    /// Guard of asyncWorker
+    QMutex asyncMutex;
+
+    /// The writer of write-behind mode
+    _DQWriteBehind* writeBehind;
+
+    /// The query profiler. NULL if it is disabled
+    _DQProfiler* profiler;
+
+    /// The background maintenance thread. NULL if it is disabled
+    _DQMaintenance* maintenance;
+
+    /// Run and time the WAL checkpoints
+    _DQCheckpointer checkpointer;
+
+    /// The busy handler of the retry policy. NULL if the policy is null
+    _DQBusyHandler* busyHandler;
+
+    /// The writer of read / write split. It is shared by the clones
+    QSharedPointer<_DQWriterThread> writerThread;
+
+    /// The readers of read / write split
+    DQConnectionPool* readerPool;
+
+    /// The installed index advisor. It is not owned.
+    DQIndexAdvisor* indexAdvisor;
+
+    /// The hooks of watch(). NULL if nothing is watched
+    _DQChangeHook* changeHook;
+
+    /// The persister of openInMemory(). NULL if it is not persisted
+    _DQPersister* persister;
+
+    /// The name of QSqlDatabase created by openInMemory(). It is removed on close()
+    QString memoryDatabase;
+
+    /// The files attached by attach(). The key is the schema name
+    QMap<QString,QString> attachments;
+
+    /// The functions registered by registerFunction() / registerAggregate()
+    QList<_DQSqlFunction> functions;
+
+    /// TRUE if it is created by snapshot()
+    bool snapshot;
 
-    QMutex mutex;
+    /// The snapshot to be shared by other connections. It is only available with SQLITE_ENABLE_SNAPSHOT
+#ifdef SQLITE_ENABLE_SNAPSHOT
+    sqlite3_snapshot* snapshotHandle;
+#else
+    void* snapshotHandle;
+#endif
 };
 
 /// The default connection shared for all objects
@@ -56,42 +161,789 @@ bool DQConnection::operator==(const DQConnection &rhs) {
     return d.constData() == rhs.d.constData();
 }
 
-bool DQConnection::operator!=(const DQConnection &rhs) {
-    return d.constData() != rhs.d.constData();
-}
+bool DQConnection::operator!=(const DQConnection &rhs) {
+    return d.constData() != rhs.d.constData();
+}
+
+bool DQConnection::open(QSqlDatabase db,DQConnectionOptions options){
+    Q_ASSERT(db.isOpen());
+
+    DQSqlStatement *statement = DQSqlStatement::create(db.driverName());
+    if (!statement) {
+        qWarning() << QString("DQConnection::open() - The driver %1 is not supported").arg(db.driverName());
+        return false;
+    }
+
+    if (!m_defaultConnection.isOpen()
+        && this != &m_defaultConnection
+        ) {
+
+        d.operator = (m_defaultConnection.d); // It become the default connection
+
+    }
+
+    d->m_sql.setStatement(statement);
+    d->m_sql.setDatabase(db);
+
+    // The connection is not left opened with a part of the options
+    if (!applyOptions(options)) {
+        close();
+        d->options = DQConnectionOptions();
+        return false;
+    }
+
+    return true;
+}
+
+bool DQConnection::openInMemory(QString persistPath,int interval,DQConnectionOptions options){
+    // Without the C API the version of SQLite is not known , opening the "memdb" VFS fails on an old library
+#if !defined(DQ_SQLITE_API) || (SQLITE_VERSION_NUMBER >= 3036000 && !defined(SQLITE_OMIT_DESERIALIZE))
+    static QAtomicInt counter;
+    QString name = QString("dquest_memory_%1").arg(counter.fetchAndAddOrdered(1));
+
+    bool res;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE",name);
+
+        // The name must start with "/" to be shared by the connections of the process
+        db.setDatabaseName(QString("file:/%1?vfs=memdb").arg(name));
+        db.setConnectOptions("QSQLITE_OPEN_URI");
+
+        res = db.open();
+        if (!res)
+            qWarning() << QString("DQConnection::openInMemory() - Failed to open the database : %1").arg(db.lastError().text());
+
+        if (res && !persistPath.isEmpty()) {
+            res = _DQPersister::load(_dqSqliteHandle(db),persistPath);
+        }
+
+        if (res)
+            res = open(db,options);
+
+        if (!res) {
+            d->m_sql.setDatabase(QSqlDatabase());
+            db.close();
+        }
+    }
+
+    if (!res) {
+        QSqlDatabase::removeDatabase(name);
+        return false;
+    }
+
+    d->memoryDatabase = name;
+    if (!persistPath.isEmpty())
+        d->persister = new _DQPersister(this,persistPath,interval);
+
+    return true;
+#else
+    Q_UNUSED(persistPath);
+    Q_UNUSED(interval);
+    Q_UNUSED(options);
+    qWarning() << "DQConnection::openInMemory() - It requires SQLite 3.36 or later";
+    return false;
+#endif
+}
+
+bool DQConnection::persist(){
+    if (!d->persister) {
+        qWarning() << "DQConnection::persist() - The connection is not opened by openInMemory() with a file";
+        return false;
+    }
+
+    return d->persister->persistNow();
+}
+
+DQConnectionOptions DQConnection::options(){
+    return d->options;
+}
+
+bool DQConnection::applyOptions(DQConnectionOptions options){
+    d->options = options;
+
+    // Removing the handler also clears the busy timeout , so it goes before the PRAGMA
+    delete d->busyHandler;
+    d->busyHandler = 0;
+
+    if (!options.isNull() && d->m_sql.database().driverName() != "QSQLITE") {
+        qWarning() << "DQConnection::open() - DQConnectionOptions is only supported by the QSQLITE driver";
+        return false;
+    }
+
+    bool res = true;
+    foreach (QString pragma , options.pragmas()) {
+        QSqlQuery q = query();
+        if (!q.exec(pragma)) {
+            qWarning() << QString("DQConnection::open() - Failed to apply %1 : %2").arg(pragma)
+                          .arg(q.lastError().text());
+            setLastQuery(q);
+            res = false;
+        }
+    }
+
+    if (!options.retryPolicy.isNull() && !applyRetryPolicy())
+        res = false;
+
+    return res;
+}
+
+bool DQConnection::applyRetryPolicy(){
+    delete d->busyHandler;
+    d->busyHandler = 0;
+
+#ifdef DQ_SQLITE_API
+    sqlite3 *handle = _dqSqliteHandle(d->m_sql.database());
+    if (!handle) {
+        qWarning() << "DQConnection::setRetryPolicy() - The connection is not opened by the QSQLITE driver";
+        return false;
+    }
+
+    if (d->options.retryPolicy.isNull()) {
+        sqlite3_busy_timeout(handle,d->options.busyTimeout.isNull() ? 0 : d->options.busyTimeout.toInt());
+        return true;
+    }
+
+    d->busyHandler = new _DQBusyHandler(d->m_sql.database(),d->options.retryPolicy);
+    return true;
+#else
+    if (d->m_sql.database().driverName() != "QSQLITE") {
+        qWarning() << "DQConnection::setRetryPolicy() - The connection is not opened by the QSQLITE driver";
+        return false;
+    }
+
+    // The busy handler can't be installed , SQLite waits up to the timeout of the policy instead
+    int timeout = d->options.retryPolicy.isNull() ?
+                  (d->options.busyTimeout.isNull() ? 0 : d->options.busyTimeout.toInt()) :
+                  d->options.retryPolicy.timeout;
+
+    QSqlQuery q = query();
+    if (!q.exec(QString("PRAGMA busy_timeout = %1;").arg(timeout))) {
+        qWarning() << QString("DQConnection::setRetryPolicy() - Failed : %1").arg(q.lastError().text());
+        setLastQuery(q);
+        return false;
+    }
+    return true;
+#endif
+}
+
+DQConnection DQConnection::clone(QString connectionName){
+    DQConnection res;
+
+    QSqlDatabase source = d->m_sql.database();
+    if (!source.isValid()) {
+        qWarning() << "DQConnection::clone() - The connection is not opened";
+        return res;
+    }
+
+#if QT_VERSION >= 0x050D00
+    QSqlDatabase db = QSqlDatabase::cloneDatabase(source.connectionName(),connectionName);
+#else
+    QSqlDatabase db = QSqlDatabase::cloneDatabase(source,connectionName);
+#endif
+
+    if (!db.open()) {
+        qWarning() << QString("DQConnection::clone() - Failed to open database : %1").arg(db.lastError().text());
+        return res;
+    }
+
+    res.d->m_sql.setStatement(DQSqlStatement::create(db.driverName()));
+    res.d->m_sql.setDatabase(db);
+    res.d->m_models = d->m_models;
+    res.d->schemaFingerprintEnabled = d->schemaFingerprintEnabled;
+    res.d->writerThread = d->writerThread;
+    res.applyOptions(d->options);
+
+    QMapIterator<QString,QString> iter(d->attachments);
+    while (iter.hasNext()) {
+        iter.next();
+        res.attach(iter.value(),iter.key());
+    }
+
+    QHash<const DQModelMetaInfo*,QString> bindings = d->m_sql.statement()->schemaBindings();
+    QHashIterator<const DQModelMetaInfo*,QString> bindingIter(bindings);
+    while (bindingIter.hasNext()) {
+        bindingIter.next();
+        res.d->m_sql.statement()->bindSchema(bindingIter.key(),bindingIter.value());
+    }
+
+    sqlite3 *handle = _dqSqliteHandle(db);
+    if (handle) {
+        foreach (_DQSqlFunction function , d->functions) {
+            function.install(handle);
+        }
+    }
+    res.d->functions = d->functions;
+
+    return res;
+}
+
+DQConnection DQConnection::snapshot(QString connectionName){
+    DQConnection res;
+
+#ifndef SQLITE_ENABLE_SNAPSHOT
+    if (d->snapshot) {
+        qWarning() << "DQConnection::snapshot() - Sharing a snapshot requires SQLITE_ENABLE_SNAPSHOT";
+        return res;
+    }
+#endif
+
+    if (!isOpen()) {
+        qWarning() << "DQConnection::snapshot() - The connection is not opened";
+        return res;
+    }
+
+    QSqlDatabase db = d->m_sql.database();
+    if (db.driverName() != "QSQLITE") {
+        qWarning() << "DQConnection::snapshot() - Only the QSQLITE driver is supported";
+        return res;
+    }
+
+    if (db.databaseName().isEmpty() || db.databaseName() == ":memory:") {
+        qWarning() << "DQConnection::snapshot() - An in-memory database could not be shared by other connection";
+        return res;
+    }
+
+    if (!d->snapshot) {
+        QSqlQuery q = query();
+        if (q.exec("PRAGMA journal_mode") && q.next() && q.value(0).toString().toLower() != "wal") {
+            qWarning() << "DQConnection::snapshot() - The journal mode is not WAL. The writers are blocked until the snapshot is closed";
+        }
+    }
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+    if (d->snapshot && !d->snapshotHandle) {
+        qWarning() << "DQConnection::snapshot() - The snapshot could not be shared";
+        return res;
+    }
+#endif
+
+    res = clone(connectionName);
+    if (!res.isOpen())
+        return res;
+
+    // close() ends the read transaction
+    res.d->snapshot = true;
+
+    QSqlQuery q = res.query();
+    bool ok = q.exec("PRAGMA query_only = 1") && res.transaction();
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+    sqlite3 *handle = _dqSqliteHandle(res.sql().database());
+    if (ok && d->snapshot && d->snapshotHandle) {
+        // It must be opened before the first read of the transaction
+        int rc = handle ? sqlite3_snapshot_open(handle,"main",d->snapshotHandle) : SQLITE_ERROR;
+        if (rc != SQLITE_OK) {
+            qWarning() << QString("DQConnection::snapshot() - Failed to open the snapshot : %1")
+                          .arg(handle ? QString::fromUtf8(sqlite3_errmsg(handle)) : QString("Not a SQLite connection"));
+            ok = false;
+        }
+    }
+#endif
+
+    // The read transaction is started on the first read
+    ok = ok && q.exec("SELECT count(*) FROM sqlite_master") && q.next();
+    q.finish();
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+    if (ok && handle && sqlite3_snapshot_get(handle,"main",&res.d->snapshotHandle) != SQLITE_OK) {
+        qWarning() << QString("DQConnection::snapshot() - Failed to get the snapshot : %1")
+                      .arg(QString::fromUtf8(sqlite3_errmsg(handle)));
+        res.d->snapshotHandle = 0;
+    }
+#endif
+
+    if (!ok) {
+        qWarning() << QString("DQConnection::snapshot() - Failed to start the read transaction : %1").arg(q.lastError().text());
+        res.close();
+        return DQConnection();
+    }
+
+    return res;
+}
+
+bool DQConnection::isSnapshot(){
+    return d->snapshot;
+}
+
+bool DQConnection::exportSnapshot(QList<DQModelMetaInfo*> models,QString path){
+    QSqlDatabase db = d->m_sql.database();
+    if (db.driverName() != "QSQLITE") {
+        qWarning() << "DQConnection::exportSnapshot() - Only the QSQLITE driver is supported";
+        return false;
+    }
+
+    if (QFile::exists(path) && !QFile::remove(path)) {
+        qWarning() << QString("DQConnection::exportSnapshot() - Failed to replace %1").arg(path);
+        return false;
+    }
+
+    const QString schema = "dq_export";
+
+    QSqlQuery q = query();
+    q.prepare(QString("ATTACH DATABASE :path AS %1").arg(schema));
+    q.bindValue(":path",path);
+    if (!q.exec()) {
+        qWarning() << QString("DQConnection::exportSnapshot() - Failed to create %1 : %2").arg(path).arg(q.lastError().text());
+        setLastQuery(q);
+        return false;
+    }
+
+    DQSqlStatement *statement = d->m_sql.statement();
+    bool res = transaction();
+
+    foreach (DQModelMetaInfo* info , models) {
+        if (!res)
+            break;
+
+        QString name = info->name();
+        QString target = QString("%1.%2").arg(schema).arg(name);
+        QString columns = info->writableFields(info->columnNameList()).join(",");
+
+        res = q.exec(statement->createTableIfNotExists(info,target)) &&
+              q.exec(QString("INSERT INTO %1 (%2) SELECT %2 FROM main.%3").arg(target).arg(columns).arg(name));
+        if (!res)
+            break;
+
+        // The indexes are created after the records are written
+        QSqlQuery indexes = query();
+        indexes.prepare("SELECT name,sql FROM main.sqlite_master WHERE type = 'index' AND tbl_name = :table AND sql IS NOT NULL");
+        indexes.bindValue(":table",name);
+        if (!indexes.exec()) {
+            q = indexes;
+            res = false;
+            break;
+        }
+        while (res && indexes.next()) {
+            QString index = indexes.value(0).toString();
+            QString sql = indexes.value(1).toString();
+            int pos = sql.indexOf(index);
+            if (pos >= 0)
+                sql.insert(pos,schema + ".");
+            res = q.exec(sql);
+        }
+    }
+
+    if (!res) {
+        qWarning() << QString("DQConnection::exportSnapshot() - Failed to export to %1 : %2").arg(path).arg(q.lastError().text());
+        setLastQuery(q);
+        rollback();
+    } else {
+        res = commit();
+    }
+
+    q = query();
+    q.exec(QString("DETACH DATABASE %1").arg(schema));
+
+    if (!res)
+        QFile::remove(path);
+
+    return res;
+}
+
+bool DQConnection::exportSnapshot(QString path){
+    QSqlDatabase db = d->m_sql.database();
+    if (db.driverName() != "QSQLITE") {
+        qWarning() << "DQConnection::exportSnapshot() - Only the QSQLITE driver is supported";
+        return false;
+    }
+
+    if (QFile::exists(path) && !QFile::remove(path)) {
+        qWarning() << QString("DQConnection::exportSnapshot() - Failed to replace %1").arg(path);
+        return false;
+    }
+
+    QSqlQuery q = query();
+    q.prepare("VACUUM INTO :path");
+    q.bindValue(":path",path);
+    bool res = q.exec();
+    setLastQuery(q);
+
+    if (!res)
+        qWarning() << QString("DQConnection::exportSnapshot() - Failed to export to %1 : %2").arg(path).arg(q.lastError().text());
+
+    return res;
+}
+
+bool DQConnection::backupTo(QString path,int pagesPerStep,int sleepMs,DQBackupProgressFunc progress,void *userData){
+#ifndef DQ_SQLITE_API
+    Q_UNUSED(pagesPerStep);
+    Q_UNUSED(sleepMs);
+
+    if (d->m_sql.database().driverName() != "QSQLITE") {
+        qWarning() << "DQConnection::backupTo() - The connection is not opened by the QSQLITE driver";
+        return false;
+    }
+
+    bool res = exportSnapshot(path);
+    if (res && progress) {
+        QSqlQuery q = query();
+        int pages = q.exec("PRAGMA page_count;") && q.next() ? q.value(0).toInt() : 0;
+        if (!progress(0,pages,userData)) {
+            QFile::remove(path);
+            return false;
+        }
+    }
+    return res;
+#else
+    sqlite3 *source = _dqSqliteHandle(d->m_sql.database());
+    if (!source) {
+        qWarning() << "DQConnection::backupTo() - The connection is not opened by the QSQLITE driver";
+        return false;
+    }
+
+    sqlite3 *dest = 0;
+    QByteArray file = path.toUtf8();
+    if (sqlite3_open_v2(file.constData(),&dest,SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,0) != SQLITE_OK) {
+        qWarning() << QString("DQConnection::backupTo() - Failed to open %1 : %2").arg(path)
+                      .arg(QString::fromUtf8(sqlite3_errmsg(dest)));
+        sqlite3_close(dest);
+        return false;
+    }
+
+    sqlite3_backup *backup = sqlite3_backup_init(dest,"main",source,"main");
+    if (!backup) {
+        qWarning() << QString("DQConnection::backupTo() - Failed to start : %1").arg(QString::fromUtf8(sqlite3_errmsg(dest)));
+        sqlite3_close(dest);
+        QFile::remove(path);
+        return false;
+    }
+
+    int nPage = pagesPerStep > 0 ? pagesPerStep : -1;
+    bool aborted = false;
+    int rc;
+
+    do {
+        rc = sqlite3_backup_step(backup,nPage);
+
+        if (progress && !progress(sqlite3_backup_remaining(backup),sqlite3_backup_pagecount(backup),userData)) {
+            aborted = true;
+            break;
+        }
+
+        if ((rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) && sleepMs > 0)
+            sqlite3_sleep(sleepMs);
+
+    } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+    sqlite3_backup_finish(backup);
+
+    bool res = !aborted && rc == SQLITE_DONE && sqlite3_errcode(dest) == SQLITE_OK;
+    if (!res && !aborted) {
+        qWarning() << QString("DQConnection::backupTo() - Failed to copy to %1 : %2").arg(path)
+                      .arg(QString::fromUtf8(sqlite3_errstr(rc)));
+    }
+
+    sqlite3_close(dest);
+
+    if (!res)
+        QFile::remove(path);
+
+    return res;
+#endif
+}
+
+bool DQConnection::importSnapshot(QString path,QString schema,qint64 mmapSize){
+    QSqlDatabase db = d->m_sql.database();
+    if (db.driverName() != "QSQLITE") {
+        qWarning() << "DQConnection::importSnapshot() - Only the QSQLITE driver is supported";
+        return false;
+    }
+
+    if (!QFile::exists(path)) {
+        qWarning() << QString("DQConnection::importSnapshot() - %1 is not existed").arg(path);
+        return false;
+    }
+
+    QString file = path;
+    if (db.connectOptions().contains("QSQLITE_OPEN_URI")) {
+        file = QString("file:%1?mode=ro").arg(QUrl::toPercentEncoding(QFileInfo(path).absoluteFilePath(),"/").constData());
+    }
+
+    QSqlQuery q = query();
+    q.prepare(QString("ATTACH DATABASE :path AS %1").arg(schema));
+    q.bindValue(":path",file);
+    bool res = q.exec();
+
+    if (res && mmapSize > 0)
+        res = q.exec(QString("PRAGMA %1.mmap_size = %2").arg(schema).arg(mmapSize));
+
+    setLastQuery(q);
+
+    if (!res) {
+        qWarning() << QString("DQConnection::importSnapshot() - Failed to attach %1 : %2").arg(path).arg(q.lastError().text());
+        QSqlQuery detach = query();
+        detach.exec(QString("DETACH DATABASE %1").arg(schema));
+        return false;
+    }
+
+    // The unqualified table names may refer to the attached database now
+    d->m_sql.clearStatementCache();
+    d->m_sql.clearResultCache();
+
+    return true;
+}
+
+bool DQConnection::detachSnapshot(QString schema){
+    d->m_sql.clearStatementCache();
+    d->m_sql.clearResultCache();
+
+    QSqlQuery q = query();
+    bool res = q.exec(QString("DETACH DATABASE %1").arg(schema));
+    setLastQuery(q);
+
+    if (!res)
+        qWarning() << QString("DQConnection::detachSnapshot() - Failed to detach %1 : %2").arg(schema).arg(q.lastError().text());
+
+    return res;
+}
+
+bool DQConnection::attach(QString path,QString alias){
+    QSqlDatabase db = d->m_sql.database();
+    if (db.driverName() != "QSQLITE") {
+        qWarning() << "DQConnection::attach() - Only the QSQLITE driver is supported";
+        return false;
+    }
+
+    if (alias.isEmpty() || alias.toLower() == "main" || alias.toLower() == "temp") {
+        qWarning() << QString("DQConnection::attach() - Invalid schema name %1").arg(alias);
+        return false;
+    }
+
+    QString file = QFileInfo(path).absoluteFilePath();
+
+    QSqlQuery q = query();
+    q.prepare(QString("ATTACH DATABASE :path AS %1").arg(alias));
+    q.bindValue(":path",file);
+    bool res = q.exec();
+    setLastQuery(q);
+
+    if (!res) {
+        qWarning() << QString("DQConnection::attach() - Failed to attach %1 : %2").arg(path).arg(q.lastError().text());
+        return false;
+    }
+
+    d->attachments.insert(alias,file);
+
+    // The unqualified table names may refer to the attached database now
+    d->m_sql.clearStatementCache();
+    d->m_sql.clearResultCache();
+
+    return true;
+}
+
+bool DQConnection::detach(QString alias){
+    if (!d->attachments.contains(alias)) {
+        qWarning() << QString("DQConnection::detach() - %1 is not attached").arg(alias);
+        return false;
+    }
+
+    DQSqlStatement *statement = d->m_sql.statement();
+    QHashIterator<const DQModelMetaInfo*,QString> iter(statement->schemaBindings());
+    while (iter.hasNext()) {
+        iter.next();
+        if (iter.value() == alias)
+            statement->bindSchema(iter.key(),QString());
+    }
+
+    d->m_sql.clearStatementCache();
+    d->m_sql.clearResultCache();
+
+    QSqlQuery q = query();
+    bool res = q.exec(QString("DETACH DATABASE %1").arg(alias));
+    setLastQuery(q);
+
+    if (!res) {
+        qWarning() << QString("DQConnection::detach() - Failed to detach %1 : %2").arg(alias).arg(q.lastError().text());
+        return false;
+    }
+
+    d->attachments.remove(alias);
+    return true;
+}
+
+QStringList DQConnection::attachedSchemas(){
+    return d->attachments.keys();
+}
+
+void DQConnection::bindSchema(DQModelMetaInfo* metaInfo,QString alias){
+    DQSqlStatement *statement = d->m_sql.statement();
+    if (!statement) {
+        qWarning() << "DQConnection::bindSchema() - The connection is not opened";
+        return;
+    }
+
+    // The full text index and its triggers are created in the main database
+    if (!alias.isEmpty() && !metaInfo->fullTextNameList().isEmpty()) {
+        qWarning() << QString("DQConnection::bindSchema() - %1 has DQFullText fields , it could not be bound to an attached database")
+                      .arg(metaInfo->className());
+        return;
+    }
+
+    statement->bindSchema(metaInfo,alias);
+
+    // The cached statements and results refer to the previous table
+    d->m_sql.clearStatementCache();
+    d->m_sql.clearResultCache();
+}
+
+bool DQConnection::isOpen(){
+    return d->m_sql.database().isOpen();
+}
+
+static bool _dqRegisterFunction(DQConnectionPriv *d,const _DQSqlFunction &function,const char *method){
+    sqlite3 *handle = _dqSqliteHandle(d->m_sql.database());
+    if (!handle) {
+#ifdef DQ_SQLITE_API
+        qWarning() << QString("DQConnection::%1() - Only the QSQLITE driver is supported").arg(method);
+#else
+        qWarning() << QString("DQConnection::%1() - It requires DQuest built with dquest_sqlite_api").arg(method);
+#endif
+        return false;
+    }
+
+    if (function.name.isEmpty() || function.nArgs < -1) {
+        qWarning() << QString("DQConnection::%1() - Invalid function %2").arg(method).arg(function.name);
+        return false;
+    }
+
+    if (!function.install(handle))
+        return false;
+
+    for (int i = d->functions.size() - 1 ; i >= 0;i--) {
+        if (d->functions.at(i).isSame(function.name,function.nArgs))
+            d->functions.removeAt(i);
+    }
+    d->functions << function;
+
+    // The prepared statements and cached results may use the old definition
+    d->m_sql.clearStatementCache();
+    d->m_sql.clearResultCache();
+
+    return true;
+}
+
+bool DQConnection::registerFunction(QString name,int nArgs,DQSqlFunction function,void *userData,bool deterministic){
+    if (!function) {
+        qWarning() << "DQConnection::registerFunction() - The function is NULL";
+        return false;
+    }
+
+    _DQSqlFunction item;
+    item.name = name;
+    item.nArgs = nArgs;
+    item.function = function;
+    item.userData = userData;
+    item.deterministic = deterministic;
+
+    return _dqRegisterFunction(d.data(),item,"registerFunction");
+}
+
+bool DQConnection::registerAggregate(QString name,int nArgs,DQSqlAggregateStep step,DQSqlAggregateFinal final,void *userData){
+    if (!step || !final) {
+        qWarning() << "DQConnection::registerAggregate() - The step and final function are required";
+        return false;
+    }
+
+    _DQSqlFunction item;
+    item.name = name;
+    item.nArgs = nArgs;
+    item.step = step;
+    item.final = final;
+    item.userData = userData;
+
+    return _dqRegisterFunction(d.data(),item,"registerAggregate");
+}
+
+bool DQConnection::unregisterFunction(QString name,int nArgs){
+    int index = -1;
+    for (int i = 0 ; i < d->functions.size();i++) {
+        if (d->functions.at(i).isSame(name,nArgs))
+            index = i;
+    }
+
+    if (index < 0) {
+        qWarning() << QString("DQConnection::unregisterFunction() - %1 is not registered").arg(name);
+        return false;
+    }
+
+    d->functions.removeAt(index);
+
+    sqlite3 *handle = _dqSqliteHandle(d->m_sql.database());
+    if (handle)
+        _DQSqlFunction::uninstall(handle,name,nArgs);
+
+    d->m_sql.clearStatementCache();
+    d->m_sql.clearResultCache();
+
+    return true;
+}
+
+void DQConnection::close(){
+    setWriteBehindEnabled(false); // The pending rows are written
+
+    setReadWriteSplitEnabled(false);
+
+    delete d->persister; // The last changes are written
+    d->persister = 0;
+
+    delete d->maintenance;
+    d->maintenance = 0;
+
+    delete d->busyHandler;
+    d->busyHandler = 0;
 
-bool DQConnection::open(QSqlDatabase db){
-    Q_ASSERT(db.isOpen());
+    d->asyncMutex.lock();
+    delete d->asyncWorker; // The pending async queries are canceled
+    d->asyncWorker = 0;
+    d->asyncMutex.unlock();
 
-    if (db.driverName() != "QSQLITE") {
-        qWarning() << "Only QSQLITE dirver is supported.";
-        return false;
+    delete d->changeHook;
+    d->changeHook = 0;
+
+    if (d->snapshot) {
+        d->releaseSnapshot();
+        if (isOpen())
+            d->m_sql.rollback(); // End the read transaction
+        d->snapshot = false;
     }
 
-    if (!m_defaultConnection.isOpen()
-        && this != &m_defaultConnection
-        ) {
+    d->attachments.clear(); // They are detached with the database
 
-        d.operator = (m_defaultConnection.d); // It become the default connection
+    d->functions.clear();
+
+    // The queries of all the threads refer to the database
+    d->lastQueryMutex.lock();
+    d->lastQuery.clear();
+    d->lastQueryMutex.unlock();
 
+    QString memoryDatabase = d->memoryDatabase;
+    d->memoryDatabase.clear();
+
+    d->m_sql.setDatabase(QSqlDatabase());
+
+    if (!memoryDatabase.isEmpty()) {
+        QSqlDatabase::database(memoryDatabase,false).close();
+        QSqlDatabase::removeDatabase(memoryDatabase);
     }
+}
 
-    d->m_sql.setStatement(new DQSqliteStatement());
-    d->m_sql.setDatabase(db);
+_DQAsyncWorker* DQConnection::asyncWorker(){
+    QMutexLocker locker(&d->asyncMutex);
+    if (!d->asyncWorker && isOpen())
+        d->asyncWorker = new _DQAsyncWorker(this);
+    return d->asyncWorker;
+}
 
-    return true;
+_DQWriteBehind* DQConnection::writeBehind(){
+    return d->writeBehind;
 }
 
-bool DQConnection::isOpen(){
-    return d->m_sql.database().isOpen();
+_DQProfiler* DQConnection::profiler(){
+    return d->profiler;
 }
 
-void DQConnection::close(){
-    if (d->lastQuery) {
-        delete d->lastQuery;
-        d->lastQuery = 0;
-    }
-    d->m_sql.setDatabase(QSqlDatabase());
+_DQWriterThread* DQConnection::writerThread(){
+    return d->writerThread.data();
 }
 
 bool DQConnection::addModel(DQModelMetaInfo* metaInfo){
@@ -108,6 +960,10 @@ bool DQConnection::addModel(DQModelMetaInfo* metaInfo){
 }
 
 DQConnection DQConnection::defaultConnection(){
+    DQConnectionPool* pool = DQConnectionPool::defaultPool();
+    if (pool)
+        return pool->connection();
+
     return m_defaultConnection;
 }
 
@@ -117,9 +973,110 @@ void DQConnection::setToDefaultConnection(){
     }
 }
 
+/// Read the first integer of a PRAGMA. It is -1 on failure.
+static qint64 _dqPragma(QSqlQuery &q,const QString &pragma){
+    if (!q.exec(QString("PRAGMA %1").arg(pragma)) || !q.next())
+        return -1;
+    return q.value(0).toLongLong();
+}
+
+/// Describe the declaration of a model for the schema fingerprint
+static QByteArray _dqSchemaSignature(const DQModelMetaInfo *info){
+    QStringList res;
+    res << info->name() << info->className();
+
+    int n = info->size();
+    for (int i = 0 ; i < n;i++) {
+        const DQModelMetaInfoField *field = info->at(i);
+        DQClause clause = field->clause;
+        QStringList flags;
+        for (int type = 0 ; type < DQClause::LAST;type++) {
+            if (!clause.testFlag((DQClause::Type) type))
+                continue;
+            QString value;
+            if (type == DQClause::FOREIGN_KEY) {
+                DQModelMetaInfo *linked = info->linkedMetaInfo(i);
+                value = linked ? linked->name() : QString();
+            } else {
+                value = clause.flag((DQClause::Type) type).toString();
+            }
+            flags << QString("%1=%2").arg(type).arg(value);
+        }
+        res << QString("%1:%2:%3").arg(field->name).arg((int) field->type).arg(flags.join(","));
+    }
+
+    foreach (DQModelMetaInfoIndex index , info->indexList()) {
+        res << QString("index:%1:%2:%3:%4").arg(index.name)
+               .arg(index.columns.join(","))
+               .arg(index.unique ? 1 : 0)
+               .arg(index.where);
+    }
+
+    return res.join("\n").toUtf8();
+}
+
+void DQConnection::setSchemaFingerprintEnabled(bool enabled){
+    d->schemaFingerprintEnabled = enabled;
+}
+
+bool DQConnection::isSchemaFingerprintEnabled(){
+    return d->schemaFingerprintEnabled;
+}
+
+int DQConnection::schemaFingerprint(){
+    // The format version is changed whenever the generated DDL of the same declaration is changed
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray("dquest-schema-1"));
+    hash.addData(d->m_sql.database().driverName().toUtf8());
+
+    foreach (DQModelMetaInfo* info ,d->m_models) {
+        hash.addData(QByteArray(1,'\0'));
+        hash.addData(_dqSchemaSignature(info));
+    }
+
+    QByteArray digest = hash.result();
+    int res = ((uchar) digest.at(0) << 24 | (uchar) digest.at(1) << 16 | (uchar) digest.at(2) << 8 | (uchar) digest.at(3)) & 0x7fffffff;
+
+    // Zero is the value of a new database
+    return res == 0 ? 1 : res;
+}
+
+bool DQConnection::clearSchemaFingerprint(){
+    QSqlDatabase db = d->m_sql.database();
+    if (!db.isOpen() || db.driverName() != "QSQLITE") {
+        qWarning() << "DQConnection::clearSchemaFingerprint() - The connection is not opened by the QSQLITE driver";
+        return false;
+    }
+
+    QSqlQuery q = d->m_sql.query();
+    if (!q.exec("PRAGMA user_version = 0")) {
+        setLastQuery(q);
+        return false;
+    }
+    return true;
+}
+
+/// TRUE if createTables() could use the schema fingerprint stored in database
+static bool _dqCanUseSchemaFingerprint(DQSql &sql){
+    return sql.database().driverName() == "QSQLITE" && sql.statement()->schemaBindings().isEmpty();
+}
+
 bool DQConnection::createTables(){
 
     bool res = true;
+
+    bool fingerprint = d->schemaFingerprintEnabled && _dqCanUseSchemaFingerprint(d->m_sql);
+    int value = 0;
+    if (fingerprint) {
+        value = schemaFingerprint();
+        QSqlQuery q = d->m_sql.query();
+        if (_dqPragma(q,"user_version") == value)
+            return true;
+    }
+
+    // Seeding of initial data is written within a single transaction
+    DQTransaction transaction(*this);
+
     foreach (DQModelMetaInfo* info ,d->m_models) {
 
         if (!d->m_sql.exists(info)) {
@@ -141,12 +1098,124 @@ bool DQConnection::createTables(){
         }
     }
 
+    if (res)
+        res = transaction.commit();
+
+    // The indexes are created after the initial data is inserted , so the seeding do not pay for index maintenance
+    if (res)
+        res = createDeclaredIndexes();
+
+    if (res)
+        res = createFullTextIndexes();
+
+    if (res && fingerprint) {
+        QSqlQuery q = d->m_sql.query();
+        if (!q.exec(QString("PRAGMA user_version = %1").arg(value))) {
+            qWarning() << QString("DQConnection::createTables() - Failed to store the schema fingerprint . Error : %1")
+                          .arg(q.lastError().text());
+            setLastQuery(q);
+        }
+    }
+
+    return res;
+}
+
+bool DQConnection::createDeclaredIndexes(){
+    bool res = true;
+
+    foreach (DQModelMetaInfo* info ,d->m_models) {
+        foreach (DQModelMetaInfoIndex declaration , info->indexList()) {
+            DQBaseIndex index(info,declaration.name);
+            index.setColumnDefList(declaration.columns);
+            index.setUnique(declaration.unique);
+            index.setWhere(declaration.where);
+
+            if (!d->m_sql.createIndexIfNotExists(index)) {
+                qWarning() << QString("DQConnection::createTables() - Failed to create index %1 for %2 . Error : %3").arg(declaration.name)
+                        .arg(info->className())
+                        .arg( d->m_sql.lastQuery().lastError().text());
+                setLastQuery( d->m_sql.lastQuery() );
+                res = false;
+            }
+        }
+    }
+
+    return res;
+}
+
+bool DQConnection::migrate(){
+    bool res = true;
+    DQSqlStatement *statement = d->m_sql.statement();
+
+    foreach (DQModelMetaInfo* info ,d->m_models) {
+        if (!d->m_sql.exists(info))
+            continue;
+
+        QStringList columns = d->m_sql.columns(info);
+
+        int n = info->size();
+        for (int i = 0 ; i < n;i++) {
+            const DQModelMetaInfoField *field = info->at(i);
+            if (columns.contains(field->name))
+                continue;
+
+            if (!statement->canAddColumn(field)) {
+                qWarning() << QString("DQConnection::migrate() - %1.%2 could not be added to existing table. Call rebuildTable() for it")
+                              .arg(info->name()).arg(field->name);
+                res = false;
+                continue;
+            }
+
+            if (!d->m_sql.addColumn(info,field->name)) {
+                qWarning() << QString("DQConnection::migrate() - Failed to add %1.%2 . Error : %3").arg(info->name())
+                              .arg(field->name)
+                              .arg(d->m_sql.lastQuery().lastError().text());
+                setLastQuery( d->m_sql.lastQuery() );
+                res = false;
+            }
+        }
+    }
+
+    if (!createTables())
+        res = false;
+
+    return res;
+}
+
+bool DQConnection::rebuildTable(DQModelMetaInfo* metaInfo,int batchSize){
+    bool res = d->m_sql.rebuildTable(metaInfo,batchSize);
+    setLastQuery(d->m_sql.lastQuery());
+    return res;
+}
+
+int DQConnection::removeIds(DQModelMetaInfo* metaInfo,QVariantList ids){
+    int res = d->m_sql.removeIds(metaInfo,ids);
+    setLastQuery(d->m_sql.lastQuery());
+    return res;
+}
+
+bool DQConnection::createFullTextIndexes(){
+    bool res = true;
+
+    foreach (DQModelMetaInfo* info ,d->m_models) {
+        if (!d->m_sql.createFullTextIndex(info)) {
+            qWarning() << QString("DQConnection::createTables() - Failed to create the full text index for %1 . Error : %2").arg(info->className())
+                    .arg( d->m_sql.lastQuery().lastError().text());
+            setLastQuery( d->m_sql.lastQuery() );
+            res = false;
+        }
+    }
+
     return res;
 }
 
 bool DQConnection::dropTables() {
     bool res = true;
 
+    // The stored fingerprint no longer describes the database
+    if (d->schemaFingerprintEnabled && _dqCanUseSchemaFingerprint(d->m_sql))
+        clearSchemaFingerprint();
+
     foreach (DQModelMetaInfo* info ,d->m_models) {
         if (!d->m_sql.exists(info))
             continue;
@@ -170,6 +1239,18 @@ bool DQConnection::dropIndex(QString name){
     return d->m_sql.dropIndexIfExists(name);
 }
 
+bool DQConnection::transaction(){
+    return d->m_sql.transaction();
+}
+
+bool DQConnection::commit(){
+    return d->m_sql.commit();
+}
+
+bool DQConnection::rollback(){
+    return d->m_sql.rollback();
+}
+
 DQSql& DQConnection::sql(){
     return d->m_sql;
 }
@@ -179,24 +1260,377 @@ QSqlQuery DQConnection::query(){
 }
 
 void DQConnection::setLastQuery(QSqlQuery query){
-    d->mutex.lock();
-    if (d->lastQuery != 0)
-        delete d->lastQuery;
-    d->lastQuery = new QSqlQuery(query);
-    d->mutex.unlock();
+    if (!d->lastQueryEnabled)
+        return;
+
+    QMutexLocker locker(&d->lastQueryMutex);
+    d->lastQuery[QThread::currentThread()] = query;
 }
 
 QSqlQuery DQConnection::lastQuery(){
-    /*
-      Although lastQuery() is thread-safe, but as it do not hold the
-      lastQuery per thread. The result become meaningless , as it
-      may override by another thread.
-     @todo Implement last query storage per thread.
-     */
-    QSqlQuery query;
-    d->mutex.lock();
-    query = *d->lastQuery;
-    d->mutex.unlock();
-
-    return query;
+    QMutexLocker locker(&d->lastQueryMutex);
+    return d->lastQuery.value(QThread::currentThread());
+}
+
+void DQConnection::setLastQueryEnabled(bool enabled){
+    d->lastQueryEnabled = enabled;
+    if (!enabled) {
+        QMutexLocker locker(&d->lastQueryMutex);
+        d->lastQuery.clear();
+    }
+
+    d->m_sql.setLastQueryEnabled(enabled);
+}
+
+bool DQConnection::isLastQueryEnabled(){
+    return d->lastQueryEnabled;
+}
+
+void DQConnection::setIdentityMapEnabled(bool enabled,int capacity){
+    if (capacity >= 0)
+        d->m_sql.setIdentityMapCapacity(capacity);
+    d->m_sql.setIdentityMapEnabled(enabled);
+}
+
+bool DQConnection::isIdentityMapEnabled(){
+    return d->m_sql.isIdentityMapEnabled();
+}
+
+void DQConnection::setWriteBehindEnabled(bool enabled,int batchSize,int window,int capacity){
+    if (d->writeBehind) {
+        waitForFlush();
+        delete d->writeBehind;
+        d->writeBehind = 0;
+    }
+
+    if (!enabled)
+        return;
+
+    if (!isOpen()) {
+        qWarning() << "DQConnection::setWriteBehindEnabled() - The connection is not opened";
+        return;
+    }
+
+    d->writeBehind = new _DQWriteBehind(this,batchSize,window,capacity);
+}
+
+bool DQConnection::isWriteBehindEnabled(){
+    return d->writeBehind != 0;
+}
+
+void DQConnection::flush(){
+    if (d->writeBehind)
+        d->writeBehind->flush();
+}
+
+bool DQConnection::waitForFlush(){
+    if (!d->writeBehind)
+        return true;
+
+    QSet<QString> tables;
+    bool res = d->writeBehind->waitForFlush(tables);
+    foreach (QString table , tables) {
+        d->m_sql.notifyTableChanged(table);
+    }
+    return res;
+}
+
+int DQConnection::pendingWrites(){
+    if (!d->writeBehind)
+        return 0;
+    return d->writeBehind->pending();
+}
+
+void DQConnection::setReadWriteSplitEnabled(bool enabled,int batchSize){
+    // The clones of readers release their reference to the writer
+    delete d->readerPool;
+    d->readerPool = 0;
+    d->writerThread.clear();
+
+    if (!enabled)
+        return;
+
+    if (!isOpen()) {
+        qWarning() << "DQConnection::setReadWriteSplitEnabled() - The connection is not opened";
+        return;
+    }
+
+    // The writer clones the database before it is shared , so the writer itself writes directly
+    d->writerThread = QSharedPointer<_DQWriterThread>(new _DQWriterThread(this,batchSize));
+
+    d->readerPool = new DQConnectionPool(*this);
+    if (!DQConnectionPool::defaultPool() && m_defaultConnection == *this)
+        d->readerPool->setToDefaultPool();
+}
+
+bool DQConnection::isReadWriteSplitEnabled(){
+    return !d->writerThread.isNull();
+}
+
+DQConnectionPool* DQConnection::readerPool(){
+    return d->readerPool;
+}
+
+void DQConnection::setMaintenanceEnabled(bool enabled,DQMaintenanceOptions options){
+    delete d->maintenance;
+    d->maintenance = 0;
+
+    if (!enabled)
+        return;
+
+    if (!isOpen()) {
+        qWarning() << "DQConnection::setMaintenanceEnabled() - The connection is not opened";
+        return;
+    }
+
+    if (d->m_sql.database().driverName() != "QSQLITE") {
+        qWarning() << "DQConnection::setMaintenanceEnabled() - Only the QSQLITE driver is supported";
+        return;
+    }
+
+    d->maintenance = new _DQMaintenance(this,options,&d->checkpointer);
+}
+
+bool DQConnection::isMaintenanceEnabled(){
+    return d->maintenance != 0;
+}
+
+void DQConnection::runMaintenance(){
+    if (d->maintenance)
+        d->maintenance->runNow();
+}
+
+QList<DQQueryStats> DQConnection::maintenanceStats(){
+    if (!d->maintenance)
+        return QList<DQQueryStats>();
+    return d->maintenance->stats();
+}
+
+bool DQConnection::checkpoint(CheckpointMode mode){
+    QSqlDatabase db = d->m_sql.database();
+    if (!db.isOpen() || db.driverName() != "QSQLITE") {
+        qWarning() << "DQConnection::checkpoint() - The connection is not opened by the QSQLITE driver";
+        return false;
+    }
+
+    QString error;
+    if (!d->checkpointer.checkpoint(db,mode,0,0,&error)) {
+        qWarning() << QString("DQConnection::checkpoint() - Failed : %1").arg(error);
+        return false;
+    }
+    return true;
+}
+
+qint64 DQConnection::walSize(){
+    return _DQCheckpointer::walSize(d->m_sql.database());
+}
+
+DQQueryStats DQConnection::checkpointStats(){
+    return d->checkpointer.stats();
+}
+
+DQConnectionStats DQConnection::stats(bool exactRowCount){
+    DQConnectionStats res;
+
+    if (!isOpen()) {
+        qWarning() << "DQConnection::stats() - The connection is not opened";
+        return res;
+    }
+
+    res.statementCacheCapacity = d->m_sql.statementCacheCapacity();
+    res.statementCacheHits = d->m_sql.statementCacheHits();
+    res.statementCacheMisses = d->m_sql.statementCacheMisses();
+    res.resultCacheEnabled = d->m_sql.isResultCacheEnabled();
+    res.resultCacheHits = d->m_sql.resultCacheHits();
+
+    bool sqlite = d->m_sql.database().driverName() == "QSQLITE";
+    DQSqlStatement *statement = d->m_sql.statement();
+    QHash<QString,qint64> written = d->m_sql.writeCounts();
+    QSqlQuery q = query();
+
+    QStringList schemas;
+    schemas << "main" << attachedSchemas();
+
+    // Row estimates of ANALYZE. The first number of stat is the no. of rows of the table
+    QHash<QString,qint64> estimates;
+    if (sqlite && !exactRowCount) {
+        foreach (QString schema , schemas) {
+            if (!q.exec(QString("SELECT tbl,stat FROM %1.sqlite_stat1").arg(schema)))
+                continue; // Not analyzed
+            while (q.next()) {
+                QString key = schema + "." + q.value(0).toString();
+                qint64 rows = q.value(1).toString().section(' ',0,0).toLongLong();
+                estimates[key] = qMax(estimates.value(key,0),rows);
+            }
+        }
+    }
+
+    foreach (DQModelMetaInfo* metaInfo , d->m_models) {
+        DQTableStats table;
+        table.name = metaInfo->name();
+        table.table = table.name;
+        table.schema = statement->boundSchema(metaInfo);
+        if (table.schema.isEmpty())
+            table.schema = "main";
+        table.written = written.value(table.name,0);
+
+        QString key = table.schema + "." + table.name;
+        if (estimates.contains(key)) {
+            table.rows = estimates.value(key);
+            table.estimated = true;
+        } else if (q.exec(QString("SELECT count(*) FROM %1").arg(statement->qualifiedName(metaInfo))) && q.next()) {
+            table.rows = q.value(0).toLongLong();
+        }
+
+        res.tables << table;
+    }
+
+    if (!sqlite) {
+        setLastQuery(q);
+        return res;
+    }
+
+    res.pageSize = _dqPragma(q,"page_size");
+    res.pageCount = _dqPragma(q,"page_count");
+    res.freePages = _dqPragma(q,"freelist_count");
+    res.walSize = walSize();
+
+    // Page usage by dbstat. The query fails if the virtual table is not compiled in
+    QHash<QString,int> tableIndex;
+    for (int i = 0 ; i < res.tables.size();i++)
+        tableIndex[res.tables.at(i).schema + "." + res.tables.at(i).name] = i;
+
+    foreach (QString schema , schemas) {
+        QString sql = QString("SELECT s.name,m.type,m.tbl_name,count(*),sum(s.pgsize),sum(s.unused) "
+                              "FROM dbstat('%1') s JOIN %1.sqlite_master m ON m.name = s.name "
+                              "GROUP BY s.name").arg(schema);
+        if (!q.exec(sql))
+            break;
+
+        while (q.next()) {
+            QString name = q.value(0).toString();
+            QString owner = q.value(2).toString();
+            if (!tableIndex.contains(schema + "." + owner))
+                continue; // Not a table of registered model
+
+            DQTableStats item;
+            if (q.value(1).toString() == "index") {
+                item.name = name;
+                item.table = owner;
+                item.schema = schema;
+                item.isIndex = true;
+                item.pages = q.value(3).toLongLong();
+                item.bytes = q.value(4).toLongLong();
+                item.unusedBytes = q.value(5).toLongLong();
+                res.indexes << item;
+            } else if (name == owner) {
+                DQTableStats &table = res.tables[tableIndex.value(schema + "." + name)];
+                table.pages = q.value(3).toLongLong();
+                table.bytes = q.value(4).toLongLong();
+                table.unusedBytes = q.value(5).toLongLong();
+            }
+        }
+    }
+    setLastQuery(q);
+
+#ifdef DQ_SQLITE_API
+    sqlite3 *handle = _dqSqliteHandle(d->m_sql.database());
+    if (!handle)
+        return res;
+
+    // The counters are not reset , they are cumulative since the connection was opened
+    int current,highwater;
+#ifdef SQLITE_DBSTATUS_CACHE_HIT
+    if (sqlite3_db_status(handle,SQLITE_DBSTATUS_CACHE_HIT,&current,&highwater,0) == SQLITE_OK)
+        res.cacheHits = current;
+    if (sqlite3_db_status(handle,SQLITE_DBSTATUS_CACHE_MISS,&current,&highwater,0) == SQLITE_OK)
+        res.cacheMisses = current;
+#endif
+#ifdef SQLITE_DBSTATUS_CACHE_WRITE
+    if (sqlite3_db_status(handle,SQLITE_DBSTATUS_CACHE_WRITE,&current,&highwater,0) == SQLITE_OK)
+        res.cacheWrites = current;
+#endif
+    if (sqlite3_db_status(handle,SQLITE_DBSTATUS_CACHE_USED,&current,&highwater,0) == SQLITE_OK)
+        res.cacheUsed = current;
+#endif
+
+    return res;
+}
+
+bool DQConnection::setRetryPolicy(DQRetryPolicy policy){
+    d->options.retryPolicy = policy;
+    return applyRetryPolicy();
+}
+
+DQRetryPolicy DQConnection::retryPolicy(){
+    return d->options.retryPolicy;
+}
+
+QList<DQQueryStats> DQConnection::busyStats(){
+    if (!d->busyHandler)
+        return QList<DQQueryStats>();
+    return d->busyHandler->stats();
+}
+
+void DQConnection::resetBusyStats(){
+    if (d->busyHandler)
+        d->busyHandler->reset();
+}
+
+void DQConnection::setProfilingEnabled(bool enabled,int slowQueryThreshold){
+    delete d->profiler;
+    d->profiler = 0;
+
+    if (enabled)
+        d->profiler = new _DQProfiler(slowQueryThreshold);
+}
+
+bool DQConnection::isProfilingEnabled(){
+    return d->profiler != 0;
+}
+
+QList<DQQueryStats> DQConnection::queryStats(){
+    if (!d->profiler)
+        return QList<DQQueryStats>();
+    return d->profiler->stats();
+}
+
+void DQConnection::resetQueryStats(){
+    if (d->profiler)
+        d->profiler->reset();
+}
+
+void DQConnection::setIndexAdvisor(DQIndexAdvisor* advisor){
+    d->indexAdvisor = advisor;
+}
+
+DQChangeNotifier* DQConnection::watch(QStringList tables){
+    if (!d->changeHook) {
+        sqlite3 *handle = _dqSqliteHandle(d->m_sql.database());
+        if (!handle) {
+#ifdef DQ_SQLITE_API
+            qWarning() << "DQConnection::watch() - The connection is not opened by the QSQLITE driver";
+#else
+            qWarning() << "DQConnection::watch() - It requires DQuest built with dquest_sqlite_api";
+#endif
+            return 0;
+        }
+        d->changeHook = new _DQChangeHook(handle,d->m_sql);
+    }
+
+    return d->changeHook->watch(tables);
+}
+
+void DQConnection::unwatch(DQChangeNotifier* notifier){
+    if (!d->changeHook || !d->changeHook->unwatch(notifier))
+        return;
+
+    if (d->changeHook->size() == 0) {
+        delete d->changeHook;
+        d->changeHook = 0;
+    }
+}
+
+DQIndexAdvisor* DQConnection::indexAdvisor(){
+    return d->indexAdvisor;
 }
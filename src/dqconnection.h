@@ -9,12 +9,56 @@
 
 #include <dqmodelmetainfo.h>
 #include <dqindex.h>
+#include <dqconnectionoptions.h>
+#include <dqmaintenanceoptions.h>
+#include <dqquerystats.h>
+#include <dqconnectionstats.h>
 
 class DQModelMetaInfo;
 class DQSql;
 class DQConnectionPriv;
+class _DQAsyncWorker;
+class _DQWriteBehind;
+class _DQProfiler;
+class _DQMaintenance;
+class _DQWriterThread;
+class _DQPersister;
+class DQConnectionPool;
+class DQIndexAdvisor;
+class DQChangeNotifier;
 template <typename T> inline DQModelMetaInfo* dqMetaInfo();
 
+/// The progress callback of DQConnection::backupTo()
+/**
+  @param remaining No. of pages to be copied
+  @param total Total no. of pages of the database
+  @param userData The pointer passed to backupTo()
+  @return FALSE to abort the backup
+ */
+typedef bool (*DQBackupProgressFunc)(int remaining,int total,void *userData);
+
+/// A SQL scalar function registered by DQConnection::registerFunction()
+/**
+  @param args The arguments. INTEGER is passed as qlonglong , REAL as double , TEXT as QString and BLOB as QByteArray.
+  @param userData The pointer passed to registerFunction()
+  @return The result of the call. A null QVariant returns NULL.
+ */
+typedef QVariant (*DQSqlFunction)(const QVariantList &args,void *userData);
+
+/// The step function of a SQL aggregate registered by DQConnection::registerAggregate()
+/**
+  @param state The state of the group. It is a null QVariant on the first row.
+  @param args The arguments of the row
+ */
+typedef void (*DQSqlAggregateStep)(QVariant &state,const QVariantList &args,void *userData);
+
+/// The final function of a SQL aggregate registered by DQConnection::registerAggregate()
+/**
+  @param state The state left by the step function. It is a null QVariant if no row is aggregated.
+  @return The result of the group
+ */
+typedef QVariant (*DQSqlAggregateFinal)(const QVariant &state,void *userData);
+
 /// Connection to QSqlDatabase
 /**
   DQuest is an ORM library , but it do not interact with database backend(e.g SQLite) directly. Instead
@@ -26,7 +70,9 @@ template <typename T> inline DQModelMetaInfo* dqMetaInfo();
   store all the supported model , and return a DQSql object to this database for more advanced
   database operation.
 
-  @todo Thread-safe implemention.
+  A connection should only be used by the thread that opens it. Use DQConnectionPool
+  for multi-threaded application.
+
   @remarks It is an explicitly shared class
 
 
@@ -92,7 +138,287 @@ public:
     bool operator!=(const DQConnection &rhs);
 
     /// Open the connection to database
-    bool open(QSqlDatabase db);
+    /**
+      @param db The opened database
+      @param options The PRAGMA settings to be applied. They are also applied on every clone().
+      @return TRUE if it is successful. FALSE if the driver is not supported or any of the options is failed to apply.
+      The connection is closed on failure , but the settings applied before the failed one are kept by the database.
+      @see DQConnectionOptions
+     */
+    bool open(QSqlDatabase db,DQConnectionOptions options = DQConnectionOptions());
+
+    /// Open an in-memory SQLite database which is persisted to a file
+    /**
+      The database lives in memory , so the reads never touch the disk. It is
+      shared by the clones of the connection (DQConnectionPool , the async
+      worker ...) by the "memdb" VFS. The QSqlDatabase is created and removed
+      by the connection.
+
+      On open , the content of persistPath is loaded by the backup API. A
+      background thread checks the database on every interval and writes it
+      to persistPath if anything is committed. The database is copied in
+      memory and written to the file by the thread , so save() is not blocked
+      by the disk. The last changes are written on close().
+
+\code
+    DQConnection cache;
+    cache.openInMemory("cache.db",1000);
+    cache.addModel<Session>();
+    cache.createTables();
+\endcode
+
+      @param persistPath The file to persist. If it is empty , the database is not persisted.
+      @param interval The interval of persistence in msec. Zero only writes the file on persist() / close().
+      @param options The PRAGMA settings. The journal mode of an in-memory database can't be WAL.
+      @return FALSE if the SQLite library do not support the memdb VFS ( < 3.36 ) or the file is failed to load
+      @remarks The changes after the last persistence are lost if the process crashes.
+      A persisted database requires DQuest built with CONFIG += dquest_sqlite_api.
+     */
+    bool openInMemory(QString persistPath,int interval = 1000,DQConnectionOptions options = DQConnectionOptions());
+
+    /// Write the in-memory database opened by openInMemory() to its file now
+    /**
+      It blocks until the file is written. Nothing is written if the database is not changed since the last persistence.
+      @return FALSE if the connection is not opened by openInMemory() with a file , or it is failed to write.
+     */
+    bool persist();
+
+    /// The options applied by open()
+    DQConnectionOptions options();
+
+    /// Create a new connection to a clone of the connected database
+    /**
+      The database is cloned by QSqlDatabase::cloneDatabase() and opened.
+      The returned connection has the same registered models and options , but it will
+      never become the default connection.
+
+      As QSqlDatabase could only be used in the thread that create it , it
+      should be called within the thread which use the new connection.
+
+      @param connectionName The connection name of the cloned QSqlDatabase
+      @see DQConnectionPool
+     */
+    DQConnection clone(QString connectionName);
+
+    /// Open a read-only connection pinned to the current state of database
+    /**
+      The returned connection is a clone() with "PRAGMA query_only" set and a
+      read transaction started. All the queries run on it see the same state of
+      database until it is closed , no matter what is committed by other connections.
+
+      In WAL journal mode, the snapshot does not block the writers , and the
+      writers do not change the result of the snapshot. In other journal modes, the
+      read transaction holds a shared lock , writers can't commit until it is closed.
+
+      As a QSqlDatabase could only be used by the thread that create it, call
+      snapshot() on the returned connection within each worker thread to get a
+      clone reading the same snapshot:
+
+\code
+    DQConnection report = connection.snapshot("report");
+
+    // In a worker thread
+    DQConnection worker = report.snapshot(QString("report-%1").arg(index));
+    int count = DQQuery<User>(worker).count();
+    worker.close();
+\endcode
+
+      Sharing a snapshot between connections requires the SQLite library built with
+      SQLITE_ENABLE_SNAPSHOT and DQuest built with the same define. Otherwise calling
+      snapshot() on a snapshot connection fails.
+
+      @param connectionName The connection name of the cloned QSqlDatabase
+      @return The snapshot connection. It is not opened if it is failed.
+      @remarks The snapshot is kept until close() is called. Don't call commit() / rollback() on it.
+     */
+    DQConnection snapshot(QString connectionName);
+
+    /// TRUE if it is a connection returned by snapshot()
+    bool isSnapshot();
+
+    /// Export the tables of models to a new SQLite database file
+    /**
+      The records and the indexes of the tables are copied to the file by an
+      attached database , in a single transaction. The file is compact as it is
+      written once. It could be shipped and attached by importSnapshot().
+
+      @param models The models to be exported
+      @param path The file. The existing one is replaced.
+      @return TRUE if it is successful
+      @remarks It must not be called within a transaction. Only the QSQLITE driver is supported.
+     */
+    bool exportSnapshot(QList<DQModelMetaInfo*> models,QString path);
+
+    /// Export the whole database to a new file by "VACUUM INTO"
+    /**
+      @remarks It requires SQLite 3.27 or later
+     */
+    bool exportSnapshot(QString path);
+
+    /// Copy the database to a file by the SQLite online backup API
+    /**
+      The pages are copied in steps. The source database is only locked
+      within a step , the writers could proceed between the steps. If the
+      database is changed by other connection during the backup , the copy is
+      restarted automatically. The changes made by this connection are
+      copied in place. The result is a consistent copy of the database.
+
+      @param path The destination file. It is overwritten.
+      @param pagesPerStep No. of pages copied per step. Zero or negative value copies all the pages in a single step.
+      @param sleepMs The time to sleep between the steps in milliseconds. It leaves time for the other queries.
+      @param progress The callback after each step. It may be NULL.
+      @param userData The pointer passed to the callback
+      @return TRUE if it is successful. The destination file is removed on failure or abort.
+      @remarks It must be called in the thread of the connection. Call it on a clone() within a
+      worker thread to run a backup in background. Only the QSQLITE driver is supported.
+      Without CONFIG += dquest_sqlite_api it falls back to exportSnapshot(path) in a single step , the progress
+      callback is only called once when it is done.
+     */
+    bool backupTo(QString path,int pagesPerStep = 100,int sleepMs = 10,
+                  DQBackupProgressFunc progress = 0,void *userData = 0);
+
+    /// Attach an exported database file to the connection
+    /**
+      The tables of the file are read by DQQuery directly if the main database
+      do not have a table with the same name. For example:
+
+\code
+    DQConnection connection;
+    connection.open(db);
+    connection.importSnapshot("reference.db");
+
+    DQQuery<Country> query(connection); // Read from reference.db
+\endcode
+
+      If the database is opened with the "QSQLITE_OPEN_URI" connect option , the file is
+      attached read-only (mode=ro).
+
+      @param path The file exported by exportSnapshot()
+      @param schema The schema name of the attached database
+      @param mmapSize The max size of memory-mapped I/O of the file in bytes. Zero disables it.
+      @remarks Don't call createTables() for the models in the file , otherwise the empty tables in main database hide them.
+     */
+    bool importSnapshot(QString path,QString schema = "snapshot",qint64 mmapSize = 0);
+
+    /// Detach a database attached by importSnapshot()
+    bool detachSnapshot(QString schema = "snapshot");
+
+    /// Attach a SQLite database file under a schema name
+    /**
+      The tables of the file could be referred as "alias.table" in the SQL
+      statements of this connection. Bind a model to the alias by bindSchema(),
+      then DQQuery , DQModel::save() and createTables() of the model work on
+      the attached file. The tables of different files could be joined by a
+      single statement within SQLite. For example:
+
+\code
+    DQConnection connection;
+    connection.open(db); // hot.db
+    connection.attach("archive.db","archive");
+
+    connection.addModel<Order>();
+    connection.addModel<ArchivedOrder>();
+    connection.bindSchema<ArchivedOrder>("archive");
+    connection.createTables(); // archive.archived_order is created in archive.db
+
+    DQQuery<ArchivedOrder> query(connection); // SELECT ... FROM archive.archived_order
+\endcode
+
+      The file is created if it is not existed. The attachments and schema bindings
+      are copied to the clones made by clone() (e.g the connection of DQConnectionPool
+      and the async worker) , attach the files before the connection is cloned.
+
+      @param path The path of database file
+      @param alias The schema name. It must not be "main" or "temp".
+      @return FALSE if the driver is not QSQLITE or the ATTACH statement failed (e.g within a transaction)
+     */
+    bool attach(QString path,QString alias);
+
+    /// Detach a database attached by attach()
+    /**
+      The models bound to the alias are bound to the main database again.
+     */
+    bool detach(QString alias);
+
+    /// The schema names of the databases attached by attach()
+    QStringList attachedSchemas();
+
+    /// Bind the table of a model to the schema of an attached database
+    template <typename T>
+    void bindSchema(QString alias) {
+        bindSchema(dqMetaInfo<T>(),alias);
+    }
+
+    /// Bind the table of a model to the schema of an attached database
+    /**
+      The table name in the statements generated for the model is qualified by the
+      schema (e.g "archive.user"). The binding only affects this connection and its clones.
+
+      @param alias The schema name. An empty string binds the model to the main database.
+      @remarks A model with DQFullText fields could not be bound , as the full text index is kept in the main database.
+      @see DQSqlStatement::qualifiedName()
+     */
+    void bindSchema(DQModelMetaInfo* metaInfo,QString alias);
+
+    /// Register a SQL function implemented in C++
+    /**
+      The function is installed by sqlite3_create_function_v2() , so it is run
+      by the SQLite VM next to the data and could be used in any statement of
+      the connection , e.g in a filter or the ordering terms:
+
+\code
+static QVariant bmi(const QVariantList &args,void *) {
+    double height = args.at(0).toDouble() / 100;
+    return args.at(1).toDouble() / (height * height);
+}
+
+    connection.registerFunction("bmi",2,bmi);
+
+    DQQuery<HealthCheck> query = DQQuery<HealthCheck>(connection)
+                                 .filter(DQWhere("bmi(height,weight)") > 25)
+                                 .orderBy("bmi(height,weight) desc");
+\endcode
+
+      The function is installed again on every clone() , therefore it is
+      available to DQConnectionPool , the async worker and the other background
+      threads of the connection. The clones created before the registration
+      (e.g a started async worker) are not updated , so register the functions
+      right after open().
+
+      @param name The name of the function
+      @param nArgs No. of arguments. -1 for any no. of arguments.
+      @param function The function. It is called by the thread running the statement , so it should be thread-safe.
+      @param userData The pointer passed to the function
+      @param deterministic TRUE if the result only depends on the arguments. SQLite could then use it in an index and factor it out of a loop.
+      @return FALSE if the driver is not QSQLITE or the function is failed to install
+      @remarks It requires DQuest built with CONFIG += dquest_sqlite_api
+     */
+    bool registerFunction(QString name,int nArgs,DQSqlFunction function,void *userData = 0,bool deterministic = true);
+
+    /// Register a SQL aggregate function implemented in C++
+    /**
+      The aggregate could be called by DQSharedQuery::call() , aggregate() or in
+      the HAVING clause. For example , a product of the values:
+
+\code
+static void productStep(QVariant &state,const QVariantList &args,void *) {
+    state = (state.isNull() ? 1.0 : state.toDouble()) * args.at(0).toDouble();
+}
+
+static QVariant productFinal(const QVariant &state,void *) {
+    return state;
+}
+
+    connection.registerAggregate("product",1,productStep,productFinal);
+    QVariant res = DQQuery<HealthCheck>(connection).call("product","weight");
+\endcode
+
+      @see registerFunction()
+     */
+    bool registerAggregate(QString name,int nArgs,DQSqlAggregateStep step,DQSqlAggregateFinal final,void *userData = 0);
+
+    /// Remove a function registered by registerFunction() or registerAggregate()
+    bool unregisterFunction(QString name,int nArgs);
 
     /// Close the connection to database
     void close();
@@ -115,6 +441,9 @@ public:
 
     /// Get the default connection object
     /**
+        If a DQConnectionPool is installed as the default pool , it will return
+        the connection of calling thread from the pool.
+
         Default connection is the first opened connection. Any DQConnection instance
         can become the default connection as long as it is the first one to call open().
 
@@ -142,9 +471,94 @@ public:
     /**
       It will run "create table" for all added model if they are not existed. It will also call
       model's initialData() to retrieve the initial data and insert to database.
+
+      The indexes declared by DQ_INDEX are then created if they are not existed. So do
+      the full text index and triggers of the fields declared with DQFullText.
+
+      If the schema fingerprint is enabled and it matches the one stored by the last
+      successful call , it returns immediately without any DDL.
+
+      @see setSchemaFingerprintEnabled()
      */
     bool createTables();
 
+    /// Enable / disable the schema fingerprint of createTables()
+    /**
+      The fingerprint is a hash of the table name , fields , clauses and indexes of
+      all the added models. It is written to "PRAGMA user_version" of the main
+      database after createTables() succeeded. On next start , createTables()
+      only reads the pragma and skips the exists() checks , the DDL and the initial
+      data if the models are not changed. It saves the startup time of short-lived
+      processes:
+
+\code
+    connection.open(db);
+    connection.setSchemaFingerprintEnabled(true);
+    connection.addModel<HealthCheck>();
+    connection.createTables(); // No DDL if the schema is already created
+\endcode
+
+      It is disabled by default. The setting is copied by clone().
+
+      @remarks It takes over "PRAGMA user_version" , do not enable it if the application stores
+      its own version there. The tables dropped outside dropTables() are not noticed , call
+      clearSchemaFingerprint() after that. The fast path is not used if a model is bound to an
+      attached database by bindSchema(). Only the QSQLITE driver is supported.
+     */
+    void setSchemaFingerprintEnabled(bool enabled);
+
+    /// TRUE if the schema fingerprint is enabled
+    bool isSchemaFingerprintEnabled();
+
+    /// The fingerprint of the added models
+    /**
+      @return A positive 31 bits hash. It is changed whenever a model is added or its declaration is changed.
+     */
+    int schemaFingerprint();
+
+    /// Clear the fingerprint stored in database , so the next createTables() runs the DDL
+    bool clearSchemaFingerprint();
+
+    /// Update the tables of all added model to their declaration
+    /**
+      It compares the fields of each model with the columns of its existing table
+      and adds the missing columns by "ALTER TABLE ... ADD COLUMN". The existing
+      records are not copied. Then it calls createTables() to create the missing
+      tables and declared indexes.
+
+      A field that could not be added to existing table (e.g UNIQUE , or NOT NULL
+      without default value) is reported and skipped , it returns FALSE in that
+      case. Call rebuildTable() explicitly for it.
+
+      The columns that are no longer declared are kept.
+     */
+    bool migrate();
+
+    /// Rebuild the table of a model by a batched copy to a new table
+    /**
+      @see DQSql::rebuildTable()
+     */
+    template <typename T>
+    bool rebuildTable(int batchSize = 10000) {
+        return rebuildTable(dqMetaInfo<T>(),batchSize);
+    }
+
+    /// Rebuild the table of a model by a batched copy to a new table
+    bool rebuildTable(DQModelMetaInfo* metaInfo,int batchSize = 10000);
+
+    /// Remove the records of a model by id
+    /**
+      @see DQSql::removeIds()
+      @return No. of records removed. -1 if the operation is failed.
+     */
+    template <typename T>
+    int removeIds(QVariantList ids) {
+        return removeIds(dqMetaInfo<T>(),ids);
+    }
+
+    /// Remove the records of a model by id
+    int removeIds(DQModelMetaInfo* metaInfo,QVariantList ids);
+
     /// Drop all the tables
     bool dropTables();
 
@@ -153,6 +567,25 @@ public:
 
     bool dropIndex(QString name);
 
+    /// Begin a transaction
+    /**
+      Transactions could be nested. The outermost call begins a real
+      database transaction, the inner calls are implemented by SAVEPOINT.
+      Each call should be paired with commit() or rollback().
+
+      Multiple write operations within a transaction only pay a single
+      journal sync.
+
+      @see DQTransaction
+     */
+    bool transaction();
+
+    /// Commit the innermost transaction
+    bool commit();
+
+    /// Rollback the innermost transaction
+    bool rollback();
+
     /// Get the SQL interface that you may run predefined sql operations on the database
     DQSql& sql();
 
@@ -161,6 +594,10 @@ public:
 
     /// The last query with error used by DQConnection
     /**
+      The last query is stored per thread. It returns the last query
+      run by the calling thread. The queries of all the threads are
+      released by close().
+
       @threadsafe
       @remarks It is thread-safe function
      */
@@ -174,6 +611,274 @@ public:
      */
     void setLastQuery(QSqlQuery query);
 
+    /// Enable / disable the recording of last query
+    /**
+      It is enabled by default. If it is disabled, lastQuery() will return an empty query.
+      The setting is also applied to sql().
+     */
+    void setLastQueryEnabled(bool enabled);
+
+    /// TRUE if the last query is recorded
+    bool isLastQueryEnabled();
+
+    /// Enable / disable the identity map of sql()
+    /**
+      The models loaded by id (e.g. DQForeignKey loading) are served from
+      a bounded per-connection map until the table is changed.
+
+      @see DQSql::setIdentityMapEnabled()
+     */
+    void setIdentityMapEnabled(bool enabled ,int capacity = -1);
+
+    /// TRUE if the identity map is enabled
+    bool isIdentityMapEnabled();
+
+    /// Enable / disable the write-behind mode
+    /**
+      In write-behind mode , DQModel::save() only queues a copy of the model
+      and returns immediately. A background writer drains the queue to a clone
+      of the database by DQSharedList::saveAll() , so the rows are written in
+      batched transactions instead of one journal sync per save().
+
+      The queue is written when it reaches batchSize rows , window milliseconds
+      after the last write or flush() is called , whichever comes first.
+      If capacity rows are pending , save() is blocked until the writer catches up.
+
+      Disabling the mode (or close()) waits for all the pending rows to be written.
+
+      @param batchSize No. of rows written per transaction
+      @param window The max. delay in milliseconds before a pending row is written. Zero or negative value will only write on batchSize or flush()
+      @param capacity The max. no. of pending rows
+
+      @remarks The id of a newly inserted model is not updated. The written rows are visible
+      to the other connections after the transaction is committed , call waitForFlush() before
+      reading them back. save() may be called by any thread , but the mode should not be
+      changed while any other thread is saving.
+
+      @see waitForFlush()
+     */
+    void setWriteBehindEnabled(bool enabled , int batchSize = 500 , int window = 50 , int capacity = 10000);
+
+    /// TRUE if the write-behind mode is enabled
+    bool isWriteBehindEnabled();
+
+    /// Ask the writer to write the pending rows without waiting for the batch size or time window
+    void flush();
+
+    /// Block until all the rows saved before the call are written
+    /**
+      The result cache and identity map of sql() are notified for the written tables.
+
+      @return TRUE if no write is failed since the last call. It is also TRUE if the write-behind mode is disabled.
+     */
+    bool waitForFlush();
+
+    /// No. of rows saved in write-behind mode but not written yet
+    int pendingWrites();
+
+    /// Enable / disable the read / write split
+    /**
+      SQLite allows a single writer. When many threads write through their
+      own connections , they wait for the file lock of each other. In the
+      read / write split mode , the connection owns:
+
+      <ul>
+      <li> A writer thread with its own clone of the database. DQModel::save() , DQModel::remove() ,
+      DQSharedList::saveAll() / removeAll() and DQSharedQuery::remove() / update() of this connection and
+      its clones are queued to the writer. The caller is blocked until the operation is committed ,
+      so the result and the generated id are the same as before. </li>
+      <li> A DQConnectionPool of reader connections , readerPool(). It is installed as the default pool
+      if this is the default connection and no pool is installed , so DQQuery in any thread reads by the
+      connection of its thread. </li>
+      </ul>
+
+      The operations queued while the writer is busy are committed in a single transaction
+      (group commit) , at most batchSize per transaction. Each operation is wrapped by a
+      SAVEPOINT , a failed operation does not affect the others.
+
+      The writes within a transaction of the calling connection (DQTransaction) are not queued ,
+      they are run by the calling connection to keep the transaction atomic.
+      In write-behind mode , DQModel::save() is queued to the write-behind writer first.
+
+      @remarks The journal mode should be WAL for the readers to run while writing.
+      The clones created while the mode is enabled keep using the writer until they are closed.
+      close() stops the writer and closes the readers.
+     */
+    void setReadWriteSplitEnabled(bool enabled , int batchSize = 1000);
+
+    /// TRUE if the writes of the connection are queued to a writer thread
+    bool isReadWriteSplitEnabled();
+
+    /// The pool of the reader connections of read / write split. NULL if the mode is disabled
+    DQConnectionPool* readerPool();
+
+    /// Enable / disable the background maintenance
+    /**
+      The analyzer statistics of a table get stale as it grows , and so do the
+      query plans. When the maintenance is enabled , a thread of idle priority
+      counts the rows written through sql() per table. Once a threshold of
+      DQMaintenanceOptions is passed , it runs ANALYZE / "PRAGMA optimize" ,
+      incremental vacuum or passive WAL checkpoint on a clone of the database.
+
+      The tasks are postponed while the connection keeps writing. The time of
+      each statement run by the tasks is reported by maintenanceStats().
+
+      @remarks Only the QSQLITE driver is supported. The rows written by other
+      connections or raw SQL are not counted. ANALYZE takes the write lock of
+      the database , set DQConnectionOptions::busyTimeout to let the writers wait for it.
+      @see runMaintenance()
+     */
+    void setMaintenanceEnabled(bool enabled , DQMaintenanceOptions options = DQMaintenanceOptions());
+
+    /// TRUE if the background maintenance is enabled
+    bool isMaintenanceEnabled();
+
+    /// Run the maintenance tasks their threshold is passed now , and block until they are finished
+    void runMaintenance();
+
+    /// The timing of the statements run by the maintenance tasks , sorted by the total time in descending order
+    QList<DQQueryStats> maintenanceStats();
+
+    /// The mode of checkpoint(). The values are the same as SQLITE_CHECKPOINT_*
+    enum CheckpointMode {
+        /// Write back as many frames as possible without waiting for the readers and writers
+        PassiveCheckpoint = 0,
+        /// Wait for the writers , then write back all the frames
+        FullCheckpoint = 1,
+        /// FullCheckpoint , then wait for the readers so the next writer restarts the WAL from the beginning
+        RestartCheckpoint = 2,
+        /// RestartCheckpoint , then truncate the WAL file to zero bytes
+        TruncateCheckpoint = 3
+    };
+
+    /// Checkpoint the WAL of the database
+    /**
+      The time of the call is added to checkpointStats().
+
+      @return FALSE if the database is not in WAL mode of QSQLITE driver , or the checkpoint of
+      a blocking mode could not be completed (SQLITE_BUSY)
+      @see DQMaintenanceOptions::checkpointSize
+     */
+    bool checkpoint(CheckpointMode mode = PassiveCheckpoint);
+
+    /// The size of the WAL file in bytes
+    /**
+      @return 0 if there is no WAL file. -1 for in-memory database or non-QSQLITE driver
+     */
+    qint64 walSize();
+
+    /// The timing of checkpoints run by checkpoint() and the maintenance thread
+    /**
+      The rows of the stats are the no. of frames written back to the database.
+     */
+    DQQueryStats checkpointStats();
+
+    /// The row counts , sizes and cache statistics of the connection
+    /**
+      The row count of a table is read from sqlite_stat1 (the result of last
+      ANALYZE , e.g by the background maintenance) if it is available , it is
+      cheap but may be stale. Otherwise the rows are counted by "SELECT count(*)".
+
+      The page usage of the tables and indexes are read from the dbstat
+      virtual table , which requires SQLite built with SQLITE_ENABLE_DBSTAT_VTAB.
+      Reading dbstat walks all the pages of the tables , it should not be called
+      frequently on a large database.
+
+      @param exactRowCount TRUE if all the tables should be counted by "SELECT count(*)"
+      @see DQStatsReporter
+     */
+    DQConnectionStats stats(bool exactRowCount = false);
+
+    /// Set the retry policy of the statements blocked by other connections
+    /**
+      The policy is kept in options() , so it is also applied to the clones
+      (e.g the connections of DQConnectionPool). A null policy restores the
+      PRAGMA busy_timeout of options().
+
+      The blocked statements are reported by busyStats(). Changing the policy resets the stats.
+
+      @return FALSE if the connection is not opened by the QSQLITE driver
+      @see DQRetryPolicy
+     */
+    bool setRetryPolicy(DQRetryPolicy policy);
+
+    /// The retry policy of the connection
+    DQRetryPolicy retryPolicy();
+
+    /// The statements blocked by other connections , sorted by the busy time in descending order
+    /**
+      Each busy wait is counted as a call. DQQueryStats::retries and DQQueryStats::busyTime
+      are the no. of retries and the time slept , a wait ended by the timeout of the policy is a failure.
+      maxTime is the longest single wait.
+
+      @return The stats. It is empty if no retry policy is set.
+     */
+    QList<DQQueryStats> busyStats();
+
+    /// Remove the stats of busyStats()
+    void resetBusyStats();
+
+    /// Enable / disable the profiling of queries
+    /**
+      When it is enabled , the statements run by DQSharedQuery (and so DQQuery) are timed.
+      The prepare time , execution time , no. of rows and the time of writing
+      the rows to models are aggregated per normalized statement.
+      When it is disabled , the cost is a pointer check per query.
+
+      The stats are collected per connection. The clones (e.g the connections of
+      DQConnectionPool) are not profiled.
+
+      @param slowQueryThreshold The statement took no less than the time in milliseconds is logged by qWarning(). Negative value disable the log.
+      @see queryStats()
+     */
+    void setProfilingEnabled(bool enabled , int slowQueryThreshold = -1);
+
+    /// TRUE if the profiling is enabled
+    bool isProfilingEnabled();
+
+    /// The collected stats sorted by the total time in descending order
+    QList<DQQueryStats> queryStats();
+
+    /// Remove the collected stats
+    void resetQueryStats();
+
+    /// Install an index advisor to analyze the queries run by DQSharedQuery
+    /**
+      Every distinct SELECT statement is explained once by the advisor before it is executed.
+
+      @param advisor The advisor. The ownership is not taken. Pass NULL to uninstall.
+      @see DQIndexAdvisor
+     */
+    void setIndexAdvisor(DQIndexAdvisor* advisor);
+
+    /// The installed index advisor
+    DQIndexAdvisor* indexAdvisor();
+
+    /// Watch the changes of the table of a model
+    /**
+      @see watch(QStringList)
+     */
+    template <typename T>
+    DQChangeNotifier* watch() {
+        return watch(QStringList(dqMetaInfo<T>()->name()));
+    }
+
+    /// Watch the changes of tables made through the connection
+    /**
+      It installs the SQLite update and commit hooks on first call. The rows changed
+      by each committed transaction are emitted by DQChangeNotifier::changed().
+      While a notifier is installed , the result cache and identity map of sql() are
+      also notified by the hook , including the changes made by raw SQL statements.
+
+      @param tables The table names. Empty list watches all the tables.
+      @return The notifier. It is owned by the connection and deleted by unwatch() or close(). NULL if the driver is not QSQLITE.
+      @remarks Call it in the thread of the connection. It requires DQuest built with CONFIG += dquest_sqlite_api
+     */
+    DQChangeNotifier* watch(QStringList tables = QStringList());
+
+    /// Remove a notifier created by watch(). The hooks are removed with the last notifier.
+    void unwatch(DQChangeNotifier* notifier);
+
 signals:
 
 public slots:
@@ -181,8 +886,47 @@ public slots:
 protected:
 
 private:
+    /// The worker thread for asynchronous query. It is started on first call.
+    /**
+      @return The worker or NULL if the connection is not opened
+     */
+    _DQAsyncWorker* asyncWorker();
+
+    /// The writer of write-behind mode
+    /**
+      @return The writer or NULL if the mode is disabled
+     */
+    _DQWriteBehind* writeBehind();
+
+    /// The profiler of the connection
+    /**
+      @return The profiler or NULL if the profiling is disabled
+     */
+    _DQProfiler* profiler();
+
+    /// The writer of read / write split
+    /**
+      @return The writer or NULL if the mode is disabled
+     */
+    _DQWriterThread* writerThread();
+
+    /// Create the indexes declared by DQ_INDEX of all added model
+    bool createDeclaredIndexes();
+
+    /// Create the full text indexes of the DQFullText fields of all added model
+    bool createFullTextIndexes();
+
+    /// Run the PRAGMA statements of the options
+    bool applyOptions(DQConnectionOptions options);
+
+    /// Install the busy handler of options().retryPolicy , or restore the busy timeout if it is null
+    bool applyRetryPolicy();
 
     QExplicitlySharedDataPointer<DQConnectionPriv> d;
+
+    friend class DQSharedQuery;
+    friend class DQModel;
+    friend class DQSharedList;
 };
 
 #endif // DQCONNECTION_H
@@ -0,0 +1,101 @@
+#include <QtCore>
+#include "dqconnectionoptions.h"
+
+/* Test cases:
+
+  coretests::connectionOptions()
+  sqlitetests::connectionOptions()
+
+ */
+
+/// The settings of a named profile
+struct _DQConnectionProfile {
+    const char* name;
+    const char* journalMode;
+    const char* synchronous;
+    int cacheSize;            // 0 = unchanged
+    qint64 mmapSize;          // -1 = unchanged
+    const char* tempStore;
+    int busyTimeout;          // -1 = unchanged
+    int queryOnly;            // -1 = unchanged
+};
+
+static const _DQConnectionProfile _dqConnectionProfiles[] = {
+    { "durable" , "WAL" , "FULL" , 0 , -1 , 0 , 5000 , -1 },
+    { "balanced" , "WAL" , "NORMAL" , -16000 , -1 , "MEMORY" , 5000 , -1 },
+    { "bulk-load" , "MEMORY" , "OFF" , -64000 , -1 , "MEMORY" , 5000 , -1 },
+    { "read-only-mmap" , 0 , 0 , -32000 , 268435456 , "MEMORY" , 5000 , 1 },
+    { 0 , 0 , 0 , 0 , -1 , 0 , -1 , -1 }
+};
+
+DQConnectionOptions::DQConnectionOptions(){
+}
+
+DQConnectionOptions DQConnectionOptions::profile(QString name){
+    DQConnectionOptions res;
+
+    for (const _DQConnectionProfile *p = _dqConnectionProfiles ; p->name ; p++) {
+        if (name != p->name)
+            continue;
+
+        res.name = name;
+        res.journalMode = p->journalMode;
+        res.synchronous = p->synchronous;
+        if (p->cacheSize != 0)
+            res.cacheSize = p->cacheSize;
+        if (p->mmapSize >= 0)
+            res.mmapSize = p->mmapSize;
+        res.tempStore = p->tempStore;
+        if (p->busyTimeout >= 0)
+            res.busyTimeout = p->busyTimeout;
+        if (p->queryOnly >= 0)
+            res.queryOnly = p->queryOnly != 0;
+        return res;
+    }
+
+    qWarning() << QString("DQConnectionOptions::profile() - Unknown profile : %1").arg(name);
+    return res;
+}
+
+QStringList DQConnectionOptions::profileNames(){
+    QStringList res;
+    for (const _DQConnectionProfile *p = _dqConnectionProfiles ; p->name ; p++) {
+        res << p->name;
+    }
+    return res;
+}
+
+bool DQConnectionOptions::isNull() const{
+    return pragmas().isEmpty() && retryPolicy.isNull();
+}
+
+QStringList DQConnectionOptions::pragmas() const{
+    QStringList res;
+
+    // busy_timeout goes first , the journal mode change may need to wait for other connections
+    if (!busyTimeout.isNull())
+        res << QString("PRAGMA busy_timeout = %1").arg(busyTimeout.toInt());
+
+    if (!journalMode.isEmpty())
+        res << QString("PRAGMA journal_mode = %1").arg(journalMode);
+
+    if (!synchronous.isEmpty())
+        res << QString("PRAGMA synchronous = %1").arg(synchronous);
+
+    if (!cacheSize.isNull())
+        res << QString("PRAGMA cache_size = %1").arg(cacheSize.toLongLong());
+
+    if (!mmapSize.isNull())
+        res << QString("PRAGMA mmap_size = %1").arg(mmapSize.toLongLong());
+
+    if (!tempStore.isEmpty())
+        res << QString("PRAGMA temp_store = %1").arg(tempStore);
+
+    if (!queryOnly.isNull())
+        res << QString("PRAGMA query_only = %1").arg(queryOnly.toBool() ? 1 : 0);
+
+    if (!walAutoCheckpoint.isNull())
+        res << QString("PRAGMA wal_autocheckpoint = %1").arg(walAutoCheckpoint.toInt());
+
+    return res;
+}
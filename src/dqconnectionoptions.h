@@ -0,0 +1,96 @@
+#ifndef DQCONNECTIONOPTIONS_H
+#define DQCONNECTIONOPTIONS_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <dqretrypolicy.h>
+
+/// The SQLite settings applied by DQConnection::open()
+/**
+  DQConnectionOptions holds the PRAGMA settings of a connection. They are
+  run by DQConnection::open() and again on every DQConnection::clone() , so
+  the connections of DQConnectionPool and the worker threads have the same
+  settings as the base connection.
+
+  A null / empty member is not changed, the default value of SQLite is used.
+
+  Instead of setting the members one by one , a named profile could be used:
+
+  - "durable" : WAL journal with synchronous = FULL. No committed transaction is lost on power failure.
+  - "balanced" : WAL journal with synchronous = NORMAL , 16MB page cache and temporary tables in memory.
+    The committed transaction is durable on application crash , a power failure may roll back the latest few.
+  - "bulk-load" : In-memory journal with synchronous = OFF and 64MB page cache for loading large amount of data.
+    The database may be corrupted if the machine is crashed during writing.
+  - "read-only-mmap" : The connection could not write (query_only). The database is read through 256MB memory map.
+
+  Example:
+
+\code
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
+    db.setDatabaseName( "your.db" );
+    db.open();
+
+    DQConnection connection;
+    connection.open(db,DQConnectionOptions::profile("balanced"));
+\endcode
+
+  @see DQConnection::open()
+ */
+class DQConnectionOptions
+{
+public:
+    /// Construct an option which change nothing
+    DQConnectionOptions();
+
+    /// Get the options of a named profile
+    /**
+      @param name "durable" , "balanced" , "bulk-load" or "read-only-mmap"
+      @return The options. If the name is unknown, it return an option which change nothing.
+     */
+    static DQConnectionOptions profile(QString name);
+
+    /// The names of available profile
+    static QStringList profileNames();
+
+    /// TRUE if no any setting is changed
+    bool isNull() const;
+
+    /// The PRAGMA statements to apply the options. The retry policy is applied separately.
+    QStringList pragmas() const;
+
+    /// The profile name. It is empty if the options are not created by profile()
+    QString name;
+
+    /// PRAGMA journal_mode (e.g. "WAL" , "DELETE" , "MEMORY")
+    QString journalMode;
+
+    /// PRAGMA synchronous ("OFF" , "NORMAL" , "FULL" or "EXTRA")
+    QString synchronous;
+
+    /// PRAGMA cache_size. A positive value is the no. of page , a negative value is the size in KiB
+    QVariant cacheSize;
+
+    /// PRAGMA mmap_size in bytes
+    QVariant mmapSize;
+
+    /// PRAGMA temp_store ("DEFAULT" , "FILE" or "MEMORY")
+    QString tempStore;
+
+    /// PRAGMA busy_timeout in milliseconds
+    QVariant busyTimeout;
+
+    /// PRAGMA query_only
+    QVariant queryOnly;
+
+    /// PRAGMA wal_autocheckpoint in pages. 0 disables the automatic checkpoint of the committing connection
+    /**
+      @see DQMaintenanceOptions::checkpointSize
+     */
+    QVariant walAutoCheckpoint;
+
+    /// The retry policy of busy statement. It replaces busyTimeout if it is not null.
+    DQRetryPolicy retryPolicy;
+};
+
+#endif // DQCONNECTIONOPTIONS_H
@@ -0,0 +1,147 @@
+#include <QtCore>
+#include <QThreadStorage>
+#include <QSqlDatabase>
+#include "dqconnectionpool.h"
+#include "dqsql.h"
+
+class DQConnectionPoolPriv;
+
+/// The cloned connection of a thread
+class _DQConnectionPoolThreadData {
+public:
+    _DQConnectionPoolThreadData() : pool(0) {
+    }
+
+    /// It is destroyed by QThreadStorage on thread exit
+    ~_DQConnectionPoolThreadData();
+
+    /// Close and remove the cloned database
+    void release();
+
+    DQConnectionPoolPriv* pool;
+    DQConnection connection;
+};
+
+class DQConnectionPoolPriv {
+public:
+    DQConnectionPoolPriv() {
+        thread = 0;
+        counter = 0;
+    }
+
+    DQConnection base;
+
+    /// The owner thread of base connection
+    QThread* thread;
+
+    QThreadStorage<_DQConnectionPoolThreadData*> storage;
+
+    /// All the alive clones
+    QList<_DQConnectionPoolThreadData*> clones;
+
+    /// Used to generate the connection name
+    int counter;
+
+    QMutex mutex;
+};
+
+static DQConnectionPool* m_defaultPool = 0;
+
+_DQConnectionPoolThreadData::~_DQConnectionPoolThreadData(){
+    if (!pool)
+        return;
+
+    QMutexLocker locker(&pool->mutex);
+    pool->clones.removeAll(this);
+    release();
+}
+
+void _DQConnectionPoolThreadData::release(){
+    QSqlDatabase db = connection.sql().database();
+    QString name = db.connectionName();
+
+    connection.close();
+    db.close();
+    db = QSqlDatabase();
+
+    if (!name.isEmpty())
+        QSqlDatabase::removeDatabase(name);
+    pool = 0;
+}
+
+DQConnectionPool::DQConnectionPool(DQConnection connection) : d(new DQConnectionPoolPriv())
+{
+    d->base = connection;
+    d->thread = QThread::currentThread();
+}
+
+DQConnectionPool::~DQConnectionPool()
+{
+    if (m_defaultPool == this)
+        m_defaultPool = 0;
+
+    d->mutex.lock();
+    foreach (_DQConnectionPoolThreadData* data , d->clones) {
+        data->release();
+    }
+    d->clones.clear();
+    d->mutex.unlock();
+
+    /* The thread data of running threads are not deleted by QThreadStorage.
+       They are released already.
+     */
+    delete d;
+}
+
+DQConnection DQConnectionPool::connection(){
+    if (QThread::currentThread() == d->thread) {
+        return d->base;
+    }
+
+    if (d->storage.hasLocalData()) {
+        return d->storage.localData()->connection;
+    }
+
+    QString name;
+    d->mutex.lock();
+    name = QString("%1_dqpool_%2").arg(d->base.sql().database().connectionName()).arg(d->counter++);
+    d->mutex.unlock();
+
+    _DQConnectionPoolThreadData* data = new _DQConnectionPoolThreadData();
+    data->connection = d->base.clone(name);
+
+    if (!data->connection.isOpen()) {
+        qWarning() << QString("DQConnectionPool::connection() - Failed to open the cloned database %1").arg(name);
+        QSqlDatabase::removeDatabase(name);
+        DQConnection res = data->connection;
+        delete data;
+        return res;
+    }
+
+    data->pool = d;
+
+    d->mutex.lock();
+    d->clones << data;
+    d->mutex.unlock();
+
+    d->storage.setLocalData(data);
+
+    return data->connection;
+}
+
+DQConnection DQConnectionPool::baseConnection(){
+    return d->base;
+}
+
+int DQConnectionPool::size(){
+    QMutexLocker locker(&d->mutex);
+    return d->clones.size();
+}
+
+void DQConnectionPool::setToDefaultPool(){
+    m_defaultPool = this;
+}
+
+DQConnectionPool* DQConnectionPool::defaultPool(){
+    return m_defaultPool;
+}
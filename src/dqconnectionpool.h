@@ -0,0 +1,80 @@
+#ifndef DQCONNECTIONPOOL_H
+#define DQCONNECTIONPOOL_H
+
+#include <dqconnection.h>
+
+class DQConnectionPoolPriv;
+
+/// A pool of per-thread database connection
+/**
+  A QSqlDatabase object can only be used by the thread that creates it.
+  DQConnectionPool clones the database of a connection by
+  QSqlDatabase::cloneDatabase() for every thread that asks for it. The clone is
+  created lazily on the first call of connection() within the thread, and
+  it is closed automatically when the thread is finished.
+
+  The clone shares the registered models of the base connection (the list
+  is copied when the clone is created, so add all the models before to use
+  the pool).
+
+  If the pool is installed as the default pool, DQConnection::defaultConnection()
+  will return the connection of the calling thread. Therefore DQModel and
+  DQQuery constructed in a worker thread use their own database handle, and
+  the reads could run in parallel (The journal mode of SQLite database should
+  be WAL).
+
+  Example:
+
+\code
+    DQConnection connection;
+    connection.open(db);
+
+    DQConnectionPool pool(connection);
+    pool.setToDefaultPool();
+
+    // In worker thread
+    DQQuery<User> query; // It uses the clone of worker thread
+\endcode
+
+  @remarks The pool must be destroyed after all the threads using it are finished.
+  @threadsafe
+ */
+
+class DQConnectionPool
+{
+public:
+    /// Construct a pool over a opened connection
+    /**
+      The calling thread is the owner thread of the connection. connection()
+      return the base connection instead of a clone for the owner thread.
+     */
+    explicit DQConnectionPool(DQConnection connection);
+
+    /// Close all the cloned connections
+    ~DQConnectionPool();
+
+    /// Get the connection of the calling thread
+    /**
+      @return The connection for the calling thread. If it is failed to open the cloned database , it returns an unopened connection.
+     */
+    DQConnection connection();
+
+    /// The base connection
+    DQConnection baseConnection();
+
+    /// No. of cloned connection
+    int size();
+
+    /// Install this pool as the default pool. DQConnection::defaultConnection() will return the connection of calling thread
+    void setToDefaultPool();
+
+    /// Get the default pool. NULL if it is not installed.
+    static DQConnectionPool* defaultPool();
+
+private:
+    Q_DISABLE_COPY(DQConnectionPool)
+
+    DQConnectionPoolPriv* d;
+};
+
+#endif // DQCONNECTIONPOOL_H
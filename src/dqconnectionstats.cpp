@@ -0,0 +1,106 @@
+#include <QtCore>
+#include "dqconnectionstats.h"
+
+/* Test cases:
+
+  sqlitetests::connectionStats()
+
+ */
+
+DQTableStats::DQTableStats() {
+    isIndex = false;
+    rows = -1;
+    estimated = false;
+    written = 0;
+    pages = -1;
+    bytes = -1;
+    unusedBytes = -1;
+}
+
+DQConnectionStats::DQConnectionStats() {
+    pageSize = -1;
+    pageCount = -1;
+    freePages = -1;
+    walSize = -1;
+    cacheHits = -1;
+    cacheMisses = -1;
+    cacheWrites = -1;
+    cacheUsed = -1;
+    statementCacheCapacity = 0;
+    statementCacheHits = 0;
+    statementCacheMisses = 0;
+    resultCacheEnabled = false;
+    resultCacheHits = 0;
+}
+
+double DQConnectionStats::cacheHitRatio() const{
+    if (cacheHits <= 0)
+        return 0;
+    qint64 total = cacheHits + qMax(cacheMisses,(qint64) 0);
+    return (double) cacheHits / total;
+}
+
+double DQConnectionStats::statementCacheHitRatio() const{
+    int total = statementCacheHits + statementCacheMisses;
+    if (total == 0)
+        return 0;
+    return (double) statementCacheHits / total;
+}
+
+DQTableStats DQConnectionStats::table(const QString &name) const{
+    foreach (DQTableStats item , tables) {
+        if (item.name == name)
+            return item;
+    }
+    foreach (DQTableStats item , indexes) {
+        if (item.name == name)
+            return item;
+    }
+    return DQTableStats();
+}
+
+/// Append a metric line. The unknown value (-1) is left out.
+static void _dqAppendMetric(QStringList &lines,const QString &name,const QString &labels,qint64 value) {
+    if (value < 0)
+        return;
+    lines << QString("dquest_%1%2 %3").arg(name).arg(labels).arg(value);
+}
+
+QString DQConnectionStats::toText() const{
+    QStringList lines;
+
+    foreach (DQTableStats item , tables) {
+        QString labels = QString("{table=\"%1\",schema=\"%2\"}").arg(item.name).arg(item.schema);
+        _dqAppendMetric(lines,item.estimated ? "table_rows_estimated" : "table_rows",labels,item.rows);
+        _dqAppendMetric(lines,"table_rows_written_total",labels,item.written);
+        _dqAppendMetric(lines,"table_pages",labels,item.pages);
+        _dqAppendMetric(lines,"table_bytes",labels,item.bytes);
+        _dqAppendMetric(lines,"table_unused_bytes",labels,item.unusedBytes);
+    }
+
+    foreach (DQTableStats item , indexes) {
+        QString labels = QString("{index=\"%1\",table=\"%2\",schema=\"%3\"}").arg(item.name).arg(item.table).arg(item.schema);
+        _dqAppendMetric(lines,"index_pages",labels,item.pages);
+        _dqAppendMetric(lines,"index_bytes",labels,item.bytes);
+        _dqAppendMetric(lines,"index_unused_bytes",labels,item.unusedBytes);
+    }
+
+    _dqAppendMetric(lines,"page_size_bytes","",pageSize);
+    _dqAppendMetric(lines,"pages","",pageCount);
+    _dqAppendMetric(lines,"free_pages","",freePages);
+    _dqAppendMetric(lines,"wal_bytes","",walSize);
+    _dqAppendMetric(lines,"cache_hits_total","",cacheHits);
+    _dqAppendMetric(lines,"cache_misses_total","",cacheMisses);
+    _dqAppendMetric(lines,"cache_writes_total","",cacheWrites);
+    _dqAppendMetric(lines,"cache_used_bytes","",cacheUsed);
+    if (cacheHits >= 0)
+        lines << QString("dquest_cache_hit_ratio %1").arg(cacheHitRatio());
+
+    _dqAppendMetric(lines,"statement_cache_capacity","",statementCacheCapacity);
+    _dqAppendMetric(lines,"statement_cache_hits_total","",statementCacheHits);
+    _dqAppendMetric(lines,"statement_cache_misses_total","",statementCacheMisses);
+    if (resultCacheEnabled)
+        _dqAppendMetric(lines,"result_cache_hits_total","",resultCacheHits);
+
+    return lines.join("\n") + "\n";
+}
@@ -0,0 +1,142 @@
+#ifndef DQCONNECTIONSTATS_H
+#define DQCONNECTIONSTATS_H
+
+#include <QString>
+#include <QList>
+#include <QMetaType>
+
+/// The size of a table or index
+/**
+  @see DQConnectionStats
+ */
+class DQTableStats {
+public:
+    DQTableStats();
+
+    /// The name of table or index
+    QString name;
+
+    /// The table of an index. It is equal to name for a table
+    QString table;
+
+    /// The schema of the table. It is "main" unless the model is bound to an attached database
+    QString schema;
+
+    /// TRUE if it is an index
+    bool isIndex;
+
+    /// No. of rows. -1 if it is unknown (an index , or the table is not counted)
+    qint64 rows;
+
+    /// TRUE if rows is taken from sqlite_stat1 (the result of last ANALYZE) instead of counted
+    bool estimated;
+
+    /// No. of rows written through the connection since it was opened
+    qint64 written;
+
+    /// No. of pages used. -1 if the dbstat virtual table is not available
+    qint64 pages;
+
+    /// Total size of the pages in bytes. -1 if the dbstat virtual table is not available
+    qint64 bytes;
+
+    /// The unused bytes of the pages. -1 if the dbstat virtual table is not available
+    qint64 unusedBytes;
+};
+
+/// The row counts , sizes and cache statistics of a connection
+/**
+  It is returned by DQConnection::stats() for capacity planning:
+
+\code
+    DQConnectionStats stats = connection.stats();
+    foreach (DQTableStats table , stats.tables) {
+        qDebug() << table.name << table.rows << table.bytes;
+    }
+    qDebug() << "Cache hit ratio" << stats.cacheHitRatio();
+\endcode
+
+  toText() formats the stats as metrics (Prometheus text format) and
+  DQStatsReporter dumps them periodically.
+
+  @see DQConnection::stats()
+ */
+class DQConnectionStats {
+public:
+    DQConnectionStats();
+
+    /// The tables of the registered models
+    QList<DQTableStats> tables;
+
+    /// The indexes of the tables. Only available with dbstat.
+    QList<DQTableStats> indexes;
+
+    /// The page size of main database in bytes
+    qint64 pageSize;
+
+    /// No. of pages of main database
+    qint64 pageCount;
+
+    /// No. of unused pages of main database
+    qint64 freePages;
+
+    /// The size of the WAL file. -1 if it is not available
+    qint64 walSize;
+
+    /// No. of page cache hits (SQLITE_DBSTATUS_CACHE_HIT). The page cache counters are 0 unless DQuest is built with dquest_sqlite_api
+    qint64 cacheHits;
+
+    /// No. of page cache misses (SQLITE_DBSTATUS_CACHE_MISS)
+    qint64 cacheMisses;
+
+    /// No. of dirty pages written from the page cache (SQLITE_DBSTATUS_CACHE_WRITE)
+    qint64 cacheWrites;
+
+    /// The memory used by the page cache in bytes (SQLITE_DBSTATUS_CACHE_USED)
+    qint64 cacheUsed;
+
+    /// The capacity of the prepared statement cache
+    int statementCacheCapacity;
+
+    /// No. of prepare() served by the statement cache
+    int statementCacheHits;
+
+    /// No. of prepare() that prepared a new statement
+    int statementCacheMisses;
+
+    /// TRUE if the result cache is enabled
+    bool resultCacheEnabled;
+
+    /// No. of queries served by the result cache
+    int resultCacheHits;
+
+    /// The ratio of page cache hits. 0 if there is no access.
+    double cacheHitRatio() const;
+
+    /// The ratio of prepare() served by the statement cache. 0 if there is no call.
+    double statementCacheHitRatio() const;
+
+    /// Find the stats of a table by name
+    /**
+      @return The stats. The name is empty if it is not found.
+     */
+    DQTableStats table(const QString &name) const;
+
+    /// Format the stats in Prometheus text format
+    /**
+      The metrics are prefixed by "dquest_" , e.g:
+
+\code
+    dquest_table_rows{table="healthcheck",schema="main"} 1500
+    dquest_table_bytes{table="healthcheck",schema="main"} 126976
+    dquest_cache_hit_ratio 0.982
+\endcode
+
+      The unknown values (-1) are left out.
+     */
+    QString toText() const;
+};
+
+Q_DECLARE_METATYPE(DQConnectionStats)
+
+#endif // DQCONNECTIONSTATS_H
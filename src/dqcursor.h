@@ -0,0 +1,157 @@
+#ifndef DQCURSOR_H
+#define DQCURSOR_H
+
+#include <dqquery.h>
+
+/// Forward-only cursor over the result of a query
+/**
+  DQQuery::all() creates a model instance per record and holds all of them
+  in a DQList. DQCursor is an alternative to walk through a large result.
+  It steps the query by QSqlQuery::next() and writes the record to a single
+  model instance , so the memory usage is independent of the no. of record.
+
+  The model returned by the cursor is overwritten on every step. Copy it if you
+  need to keep the record.
+
+  Example:
+
+\code
+    DQQuery<HealthCheck> query = DQQuery<HealthCheck>().filter(DQWhere("height") > 150);
+    DQCursor<HealthCheck> cursor(query);
+
+    while (cursor.next()) {
+        qDebug() << cursor->name;
+    }
+
+    // Or iterator interface (It could be used by range-based for loop)
+
+    DQCursor<HealthCheck> cursor2(query);
+    DQCursor<HealthCheck>::iterator iter;
+    for (iter = cursor2.begin() ; iter != cursor2.end() ; iter++) {
+        qDebug() << iter->name;
+    }
+\endcode
+
+  @remarks It is not copyable
+ */
+
+template <typename T>
+class DQCursor
+{
+public:
+    /// Forward-only iterator of DQCursor
+    class iterator {
+    public:
+        inline iterator() : m_cursor(0) {
+        }
+
+        inline T& operator*() const {
+            return m_cursor->model();
+        }
+
+        inline T* operator->() const {
+            return &m_cursor->model();
+        }
+
+        inline iterator& operator++() {
+            if (!m_cursor->next())
+                m_cursor = 0;
+            return *this;
+        }
+
+        /// Step to the next record and return the previous iterator
+        /**
+          The cursor is forward-only. The returned iterator refers to the same
+          cursor and reads its current record , but it is still not equal to
+          end() after the last record is passed.
+         */
+        inline iterator operator++(int) {
+            iterator prev(*this);
+            operator++();
+            return prev;
+        }
+
+        inline bool operator==(const iterator& rhs) const {
+            return m_cursor == rhs.m_cursor;
+        }
+
+        inline bool operator!=(const iterator& rhs) const {
+            return m_cursor != rhs.m_cursor;
+        }
+
+    private:
+        inline explicit iterator(DQCursor* cursor) : m_cursor(cursor) {
+        }
+
+        DQCursor* m_cursor;
+
+        friend class DQCursor;
+    };
+
+    /// Construct a cursor over the result of the query. The query is executed on first call of next()
+    explicit DQCursor(DQSharedQuery query) : m_query(query) , m_started(false) {
+    }
+
+    /// Release the result of the query
+    ~DQCursor() {
+        m_query.finish();
+    }
+
+    /// Step to the next record.
+    /**
+      @return TRUE if the record is available and written to model(). Otherwise it is false.
+     */
+    bool next() {
+        if (!m_started) {
+            m_started = true;
+            if (!m_query.exec())
+                return false;
+        }
+
+        if (!m_query.next()) {
+            m_query.finish();
+            return false;
+        }
+
+        return m_query.recordTo(m_model);
+    }
+
+    /// The model holding the current record
+    inline T& model() {
+        return m_model;
+    }
+
+    /// Access the current record
+    inline T* operator->() {
+        return &m_model;
+    }
+
+    /// Access the current record
+    inline T& operator*() {
+        return m_model;
+    }
+
+    /// Execute the query and return the iterator to the first record
+    /**
+      The cursor could only be iterated once.
+     */
+    iterator begin() {
+        iterator iter(this);
+        ++iter;
+        return iter;
+    }
+
+    /// The iterator representing the end of result
+    inline iterator end() {
+        return iterator();
+    }
+
+private:
+    Q_DISABLE_COPY(DQCursor)
+
+    DQQuery<T> m_query;
+    T m_model;
+    bool m_started;
+};
+
+#endif // DQCURSOR_H
@@ -0,0 +1,890 @@
+#include <QtCore>
+#include "dqevaluator.h"
+#include "dqwhere_p.h"
+#include "dqmodelmetainfo.h"
+
+/* Test cases:
+
+  coretests::evaluator()
+
+  sqlitetests::evaluatorColumnar()
+
+ */
+
+enum _DQEvalOp {
+    OpNone,
+    OpAnd,
+    OpOr,
+    OpEq,
+    OpNe,
+    OpLt,
+    OpLe,
+    OpGt,
+    OpGe,
+    OpAdd,
+    OpSub,
+    OpMul,
+    OpDiv,
+    OpMod,
+    OpBetween,
+    OpIn,
+    OpNotIn,
+    OpLike,
+    OpGlob,
+    OpIs,
+    OpIsNot
+};
+
+/// A node of compiled DQWhere tree
+class _DQEvalNode {
+public:
+    enum Kind {
+        Constant,
+        Field,
+        List,
+        Expr
+    };
+
+    inline _DQEvalNode() : kind(Constant) , op(OpNone), field(-1) , left(-1) , right(-1) , hasPattern(false) {
+    }
+
+    Kind kind;
+    _DQEvalOp op;
+
+    /// The value of Constant node
+    QVariant value;
+
+    /// The index to DQEvaluatorPriv::fields of Field node
+    int field;
+
+    /// The values of List node
+    QList<QVariant> list;
+
+    int left;
+    int right;
+
+    /// The compiled pattern of like / glob with constant pattern
+    QRegExp pattern;
+    bool hasPattern;
+};
+
+/// Read the value of fields for a record
+class _DQRowAccessor {
+public:
+    virtual ~_DQRowAccessor() {
+    }
+
+    /// Get the value of field at index of DQEvaluatorPriv::fields
+    virtual QVariant value(int field) const = 0;
+};
+
+class _DQModelAccessor : public _DQRowAccessor {
+public:
+    inline _DQModelAccessor(const QStringList &fields) : m_fields(fields) , m_metaInfo(0) , m_model(0) {
+    }
+
+    void setModel(const DQAbstractModel *model) {
+        m_model = model;
+        DQModelMetaInfo *metaInfo = model->metaInfo();
+        if (metaInfo == m_metaInfo)
+            return;
+
+        m_metaInfo = metaInfo;
+        m_index.resize(m_fields.size());
+        for (int i = 0 ; i < m_fields.size();i++) {
+            m_index[i] = metaInfo->indexOf(m_fields.at(i));
+        }
+    }
+
+    QVariant value(int field) const {
+        int index = m_index.at(field);
+        if (index < 0)
+            return QVariant();
+        return m_metaInfo->value(m_model,index);
+    }
+
+private:
+    QStringList m_fields;
+    DQModelMetaInfo *m_metaInfo;
+    const DQAbstractModel *m_model;
+    QVector<int> m_index;
+};
+
+class _DQColumnAccessor : public _DQRowAccessor {
+public:
+    inline _DQColumnAccessor(const DQColumnarResult &result,const QVector<int> &columns) : m_result(result) , m_columns(columns) , row(0) {
+    }
+
+    QVariant value(int field) const {
+        int column = m_columns.at(field);
+        if (column < 0)
+            return QVariant();
+        return m_result.value(column,row);
+    }
+
+private:
+    const DQColumnarResult &m_result;
+    QVector<int> m_columns;
+
+public:
+    int row;
+};
+
+static bool _dqIsIntegral(const QVariant &v) {
+    switch (v.type()) {
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool _dqIsNumeric(const QVariant &v) {
+    return _dqIsIntegral(v) || v.type() == QVariant::Double;
+}
+
+/// Compare two non-null values. Numbers are compared by value , others are compared by string
+static int _dqCompare(const QVariant &a,const QVariant &b) {
+    bool numeric = _dqIsNumeric(a) && _dqIsNumeric(b);
+    double da = 0,db = 0;
+
+    if (!numeric && (_dqIsNumeric(a) || _dqIsNumeric(b))) {
+        bool ok1,ok2;
+        da = a.toString().toDouble(&ok1);
+        db = b.toString().toDouble(&ok2);
+        if (ok1 && ok2) {
+            return da < db ? -1 : (da > db ? 1 : 0);
+        }
+    }
+
+    if (numeric) {
+        if (_dqIsIntegral(a) && _dqIsIntegral(b)) {
+            qint64 ia = a.toLongLong();
+            qint64 ib = b.toLongLong();
+            return ia < ib ? -1 : (ia > ib ? 1 : 0);
+        }
+        da = a.toDouble();
+        db = b.toDouble();
+        return da < db ? -1 : (da > db ? 1 : 0);
+    }
+
+    return QString::compare(a.toString(),b.toString());
+}
+
+static bool _dqTruth(const QVariant &v) {
+    if (v.isNull())
+        return false;
+    if (v.type() == QVariant::Bool)
+        return v.toBool();
+    return v.toDouble() != 0;
+}
+
+/// Convert the pattern of SQL LIKE to QRegExp
+static QRegExp _dqLikePattern(const QString &like) {
+    QString rx;
+    int n = like.size();
+    for (int i = 0 ; i < n;i++) {
+        QChar c = like.at(i);
+        if (c == QChar('%'))
+            rx += ".*";
+        else if (c == QChar('_'))
+            rx += ".";
+        else
+            rx += QRegExp::escape(QString(c));
+    }
+    return QRegExp(rx,Qt::CaseInsensitive);
+}
+
+static QRegExp _dqPattern(_DQEvalOp op,const QString &pattern) {
+    if (op == OpGlob)
+        return QRegExp(pattern,Qt::CaseSensitive,QRegExp::Wildcard);
+    return _dqLikePattern(pattern);
+}
+
+/// Aggregate a sequence of values
+class _DQAggregator {
+public:
+    inline _DQAggregator(const QString &func) : m_func(func.toLower()) , m_count(0) , m_integral(true) , m_isum(0) , m_dsum(0) {
+    }
+
+    void add(const QVariant &v) {
+        if (v.isNull())
+            return;
+
+        m_count++;
+
+        if (_dqIsIntegral(v)) {
+            m_isum += v.toLongLong();
+        } else {
+            m_integral = false;
+        }
+        m_dsum += v.toDouble();
+
+        if (m_min.isNull() || _dqCompare(v,m_min) < 0)
+            m_min = v;
+        if (m_max.isNull() || _dqCompare(v,m_max) > 0)
+            m_max = v;
+    }
+
+    QVariant result() const {
+        if (m_func == "count")
+            return m_count;
+
+        if (m_count == 0)
+            return QVariant();
+
+        if (m_func == "sum") {
+            if (m_integral)
+                return m_isum;
+            return m_dsum;
+        } else if (m_func == "avg") {
+            return m_dsum / m_count;
+        } else if (m_func == "min") {
+            return m_min;
+        } else if (m_func == "max") {
+            return m_max;
+        }
+
+        qWarning() << QString("DQEvaluator::call() - Unsupported function %1").arg(m_func);
+        return QVariant();
+    }
+
+private:
+    QString m_func;
+    int m_count;
+    bool m_integral;
+    qint64 m_isum;
+    double m_dsum;
+    QVariant m_min;
+    QVariant m_max;
+};
+
+/// Run the comparison over a numeric column array
+template <typename T,typename C>
+static void _dqCompareKernel(const T *values,int n,_DQEvalOp op,C c,uchar *out) {
+    int i;
+    switch (op) {
+    case OpEq:
+        for (i = 0 ; i < n;i++) out[i] = values[i] == c;
+        break;
+    case OpNe:
+        for (i = 0 ; i < n;i++) out[i] = values[i] != c;
+        break;
+    case OpLt:
+        for (i = 0 ; i < n;i++) out[i] = values[i] < c;
+        break;
+    case OpLe:
+        for (i = 0 ; i < n;i++) out[i] = values[i] <= c;
+        break;
+    case OpGt:
+        for (i = 0 ; i < n;i++) out[i] = values[i] > c;
+        break;
+    case OpGe:
+        for (i = 0 ; i < n;i++) out[i] = values[i] >= c;
+        break;
+    default:
+        for (i = 0 ; i < n;i++) out[i] = 0;
+        break;
+    }
+}
+
+template <typename T>
+static bool _dqCompareColumn(const QVector<T> &values,_DQEvalOp op,const QVariant &c,uchar *out) {
+    if (!_dqIsNumeric(c))
+        return false;
+
+    if (_dqIsIntegral(c))
+        _dqCompareKernel(values.constData(),values.size(),op,c.toLongLong(),out);
+    else
+        _dqCompareKernel(values.constData(),values.size(),op,c.toDouble(),out);
+    return true;
+}
+
+class DQEvaluatorPriv : public QSharedData {
+public:
+    inline DQEvaluatorPriv() : root(-1) {
+    }
+
+    QVector<_DQEvalNode> nodes;
+
+    /// The field names referred by the tree
+    QStringList fields;
+
+    /// The root node. -1 if it is null
+    int root;
+
+    int compile(DQWhere where);
+
+    int compileOperand(QVariant v);
+
+    /// Get the value of a node
+    QVariant value(int index,const _DQRowAccessor &row) const;
+
+    /// Test a node as a condition
+    bool test(int index,const _DQRowAccessor &row) const;
+
+    /// Test a comparison node with the value of operands
+    bool test(int index,const QVariant &a,const QVariant &b) const;
+
+    /// Evaluate a node over all the rows of columnar result
+    QVector<uchar> mask(int index,const DQColumnarResult &result,const QVector<int> &columns) const;
+
+    /// Evaluate the filter over all the rows of columnar result
+    QVector<uchar> mask(const DQColumnarResult &result) const;
+};
+
+static int typeId = qMetaTypeId<DQWhere>();
+
+static int dataPrivTypeId = qMetaTypeId<DQWhereDataPriv>();
+
+static const struct {
+    const char *name;
+    _DQEvalOp op;
+} _dqEvalOps[] = {
+    {"and", OpAnd},
+    {"or", OpOr},
+    {"=", OpEq},
+    {"==", OpEq},
+    {"<>", OpNe},
+    {"!=", OpNe},
+    {"<", OpLt},
+    {"<=", OpLe},
+    {">", OpGt},
+    {">=", OpGe},
+    {"+", OpAdd},
+    {"-", OpSub},
+    {"*", OpMul},
+    {"/", OpDiv},
+    {"%", OpMod},
+    {"between", OpBetween},
+    {"in", OpIn},
+    {"not in", OpNotIn},
+    {"like", OpLike},
+    {"glob", OpGlob},
+    {"is", OpIs},
+    {"is not", OpIsNot},
+    {0, OpNone}
+};
+
+static _DQEvalOp _dqEvalOp(QString op) {
+    op = op.trimmed().toLower();
+    for (int i = 0 ; _dqEvalOps[i].name ; i++) {
+        if (op == _dqEvalOps[i].name)
+            return _dqEvalOps[i].op;
+    }
+    return OpNone;
+}
+
+int DQEvaluatorPriv::compile(DQWhere where) {
+    _DQEvalNode node;
+
+    if (where.isField()) {
+        QString name = where.toString();
+        int field = fields.indexOf(name);
+        if (field < 0) {
+            field = fields.size();
+            fields << name;
+        }
+        node.kind = _DQEvalNode::Field;
+        node.field = field;
+    } else {
+        node.kind = _DQEvalNode::Expr;
+        node.op = _dqEvalOp(where.op());
+        if (node.op == OpNone)
+            qWarning() << QString("DQEvaluator - Unsupported operator %1").arg(where.op());
+
+        node.left = compileOperand(where.left());
+        node.right = compileOperand(where.right());
+
+        const _DQEvalNode &right = nodes.at(node.right);
+        if ((node.op == OpLike || node.op == OpGlob) &&
+            right.kind == _DQEvalNode::Constant && !right.value.isNull()) {
+            node.pattern = _dqPattern(node.op,right.value.toString());
+            node.hasPattern = true;
+        }
+    }
+
+    nodes << node;
+    return nodes.size() - 1;
+}
+
+int DQEvaluatorPriv::compileOperand(QVariant v) {
+    if (v.userType() == typeId)
+        return compile(v.value<DQWhere>());
+
+    _DQEvalNode node;
+    if (v.userType() == dataPrivTypeId) {
+        node.kind = _DQEvalNode::List;
+        node.list = v.value<DQWhereDataPriv>().list();
+    } else {
+        node.kind = _DQEvalNode::Constant;
+        node.value = v;
+    }
+
+    nodes << node;
+    return nodes.size() - 1;
+}
+
+QVariant DQEvaluatorPriv::value(int index,const _DQRowAccessor &row) const {
+    const _DQEvalNode &node = nodes.at(index);
+
+    switch (node.kind) {
+    case _DQEvalNode::Constant:
+        return node.value;
+    case _DQEvalNode::Field:
+        return row.value(node.field);
+    case _DQEvalNode::List:
+        return QVariant();
+    default:
+        break;
+    }
+
+    if (node.op < OpAdd || node.op > OpMod)
+        return test(index,row);
+
+    QVariant a = value(node.left,row);
+    QVariant b = value(node.right,row);
+    if (a.isNull() || b.isNull())
+        return QVariant();
+
+    if (_dqIsIntegral(a) && _dqIsIntegral(b)) {
+        qint64 ia = a.toLongLong();
+        qint64 ib = b.toLongLong();
+        switch (node.op) {
+        case OpAdd:
+            return ia + ib;
+        case OpSub:
+            return ia - ib;
+        case OpMul:
+            return ia * ib;
+        case OpDiv:
+            return ib == 0 ? QVariant() : QVariant(ia / ib);
+        default:
+            return ib == 0 ? QVariant() : QVariant(ia % ib);
+        }
+    }
+
+    double da = a.toDouble();
+    double db = b.toDouble();
+    switch (node.op) {
+    case OpAdd:
+        return da + db;
+    case OpSub:
+        return da - db;
+    case OpMul:
+        return da * db;
+    case OpDiv:
+        return db == 0 ? QVariant() : QVariant(da / db);
+    default:
+        return (qint64) db == 0 ? QVariant() : QVariant(a.toLongLong() % b.toLongLong());
+    }
+}
+
+bool DQEvaluatorPriv::test(int index,const _DQRowAccessor &row) const {
+    const _DQEvalNode &node = nodes.at(index);
+
+    if (node.kind != _DQEvalNode::Expr)
+        return _dqTruth(value(index,row));
+
+    switch (node.op) {
+    case OpAnd:
+        return test(node.left,row) && test(node.right,row);
+    case OpOr:
+        return test(node.left,row) || test(node.right,row);
+    case OpAdd:
+    case OpSub:
+    case OpMul:
+    case OpDiv:
+    case OpMod:
+        return _dqTruth(value(index,row));
+    default:
+        break;
+    }
+
+    return test(index,value(node.left,row),value(node.right,row));
+}
+
+bool DQEvaluatorPriv::test(int index,const QVariant &a,const QVariant &b) const {
+    const _DQEvalNode &node = nodes.at(index);
+
+    switch (node.op) {
+    case OpIs:
+        if (a.isNull() || b.isNull())
+            return a.isNull() && b.isNull();
+        return _dqCompare(a,b) == 0;
+    case OpIsNot:
+        if (a.isNull() || b.isNull())
+            return a.isNull() != b.isNull();
+        return _dqCompare(a,b) != 0;
+    default:
+        break;
+    }
+
+    if (a.isNull())
+        return false;
+
+    const QList<QVariant> &list = nodes.at(node.right).list;
+
+    switch (node.op) {
+    case OpBetween:
+        if (list.size() != 2 || list.at(0).isNull() || list.at(1).isNull())
+            return false;
+        return _dqCompare(a,list.at(0)) >= 0 && _dqCompare(a,list.at(1)) <= 0;
+    case OpIn:
+        foreach (QVariant v , list) {
+            if (!v.isNull() && _dqCompare(a,v) == 0)
+                return true;
+        }
+        return false;
+    case OpNotIn:
+        foreach (QVariant v , list) {
+            if (v.isNull() || _dqCompare(a,v) == 0)
+                return false;
+        }
+        return true;
+    default:
+        break;
+    }
+
+    if (b.isNull())
+        return false;
+
+    switch (node.op) {
+    case OpEq:
+        return _dqCompare(a,b) == 0;
+    case OpNe:
+        return _dqCompare(a,b) != 0;
+    case OpLt:
+        return _dqCompare(a,b) < 0;
+    case OpLe:
+        return _dqCompare(a,b) <= 0;
+    case OpGt:
+        return _dqCompare(a,b) > 0;
+    case OpGe:
+        return _dqCompare(a,b) >= 0;
+    case OpLike:
+    case OpGlob:
+        if (node.hasPattern)
+            return node.pattern.exactMatch(a.toString());
+        return _dqPattern(node.op,b.toString()).exactMatch(a.toString());
+    default:
+        return false;
+    }
+}
+
+QVector<uchar> DQEvaluatorPriv::mask(int index,const DQColumnarResult &result,const QVector<int> &columns) const {
+    int n = result.rowCount();
+    QVector<uchar> res(n);
+    uchar *out = res.data();
+    const _DQEvalNode &node = nodes.at(index);
+
+    if (node.kind == _DQEvalNode::Expr && (node.op == OpAnd || node.op == OpOr)) {
+        QVector<uchar> left = mask(node.left,result,columns);
+        QVector<uchar> right = mask(node.right,result,columns);
+        const uchar *l = left.constData();
+        const uchar *r = right.constData();
+        if (node.op == OpAnd) {
+            for (int i = 0 ; i < n;i++) out[i] = l[i] & r[i];
+        } else {
+            for (int i = 0 ; i < n;i++) out[i] = l[i] | r[i];
+        }
+        return res;
+    }
+
+    /* Fast path: a comparison between a column and constants */
+
+    int column = -1;
+    bool fast = node.kind == _DQEvalNode::Expr &&
+                ((node.op >= OpEq && node.op <= OpGe) || node.op >= OpBetween);
+    if (fast) {
+        const _DQEvalNode &left = nodes.at(node.left);
+        const _DQEvalNode &right = nodes.at(node.right);
+        fast = left.kind == _DQEvalNode::Field &&
+               right.kind != _DQEvalNode::Field && right.kind != _DQEvalNode::Expr;
+        if (fast)
+            column = columns.at(left.field);
+        fast = fast && column >= 0;
+    }
+
+    if (fast && result.type(column) == DQColumnarResult::Text) {
+        // Evaluate once per distinct string
+        QStringList pool = result.textPool(column);
+        QVariant b = nodes.at(node.right).value;
+        QVector<uchar> poolMask(pool.size());
+        for (int i = 0 ; i < pool.size();i++) {
+            poolMask[i] = test(index,QVariant(pool.at(i)),b);
+        }
+        uchar nullValue = test(index,QVariant(),b);
+
+        const int *textIndex = result.textIndex(column).constData();
+        for (int i = 0 ; i < n;i++) {
+            int idx = textIndex[i];
+            out[i] = idx < 0 ? nullValue : poolMask[idx];
+        }
+        return res;
+    }
+
+    if (fast && node.op >= OpEq && node.op <= OpGe) {
+        QVariant c = nodes.at(node.right).value;
+        bool done;
+        if (result.type(column) == DQColumnarResult::Integer)
+            done = _dqCompareColumn(result.integers(column),node.op,c,out);
+        else
+            done = _dqCompareColumn(result.reals(column),node.op,c,out);
+
+        if (done) {
+            const quint32 *nulls = result.nullBitmap(column).constData();
+            for (int i = 0 ; i < n;i++) {
+                if (nulls[i / 32] & (1u << (i % 32)))
+                    out[i] = 0;
+            }
+            return res;
+        }
+    }
+
+    if (fast && (node.op == OpBetween || node.op == OpIn || node.op == OpNotIn)) {
+        const QList<QVariant> &list = nodes.at(node.right).list;
+        bool numeric = true;
+        foreach (QVariant v , list) {
+            numeric = numeric && _dqIsNumeric(v);
+        }
+
+        if (numeric && (node.op != OpBetween || list.size() == 2)) {
+            QVector<uchar> tmp(n);
+            uchar *t = tmp.data();
+            bool integer = result.type(column) == DQColumnarResult::Integer;
+
+            if (node.op == OpBetween) {
+                if (integer) {
+                    _dqCompareColumn(result.integers(column),OpGe,list.at(0),out);
+                    _dqCompareColumn(result.integers(column),OpLe,list.at(1),t);
+                } else {
+                    _dqCompareColumn(result.reals(column),OpGe,list.at(0),out);
+                    _dqCompareColumn(result.reals(column),OpLe,list.at(1),t);
+                }
+                for (int i = 0 ; i < n;i++) out[i] &= t[i];
+            } else {
+                for (int i = 0 ; i < n;i++) out[i] = 0;
+                foreach (QVariant v , list) {
+                    if (integer)
+                        _dqCompareColumn(result.integers(column),OpEq,v,t);
+                    else
+                        _dqCompareColumn(result.reals(column),OpEq,v,t);
+                    for (int i = 0 ; i < n;i++) out[i] |= t[i];
+                }
+                if (node.op == OpNotIn) {
+                    for (int i = 0 ; i < n;i++) out[i] = !out[i];
+                }
+            }
+
+            const quint32 *nulls = result.nullBitmap(column).constData();
+            for (int i = 0 ; i < n;i++) {
+                if (nulls[i / 32] & (1u << (i % 32)))
+                    out[i] = 0;
+            }
+            return res;
+        }
+    }
+
+    /* Record by record */
+
+    _DQColumnAccessor row(result,columns);
+    for (int i = 0 ; i < n;i++) {
+        row.row = i;
+        out[i] = test(index,row);
+    }
+
+    return res;
+}
+
+QVector<uchar> DQEvaluatorPriv::mask(const DQColumnarResult &result) const {
+    if (root < 0)
+        return QVector<uchar>(result.rowCount(),1);
+
+    QVector<int> columns;
+    foreach (QString field , fields) {
+        columns << result.indexOf(field);
+    }
+
+    return mask(root,result,columns);
+}
+
+DQEvaluator::DQEvaluator() : d(new DQEvaluatorPriv){
+}
+
+DQEvaluator::DQEvaluator(DQWhere where) : d(new DQEvaluatorPriv){
+    if (!where.isNull())
+        d->root = d->compile(where);
+}
+
+DQEvaluator::DQEvaluator(const DQEvaluator &other) : d(other.d){
+}
+
+DQEvaluator &DQEvaluator::operator=(const DQEvaluator &rhs){
+    if (this != &rhs)
+        d.operator=(rhs.d);
+    return *this;
+}
+
+DQEvaluator::~DQEvaluator(){
+}
+
+bool DQEvaluator::isNull() const{
+    return d->root < 0;
+}
+
+bool DQEvaluator::match(const DQAbstractModel* model) const{
+    if (d->root < 0)
+        return true;
+
+    _DQModelAccessor row(d->fields);
+    row.setModel(model);
+    return d->test(d->root,row);
+}
+
+QVector<int> DQEvaluator::select(const DQSharedList &list) const{
+    QVector<int> res;
+    int n = list.size();
+    _DQModelAccessor row(d->fields);
+
+    for (int i = 0 ; i < n;i++) {
+        if (d->root >= 0) {
+            row.setModel(list.at(i));
+            if (!d->test(d->root,row))
+                continue;
+        }
+        res << i;
+    }
+
+    return res;
+}
+
+QVector<int> DQEvaluator::select(const DQColumnarResult &result) const{
+    QVector<int> res;
+    QVector<uchar> mask = d->mask(result);
+    int n = mask.size();
+    for (int i = 0 ; i < n;i++) {
+        if (mask[i])
+            res << i;
+    }
+    return res;
+}
+
+QVariant DQEvaluator::call(QString func,const DQSharedList &list,QString field) const{
+    _DQAggregator aggregator(func);
+    QVector<int> rows = select(list);
+
+    if (field.isEmpty()) {
+        if (func.toLower() == "count")
+            return rows.size();
+        qWarning() << QString("DQEvaluator::call() - The field of %1 is missing").arg(func);
+        return QVariant();
+    }
+
+    foreach (int i , rows) {
+        const DQAbstractModel *model = list.at(i);
+        aggregator.add(model->metaInfo()->value(model,field));
+    }
+
+    return aggregator.result();
+}
+
+QVariant DQEvaluator::call(QString func,const DQColumnarResult &result,QString column) const{
+    QVector<uchar> mask = d->mask(result);
+    int n = mask.size();
+    func = func.toLower();
+
+    if (column.isEmpty()) {
+        if (func == "count")
+            return (int) select(result).size();
+        qWarning() << QString("DQEvaluator::call() - The column of %1 is missing").arg(func);
+        return QVariant();
+    }
+
+    int col = result.indexOf(column);
+    if (col < 0) {
+        qWarning() << QString("DQEvaluator::call() - %1 is not found in the result").arg(column);
+        return QVariant();
+    }
+
+    DQColumnarResult::Type type = result.type(col);
+    if (type == DQColumnarResult::Text) {
+        _DQAggregator aggregator(func);
+        for (int i = 0 ; i < n;i++) {
+            if (mask[i])
+                aggregator.add(result.value(col,i));
+        }
+        return aggregator.result();
+    }
+
+    // Skip the null values
+    uchar *m = mask.data();
+    const quint32 *nulls = result.nullBitmap(col).constData();
+    for (int i = 0 ; i < n;i++) {
+        if (nulls[i / 32] & (1u << (i % 32)))
+            m[i] = 0;
+    }
+
+    int count = 0;
+    for (int i = 0 ; i < n;i++) count += m[i];
+
+    if (func == "count")
+        return count;
+    if (count == 0)
+        return QVariant();
+
+    if (type == DQColumnarResult::Integer) {
+        const qint64 *v = result.integers(col).constData();
+        if (func == "sum" || func == "avg") {
+            qint64 sum = 0;
+            for (int i = 0 ; i < n;i++) sum += m[i] ? v[i] : 0;
+            if (func == "sum")
+                return sum;
+            return (double) sum / count;
+        }
+
+        if (func == "min" || func == "max") {
+            bool min = func == "min";
+            qint64 res = 0;
+            bool found = false;
+            for (int i = 0 ; i < n;i++) {
+                if (!m[i])
+                    continue;
+                if (!found || (min ? v[i] < res : v[i] > res))
+                    res = v[i];
+                found = true;
+            }
+            return res;
+        }
+    } else {
+        const double *v = result.reals(col).constData();
+        if (func == "sum" || func == "avg") {
+            double sum = 0;
+            for (int i = 0 ; i < n;i++) sum += m[i] ? v[i] : 0;
+            if (func == "sum")
+                return sum;
+            return sum / count;
+        }
+
+        if (func == "min" || func == "max") {
+            bool min = func == "min";
+            double res = 0;
+            bool found = false;
+            for (int i = 0 ; i < n;i++) {
+                if (!m[i])
+                    continue;
+                if (!found || (min ? v[i] < res : v[i] > res))
+                    res = v[i];
+                found = true;
+            }
+            return res;
+        }
+    }
+
+    qWarning() << QString("DQEvaluator::call() - Unsupported function %1").arg(func);
+    return QVariant();
+}
@@ -0,0 +1,88 @@
+#ifndef DQEVALUATOR_H
+#define DQEVALUATOR_H
+
+#include <QSharedDataPointer>
+#include <QVector>
+#include <dqwhere.h>
+#include <dqsharedlist.h>
+#include <dqcolumnarresult.h>
+
+class DQEvaluatorPriv;
+
+/// Evaluate a DQWhere filter in memory
+/**
+  DQEvaluator runs a DQWhere expression over the records already loaded
+  by DQSharedQuery::all() or DQSharedQuery::columns() , so a result could
+  be refiltered and aggregated repeatedly without running a new SQL query.
+
+  The supported operators are the same as DQWhere: and , or , = , <> , < ,
+  <= , > , >= , + , - , * , / , % , between , in , not in , like , glob , is and is not.
+  The comparison follows SQL: it is false if any of the operand is null (except "is" and "is not").
+
+  On DQColumnarResult , the comparison of a numeric column against constants
+  runs as a tight loop over the column array , and a predicate on a Text column
+  is evaluated once per distinct string. Other expressions are evaluated per record.
+
+  Example:
+\code
+    DQList<HealthCheck> list = DQQuery<HealthCheck>().all();
+
+    DQEvaluator tall(DQWhere("height") > 170);
+    QVector<int> rows = tall.select(list); // Index of the matched records
+    QVariant weight = tall.call("avg",list,"weight");
+
+    DQColumnarResult result = DQQuery<HealthCheck>().columns(QStringList() << "height" << "weight");
+    weight = tall.call("avg",result,"weight");
+\endcode
+
+  @remarks It is an implicitly shared class
+ */
+class DQEvaluator
+{
+public:
+    /// Construct a null evaluator. It matches every record.
+    DQEvaluator();
+
+    /// Compile the filter
+    explicit DQEvaluator(DQWhere where);
+
+    /// Copy constructor
+    DQEvaluator(const DQEvaluator &other);
+
+    /// Assignment operator overloading
+    DQEvaluator &operator=(const DQEvaluator &rhs);
+
+    ~DQEvaluator();
+
+    /// TRUE if it has no filter
+    bool isNull() const;
+
+    /// TRUE if the model fulfill the filter
+    bool match(const DQAbstractModel* model) const;
+
+    /// Get the index of the models in the list which fulfill the filter
+    QVector<int> select(const DQSharedList &list) const;
+
+    /// Get the index of the rows in the result which fulfill the filter
+    QVector<int> select(const DQColumnarResult &result) const;
+
+    /// Call an aggregate function on a field of the matched models
+    /**
+      @param func The function name. count , sum , min , max and avg are supported
+      @param list The records
+      @param field The field name. If it is empty , count() return the no. of matched models.
+      @return The result. Null values are skipped. It is null if no value is found (except count)
+     */
+    QVariant call(QString func,const DQSharedList &list,QString field = QString()) const;
+
+    /// Call an aggregate function on a column of the matched rows
+    /**
+      @see call(QString,const DQSharedList&,QString)
+     */
+    QVariant call(QString func,const DQColumnarResult &result,QString column = QString()) const;
+
+private:
+    QSharedDataPointer<DQEvaluatorPriv> d;
+};
+
+#endif // DQEVALUATOR_H
@@ -2,6 +2,21 @@
 #include <QSharedData>
 #include "dqexpression.h"
 #include "dqwhere_p.h"
+#include "dqsqlstatement.h"
+
+/* Test cases:
+
+  coretests::expression()
+  coretests::largeInList()
+  sqlitetests::largeInList()
+  sqlitetests::fullText()
+
+ */
+
+/// Lists longer than this are bound as a single JSON array by DQWhere::in()
+#ifndef DQ_IN_LIST_THRESHOLD
+#define DQ_IN_LIST_THRESHOLD 64
+#endif
 
 class DQExpressionPriv : public QSharedData {
 public:
@@ -10,8 +25,26 @@ public:
 
     QMap<QString,QVariant> m_values;
 
+    /// The placeholders in order of appearance
+    QStringList m_names;
+
+    /// The values in order of m_names
+    QList<QVariant> m_list;
+
     int m_num;
 
+    /// The prefix of argument name
+    QString m_prefix;
+
+    /// The tables of subqueries
+    QStringList m_tables;
+
+    /// The table of the query
+    QString m_table;
+
+    /// TRUE if a long in-list is bound as a JSON array
+    bool m_jsonInList;
+
     bool m_null;
 
     void process(DQWhere& where);
@@ -26,16 +59,27 @@ public:
 
     /// Bind the values , and return its argument name
     QString bind(QVariant v);
+
+    /// Bind a list as a JSON array for json_each(). It returns an empty string if any value could not be encoded
+    QString bindJson(const QList<QVariant> &list);
+
+    /// Embed a subquery and bind its values under the prefix of this expression
+    QString subquery(DQWhereDataPriv& data);
 };
 
 
 static int typeId = qMetaTypeId<DQWhere>();
 
+static inline bool _dqIsIdentifierChar(QChar c) {
+    return c.isLetterOrNumber() || c == '_';
+}
+
 static int dataPrivTypeId = qMetaTypeId<DQWhereDataPriv>();
 
 DQExpression::DQExpression(){
     d = new DQExpressionPriv();
 
+    d->m_jsonInList = true;
     d->m_null = true;
 }
 
@@ -43,6 +87,40 @@ DQExpression::DQExpression(DQWhere where)
 {
     d = new DQExpressionPriv();
 
+    d->m_prefix = "arg";
+    d->m_jsonInList = true;
+    d->process(where);
+    d->m_null = false;
+}
+
+DQExpression::DQExpression(DQWhere where,QString prefix)
+{
+    d = new DQExpressionPriv();
+
+    d->m_prefix = prefix;
+    d->m_jsonInList = true;
+    d->process(where);
+    d->m_null = false;
+}
+
+DQExpression::DQExpression(DQWhere where,QString prefix,QString table)
+{
+    d = new DQExpressionPriv();
+
+    d->m_prefix = prefix;
+    d->m_table = table;
+    d->m_jsonInList = true;
+    d->process(where);
+    d->m_null = false;
+}
+
+DQExpression::DQExpression(DQWhere where,QString prefix,QString table,bool jsonInList)
+{
+    d = new DQExpressionPriv();
+
+    d->m_prefix = prefix;
+    d->m_table = table;
+    d->m_jsonInList = jsonInList;
     d->process(where);
     d->m_null = false;
 }
@@ -59,22 +137,112 @@ DQExpression & DQExpression::operator=(const DQExpression &rhs){
 DQExpression::~DQExpression(){
 }
 
-bool DQExpression::isNull(){
+bool DQExpression::isNull() const{
     return d->m_null;
 }
 
 
-QString DQExpression::string(){
+QString DQExpression::string() const{
     return d->m_string;
 }
 
+/// Format a value as SQL literal
+static QString _dqSqlLiteral(const QVariant &v) {
+    if (v.isNull())
+        return "NULL";
+
+    switch (v.type()) {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+        return v.toString();
+    case QVariant::Bool:
+        return v.toBool() ? "1" : "0";
+    case QVariant::Double:
+        return QString::number(v.toDouble(),'g',17);
+    case QVariant::ByteArray:
+        return QString("X'%1'").arg(QString::fromLatin1(v.toByteArray().toHex()));
+    default:
+        break;
+    }
+
+    return dqEscape(v.toString());
+}
+
+QString DQExpression::literalString(){
+    QString res;
+    const QString &sql = d->m_string;
+    res.reserve(sql.size());
+
+    int n = sql.size();
+    int i = 0;
+    while (i < n) {
+        QChar c = sql.at(i);
+
+        if (c == '\'') {
+            int end = sql.indexOf('\'',i + 1);
+            while (end >= 0 && end + 1 < n && sql.at(end + 1) == '\'')
+                end = sql.indexOf('\'',end + 2);
+            if (end < 0)
+                end = n - 1;
+            res += sql.mid(i,end - i + 1);
+            i = end + 1;
+            continue;
+        }
+
+        if (c == ':' && i + 1 < n && _dqIsIdentifierChar(sql.at(i + 1))) {
+            int start = i;
+            i++;
+            while (i < n && _dqIsIdentifierChar(sql.at(i)))
+                i++;
+
+            QString name = sql.mid(start,i - start);
+            if (d->m_values.contains(name))
+                res += _dqSqlLiteral(d->m_values.value(name));
+            else
+                res += name;
+            continue;
+        }
+
+        res += c;
+        i++;
+    }
+
+    return res;
+}
+
 QMap<QString,QVariant> DQExpression::bindValues(){
     return d->m_values;
 }
 
+QStringList DQExpression::bindNames(){
+    return d->m_names;
+}
+
+QList<QVariant> DQExpression::bindValueList(){
+    return d->m_list;
+}
+
+QStringList DQExpression::tables(){
+    return d->m_tables;
+}
+
+bool DQExpression::setBindValue(int index,QVariant value){
+    if (index < 0 || index >= d->m_names.size())
+        return false;
+
+    d->m_list[index] = value;
+    d->m_values[d->m_names.at(index)] = value;
+    return true;
+}
+
 void DQExpressionPriv::process(DQWhere& where){
     m_string.clear();
     m_values.clear();
+    m_names.clear();
+    m_list.clear();
+    m_tables.clear();
 
     m_num = 0;
 
@@ -88,6 +256,12 @@ QString DQExpressionPriv::_process(DQWhere& where) {
 
     QString leftString,rightString;
 
+    if (!where.left().isValid()) {
+        // Unary operator (e.g exists)
+        rightString = _process(where.right());
+        return QString("%1 %2").arg(where.op()).arg(rightString);
+    }
+
     leftString = _process(where.left());
     rightString = _process(where.right());
 
@@ -136,6 +310,15 @@ QString DQExpressionPriv::_process(DQWhereDataPriv& data){
         break;
 
     case DQWhereDataPriv::In:
+        if (m_jsonInList && list.size() > DQ_IN_LIST_THRESHOLD) {
+            // A single parameter keeps the statement in the same shape and away from the limit of parameters
+            arg = bindJson(list);
+            if (!arg.isEmpty()) {
+                res = QString("(SELECT value FROM json_each(%1))").arg(arg);
+                break;
+            }
+        }
+
         foreach (v,list) {
             arg = bind(v);
             args << arg;
@@ -143,6 +326,22 @@ QString DQExpressionPriv::_process(DQWhereDataPriv& data){
         res = QString("(%1)").arg(args.join(","));
         break;
 
+    case DQWhereDataPriv::Subquery:
+        res = QString("(%1)").arg(subquery(data));
+        break;
+
+    case DQWhereDataPriv::Match:
+        Q_ASSERT(list.size() == 1);
+        if (m_table.isEmpty()) {
+            qWarning() << "DQExpression - DQWhere::match() is used without the table of query";
+            res = "(NULL)";
+            break;
+        }
+
+        arg = bind(list.at(0));
+        res = QString("(SELECT rowid FROM %1 WHERE %1 MATCH %2)").arg(DQSqlStatement::fullTextTable(m_table)).arg(arg);
+        break;
+
     default:
         qWarning() << "DQWhereDataPriv - Unsupported type";
         break;
@@ -152,7 +351,127 @@ QString DQExpressionPriv::_process(DQWhereDataPriv& data){
 }
 
 QString DQExpressionPriv::bind(QVariant v){
-    QString arg = QString(":arg%1").arg(m_num++);
+    QString arg = QString(":%1%2").arg(m_prefix).arg(m_num++);
     m_values[arg] = v;
+    m_names << arg;
+    m_list << v;
     return arg;
 }
+
+/// Encode a value as JSON. It returns FALSE for the type which can't be compared after the conversion (e.g QByteArray)
+static bool _dqJsonValue(const QVariant &v,QString &res) {
+    if (v.isNull()) {
+        res += "null";
+        return true;
+    }
+
+    switch (v.type()) {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+        res += v.toString();
+        return true;
+    case QVariant::Bool:
+        res += v.toBool() ? '1' : '0';
+        return true;
+    case QVariant::Double:
+        res += QString::number(v.toDouble(),'g',17);
+        return true;
+    case QVariant::ByteArray:
+    case QVariant::UserType:
+        return false;
+    default:
+        break;
+    }
+
+    if (!v.canConvert(QVariant::String))
+        return false;
+
+    QString str = v.toString();
+    res += '"';
+    int n = str.size();
+    for (int i = 0 ; i < n;i++) {
+        QChar c = str.at(i);
+        if (c == '"' || c == '\\') {
+            res += '\\';
+            res += c;
+        } else if (c.unicode() < 0x20) {
+            res += QString("\\u%1").arg(c.unicode(),4,16,QChar('0'));
+        } else {
+            res += c;
+        }
+    }
+    res += '"';
+    return true;
+}
+
+QString DQExpressionPriv::bindJson(const QList<QVariant> &list){
+    QString json;
+    json.reserve(list.size() * 8);
+    json += '[';
+
+    int n = list.size();
+    for (int i = 0 ; i < n;i++) {
+        if (i > 0)
+            json += ',';
+        if (!_dqJsonValue(list.at(i),json))
+            return QString();
+    }
+    json += ']';
+
+    return bind(json);
+}
+
+QString DQExpressionPriv::subquery(DQWhereDataPriv& data){
+    QString sql = data.text();
+    QStringList names = data.names();
+    QList<QVariant> values = data.list();
+
+    foreach (QString table , data.tables()) {
+        if (!m_tables.contains(table))
+            m_tables << table;
+    }
+
+    // Rename the placeholders, so that they would not clash with the outer query
+    QString res;
+    res.reserve(sql.size());
+    int n = sql.size();
+    int i = 0;
+    while (i < n) {
+        QChar c = sql.at(i);
+
+        if (c == '\'') {
+            int end = sql.indexOf('\'',i + 1);
+            while (end >= 0 && end + 1 < n && sql.at(end + 1) == '\'')
+                end = sql.indexOf('\'',end + 2);
+            if (end < 0)
+                end = n - 1;
+            res += sql.mid(i,end - i + 1);
+            i = end + 1;
+            continue;
+        }
+
+        if (c == ':' && i + 1 < n && _dqIsIdentifierChar(sql.at(i + 1))) {
+            int start = i;
+            i++;
+            while (i < n && _dqIsIdentifierChar(sql.at(i)))
+                i++;
+
+            QString name = sql.mid(start,i - start);
+            int index = names.indexOf(name);
+            if (index >= 0) {
+                res += bind(values.at(index));
+            } else {
+                qWarning() << QString("DQExpression - Unknown placeholder %1 in subquery").arg(name);
+                res += name;
+            }
+            continue;
+        }
+
+        res += c;
+        i++;
+    }
+
+    return res;
+}
@@ -3,6 +3,7 @@
 
 #include <dqwhere.h>
 #include <QMap>
+#include <QStringList>
 #include <QSharedDataPointer>
 
 class DQExpressionPriv;
@@ -17,17 +18,62 @@ public:
     DQExpression();
     DQExpression(const DQExpression& rhs);
     DQExpression(DQWhere where);
+
+    /// Construct an expression which bind the values with a custom prefix
+    /**
+      @param where The expression
+      @param prefix The prefix of the argument name. The default one is "arg", which generates ":arg0" , ":arg1" ...
+
+      It is used for combining several expressions in a single statement.
+     */
+    DQExpression(DQWhere where,QString prefix);
+
+    /// Construct an expression of a query on a table
+    /**
+      @param table The table of the query. It is needed by DQWhere::match() to find the full text index.
+     */
+    DQExpression(DQWhere where,QString prefix,QString table);
+
+    /// Construct an expression of a query on a table for a SQL dialect
+    /**
+      @param jsonInList TRUE if a long DQWhere::in() list is bound as a JSON array for json_each().
+      Otherwise each value is bound as a separated parameter.
+     */
+    DQExpression(DQWhere where,QString prefix,QString table,bool jsonInList);
+
     DQExpression &operator=(const DQExpression &rhs);
 
     ~DQExpression();
 
     /// Get the expression in string
-    QString string();
+    QString string() const;
+
+    /// Get the expression in string with the bound values written as SQL literals
+    /**
+      It is used where parameters are not allowed , e.g the terms of an index.
+     */
+    QString literalString();
 
     /// A map of values to find with QSqlQuery
     QMap<QString,QVariant> bindValues();
 
-    bool isNull();
+    /// The name of placeholders in the order of appearance
+    QStringList bindNames();
+
+    /// The values of placeholders in the order of bindNames()
+    QList<QVariant> bindValueList();
+
+    /// Replace the value of a placeholder
+    /**
+      @param index The position of placeholder in bindNames()
+      @return FALSE if the index is out of range
+     */
+    bool setBindValue(int index,QVariant value);
+
+    /// The tables read by the subqueries of the expression
+    QStringList tables();
+
+    bool isNull() const;
 
 private:
 
@@ -69,12 +69,10 @@ static QString unescape(QString value) {
     return result;
 }
 
-template <>
-bool DQField<QStringList>::set(QVariant value){
-    QString str;
-
+/// Split the string stored in database to QStringList
+static QVariant stringListFromString(QVariant value) {
     if (value.type() == QVariant::String) {
-        str = value.toString();
+        QString str = value.toString();
         QStringList list = str.split(SEP);
         QStringList result;
 
@@ -84,16 +82,12 @@ bool DQField<QStringList>::set(QVariant value){
 
         value = result;
     }
-
-//    qDebug() << __func__ << str;
-    return DQBaseField::set(value);;
+    return value;
 }
 
-template <>
-QVariant DQField<QStringList>::get(bool convert) const {
-    QVariant val = DQBaseField::get(convert);
-
-    if (convert && val.type() == QVariant::StringList ) {
+/// Join the QStringList to a string for saving
+static QVariant stringListToString(QVariant val) {
+    if (val.type() == QVariant::StringList ) {
         QStringList list = val.toStringList();
         QStringList result;
         QString str;
@@ -105,7 +99,44 @@ QVariant DQField<QStringList>::get(bool convert) const {
         str = result.join(SEP);
         val = str;
     }
-//    qDebug() << __func__ << str << list;
+    return val;
+}
+
+template <>
+bool DQField<QStringList>::set(QVariant value){
+    return DQVariantField::set(stringListFromString(value));
+}
+
+template <>
+QVariant DQField<QStringList>::get(bool convert) const {
+    QVariant val = DQVariantField::get(convert);
+
+    if (convert)
+        val = stringListToString(val);
+
+    return val;
+}
+
+template <>
+bool DQTypedField<QStringList>::set(QVariant value){
+    value = stringListFromString(value);
+    if (value.isNull()) {
+        clear();
+    } else {
+        setValue(value.toStringList());
+    }
+    return true;
+}
+
+template <>
+QVariant DQTypedField<QStringList>::get(bool convert) const {
+    if (isNull())
+        return QVariant();
+
+    QVariant val = value();
+
+    if (convert)
+        val = stringListToString(val);
 
     return val;
 }
@@ -14,7 +14,7 @@
  */
 
 template <typename T>
-class DQField : public DQBaseField
+class DQField : public DQVariantField
 {
 public:
     /// Default constructor
@@ -69,12 +69,12 @@ public:
 
     /// Get the value of the field
     inline QVariant get(bool convert = false) const {
-        return DQBaseField::get(convert);
+        return DQVariantField::get(convert);
     }
 
     /// Set the value of the field
     inline bool set(QVariant value) {
-        return DQBaseField::set(value);
+        return DQVariantField::set(value);
     }
 
     /// Cast it to the template type
@@ -91,6 +91,162 @@ bool DQField<QStringList>::set(QVariant value);
 template <>
 QVariant DQField<QStringList>::get(bool convert) const;
 
+/// Database field with typed storage
+/**
+    DQTypedField store the value as its template type plus a null flag
+    instead of QVariant. The value is converted to / from QVariant only
+    when it is written to or read from database, the access in C++ code
+    do not need any type dispatch or heap allocation.
+
+    It could be used in place of DQField. As the stored value is not a
+    QVariant, operator-> provides access to the template type.
+
+\code
+class User : public DQModel {
+    DQ_MODEL
+public:
+    DQTypedField<QString> name;
+    DQTypedField<int> karma;
+};
+
+    User user;
+    user.name = "tester";
+    qDebug() << user.name->size(); // QString::size()
+\endcode
+
+    @see DQField
+ */
+template <typename T>
+class DQTypedField : public DQBaseField
+{
+public:
+    /// Default constructor. The field is null.
+    DQTypedField() : m_value() , m_isNull(true) {
+    }
+
+    /// Return the type id of the field
+    static QVariant::Type type(){
+        return (QVariant::Type) qMetaTypeId<T>();
+    }
+
+    /// Set the value of the field. A null QVariant will clear the field.
+    bool set(QVariant value) {
+        if (value.isNull()) {
+            clear();
+        } else {
+            m_value = qvariant_cast<T>(value);
+            m_isNull = false;
+            m_dirty = true;
+            m_deferred = false;
+        }
+        return true;
+    }
+
+    /// Get the value of the field. It is a null QVariant if the field is null.
+    QVariant get(bool convert = false) const {
+        Q_UNUSED(convert);
+        ensureLoaded();
+        if (m_isNull)
+            return QVariant();
+        return qVariantFromValue(m_value);
+    }
+
+    /// Get the stored value
+    inline const T& value() const {
+        ensureLoaded();
+        return m_value;
+    }
+
+    /// Set the stored value. The field will become non-null.
+    inline void setValue(const T& value) {
+        m_value = value;
+        m_isNull = false;
+        m_dirty = true;
+        m_deferred = false;
+    }
+
+    /// TRUE if the field is null
+    inline bool isNull() const {
+        ensureLoaded();
+        return m_isNull;
+    }
+
+    /// Set the field to null
+    inline void clear() {
+        m_value = T();
+        m_isNull = true;
+        m_dirty = true;
+        m_deferred = false;
+    }
+
+    /// Assign a value of template type
+    inline DQTypedField& operator=(const T& value) {
+        setValue(value);
+        return *this;
+    }
+
+    /// Assign a string
+    inline DQTypedField& operator=(const char* string) {
+        set(QString(string));
+        return *this;
+    }
+
+    /// Copy the value from a QVariant object
+    inline QVariant operator=(const QVariant &val){
+        set(val);
+        return val;
+    }
+
+    /// Provides access to stored value
+    inline const T* operator->() const {
+        ensureLoaded();
+        return &m_value;
+    }
+
+    /// Get the value of the field
+    inline T operator() () const {
+        ensureLoaded();
+        return m_value;
+    }
+
+    /// Cast it to the template type
+    inline operator T() const {
+        ensureLoaded();
+        return m_value;
+    }
+
+    /// Compare with its template type. A null field is not equal to any value.
+    inline bool operator==(const T& t) const {
+        ensureLoaded();
+        return !m_isNull && m_value == t;
+    }
+
+    /// Compare with its template type
+    inline bool operator!=(const T& t) const {
+        return !operator==(t);
+    }
+
+    /// Compare with string type
+    inline bool operator==(const char *string) const {
+        return get() == QString(string);
+    }
+
+    /// Compare with string type
+    inline bool operator!=(const char *string) const {
+        return get() != QString(string);
+    }
+
+private:
+    T m_value;
+    bool m_isNull;
+};
+
+template <>
+bool DQTypedField<QStringList>::set(QVariant value);
+
+template <>
+QVariant DQTypedField<QStringList>::get(bool convert) const;
+
 /// Primary key field
 
 class DQPrimaryKey : public DQField<int> {
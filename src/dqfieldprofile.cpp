@@ -0,0 +1,50 @@
+#include <QtCore>
+#include "dqfieldprofile_p.h"
+#include "dqmodelmetainfo.h"
+
+/* Test cases:
+
+  sqlitetests::autoOnly()
+
+ */
+
+_DQFieldProfile::_DQFieldProfile(int samples) : m_samples(samples) , m_executions(0) {
+}
+
+_DQFieldProfile* _DQFieldProfile::profile(const QString &key,int samples){
+    static QMutex mutex;
+    static QHash<QString,_DQFieldProfile*> profiles;
+
+    QMutexLocker locker(&mutex);
+    _DQFieldProfile *res = profiles.value(key);
+    if (!res) {
+        res = new _DQFieldProfile(samples);
+        profiles.insert(key,res);
+    }
+    return res;
+}
+
+bool _DQFieldProfile::sample(){
+    QMutexLocker locker(&m_mutex);
+    if (m_executions >= m_samples)
+        return false;
+    m_executions++;
+    return true;
+}
+
+void _DQFieldProfile::access(int index){
+    QMutexLocker locker(&m_mutex);
+    m_accessed.insert(index);
+}
+
+QStringList _DQFieldProfile::fields(DQModelMetaInfo *metaInfo){
+    QMutexLocker locker(&m_mutex);
+    QStringList res;
+    int n = metaInfo->size();
+    for (int i = 0 ; i < n;i++) {
+        const DQModelMetaInfoField *field = metaInfo->at(i);
+        if (field->name == "id" || m_accessed.contains(i))
+            res << field->name;
+    }
+    return res;
+}
@@ -0,0 +1,45 @@
+#ifndef DQFIELDPROFILE_P_H
+#define DQFIELDPROFILE_P_H
+
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+
+class DQModelMetaInfo;
+
+/// The fields accessed by the records of a query
+/**
+  It is used by DQSharedQuery::autoOnly(). The first executions of the query
+  are sampled: all the fields are read, and the access of each field is
+  recorded. Then the query only reads the accessed fields, the others are
+  deferred. A deferred field loaded later is recorded too, so it is read
+  by the next execution.
+
+  The profile is shared by the queries of the same statement. It is
+  created on first use and never deleted, as the hydrated records keep
+  a pointer to it.
+ */
+class _DQFieldProfile {
+public:
+    explicit _DQFieldProfile(int samples);
+
+    /// Find or create the profile of a statement
+    static _DQFieldProfile* profile(const QString &key,int samples);
+
+    /// Count an execution. TRUE if it is sampled
+    bool sample();
+
+    /// Record the access of a field by its index
+    void access(int index);
+
+    /// The accessed fields in declaration order. The id is always included
+    QStringList fields(DQModelMetaInfo *metaInfo);
+
+private:
+    QMutex m_mutex;
+    int m_samples;
+    int m_executions;
+    QSet<int> m_accessed;
+};
+
+#endif // DQFIELDPROFILE_P_H
@@ -1,8 +1,13 @@
 #ifndef DQFOREIGNKEY_H
 #define DQFOREIGNKEY_H
 
+#include <QSharedData>
+#include <QExplicitlySharedDataPointer>
 #include <dqfield.h>
 #include <dqquery.h>
+#ifdef Q_COMPILER_RVALUE_REFS
+#include <utility>
+#endif
 
 /// Foreign key field
 /** DQForeignKey is a special kind of DQField which can declare
@@ -76,18 +81,90 @@ To link with other record, it is just need to use the "=" operator
     friendship.b = user; // friendship.b will store the primary key of "user"
 \endcode
 
+<b>Prefetch</b>
+
+Auto loading runs a query per foreign key. If the "linked" records of a
+list of models are going to be accessed, use DQSharedQuery::prefetch() to
+load all of them by a single query per relation, or
+DQSharedQuery::selectRelated() to read them in the same query by a JOIN.
+
+ */
+
+/// The base class of DQForeignKey
+/**
+  It provides a type independent interface to access the "linked"
+  model. User should not use this class directly.
  */
+class DQBaseForeignKey : public DQField<int> {
+public:
+    /// Set the "linked" model by copying other one
+    /**
+      @param model A model instance of the linked type. It must have the same id as the key.
+     */
+    virtual void setLinkedModel(const DQAbstractModel *model) = 0;
+
+    /// Get the instance of "linked" model without loading. It is created if it is not existed.
+    virtual DQAbstractModel* linkedModel() = 0;
+};
+
+/// The "linked" model shared by the copies of a DQForeignKey
+template <typename T>
+class _DQLinkedModel : public QSharedData {
+public:
+    inline _DQLinkedModel() {
+    }
+
+    inline _DQLinkedModel(const T &rhs) : model(rhs) {
+    }
+
+    inline _DQLinkedModel(const _DQLinkedModel &rhs) : QSharedData(rhs) , model(rhs.model) {
+    }
+
+    T model;
+};
+
 template <typename T>
-class DQForeignKey : public DQField<int> {
+class DQForeignKey : public DQBaseForeignKey {
 public:
     /// Construct a foreign key field
-    DQForeignKey() : model(0){
+    DQForeignKey() {
+    }
+
+    /// Copy constructor.
+    /**
+      The "linked" model is shared with rhs. It is copied on
+      the first access through operator->() / operator()() ,
+      so copying a key (and the model contains it) is O(1).
+     */
+    DQForeignKey(const DQForeignKey& rhs) : DQBaseForeignKey(rhs) , d(rhs.d) {
     }
 
+#ifdef Q_COMPILER_RVALUE_REFS
+    /// Move constructor. The "linked" model is taken from rhs.
+    DQForeignKey(DQForeignKey&& rhs) : DQBaseForeignKey(std::move(rhs)) {
+        d.swap(rhs.d);
+    }
+
+    /// Move assignment. The "linked" model is taken from rhs.
+    DQForeignKey& operator=(DQForeignKey&& rhs) {
+        DQBaseForeignKey::operator=(std::move(rhs));
+        d.swap(rhs.d);
+        return *this;
+    }
+#endif
+
     /// Destruct the foreign key field
     ~DQForeignKey() {
-        if (model)
-            delete model;
+    }
+
+    /// Copy from other DQForeignKey object. The "linked" model is shared until it is accessed.
+    DQForeignKey& operator=(const DQForeignKey& rhs) {
+        if (this == &rhs)
+            return *this;
+        set(rhs.get());
+        d = rhs.d;
+
+        return *this;
     }
 
     /// Copy from other DQForeignKey object.
@@ -97,11 +174,7 @@ public:
      */
     DQForeignKey& operator=(T& rhs) {
         set(rhs.id());
-        if (model){
-            delete model;
-            model = 0;
-        }
-        model = new T(rhs);
+        d = new _DQLinkedModel<T>(rhs);
 
         return *this;
     }
@@ -115,22 +188,20 @@ public:
 
     /// Access the data field of the "linked" model
     T* operator->() {
-        if (!model)
-            model = new T();
+        detach();
         if ( !get().isNull() &&  !isLoaded()  ) {
             load();
         }
-        return model;
+        return &d->model;
     }
 
     /// Return an instance of the "linked" model
     T& operator() () {
-        if (!model)
-            model = new T();
+        detach();
         if ( !get().isNull() &&  !isLoaded() ) {
             load();
         }
-        return *model;
+        return d->model;
     }
 
     static DQClause clause() {
@@ -141,34 +212,45 @@ public:
     /// TRUE if the model is already loaded.
     inline bool isLoaded() {
         bool res = false;
-        if (!model)
+        if (!d)
             return res;
         if ( !get().isNull()
-            && !model->id().isNull()
-            && get() == model->id() ) {
+            && !d->model.id().isNull()
+            && get() == d->model.id() ) {
             res = true;
         }
         return res;
     }
 
+    void setLinkedModel(const DQAbstractModel *other) {
+        Q_ASSERT(other->metaInfo() == dqMetaInfo<T>());
+        d = new _DQLinkedModel<T>(*static_cast<const T*>(other));
+    }
+
+    DQAbstractModel* linkedModel() {
+        detach();
+        return &d->model;
+    }
+
 private:
     bool load();
-    T *model;
+
+    /// Create the "linked" model if it is not existed , or copy it if it is shared by other key
+    inline void detach() {
+        if (!d)
+            d = new _DQLinkedModel<T>();
+        else
+            d.detach();
+    }
+
+    QExplicitlySharedDataPointer<_DQLinkedModel<T> > d;
 
 };
 
 template<typename T>
 bool DQForeignKey<T>::load() {
-    bool res = false;
-    DQQuery<T> query = DQQuery<T>().filter(DQWhere("id","=", get()  ) ).limit(1);
-    if ( query.exec() ){
-        if (query.next() ) {
-            query.recordTo(*model);
-            res = true;
-        }
-    }
-
-    return res;
+    DQQuery<T> query = DQQuery<T>().filter(DQWhere("id","=", get()  ) );
+    return query.get(d->model);
 }
 
 
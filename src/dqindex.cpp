@@ -1,8 +1,17 @@
 #include "dqindex.h"
+#include "dqexpression.h"
+
+/* Test cases:
+
+  coretests::expressionIndex()
+  sqlitetests::generatedColumn()
+
+ */
 
 DQBaseIndex::DQBaseIndex(DQModelMetaInfo* metaInfo, QString name) :
     m_metaInfo(metaInfo),
-    m_name(name)
+    m_name(name),
+    m_unique(false)
 {
 }
 
@@ -26,3 +35,28 @@ DQBaseIndex& DQBaseIndex::operator<<(QString columnDef){
     m_columnDefList << columnDef;
     return *this;
 }
+
+DQBaseIndex& DQBaseIndex::operator<<(DQWhere expression){
+    m_columnDefList << DQExpression(expression).literalString();
+    return *this;
+}
+
+bool DQBaseIndex::isUnique() const{
+    return m_unique;
+}
+
+void DQBaseIndex::setUnique(bool unique){
+    m_unique = unique;
+}
+
+QString DQBaseIndex::where() const{
+    return m_where;
+}
+
+void DQBaseIndex::setWhere(QString where){
+    m_where = where;
+}
+
+void DQBaseIndex::setWhere(DQWhere where){
+    m_where = DQExpression(where).literalString();
+}
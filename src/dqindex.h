@@ -4,6 +4,7 @@
 #include <QObject>
 #include <QString>
 #include <dqmodelmetainfo.h>
+#include <dqwhere.h>
 
 /// The based class of DQIndex
 class DQBaseIndex
@@ -30,6 +31,42 @@ public:
     /// Append column definition through operator<< overloading
     DQBaseIndex& operator<<(QString columnDef);
 
+    /// Append an expression as the index term
+    /**
+      The values of the expression are written as literals, as parameters are not allowed
+      in index. A filter could be served by the index if it has the same expression.
+
+\code
+    DQIndex<User> index("user_email");
+    index << DQWhere("lower(email)");
+
+    DQIndex<Event> byDay("event_day");
+    byDay << DQWhere("created") / 86400; // created / 86400
+
+    // Served by the indexes
+    DQQuery<User>().filter(DQWhere("lower(email)") == "ben@example.com");
+    DQQuery<Event>().filter(DQWhere("created / 86400") == 16000);
+\endcode
+
+      @remarks SQLite matches the expression including its constants , so the constant of the filter should be written in the expression instead of being bound.
+     */
+    DQBaseIndex& operator<<(DQWhere expression);
+
+    /// TRUE if it is an UNIQUE index
+    bool isUnique() const;
+
+    /// Set to create an UNIQUE index
+    void setUnique(bool unique);
+
+    /// The condition of partial index
+    QString where() const;
+
+    /// Set the condition of partial index. Only the rows fulfill the condition are indexed.
+    void setWhere(QString where);
+
+    /// Set the condition of partial index by expression
+    void setWhere(DQWhere where);
+
 protected:
 
 private:
@@ -37,6 +74,9 @@ private:
 
     QString m_name;
     QStringList m_columnDefList;
+
+    bool m_unique;
+    QString m_where;
 };
 
 /// SQL Indexing information
@@ -0,0 +1,195 @@
+#include <QtCore>
+#include <algorithm>
+#include <QRegExp>
+#include "dqindexadvisor.h"
+#include "dqqueryplan.h"
+#include "dqsharedquery_p.h"
+#include "dqconnection.h"
+#include "dqsql.h"
+#include "dqsqlstatement.h"
+
+/* Test cases:
+
+  sqlitetests::explain()
+
+ */
+
+static int typeId = qMetaTypeId<DQWhere>();
+
+/// The name of field if the value is a field node
+static QString _dqFieldName(QVariant value) {
+    if (value.userType() != typeId)
+        return QString();
+
+    DQWhere where = value.value<DQWhere>();
+    if (!where.isField())
+        return QString();
+    return where.toString();
+}
+
+/// Collect the columns compared in the "AND" terms of a filter
+static void _dqCollectColumns(DQWhere where,QStringList *equal,QStringList *range) {
+    if (where.isNull() || where.isField())
+        return;
+
+    QString op = where.op().trimmed().toLower();
+
+    if (op == "and") {
+        if (where.left().userType() == typeId)
+            _dqCollectColumns(where.left().value<DQWhere>(),equal,range);
+        if (where.right().userType() == typeId)
+            _dqCollectColumns(where.right().value<DQWhere>(),equal,range);
+        return;
+    }
+
+    // The column compared with an expression of other column could not use index
+    QString field = _dqFieldName(where.left());
+    if (field.isEmpty() || where.right().userType() == typeId)
+        return;
+
+    if (op == "=" || op == "==" || op == "in" || op == "is") {
+        if (!equal->contains(field))
+            equal->append(field);
+    } else if (op == "<" || op == "<=" || op == ">" || op == ">=" ||
+               op == "between" || op == "like" || op == "glob") {
+        if (!range->contains(field))
+            range->append(field);
+    }
+}
+
+DQBaseIndex DQIndexAdvisor::Advice::index() const{
+    DQBaseIndex res(metaInfo,name);
+    res.setColumnDefList(columns);
+    return res;
+}
+
+DQIndexAdvisor::DQIndexAdvisor(){
+}
+
+QStringList DQIndexAdvisor::indexColumns(DQSharedQuery query){
+    QStringList res;
+    DQModelMetaInfo *metaInfo = query.data->metaInfo;
+    if (!metaInfo)
+        return res;
+
+    QStringList equal;
+    QStringList range;
+    _dqCollectColumns(query.data->where,&equal,&range);
+
+    // A lookup by primary key do not need other index
+    if (equal.contains("id"))
+        return res;
+
+    foreach (QString field , equal) {
+        if (metaInfo->indexOf(field) >= 0)
+            res << field;
+    }
+
+    QString rangeField;
+    foreach (QString field , range) {
+        if (metaInfo->indexOf(field) >= 0 && !res.contains(field)) {
+            rangeField = field;
+            break;
+        }
+    }
+
+    if (!rangeField.isEmpty()) {
+        // The rows are not sorted by the columns after a range column
+        res << rangeField;
+    } else {
+        foreach (QString term , query.data->orderBy) {
+            QString field = term.trimmed().split(QRegExp("\\s+")).at(0);
+            if (field == "id" || metaInfo->indexOf(field) < 0 || res.contains(field))
+                break;
+            res << field;
+        }
+    }
+
+    return res;
+}
+
+bool DQIndexAdvisor::analyze(DQSharedQuery query){
+    DQModelMetaInfo *metaInfo = query.data->metaInfo;
+    if (!metaInfo)
+        return false;
+
+    QString sql = query.statement();
+
+    QHash<QString,int>::const_iterator iter = m_analyzed.constFind(sql);
+    if (iter != m_analyzed.constEnd()) {
+        int index = iter.value();
+        if (index < 0)
+            return false;
+        m_advices[index].hits++;
+        return true;
+    }
+
+    DQQueryPlan plan = query.explain();
+    QString table = metaInfo->name();
+
+    bool fullScan = false;
+    foreach (QString name , plan.fullScanTables()) {
+        if (name.compare(table,Qt::CaseInsensitive) == 0)
+            fullScan = true;
+    }
+
+    QStringList columns;
+    if (fullScan)
+        columns = indexColumns(query);
+
+    if (columns.isEmpty()) {
+        m_analyzed.insert(sql,-1);
+        return false;
+    }
+
+    QString key = QString("%1(%2)").arg(table).arg(columns.join(","));
+    int index = m_index.value(key,-1);
+    if (index < 0) {
+        Advice advice;
+        advice.metaInfo = metaInfo;
+        advice.name = QString("dq_%1_%2").arg(table).arg(columns.join("_"));
+        advice.columns = columns;
+        advice.sql = sql;
+        advice.statement = query.data->connection.sql().statement()->createIndexIfNotExists(advice.index());
+
+        index = m_advices.size();
+        m_advices << advice;
+        m_index.insert(key,index);
+    }
+
+    m_advices[index].hits++;
+    m_analyzed.insert(sql,index);
+
+    return true;
+}
+
+static bool _dqAdviceGreaterThan(const DQIndexAdvisor::Advice &a,const DQIndexAdvisor::Advice &b) {
+    return a.hits > b.hits;
+}
+
+QList<DQIndexAdvisor::Advice> DQIndexAdvisor::advices() const{
+    QList<Advice> res = m_advices;
+    std::stable_sort(res.begin(),res.end(),_dqAdviceGreaterThan);
+    return res;
+}
+
+bool DQIndexAdvisor::apply(DQConnection connection){
+    bool res = true;
+    foreach (const Advice &advice , m_advices) {
+        if (!connection.createIndex(advice.index())) {
+            qWarning() << QString("DQIndexAdvisor::apply() - Failed to create index %1").arg(advice.name);
+            res = false;
+        }
+    }
+    return res;
+}
+
+int DQIndexAdvisor::analyzedCount() const{
+    return m_analyzed.size();
+}
+
+void DQIndexAdvisor::clear(){
+    m_advices.clear();
+    m_index.clear();
+    m_analyzed.clear();
+}
@@ -0,0 +1,114 @@
+#ifndef DQINDEXADVISOR_H
+#define DQINDEXADVISOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QHash>
+#include <dqindex.h>
+#include <dqsharedquery.h>
+
+class DQConnection;
+
+/// Propose the missing index of queries
+/**
+  DQIndexAdvisor runs DQSharedQuery::explain() on the queries. If the table
+  of the query is visited by a full table scan , it proposes an index over the
+  filtered and ordered columns:
+
+  - The columns compared by = , in() and is() in the "AND" terms of the filter
+  - Then the first column compared by range ( < , <= , > , >= , between() , like() )
+  - Or , without a range column , the orderBy() columns
+
+  A statement is only explained once , so the advisor could be installed on
+  a connection by DQConnection::setIndexAdvisor() to watch every query run by
+  DQSharedQuery in development build.
+
+  Example:
+\code
+    DQIndexAdvisor advisor;
+    connection.setIndexAdvisor(&advisor);
+
+    // Run the application...
+
+    foreach (DQIndexAdvisor::Advice advice , advisor.advices()) {
+        qDebug() << advice.hits << advice.statement;
+    }
+    advisor.apply(connection); // Or create the indexes
+\endcode
+
+  @remarks The advisor do not check the existing indexes , it only reports the query is not served by any of them.
+ */
+class DQIndexAdvisor
+{
+public:
+    /// A proposed index
+    class Advice {
+    public:
+        inline Advice() {
+            metaInfo = 0;
+            hits = 0;
+        }
+
+        /// The model of the table
+        DQModelMetaInfo* metaInfo;
+
+        /// The proposed index name
+        QString name;
+
+        /// The indexed columns in order
+        QStringList columns;
+
+        /// No. of analyzed statements which could use the index
+        int hits;
+
+        /// The first statement which need the index
+        QString sql;
+
+        /// The "CREATE INDEX" statement
+        QString statement;
+
+        /// The index definition which could be passed to DQConnection::createIndex()
+        DQBaseIndex index() const;
+    };
+
+    DQIndexAdvisor();
+
+    /// Explain a query and propose an index if the table is fully scanned
+    /**
+      @return TRUE if the query need an index
+     */
+    bool analyze(DQSharedQuery query);
+
+    /// The proposed indexes sorted by hits in descending order
+    QList<Advice> advices() const;
+
+    /// Create all the proposed indexes
+    /**
+      @return TRUE if all of them are created
+     */
+    bool apply(DQConnection connection);
+
+    /// No. of distinct statement analyzed
+    int analyzedCount() const;
+
+    /// Remove all the advices and analyzed statements
+    void clear();
+
+    /// The columns to be indexed for a query
+    /**
+      @return The columns or an empty list if no column could be indexed
+     */
+    static QStringList indexColumns(DQSharedQuery query);
+
+private:
+    QList<Advice> m_advices;
+
+    /// Index of m_advices by table and columns
+    QHash<QString,int> m_index;
+
+    /// The index of advice of analyzed statements. -1 if no index is needed
+    QHash<QString,int> m_analyzed;
+};
+
+#endif // DQINDEXADVISOR_H
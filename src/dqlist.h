@@ -6,6 +6,9 @@
 #include <dqabstractmodel.h>
 #include <dqmodelmetainfo.h>
 #include <dqsharedlist.h>
+#ifdef Q_COMPILER_RVALUE_REFS
+#include <utility>
+#endif
 
 /// Storage of a list of model item instance
 /**
@@ -75,6 +78,21 @@ public:
         return res;
     }
 
+#ifdef Q_COMPILER_RVALUE_REFS
+    /// Append a model to the list.
+    /**
+      @param model The input model. It is moved to a new instance stored in the list.
+     */
+    bool append(T&& model) {
+        T* t = new T(std::move(model));
+        bool res = DQSharedList::append(t);
+        if (!res) {
+            delete t;
+        }
+        return res;
+    }
+#endif
+
     /// Append a model to the list.
     /**
       @param model The input model. Ownership will be taken.
@@ -84,6 +102,20 @@ public:
         return DQSharedList::append(model);
     }
 
+    /// Merge the lists sorted by a field into a single sorted list
+    /**
+      @see DQSharedList::merge()
+     */
+    static DQList merge(QList<DQList> lists,QString field,Qt::SortOrder order = Qt::AscendingOrder,int limit = -1) {
+        QList<DQSharedList> input;
+        foreach (DQList list , lists) {
+            input << list;
+        }
+        DQList res = DQSharedList::merge(input,field,order,limit);
+        res.setMetaInfo(dqMetaInfo<T>());
+        return res;
+    }
+
     /// Cast it to DQSharedList
     operator DQSharedList() {
         DQSharedList res (*this);
@@ -100,13 +132,13 @@ inline QDebug operator<< (QDebug d, const DQList<T>& rhs ){
     for (int i = 0 ; i < n;i++) {
         DQAbstractModel *model = rhs.at(i);
         metaInfo = model->metaInfo();
-        QStringList fields = metaInfo->fieldNameList();
         QStringList col;
-        foreach (QString field,fields){
-            QVariant value = metaInfo->value(model,field);
+        int count = metaInfo->size();
+        for (int j = 0 ; j < count;j++){
+            QVariant value = metaInfo->value(model,j);
             if (value.isNull())
                 continue;
-            col << QString("%1=%2").arg(field).arg(value.toString());
+            col << QString("%1=%2").arg(metaInfo->at(j)->name).arg(value.toString());
         }
 
         QString res = QString("(%2)")
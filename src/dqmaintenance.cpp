@@ -0,0 +1,252 @@
+#include <QtCore>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include "dqmaintenance_p.h"
+#include "dqsql.h"
+
+/* Test cases:
+
+  sqlitetests::maintenance()
+
+ */
+
+/// The max. no. of intervals the tasks could be postponed by a busy connection
+#ifndef DQ_MAINTENANCE_MAX_DEFERRAL
+#define DQ_MAINTENANCE_MAX_DEFERRAL 10
+#endif
+
+/// Read the first column of a PRAGMA
+static QString _dqPragma(QSqlDatabase db,const QString &name) {
+    QSqlQuery q(db);
+    if (!q.exec(QString("PRAGMA %1;").arg(name)) || !q.next())
+        return QString();
+    return q.value(0).toString();
+}
+
+static qint64 _dqTotal(const QHash<QString,qint64> &counts) {
+    qint64 res = 0;
+    QHashIterator<QString,qint64> iter(counts);
+    while (iter.hasNext()) {
+        iter.next();
+        res += iter.value();
+    }
+    return res;
+}
+
+_DQMaintenance::_DQMaintenance(DQConnection* base,const DQMaintenanceOptions &options,_DQCheckpointer* checkpointer) :
+    _DQCloneThread(base,"dqmaintenance","maintenance thread") , m_sql(base->sql()) , m_options(options) ,
+    m_deferred(0) , m_wal(false) , m_incrementalVacuum(false) ,
+    m_checkpointer(checkpointer) , m_hookHandle(0) , m_autoCheckpoint(0) , m_checkpointFrames(0) ,
+    m_profiler(-1) ,
+    m_requested(0) , m_served(0) , m_checkpointRequested(false) {
+
+    // The writes before the maintenance is enabled are not counted
+    m_analyzed = m_sql.writeCounts();
+    m_lastTotal = _dqTotal(m_analyzed);
+    m_vacuumed = m_lastTotal;
+    m_checkpointed = m_lastTotal;
+
+    startClone(QThread::IdlePriority);
+
+    QSqlDatabase db = m_sql.database();
+    if (m_options.checkpointSize > 0 && _dqPragma(db,"journal_mode").toLower() == "wal") {
+        int pageSize = qMax(_dqPragma(db,"page_size").toInt() , 1);
+        m_checkpointFrames = (int) qMax(m_options.checkpointSize / pageSize , Q_INT64_C(1));
+        m_autoCheckpoint = _dqPragma(db,"wal_autocheckpoint").toInt();
+
+#ifdef DQ_SQLITE_API
+        // It replaces the automatic checkpoint
+        m_hookHandle = _dqSqliteHandle(db);
+        if (m_hookHandle)
+            sqlite3_wal_hook(m_hookHandle,walHook,this);
+#endif
+        // Without the hook the size of WAL is polled on every interval
+    }
+}
+
+_DQMaintenance::~_DQMaintenance(){
+#ifdef DQ_SQLITE_API
+    // The handle is released if the database is closed already
+    if (m_hookHandle && _dqSqliteHandle(m_sql.database()) == m_hookHandle)
+        sqlite3_wal_autocheckpoint(m_hookHandle,m_autoCheckpoint); // The hook is removed
+#endif
+
+    stopClone();
+}
+
+void _DQMaintenance::stopping(){
+    m_done.wakeAll();
+}
+
+void _DQMaintenance::runNow(){
+    QMutexLocker locker(&m_mutex);
+    int ticket = ++m_requested;
+    m_wake.wakeAll();
+
+    while (!m_stop && m_served - ticket < 0)
+        m_done.wait(&m_mutex);
+}
+
+QList<DQQueryStats> _DQMaintenance::stats(){
+    QMutexLocker locker(&m_statsMutex);
+    return m_profiler.stats();
+}
+
+void _DQMaintenance::process(){
+    if (m_connection.isOpen()) {
+        QSqlDatabase db = m_connection.sql().database();
+        m_wal = _dqPragma(db,"journal_mode").toLower() == "wal";
+        m_incrementalVacuum = _dqPragma(db,"auto_vacuum") == "2";
+        if (m_options.analysisLimit >= 0)
+            _dqPragma(db,QString("analysis_limit = %1").arg(m_options.analysisLimit));
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+
+    m_mutex.lock();
+    while (!m_stop) {
+        if (m_served == m_requested && !m_checkpointRequested) {
+            if (m_options.interval > 0)
+                m_wake.wait(&m_mutex,(unsigned long) qMax(m_options.interval - clock.elapsed() , Q_INT64_C(0)));
+            else
+                m_wake.wait(&m_mutex);
+        }
+        if (m_stop)
+            break;
+
+        int requested = m_requested;
+        bool checkpointRequested = m_checkpointRequested;
+        m_checkpointRequested = false;
+        m_mutex.unlock();
+
+        // The interval is not restarted by the wake up of WAL hook
+        bool due = requested != m_served;
+        if (m_options.interval > 0 && clock.elapsed() >= m_options.interval) {
+            clock.restart();
+            due = true;
+        }
+
+        if (m_connection.isOpen())
+            maintain(requested != m_served,due,checkpointRequested);
+
+        m_mutex.lock();
+        m_served = requested;
+        m_done.wakeAll();
+    }
+    m_done.wakeAll();
+    m_mutex.unlock();
+}
+
+void _DQMaintenance::maintain(bool force,bool due,bool checkpoint){
+    QHash<QString,qint64> counts = m_sql.writeCounts();
+    qint64 total = _dqTotal(counts);
+
+    if (m_wal && m_options.checkpointSize > 0) {
+        // The passive checkpoint does not block the writers , so it is not postponed
+        if (checkpoint || _DQCheckpointer::walSize(m_connection.sql().database()) >= m_options.checkpointSize) {
+            this->checkpoint();
+            m_checkpointed = total;
+        }
+    }
+
+    if (!due)
+        return;
+
+    bool busy = total != m_lastTotal;
+    m_lastTotal = total;
+    if (!force && busy && ++m_deferred < DQ_MAINTENANCE_MAX_DEFERRAL)
+        return;
+    m_deferred = 0;
+
+    if (m_options.analyzeThreshold >= 0) {
+        QStringList tables;
+        QHashIterator<QString,qint64> iter(counts);
+        while (iter.hasNext()) {
+            iter.next();
+            qint64 written = iter.value() - m_analyzed.value(iter.key(),0);
+            if (written > 0 && written >= m_options.analyzeThreshold)
+                tables << iter.key();
+        }
+
+        if (!tables.isEmpty()) {
+            tables.sort();
+            foreach (QString table , tables) {
+                exec(QString("ANALYZE %1;").arg(table));
+                m_analyzed[table] = counts.value(table);
+            }
+            exec("PRAGMA optimize;");
+        }
+    }
+
+    qint64 written = total - m_vacuumed;
+    if (m_incrementalVacuum && m_options.vacuumThreshold >= 0 &&
+        written > 0 && written >= m_options.vacuumThreshold) {
+        exec(QString("PRAGMA incremental_vacuum(%1);").arg(qMax(m_options.vacuumPages,0)));
+        m_vacuumed = total;
+    }
+
+    written = total - m_checkpointed;
+    if (m_wal && m_options.checkpointThreshold >= 0 &&
+        written > 0 && written >= m_options.checkpointThreshold) {
+        this->checkpoint();
+        m_checkpointed = total;
+    }
+}
+
+void _DQMaintenance::checkpoint(){
+    QSqlDatabase db = m_connection.sql().database();
+    if (!db.isOpen())
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    bool res = m_checkpointer->checkpoint(db,DQConnection::PassiveCheckpoint,0,0,&error);
+    qint64 nsecs = timer.nsecsElapsed();
+
+    if (!res)
+        qWarning() << QString("DQConnection - Maintenance checkpoint failed : %1").arg(error);
+
+    QMutexLocker locker(&m_statsMutex);
+    m_profiler.record("PRAGMA wal_checkpoint(PASSIVE);",0,nsecs,res);
+}
+
+#ifdef DQ_SQLITE_API
+int _DQMaintenance::walHook(void* maintenance,sqlite3* handle,const char* database,int frames){
+    Q_UNUSED(handle);
+    Q_UNUSED(database);
+
+    // It is called by the committing thread. Only wake up the maintenance thread here
+    _DQMaintenance* self = static_cast<_DQMaintenance*>(maintenance);
+    if (frames >= self->m_checkpointFrames) {
+        QMutexLocker locker(&self->m_mutex);
+        if (!self->m_checkpointRequested) {
+            self->m_checkpointRequested = true;
+            self->m_wake.wakeAll();
+        }
+    }
+    return SQLITE_OK;
+}
+#endif
+
+bool _DQMaintenance::exec(const QString &sql){
+    QElapsedTimer timer;
+    timer.start();
+
+    QSqlQuery q(m_connection.sql().database());
+    bool res = q.exec(sql);
+    while (res && q.next()) {
+        // PRAGMA incremental_vacuum reclaims the pages while the rows are stepped
+    }
+    qint64 nsecs = timer.nsecsElapsed();
+
+    if (!res)
+        qWarning() << QString("DQConnection - Maintenance task %1 failed : %2").arg(sql).arg(q.lastError().text());
+
+    QMutexLocker locker(&m_statsMutex);
+    m_profiler.record(sql,0,nsecs,res);
+
+    return res;
+}
@@ -0,0 +1,117 @@
+#ifndef DQMAINTENANCE_P_H
+#define DQMAINTENANCE_P_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include "dqclonethread_p.h"
+#include "dqsql.h"
+#include "dqmaintenanceoptions.h"
+#include "dqprofiler_p.h"
+#include "dqcheckpointer_p.h"
+
+/// The background maintenance thread of a connection
+/**
+  The thread wakes up on every interval and compares the write counters of
+  the base connection's DQSql with the counters of the last run of each task.
+  The due tasks are run on a clone of the database (_DQCloneThread).
+
+  The tasks are postponed while the base connection is writing (the counters
+  changed since the previous interval) , at most DQ_MAINTENANCE_MAX_DEFERRAL
+  intervals. The thread runs in QThread::IdlePriority.
+
+  The statements run by the tasks are timed by a private _DQProfiler.
+
+  If DQMaintenanceOptions::checkpointSize is set , a WAL hook is installed on
+  the base connection in place of its automatic checkpoint. The hook wakes up
+  the thread to run a passive checkpoint once the WAL reach the size.
+ */
+class _DQMaintenance : public _DQCloneThread {
+public:
+    /// Start the thread. It blocks until the database is cloned.
+    /**
+      @param checkpointer Record the checkpoints. The ownership is not taken.
+     */
+    _DQMaintenance(DQConnection* base,const DQMaintenanceOptions &options,_DQCheckpointer* checkpointer);
+
+    /// Stop the thread and restore the automatic checkpoint. The running task is completed.
+    ~_DQMaintenance();
+
+    /// Run the due tasks now, even if the connection is busy. It blocks until they are finished.
+    void runNow();
+
+    /// The timing of the statements run by the tasks
+    QList<DQQueryStats> stats();
+
+protected:
+    void process();
+
+    void stopping();
+
+private:
+    /// Run the tasks their threshold is passed
+    /**
+      @param force TRUE if the tasks should not be postponed by the writes
+      @param due TRUE if the interval is elapsed or it is forced. Otherwise only the checkpoint by size is run
+      @param checkpoint TRUE if the WAL hook found the WAL reached the size
+     */
+    void maintain(bool force,bool due,bool checkpoint);
+
+    /// Run a passive checkpoint on the clone
+    void checkpoint();
+
+    /// The WAL hook of base connection
+    static int walHook(void* maintenance,sqlite3* handle,const char* database,int frames);
+
+    /// Run a statement and record its time
+    bool exec(const QString &sql);
+
+    /// The DQSql of base connection. Its counters are guarded by its own mutex
+    DQSql m_sql;
+
+    DQMaintenanceOptions m_options;
+
+    /// The write counters at the last ANALYZE of each table
+    QHash<QString,qint64> m_analyzed;
+
+    /// The total no. of written rows at the last vacuum / checkpoint
+    qint64 m_vacuumed;
+    qint64 m_checkpointed;
+
+    /// The total no. of written rows on the last interval
+    qint64 m_lastTotal;
+
+    /// No. of successive intervals the tasks were postponed
+    int m_deferred;
+
+    bool m_wal;
+    bool m_incrementalVacuum;
+
+    _DQCheckpointer* m_checkpointer;
+
+    /// The handle of base connection which the WAL hook is installed. NULL if it is not installed
+    sqlite3* m_hookHandle;
+
+    /// The wal_autocheckpoint of base connection before the hook is installed
+    int m_autoCheckpoint;
+
+    /// checkpointSize in pages
+    int m_checkpointFrames;
+
+    _DQProfiler m_profiler;
+
+    /// Guard of m_profiler
+    QMutex m_statsMutex;
+
+    /// Notify runNow() that the tasks are finished
+    QWaitCondition m_done;
+
+    /// No. of runNow() requested and served
+    int m_requested;
+    int m_served;
+
+    /// TRUE if the WAL hook asked for a checkpoint
+    bool m_checkpointRequested;
+};
+
+#endif // DQMAINTENANCE_P_H
@@ -0,0 +1,17 @@
+#include "dqmaintenanceoptions.h"
+
+/* Test cases:
+
+  sqlitetests::maintenance()
+
+ */
+
+DQMaintenanceOptions::DQMaintenanceOptions(){
+    interval = 60000;
+    analyzeThreshold = 1000;
+    analysisLimit = 400;
+    vacuumThreshold = 10000;
+    vacuumPages = 0;
+    checkpointThreshold = 1000;
+    checkpointSize = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef DQMAINTENANCEOPTIONS_H
+#define DQMAINTENANCEOPTIONS_H
+
+#include <QtGlobal>
+
+/// The thresholds of the background maintenance of a connection
+/**
+  The maintenance thread counts the rows written through DQSql (insert ,
+  update , remove and the bulk writes). When the count since the last run of
+  a task reach its threshold , the task is run on the next idle interval:
+
+  - ANALYZE of each table written no less than analyzeThreshold rows , followed by "PRAGMA optimize"
+  - "PRAGMA incremental_vacuum" after vacuumThreshold rows are written. It is skipped unless auto_vacuum is INCREMENTAL.
+  - "PRAGMA wal_checkpoint(PASSIVE)" after checkpointThreshold rows are written. It is skipped unless the journal mode is WAL.
+
+  A negative threshold disables the task.
+
+  The checkpoint could also be triggered by the size of WAL (checkpointSize).
+  It replaces the automatic checkpoint of the connection , which runs in the
+  committing thread and stalls the write that passes the limit. The passive
+  checkpoint is run by the maintenance thread instead , it is never postponed
+  by the writes.
+
+  Example:
+
+\code
+    DQMaintenanceOptions options;
+    options.interval = 30000;
+    options.analyzeThreshold = 5000;
+
+    connection.setMaintenanceEnabled(true,options);
+\endcode
+
+  @see DQConnection::setMaintenanceEnabled()
+ */
+class DQMaintenanceOptions
+{
+public:
+    /// Construct the default thresholds
+    DQMaintenanceOptions();
+
+    /// The time in milliseconds between two checks. Zero or negative value only run the tasks on DQConnection::runMaintenance()
+    int interval;
+
+    /// No. of rows written to a table before it is analyzed. The default value is 1000
+    int analyzeThreshold;
+
+    /// PRAGMA analysis_limit used by ANALYZE. Zero means no limit, negative value keep the setting. The default value is 400
+    int analysisLimit;
+
+    /// No. of rows written before the free pages are reclaimed. The default value is 10000
+    int vacuumThreshold;
+
+    /// The max. no. of pages reclaimed by a single run. Zero reclaim all the free pages
+    int vacuumPages;
+
+    /// No. of rows written before the WAL is checkpointed. The default value is 1000
+    int checkpointThreshold;
+
+    /// The size of WAL file in bytes to trigger a checkpoint. Zero or negative value disable it (the default)
+    /**
+      When it is enabled , the automatic checkpoint of the connection is disabled.
+      A commit that makes the WAL grow over the size wakes the maintenance thread ,
+      and the size is also checked on every interval for the writes of other connections.
+     */
+    qint64 checkpointSize;
+};
+
+#endif // DQMAINTENANCEOPTIONS_H
@@ -20,6 +20,10 @@ public:
         return DQSharedQuery::recordTo(model);
     }
 
+    bool get(DQModel *model) {
+        return DQSharedQuery::get(model);
+    }
+
     DQModelMetaInfo *m_metaInfo;
 };
 
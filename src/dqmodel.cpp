@@ -6,19 +6,48 @@
 #include "dqlist.h"
 
 #include "dqsql.h"
+#include "dqwritebehind_p.h"
+#include "dqwriterthread_p.h"
+#include "dqfieldprofile_p.h"
 
 //#define TABLE_NAME "Model without DQ_MODEL"
 #define TABLE_NAME ""
 
 
-DQModel::DQModel() : m_connection ( DQConnection::defaultConnection()){
+DQModel::DQModel() : m_connection ( DQConnection::defaultConnection()) , m_fieldProfile(0){
 
 }
 
-DQModel::DQModel(DQConnection connection) : m_connection(connection)
+DQModel::DQModel(DQConnection connection) : m_connection(connection) , m_fieldProfile(0)
 {
 }
 
+DQModel::DQModel(const DQModel& rhs) : DQAbstractModel(rhs) , id(rhs.id) , m_connection(rhs.m_connection) , m_fieldProfile(rhs.m_fieldProfile)
+{
+}
+
+DQModel& DQModel::operator=(const DQModel& rhs){
+    DQAbstractModel::operator=(rhs);
+    id = rhs.id;
+    m_connection = rhs.m_connection;
+    m_fieldProfile = rhs.m_fieldProfile;
+    return *this;
+}
+
+#ifdef Q_COMPILER_RVALUE_REFS
+DQModel::DQModel(DQModel&& rhs) : DQAbstractModel(rhs) , id(std::move(rhs.id)) , m_connection(rhs.m_connection) , m_fieldProfile(rhs.m_fieldProfile)
+{
+}
+
+DQModel& DQModel::operator=(DQModel&& rhs){
+    DQAbstractModel::operator=(rhs);
+    id = std::move(rhs.id);
+    m_connection = rhs.m_connection;
+    m_fieldProfile = rhs.m_fieldProfile;
+    return *this;
+}
+#endif
+
 DQModel::~DQModel(){
 }
 
@@ -45,22 +74,84 @@ bool DQModel::save(bool forceInsert,bool forceAllField) {
     DQModelMetaInfo *info = metaInfo();
     Q_ASSERT(info);
 
-    QStringList fields = info->fieldNameList();
+    _DQWriteBehind* writer = m_connection.writeBehind();
+
+    /* The untouched deferred fields are not written by UPDATE. Otherwise
+       the whole record is written , they are loaded by a single query first.
+     */
+    if (writer || forceInsert || forceAllField || id.get().isNull() || id.isDirty()) {
+        QStringList deferredFields;
+        int n = info->size();
+        for (int i = 0 ; i < n;i++) {
+            if (info->field(this,i)->isDeferred())
+                deferredFields << info->at(i)->name;
+        }
+        if (!deferredFields.isEmpty())
+            loadFields(deferredFields);
+    }
+
+    if (writer) {
+        writer->enqueue(static_cast<DQModel*>(info->clone(this)),forceInsert,forceAllField);
+        info->setDirty(this,false);
+        return true;
+    }
+
+    _DQWriterThread* writerThread = m_connection.writerThread();
+    if (writerThread && m_connection.sql().transactionDepth() == 0) {
+        bool res = writerThread->save(this,forceInsert,forceAllField);
+        if (res)
+            m_connection.sql().notifyTableChanged(info->name());
+        return res;
+    }
+
+    DQSql sql = m_connection.sql();
+
+    /* For the record loaded from / saved to database , only the changed fields
+       are written by UPDATE. An explicitly assigned id is not a known
+       record, it will be replaced as before.
+     */
+    if (!forceInsert && !forceAllField && !id.get().isNull() && !id.isDirty()) {
+        QStringList dirtyFields;
+        int n = info->size();
+        for (int i = 0 ; i < n;i++) {
+            const DQModelMetaInfoField* field = info->at(i);
+            if (field->name != "id" && info->field(this,i)->isDirty())
+                dirtyFields << field->name;
+        }
+
+        dirtyFields = info->writableFields(dirtyFields);
+        if (dirtyFields.isEmpty())
+            return true;
+
+        int updated = sql.update(info,this,dirtyFields);
+        m_connection.setLastQuery(sql.lastQuery());
+
+        if (updated < 0)
+            return false;
+
+        if (updated > 0) {
+            info->setDirty(this,false);
+            return true;
+        }
+
+        // The record is not existed in database. Insert it.
+    }
+
     QStringList nonNullFields;
     if (forceAllField) {
 
-        nonNullFields = fields;
+        nonNullFields = info->columnNameList();
 
     } else {
 
-    foreach (QString field , fields) {
-        QVariant v = info->value(this,field);
-        if (forceInsert && field == "id" ) // skip id field when forceInsert
+    int n = info->size();
+    for (int i = 0 ; i < n;i++) {
+        const DQModelMetaInfoField* field = info->at(i);
+        if (forceInsert && field->name == "id" ) // skip id field when forceInsert
             continue;
 
-        if (!v.isNull() ) {
-//            qDebug() << field;
-            nonNullFields << field;
+        if (!info->field(this,i)->get().isNull() ) {
+            nonNullFields << field->name;
         }
     }
 
@@ -68,14 +159,92 @@ bool DQModel::save(bool forceInsert,bool forceAllField) {
 
     bool res ;
 
-    DQSql sql = m_connection.sql();
-
     if (forceInsert || id->isNull() ) {
         res = sql.replaceInto(info,this,nonNullFields,true);
     } else {
         res = sql.replaceInto(info,this,nonNullFields,false);
     }
 
+    if (res)
+        info->setDirty(this,false);
+
+    m_connection.setLastQuery(sql.lastQuery());
+
+    return res;
+}
+
+bool DQModel::upsert(QStringList conflictColumns){
+    if (!clean() ) {
+        return false;
+    }
+    DQModelMetaInfo *info = metaInfo();
+    Q_ASSERT(info);
+
+    int n = info->size();
+
+    if (conflictColumns.isEmpty()) {
+        // Each DQUnique column is a constraint of its own , the target must be one of them
+        for (int i = 0 ; i < n;i++) {
+            DQClause clause = info->at(i)->clause;
+            if (clause.testFlag(DQClause::UNIQUE)) {
+                conflictColumns << info->at(i)->name;
+                break;
+            }
+        }
+        if (conflictColumns.isEmpty())
+            conflictColumns << "id";
+    }
+
+    QStringList fields;
+    for (int i = 0 ; i < n;i++) {
+        if (!info->field(this,i)->get().isNull() )
+            fields << info->at(i)->name;
+    }
+
+    DQSql sql = m_connection.sql();
+    bool byId = conflictColumns == QStringList("id");
+    bool res;
+
+    // NULL values are distinct in an UNIQUE constraint , so a record with a NULL conflict column is always inserted
+    bool inserting = false;
+    foreach (QString column , conflictColumns) {
+        if (info->value(this,column,true).isNull())
+            inserting = true;
+    }
+
+    if (inserting) {
+        // It can't conflict with any record
+        res = sql.insertInto(info,this,fields,true);
+    } else {
+        res = sql.upsert(info,this,fields,conflictColumns);
+    }
+
+    if (res && !byId && !inserting) {
+        // The last insert id is not updated if the existing record is updated
+        DQWhere where;
+        foreach (QString column , conflictColumns) {
+            DQWhere w = DQWhere(column) == info->value(this,column,true);
+            where = where.isNull() ? w : (where && w);
+        }
+
+        _DQMetaInfoQuery query( info ,  m_connection);
+        query = query.select("id").filter(where).limit(1);
+
+        res = false;
+        if (query.exec()) {
+            if (query.next()) {
+                res = true;
+                QVariant value = query.value();
+                if (id.get() != value)
+                    id.set(value);
+            }
+            query.finish();
+        }
+    }
+
+    if (res)
+        info->setDirty(this,false);
+
     m_connection.setLastQuery(sql.lastQuery());
 
     return res;
@@ -86,15 +255,44 @@ bool DQModel::load(DQWhere where){
 
     _DQMetaInfoQuery query( metaInfo() ,  m_connection);
 
-    query = query.filter(where).limit(1);
-    if (query.exec()){
-        if (query.next()){
+    query = query.filter(where);
+    res = query.get(this);
+
+    if (!res)
+        id->clear();
+
+    m_connection.setLastQuery(query.lastQuery());
+
+    return res;
+}
+
+bool DQModel::loadFields(QStringList fields){
+    if (id->isNull() || fields.isEmpty())
+        return false;
+
+    DQModelMetaInfo *info = metaInfo();
+    int n = info->size();
+
+    // The fields not in the list keep their dirty state
+    QVector<bool> dirty(n);
+    for (int i = 0 ; i < n;i++) {
+        dirty[i] = info->field(this,i)->isDirty() && !fields.contains(info->at(i)->name);
+    }
+
+    _DQMetaInfoQuery query( info ,  m_connection);
+    query = query.select(fields).filter(DQWhere("id") == id.get()).limit(1);
+
+    bool res = false;
+    if (query.exec()) {
+        if (query.next()) {
             res = query.recordTo(this);
         }
+        query.finish();
     }
 
-    if (!res)
-        id->clear();
+    for (int i = 0 ; i < n;i++) {
+        info->field(this,i)->setDirty(dirty.at(i));
+    }
 
     m_connection.setLastQuery(query.lastQuery());
 
@@ -16,6 +16,8 @@
 #include <dqquery.h>
 #include <dqforeignkey.h>
 
+class _DQFieldProfile;
+
 /// Database model class
 /** DQModel is the core of DQuest that provide an ORM interface to sql database table.
   To declare your database model, you should:
@@ -55,6 +57,24 @@ public:
     /// Construct a DQModel object and set the database connection
     explicit DQModel(DQConnection connection);
 
+    /// Copy constructor
+    /**
+      The fields are copied in O(1). DQField values are implicitly shared QVariant
+      and the "linked" model of DQForeignKey is shared until it is accessed.
+     */
+    DQModel(const DQModel& rhs);
+
+    /// Copy the fields and connection of other model
+    DQModel& operator=(const DQModel& rhs);
+
+#ifdef Q_COMPILER_RVALUE_REFS
+    /// Move constructor
+    DQModel(DQModel&& rhs);
+
+    /// Move assignment
+    DQModel& operator=(DQModel&& rhs);
+#endif
+
     virtual ~DQModel();
 
     /// The primary key. It is default field for every model
@@ -82,12 +102,48 @@ public:
       If the id is not set , the record will be inserted to the database , then id field will be updated automatically.
       The successive call will update the record instead of insert unless forceInsert is TRUE.
 
+      For a record loaded from or saved to database, only the dirty fields (DQBaseField::isDirty())
+      are written by "UPDATE". If no field is changed, nothing will be written.
+
+      If the write-behind mode of the connection is enabled , a copy of the record is queued
+      and it returns TRUE immediately. The whole record is written by "REPLACE" later and
+      the id field is not updated.
+
+      The fields declared with DQGenerated are never written, and their values are not refreshed by save().
+
+      @see DQConnection::setWriteBehindEnabled()
      */
     virtual bool save(bool forceInsert = false,bool forceAllField = false);
 
+    /// Insert the record , or update the existing record that has the same value on conflictColumns
+    /**
+      @param conflictColumns The columns of a UNIQUE constraint. If it is empty, the first field declared with DQUnique is used. If there is no any, it will be "id".
+      Pass the columns explicitly for a composite UNIQUE index , or to use another DQUnique field.
+
+      It writes by "INSERT ... ON CONFLICT DO UPDATE". Unlike save() with "REPLACE",
+      the existing row is updated in place, so its id , the foreign key references to it and
+      the unchanged index entries are kept. Null fields are skipped. The id field
+      will be set to the inserted / updated record after operation.
+
+      @remarks It requires SQLite 3.24 or above
+     */
+    bool upsert(QStringList conflictColumns = QStringList());
+
     /// Load the record that first match with filter
     bool load(DQWhere where);
 
+    /// Load the fields from the record of the same id
+    /**
+      @param fields The name of fields to be loaded. Other fields are not changed.
+
+      It is used to load the deferred fields (DQBaseField::isDeferred()). The loaded
+      fields become non-dirty.
+
+      @return FALSE if the id is not set or the record is not found
+      @see DQSharedQuery::defer()
+     */
+    bool loadFields(QStringList fields);
+
     /// Remove the record from database
     /**
       @return TRUE if the record is successfully removed
@@ -136,6 +192,12 @@ protected:
 
 private:
     DQConnection m_connection;
+
+    /// The profile of the query which read the record. It is NULL unless DQSharedQuery::autoOnly() is used
+    _DQFieldProfile *m_fieldProfile;
+
+    friend class DQBaseField;
+    friend class DQSharedQuery;
 };
 
 template<>
@@ -145,12 +207,7 @@ public:
     /// Return the fields of DQModel
     static inline QList<DQModelMetaInfoField> fields() {
         QList<DQModelMetaInfoField> result;
-        DQModel m;
-        result << DQModelMetaInfoField("id",
-                                       offsetof(DQModel,id),
-                                       m.id.type(),
-                                       m.id.clause()
-                                       );
+        result << _dqMetaInfoField("id",&DQModel::id,offsetof(DQModel,id));
         return result;
     }
 };
@@ -167,7 +224,49 @@ public:
   @see DQDefault
  */
 #define DQ_FIELD(field , CLAUSE...) \
-new DQModelMetaInfoField(#field,offsetof(Table,field),m.field.type(), m.field.clause(), ## CLAUSE)
+_dqMetaInfoField(#field,&Table::field,offsetof(Table,field), ## CLAUSE)
+
+/// Declare an index of the model
+/**
+  The index is created by DQConnection::createTables() after the tables are
+  created and the initial data is inserted.
+
+  @param name The name of index. You don't need to quote the string
+  @param COLUMNS The column definitions. You don't need to quote the string. (e.g height , weight DESC)
+  @remarks This macro should be only used within DQ_DECLARE_MODEL / DQ_DECLARE_MODEL2
+
+Example:
+\code
+DQ_DECLARE_MODEL(HealthCheck,
+                 "healthcheck",
+                 DQ_FIELD(name , DQNotNull),
+                 DQ_FIELD(height),
+                 DQ_FIELD(weight),
+                 DQ_INDEX(healthcheck_height , height , weight DESC),
+                 DQ_UNIQUE_INDEX(healthcheck_name , name),
+                 DQ_PARTIAL_INDEX(healthcheck_tall , "height > 180" , height)
+                 );
+\endcode
+ */
+#define DQ_INDEX(name , COLUMNS...) \
+_dqMetaInfoCreateIndex(#name , #COLUMNS , false)
+
+/// Declare an UNIQUE index of the model
+/**
+  @see DQ_INDEX
+ */
+#define DQ_UNIQUE_INDEX(name , COLUMNS...) \
+_dqMetaInfoCreateIndex(#name , #COLUMNS , true)
+
+/// Declare a partial index of the model which only contains the rows fulfill the condition
+/**
+  @param name The name of index
+  @param WHERE The condition in string
+  @param COLUMNS The column definitions
+  @see DQ_INDEX
+ */
+#define DQ_PARTIAL_INDEX(name , WHERE , COLUMNS...) \
+_dqMetaInfoCreateIndex(#name , #COLUMNS , false , WHERE)
 
 /**
   See tests/modes/model1.h
@@ -182,8 +281,7 @@ new DQModelMetaInfoField(#field,offsetof(Table,field),m.field.type(), m.field.cl
                 return #MODEL; \
             } \
             static inline QList<DQModelMetaInfoField> fields() {\
-                QList<DQModelMetaInfoField> result;\
-                MODEL m;
+                QList<DQModelMetaInfoField> result;
 
 #define DQ_DECLARE_MODEL_END(MODEL,NAME) \
                 return result; \
@@ -196,11 +294,7 @@ new DQModelMetaInfoField(#field,offsetof(Table,field),m.field.type(), m.field.cl
             return NAME; \
         } \
         inline DQModelMetaInfo *MODEL::metaInfo() const { \
-            static DQModelMetaInfo *meta = 0; \
-            if (!meta){ \
-                meta = dqMetaInfo<MODEL>(); \
-            } \
-            return meta; \
+            return dqMetaInfo<MODEL>(); \
         } \
         inline DQSharedQuery MODEL::objects() { \
             DQQuery<MODEL> query; \
@@ -248,16 +342,16 @@ DQ_DECLARE_MODEL(User,
 #define DQ_DECLARE_MODEL(MODEL,NAME,FIELDS...) \
         DQ_DECLARE_MODEL_BEGIN(MODEL,NAME) \
             result << DQModelMetaInfoHelper<DQModel>::fields(); \
-            DQModelMetaInfoField* list[] = { FIELDS,0 }; \
-            result << _dqMetaInfoCreateFields(list) ; \
+            const DQModelMetaInfoField list[] = { FIELDS }; \
+            result << _dqMetaInfoFields(list,sizeof(list) / sizeof(list[0])) ; \
         DQ_DECLARE_MODEL_END(MODEL,NAME)
 
 /// Declare a model which is not a direct sub-class of DQModel
 #define DQ_DECLARE_MODEL2(MODEL,NAME,PARENT,FIELDS...) \
         DQ_DECLARE_MODEL_BEGIN(MODEL,NAME) \
-            result << DQModelMetaInfoHelper<PARENT>::fields(); \
-            DQModelMetaInfoField* list[] = { FIELDS,0 }; \
-            result << _dqMetaInfoCreateFields(list) ; \
+            result << _dqMetaInfoInheritFields(DQModelMetaInfoHelper<PARENT>::fields()); \
+            const DQModelMetaInfoField list[] = { FIELDS }; \
+            result << _dqMetaInfoFields(list,sizeof(list) / sizeof(list[0])) ; \
         DQ_DECLARE_MODEL_END(MODEL,NAME)
 
 /// The DQ_MODEL macro must appear in the class definition that declares model's virtual function for database access
@@ -303,13 +397,13 @@ public: \
 /// Print model field for debugging
 inline QDebug operator<< (QDebug d, const DQModel* model){
     DQModelMetaInfo *metaInfo = model->metaInfo();
-    QStringList fields = metaInfo->fieldNameList();
     QStringList col;
-    foreach (QString field,fields){
-        QVariant value = metaInfo->value(model,field);
+    int count = metaInfo->size();
+    for (int j = 0 ; j < count;j++){
+        QVariant value = metaInfo->value(model,j);
         if (value.isNull())
             continue;
-        col << QString("%1=%2").arg(field).arg(value.toString());
+        col << QString("%1=%2").arg(metaInfo->at(j)->name).arg(value.toString());
     }
 
     QString res = QString("%1[%2]")
@@ -8,89 +8,180 @@
 #define DQ_MODEL_GET_FIELD(model, offset) \
             ( (DQBaseField*) MEMBER_PTR(model,offset) )
 
-static QMap<QString , DQModelMetaInfo* > metaTypeList;
+/// An entry of the meta info registry
+/**
+  The registry is a singly linked list. A new entry is prepended by
+  compare-and-swap and the entries are never removed, so it could be
+  read without lock. The newer registration of the same name is found first.
+ */
+class _DQMetaInfoEntry {
+public:
+    QString name;
+    DQModelMetaInfo *metaInfo;
+    _DQMetaInfoEntry *next;
+};
+
+static QAtomicPointer<_DQMetaInfoEntry> _dqMetaInfoRegistry;
+
+static inline _DQMetaInfoEntry* _dqLoad(QAtomicPointer<_DQMetaInfoEntry> &value) {
+#if QT_VERSION >= 0x050000
+    return value.loadAcquire();
+#else
+    return value;
+#endif
+}
+
+_DQRecursiveMutex* _dqMetaInfoMutex() {
+    // The first call may race between threads. It relies on the thread-safe initialization of
+    // function-local statics by the compiler (C++11 , or -fthreadsafe-statics which GCC / Clang enable by default)
+#if QT_VERSION >= 0x050E00
+    static QRecursiveMutex mutex;
+#else
+    static QMutex mutex(QMutex::Recursive);
+#endif
+    return &mutex;
+}
 
 DQModelMetaInfo* dqFindMetaInfo(QString name) {
-    DQModelMetaInfo * res = 0;
-    if (metaTypeList.contains(name))
-        res = metaTypeList[name];
-    return res;
+    for (_DQMetaInfoEntry *entry = _dqLoad(_dqMetaInfoRegistry) ; entry ; entry = entry->next) {
+        if (entry->name == name)
+            return entry->metaInfo;
+    }
+    return 0;
 }
 
 void dqRegisterMetaInfo(QString name, DQModelMetaInfo *metaType){
-    metaTypeList[name] = metaType;
+    _DQMetaInfoEntry *entry = new _DQMetaInfoEntry();
+    entry->name = name;
+    entry->metaInfo = metaType;
+
+    do {
+        entry->next = _dqLoad(_dqMetaInfoRegistry);
+    } while (!_dqMetaInfoRegistry.testAndSetOrdered(entry->next,entry));
 }
 
 DQModelMetaInfo::DQModelMetaInfo() : QObject() {
+    createFunc = 0;
+    createAtFunc = 0;
+    initialDataFunc = 0;
+    m_modelSize = 0;
+
     QCoreApplication *app = QCoreApplication::instance();
-    setParent(app); // Then it will be destroyed in program termination. Make valgrind happy.
+    // Then it will be destroyed in program termination. Make valgrind happy.
+    // The children list of application could not be changed by other thread , the instance created there is kept until exit.
+    if (app && app->thread() == QThread::currentThread())
+        setParent(app);
 }
 
 void DQModelMetaInfo::registerField(DQModelMetaInfoField field){
     // The final registerField() call
 
+    if (field.offset < 0) {
+        // Declared by DQ_INDEX
+        m_indexList << field.index;
+        return;
+    }
+
+    if (m_fieldIndex.contains(field.name)) {
+        // Overridden by the derived model. The clause may be changed , the lists are built again in field order
+        m_fieldList[m_fieldIndex[field.name]] = field;
+        updateClauseLists();
+    } else {
+        m_fieldIndex[field.name] = m_fieldList.size();
+        m_fieldList << field;
+        m_columnNameList << field.name;
+
+        m_fieldNameList = m_columnNameList;
+        m_fieldNameList.sort();
+
+        appendClauseLists(field);
+    }
+}
+
+void DQModelMetaInfo::appendClauseLists(DQModelMetaInfoField field){
     if (field.clause.testFlag(DQClause::FOREIGN_KEY)) {
         m_foreignKeyList << field;
+        m_foreignKeyNameList << field.name;
     }
 
-    m_fields[field.name] = field;
-    m_fieldList << field;
+    if (field.clause.testFlag(DQClause::FULL_TEXT))
+        m_fullTextNameList << field.name;
+
+    if (field.clause.testFlag(DQClause::GENERATED))
+        m_generatedNameList << field.name;
+}
+
+void DQModelMetaInfo::updateClauseLists(){
+    m_foreignKeyList.clear();
+    m_foreignKeyNameList.clear();
+    m_fullTextNameList.clear();
+    m_generatedNameList.clear();
+
+    int n = m_fieldList.size();
+    for (int i = 0 ; i < n;i++) {
+        appendClauseLists(m_fieldList.at(i));
+    }
 }
 
 void DQModelMetaInfo::registerFields(QList<DQModelMetaInfoField> fields){
+    m_fieldList.reserve(m_fieldList.size() + fields.size());
     foreach (DQModelMetaInfoField field,fields) {
         registerField(field);
     }
 }
 
-QStringList DQModelMetaInfo::fieldNameList(){
-    QStringList result;
-    QMapIterator<QString, DQModelMetaInfoField> iter(m_fields);
-    while (iter.hasNext()) {
-         iter.next();
-         result << iter.key();
-    }
-    return result;
+QStringList DQModelMetaInfo::fieldNameList() const{
+    return m_fieldNameList;
+}
+
+QStringList DQModelMetaInfo::columnNameList() const{
+    return m_columnNameList;
 }
 
 QList<DQModelMetaInfoField> DQModelMetaInfo::foreignKeyList(){
     return m_foreignKeyList;
 }
 
-QStringList DQModelMetaInfo::foreignKeyNameList(){
-    QStringList result;
-    foreach (DQModelMetaInfoField field , m_foreignKeyList){
-        result << field.name;
-    }
+QStringList DQModelMetaInfo::foreignKeyNameList() const{
+    return m_foreignKeyNameList;
+}
+
+QStringList DQModelMetaInfo::fullTextNameList() const{
+    return m_fullTextNameList;
+}
 
-    return result;
+QStringList DQModelMetaInfo::generatedNameList() const{
+    return m_generatedNameList;
+}
 
+QStringList DQModelMetaInfo::writableFields(QStringList fields) const{
+    foreach (QString field , m_generatedNameList)
+        fields.removeAll(field);
+    return fields;
 }
 
 int DQModelMetaInfo::size() const{
-    return m_fields.size();
+    return m_fieldList.size();
 }
 
 const DQModelMetaInfoField* DQModelMetaInfo::at(int idx) const{
     return &m_fieldList.at(idx);
 }
 
-bool DQModelMetaInfo::setValue(DQAbstractModel *model,QString field, const QVariant& val){
-    if (!m_fields.contains(field))
-        return false;
-    int offset = m_fields[field].offset;
+int DQModelMetaInfo::indexOf(const QString& field) const {
+    return m_fieldIndex.value(field,-1);
+}
 
-    DQBaseField* f = DQ_MODEL_GET_FIELD(model,offset);
-    f->set(val);
-    return true;
+bool DQModelMetaInfo::setValue(DQAbstractModel *model,QString field, const QVariant& val){
+    return setValue(model,indexOf(field),val);
 }
 
 bool DQModelMetaInfo::setValue(DQAbstractModel *model,int index, const QVariant& val){
-    if (index< 0 || index > size() ) {
+    if (index< 0 || index >= size() ) {
         return false;
     }
 
-    int offset = m_fieldList[index].offset;
+    int offset = m_fieldList.at(index).offset;
 
     DQBaseField* f = DQ_MODEL_GET_FIELD(model,offset);
     f->set(val);
@@ -98,27 +189,49 @@ bool DQModelMetaInfo::setValue(DQAbstractModel *model,int index, const QVariant&
 }
 
 QVariant DQModelMetaInfo::value(const DQAbstractModel *model,QString field,bool convert) const{
-    QVariant v;
-    if (!m_fields.contains(field))
-        return v;
-    int offset = m_fields[field].offset;
-
-    DQBaseField* f = DQ_MODEL_GET_FIELD(model,offset);
-
-    return f->get(convert);
+    return value(model,indexOf(field),convert);
 }
 
 QVariant DQModelMetaInfo::value(const DQAbstractModel *model,int index ,bool convert) const{
-    if (index< 0 || index > size() ) {
+    if (index< 0 || index >= size() ) {
         return QVariant();
     }
 
-    int offset = m_fieldList[index].offset;
+    int offset = m_fieldList.at(index).offset;
 
     DQBaseField* f = DQ_MODEL_GET_FIELD(model,offset);
     return f->get(convert);
 }
 
+DQBaseField* DQModelMetaInfo::field(DQAbstractModel *model,int index) const{
+    if (index< 0 || index >= size() ) {
+        return 0;
+    }
+
+    int offset = m_fieldList.at(index).offset;
+
+    return DQ_MODEL_GET_FIELD(model,offset);
+}
+
+void DQModelMetaInfo::setDirty(DQAbstractModel *model,bool dirty) const{
+    int n = m_fieldList.size();
+    for (int i = 0 ; i < n;i++) {
+        DQ_MODEL_GET_FIELD(model,m_fieldList.at(i).offset)->setDirty(dirty);
+    }
+}
+
+DQModelMetaInfo* DQModelMetaInfo::linkedMetaInfo(int index) const{
+    if (index< 0 || index >= size() ) {
+        return 0;
+    }
+
+    DQClause clause = m_fieldList.at(index).clause;
+    if (!clause.testFlag(DQClause::FOREIGN_KEY))
+        return 0;
+
+    return (DQModelMetaInfo*) clause.flag(DQClause::FOREIGN_KEY).value<void *>();
+}
+
 QString DQModelMetaInfo::name() const{
     return m_name;
 }
@@ -139,6 +252,64 @@ DQAbstractModel* DQModelMetaInfo::create(){
     return createFunc();
 }
 
+DQAbstractModel* DQModelMetaInfo::create(void *buffer){
+    return createAtFunc(buffer);
+}
+
+DQAbstractModel* DQModelMetaInfo::clone(const DQAbstractModel *model){
+    DQAbstractModel* res = createFunc();
+    int n = m_fieldList.size();
+    for (int i = 0 ; i < n;i++) {
+        int offset = m_fieldList.at(i).offset;
+        DQBaseField* from = DQ_MODEL_GET_FIELD(model,offset);
+        DQBaseField* to = DQ_MODEL_GET_FIELD(res,offset);
+        if (from->isDeferred())
+            to->setDeferred(res);
+        else
+            to->set(from->get());
+        to->setDirty(from->isDirty());
+    }
+    return res;
+}
+
+QList<DQModelMetaInfoIndex> DQModelMetaInfo::indexList() const{
+    return m_indexList;
+}
+
+int DQModelMetaInfo::modelSize() const{
+    return m_modelSize;
+}
+
 DQSharedList DQModelMetaInfo::initialData(){
     return initialDataFunc();
 }
+
+DQModelMetaInfoField _dqMetaInfoCreateIndex(const char* name,const char* columns,bool unique,QString where){
+    DQModelMetaInfoIndex index;
+    index.name = name;
+    index.unique = unique;
+    index.where = where;
+
+    // Split by the comma which is not within parentheses (e.g "substr(name,1,3)")
+    QString text(columns);
+    QString column;
+    int depth = 0;
+    int n = text.size();
+    for (int i = 0 ; i < n;i++) {
+        QChar c = text.at(i);
+        if (c == '(') {
+            depth++;
+        } else if (c == ')') {
+            depth--;
+        } else if (c == ',' && depth == 0) {
+            index.columns << column.trimmed();
+            column.clear();
+            continue;
+        }
+        column += c;
+    }
+    if (!column.trimmed().isEmpty())
+        index.columns << column.trimmed();
+
+    return DQModelMetaInfoField(index);
+}
@@ -1,6 +1,7 @@
 #ifndef DQMODELMETAINFO_H
 #define DQMODELMETAINFO_H
 
+#include <new>
 #include <QString>
 #include <QMap>
 #include <QVariant>
@@ -13,12 +14,43 @@
 template <typename T>
 DQModelMetaInfo* dqMetaInfo();
 
+class DQBaseField;
+
+/// An index declared by DQ_INDEX / DQ_UNIQUE_INDEX / DQ_PARTIAL_INDEX
+class DQModelMetaInfoIndex {
+public:
+    inline DQModelMetaInfoIndex() {
+        unique = false;
+    }
+
+    /// The index name
+    QString name;
+
+    /// The column definitions (e.g "height" , "weight DESC")
+    QStringList columns;
+
+    /// TRUE if it is an UNIQUE index
+    bool unique;
+
+    /// The WHERE condition of partial index. It is empty for normal index.
+    QString where;
+};
+
 /// The field of meta info
 
 class DQModelMetaInfoField {
 public:
     inline DQModelMetaInfoField(){
         type = QVariant::Invalid;
+        offset = -1;
+    }
+
+    /// Construct an entry of index declaration. It is not a field.
+    inline DQModelMetaInfoField(const DQModelMetaInfoIndex &index) :
+        name(index.name),
+        offset(-1),
+        type(QVariant::Invalid),
+        index(index) {
     }
 
     inline DQModelMetaInfoField(QString name,
@@ -43,6 +75,9 @@ public:
     /// The clause of the field
     DQClause clause;
 
+    /// The declared index if it is not a field (offset < 0)
+    DQModelMetaInfoIndex index;
+
 };
 
 typedef DQAbstractModel* (*_dqAbstractModelCreateFunc)();
@@ -52,6 +87,17 @@ DQAbstractModel* _dqAbstractModelCreate() {
     return new T();
 }
 
+typedef DQAbstractModel* (*_dqAbstractModelCreateAtFunc)(void *buffer);
+/// A wrapper template for DQAbstractModel creation on pre-allocated memory
+/**
+  The buffer must be at least sizeof(T) bytes and suitably aligned. The
+  model must be destroyed by calling its destructor explicitly.
+ */
+template <class T>
+DQAbstractModel* _dqAbstractModelCreateAt(void *buffer) {
+    return new (buffer) T();
+}
+
 typedef DQSharedList (*_dqMetaInfoInitalDataFunc)();
 
 template <class T>
@@ -72,27 +118,52 @@ DQSharedList _dqMetaInfoInitalData() {
 
   When it is created , it will set its parent to QCoreApplication,
   so that it will be destroyed automatically.
+
+  The fields are stored in a flat array in registration order. The name
+  lists are built once on registration, so reading the fields by index
+  do not involve any lookup or allocation.
  */
 
 class DQModelMetaInfo : private QObject {
 
 public:
 
-    /// Return the list of field name
-    QStringList fieldNameList();
+    /// Return the list of field name in alphabetical order
+    QStringList fieldNameList() const;
+
+    /// Return the list of field name in registration order
+    /**
+      The order is equal to the index used by at() / value() / setValue().
+     */
+    QStringList columnNameList() const;
 
     /// List of foreign key name
-    QStringList foreignKeyNameList();
+    QStringList foreignKeyNameList() const;
 
     /// List of foreign key
     QList<DQModelMetaInfoField> foreignKeyList();
 
+    /// List of field name with the DQFullText clause in registration order
+    QStringList fullTextNameList() const;
+
+    /// List of field name with the DQGenerated / DQStoredGenerated clause in registration order
+    QStringList generatedNameList() const;
+
+    /// Remove the generated fields from a list of field name. They can't be written.
+    QStringList writableFields(QStringList fields) const;
+
     /// No. of field
     int size() const;
 
     /// Get the field data at index
     const DQModelMetaInfoField* at(int idx) const;
 
+    /// Get the index of a field
+    /**
+      @return The index of the field in registration order. -1 if the field is not existed.
+     */
+    int indexOf(const QString& field) const;
+
     /// Set value of a field on a model
     bool setValue(DQAbstractModel *model,QString field, const QVariant& val);
 
@@ -117,6 +188,21 @@ public:
      */
     QVariant value(const DQAbstractModel *model,int index ,bool convert = false) const;
 
+    /// Get the field object of a model at index
+    /**
+      @return The field object or NULL if the index is out of range
+     */
+    DQBaseField* field(DQAbstractModel *model,int index) const;
+
+    /// Set the dirty state of all the fields of a model
+    void setDirty(DQAbstractModel *model,bool dirty) const;
+
+    /// Get the meta info of the model "linked" by the foreign key at index
+    /**
+      @return The meta info or NULL if the field is not a foreign key
+     */
+    DQModelMetaInfo* linkedMetaInfo(int index) const;
+
     /// The table name
     QString name() const;
 
@@ -129,6 +215,26 @@ public:
     /// Create an instance of the associated model type
     DQAbstractModel* create();
 
+    /// Create an instance of the associated model type on a pre-allocated memory
+    /**
+      @param buffer The memory of at least modelSize() bytes. It should be aligned to the boundary of double.
+      @remarks The instance must be destroyed by calling the destructor explicitly instead of delete.
+     */
+    DQAbstractModel* create(void *buffer);
+
+    /// Create a copy of a model of the associated type
+    /**
+      The values and the dirty state of all the fields are copied. A deferred field stays deferred in the copy.
+      @return The new instance. The ownership is passed to the caller.
+     */
+    DQAbstractModel* clone(const DQAbstractModel *model);
+
+    /// The size of the associated model type in bytes (sizeof(T))
+    int modelSize() const;
+
+    /// The indexes declared in DQ_DECLARE_MODEL
+    QList<DQModelMetaInfoIndex> indexList() const;
+
 protected:
     /// Default constructor
     DQModelMetaInfo();
@@ -146,21 +252,49 @@ protected:
     void registerFields(QList<DQModelMetaInfoField> fields);
 
 private:
-    /// Field data
-    QMap<QString, DQModelMetaInfoField> m_fields;
+    /// Append the field to the lists of foreign key , full text and generated fields according to its clause
+    void appendClauseLists(DQModelMetaInfoField field);
+
+    /// Build the lists of foreign key , full text and generated fields from m_fieldList again
+    void updateClauseLists();
 
     /// Field in registration order
-    QList<DQModelMetaInfoField> m_fieldList;
+    QVector<DQModelMetaInfoField> m_fieldList;
+
+    /// Index of field in m_fieldList
+    QHash<QString,int> m_fieldIndex;
+
+    /// Cached result of fieldNameList()
+    QStringList m_fieldNameList;
+
+    /// Cached result of columnNameList()
+    QStringList m_columnNameList;
 
     QList<DQModelMetaInfoField> m_foreignKeyList;
 
+    /// Cached result of foreignKeyNameList()
+    QStringList m_foreignKeyNameList;
+
+    /// Cached result of fullTextNameList()
+    QStringList m_fullTextNameList;
+
+    /// Cached result of generatedNameList()
+    QStringList m_generatedNameList;
+
+    /// The declared indexes
+    QList<DQModelMetaInfoIndex> m_indexList;
+
     /// The table name
     QString m_name;
     QString m_className;
 
     _dqAbstractModelCreateFunc createFunc;
+    _dqAbstractModelCreateAtFunc createAtFunc;
     _dqMetaInfoInitalDataFunc initialDataFunc;
 
+    /// sizeof() the model type
+    int m_modelSize;
+
     template <typename T>
     friend DQModelMetaInfo* dqMetaInfo();
 
@@ -169,12 +303,14 @@ private:
 /// Find a meta info instance from database
 /**
   @return The instance of the DQModelMetaInfo or NULL if it is not found.
+  @threadsafe It do not lock.
  */
 DQModelMetaInfo* dqFindMetaInfo(QString name);
 
 /// Register a meta info
 /**
   @remarks User should not use this function for any purpose
+  @threadsafe
  */
 void dqRegisterMetaInfo(QString name, DQModelMetaInfo *metaType);
 
@@ -195,7 +331,57 @@ public:
 
 };
 
-/// Create fields from a list of DQModelMetaInfoField*
+/// Create the entry of DQ_INDEX
+/**
+  @param name The index name
+  @param columns The comma separated column definitions
+  @param unique TRUE if it is an UNIQUE index
+  @param where The condition of partial index
+ */
+DQModelMetaInfoField _dqMetaInfoCreateIndex(const char* name,const char* columns,bool unique,QString where = QString());
+
+/// Create the entry of DQ_FIELD
+/**
+  The type and the default clause are read from the static functions of the
+  field class , which is deduced from the member pointer. No instance of the
+  model is needed.
+
+  @param name The field name
+  @param member The member pointer of the field (e.g &User::name). It is used for type deduction only
+  @param offset The offset of the field in the model
+  @param clause The declared clause
+ */
+template <class Model,class Field>
+inline DQModelMetaInfoField _dqMetaInfoField(const char* name,Field Model::*member,int offset,DQClause clause = DQClause()) {
+    Q_UNUSED(member);
+    return DQModelMetaInfoField(name,offset,Field::type(),Field::clause(),clause);
+}
+
+/// The fields of parent model. The index declarations are not inherited , as the index name must be unique in database.
+static inline QList<DQModelMetaInfoField> _dqMetaInfoInheritFields(const QList<DQModelMetaInfoField> &fields) {
+    QList<DQModelMetaInfoField> res;
+    foreach (const DQModelMetaInfoField &field , fields) {
+        if (field.offset >= 0)
+            res << field;
+    }
+    return res;
+}
+
+/// Create fields from the array declared by DQ_DECLARE_MODEL
+static inline QList<DQModelMetaInfoField> _dqMetaInfoFields(const DQModelMetaInfoField *list,int size) {
+    QList<DQModelMetaInfoField> res;
+    res.reserve(size);
+
+    for (int i = 0 ; i < size ; i++)
+        res << list[i];
+
+    return res;
+}
+
+/// Create fields from a null terminated list of DQModelMetaInfoField*. The list items are deleted.
+/**
+  It is used by the model helper classes written by hand before the fields were declared by value.
+ */
 static inline QList<DQModelMetaInfoField> _dqMetaInfoCreateFields(DQModelMetaInfoField*  list[]) {
     /* Didn't use variadic argument on Mac. The no. of "new" in a line is limited. */
     QList<DQModelMetaInfoField> res;
@@ -211,36 +397,72 @@ static inline QList<DQModelMetaInfoField> _dqMetaInfoCreateFields(DQModelMetaInf
 }
 
 
+static inline DQModelMetaInfo* _dqLoad(QAtomicPointer<DQModelMetaInfo> &value) {
+#if QT_VERSION >= 0x050000
+    return value.loadAcquire();
+#else
+    return value;
+#endif
+}
+
+#if QT_VERSION >= 0x050E00
+typedef QRecursiveMutex _DQRecursiveMutex;
+#else
+typedef QMutex _DQRecursiveMutex;
+#endif
+
+/// The lock of meta info creation. It is recursive , as the meta info of foreign key is created within.
+_DQRecursiveMutex* _dqMetaInfoMutex();
+
 /// Find the meta info of DQModel class. If it is not existed, it will create a one automatically
+/**
+  @threadsafe The created meta info is read without lock. The creation is
+  serialized , so only one instance is created even it is first used by
+  several threads at the same time.
+ */
 template <typename T>
 inline DQModelMetaInfo* dqMetaInfo() {
-    static DQModelMetaInfo* metaInfo = 0;
-    if (metaInfo)
-        return metaInfo;
-
-    QString name = T::TableName();
+    static QAtomicPointer<DQModelMetaInfo> metaInfo;
+    DQModelMetaInfo *res = _dqLoad(metaInfo);
+    if (res)
+        return res;
 
     if (T::DQModelDefined == 0){
         qWarning() << "dqMetaInfo: You should declare database model class by DQ_MODEL / DQ_DECLARE_MODEL pair";
         return 0;
     }
 
-    metaInfo = (DQModelMetaInfo*) dqFindMetaInfo(name);
-    if (metaInfo) {
+    QMutexLocker locker(_dqMetaInfoMutex());
+    res = _dqLoad(metaInfo);
+    if (res) // Created by other thread
+        return res;
+
+    QString name = T::TableName();
+
+    res = dqFindMetaInfo(name);
+    if (res) {
         qWarning() << QString("Table with same name is detected! : %1 ").arg(name);
     } else {
-        metaInfo = new DQModelMetaInfo();
-        metaInfo->setName(name);
-        metaInfo->setClassName(DQModelMetaInfoHelper<T>::className());
-        metaInfo->createFunc = _dqAbstractModelCreate<T>;
-        metaInfo->initialDataFunc =_dqMetaInfoInitalData<T>;
+        res = new DQModelMetaInfo();
+        res->setName(name);
+        res->setClassName(DQModelMetaInfoHelper<T>::className());
+        res->createFunc = _dqAbstractModelCreate<T>;
+        res->createAtFunc = _dqAbstractModelCreateAt<T>;
+        res->m_modelSize = sizeof(T);
+        res->initialDataFunc =_dqMetaInfoInitalData<T>;
 
         QList<DQModelMetaInfoField> fields = DQModelMetaInfoHelper<T>::fields();
-        metaInfo->registerFields(fields);
-        dqRegisterMetaInfo(name,metaInfo);
+        res->registerFields(fields);
+        dqRegisterMetaInfo(name,res);
     }
 
-    return metaInfo;
+#if QT_VERSION >= 0x050000
+    metaInfo.storeRelease(res);
+#else
+    metaInfo.fetchAndStoreRelease(res);
+#endif
+
+    return res;
 }
 
 /// Get the table name of the model
@@ -0,0 +1,181 @@
+#include <QtCore>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include "dqpersister_p.h"
+#include "dqsql.h"
+
+/* Test cases:
+
+  sqlitetests::inMemory()
+
+ */
+
+/// The name of temporary file of an image
+static QString _dqTemporaryPath(const QString &path) {
+    return path + ".tmp";
+}
+
+_DQPersister::_DQPersister(DQConnection* base,const QString &path,int interval) :
+    _DQCloneThread(base,"dqpersister","persister thread") , m_path(path) , m_interval(interval) ,
+    m_version(0) , m_written(QFile::exists(path)) , m_persisted(0) , m_ok(true) ,
+    m_requested(0) , m_served(0) {
+
+    startClone(QThread::LowPriority);
+}
+
+_DQPersister::~_DQPersister(){
+    stopClone();
+}
+
+void _DQPersister::stopping(){
+    m_done.wakeAll();
+}
+
+bool _DQPersister::persistNow(){
+    QMutexLocker locker(&m_mutex);
+    int ticket = ++m_requested;
+    m_wake.wakeAll();
+
+    while (!m_stop && m_served - ticket < 0)
+        m_done.wait(&m_mutex);
+
+    return m_ok;
+}
+
+int _DQPersister::persisted(){
+    QMutexLocker locker(&m_mutex);
+    return m_persisted;
+}
+
+bool _DQPersister::load(sqlite3* handle,const QString &path){
+#ifndef DQ_SQLITE_API
+    Q_UNUSED(handle);
+    Q_UNUSED(path);
+    qWarning() << "DQConnection::openInMemory() - Persisting to a file requires DQuest built with dquest_sqlite_api";
+    return false;
+#else
+    if (!handle)
+        return false;
+
+    QString file = path;
+    if (!QFile::exists(file))
+        file = _dqTemporaryPath(path);
+    if (!QFile::exists(file))
+        return true; // Nothing was persisted
+
+    sqlite3 *source = 0;
+    QByteArray name = file.toUtf8();
+    if (sqlite3_open_v2(name.constData(),&source,SQLITE_OPEN_READONLY,0) != SQLITE_OK) {
+        qWarning() << QString("DQConnection::openInMemory() - Failed to open %1 : %2").arg(file)
+                      .arg(QString::fromUtf8(sqlite3_errmsg(source)));
+        sqlite3_close(source);
+        return false;
+    }
+
+    bool res = false;
+    sqlite3_backup *backup = sqlite3_backup_init(handle,"main",source,"main");
+    if (backup) {
+        int rc = sqlite3_backup_step(backup,-1);
+        sqlite3_backup_finish(backup);
+        res = rc == SQLITE_DONE;
+    }
+
+    if (!res) {
+        qWarning() << QString("DQConnection::openInMemory() - Failed to load %1 : %2").arg(file)
+                      .arg(QString::fromUtf8(sqlite3_errmsg(handle)));
+    }
+
+    sqlite3_close(source);
+    return res;
+#endif
+}
+
+void _DQPersister::process(){
+    if (m_connection.isOpen()) {
+        // The loaded content is already in the file
+        QSqlQuery q = m_connection.query();
+        if (q.exec("PRAGMA data_version;") && q.next())
+            m_version = q.value(0).toInt();
+    }
+
+    m_mutex.lock();
+    while (!m_stop) {
+        if (m_served == m_requested) {
+            if (m_interval > 0)
+                m_wake.wait(&m_mutex,(unsigned long) m_interval);
+            else
+                m_wake.wait(&m_mutex);
+        }
+        if (m_stop)
+            break;
+
+        int requested = m_requested;
+        m_mutex.unlock();
+
+        bool ok = persist();
+
+        m_mutex.lock();
+        m_ok = ok;
+        m_served = requested;
+        m_done.wakeAll();
+    }
+    m_mutex.unlock();
+
+    // The last changes
+    bool ok = persist();
+
+    m_mutex.lock();
+    m_ok = ok;
+    m_mutex.unlock();
+}
+
+bool _DQPersister::persist(){
+#ifndef DQ_SQLITE_API
+    return false;
+#else
+    sqlite3 *handle = _dqSqliteHandle(m_connection.sql().database());
+    if (!handle)
+        return false;
+
+    int version = m_version;
+    QSqlQuery q = m_connection.query();
+    if (q.exec("PRAGMA data_version;") && q.next())
+        version = q.value(0).toInt();
+    q.finish();
+
+    if (m_written && version == m_version)
+        return true;
+
+    sqlite3_int64 size = 0;
+    unsigned char *image = sqlite3_serialize(handle,"main",&size,0);
+    if (!image) {
+        qWarning() << "DQConnection - Failed to copy the in-memory database";
+        return false;
+    }
+
+    QString temporary = _dqTemporaryPath(m_path);
+    QFile file(temporary);
+    bool res = file.open(QIODevice::WriteOnly | QIODevice::Truncate) &&
+               file.write((const char*) image,size) == size &&
+               file.flush();
+    file.close();
+    sqlite3_free(image);
+
+    if (res) {
+        QFile::remove(m_path);
+        res = QFile::rename(temporary,m_path);
+    }
+
+    if (!res) {
+        qWarning() << QString("DQConnection - Failed to persist the in-memory database to %1").arg(m_path);
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_version = version;
+    m_written = true;
+    m_persisted++;
+
+    return true;
+#endif
+}
@@ -0,0 +1,78 @@
+#ifndef DQPERSISTER_P_H
+#define DQPERSISTER_P_H
+
+#include <QWaitCondition>
+#include "dqclonethread_p.h"
+#include "dqsqlite_p.h"
+
+/// The background thread to persist an in-memory database to a file
+/**
+  The thread opens a clone of the in-memory database (The clone shares the
+  database by the "memdb" VFS). On every interval it polls "PRAGMA data_version"
+  , and if any other connection committed since the last run , the database is
+  copied by sqlite3_serialize() and written to the file.
+
+  The read lock of the in-memory database is only held while the pages are
+  copied in memory , so save() is not blocked by the file I/O. The image is
+  written to "path.tmp" and then renamed to the path , a crash during the write
+  never leaves a partial file.
+
+  The clone is owned by the thread (_DQCloneThread). The last changes are
+  persisted when the thread is stopped.
+ */
+class _DQPersister : public _DQCloneThread {
+public:
+    /// Start the thread. It blocks until the database is cloned.
+    _DQPersister(DQConnection* base,const QString &path,int interval);
+
+    /// Persist the last changes and stop the thread
+    ~_DQPersister();
+
+    /// Persist the changes now. It blocks until the file is written.
+    /**
+      @return FALSE if it is failed to write the file
+     */
+    bool persistNow();
+
+    /// No. of times the file was written
+    int persisted();
+
+    /// Restore a database file into a connection by the backup API
+    /**
+      If the file is not existed and a temporary file is left by an interrupted write , it is used instead.
+      @return TRUE if it is restored or there is no file. It is always FALSE without DQ_SQLITE_API.
+     */
+    static bool load(sqlite3* handle,const QString &path);
+
+protected:
+    void process();
+
+    void stopping();
+
+private:
+    /// Write the database to the file if it is changed
+    bool persist();
+
+    QString m_path;
+    int m_interval;
+
+    /// data_version of the last persisted image
+    int m_version;
+
+    /// TRUE if the file matches the database on m_version
+    bool m_written;
+
+    int m_persisted;
+
+    /// The result of last persist()
+    bool m_ok;
+
+    /// Notify persistNow() that the file is written
+    QWaitCondition m_done;
+
+    /// No. of persistNow() requested and served
+    int m_requested;
+    int m_served;
+};
+
+#endif // DQPERSISTER_P_H
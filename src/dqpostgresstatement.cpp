@@ -0,0 +1,250 @@
+#include <QStringList>
+#include <QtCore>
+#include "dqpostgresstatement.h"
+#include "dqexpression.h"
+#include "dqsqlbuilder_p.h"
+
+/* Test cases:
+
+  coretests::postgresStatement()
+
+ */
+
+DQPostgresStatement::DQPostgresStatement()
+{
+}
+
+QString DQPostgresStatement::_createTableIfNotExists(DQModelMetaInfo *info,QString tableName) {
+    QStringList columnDefList;
+
+    int n = info->size();
+
+    for (int i = 0 ; i < n;i++){
+        const DQModelMetaInfoField *f = info->at(i);
+
+        if (columnTypeName(f->type).isNull()) {
+            qWarning() << QString("%1::%3 - DQField<%2> is not supported yet")
+                        .arg(info->name()).arg(QVariant::typeToName(f->type)).arg(f->name);
+            continue;
+        }
+
+        DQClause clause = f->clause;
+        if (clause.testFlag(DQClause::PRIMARY_KEY)) {
+            columnDefList << QString("%1 SERIAL PRIMARY KEY").arg(f->name);
+            continue;
+        }
+
+        columnDefList << QString("%1 %2 %3")
+                         .arg(f->name)
+                         .arg(columnTypeName(f->type))
+                         .arg(columnConstraint(f->clause));
+    }
+
+    QList<DQModelMetaInfoField> foreignKeyList = info->foreignKeyList();
+    n = foreignKeyList.size();
+
+    for (int i = 0; i < n ;i++){
+        DQModelMetaInfoField f = foreignKeyList.at(i);
+        QVariant v = f.clause.flag(DQClause::FOREIGN_KEY);
+        DQModelMetaInfo * targetInfo = (DQModelMetaInfo*) v.value<void *>();
+        Q_ASSERT(targetInfo);
+
+        columnDefList << QString("FOREIGN KEY(%1) REFERENCES %2(id)")
+                         .arg(f.name)
+                         .arg(targetInfo->name());
+    }
+
+    return QString("CREATE TABLE IF NOT EXISTS %1 (\n%2\n);")
+           .arg(tableName)
+           .arg(columnDefList.join(",\n"));
+}
+
+QString DQPostgresStatement::_columnDefinition(const DQModelMetaInfoField *field) {
+    DQClause clause = field->clause;
+    QString res = QString("%1 %2 %3")
+                  .arg(field->name)
+                  .arg(columnTypeName(field->type))
+                  .arg(columnConstraint(field->clause));
+
+    if (clause.testFlag(DQClause::FOREIGN_KEY)) {
+        DQModelMetaInfo * targetInfo = (DQModelMetaInfo*) clause.flag(DQClause::FOREIGN_KEY).value<void *>();
+        res += QString(" REFERENCES %1(id)").arg(targetInfo->name());
+    }
+
+    return res;
+}
+
+bool DQPostgresStatement::canAddColumn(const DQModelMetaInfoField *field) {
+    DQClause clause = field->clause;
+
+    if (clause.testFlag(DQClause::PRIMARY_KEY))
+        return false;
+
+    if (clause.testFlag(DQClause::GENERATED))
+        return true;
+
+    bool hasDefault = clause.testFlag(DQClause::DEFAULT) && !clause.flag(DQClause::DEFAULT).isNull();
+
+    return !clause.testFlag(DQClause::NOT_NULL) || hasDefault;
+}
+
+QString DQPostgresStatement::columnTypeName(QVariant::Type type) {
+    QString res;
+    switch (type){
+    case QVariant::Int:
+    case QVariant::UInt:
+        res = "INTEGER";
+        break;
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+        res = "BIGINT";
+        break;
+    case QVariant::Double:
+        res = "DOUBLE PRECISION";
+        break;
+    case QVariant::String:
+    case QVariant::StringList:
+        res = "TEXT";
+        break;
+    case QVariant::DateTime:
+        res = "TIMESTAMP";
+        break;
+    case QVariant::Date:
+        res = "DATE";
+        break;
+    case QVariant::ByteArray:
+        res = "BYTEA";
+        break;
+    case QVariant::Bool:
+        res = "BOOLEAN";
+        break;
+    default:
+        break;
+    }
+    return res;
+}
+
+QString DQPostgresStatement::columnConstraint(DQClause clause){
+    QStringList res;
+    // PostgreSQL only has stored generated column
+    if (clause.testFlag(DQClause::GENERATED)) {
+        res << QString("GENERATED ALWAYS AS (%1) STORED").arg(clause.flag(DQClause::GENERATED).toString());
+    }
+
+    if (clause.testFlag(DQClause::NOT_NULL)) {
+        res << "NOT NULL";
+    }
+
+    if (clause.testFlag(DQClause::UNIQUE)) {
+        res << "UNIQUE";
+    }
+
+    if (clause.testFlag(DQClause::DEFAULT)) {
+        res << QString("DEFAULT %1").arg(clause.flag(DQClause::DEFAULT).toString());
+    }
+
+    return res.join(" ");
+}
+
+QString DQPostgresStatement::driverName(){
+    return "POSTGRESQL";
+}
+
+QString DQPostgresStatement::listSchema(){
+    return "SELECT 'table' AS type , tablename AS name , tablename AS tbl_name FROM pg_tables WHERE schemaname = current_schema() "
+           "UNION ALL "
+           "SELECT 'index' AS type , indexname AS name , tablename AS tbl_name FROM pg_indexes WHERE schemaname = current_schema()";
+}
+
+QString DQPostgresStatement::listColumns(QString table){
+    return QString("SELECT column_name AS name FROM information_schema.columns "
+                   "WHERE table_schema = current_schema() AND table_name = '%1' ORDER BY ordinal_position").arg(table);
+}
+
+bool DQPostgresStatement::returnsInsertId(){
+    return true;
+}
+
+QString DQPostgresStatement::returningId(QString sql){
+    sql = sql.trimmed();
+    if (sql.endsWith(';'))
+        sql.chop(1);
+    return sql + " RETURNING id;";
+}
+
+QString DQPostgresStatement::insertInto(DQModelMetaInfo *info,const QStringList &fields){
+    _DQSqlBuilder builder;
+    QString &sql = builder.sql();
+
+    _insertInto(sql,info,"INSERT",fields);
+    sql.chop(1); // Remove the ";"
+    sql += QLatin1String(" RETURNING id;");
+
+    return builder.result();
+}
+
+QString DQPostgresStatement::replaceInto(DQModelMetaInfo *info,const QStringList &fields){
+    if (!fields.contains("id"))
+        return insertInto(info,fields);
+
+    return upsert(info,fields,QStringList("id"));
+}
+
+QString DQPostgresStatement::upsert(DQModelMetaInfo *info,QStringList fields,QStringList conflictColumns){
+    return returningId(DQSqlStatement::upsert(info,fields,conflictColumns));
+}
+
+QString DQPostgresStatement::insertRows(DQModelMetaInfo *info,QStringList fields,int rows){
+    return returningId(DQSqlStatement::insertRows(info,fields,rows));
+}
+
+int DQPostgresStatement::maxBindParameters(){
+    return 65535;
+}
+
+bool DQPostgresStatement::supportsJsonInList(){
+    return false;
+}
+
+QString DQPostgresStatement::deleteFrom(const DQSharedQuery &query){
+    DQQueryRules rules;
+    rules = query;
+
+    if (rules.limit() <= 0)
+        return DQSqlStatement::deleteFrom(query);
+
+    // DELETE do not support LIMIT
+    _DQSqlBuilder builder;
+    QString &sql = builder.sql();
+
+    sql += QLatin1String("DELETE FROM ");
+    appendQualifiedName(sql,rules.metaInfo());
+    sql += QLatin1String(" WHERE id IN (SELECT id FROM ");
+    appendQualifiedName(sql,rules.metaInfo());
+
+    DQExpression expression = rules.expression();
+    if (!expression.isNull()) {
+        sql += QLatin1String(" WHERE ");
+        sql += expression.string();
+    }
+
+    sql += QLatin1Char(' ');
+    limitAndOffset(sql,rules.limit());
+    sql += QLatin1String(") ;");
+
+    return builder.result();
+}
+
+void DQPostgresStatement::limitAndOffset(QString &sql,int limit, int offset) {
+    if (limit > 0) {
+        sql += QLatin1String("LIMIT ");
+        _DQSqlBuilder::appendNumber(sql,limit);
+    } else {
+        sql += QLatin1String("LIMIT ALL");
+    }
+
+    if (offset > 0) {
+        sql += QLatin1String(" OFFSET ");
+        _DQSqlBuilder::appendNumber(sql,offset);
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef DQPOSTGRESSTATEMENT_H
+#define DQPOSTGRESSTATEMENT_H
+
+#include <QVariant>
+#include <dqsqlstatement.h>
+
+/// PostgreSQL SQL Statement generator
+/**
+    It is used by DQConnection for a database opened by the "QPSQL" driver.
+    The differences with SQLite are:
+
+    <ul>
+    <li> The "id" field is a SERIAL primary key. The id of inserted record is returned by "RETURNING id". </li>
+    <li> "REPLACE INTO" is written as "INSERT ... ON CONFLICT(id) DO UPDATE". </li>
+    <li> DELETE with limit() is written as a sub-query on id. </li>
+    </ul>
+
+    The tables and indexes are read from the current schema.
+
+    @remarks DQConnectionOptions , DQConnection::snapshot() , DQSql::rebuildTable() and DQBlobStream
+    are SQLite only. The long DQWhere::in() lists are bound value by value.
+    @remarks It is thread-safe
+ */
+class DQPostgresStatement : public DQSqlStatement
+{
+public:
+    DQPostgresStatement();
+
+    QString columnTypeName(QVariant::Type type);
+    QString columnConstraint(DQClause clause);
+
+    virtual QString driverName();
+
+    virtual QString listSchema();
+
+    virtual QString listColumns(QString table);
+    using DQSqlStatement::listColumns;
+
+    /// The INSERT statements end with "RETURNING id"
+    virtual bool returnsInsertId();
+
+    /// PostgreSQL can't add a PRIMARY KEY column or a NOT NULL column without default value
+    virtual bool canAddColumn(const DQModelMetaInfoField *field);
+
+    virtual QString insertInto(DQModelMetaInfo *info,const QStringList &fields);
+
+    /// "INSERT ... ON CONFLICT(id) DO UPDATE" if the id is given , otherwise it is a plain INSERT
+    virtual QString replaceInto(DQModelMetaInfo *info,const QStringList &fields);
+
+    virtual QString upsert(DQModelMetaInfo *info,QStringList fields,QStringList conflictColumns);
+
+    virtual QString insertRows(DQModelMetaInfo *info,QStringList fields,int rows);
+
+    /// PostgreSQL allows 65535 bind parameters per statement
+    virtual int maxBindParameters();
+
+    /// QPSQL has no json_each() , the in-lists are always bound value by value
+    virtual bool supportsJsonInList();
+
+    virtual QString deleteFrom(const DQSharedQuery &query);
+
+protected:
+
+    virtual QString _createTableIfNotExists(DQModelMetaInfo *info,QString tableName);
+
+    virtual QString _columnDefinition(const DQModelMetaInfoField *field);
+
+    virtual void limitAndOffset(QString &sql,int limit, int offset = 0);
+
+private:
+    /// Append "RETURNING id" to an INSERT statement
+    QString returningId(QString sql);
+};
+
+#endif // DQPOSTGRESSTATEMENT_H
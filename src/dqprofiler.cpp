@@ -0,0 +1,98 @@
+#include <QtCore>
+#include <algorithm>
+#include "dqprofiler_p.h"
+
+/// The max. no. of raw statement kept by the normalization cache
+#define DQ_PROFILER_NORMALIZED_CACHE_SIZE 1000
+
+static bool _dqStatsGreaterThan(const DQQueryStats &a,const DQQueryStats &b) {
+    return a.totalTime() > b.totalTime();
+}
+
+_DQProfiler::_DQProfiler(int slowQueryThreshold) : m_slowQueryThreshold(slowQueryThreshold) , m_pending(-1) , m_pendingNsecs(0) {
+}
+
+_DQProfiler::~_DQProfiler(){
+    commit();
+}
+
+void _DQProfiler::record(const QString &sql,qint64 prepareNsecs,qint64 execNsecs,bool ok){
+    commit();
+
+    QHash<QString,QString>::const_iterator iter = m_normalized.constFind(sql);
+    QString normalized;
+    if (iter == m_normalized.constEnd()) {
+        normalized = DQQueryStats::normalize(sql);
+        if (m_normalized.size() >= DQ_PROFILER_NORMALIZED_CACHE_SIZE)
+            m_normalized.clear();
+        m_normalized.insert(sql,normalized);
+    } else {
+        normalized = iter.value();
+    }
+
+    int index = m_index.value(normalized,-1);
+    if (index < 0) {
+        index = m_stats.size();
+        DQQueryStats stats;
+        stats.sql = normalized;
+        m_stats.append(stats);
+        m_index.insert(normalized,index);
+    }
+
+    DQQueryStats &stats = m_stats[index];
+    stats.calls++;
+    if (!ok)
+        stats.failures++;
+    stats.prepareTime += prepareNsecs / 1000;
+    stats.execTime += execNsecs / 1000;
+
+    m_pending = index;
+    m_pendingSql = sql;
+    m_pendingNsecs = prepareNsecs + execNsecs;
+}
+
+void _DQProfiler::addRows(int rows,qint64 nsecs){
+    if (m_pending < 0)
+        return;
+
+    DQQueryStats &stats = m_stats[m_pending];
+    stats.rows += rows;
+    stats.hydrationTime += nsecs / 1000;
+    m_pendingNsecs += nsecs;
+}
+
+void _DQProfiler::commit(){
+    if (m_pending < 0)
+        return;
+
+    DQQueryStats &stats = m_stats[m_pending];
+    qint64 usecs = m_pendingNsecs / 1000;
+    stats.histogram[DQQueryStats::bucketOf(usecs)]++;
+    if (usecs > stats.maxTime)
+        stats.maxTime = usecs;
+
+    if (m_slowQueryThreshold >= 0 && usecs >= (qint64) m_slowQueryThreshold * 1000) {
+        qWarning() << QString("DQConnection - Slow query (%1 ms) : %2").arg(usecs / 1000.0).arg(m_pendingSql);
+    }
+
+    m_pending = -1;
+    m_pendingSql.clear();
+    m_pendingNsecs = 0;
+}
+
+QList<DQQueryStats> _DQProfiler::stats(){
+    commit();
+
+    QList<DQQueryStats> res = m_stats.toList();
+    std::stable_sort(res.begin(),res.end(),_dqStatsGreaterThan);
+    return res;
+}
+
+void _DQProfiler::reset(){
+    m_pending = -1;
+    m_pendingSql.clear();
+    m_pendingNsecs = 0;
+    m_normalized.clear();
+    m_index.clear();
+    m_stats.clear();
+}
@@ -0,0 +1,53 @@
+#ifndef DQPROFILER_P_H
+#define DQPROFILER_P_H
+
+#include <QHash>
+#include <QVector>
+#include <QList>
+#include "dqquerystats.h"
+
+/// Collect the DQQueryStats of a connection
+/**
+  A statement is recorded after it is executed, the rows fetched later are
+  added to it by addRows(). The call is counted into the histogram (and the
+  slow query log) on the next record or when the stats are read.
+ */
+class _DQProfiler {
+public:
+    /// @param slowQueryThreshold The time in milliseconds. The slower query is logged. Negative value disable the log.
+    explicit _DQProfiler(int slowQueryThreshold);
+    ~_DQProfiler();
+
+    /// Record an execution of statement
+    void record(const QString &sql,qint64 prepareNsecs,qint64 execNsecs,bool ok);
+
+    /// Add the rows fetched by the last recorded statement
+    void addRows(int rows,qint64 nsecs);
+
+    /// The stats sorted by the total time in descending order
+    QList<DQQueryStats> stats();
+
+    /// Remove all the stats
+    void reset();
+
+private:
+    /// Finish the last recorded call
+    void commit();
+
+    int m_slowQueryThreshold;
+
+    /// The normalized of raw statement
+    QHash<QString,QString> m_normalized;
+
+    /// Index of the normalized statement in m_stats
+    QHash<QString,int> m_index;
+
+    QVector<DQQueryStats> m_stats;
+
+    /// The last recorded call. -1 if it is already committed
+    int m_pending;
+    QString m_pendingSql;
+    qint64 m_pendingNsecs;
+};
+
+#endif // DQPROFILER_P_H
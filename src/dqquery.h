@@ -4,6 +4,10 @@
 #include <dqsharedquery.h>
 #include <dqlist.h>
 
+#ifdef Q_COMPILER_RVALUE_REFS
+#include <utility>
+#endif
+
 ///  DQQuery is a template class for performing database queries and record deletion on specific model
 /**
   @remarks It is a implicitly shared class
@@ -39,11 +43,73 @@ public:
         return *this;
     }
 
+#ifdef Q_COMPILER_RVALUE_REFS
+    /// Take the result of a builder function (e.g DQQuery<T>().filter(...) ) without copying
+    DQQuery(DQSharedQuery &&rhs) : DQSharedQuery(std::move(rhs)) {
+        setMetaInfo(dqMetaInfo<T>());
+    }
+
+    /// Take the result of a builder function without copying
+    DQQuery& operator=(DQSharedQuery &&rhs ) {
+        DQSharedQuery::operator =(std::move(rhs));
+        setMetaInfo(dqMetaInfo<T>());
+        return *this;
+    }
+#endif
+
+    /// Construct a new query object for the page after a record (keyset pagination)
+    /**
+      @param lastRow The last record of previous page
+      @param term The ordering term with optional ASC / DESC (e.g "height desc")
+
+      It filters the records by "WHERE key > :value" (or "<" for DESC)
+      and sorts them by the key, so the records of previous pages are not
+      visited by database. The cost of a page do not depend on its position
+      when the key is indexed. The "id" field is used as tie-breaker if the key is not unique.
+
+      It is combined with the current filter. Use it with limit():
+
+\code
+    DQQuery<HealthCheck> query = DQQuery<HealthCheck>().limit(100);
+
+    DQList<HealthCheck> page = query.orderBy("height").all(); // First page
+    while (page.size() > 0) {
+        // ...
+        page = query.after(*page.at(page.size() - 1),"height").all();
+    }
+\endcode
+     */
+    DQSharedQuery after(const T& lastRow,QString term) {
+        return DQSharedQuery::after(&lastRow,term);
+    }
+
     /// Save the next record to DQModel
     bool recordTo(T &model) {
         return DQSharedQuery::recordTo(&model);
     }
 
+    /// Get a single record that first match with the filter (limit(1) will be set)
+    /**
+      A lookup by id may be served by the identity map of the connection.
+
+      @see DQSql::setIdentityMapEnabled()
+     */
+    bool get(T &model) {
+        return DQSharedQuery::get(&model);
+    }
+
+    /// Run a function on every record by several threads
+    /**
+      The function is called with T& per record.
+
+      @see DQSharedQuery::parallelForEach()
+     */
+    template <typename Function>
+    bool parallelForEach(int nThreads , Function fn) {
+        _DQForEachFunctionImpl<T,Function> function(fn);
+        return parallelScan(nThreads,&function);
+    }
+
     /// Read the next record
     T record() {
         T t;
@@ -0,0 +1,84 @@
+#include <QtCore>
+#include "dqqueryplan.h"
+
+/* Test cases:
+
+  coretests::queryPlan()
+  sqlitetests::explain()
+
+ */
+
+bool DQQueryPlan::Step::isFullScan() const{
+    // SQLite 3.36 drop the word "TABLE" from "SCAN TABLE"
+    return detail.startsWith("SCAN ") && !detail.contains(" USING ");
+}
+
+QString DQQueryPlan::Step::table() const{
+#if QT_VERSION >= 0x050E00
+    QStringList words = detail.split(" ",Qt::SkipEmptyParts);
+#else
+    QStringList words = detail.split(" ",QString::SkipEmptyParts);
+#endif
+    if (words.size() < 2 || (words.at(0) != "SCAN" && words.at(0) != "SEARCH"))
+        return QString();
+
+    int index = 1;
+    if (words.at(1) == "TABLE")
+        index = 2;
+
+    if (index >= words.size())
+        return QString();
+    return words.at(index);
+}
+
+DQQueryPlan::DQQueryPlan(){
+}
+
+bool DQQueryPlan::isEmpty() const{
+    return m_steps.isEmpty();
+}
+
+int DQQueryPlan::size() const{
+    return m_steps.size();
+}
+
+const DQQueryPlan::Step& DQQueryPlan::at(int index) const{
+    return m_steps.at(index);
+}
+
+void DQQueryPlan::append(const Step &step){
+    m_steps.append(step);
+}
+
+bool DQQueryPlan::hasFullScan() const{
+    foreach (const Step &step , m_steps) {
+        if (step.isFullScan())
+            return true;
+    }
+    return false;
+}
+
+QStringList DQQueryPlan::fullScanTables() const{
+    QStringList res;
+    foreach (const Step &step , m_steps) {
+        if (!step.isFullScan())
+            continue;
+        QString table = step.table();
+        if (!table.isEmpty() && !res.contains(table))
+            res << table;
+    }
+    return res;
+}
+
+QString DQQueryPlan::toString() const{
+    QHash<int,int> levels;
+    QStringList lines;
+
+    foreach (const Step &step , m_steps) {
+        int level = step.parent != 0 && levels.contains(step.parent) ? levels.value(step.parent) + 1 : 0;
+        levels[step.id] = level;
+        lines << QString(level * 2,' ') + step.detail;
+    }
+
+    return lines.join("\n");
+}
@@ -0,0 +1,76 @@
+#ifndef DQQUERYPLAN_H
+#define DQQUERYPLAN_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+/// The result of "EXPLAIN QUERY PLAN"
+/**
+  DQQueryPlan is returned by DQSharedQuery::explain(). It is a list of steps
+  reported by SQLite. The steps form a tree by their id and parent.
+
+  Example:
+\code
+    DQQueryPlan plan = DQQuery<HealthCheck>().filter(DQWhere("height") > 170).explain();
+    if (plan.hasFullScan())
+        qDebug() << plan.toString(); // SCAN TABLE healthcheck
+\endcode
+
+  @see DQIndexAdvisor
+ */
+class DQQueryPlan
+{
+public:
+    /// A step of the plan
+    class Step {
+    public:
+        inline Step() {
+            id = 0;
+            parent = 0;
+        }
+
+        /// The id of the step
+        int id;
+
+        /// The id of parent step. Zero for top level step
+        int parent;
+
+        /// The description (e.g "SEARCH TABLE user USING INDEX user_name (name=?)")
+        QString detail;
+
+        /// TRUE if the step visits every row of a table without using an index
+        bool isFullScan() const;
+
+        /// The table (or its alias) visited by the step. It is empty if the step is not a SCAN / SEARCH step
+        QString table() const;
+    };
+
+    DQQueryPlan();
+
+    /// TRUE if there is no step. A failed explain() returns an empty plan
+    bool isEmpty() const;
+
+    /// No. of steps
+    int size() const;
+
+    /// Get the step at index
+    const Step& at(int index) const;
+
+    /// Append a step
+    void append(const Step &step);
+
+    /// TRUE if any of the step is a full table scan
+    bool hasFullScan() const;
+
+    /// The tables visited by full table scan
+    QStringList fullScanTables() const;
+
+    /// The plan in text. A line per step , indented by level
+    QString toString() const;
+
+private:
+    QList<Step> m_steps;
+};
+
+#endif // DQQUERYPLAN_H
@@ -26,26 +26,46 @@ DQQueryRules::~DQQueryRules()
 {
 }
 
-int DQQueryRules::limit(){
+int DQQueryRules::limit() const{
     return data->limit;
 }
 
-DQExpression DQQueryRules::expression(){
+int DQQueryRules::offset() const{
+    return data->offset;
+}
+
+DQExpression DQQueryRules::expression() const{
     return data->expression;
 }
 
-QString DQQueryRules::func(){
+QString DQQueryRules::func() const{
     return data->func;
 }
 
-DQModelMetaInfo *DQQueryRules::metaInfo(){
+DQModelMetaInfo *DQQueryRules::metaInfo() const{
     return data->metaInfo;
 }
 
-QStringList DQQueryRules::fields(){
+QStringList DQQueryRules::fields() const{
     return data->fields;
 }
 
-QStringList DQQueryRules::orderBy() {
+QStringList DQQueryRules::orderBy() const{
     return data->orderBy;
 }
+
+QStringList DQQueryRules::related() const{
+    return data->related;
+}
+
+QStringList DQQueryRules::deferred() const{
+    return data->deferredFields();
+}
+
+QStringList DQQueryRules::groupBy() const{
+    return data->groupBy;
+}
+
+DQExpression DQQueryRules::having() const{
+    return data->having;
+}
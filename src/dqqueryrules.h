@@ -22,21 +22,36 @@ public:
     ~DQQueryRules();
 
     /// Get the limit of query
-    int limit();
+    int limit() const;
 
-    DQExpression expression();
+    /// Get the no. of records to be skipped
+    int offset() const;
+
+    DQExpression expression() const;
 
     /// Get the func that should be applied on result column
-    QString func();
+    QString func() const;
 
     /// Get the DQModelMetaInfo instance of the query model
-    DQModelMetaInfo *metaInfo();
+    DQModelMetaInfo *metaInfo() const;
 
     /// Get the field for result column
-    QStringList fields();
+    QStringList fields() const;
 
     /// Get the field for orderBy
-    QStringList orderBy();
+    QStringList orderBy() const;
+
+    /// Get the foreign keys which should be loaded by JOIN
+    QStringList related() const;
+
+    /// Get the fields which should be left out from the result
+    QStringList deferred() const;
+
+    /// Get the fields of GROUP BY
+    QStringList groupBy() const;
+
+    /// Get the HAVING clause
+    DQExpression having() const;
 
 private:
     QSharedDataPointer<DQSharedQueryPriv> data;
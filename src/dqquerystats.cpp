@@ -0,0 +1,118 @@
+#include <QtCore>
+#include "dqquerystats.h"
+
+/* Test cases:
+
+  coretests::queryStats()
+  sqlitetests::profiling()
+
+ */
+
+static inline bool _dqIsIdentifierChar(QChar c) {
+    return c.isLetterOrNumber() || c == '_' || c == '$';
+}
+
+DQQueryStats::DQQueryStats() : histogram(BucketCount,0) {
+    calls = 0;
+    failures = 0;
+    rows = 0;
+    prepareTime = 0;
+    execTime = 0;
+    hydrationTime = 0;
+    maxTime = 0;
+    retries = 0;
+    busyTime = 0;
+}
+
+qint64 DQQueryStats::totalTime() const{
+    return prepareTime + execTime + hydrationTime;
+}
+
+double DQQueryStats::averageTime() const{
+    if (calls == 0)
+        return 0;
+    return (double) totalTime() / calls;
+}
+
+qint64 DQQueryStats::bucketBound(int bucket){
+    if (bucket >= BucketCount - 1)
+        return Q_INT64_C(0x7fffffffffffffff);
+    return Q_INT64_C(1) << (bucket + 1);
+}
+
+int DQQueryStats::bucketOf(qint64 usecs){
+    int bucket = 0;
+    while (bucket < BucketCount - 1 && usecs >= bucketBound(bucket))
+        bucket++;
+    return bucket;
+}
+
+QString DQQueryStats::normalize(const QString &sql){
+    QString res;
+    res.reserve(sql.size());
+
+    int n = sql.size();
+    int i = 0;
+    while (i < n) {
+        QChar c = sql.at(i);
+
+        if (c == '\'') {
+            // String literal. '' is an escaped quote
+            i++;
+            while (i < n) {
+                if (sql.at(i) == '\'') {
+                    if (i + 1 < n && sql.at(i + 1) == '\'') {
+                        i += 2;
+                        continue;
+                    }
+                    break;
+                }
+                i++;
+            }
+            i++;
+            res += '?';
+            continue;
+        }
+
+        if (c == '"') {
+            // Quoted identifier is kept
+            int end = sql.indexOf('"',i + 1);
+            if (end < 0)
+                end = n - 1;
+            res += sql.mid(i,end - i + 1);
+            i = end + 1;
+            continue;
+        }
+
+        if (c == ':' && i + 1 < n && _dqIsIdentifierChar(sql.at(i + 1))) {
+            // Named placeholder
+            i++;
+            while (i < n && _dqIsIdentifierChar(sql.at(i)))
+                i++;
+            res += '?';
+            continue;
+        }
+
+        if (c.isDigit() && (res.isEmpty() || !_dqIsIdentifierChar(res.at(res.size() - 1)))) {
+            // Numeric literal
+            while (i < n && (sql.at(i).isDigit() || sql.at(i) == '.'))
+                i++;
+            res += '?';
+            continue;
+        }
+
+        res += c;
+        i++;
+    }
+
+    // The list of values (e.g "IN (?,?,?)") is treated as single value
+    int length;
+    do {
+        length = res.size();
+        res.replace("?,?","?");
+        res.replace("?, ?","?");
+        res.replace("? , ?","?");
+    } while (res.size() != length);
+
+    return res;
+}
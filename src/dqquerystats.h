@@ -0,0 +1,87 @@
+#ifndef DQQUERYSTATS_H
+#define DQQUERYSTATS_H
+
+#include <QString>
+#include <QVector>
+
+/// The aggregated timing of a SQL statement
+/**
+  DQQueryStats is collected by DQConnection when the profiling is enabled.
+  The statements that only differ in the bound values or literals are
+  aggregated into a single entry , for example:
+
+\code
+    SELECT id,name FROM user WHERE id = ? LIMIT ?
+\endcode
+
+  All the time values are in microseconds.
+
+  @see DQConnection::setProfilingEnabled()
+ */
+class DQQueryStats
+{
+public:
+    /// No. of buckets of histogram
+    enum {
+        BucketCount = 24
+    };
+
+    DQQueryStats();
+
+    /// The normalized SQL statement
+    QString sql;
+
+    /// No. of execution
+    int calls;
+
+    /// No. of failed execution
+    int failures;
+
+    /// No. of rows read into models by DQSharedQuery::all() / get()
+    qint64 rows;
+
+    /// Total time spent in preparing the statement
+    qint64 prepareTime;
+
+    /// Total time spent in executing the statement
+    qint64 execTime;
+
+    /// Total time spent in fetching the rows and writing them to models
+    qint64 hydrationTime;
+
+    /// The longest time of a single call
+    qint64 maxTime;
+
+    /// No. of retries after the statement was blocked by other connection
+    /**
+      @see DQConnection::busyStats()
+     */
+    int retries;
+
+    /// Total time slept before the retries
+    qint64 busyTime;
+
+    /// No. of calls by their time
+    /**
+      The bucket i counts the calls took less than bucketBound(i) microseconds
+      (and not less than bucketBound(i - 1)). The last bucket counts all the remaining calls.
+     */
+    QVector<int> histogram;
+
+    /// The total time of all the calls
+    qint64 totalTime() const;
+
+    /// The mean time of a call
+    double averageTime() const;
+
+    /// The upper bound of a histogram bucket in microseconds
+    static qint64 bucketBound(int bucket);
+
+    /// The histogram bucket of a time in microseconds
+    static int bucketOf(qint64 usecs);
+
+    /// Replace the literals and bind placeholders of a SQL statement by "?"
+    static QString normalize(const QString &sql);
+};
+
+#endif // DQQUERYSTATS_H
@@ -0,0 +1,32 @@
+#include <QtCore>
+#include "dqretrypolicy.h"
+
+/* Test cases:
+
+  coretests::retryPolicy()
+  sqlitetests::busyRetry()
+
+ */
+
+DQRetryPolicy::DQRetryPolicy(int timeout) : timeout(timeout) {
+    initialDelay = 1;
+    maxDelay = 100;
+    multiplier = 2;
+    jitter = 0.5;
+}
+
+bool DQRetryPolicy::isNull() const{
+    return timeout < 0;
+}
+
+int DQRetryPolicy::delay(int retry,double random) const{
+    double res = qMax(initialDelay , 1);
+    for (int i = 0 ; i < retry && res < maxDelay ; i++)
+        res *= qMax(multiplier , 1.0);
+    res = qMin(res , (double) qMax(maxDelay , 1));
+
+    double fraction = qBound(0.0 , jitter , 1.0) * qBound(0.0 , random , 1.0);
+    res -= res * fraction;
+
+    return qMax((int) res , 1);
+}
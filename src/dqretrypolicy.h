@@ -0,0 +1,73 @@
+#ifndef DQRETRYPOLICY_H
+#define DQRETRYPOLICY_H
+
+/// The retry policy of a statement blocked by the lock of other connection
+/**
+  SQLite allows a single writer. A statement which could not take the lock
+  fails with SQLITE_BUSY , unless a busy handler of the connection asks to
+  retry. The handler installed by DQRetryPolicy sleeps with exponential
+  backoff between the retries:
+
+\code
+    delay(n) = min(initialDelay * multiplier ^ n , maxDelay) * (1 - jitter * random(0,1))
+\endcode
+
+  until the statement has waited for timeout milliseconds in total.
+  The jitter spreads the retries of the processes blocked by the same writer.
+
+  It replaces PRAGMA busy_timeout , which polls at fixed intervals.
+
+  Example:
+
+\code
+    DQConnectionOptions options = DQConnectionOptions::profile("balanced");
+    options.retryPolicy = DQRetryPolicy(10000);
+
+    connection.open(db,options);
+\endcode
+
+  @remarks SQLite does not call the busy handler if the wait could deadlock ,
+  e.g a deferred transaction upgrading from read to write. The transaction should be
+  started by BEGIN IMMEDIATE in that case. The handler requires DQuest built with
+  CONFIG += dquest_sqlite_api , otherwise only the timeout is applied by PRAGMA busy_timeout
+  and DQConnection::busyStats() is empty.
+
+  @see DQConnection::setRetryPolicy()
+ */
+class DQRetryPolicy
+{
+public:
+    /// Construct a policy
+    /**
+      @param timeout The max. wait of a statement in milliseconds. Negative value construct a null policy.
+     */
+    explicit DQRetryPolicy(int timeout = -1);
+
+    /// TRUE if the policy is not set
+    bool isNull() const;
+
+    /// The max. total wait of a statement in milliseconds
+    int timeout;
+
+    /// The delay before the first retry in milliseconds. The default value is 1
+    int initialDelay;
+
+    /// The max. delay between two retries in milliseconds. The default value is 100
+    int maxDelay;
+
+    /// The growth of delay per retry. The default value is 2
+    double multiplier;
+
+    /// The fraction of delay to be randomized , from 0 to 1. The default value is 0.5
+    double jitter;
+
+    /// The delay before a retry
+    /**
+      @param retry The no. of retries done
+      @param random A random no. from 0 to 1
+      @return The delay in milliseconds. It is at least 1.
+     */
+    int delay(int retry,double random) const;
+};
+
+#endif // DQRETRYPOLICY_H
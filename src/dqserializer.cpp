@@ -0,0 +1,1446 @@
+#include <QtCore>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include "dqserializer.h"
+#include "dqmodelmetainfo.h"
+
+/* Test cases:
+
+  coretests::serializer()
+
+ */
+
+/// The size of output buffer flushed to device by DQSerializer
+#ifndef DQ_SERIALIZER_BUFFER_SIZE
+#define DQ_SERIALIZER_BUFFER_SIZE (64 * 1024)
+#endif
+
+/// The magic number of the binary format
+#define DQ_BINARY_MAGIC "DQB\x01"
+
+/// The section markers of the binary format
+enum {
+    _DQBinaryTable = 'T',
+    _DQBinaryRecord = 'R',
+    _DQBinaryEnd = 'E'
+};
+
+/// The encoding of a field value. It is also the type code of the binary format.
+enum _DQValueType {
+    _DQText = 0,
+    _DQInteger,
+    _DQReal,
+    _DQBlob,
+    _DQBool,
+    _DQDate,
+    _DQTime,
+    _DQDateTime,
+    _DQStringList
+};
+
+static int _dqValueType(int type) {
+    switch (type) {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+        return _DQInteger;
+    case QVariant::Double:
+    case QMetaType::Float:
+        return _DQReal;
+    case QVariant::ByteArray:
+        return _DQBlob;
+    case QVariant::Bool:
+        return _DQBool;
+    case QVariant::Date:
+        return _DQDate;
+    case QVariant::Time:
+        return _DQTime;
+    case QVariant::DateTime:
+        return _DQDateTime;
+    case QVariant::StringList:
+        return _DQStringList;
+    default:
+        return _DQText;
+    }
+}
+
+/// No. of bytes of a string in UTF-8
+static int _dqUtf8Length(const QString &string) {
+    int res = 0;
+    const QChar *c = string.constData();
+    int n = string.size();
+    for (int i = 0 ; i < n;i++) {
+        ushort u = c[i].unicode();
+        if (u < 0x80)
+            res += 1;
+        else if (u < 0x800)
+            res += 2;
+        else if (QChar::isHighSurrogate(u) && i + 1 < n && QChar::isLowSurrogate(c[i + 1].unicode())) {
+            res += 4;
+            i++;
+        } else
+            res += 3;
+    }
+    return res;
+}
+
+static inline void _dqAppendCodePoint(QByteArray &out,uint code) {
+    if (code < 0x80) {
+        out += (char) code;
+    } else if (code < 0x800) {
+        out += (char) (0xc0 | (code >> 6));
+        out += (char) (0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+        out += (char) (0xe0 | (code >> 12));
+        out += (char) (0x80 | ((code >> 6) & 0x3f));
+        out += (char) (0x80 | (code & 0x3f));
+    } else {
+        out += (char) (0xf0 | (code >> 18));
+        out += (char) (0x80 | ((code >> 12) & 0x3f));
+        out += (char) (0x80 | ((code >> 6) & 0x3f));
+        out += (char) (0x80 | (code & 0x3f));
+    }
+}
+
+/// Append a string in UTF-8. If json is TRUE , the JSON special characters are escaped.
+static void _dqAppendUtf8(QByteArray &out,const QString &string,bool json) {
+    static const char hex[] = "0123456789abcdef";
+    const QChar *c = string.constData();
+    int n = string.size();
+    for (int i = 0 ; i < n;i++) {
+        uint u = c[i].unicode();
+        if (json && (u < 0x20 || u == '"' || u == '\\')) {
+            out += '\\';
+            switch (u) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '\n': out += 'n'; break;
+            case '\r': out += 'r'; break;
+            case '\t': out += 't'; break;
+            default:
+                out += "u00";
+                out += hex[u >> 4];
+                out += hex[u & 0xf];
+                break;
+            }
+            continue;
+        }
+
+        if (QChar::isHighSurrogate(u) && i + 1 < n && QChar::isLowSurrogate(c[i + 1].unicode())) {
+            u = QChar::surrogateToUcs4(u,c[i + 1].unicode());
+            i++;
+        }
+        _dqAppendCodePoint(out,u);
+    }
+}
+
+/// The ISO 8601 text of date / time values
+static QString _dqIsoText(const QVariant &value,int valueType) {
+    switch (valueType) {
+    case _DQDate:
+        return value.toDate().toString(Qt::ISODate);
+    case _DQTime:
+        return value.toTime().toString(Qt::ISODate);
+    default:
+        return value.toDateTime().toString(Qt::ISODate);
+    }
+}
+
+/// The field table of a meta info used by serializer
+class _DQFieldTable {
+public:
+    _DQFieldTable() : metaInfo(0) {
+    }
+
+    void build(const DQModelMetaInfo *metaInfo) {
+        this->metaInfo = metaInfo;
+        int n = metaInfo->size();
+        jsonKeys.resize(n);
+        types.resize(n);
+        for (int i = 0 ; i < n;i++) {
+            const DQModelMetaInfoField *field = metaInfo->at(i);
+            QByteArray key = "\"";
+            _dqAppendUtf8(key,field->name,true);
+            key += "\":";
+            jsonKeys[i] = key;
+            types[i] = _dqValueType(field->type);
+        }
+    }
+
+    const DQModelMetaInfo *metaInfo;
+
+    /// The pre-encoded JSON keys , e.g "name":
+    QVector<QByteArray> jsonKeys;
+
+    QVector<int> types;
+};
+
+class DQSerializerPriv {
+public:
+    DQSerializerPriv() : device(0) , format(DQSerializer::Json) , count(0) , started(false) , finished(false) , failed(false) ,
+        last(0) , binaryTable(0) {
+    }
+
+    bool flush() {
+        if (buffer.isEmpty() || failed)
+            return !failed;
+
+        if (device->write(buffer) != buffer.size()) {
+            qWarning() << QString("DQSerializer::write() - Failed to write the device : %1").arg(device->errorString());
+            failed = true;
+        }
+        buffer.resize(0);
+        return !failed;
+    }
+
+    /// The table of the meta info. It is built on first use.
+    const _DQFieldTable& table(const DQModelMetaInfo *metaInfo) {
+        if (last && last->metaInfo == metaInfo)
+            return *last;
+
+        if (!tables.contains(metaInfo))
+            tables[metaInfo].build(metaInfo);
+        last = &tables[metaInfo];
+        return *last;
+    }
+
+    // CBOR
+
+    void cborHead(int major,quint64 value) {
+        char m = (char) (major << 5);
+        if (value < 24) {
+            buffer += (char) (m | value);
+        } else if (value <= 0xff) {
+            buffer += (char) (m | 24);
+            buffer += (char) value;
+        } else if (value <= 0xffff) {
+            buffer += (char) (m | 25);
+            appendBigEndian(value,2);
+        } else if (value <= Q_UINT64_C(0xffffffff)) {
+            buffer += (char) (m | 26);
+            appendBigEndian(value,4);
+        } else {
+            buffer += (char) (m | 27);
+            appendBigEndian(value,8);
+        }
+    }
+
+    void appendBigEndian(quint64 value,int bytes) {
+        for (int i = bytes - 1 ; i >= 0 ; i--)
+            buffer += (char) ((value >> (i * 8)) & 0xff);
+    }
+
+    void cborText(const QString &text) {
+        cborHead(3,_dqUtf8Length(text));
+        _dqAppendUtf8(buffer,text,false);
+    }
+
+    void cborValue(const QVariant &value,int type) {
+        if (value.isNull()) {
+            buffer += (char) 0xf6;
+            return;
+        }
+
+        switch (type) {
+        case _DQInteger: {
+            qint64 v = value.toLongLong();
+            if (v >= 0)
+                cborHead(0,(quint64) v);
+            else
+                cborHead(1,(quint64) (-(v + 1)));
+            break;
+        }
+        case _DQReal: {
+            double v = value.toDouble();
+            quint64 bits;
+            memcpy(&bits,&v,sizeof(bits));
+            buffer += (char) 0xfb;
+            appendBigEndian(bits,8);
+            break;
+        }
+        case _DQBlob: {
+            QByteArray v = value.toByteArray();
+            cborHead(2,v.size());
+            buffer += v;
+            break;
+        }
+        case _DQBool:
+            buffer += (char) (value.toBool() ? 0xf5 : 0xf4);
+            break;
+        case _DQDate:
+            cborHead(6,1004);
+            cborText(_dqIsoText(value,type));
+            break;
+        case _DQDateTime:
+            cborHead(6,0);
+            cborText(_dqIsoText(value,type));
+            break;
+        case _DQTime:
+            cborText(_dqIsoText(value,type));
+            break;
+        case _DQStringList: {
+            QStringList list = value.toStringList();
+            cborHead(4,list.size());
+            foreach (QString item , list)
+                cborText(item);
+            break;
+        }
+        default:
+            cborText(value.toString());
+            break;
+        }
+    }
+
+    // JSON
+
+    void jsonText(const QString &text) {
+        buffer += '"';
+        _dqAppendUtf8(buffer,text,true);
+        buffer += '"';
+    }
+
+    void jsonValue(const QVariant &value,int type) {
+        if (value.isNull()) {
+            buffer += "null";
+            return;
+        }
+
+        switch (type) {
+        case _DQInteger:
+            buffer += QByteArray::number(value.toLongLong());
+            break;
+        case _DQReal: {
+            double v = value.toDouble();
+            if (qIsNaN(v) || qIsInf(v))
+                buffer += "null"; // Not representable in JSON
+            else
+                buffer += QByteArray::number(v,'g',17);
+            break;
+        }
+        case _DQBlob:
+            buffer += '"';
+            buffer += value.toByteArray().toBase64();
+            buffer += '"';
+            break;
+        case _DQBool:
+            buffer += value.toBool() ? "true" : "false";
+            break;
+        case _DQDate:
+        case _DQTime:
+        case _DQDateTime:
+            jsonText(_dqIsoText(value,type));
+            break;
+        case _DQStringList: {
+            QStringList list = value.toStringList();
+            buffer += '[';
+            for (int i = 0 ; i < list.size();i++) {
+                if (i > 0)
+                    buffer += ',';
+                jsonText(list.at(i));
+            }
+            buffer += ']';
+            break;
+        }
+        default:
+            jsonText(value.toString());
+            break;
+        }
+    }
+
+    // Binary
+
+    void varint(quint64 value) {
+        while (value >= 0x80) {
+            buffer += (char) ((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        buffer += (char) value;
+    }
+
+    inline void zigzag(qint64 value) {
+        varint(((quint64) value << 1) ^ (quint64) (value >> 63));
+    }
+
+    void binaryText(const QString &text) {
+        varint(_dqUtf8Length(text));
+        _dqAppendUtf8(buffer,text,false);
+    }
+
+    void writeBinaryTable(const _DQFieldTable &table) {
+        buffer += (char) _DQBinaryTable;
+        int n = table.types.size();
+        varint(n);
+        for (int i = 0 ; i < n;i++) {
+            binaryText(table.metaInfo->at(i)->name);
+            buffer += (char) table.types.at(i);
+        }
+    }
+
+    void binaryValue(const QVariant &value,int type) {
+        switch (type) {
+        case _DQInteger:
+            zigzag(value.toLongLong());
+            break;
+        case _DQReal: {
+            double v = value.toDouble();
+            quint64 bits;
+            memcpy(&bits,&v,sizeof(bits));
+            for (int i = 0 ; i < 8;i++)
+                buffer += (char) ((bits >> (i * 8)) & 0xff);
+            break;
+        }
+        case _DQBlob: {
+            QByteArray v = value.toByteArray();
+            varint(v.size());
+            buffer += v;
+            break;
+        }
+        case _DQBool:
+            buffer += (char) (value.toBool() ? 1 : 0);
+            break;
+        case _DQDate:
+            zigzag(value.toDate().toJulianDay());
+            break;
+        case _DQTime:
+            varint(QTime(0,0).msecsTo(value.toTime()));
+            break;
+        case _DQDateTime:
+            zigzag(value.toDateTime().toMSecsSinceEpoch());
+            break;
+        case _DQStringList: {
+            QStringList list = value.toStringList();
+            varint(list.size());
+            foreach (QString item , list)
+                binaryText(item);
+            break;
+        }
+        default:
+            binaryText(value.toString());
+            break;
+        }
+    }
+
+    QIODevice *device;
+    DQSerializer::Format format;
+    int count;
+    bool started;
+    bool finished;
+    bool failed;
+
+    QByteArray buffer;
+
+    QHash<const DQModelMetaInfo*,_DQFieldTable> tables;
+
+    /// The table of last written model
+    const _DQFieldTable *last;
+
+    /// The meta info of last binary table header
+    const DQModelMetaInfo *binaryTable;
+};
+
+DQSerializer::DQSerializer(QIODevice *device,Format format) {
+    d = new DQSerializerPriv();
+    d->device = device;
+    d->format = format;
+    d->buffer.reserve(DQ_SERIALIZER_BUFFER_SIZE + 4096);
+}
+
+DQSerializer::~DQSerializer() {
+    finish();
+    delete d;
+}
+
+bool DQSerializer::write(const DQAbstractModel *model) {
+    if (d->finished) {
+        qWarning() << "DQSerializer::write() - The serializer is finished";
+        return false;
+    }
+
+    if (d->failed)
+        return false;
+
+    if (!d->started) {
+        d->started = true;
+        switch (d->format) {
+        case Json:
+            d->buffer += '[';
+            break;
+        case Cbor:
+            d->buffer += (char) 0x9f; // Indefinite-length array
+            break;
+        case Binary:
+            d->buffer += DQ_BINARY_MAGIC;
+            break;
+        }
+    }
+
+    const DQModelMetaInfo *metaInfo = model->metaInfo();
+    const _DQFieldTable &table = d->table(metaInfo);
+    int n = table.types.size();
+
+    switch (d->format) {
+    case Json:
+        if (d->count > 0)
+            d->buffer += ',';
+        d->buffer += '{';
+        for (int i = 0 ; i < n;i++) {
+            if (i > 0)
+                d->buffer += ',';
+            d->buffer += table.jsonKeys.at(i);
+            d->jsonValue(metaInfo->value(model,i),table.types.at(i));
+        }
+        d->buffer += '}';
+        break;
+
+    case Cbor:
+        d->cborHead(5,n);
+        for (int i = 0 ; i < n;i++) {
+            d->cborText(metaInfo->at(i)->name);
+            d->cborValue(metaInfo->value(model,i),table.types.at(i));
+        }
+        break;
+
+    case Binary: {
+        if (d->binaryTable != metaInfo) {
+            d->writeBinaryTable(table);
+            d->binaryTable = metaInfo;
+        }
+
+        d->buffer += (char) _DQBinaryRecord;
+
+        // The null bitmap is filled after the values are read
+        int bitmap = d->buffer.size();
+        int bitmapSize = (n + 7) / 8;
+        for (int i = 0 ; i < bitmapSize;i++)
+            d->buffer += (char) 0;
+
+        for (int i = 0 ; i < n;i++) {
+            QVariant value = metaInfo->value(model,i);
+            if (value.isNull()) {
+                char *bits = d->buffer.data() + bitmap;
+                bits[i / 8] = (char) (bits[i / 8] | (1 << (i % 8)));
+                continue;
+            }
+            d->binaryValue(value,table.types.at(i));
+        }
+        break;
+    }
+    }
+
+    d->count++;
+
+    if (d->buffer.size() >= DQ_SERIALIZER_BUFFER_SIZE)
+        return d->flush();
+
+    return true;
+}
+
+bool DQSerializer::write(const DQSharedList &list) {
+    int n = list.size();
+    for (int i = 0 ; i < n;i++) {
+        if (!write(list.at(i)))
+            return false;
+    }
+    return true;
+}
+
+bool DQSerializer::finish() {
+    if (d->finished)
+        return !d->failed;
+
+    d->finished = true;
+
+    switch (d->format) {
+    case Json:
+        if (!d->started)
+            d->buffer += '[';
+        d->buffer += ']';
+        break;
+    case Cbor:
+        if (!d->started)
+            d->buffer += (char) 0x9f;
+        d->buffer += (char) 0xff; // Break
+        break;
+    case Binary:
+        if (!d->started)
+            d->buffer += DQ_BINARY_MAGIC;
+        d->buffer += (char) _DQBinaryEnd;
+        break;
+    }
+
+    return d->flush();
+}
+
+int DQSerializer::count() const {
+    return d->count;
+}
+
+DQSerializer::Format DQSerializer::format() const {
+    return d->format;
+}
+
+/// The field of a binary table header
+class _DQBinaryField {
+public:
+    QString name;
+    int type;
+};
+
+class DQDeserializerPriv {
+public:
+    DQDeserializerPriv() : device(0) , format(DQSerializer::Json) , pos(0) , started(false) , ended(false) ,
+        remaining(-1) , error(false) , mappedMetaInfo(0) {
+    }
+
+    /// Make sure n bytes are available in buffer
+    bool fill(int n) {
+        if (buffer.size() - pos >= n)
+            return true;
+
+        if (pos > 0) {
+            buffer.remove(0,pos);
+            pos = 0;
+        }
+
+        while (buffer.size() < n) {
+            QByteArray chunk = device->read(qMax(n - buffer.size() , DQ_SERIALIZER_BUFFER_SIZE));
+            if (chunk.isEmpty()) {
+                if (!device->waitForReadyRead(-1))
+                    return false;
+                continue;
+            }
+            buffer += chunk;
+        }
+        return true;
+    }
+
+    bool fail(const QString &message) {
+        if (!error) {
+            error = true;
+            errorString = message;
+            qWarning() << QString("DQDeserializer::next() - %1").arg(message);
+        }
+        return false;
+    }
+
+    /// Read a byte. It is -1 on the end of input.
+    inline int get() {
+        if (!fill(1))
+            return -1;
+        return (uchar) buffer.at(pos++);
+    }
+
+    inline int peek() {
+        if (!fill(1))
+            return -1;
+        return (uchar) buffer.at(pos);
+    }
+
+    bool readBytes(int n,QByteArray &out) {
+        if (n < 0 || !fill(n))
+            return false;
+        out = buffer.mid(pos,n);
+        pos += n;
+        return true;
+    }
+
+    /// Convert a decoded value to the type of field
+    static QVariant convert(const QVariant &value,int type) {
+        if (value.isNull())
+            return QVariant();
+
+        switch (_dqValueType(type)) {
+        case _DQBlob:
+            if (value.type() == QVariant::String)
+                return QByteArray::fromBase64(value.toString().toLatin1());
+            return value;
+        case _DQDate:
+            if (value.type() == QVariant::String)
+                return QDate::fromString(value.toString(),Qt::ISODate);
+            return value;
+        case _DQTime:
+            if (value.type() == QVariant::String)
+                return QTime::fromString(value.toString(),Qt::ISODate);
+            return value;
+        case _DQDateTime:
+            if (value.type() == QVariant::String)
+                return QDateTime::fromString(value.toString(),Qt::ISODate);
+            return value;
+        case _DQStringList:
+            return value.toStringList();
+        default:
+            return value;
+        }
+    }
+
+    /// Set a field by name. The unknown field is skipped.
+    void setField(DQAbstractModel *model,const QString &name,const QVariant &value) {
+        DQModelMetaInfo *metaInfo = model->metaInfo();
+        int index = metaInfo->indexOf(name);
+        if (index < 0)
+            return;
+        metaInfo->setValue(model,index,convert(value,metaInfo->at(index)->type));
+        assigned[index] = true;
+    }
+
+    /// Set the fields not found in the record to null
+    void beginRecord(DQAbstractModel *model) {
+        assigned.fill(false,model->metaInfo()->size());
+    }
+
+    void endRecord(DQAbstractModel *model) {
+        DQModelMetaInfo *metaInfo = model->metaInfo();
+        for (int i = 0 ; i < assigned.size();i++) {
+            if (!assigned.at(i))
+                metaInfo->setValue(model,i,QVariant());
+        }
+    }
+
+    // JSON
+
+    void skipSpace() {
+        int c;
+        while ((c = peek()) == ' ' || c == '\n' || c == '\r' || c == '\t')
+            pos++;
+    }
+
+    bool jsonLiteral(const char *literal) {
+        int n = strlen(literal);
+        if (!fill(n) || strncmp(buffer.constData() + pos,literal,n) != 0)
+            return fail("Invalid JSON literal");
+        pos += n;
+        return true;
+    }
+
+    bool jsonHex(uint *code) {
+        *code = 0;
+        for (int i = 0 ; i < 4;i++) {
+            int c = get();
+            int v;
+            if (c >= '0' && c <= '9')
+                v = c - '0';
+            else if (c >= 'a' && c <= 'f')
+                v = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                v = c - 'A' + 10;
+            else
+                return fail("Invalid \\u escape");
+            *code = (*code << 4) | v;
+        }
+        return true;
+    }
+
+    bool jsonString(QString &out) {
+        if (get() != '"')
+            return fail("String is expected");
+
+        text.resize(0);
+        for (;;) {
+            int c = get();
+            if (c < 0)
+                return fail("Unterminated string");
+            if (c == '"')
+                break;
+            if (c != '\\') {
+                text += (char) c;
+                continue;
+            }
+
+            c = get();
+            switch (c) {
+            case '"': case '\\': case '/': text += (char) c; break;
+            case 'b': text += '\b'; break;
+            case 'f': text += '\f'; break;
+            case 'n': text += '\n'; break;
+            case 'r': text += '\r'; break;
+            case 't': text += '\t'; break;
+            case 'u': {
+                uint code;
+                if (!jsonHex(&code))
+                    return false;
+                if (QChar::isHighSurrogate(code) && peek() == '\\') {
+                    pos++;
+                    uint low;
+                    if (get() != 'u' || !jsonHex(&low) || !QChar::isLowSurrogate(low))
+                        return fail("Invalid surrogate pair");
+                    code = QChar::surrogateToUcs4(code,low);
+                }
+                _dqAppendCodePoint(text,code);
+                break;
+            }
+            default:
+                return fail("Invalid escape");
+            }
+        }
+
+        out = QString::fromUtf8(text.constData(),text.size());
+        return true;
+    }
+
+    bool jsonValue(QVariant &out) {
+        skipSpace();
+        int c = peek();
+        switch (c) {
+        case '"': {
+            QString s;
+            if (!jsonString(s))
+                return false;
+            out = s;
+            return true;
+        }
+        case 'n':
+            out = QVariant();
+            return jsonLiteral("null");
+        case 't':
+            out = true;
+            return jsonLiteral("true");
+        case 'f':
+            out = false;
+            return jsonLiteral("false");
+        case '[': {
+            pos++;
+            QVariantList list;
+            skipSpace();
+            if (peek() == ']') {
+                pos++;
+                out = list;
+                return true;
+            }
+            for (;;) {
+                QVariant item;
+                if (!jsonValue(item))
+                    return false;
+                list << item;
+                skipSpace();
+                c = get();
+                if (c == ']')
+                    break;
+                if (c != ',')
+                    return fail("',' or ']' is expected");
+            }
+            out = list;
+            return true;
+        }
+        case '{': {
+            pos++;
+            QVariantMap map;
+            skipSpace();
+            if (peek() == '}') {
+                pos++;
+                out = map;
+                return true;
+            }
+            for (;;) {
+                QString key;
+                QVariant item;
+                skipSpace();
+                if (!jsonString(key))
+                    return false;
+                skipSpace();
+                if (get() != ':')
+                    return fail("':' is expected");
+                if (!jsonValue(item))
+                    return false;
+                map[key] = item;
+                skipSpace();
+                c = get();
+                if (c == '}')
+                    break;
+                if (c != ',')
+                    return fail("',' or '}' is expected");
+            }
+            out = map;
+            return true;
+        }
+        default: {
+            text.resize(0);
+            bool real = false;
+            while ((c = peek()) >= 0 && (isdigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')) {
+                if (c == '.' || c == 'e' || c == 'E')
+                    real = true;
+                text += (char) c;
+                pos++;
+            }
+            bool ok;
+            if (real)
+                out = text.toDouble(&ok);
+            else
+                out = text.toLongLong(&ok);
+            if (!ok)
+                return fail("Invalid JSON value");
+            return true;
+        }
+        }
+    }
+
+    bool jsonNext(DQAbstractModel *model) {
+        skipSpace();
+        if (!started) {
+            started = true;
+            if (get() != '[')
+                return fail("JSON array is expected");
+            skipSpace();
+            if (peek() == ']') {
+                pos++;
+                ended = true;
+                return false;
+            }
+        } else {
+            int c = get();
+            if (c == ']') {
+                ended = true;
+                return false;
+            }
+            if (c != ',')
+                return fail("',' or ']' is expected");
+            skipSpace();
+        }
+
+        if (get() != '{')
+            return fail("JSON object is expected");
+
+        beginRecord(model);
+        skipSpace();
+        if (peek() == '}') {
+            pos++;
+        } else {
+            for (;;) {
+                QString key;
+                QVariant value;
+                skipSpace();
+                if (!jsonString(key))
+                    return false;
+                skipSpace();
+                if (get() != ':')
+                    return fail("':' is expected");
+                if (!jsonValue(value))
+                    return false;
+                setField(model,key,value);
+                skipSpace();
+                int c = get();
+                if (c == '}')
+                    break;
+                if (c != ',')
+                    return fail("',' or '}' is expected");
+            }
+        }
+        endRecord(model);
+
+        skipSpace();
+        return true;
+    }
+
+    // CBOR
+
+    /// Read the argument of an initial byte. It is -1 for indefinite length.
+    bool cborArgument(int info,qint64 *arg,quint64 *raw = 0) {
+        quint64 value = 0;
+        int bytes = 0;
+        if (info < 24) {
+            value = info;
+        } else if (info <= 27) {
+            bytes = 1 << (info - 24);
+            if (!fill(bytes))
+                return fail("Truncated CBOR item");
+            for (int i = 0 ; i < bytes;i++)
+                value = (value << 8) | (uchar) buffer.at(pos++);
+        } else if (info == 31) {
+            *arg = -1;
+            if (raw)
+                *raw = 0;
+            return true;
+        } else {
+            return fail("Invalid CBOR item");
+        }
+
+        *arg = (qint64) value;
+        if (raw)
+            *raw = value;
+        return true;
+    }
+
+    bool cborString(int major,qint64 length,QByteArray &out) {
+        if (length >= 0) {
+            if (!readBytes((int) length,out))
+                return fail("Truncated CBOR string");
+            return true;
+        }
+
+        // Indefinite length. The chunks are definite strings of the same type
+        out.clear();
+        for (;;) {
+            int b = get();
+            if (b == 0xff)
+                return true;
+            qint64 n;
+            if (b < 0 || (b >> 5) != major || !cborArgument(b & 31,&n) || n < 0)
+                return fail("Invalid CBOR string chunk");
+            QByteArray chunk;
+            if (!readBytes((int) n,chunk))
+                return fail("Truncated CBOR string");
+            out += chunk;
+        }
+    }
+
+    bool cborValue(QVariant &out) {
+        int b = get();
+        if (b < 0)
+            return fail("Truncated CBOR item");
+
+        int major = b >> 5;
+        int info = b & 31;
+        qint64 arg;
+        quint64 raw;
+
+        if (major != 7 && !cborArgument(info,&arg,&raw))
+            return false;
+
+        switch (major) {
+        case 0:
+            if (raw > (quint64) Q_INT64_C(0x7fffffffffffffff))
+                out = (qulonglong) raw;
+            else
+                out = (qlonglong) raw;
+            return true;
+        case 1:
+            out = (qlonglong) (-1 - (qint64) raw);
+            return true;
+        case 2: {
+            QByteArray data;
+            if (!cborString(2,arg,data))
+                return false;
+            out = data;
+            return true;
+        }
+        case 3: {
+            QByteArray data;
+            if (!cborString(3,arg,data))
+                return false;
+            out = QString::fromUtf8(data.constData(),data.size());
+            return true;
+        }
+        case 4: {
+            QVariantList list;
+            for (qint64 i = 0 ; arg < 0 || i < arg;i++) {
+                if (arg < 0 && peek() == 0xff) {
+                    pos++;
+                    break;
+                }
+                QVariant item;
+                if (!cborValue(item))
+                    return false;
+                list << item;
+            }
+            out = list;
+            return true;
+        }
+        case 5: {
+            QVariantMap map;
+            for (qint64 i = 0 ; arg < 0 || i < arg;i++) {
+                if (arg < 0 && peek() == 0xff) {
+                    pos++;
+                    break;
+                }
+                QVariant key,item;
+                if (!cborValue(key) || !cborValue(item))
+                    return false;
+                map[key.toString()] = item;
+            }
+            out = map;
+            return true;
+        }
+        case 6:
+            // The tagged value is converted by the type of field
+            return cborValue(out);
+        default:
+            return cborSimple(info,out);
+        }
+    }
+
+    bool cborSimple(int info,QVariant &out) {
+        switch (info) {
+        case 20:
+            out = false;
+            return true;
+        case 21:
+            out = true;
+            return true;
+        case 22:
+        case 23:
+            out = QVariant();
+            return true;
+        case 25: {
+            // Half precision
+            if (!fill(2))
+                return fail("Truncated CBOR item");
+            int half = ((uchar) buffer.at(pos) << 8) | (uchar) buffer.at(pos + 1);
+            pos += 2;
+            int exp = (half >> 10) & 0x1f;
+            int mant = half & 0x3ff;
+            double v;
+            if (exp == 0)
+                v = ldexp((double) mant,-24);
+            else if (exp != 31)
+                v = ldexp((double) (mant + 1024),exp - 25);
+            else
+                v = mant == 0 ? qInf() : qQNaN();
+            out = (half & 0x8000) ? -v : v;
+            return true;
+        }
+        case 26: {
+            qint64 bits;
+            if (!cborArgument(26,&bits))
+                return false;
+            quint32 v32 = (quint32) bits;
+            float f;
+            memcpy(&f,&v32,sizeof(f));
+            out = (double) f;
+            return true;
+        }
+        case 27: {
+            quint64 bits;
+            qint64 arg;
+            if (!cborArgument(27,&arg,&bits))
+                return false;
+            double v;
+            memcpy(&v,&bits,sizeof(v));
+            out = v;
+            return true;
+        }
+        default:
+            return fail("Unsupported CBOR simple value");
+        }
+    }
+
+    bool cborNext(DQAbstractModel *model) {
+        if (!started) {
+            started = true;
+            int b = get();
+            if (b < 0 || (b >> 5) != 4)
+                return fail("CBOR array is expected");
+            if (!cborArgument(b & 31,&remaining))
+                return false;
+        }
+
+        if (remaining == 0) {
+            ended = true;
+            return false;
+        }
+
+        if (remaining < 0 && peek() == 0xff) {
+            pos++;
+            ended = true;
+            return false;
+        }
+
+        int b = get();
+        qint64 fields;
+        if (b < 0 || (b >> 5) != 5)
+            return fail("CBOR map is expected");
+        if (!cborArgument(b & 31,&fields))
+            return false;
+
+        beginRecord(model);
+        for (qint64 i = 0 ; fields < 0 || i < fields;i++) {
+            if (fields < 0 && peek() == 0xff) {
+                pos++;
+                break;
+            }
+            QVariant key,value;
+            if (!cborValue(key) || !cborValue(value))
+                return false;
+            setField(model,key.toString(),value);
+        }
+        endRecord(model);
+
+        if (remaining > 0)
+            remaining--;
+        return true;
+    }
+
+    // Binary
+
+    bool varint(quint64 *value) {
+        *value = 0;
+        for (int shift = 0 ; shift < 64;shift += 7) {
+            int b = get();
+            if (b < 0)
+                return fail("Truncated varint");
+            *value |= (quint64) (b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return true;
+        }
+        return fail("Invalid varint");
+    }
+
+    bool zigzag(qint64 *value) {
+        quint64 v;
+        if (!varint(&v))
+            return false;
+        *value = (qint64) (v >> 1) ^ -(qint64) (v & 1);
+        return true;
+    }
+
+    bool binaryText(QString &out) {
+        quint64 length;
+        QByteArray data;
+        if (!varint(&length) || !readBytes((int) length,data))
+            return fail("Truncated string");
+        out = QString::fromUtf8(data.constData(),data.size());
+        return true;
+    }
+
+    bool binaryValue(int type,QVariant &out) {
+        switch (type) {
+        case _DQInteger: {
+            qint64 v;
+            if (!zigzag(&v))
+                return false;
+            out = (qlonglong) v;
+            return true;
+        }
+        case _DQReal: {
+            if (!fill(8))
+                return fail("Truncated value");
+            quint64 bits = 0;
+            for (int i = 7 ; i >= 0 ; i--)
+                bits = (bits << 8) | (uchar) buffer.at(pos + i);
+            pos += 8;
+            double v;
+            memcpy(&v,&bits,sizeof(v));
+            out = v;
+            return true;
+        }
+        case _DQBlob: {
+            quint64 length;
+            QByteArray data;
+            if (!varint(&length) || !readBytes((int) length,data))
+                return fail("Truncated blob");
+            out = data;
+            return true;
+        }
+        case _DQBool: {
+            int b = get();
+            if (b < 0)
+                return fail("Truncated value");
+            out = b != 0;
+            return true;
+        }
+        case _DQDate: {
+            qint64 v;
+            if (!zigzag(&v))
+                return false;
+            out = QDate::fromJulianDay((int) v);
+            return true;
+        }
+        case _DQTime: {
+            quint64 v;
+            if (!varint(&v))
+                return false;
+            out = QTime(0,0).addMSecs((int) v);
+            return true;
+        }
+        case _DQDateTime: {
+            qint64 v;
+            if (!zigzag(&v))
+                return false;
+            out = QDateTime::fromMSecsSinceEpoch(v);
+            return true;
+        }
+        case _DQStringList: {
+            quint64 n;
+            if (!varint(&n))
+                return false;
+            QStringList list;
+            for (quint64 i = 0 ; i < n;i++) {
+                QString item;
+                if (!binaryText(item))
+                    return false;
+                list << item;
+            }
+            out = list;
+            return true;
+        }
+        default: {
+            QString s;
+            if (!binaryText(s))
+                return false;
+            out = s;
+            return true;
+        }
+        }
+    }
+
+    bool binaryTable() {
+        quint64 n;
+        if (!varint(&n))
+            return false;
+
+        fields.clear();
+        for (quint64 i = 0 ; i < n;i++) {
+            _DQBinaryField field;
+            if (!binaryText(field.name))
+                return false;
+            field.type = get();
+            if (field.type < 0)
+                return fail("Truncated table header");
+            fields << field;
+        }
+
+        mappedMetaInfo = 0;
+        return true;
+    }
+
+    bool binaryNext(DQAbstractModel *model) {
+        if (!started) {
+            started = true;
+            QByteArray magic;
+            if (!readBytes(4,magic) || magic != QByteArray(DQ_BINARY_MAGIC))
+                return fail("Invalid binary header");
+        }
+
+        int marker;
+        while ((marker = get()) == _DQBinaryTable) {
+            if (!binaryTable())
+                return false;
+        }
+
+        if (marker == _DQBinaryEnd) {
+            ended = true;
+            return false;
+        }
+
+        if (marker != _DQBinaryRecord || fields.isEmpty())
+            return fail("Invalid record");
+
+        // Map the fields of input to the model once per table
+        DQModelMetaInfo *metaInfo = model->metaInfo();
+        if (mappedMetaInfo != metaInfo) {
+            mapping.resize(fields.size());
+            for (int i = 0 ; i < fields.size();i++)
+                mapping[i] = metaInfo->indexOf(fields.at(i).name);
+            mappedMetaInfo = metaInfo;
+        }
+
+        int n = fields.size();
+        QByteArray bitmap;
+        if (!readBytes((n + 7) / 8,bitmap))
+            return fail("Truncated record");
+
+        beginRecord(model);
+        for (int i = 0 ; i < n;i++) {
+            if (bitmap.at(i / 8) & (1 << (i % 8)))
+                continue;
+
+            QVariant value;
+            if (!binaryValue(fields.at(i).type,value))
+                return false;
+
+            int index = mapping.at(i);
+            if (index >= 0) {
+                metaInfo->setValue(model,index,convert(value,metaInfo->at(index)->type));
+                assigned[index] = true;
+            }
+        }
+        endRecord(model);
+
+        return true;
+    }
+
+    QIODevice *device;
+    DQSerializer::Format format;
+
+    /// The bytes read from device
+    QByteArray buffer;
+    int pos;
+
+    bool started;
+    bool ended;
+
+    /// No. of remaining records of a definite CBOR array. -1 if indefinite.
+    qint64 remaining;
+
+    bool error;
+    QString errorString;
+
+    /// The reusable buffer of JSON text
+    QByteArray text;
+
+    /// TRUE if the field of the same index is found in current record
+    QVector<bool> assigned;
+
+    /// The fields of current binary table
+    QList<_DQBinaryField> fields;
+
+    /// The index of binary table field in mappedMetaInfo
+    QVector<int> mapping;
+    DQModelMetaInfo *mappedMetaInfo;
+};
+
+DQDeserializer::DQDeserializer(QIODevice *device,DQSerializer::Format format) {
+    d = new DQDeserializerPriv();
+    d->device = device;
+    d->format = format;
+}
+
+DQDeserializer::~DQDeserializer() {
+    delete d;
+}
+
+bool DQDeserializer::next(DQAbstractModel *model) {
+    if (d->ended || d->error)
+        return false;
+
+    bool res = false;
+    switch (d->format) {
+    case DQSerializer::Json:
+        res = d->jsonNext(model);
+        break;
+    case DQSerializer::Cbor:
+        res = d->cborNext(model);
+        break;
+    case DQSerializer::Binary:
+        res = d->binaryNext(model);
+        break;
+    }
+
+    if (!res && !d->ended && !d->error)
+        d->fail("Unexpected end of input");
+
+    return res;
+}
+
+bool DQDeserializer::readAll(DQSharedList &list,DQModelMetaInfo *metaInfo) {
+    if (!metaInfo)
+        metaInfo = list.metaInfo();
+
+    if (!metaInfo) {
+        qWarning() << "DQDeserializer::readAll() - The type of model is unknown";
+        return false;
+    }
+
+    for (;;) {
+        DQAbstractModel *model = list.appendNew(metaInfo);
+        if (!model) {
+            qWarning() << "DQDeserializer::readAll() - The model is not accepted by the list";
+            return false;
+        }
+
+        if (!next(model)) {
+            list.removeAt(list.size() - 1);
+            break;
+        }
+    }
+
+    return !d->error;
+}
+
+bool DQDeserializer::hasError() const {
+    return d->error;
+}
+
+QString DQDeserializer::errorString() const {
+    return d->errorString;
+}
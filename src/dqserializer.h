@@ -0,0 +1,140 @@
+#ifndef DQSERIALIZER_H
+#define DQSERIALIZER_H
+
+#include <QIODevice>
+#include <QString>
+#include <dqabstractmodel.h>
+#include <dqsharedlist.h>
+
+class DQModelMetaInfo;
+class DQSerializerPriv;
+class DQDeserializerPriv;
+
+/// Write models to a device as JSON , CBOR or a compact binary format
+/**
+  The models are encoded field by field in the registration order of their
+  meta info. The values are written straight into an output buffer , which
+  is flushed to the device when it is full. No intermediate document is
+  built , so it could write the records of a DQCursor one by one:
+
+\code
+    QTcpSocket *socket;
+    DQSerializer serializer(socket,DQSerializer::Json);
+
+    DQCursor<HealthCheck> cursor(DQQuery<HealthCheck>().filter(DQWhere("height") > 150));
+    while (cursor.next()) {
+        serializer.write(&cursor.model());
+    }
+    serializer.finish();
+\endcode
+
+  The formats:
+
+  <ul>
+  <li> Json - An array of objects. QByteArray is encoded in base64 and the date / time in ISO 8601. </li>
+  <li> Cbor - An indefinite-length array of maps (RFC 8949). QDate is tagged by 1004 and QDateTime by 0. </li>
+  <li> Binary - A DQuest specific format. The field names and types are written once in a header ,
+       and each record is a null bitmap followed by the varint or raw encoded values. </li>
+  </ul>
+
+  @see DQDeserializer
+  @see DQSharedList::toJson()
+ */
+class DQSerializer
+{
+public:
+    /// The encoding of serialized models
+    enum Format {
+        Json,
+        Cbor,
+        Binary
+    };
+
+    /// Construct a serializer writing to a device. The device must be opened for writing.
+    DQSerializer(QIODevice *device,Format format);
+
+    /// Call finish() and destroy the serializer
+    ~DQSerializer();
+
+    /// Write a model
+    /**
+      @return FALSE if it is failed to write the device
+     */
+    bool write(const DQAbstractModel *model);
+
+    /// Write all the models of a list
+    bool write(const DQSharedList &list);
+
+    /// Close the array and flush the buffer to device
+    /**
+      Nothing could be written after finish(). It is called by the destructor
+      if it is not called.
+     */
+    bool finish();
+
+    /// No. of models written
+    int count() const;
+
+    /// The format of the serializer
+    Format format() const;
+
+private:
+    Q_DISABLE_COPY(DQSerializer)
+
+    DQSerializerPriv *d;
+};
+
+/// Read the models written by DQSerializer
+/**
+  The device is read in chunks and a record is decoded on each call of next(),
+  so a large input could be processed without loading all the models:
+
+\code
+    DQDeserializer reader(&file,DQSerializer::Binary);
+    HealthCheck record;
+    while (reader.next(&record)) {
+        // ...
+    }
+    if (reader.hasError())
+        qWarning() << reader.errorString();
+\endcode
+
+  The fields are matched by name , the unknown fields of input are skipped
+  and the missing fields are set to null. JSON and CBOR written by other
+  encoders are accepted if it is an array of objects / maps.
+ */
+class DQDeserializer
+{
+public:
+    /// Construct a deserializer reading from a device. The device must be opened for reading.
+    DQDeserializer(QIODevice *device,DQSerializer::Format format);
+
+    ~DQDeserializer();
+
+    /// Read the next record into a model
+    /**
+      @return FALSE if it is the end of input or an error occurred.
+     */
+    bool next(DQAbstractModel *model);
+
+    /// Read all the remaining records and append them to a list
+    /**
+      @param list The output list
+      @param metaInfo The type of created models. If it is NULL , the meta info binded to the list is used.
+      @return FALSE if an error occurred. The records read before the error are kept.
+     */
+    bool readAll(DQSharedList &list,DQModelMetaInfo *metaInfo = 0);
+
+    /// TRUE if the input is malformed or truncated
+    bool hasError() const;
+
+    /// The description of the last error
+    QString errorString() const;
+
+private:
+    Q_DISABLE_COPY(DQDeserializer)
+
+    DQDeserializerPriv *d;
+};
+
+#endif // DQSERIALIZER_H
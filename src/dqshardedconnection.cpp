@@ -0,0 +1,374 @@
+#include <QtCore>
+#include "dqshardedconnection.h"
+#include "dqmodel.h"
+#include "dqmodelmetainfo.h"
+
+/* Test cases:
+
+  sqlitetests::shardedConnection()
+
+ */
+
+/// The shard key of a model
+class _DQShardKey {
+public:
+    _DQShardKey() : function(0) {
+    }
+
+    QString field;
+    DQShardedConnection::ShardFunction function;
+};
+
+class DQShardedConnectionPriv {
+public:
+    QList<DQConnection> shards;
+
+    QList<DQModelMetaInfo*> models;
+
+    QHash<DQModelMetaInfo*,_DQShardKey> keys;
+};
+
+/// Wait for a future. The result of canceled job is the default value
+template <typename T>
+static bool _dqWait(QFuture<T> future, T *result) {
+    future.waitForFinished();
+    if (future.isCanceled() || future.resultCount() == 0)
+        return false;
+    *result = future.result();
+    return true;
+}
+
+DQShardedConnection::DQShardedConnection() : d(new DQShardedConnectionPriv())
+{
+}
+
+DQShardedConnection::~DQShardedConnection()
+{
+    delete d;
+}
+
+void DQShardedConnection::addShard(DQConnection connection){
+    if (!connection.isOpen()) {
+        qWarning() << "DQShardedConnection::addShard() - The connection is not opened";
+    }
+
+    foreach (DQModelMetaInfo* metaInfo , d->models) {
+        connection.addModel(metaInfo);
+    }
+
+    d->shards << connection;
+}
+
+int DQShardedConnection::size(){
+    return d->shards.size();
+}
+
+DQConnection DQShardedConnection::shard(int index){
+    return d->shards.at(index);
+}
+
+bool DQShardedConnection::addModel(DQModelMetaInfo* metaInfo){
+    bool res = true;
+
+    for (int i = 0 ; i < d->shards.size();i++) {
+        if (!d->shards[i].addModel(metaInfo))
+            res = false;
+    }
+
+    if (!d->models.contains(metaInfo))
+        d->models << metaInfo;
+
+    return res;
+}
+
+bool DQShardedConnection::createTables(){
+    bool res = true;
+    for (int i = 0 ; i < d->shards.size();i++) {
+        if (!d->shards[i].createTables()) {
+            qWarning() << QString("DQShardedConnection::createTables() - Failed on shard %1").arg(i);
+            res = false;
+        }
+    }
+    return res;
+}
+
+bool DQShardedConnection::dropTables(){
+    bool res = true;
+    for (int i = 0 ; i < d->shards.size();i++) {
+        if (!d->shards[i].dropTables())
+            res = false;
+    }
+    return res;
+}
+
+void DQShardedConnection::setShardKey(DQModelMetaInfo* metaInfo , QString field , ShardFunction function){
+    if (metaInfo->indexOf(field) < 0) {
+        qWarning() << QString("DQShardedConnection::setShardKey() - %1 is not a field of %2").arg(field).arg(metaInfo->name());
+        return;
+    }
+
+    _DQShardKey key;
+    key.field = field;
+    key.function = function ? function : hash;
+    d->keys[metaInfo] = key;
+}
+
+int DQShardedConnection::shardOf(DQModelMetaInfo* metaInfo , QVariant key){
+    int n = d->shards.size();
+    if (n == 0 || !d->keys.contains(metaInfo))
+        return -1;
+
+    int index = d->keys.value(metaInfo).function(key,n);
+    if (index < 0 || index >= n) {
+        qWarning() << QString("DQShardedConnection::shardOf() - The shard function returned an invalid index %1").arg(index);
+        return -1;
+    }
+
+    return index;
+}
+
+int DQShardedConnection::shardOf(DQModel* model){
+    DQModelMetaInfo *metaInfo = model->metaInfo();
+    if (!d->keys.contains(metaInfo))
+        return -1;
+
+    QVariant key = metaInfo->value(model,d->keys.value(metaInfo).field);
+    return shardOf(metaInfo,key);
+}
+
+bool DQShardedConnection::save(DQModel* model , bool forceInsert , bool forceAllField){
+    DQModelMetaInfo *metaInfo = model->metaInfo();
+    if (!d->keys.contains(metaInfo)) {
+        qWarning() << QString("DQShardedConnection::save() - The shard key of %1 is not set").arg(metaInfo->name());
+        return false;
+    }
+
+    QVariant key = metaInfo->value(model,d->keys.value(metaInfo).field);
+    if (key.isNull()) {
+        qWarning() << QString("DQShardedConnection::save() - The shard key %1 is null").arg(d->keys.value(metaInfo).field);
+        return false;
+    }
+
+    int index = shardOf(metaInfo,key);
+    if (index < 0)
+        return false;
+
+    model->setConnection(d->shards.at(index));
+    return model->save(forceInsert,forceAllField);
+}
+
+bool DQShardedConnection::load(DQModel* model , DQWhere where , QVariant key){
+    if (!key.isNull()) {
+        int index = shardOf(model->metaInfo(),key);
+        if (index < 0)
+            return false;
+
+        model->setConnection(d->shards.at(index));
+        return model->load(where);
+    }
+
+    for (int i = 0 ; i < d->shards.size();i++) {
+        model->setConnection(d->shards.at(i));
+        if (model->load(where))
+            return true;
+    }
+
+    return false;
+}
+
+DQSharedList DQShardedConnection::all(DQSharedQuery query){
+    int n = d->shards.size();
+
+    QList<QFuture<DQSharedList> > futures;
+    for (int i = 0 ; i < n;i++) {
+        DQSharedQuery q(query);
+        q.setConnection(d->shards.at(i));
+        futures << q.allAsync();
+    }
+
+    DQSharedList res;
+    bool first = true;
+    for (int i = 0 ; i < n;i++) {
+        DQSharedList list;
+        if (!_dqWait(futures.at(i),&list)) {
+            qWarning() << QString("DQShardedConnection::all() - Failed on shard %1").arg(i);
+            continue;
+        }
+
+        // The models of async result are read by the worker connection. Bind them to the shard connection
+        int size = list.size();
+        if (first) {
+            // The first list is reused , the models of other shards are copied into it
+            for (int j = 0 ; j < size;j++)
+                static_cast<DQModel*>(list.at(j))->setConnection(d->shards.at(i));
+            res = list;
+            first = false;
+            continue;
+        }
+
+        for (int j = 0 ; j < size;j++) {
+            DQAbstractModel *item = list.at(j);
+            DQModel *model = static_cast<DQModel*>(item->metaInfo()->clone(item));
+            model->setConnection(d->shards.at(i));
+            res.append(model);
+        }
+    }
+
+    return res;
+}
+
+int DQShardedConnection::count(DQSharedQuery query){
+    int n = d->shards.size();
+
+    QList<QFuture<int> > futures;
+    for (int i = 0 ; i < n;i++) {
+        DQSharedQuery q(query);
+        q.setConnection(d->shards.at(i));
+        futures << q.countAsync();
+    }
+
+    int res = 0;
+    bool ok = true;
+    for (int i = 0 ; i < n;i++) {
+        int count = -1;
+        if (!_dqWait(futures.at(i),&count) || count < 0) {
+            qWarning() << QString("DQShardedConnection::count() - Failed on shard %1").arg(i);
+            ok = false;
+            continue;
+        }
+        res += count;
+    }
+
+    return ok ? res : -1;
+}
+
+/// Add two values. The result is integer if both of them are integer
+static QVariant _dqAdd(const QVariant &a,const QVariant &b) {
+    if (a.isNull())
+        return b;
+    if (b.isNull())
+        return a;
+
+    bool integer = (a.type() == QVariant::Int || a.type() == QVariant::LongLong) &&
+                   (b.type() == QVariant::Int || b.type() == QVariant::LongLong);
+    if (integer)
+        return QVariant(a.toLongLong() + b.toLongLong());
+    return QVariant(a.toDouble() + b.toDouble());
+}
+
+/// Compare two values as number if possible
+static bool _dqLessThan(const QVariant &a,const QVariant &b) {
+    bool aok,bok;
+    double x = a.toDouble(&aok);
+    double y = b.toDouble(&bok);
+    if (aok && bok)
+        return x < y;
+    return a.toString() < b.toString();
+}
+
+QVariant DQShardedConnection::call(DQSharedQuery query , QString func , QString field){
+    QString name = func.toLower();
+    bool avg = name == "avg";
+
+    if (!avg && name != "sum" && name != "total" && name != "count" && name != "min" && name != "max") {
+        qWarning() << QString("DQShardedConnection::call() - %1() could not be merged across shards").arg(func);
+        return QVariant();
+    }
+
+    int n = d->shards.size();
+
+    QList<QFuture<QVariant> > futures;
+    QList<QFuture<QVariant> > counts;
+    for (int i = 0 ; i < n;i++) {
+        DQSharedQuery q(query);
+        q.setConnection(d->shards.at(i));
+        QStringList fields;
+        fields << field;
+        futures << q.callAsync(avg ? QString("sum") : func,fields);
+        if (avg)
+            counts << q.callAsync("count",fields);
+    }
+
+    QVariant res;
+    QVariant total;
+
+    for (int i = 0 ; i < n;i++) {
+        QVariant value;
+        if (!_dqWait(futures.at(i),&value)) {
+            qWarning() << QString("DQShardedConnection::call() - Failed on shard %1").arg(i);
+            return QVariant();
+        }
+
+        if (avg) {
+            QVariant count;
+            if (!_dqWait(counts.at(i),&count)) {
+                qWarning() << QString("DQShardedConnection::call() - Failed on shard %1").arg(i);
+                return QVariant();
+            }
+            total = _dqAdd(total,count);
+        }
+
+        if (value.isNull())
+            continue;
+
+        if (name == "min") {
+            if (res.isNull() || _dqLessThan(value,res))
+                res = value;
+        } else if (name == "max") {
+            if (res.isNull() || _dqLessThan(res,value))
+                res = value;
+        } else {
+            res = _dqAdd(res,value);
+        }
+    }
+
+    if (avg) {
+        if (res.isNull() || total.toLongLong() == 0)
+            return QVariant();
+        return QVariant(res.toDouble() / total.toLongLong());
+    }
+
+    return res;
+}
+
+bool DQShardedConnection::remove(DQSharedQuery query){
+    bool res = true;
+    for (int i = 0 ; i < d->shards.size();i++) {
+        DQSharedQuery q(query);
+        q.setConnection(d->shards.at(i));
+        if (!q.remove()) {
+            qWarning() << QString("DQShardedConnection::remove() - Failed on shard %1").arg(i);
+            res = false;
+        }
+    }
+    return res;
+}
+
+int DQShardedConnection::hash(const QVariant &key , int shardCount){
+    if (shardCount <= 0)
+        return -1;
+
+    switch (key.type()) {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+        // qAbs() overflows on the min of qint64
+        return (int) ((quint64) key.toLongLong() % (quint64) shardCount);
+    case QVariant::ULongLong:
+        return (int) (key.toULongLong() % (quint64) shardCount);
+    default:
+        break;
+    }
+
+    // 32-bit FNV-1a
+    QByteArray bytes = key.toString().toUtf8();
+    quint32 h = 2166136261u;
+    int n = bytes.size();
+    const char *p = bytes.constData();
+    for (int i = 0 ; i < n;i++) {
+        h ^= (quint8) p[i];
+        h *= 16777619u;
+    }
+
+    return (int) (h % (quint32) shardCount);
+}
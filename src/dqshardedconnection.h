@@ -0,0 +1,164 @@
+#ifndef DQSHARDEDCONNECTION_H
+#define DQSHARDEDCONNECTION_H
+
+#include <dqconnection.h>
+#include <dqsharedquery.h>
+#include <dqsharedlist.h>
+#include <dqwhere.h>
+
+class DQModel;
+class DQShardedConnectionPriv;
+
+/// A set of connections , each holding a part of the records
+/**
+  The records of a model are distributed to the shards by the value of a
+  shard key field. Every shard is a separated database (e.g a SQLite file)
+  with its own connection , so the write throughput and file size grow with
+  the no. of shards.
+
+  save() routes a model to the shard of its key. A query is run on all the
+  shards in parallel by their async workers (DQSharedQuery::allAsync()) ,
+  and the results are merged.
+
+  Example:
+
+\code
+    DQShardedConnection events;
+    for (int i = 0 ; i < 4 ; i++) {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE",QString("shard%1").arg(i));
+        db.setDatabaseName(QString("events%1.db").arg(i));
+        db.open();
+
+        DQConnection connection;
+        connection.open(db);
+        events.addShard(connection);
+    }
+
+    events.addModel<Event>();
+    events.createTables();
+    events.setShardKey<Event>("userId");
+
+    Event event;
+    event.userId = "tester";
+    events.save(&event);
+
+    int n = events.count(DQQuery<Event>().filter(DQWhere("kind") == "login"));
+\endcode
+
+  @remarks The id is only unique within a shard. Use the shard key to identify a record across shards.
+  The orderBy() , limit() and offset() of a query are applied per shard.
+  The async worker reads a clone of the database , so the shards could not be in-memory databases.
+ */
+class DQShardedConnection
+{
+public:
+    /// A function to map a key to the shard index
+    /**
+      @param key The value of shard key field
+      @param shardCount No. of shard
+      @return The index of shard , from 0 to shardCount - 1
+     */
+    typedef int (*ShardFunction)(const QVariant &key,int shardCount);
+
+    DQShardedConnection();
+    ~DQShardedConnection();
+
+    /// Add an opened connection as the next shard
+    /**
+      The shard index of a key depends on the no. of shards , add all the shards before to save any record.
+     */
+    void addShard(DQConnection connection);
+
+    /// No. of shard
+    int size();
+
+    /// The connection of a shard
+    DQConnection shard(int index);
+
+    /// Register a model to all the shards
+    template <typename T>
+    bool addModel() {
+        return addModel(dqMetaInfo<T>());
+    }
+
+    /// Register a model to all the shards
+    bool addModel(DQModelMetaInfo* metaInfo);
+
+    /// Create the tables of the registered models on all the shards
+    bool createTables();
+
+    /// Drop the tables of the registered models on all the shards
+    bool dropTables();
+
+    /// Set the shard key of a model
+    template <typename T>
+    void setShardKey(QString field , ShardFunction function = 0) {
+        setShardKey(dqMetaInfo<T>(),field,function);
+    }
+
+    /// Set the shard key of a model
+    /**
+      @param field The field name of shard key
+      @param function The function to map the key value to a shard. NULL use hash()
+     */
+    void setShardKey(DQModelMetaInfo* metaInfo , QString field , ShardFunction function = 0);
+
+    /// The shard index of a key value
+    /**
+      @return The index. -1 if no shard is added or the shard key of the model is not set
+     */
+    int shardOf(DQModelMetaInfo* metaInfo , QVariant key);
+
+    /// The shard index of a model by its shard key field
+    int shardOf(DQModel* model);
+
+    /// Save the model to the shard of its key
+    /**
+      The connection of the model is changed to the shard.
+      @return FALSE if the shard key of the model is not set or null
+     */
+    bool save(DQModel* model , bool forceInsert = false , bool forceAllField = false);
+
+    /// Load the first record matched
+    /**
+      @param key The shard key value of the record. If it is null , the shards are searched in order.
+      @return TRUE if it is found. The connection of the model is changed to the shard of the record.
+     */
+    bool load(DQModel* model , DQWhere where , QVariant key = QVariant());
+
+    /// Run DQSharedQuery::all() on all the shards in parallel and concatenate the results in shard order
+    /**
+      The connection of the models is the shard where they are read from , so they could be saved back directly.
+     */
+    DQSharedList all(DQSharedQuery query);
+
+    /// Sum of DQSharedQuery::count() of all the shards. -1 if any shard is failed
+    int count(DQSharedQuery query);
+
+    /// Run an aggregate function on all the shards in parallel and merge the results
+    /**
+      @param func "sum" , "total" , "count" , "min" , "max" or "avg". The average is computed from the sum and count of every shard.
+      @return The merged result. It is null if the function could not be merged , or no record is aggregated.
+     */
+    QVariant call(DQSharedQuery query , QString func , QString field);
+
+    /// Remove the records matched on all the shards
+    /**
+      @return TRUE if it is successful on all the shards
+     */
+    bool remove(DQSharedQuery query);
+
+    /// The default shard function
+    /**
+      An integer key is mapped by the modulus of its unsigned 64-bit value. Other values are mapped by the
+      FNV-1a hash of their string form , so the result never changes between runs or platforms.
+     */
+    static int hash(const QVariant &key , int shardCount);
+
+private:
+    Q_DISABLE_COPY(DQShardedConnection)
+
+    DQShardedConnectionPriv* d;
+};
+
+#endif // DQSHARDEDCONNECTION_H
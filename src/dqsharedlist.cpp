@@ -1,6 +1,316 @@
 #include "dqsharedlist.h"
 #include <QSharedData>
+#include <QSet>
 #include <QList>
+#include <QSqlError>
+#include <QThread>
+#include <QBuffer>
+#include <QVector>
+#include <QDateTime>
+#include <algorithm>
+#include <vector>
+#include "dqmodel.h"
+#include "dqsql.h"
+#include "dqtransaction.h"
+#include "dqwriterthread_p.h"
+#include "dqserializer.h"
+
+/* Test cases:
+
+  coretests::sharedListArena()
+  coretests::listSort()
+  coretests::serializer()
+
+ */
+
+/// Size of the first memory block of _DQModelArena in bytes
+#define DQ_ARENA_BLOCK_SIZE (16 * 1024)
+
+/// Maximum size of a memory block of _DQModelArena in bytes
+#define DQ_ARENA_MAX_BLOCK_SIZE (1024 * 1024)
+
+/// The alignment of the models allocated by _DQModelArena
+#define DQ_ARENA_ALIGNMENT 16
+
+/// The minimum size of list sorted by multiple threads in DQSharedList::sortBy()
+#ifndef DQ_PARALLEL_SORT_THRESHOLD
+#define DQ_PARALLEL_SORT_THRESHOLD 50000
+#endif
+
+/// The maximum no. of threads used by DQSharedList::sortBy()
+#ifndef DQ_PARALLEL_SORT_MAX_THREADS
+#define DQ_PARALLEL_SORT_MAX_THREADS 8
+#endif
+
+/// A bump allocator for the models owned by a DQSharedList
+/**
+  The memory is allocated in blocks of increasing size. Individual
+  allocation could not be freed, the blocks are released at once
+  by release().
+ */
+class _DQModelArena {
+public:
+    inline _DQModelArena() {
+        m_blockSize = DQ_ARENA_BLOCK_SIZE;
+        m_used = 0;
+        m_capacity = 0;
+    }
+
+    inline ~_DQModelArena() {
+        release();
+    }
+
+    void* allocate(int size) {
+        size = (size + DQ_ARENA_ALIGNMENT - 1) & ~(DQ_ARENA_ALIGNMENT - 1);
+
+        if (m_blocks.isEmpty() || m_used + size > m_capacity) {
+            m_capacity = qMax(m_blockSize , size);
+            m_blocks << static_cast<char*>(::operator new(m_capacity));
+            m_used = 0;
+            m_blockSize = qMin(m_blockSize * 2 , DQ_ARENA_MAX_BLOCK_SIZE);
+        }
+
+        void *res = m_blocks.last() + m_used;
+        m_used += size;
+        return res;
+    }
+
+    /// Take the blocks of other arena. The other arena becomes empty.
+    /**
+      The blocks are inserted before the current block , so the next
+      allocation continues on the current block.
+     */
+    void adopt(_DQModelArena &other) {
+        if (other.m_blocks.isEmpty())
+            return;
+
+        QList<char*> blocks = other.m_blocks;
+        blocks.append(m_blocks);
+        m_blocks = blocks;
+
+        other.m_blocks.clear();
+        other.release();
+    }
+
+    void release() {
+        foreach (char *block , m_blocks) {
+            ::operator delete(block);
+        }
+        m_blocks.clear();
+        m_blockSize = DQ_ARENA_BLOCK_SIZE;
+        m_used = 0;
+        m_capacity = 0;
+    }
+
+private:
+    QList<char*> m_blocks;
+
+    /// The size of next block
+    int m_blockSize;
+
+    /// Used bytes of the last block
+    int m_used;
+
+    /// Size of the last block
+    int m_capacity;
+};
+
+/// The typed sort key of a model in DQSharedList::sortBy()
+class _DQSortKey {
+public:
+    enum Kind {
+        Null = 0,
+        Number,
+        Text,
+        Blob
+    };
+
+    inline _DQSortKey() : kind(Null) , isInteger(true) , integer(0) , real(0) , index(0) {
+    }
+
+    /// Create the key of a field value
+    static _DQSortKey create(const QVariant &value,int index) {
+        _DQSortKey res;
+        res.index = index;
+
+        if (value.isNull())
+            return res;
+
+        switch ((int) value.type()) {
+        case QVariant::Bool:
+        case QVariant::Int:
+        case QVariant::UInt:
+        case QVariant::LongLong:
+        case QVariant::ULongLong:
+        case QVariant::Char:
+            res.kind = Number;
+            res.integer = value.toLongLong();
+            break;
+        case QVariant::Double:
+        case QMetaType::Float:
+            res.kind = Number;
+            res.isInteger = false;
+            res.real = value.toDouble();
+            break;
+        case QVariant::Date:
+            res.kind = Number;
+            res.integer = value.toDate().toJulianDay();
+            break;
+        case QVariant::Time:
+            res.kind = Number;
+            res.integer = QTime(0,0).msecsTo(value.toTime());
+            break;
+        case QVariant::DateTime:
+            res.kind = Number;
+            res.integer = value.toDateTime().toMSecsSinceEpoch();
+            break;
+        case QVariant::ByteArray:
+            res.kind = Blob;
+            res.blob = value.toByteArray();
+            break;
+        default:
+            res.kind = Text;
+            res.text = value.toString();
+            break;
+        }
+
+        return res;
+    }
+
+    /// Compare the values of two keys. The index is not compared.
+    static inline int compare(const _DQSortKey &a,const _DQSortKey &b) {
+        if (a.kind != b.kind)
+            return a.kind < b.kind ? -1 : 1;
+
+        switch (a.kind) {
+        case Number:
+            if (a.isInteger && b.isInteger)
+                return a.integer < b.integer ? -1 : (a.integer > b.integer ? 1 : 0);
+            else {
+                double x = a.isInteger ? (double) a.integer : a.real;
+                double y = b.isInteger ? (double) b.integer : b.real;
+                return x < y ? -1 : (x > y ? 1 : 0);
+            }
+        case Text:
+            return a.text.compare(b.text);
+        case Blob:
+            return a.blob < b.blob ? -1 : (b.blob < a.blob ? 1 : 0);
+        default:
+            return 0;
+        }
+    }
+
+    int kind;
+    bool isInteger;
+    qint64 integer;
+    double real;
+    QString text;
+    QByteArray blob;
+
+    /// The position of model. It breaks the ties , so the sorting is stable
+    int index;
+};
+
+/// The ordering of _DQSortKey
+class _DQSortKeyLess {
+public:
+    inline _DQSortKeyLess(Qt::SortOrder order) : descending(order == Qt::DescendingOrder) {
+    }
+
+    inline bool operator()(const _DQSortKey &a,const _DQSortKey &b) const {
+        int res = _DQSortKey::compare(a,b);
+        if (res != 0)
+            return descending ? res > 0 : res < 0;
+        return a.index < b.index;
+    }
+
+    bool descending;
+};
+
+/// Sort a range of keys in a thread
+class _DQSortWorker : public QThread {
+public:
+    _DQSortWorker(_DQSortKey *begin,_DQSortKey *end,_DQSortKeyLess less) :
+        m_begin(begin) , m_end(end) , m_less(less) {
+    }
+
+protected:
+    void run() {
+        std::sort(m_begin,m_end,m_less);
+    }
+
+private:
+    _DQSortKey *m_begin;
+    _DQSortKey *m_end;
+    _DQSortKeyLess m_less;
+};
+
+/// Sort the keys. A large array is split into chunks sorted in parallel and then merged.
+static void _dqSortKeys(QVector<_DQSortKey> &keys,_DQSortKeyLess less) {
+    int n = keys.size();
+    int threads = qMin(QThread::idealThreadCount() , DQ_PARALLEL_SORT_MAX_THREADS);
+    _DQSortKey *begin = keys.data();
+
+    if (n < DQ_PARALLEL_SORT_THRESHOLD || threads < 2) {
+        std::sort(begin,begin + n,less);
+        return;
+    }
+
+    QVector<int> bounds;
+    for (int i = 0 ; i <= threads;i++) {
+        bounds << (int) ((qint64) n * i / threads);
+    }
+
+    QList<_DQSortWorker*> workers;
+    for (int i = 0 ; i < threads;i++) {
+        _DQSortWorker *worker = new _DQSortWorker(begin + bounds[i],begin + bounds[i+1],less);
+        worker->start();
+        workers << worker;
+    }
+
+    foreach (_DQSortWorker *worker , workers) {
+        worker->wait();
+        delete worker;
+    }
+
+    // Merge the adjacent chunks until a single chunk is left
+    for (int width = 1 ; width < threads;width *= 2) {
+        for (int i = 0 ; i + width < threads;i += width * 2) {
+            int last = qMin(i + width * 2 , threads);
+            std::inplace_merge(begin + bounds[i],begin + bounds[i + width],begin + bounds[last],less);
+        }
+    }
+}
+
+/// Create the sort keys of the models in a list
+/**
+  @return FALSE if any model has no such field
+ */
+static bool _dqCreateSortKeys(const QList<DQAbstractModel*> &list,const QString &field,QVector<_DQSortKey> &keys,const char* method) {
+    int n = list.size();
+    keys.resize(n);
+
+    // The index of field is only looked up once per type
+    DQModelMetaInfo *metaInfo = 0;
+    int index = -1;
+
+    for (int i = 0 ; i < n;i++) {
+        DQAbstractModel *model = list.at(i);
+        if (model->metaInfo() != metaInfo) {
+            metaInfo = model->metaInfo();
+            index = metaInfo->indexOf(field);
+            if (index < 0) {
+                qWarning() << QString("DQSharedList::%1() - %2 has no field %3")
+                              .arg(method).arg(metaInfo->className()).arg(field);
+                return false;
+            }
+        }
+
+        keys[i] = _DQSortKey::create(metaInfo->value(model,index),i);
+    }
+
+    return true;
+}
 
 class DQSharedListPriv : public QSharedData {
 public:
@@ -12,15 +322,57 @@ public:
         clear();
     }
 
-    void clear(){
-        foreach (DQAbstractModel*model, list){
+    /// Destroy a model at index. The memory allocated by arena is not released
+    inline void destroy(int index) {
+        DQAbstractModel *model = list.at(index);
+        if (inArena.at(index))
+            model->~DQAbstractModel();
+        else
             delete model;
+    }
+
+    void clear(){
+        int n = list.size();
+        for (int i = 0 ; i < n ; i++) {
+            destroy(i);
         }
         list.clear();
+        inArena.clear();
+        arena.release();
         metaInfo = 0;
     }
 
+    /// Reorder the list by the keys. The models not in the first count keys are destroyed.
+    void reorder(const QVector<_DQSortKey> &keys,int count) {
+        QList<DQAbstractModel*> sorted;
+        QList<bool> sortedInArena;
+        QVector<bool> kept(list.size(),false);
+
+        sorted.reserve(count);
+        sortedInArena.reserve(count);
+        for (int i = 0 ; i < count;i++) {
+            int index = keys.at(i).index;
+            sorted << list.at(index);
+            sortedInArena << inArena.at(index);
+            kept[index] = true;
+        }
+
+        for (int i = 0 ; i < list.size();i++) {
+            if (!kept.at(i))
+                destroy(i);
+        }
+
+        list = sorted;
+        inArena = sortedInArena;
+    }
+
     QList <DQAbstractModel*> list;
+
+    /// TRUE if the model of the same index is constructed in arena
+    QList<bool> inArena;
+
+    _DQModelArena arena;
+
     DQModelMetaInfo *metaInfo;
 };
 
@@ -57,17 +409,31 @@ bool DQSharedList::append(DQAbstractModel* model){
     }
 
     data->list << model;
+    data->inArena << false;
     return true;
 }
 
+DQAbstractModel* DQSharedList::appendNew(DQModelMetaInfo* metaInfo){
+    if (data->metaInfo && metaInfo != data->metaInfo) {
+        return 0;
+    }
+
+    void *buffer = data->arena.allocate(metaInfo->modelSize());
+    DQAbstractModel *model = metaInfo->create(buffer);
+
+    data->list << model;
+    data->inArena << true;
+    return model;
+}
+
 void DQSharedList::clear() {
     data->clear();
 }
 
 void DQSharedList::removeAt(int index){
-    DQAbstractModel *model = data->list.value(index);
+    data->destroy(index);
     data->list.removeAt(index);
-    delete model;
+    data->inArena.removeAt(index);
 }
 
 bool DQSharedList::save(bool forceInsert,bool forceAllField) {
@@ -84,6 +450,381 @@ bool DQSharedList::save(bool forceInsert,bool forceAllField) {
     return res;
 }
 
+/// A set of models sharing the same statement in saveAll()
+class _DQBulkGroup {
+public:
+    DQModelMetaInfo* info;
+    QStringList fields;
+    bool insert;
+    QList<DQModel*> models;
+
+    /// The ids of the models before writing. They are restored on rollback
+    QVariantList ids;
+};
+
+bool DQSharedList::saveAll(BulkOptions options) {
+    int n = size();
+    if (n == 0)
+        return true;
+
+    bool res = true;
+
+    DQConnection connection = static_cast<DQModel*>(at(0))->connection();
+    DQSql sql = connection.sql();
+
+    _DQWriterThread* writerThread = connection.writerThread();
+    if (writerThread && sql.transactionDepth() == 0) {
+        res = writerThread->saveAll(*this,options);
+        if (res) {
+            QSet<DQModelMetaInfo*> written;
+            for (int i = 0 ; i < n ; i++)
+                written << static_cast<DQModel*>(at(i))->metaInfo();
+            foreach (DQModelMetaInfo* info , written)
+                sql.notifyTableChanged(info->name());
+        }
+        return res;
+    }
+
+    int batchSize = options.batchSize > 0 ? options.batchSize : n;
+
+    for (int start = 0 ; start < n ; start += batchSize) {
+        int end = qMin(start + batchSize , n);
+
+        QList<_DQBulkGroup> groups;
+        QHash<QString,int> groupIndex;
+
+        for (int i = start ; i < end ; i++) {
+            DQModel* model = static_cast<DQModel*>(at(i));
+            if (!model->clean()) {
+                res = false;
+                continue;
+            }
+
+            DQModelMetaInfo *info = model->metaInfo();
+            QStringList savingFields;
+            bool insert = options.forceInsert || model->id->isNull();
+
+            if (options.forceAllField) {
+                savingFields = info->columnNameList();
+            } else {
+                int count = info->size();
+                for (int j = 0 ; j < count ; j++) {
+                    const DQModelMetaInfoField* field = info->at(j);
+                    if (options.forceInsert && field->name == "id" )
+                        continue;
+
+                    if (!info->field(model,j)->get().isNull() ) {
+                        savingFields << field->name;
+                    }
+                }
+            }
+
+            QString key = QString("%1:%2:%3").arg(info->name()).arg(insert).arg(savingFields.join(","));
+            if (!groupIndex.contains(key)) {
+                _DQBulkGroup group;
+                group.info = info;
+                group.fields = savingFields;
+                group.insert = insert;
+                groupIndex[key] = groups.size();
+                groups << group;
+            }
+            groups[groupIndex[key]].models << model;
+            groups[groupIndex[key]].ids << model->id.get();
+        }
+
+        DQTransaction transaction(connection);
+        bool ok = transaction.isActive();
+
+        for (int i = 0 ; i < groups.size() ; i++) {
+            const _DQBulkGroup &group = groups.at(i);
+            // The id is bound as null value if it is not skipped
+            bool updateId = options.updateId && group.insert &&
+                            (!group.fields.contains("id") || !options.forceInsert);
+            if (!sql.replaceInto(group.info,group.models,group.fields,updateId)) {
+                qWarning() << "DQSharedList::saveAll() - " << sql.lastQuery().lastError().text();
+                ok = false;
+                break;
+            }
+        }
+
+        if (ok) {
+            ok = transaction.commit();
+        }
+
+        if (ok) {
+            for (int i = 0 ; i < groups.size() ; i++) {
+                const _DQBulkGroup &group = groups.at(i);
+                foreach (DQModel* model , group.models) {
+                    group.info->setDirty(model,false);
+                }
+            }
+        }
+
+        if (!ok) {
+            transaction.rollback();
+
+            // The generated id is no longer valid , the id given with forceInsert is kept
+            for (int i = 0 ; i < groups.size() ; i++) {
+                const _DQBulkGroup &group = groups.at(i);
+                if (!group.insert)
+                    continue;
+                for (int j = 0 ; j < group.models.size() ; j++) {
+                    group.models.at(j)->id.set(group.ids.at(j));
+                }
+            }
+            res = false;
+            break;
+        }
+    }
+
+    connection.setLastQuery(sql.lastQuery());
+
+    return res;
+}
+
+bool DQSharedList::removeAll() {
+    int n = size();
+    if (n == 0)
+        return true;
+
+    DQConnection connection = static_cast<DQModel*>(at(0))->connection();
+    DQSql sql = connection.sql();
+
+    _DQWriterThread* writerThread = connection.writerThread();
+    if (writerThread && sql.transactionDepth() == 0) {
+        bool res = writerThread->removeAll(*this);
+        if (res) {
+            QSet<DQModelMetaInfo*> removed;
+            for (int i = 0 ; i < n ; i++)
+                removed << static_cast<DQModel*>(at(i))->metaInfo();
+            foreach (DQModelMetaInfo* info , removed)
+                sql.notifyTableChanged(info->name());
+        }
+        return res;
+    }
+
+    // The ids grouped by model
+    QList<DQModelMetaInfo*> infos;
+    QList<QVariantList> ids;
+
+    for (int i = 0 ; i < n ; i++) {
+        DQModel* model = static_cast<DQModel*>(at(i));
+        if (model->id->isNull())
+            continue;
+
+        DQModelMetaInfo *info = model->metaInfo();
+        int index = infos.indexOf(info);
+        if (index < 0) {
+            index = infos.size();
+            infos << info;
+            ids << QVariantList();
+        }
+        ids[index] << model->id.get();
+    }
+
+    DQTransaction transaction(connection);
+    bool ok = transaction.isActive();
+
+    for (int i = 0 ; ok && i < infos.size() ; i++) {
+        if (sql.removeIds(infos.at(i),ids.at(i)) < 0)
+            ok = false;
+    }
+
+    if (ok)
+        ok = transaction.commit();
+
+    connection.setLastQuery(sql.lastQuery());
+
+    if (!ok) {
+        transaction.rollback();
+        return false;
+    }
+
+    for (int i = 0 ; i < n ; i++) {
+        static_cast<DQModel*>(at(i))->id->clear();
+    }
+
+    return true;
+}
+
+bool DQSharedList::sortBy(QString field,Qt::SortOrder order){
+    QVector<_DQSortKey> keys;
+    if (!_dqCreateSortKeys(data->list,field,keys,"sortBy"))
+        return false;
+
+    _dqSortKeys(keys,_DQSortKeyLess(order));
+    data->reorder(keys,keys.size());
+
+    return true;
+}
+
+bool DQSharedList::topK(QString field,int k,Qt::SortOrder order){
+    if (k < 0) {
+        qWarning() << "DQSharedList::topK() - k must not be negative";
+        return false;
+    }
+
+    if (k >= size())
+        return sortBy(field,order);
+
+    QVector<_DQSortKey> keys;
+    if (!_dqCreateSortKeys(data->list,field,keys,"topK"))
+        return false;
+
+    std::partial_sort(keys.begin(),keys.begin() + k,keys.end(),_DQSortKeyLess(order));
+    data->reorder(keys,k);
+
+    return true;
+}
+
+/// The head of an input list in DQSharedList::merge()
+class _DQMergeCursor {
+public:
+    int list;
+    int pos;
+};
+
+/// The ordering of the heap of _DQMergeCursor. The smallest head is on the top.
+class _DQMergeCursorGreater {
+public:
+    _DQMergeCursorGreater(const QVector<QVector<_DQSortKey> > &keys,Qt::SortOrder order) :
+        keys(keys) , less(order) {
+    }
+
+    inline bool operator()(const _DQMergeCursor &a,const _DQMergeCursor &b) const {
+        const _DQSortKey &x = keys.at(a.list).at(a.pos);
+        const _DQSortKey &y = keys.at(b.list).at(b.pos);
+        int res = _DQSortKey::compare(x,y);
+        if (res != 0)
+            return less(y,x);
+        return a.list > b.list;
+    }
+
+    const QVector<QVector<_DQSortKey> > &keys;
+    _DQSortKeyLess less;
+};
+
+DQSharedList DQSharedList::merge(QList<DQSharedList> lists,QString field,Qt::SortOrder order,int limit){
+    DQSharedList res;
+    if (lists.isEmpty())
+        return res;
+
+    res.setMetaInfo(lists.first().metaInfo());
+
+    int k = lists.size();
+    int total = 0;
+    QVector<QVector<_DQSortKey> > keys(k);
+    for (int i = 0 ; i < k;i++) {
+        for (int j = 0 ; j < i;j++) {
+            if (lists.at(j).data == lists.at(i).data) {
+                qWarning() << "DQSharedList::merge() - The same list is passed twice";
+                return res;
+            }
+        }
+
+        if (!_dqCreateSortKeys(lists.at(i).data->list,field,keys[i],"merge"))
+            return res;
+        total += keys.at(i).size();
+    }
+
+    if (limit < 0 || limit > total)
+        limit = total;
+
+    _DQMergeCursorGreater greater(keys,order);
+    std::vector<_DQMergeCursor> heap;
+    for (int i = 0 ; i < k;i++) {
+        if (keys.at(i).isEmpty())
+            continue;
+        _DQMergeCursor cursor;
+        cursor.list = i;
+        cursor.pos = 0;
+        heap.push_back(cursor);
+    }
+    std::make_heap(heap.begin(),heap.end(),greater);
+
+    DQSharedListPriv *target = res.data.data();
+    target->list.reserve(limit);
+    target->inArena.reserve(limit);
+
+    while (target->list.size() < limit) {
+        std::pop_heap(heap.begin(),heap.end(),greater);
+        _DQMergeCursor &cursor = heap.back();
+
+        DQSharedListPriv *source = lists.at(cursor.list).data.data();
+        target->list << source->list.at(cursor.pos);
+        target->inArena << source->inArena.at(cursor.pos);
+        source->list[cursor.pos] = 0; // Moved
+
+        cursor.pos++;
+        if (cursor.pos < keys.at(cursor.list).size())
+            std::push_heap(heap.begin(),heap.end(),greater);
+        else
+            heap.pop_back();
+    }
+
+    // Destroy the models beyond the limit and take the arenas
+    for (int i = 0 ; i < k;i++) {
+        DQSharedListPriv *source = lists.at(i).data.data();
+        for (int j = 0 ; j < source->list.size();j++) {
+            if (source->list.at(j))
+                source->destroy(j);
+        }
+        source->list.clear();
+        source->inArena.clear();
+        target->arena.adopt(source->arena);
+    }
+
+    return res;
+}
+
+static QByteArray _dqSerialize(const DQSharedList &list,DQSerializer::Format format){
+    QByteArray res;
+    QBuffer buffer(&res);
+    buffer.open(QIODevice::WriteOnly);
+
+    DQSerializer serializer(&buffer,format);
+    serializer.write(list);
+    serializer.finish();
+
+    return res;
+}
+
+static bool _dqDeserialize(DQSharedList &list,QIODevice *device,DQSerializer::Format format){
+    DQDeserializer deserializer(device,format);
+    return deserializer.readAll(list);
+}
+
+QByteArray DQSharedList::toJson() const{
+    return _dqSerialize(*this,DQSerializer::Json);
+}
+
+QByteArray DQSharedList::toCbor() const{
+    return _dqSerialize(*this,DQSerializer::Cbor);
+}
+
+bool DQSharedList::writeBinary(QIODevice *device) const{
+    DQSerializer serializer(device,DQSerializer::Binary);
+    return serializer.write(*this) && serializer.finish();
+}
+
+bool DQSharedList::fromJson(const QByteArray &json){
+    QByteArray data(json);
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    return _dqDeserialize(*this,&buffer,DQSerializer::Json);
+}
+
+bool DQSharedList::fromCbor(const QByteArray &cbor){
+    QByteArray data(cbor);
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    return _dqDeserialize(*this,&buffer,DQSerializer::Cbor);
+}
+
+bool DQSharedList::readBinary(QIODevice *device){
+    return _dqDeserialize(*this,device,DQSerializer::Binary);
+}
+
 DQModelMetaInfo* DQSharedList::metaInfo(){
     return data->metaInfo;
 }
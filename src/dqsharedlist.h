@@ -7,6 +7,7 @@
 
 
 class DQSharedListPriv;
+class QIODevice;
 
 /// DQSharedList is the base class of DQList
 /**
@@ -35,6 +36,29 @@ class DQSharedListPriv;
 class DQSharedList
 {
 public:
+    /// The options of saveAll()
+    class BulkOptions {
+    public:
+        inline BulkOptions() {
+            forceInsert = false;
+            forceAllField = false;
+            updateId = true;
+            batchSize = 0;
+        }
+
+        /// TRUE if the data should be inserted to the database as new records regardless of the original id.
+        bool forceInsert;
+
+        /// TRUE if all the field should be saved no matter it is null or not.
+        bool forceAllField;
+
+        /// TRUE if the id field of new records should be updated after operation
+        bool updateId;
+
+        /// No. of record to be written per transaction. Zero or negative value will write all the records in a single transaction.
+        int batchSize;
+    };
+
     /// Default constructor
     DQSharedList();
 
@@ -63,6 +87,19 @@ public:
      */
     bool append(DQAbstractModel* model);
 
+    /// Create a model and append it to the list
+    /**
+      The model is constructed in a memory arena owned by the list instead of
+      being allocated individually. The arena is released at once when the
+      list is cleared or destroyed , so it is cheaper to create a large
+      number of models.
+
+      @param metaInfo The meta info of the model type
+      @return The new model. The ownership is kept by the list , it must not be deleted by user. NULL if the type is not accepted by the list.
+      @see metaInfo
+     */
+    DQAbstractModel* appendNew(DQModelMetaInfo* metaInfo);
+
     /// Removes all items from the list.
     void clear();
 
@@ -80,6 +117,116 @@ public:
 
     bool save(bool forceInsert = false,bool forceAllField = false);
 
+    /// Save all the contained item to database by the bulk write path
+    /**
+      Unlike save(), it will not call DQModel::save() on each item. The
+      records are written within a single transaction (or one per
+      options.batchSize records). Items sharing the same model and set
+      of saving fields are written by a single prepared statement with
+      QSqlQuery::execBatch(). The generated ids are written back in order.
+
+      The ids are derived from the last inserted id , it assumes the batch
+      got contiguous ids. That is guaranteed by an AUTOINCREMENT table. A table
+      without AUTOINCREMENT may reuse the ids of deleted records once the
+      largest id is reached , then the written back ids are wrong. The drivers
+      with "RETURNING id" (DQSqlStatement::returnsInsertId()) read each id instead.
+
+      All the items are written to the connection of the first item.
+
+      If any of the item failed DQModel::clean() , it will be skipped and
+      the result will be false. If the database operation is failed , the
+      whole batch will be rolled back and the ids of the items are restored.
+
+      @return TRUE if all of the item is successfully saved
+     */
+    bool saveAll(BulkOptions options = BulkOptions());
+
+    /// Remove all the models in the list from database
+    /**
+      The records are removed by chunked "DELETE ... WHERE id IN (...)" statements
+      within a single transaction. The ids of models are cleared if it is successful.
+      The models without id are skipped.
+
+      @return TRUE if it is successful. Nothing is removed on failure.
+      @see DQConnection::removeIds()
+     */
+    bool removeAll();
+
+    /// Sort the list by a field
+    /**
+      The value of the field is read once per model and converted to a typed
+      key , so the comparison does not look up the field or create QVariant.
+      The keys are ordered like SQLite : NULL first , then the numbers
+      (including QDate / QTime / QDateTime) , the strings and the blobs.
+      The sorting is stable.
+
+      A list larger than DQ_PARALLEL_SORT_THRESHOLD is sorted by multiple
+      threads.
+
+      @return FALSE if any model in the list has no such field. The list is not changed.
+     */
+    bool sortBy(QString field,Qt::SortOrder order = Qt::AscendingOrder);
+
+    /// Keep only the first k models ordered by a field
+    /**
+      It is cheaper than sortBy() for a small k , only the top k keys are
+      sorted. The other models are removed from the list and destroyed.
+
+      @see sortBy()
+     */
+    bool topK(QString field,int k,Qt::SortOrder order = Qt::AscendingOrder);
+
+    /// Merge the lists sorted by a field into a single sorted list
+    /**
+      It is a k-way merge , e.g of the results of DQShardedConnection::all() or
+      the same query on several attached databases:
+
+\code
+    QList<DQSharedList> lists;
+    lists << DQQuery<HealthCheck>(hot).orderBy("recordDate desc").limit(10).all()
+          << DQQuery<HealthCheck>(archive).orderBy("recordDate desc").limit(10).all();
+
+    DQList<HealthCheck> latest = DQSharedList::merge(lists,"recordDate",Qt::DescendingOrder,10);
+\endcode
+
+      The models are moved into the result without copying , the input lists
+      are emptied. The models of the same key are ordered by the order of lists.
+
+      @param lists The input lists. Each of them must be sorted by the field in the same order.
+      @param limit The maximum size of the result. The remaining models are destroyed. -1 if unlimited.
+      @return The merged list. It is binded to the meta info of the first list.
+     */
+    static DQSharedList merge(QList<DQSharedList> lists,QString field,Qt::SortOrder order = Qt::AscendingOrder,int limit = -1);
+
+    /// Serialize the models to a JSON array of objects
+    /**
+      @see DQSerializer
+     */
+    QByteArray toJson() const;
+
+    /// Serialize the models to a CBOR array of maps
+    QByteArray toCbor() const;
+
+    /// Write the models to a device in the binary format of DQSerializer
+    /**
+      @return FALSE if it is failed to write the device
+     */
+    bool writeBinary(QIODevice *device) const;
+
+    /// Append the models read from a JSON array
+    /**
+      The list must be binded to a model type (e.g DQList).
+      @return FALSE if the input is malformed. The records read before the error are kept.
+      @see DQDeserializer
+     */
+    bool fromJson(const QByteArray &json);
+
+    /// Append the models read from a CBOR array
+    bool fromCbor(const QByteArray &cbor);
+
+    /// Append the models read from a device in the binary format of DQSerializer
+    bool readBinary(QIODevice *device);
+
     /// Get the binded model's meta info
     /** If this function non-null value , then this object is binded
       to specific model, it could only be used to store single model type.
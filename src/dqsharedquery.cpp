@@ -1,5 +1,13 @@
 #include <QSharedData>
 #include <QSqlRecord>
+#include <QSqlError>
+#include <QRegExp>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QDataStream>
+#ifdef Q_COMPILER_RVALUE_REFS
+#include <utility>
+#endif
 
 #include "dqsql.h"
 #include "dqconnection.h"
@@ -7,6 +15,126 @@
 #include "dqsharedquery_p.h"
 #include "dqsqlstatement.h"
 #include "dqexpression.h"
+#include "dqforeignkey.h"
+#include "dqasyncworker_p.h"
+#include "dqwriterthread_p.h"
+#include "dqprofiler_p.h"
+#include "dqfieldprofile_p.h"
+#include "dqindexadvisor.h"
+#include "dqconnectionpool.h"
+
+/// Max no. of id passed to a single IN (...) clause of prefetch. SQLite limit 999 parameters by default
+#define DQ_PREFETCH_BATCH_SIZE 500
+
+/// No. of id ranges per thread of parallelForEach()
+#define DQ_PARALLEL_RANGES_PER_THREAD 16
+
+/// TRUE if the long in-lists could be bound as a JSON array on the connection
+static bool _dqJsonInList(DQConnection connection) {
+    DQSqlStatement *statement = connection.sql().statement();
+    return !statement || statement->supportsJsonInList();
+}
+
+/// The expression of a filter written for the dialect of the connection
+static DQExpression _dqExpression(DQConnection connection,DQModelMetaInfo *metaInfo,DQWhere where,QString prefix) {
+    return DQExpression(where,prefix,metaInfo ? metaInfo->name() : QString(),_dqJsonInList(connection));
+}
+
+/// The state shared by the threads of parallelForEach()
+class _DQParallelScan {
+public:
+    /// The query without connection. Each thread filters the range and set its own connection
+    DQSharedQuery query;
+
+    /// The filter of the query
+    DQWhere where;
+
+    DQModelMetaInfo *metaInfo;
+
+    _DQForEachFunction *function;
+
+    DQConnectionPool *pool;
+
+    qlonglong min;
+
+    /// No. of id per range
+    qlonglong width;
+
+    int ranges;
+
+    /// The next range to be taken
+    QAtomicInt next;
+
+    QAtomicInt failed;
+
+    /// Scan the ranges until all of them are taken
+    void run();
+};
+
+void _DQParallelScan::run(){
+    DQConnection connection = pool->connection();
+    if (!connection.isOpen()) {
+        failed.fetchAndStoreOrdered(1);
+        return;
+    }
+
+    // DQModel is the only derived class of DQAbstractModel
+    DQModel *model = static_cast<DQModel*>(metaInfo->create());
+    model->setConnection(connection);
+
+    for (;;) {
+        int range = next.fetchAndAddOrdered(1);
+        if (range >= ranges || failed.fetchAndAddOrdered(0))
+            break;
+
+        qlonglong begin = min + width * range;
+        DQWhere filter = DQWhere("id") >= begin && DQWhere("id") < begin + width;
+        if (!where.isNull())
+            filter = where && filter;
+
+        DQSharedQuery q = query.filter(filter);
+        q.setConnection(connection);
+
+        if (!q.exec()) {
+            failed.fetchAndStoreOrdered(1);
+            break;
+        }
+
+        while (q.next()) {
+            if (!q.recordTo(model)) {
+                failed.fetchAndStoreOrdered(1);
+                break;
+            }
+            function->run(model);
+        }
+        q.finish();
+    }
+
+    delete model;
+}
+
+/// A worker thread of parallelForEach()
+class _DQParallelScanThread : public QThread {
+public:
+    inline _DQParallelScanThread(_DQParallelScan *scan) : scan(scan) {
+    }
+
+protected:
+    void run() {
+        scan->run();
+    }
+
+private:
+    _DQParallelScan *scan;
+};
+
+/// Append the fields which are not in the list
+static void _dqAppendUnique(QStringList &list,const QStringList &fields) {
+    foreach (QString field, fields) {
+        if (!list.contains(field))
+            list << field;
+    }
+}
 
 DQSharedQuery::DQSharedQuery() : data(new DQSharedQueryPriv) {
     data->connection = DQConnection::defaultConnection();
@@ -17,36 +145,77 @@ DQSharedQuery::DQSharedQuery(DQConnection connection) : data(new DQSharedQueryPr
     data->connection = connection;
 }
 
-DQSharedQuery::DQSharedQuery(const DQSharedQuery &rhs) : data(rhs.data)
+DQSharedQuery::DQSharedQuery(const DQSharedQuery &rhs) : data(rhs.data) , m_query(rhs.m_query) , m_lastError(rhs.m_lastError)
 {
 }
 
 DQSharedQuery &DQSharedQuery::operator=(const DQSharedQuery &rhs)
 {
-    if (this != &rhs)
+    if (this != &rhs) {
         data.operator=(rhs.data);
+        m_query = rhs.m_query;
+        m_lastError = rhs.m_lastError;
+    }
     return *this;
 }
 
+#ifdef Q_COMPILER_RVALUE_REFS
+DQSharedQuery::DQSharedQuery(DQSharedQuery &&rhs) : data(new DQSharedQueryPriv) , m_query(rhs.m_query) , m_lastError(rhs.m_lastError)
+{
+    // rhs is left as an empty query of the same connection and model
+    data->connection = rhs.data->connection;
+    data->metaInfo = rhs.data->metaInfo;
+    data.swap(rhs.data);
+    rhs.m_query = QSqlQuery();
+}
+
+DQSharedQuery &DQSharedQuery::operator=(DQSharedQuery &&rhs)
+{
+    if (this != &rhs) {
+        data.swap(rhs.data);
+        m_query = rhs.m_query;
+        m_lastError = rhs.m_lastError;
+        rhs.m_query = QSqlQuery();
+    }
+    return *this;
+}
+#endif
+
 DQSharedQuery::~DQSharedQuery()
 {
 }
 
 void DQSharedQuery::setConnection(DQConnection connection) {
+    bool jsonInList = _dqJsonInList(data->connection);
+
     data->connection = connection;
+    data->sql.text.clear();
+
+    // The in-lists are written for the dialect of the connection
+    if (jsonInList != _dqJsonInList(connection)) {
+        if (!data->expression.isNull())
+            data->expression = _dqExpression(connection,data->metaInfo,data->where,"arg");
+        if (!data->having.isNull())
+            data->having = _dqExpression(connection,data->metaInfo,data->havingWhere,"having");
+    }
 }
 
 void DQSharedQuery::setMetaInfo(DQModelMetaInfo *info){
+    // DQQuery set the same model on every conversion. It should not detach the shared data.
+    if (data.constData()->metaInfo == info)
+        return;
+
     data->metaInfo = info;
+    data->sql.text.clear();
 }
 
-DQSharedQuery DQSharedQuery::select(QStringList fields) {
+DQSharedQuery DQSharedQuery::select(QStringList fields) DQ_QUERY_LVALUE {
     DQSharedQuery query(*this);
     query.data->fields = fields;
     return query;
 }
 
-DQSharedQuery DQSharedQuery::select(QString field) {
+DQSharedQuery DQSharedQuery::select(QString field) DQ_QUERY_LVALUE {
     DQSharedQuery query(*this);
     QStringList fields;
     fields << field;
@@ -54,25 +223,90 @@ DQSharedQuery DQSharedQuery::select(QString field) {
     return query;
 }
 
-DQSharedQuery DQSharedQuery::filter(DQWhere where) {
+DQSharedQuery DQSharedQuery::filter(DQWhere where) DQ_QUERY_LVALUE {
+    DQSharedQuery query(*this);
+    query.data->where = where;
+    query.data->expression = _dqExpression(query.data->connection,query.data->metaInfo,where,"arg");
+    return query;
+}
+
+DQSharedQuery DQSharedQuery::groupBy(QStringList fields) DQ_QUERY_LVALUE {
+    DQSharedQuery query(*this);
+    query.data->groupBy = fields;
+    return query;
+}
+
+DQSharedQuery DQSharedQuery::groupBy(QString field) DQ_QUERY_LVALUE {
+    QStringList fields;
+    fields << field;
+    return groupBy(fields);
+}
+
+DQSharedQuery DQSharedQuery::having(DQWhere where) DQ_QUERY_LVALUE {
     DQSharedQuery query(*this);
-    query.data->expression = DQExpression(where);
+    query.data->havingWhere = where;
+    query.data->having = _dqExpression(query.data->connection,query.data->metaInfo,where,"having");
     return query;
 }
 
-DQSharedQuery DQSharedQuery::limit(int val){
+DQSharedQuery DQSharedQuery::limit(int val) DQ_QUERY_LVALUE {
     DQSharedQuery query(*this);
     query.data->limit = val;
     return query;
 }
 
-DQSharedQuery DQSharedQuery::orderBy(QStringList terms){
+DQSharedQuery DQSharedQuery::offset(int val) DQ_QUERY_LVALUE {
+    DQSharedQuery query(*this);
+    query.data->offset = val;
+    return query;
+}
+
+DQSharedQuery DQSharedQuery::after(const DQAbstractModel *lastRow,QString term){
+    Q_ASSERT(data->metaInfo);
+    QStringList tokens = term.trimmed().split(QRegExp("\\s+"));
+    QString field = tokens.at(0);
+    bool desc = tokens.size() > 1 && tokens.at(1).toLower() == "desc";
+    QString op = desc ? "<" : ">";
+
+    QStringList terms;
+    terms << term;
+
+    DQSharedQuery query(*this);
+    query.data->offset = 0;
+
+    DQWhere key;
+    if (field != "id") {
+        // "id" is the tie-breaker for the records with same key
+        terms << QString("id %1").arg(desc ? "desc" : "asc");
+    }
+
+    if (lastRow) {
+        QVariant value = data->metaInfo->value(lastRow,field,true);
+        if (field == "id") {
+            key = DQWhere(field).expr(op,value);
+        } else {
+            QVariant id = data->metaInfo->value(lastRow,"id");
+            key = DQWhere(field).expr(op,value) ||
+                  ( (DQWhere(field) == value) && DQWhere("id").expr(op,id) );
+        }
+
+        DQWhere where = data->where;
+        if (!where.isNull())
+            key = where && key;
+
+        query = query.filter(key);
+    }
+
+    return query.orderBy(terms);
+}
+
+DQSharedQuery DQSharedQuery::orderBy(QStringList terms) DQ_QUERY_LVALUE {
     DQSharedQuery query(*this);
     query.data->orderBy = terms;
     return query;
 }
 
-DQSharedQuery DQSharedQuery::orderBy(QString term){
+DQSharedQuery DQSharedQuery::orderBy(QString term) DQ_QUERY_LVALUE {
     DQSharedQuery query(*this);
     QStringList fields;
     fields << term;
@@ -80,43 +314,465 @@ DQSharedQuery DQSharedQuery::orderBy(QString term){
     return query;
 }
 
-bool DQSharedQuery::exec() {
-    data->query = data->connection.query();
+DQSharedQuery DQSharedQuery::orderByRank(QString query){
+    if (!data->metaInfo) {
+        qWarning() << "DQSharedQuery::orderByRank() - The query has no model";
+        return *this;
+    }
+
+    // "id" is not a column of the index , so it refers to the record of outer query
+    QString fts = DQSqlStatement::fullTextTable(data->metaInfo->name());
+    QString term = QString("(SELECT bm25(%1) FROM %1 WHERE %1 MATCH %2 AND rowid = id)").arg(fts).arg(dqEscape(query));
+
+    return orderBy(term);
+}
+
+DQSharedQuery DQSharedQuery::prefetch(QStringList fields) DQ_QUERY_LVALUE {
+    DQSharedQuery query(*this);
+    _dqAppendUnique(query.data->prefetch,fields);
+    return query;
+}
+
+DQSharedQuery DQSharedQuery::prefetch(QString field) DQ_QUERY_LVALUE {
+    QStringList fields;
+    fields << field;
+    return prefetch(fields);
+}
 
+DQSharedQuery DQSharedQuery::selectRelated(QStringList fields) DQ_QUERY_LVALUE {
+    DQSharedQuery query(*this);
+    _dqAppendUnique(query.data->related,fields);
+    return query;
+}
+
+DQSharedQuery DQSharedQuery::selectRelated(QString field) DQ_QUERY_LVALUE {
+    QStringList fields;
+    fields << field;
+    return selectRelated(fields);
+}
+
+DQSharedQuery DQSharedQuery::defer(QStringList fields) DQ_QUERY_LVALUE {
+    DQSharedQuery query(*this);
+    _dqAppendUnique(query.data->deferred,fields);
+    return query;
+}
+
+DQSharedQuery DQSharedQuery::defer(QString field) DQ_QUERY_LVALUE {
+    QStringList fields;
+    fields << field;
+    return defer(fields);
+}
+
+DQSharedQuery DQSharedQuery::only(QStringList fields) DQ_QUERY_LVALUE {
+    DQSharedQuery query(*this);
+    _dqAppendUnique(query.data->only,fields << "id");
+    return query;
+}
+
+DQSharedQuery DQSharedQuery::only(QString field) DQ_QUERY_LVALUE {
+    QStringList fields;
+    fields << field;
+    return only(fields);
+}
+
+DQSharedQuery DQSharedQuery::autoOnly(int samples) DQ_QUERY_LVALUE {
+    DQSharedQuery query(*this);
+    query.data->autoOnlySamples = samples;
+    return query;
+}
+
+#ifdef DQ_QUERY_REF_QUALIFIERS
+DQSharedQuery DQSharedQuery::moveChanged(){
+    // The statement of the previous rules. A detached copy drops it by _DQStatementText
+    data->sql.text.clear();
+    return std::move(*this);
+}
+
+DQSharedQuery DQSharedQuery::select(QStringList fields) && {
+    data->fields = fields;
+    return moveChanged();
+}
+
+DQSharedQuery DQSharedQuery::select(QString field) && {
+    QStringList fields;
+    fields << field;
+    return std::move(*this).select(fields);
+}
+
+DQSharedQuery DQSharedQuery::filter(DQWhere where) && {
+    data->where = where;
+    data->expression = _dqExpression(data->connection,data->metaInfo,where,"arg");
+    return moveChanged();
+}
+
+DQSharedQuery DQSharedQuery::bind(int index,QVariant value) && {
+    QString sql = statement();
+
+    if (!data->expression.setBindValue(index,value))
+        qWarning() << QString("DQSharedQuery::bind() - Invalid parameter index %1").arg(index);
+
+    // Only the values are changed , the statement is still valid.
+    DQSharedQuery query = moveChanged();
+    query.data->sql.text = sql;
+    return query;
+}
+
+DQSharedQuery DQSharedQuery::limit(int val) && {
+    data->limit = val;
+    return moveChanged();
+}
+
+DQSharedQuery DQSharedQuery::offset(int val) && {
+    data->offset = val;
+    return moveChanged();
+}
+
+DQSharedQuery DQSharedQuery::orderBy(QStringList terms) && {
+    data->orderBy = terms;
+    return moveChanged();
+}
+
+DQSharedQuery DQSharedQuery::orderBy(QString term) && {
+    QStringList terms;
+    terms << term;
+    return std::move(*this).orderBy(terms);
+}
+
+DQSharedQuery DQSharedQuery::groupBy(QStringList fields) && {
+    data->groupBy = fields;
+    return moveChanged();
+}
+
+DQSharedQuery DQSharedQuery::groupBy(QString field) && {
+    QStringList fields;
+    fields << field;
+    return std::move(*this).groupBy(fields);
+}
+
+DQSharedQuery DQSharedQuery::having(DQWhere where) && {
+    data->havingWhere = where;
+    data->having = _dqExpression(data->connection,data->metaInfo,where,"having");
+    return moveChanged();
+}
+
+DQSharedQuery DQSharedQuery::prefetch(QStringList fields) && {
+    _dqAppendUnique(data->prefetch,fields);
+    return moveChanged();
+}
+
+DQSharedQuery DQSharedQuery::prefetch(QString field) && {
+    QStringList fields;
+    fields << field;
+    return std::move(*this).prefetch(fields);
+}
+
+DQSharedQuery DQSharedQuery::selectRelated(QStringList fields) && {
+    _dqAppendUnique(data->related,fields);
+    return moveChanged();
+}
+
+DQSharedQuery DQSharedQuery::selectRelated(QString field) && {
+    QStringList fields;
+    fields << field;
+    return std::move(*this).selectRelated(fields);
+}
+
+DQSharedQuery DQSharedQuery::defer(QStringList fields) && {
+    _dqAppendUnique(data->deferred,fields);
+    return moveChanged();
+}
+
+DQSharedQuery DQSharedQuery::defer(QString field) && {
+    QStringList fields;
+    fields << field;
+    return std::move(*this).defer(fields);
+}
+
+DQSharedQuery DQSharedQuery::only(QStringList fields) && {
+    _dqAppendUnique(data->only,fields << "id");
+    return moveChanged();
+}
+
+DQSharedQuery DQSharedQuery::only(QString field) && {
+    QStringList fields;
+    fields << field;
+    return std::move(*this).only(fields);
+}
+
+DQSharedQuery DQSharedQuery::autoOnly(int samples) && {
+    data->autoOnlySamples = samples;
+    return moveChanged();
+}
+#endif
+
+void DQSharedQuery::applyFieldProfile(){
+    if (data->autoOnlySamples <= 0 || !data->metaInfo || !data->fields.isEmpty() ||
+        !data->func.isEmpty() || !data->only.isEmpty() || !data->related.isEmpty())
+        return;
+
+    if (!data->profile) {
+        // The statement before any field is learned identify the queries of the same code
+        data->learned.clear();
+        data->sql.text.clear();
+        data->profile = _DQFieldProfile::profile(statement(),data->autoOnlySamples);
+    }
+
+    data->sampling = data->profile->sample();
+    if (data->sampling)
+        return;
+
+    QStringList learned = data->profile->fields(data->metaInfo);
+    if (learned != data->learned) {
+        data->learned = learned;
+        data->sql.text.clear();
+    }
+}
+
+bool DQSharedQuery::exec() {
     Q_ASSERT(data->connection.isOpen());
 
-    QString sql;
-    sql = data->connection.sql().statement()->select(*this);
+    return exec(statement());
+}
 
-    data->query.prepare(sql);
+QString DQSharedQuery::statement() {
+    if (data->sql.text.isEmpty())
+        data->sql.text = data->connection.sql().statement()->select(*this);
+    return data->sql.text;
+}
 
-    DQExpression& expression = data->expression;
-    QMap<QString,QVariant> values = expression.bindValues();
-    QMapIterator<QString, QVariant> iter(values);
+DQSharedQuery DQSharedQuery::bind(int index,QVariant value) DQ_QUERY_LVALUE {
+    // Keep the generated statement in this query , so that every copy could reuse it
+    QString sql = statement();
+    DQSharedQuery query(*this);
 
-    while (iter.hasNext()) {
-        iter.next();
-        data->query.bindValue(iter.key() , iter.value());
+    if (!query.data->expression.setBindValue(index,value))
+        qWarning() << QString("DQSharedQuery::bind() - Invalid parameter index %1").arg(index);
+
+    // Only the values are changed , the statement is still valid.
+    query.data->sql.text = sql;
+    return query;
+}
+
+int DQSharedQuery::parameterCount(){
+    return data->expression.bindNames().size();
+}
+
+void DQSharedQuery::bindValues(QSqlQuery &query){
+    DQExpression* expressions[] = { &data->expression , &data->having };
+
+    for (int e = 0 ; e < 2 ; e++) {
+        DQExpression& expression = *expressions[e];
+        QStringList names = expression.bindNames();
+        QList<QVariant> values = expression.bindValueList();
+        int n = names.size();
+
+        for (int i = 0 ; i < n;i++) {
+            query.bindValue(names.at(i) , values.at(i));
+        }
     }
+}
+
+bool DQSharedQuery::exec(const QString &sql) {
+    // Release the previous result, so that the cached statement could be reused
+    finish();
+
+    DQIndexAdvisor* advisor = data->connection.indexAdvisor();
+    if (advisor)
+        advisor->analyze(*this);
 
-    bool res = data->query.exec();
+    _DQProfiler* profiler = data->connection.profiler();
+    QElapsedTimer timer;
+    qint64 prepareTime = 0;
+    if (profiler)
+        timer.start();
 
-    data->connection.setLastQuery(data->query);
+    m_query = data->connection.sql().prepare(sql);
+    m_lastError = QSqlError();
+
+    if (profiler)
+        prepareTime = timer.nsecsElapsed();
+
+    bindValues(m_query);
+
+    bool res = m_query.exec();
+
+    if (profiler)
+        profiler->record(sql,prepareTime,timer.nsecsElapsed() - prepareTime,res);
+
+    data->connection.setLastQuery(m_query);
 
     if (!res) {
-        qWarning() << QString("Failed : %1").arg(data->query.executedQuery());
+        qWarning() << QString("Failed : %1").arg(m_query.executedQuery());
+    } else {
+        QSqlRecord record = m_query.record();
+        QStringList columns;
+        int count = record.count();
+        for (int i = 0 ; i < count;i++){
+            columns << record.fieldName(i);
+        }
+        resolveColumnMapping(columns);
     }
 
     return res;
 }
 
+bool DQSharedQuery::execCached(QList<QVariantList> *rows){
+    DQSql sql = data->connection.sql();
+    QString statement = this->statement();
+
+    QMap<QString, QVariant> values = data->expression.bindValues();
+    values.unite(data->having.bindValues());
+
+    // The values are keyed by the type and binary form. toString() is lossy (e.g the precision of double)
+    QByteArray binary;
+    QDataStream stream(&binary,QIODevice::WriteOnly);
+    QMapIterator<QString, QVariant> iter(values);
+    while (iter.hasNext()) {
+        iter.next();
+        stream << iter.key() << (qint32) iter.value().userType() << iter.value();
+    }
+
+    QString key = statement;
+    key += QLatin1Char('\n');
+    key += QString::fromLatin1(binary.constData(),binary.size());
+
+    QStringList columns;
+    if (sql.cachedResult(key,&columns,rows)) {
+        // No statement is run. Do not leave the state of the previous execution in lastQuery() / lastError()
+        finish();
+        m_query = QSqlQuery();
+        m_lastError = QSqlError();
+
+        resolveColumnMapping(columns);
+        return true;
+    }
+
+    quint64 generation = sql.resultCacheGeneration();
+
+    if (!exec(statement))
+        return false;
+
+    QSqlRecord record = m_query.record();
+    int count = record.count();
+    for (int i = 0 ; i < count;i++){
+        columns << record.fieldName(i);
+    }
+
+    while (next()) {
+        QVariantList row;
+        row.reserve(count);
+        for (int i = 0 ; i < count;i++){
+            row << m_query.value(i);
+        }
+        rows->append(row);
+    }
+    m_query.finish();
+
+    QStringList tables;
+    tables << data->metaInfo->name();
+    foreach (DQModelMetaInfo* info , data->relatedMetaInfo) {
+        if (info && data->relatedMapping.size() > 0)
+            tables << info->name();
+    }
+
+    // The result depends on the tables of subqueries too
+    tables << data->expression.tables() << data->having.tables();
+
+    sql.storeResult(key,tables,columns,*rows,generation);
+
+    return true;
+}
+
+void DQSharedQuery::resolveColumnMapping(const QStringList &columns){
+    int count = columns.size();
+
+    data->columnMapping.resize(count);
+
+    // The deferred fields could only be loaded later if the id is read
+    data->deferredMapping.clear();
+    data->sampledMapping.clear();
+    if (columns.contains("id")) {
+        foreach (QString field , data->deferredFields()) {
+            if (!columns.contains(field))
+                data->deferredMapping << data->metaInfo->indexOf(field);
+        }
+
+        // Only the fields of this execution are sampled
+        if (data->sampling) {
+            foreach (QString column , columns) {
+                int index = data->metaInfo->indexOf(column);
+                if (index >= 0 && column != "id")
+                    data->sampledMapping << index;
+            }
+        }
+    }
+    data->sampling = false;
+
+    if (data->related.isEmpty() || !data->metaInfo || !data->func.isEmpty()) {
+        data->relatedMapping.clear();
+        for (int i = 0 ; i < count;i++){
+            data->columnMapping[i] = data->metaInfo ? data->metaInfo->indexOf(columns.at(i)) : -1;
+        }
+        return;
+    }
+
+    int n = data->related.size();
+    data->relatedKeyIndex.resize(n);
+    data->relatedMetaInfo.resize(n);
+    for (int i = 0 ; i < n ; i++) {
+        int index = data->metaInfo->indexOf(data->related.at(i));
+        data->relatedKeyIndex[i] = index;
+        data->relatedMetaInfo[i] = data->metaInfo->linkedMetaInfo(index);
+    }
+
+    data->relatedMapping.resize(count);
+    for (int i = 0 ; i < count;i++){
+        QString name = columns.at(i);
+        int relation = -1;
+        int index = -1;
+        int sep = name.indexOf("__");
+
+        if (sep > 0) {
+            relation = data->related.indexOf(name.left(sep));
+            if (relation >= 0 && data->relatedMetaInfo.at(relation))
+                index = data->relatedMetaInfo.at(relation)->indexOf(name.mid(sep + 2));
+        } else {
+            index = data->metaInfo->indexOf(name);
+        }
+
+        data->columnMapping[i] = index;
+        data->relatedMapping[i] = relation;
+    }
+}
+
 bool DQSharedQuery::remove(){
-    data->query = data->connection.query();
+    _DQWriterThread* writerThread = data->connection.writerThread();
+    if (writerThread && data->connection.sql().transactionDepth() == 0) {
+        // The result of the writer belongs to its thread , only the error is returned
+        finish();
+        m_query = QSqlQuery();
+        int rows = writerThread->remove(asyncCopy(writerThread->connection()),&m_lastError);
+        if (rows >= 0)
+            data->connection.sql().notifyTableChanged(data->metaInfo->name(),rows);
+        return rows >= 0;
+    }
 
     QString sql;
     sql = data->connection.sql().statement()->deleteFrom(*this);
 
-    data->query.prepare(sql);
+    finish();
+
+    _DQProfiler* profiler = data->connection.profiler();
+    QElapsedTimer timer;
+    qint64 prepareTime = 0;
+    if (profiler)
+        timer.start();
+
+    m_query = data->connection.sql().prepare(sql);
+    m_lastError = QSqlError();
+
+    if (profiler)
+        prepareTime = timer.nsecsElapsed();
 
     DQExpression &expression = data->expression;
     QMap<QString,QVariant> values = expression.bindValues();
@@ -124,31 +780,421 @@ bool DQSharedQuery::remove(){
 
     while (iter.hasNext()) {
         iter.next();
-        data->query.bindValue(iter.key() , iter.value());
+        m_query.bindValue(iter.key() , iter.value());
+    }
+
+    bool res = m_query.exec();
+
+    if (profiler)
+        profiler->record(sql,prepareTime,timer.nsecsElapsed() - prepareTime,res);
+
+    data->connection.setLastQuery(m_query);
+
+    if (res)
+        data->connection.sql().notifyTableChanged(data->metaInfo->name(),m_query.numRowsAffected());
+
+    return res;
+}
+
+int DQSharedQuery::update(QVariantMap assignments){
+    static int whereTypeId = qMetaTypeId<DQWhere>();
+
+    _DQWriterThread* writerThread = data->connection.writerThread();
+    if (writerThread && data->connection.sql().transactionDepth() == 0) {
+        finish();
+        m_query = QSqlQuery();
+        int rows = writerThread->update(asyncCopy(writerThread->connection()),assignments,&m_lastError);
+        if (rows >= 0)
+            data->connection.sql().notifyTableChanged(data->metaInfo->name(),rows);
+        return rows;
+    }
+
+    QStringList terms;
+    QMap<QString,QVariant> values;
+
+    int i = 0;
+    QMapIterator<QString, QVariant> iter(assignments);
+    while (iter.hasNext()) {
+        iter.next();
+        QVariant value = iter.value();
+        QString arg;
+
+        if (value.userType() == whereTypeId) {
+            DQExpression expression(value.value<DQWhere>(),QString("set%1_").arg(i));
+            arg = expression.string();
+            values.unite(expression.bindValues());
+        } else {
+            arg = QString(":set%1").arg(i);
+            values[arg] = value;
+        }
+
+        terms << QString("%1 = %2").arg(iter.key()).arg(arg);
+        i++;
     }
 
-    bool res = data->query.exec();
+    if (terms.isEmpty())
+        return 0;
 
-    data->connection.setLastQuery(data->query);
+    QString sql;
+    sql = data->connection.sql().statement()->update(*this,terms);
+
+    finish();
+
+    _DQProfiler* profiler = data->connection.profiler();
+    QElapsedTimer timer;
+    qint64 prepareTime = 0;
+    if (profiler)
+        timer.start();
+
+    m_query = data->connection.sql().prepare(sql);
+    m_lastError = QSqlError();
+
+    if (profiler)
+        prepareTime = timer.nsecsElapsed();
+
+    values.unite(data->expression.bindValues());
+    QMapIterator<QString, QVariant> bindIter(values);
+
+    while (bindIter.hasNext()) {
+        bindIter.next();
+        m_query.bindValue(bindIter.key() , bindIter.value());
+    }
+
+    int res = -1;
+    bool ok = m_query.exec();
+
+    if (profiler)
+        profiler->record(sql,prepareTime,timer.nsecsElapsed() - prepareTime,ok);
+
+    if (ok) {
+        res = m_query.numRowsAffected();
+        data->connection.sql().notifyTableChanged(data->metaInfo->name(),res);
+    }
+
+    data->connection.setLastQuery(m_query);
 
     return res;
 }
 
 DQSharedList DQSharedQuery::all(){
     DQSharedList res;
+
+    applyFieldProfile();
+
+    if (data->connection.sql().isResultCacheEnabled()) {
+        QList<QVariantList> rows;
+        if (execCached(&rows)) {
+            foreach (QVariantList row , rows) {
+                DQAbstractModel* model = res.appendNew(data->metaInfo);
+                hydrate(model,&row);
+            }
+
+            if (!data->prefetch.isEmpty())
+                prefetchRelated(res);
+        }
+        return res;
+    }
+
     if (exec()) {
+        _DQProfiler* profiler = data->connection.profiler();
+        QElapsedTimer timer;
+        if (profiler)
+            timer.start();
+
         while (next() ) {
-            DQAbstractModel* model = data->metaInfo->create();
+            DQAbstractModel* model = res.appendNew(data->metaInfo);
             DQSharedQuery::recordTo(model);
-            res.append(model);
         }
+        m_query.finish();
+
+        if (profiler)
+            profiler->addRows(res.size(),timer.nsecsElapsed());
+
+        if (!data->prefetch.isEmpty())
+            prefetchRelated(res);
     }
 
     return res;
 }
 
+static DQSharedList _dqAsyncAll(DQSharedQuery query,QString,QStringList) {
+    return query.all();
+}
+
+static int _dqAsyncCount(DQSharedQuery query,QString,QStringList) {
+    return query.count();
+}
+
+static QVariant _dqAsyncCall(DQSharedQuery query,QString func,QStringList fields) {
+    return query.call(func,fields);
+}
+
+/// Queue a job to the async worker
+template <typename T>
+static QFuture<T> _dqSubmitAsync(_DQAsyncWorker *worker,DQSharedQuery query,
+                                 typename _DQAsyncQueryJob<T>::Function function,
+                                 QString func = QString(),QStringList fields = QStringList()) {
+    _DQAsyncQueryJob<T> *job = new _DQAsyncQueryJob<T>(query,function,func,fields);
+    QFuture<T> res = job->future();
+
+    if (worker) {
+        worker->submit(job);
+    } else {
+        qWarning() << "DQSharedQuery - The connection is not opened";
+        job->cancel();
+        delete job;
+    }
+
+    return res;
+}
+
+DQSharedQuery DQSharedQuery::asyncCopy(DQConnection connection){
+    DQSharedQuery query(*this);
+    query.setConnection(connection);
+
+    // The result of current query belongs to the calling thread
+    query.m_query = QSqlQuery();
+    return query;
+}
+
+QFuture<DQSharedList> DQSharedQuery::allAsync(){
+    _DQAsyncWorker *worker = data->connection.asyncWorker();
+    DQSharedQuery query = worker ? asyncCopy(worker->connection()) : *this;
+    return _dqSubmitAsync<DQSharedList>(worker,query,_dqAsyncAll);
+}
+
+QFuture<int> DQSharedQuery::countAsync(){
+    _DQAsyncWorker *worker = data->connection.asyncWorker();
+    DQSharedQuery query = worker ? asyncCopy(worker->connection()) : *this;
+    return _dqSubmitAsync<int>(worker,query,_dqAsyncCount);
+}
+
+QFuture<QVariant> DQSharedQuery::callAsync(QString func,QStringList fields){
+    _DQAsyncWorker *worker = data->connection.asyncWorker();
+    DQSharedQuery query = worker ? asyncCopy(worker->connection()) : *this;
+    return _dqSubmitAsync<QVariant>(worker,query,_dqAsyncCall,func,fields);
+}
+
+bool DQSharedQuery::parallelScan(int nThreads , _DQForEachFunction *function){
+    Q_ASSERT(data->metaInfo);
+
+    if (data->limit > 0 || data->offset > 0) {
+        qWarning() << "DQSharedQuery::parallelForEach() - limit() and offset() are not supported";
+        return false;
+    }
+
+    // call() changes the result column , so the range is read by copies
+    QVariant min = DQSharedQuery(*this).call("min","id");
+    QVariant max = DQSharedQuery(*this).call("max","id");
+    if (min.isNull() || max.isNull()) // No record
+        return true;
+
+    QString databaseName = data->connection.sql().database().databaseName();
+    if (databaseName.isEmpty() || databaseName == ":memory:")
+        nThreads = 1; // The clone is a new database
+
+    nThreads = qMax(nThreads,1);
+
+    _DQParallelScan scan;
+    scan.query = *this;
+    scan.query.m_query = QSqlQuery(); // The result of current query belongs to the calling thread
+    scan.query.data->orderBy.clear();
+    scan.query.data->func.clear(); // The query may have been used by call()
+    scan.query.data->fields.clear();
+    scan.query.data->sql.text.clear();
+    scan.where = data->where;
+    scan.metaInfo = data->metaInfo;
+    scan.function = function;
+    scan.min = min.toLongLong();
+    scan.ranges = nThreads == 1 ? 1 : nThreads * DQ_PARALLEL_RANGES_PER_THREAD;
+
+    qlonglong span = max.toLongLong() - scan.min + 1;
+    scan.width = qMax((span + scan.ranges - 1) / scan.ranges , Q_INT64_C(1));
+
+    // Use the default pool if it serves this connection , so the clones are shared with other queries
+    DQConnectionPool *defaultPool = DQConnectionPool::defaultPool();
+    DQConnectionPool *pool = 0;
+    if (defaultPool && defaultPool->baseConnection() == data->connection) {
+        scan.pool = defaultPool;
+    } else {
+        pool = new DQConnectionPool(data->connection);
+        scan.pool = pool;
+    }
+
+    QList<_DQParallelScanThread*> threads;
+    for (int i = 1 ; i < nThreads;i++) {
+        _DQParallelScanThread *thread = new _DQParallelScanThread(&scan);
+        threads << thread;
+        thread->start();
+    }
+
+    scan.run();
+
+    // The clones of the threads are closed on their exit
+    foreach (_DQParallelScanThread *thread , threads) {
+        thread->wait();
+        delete thread;
+    }
+
+    delete pool;
+
+    return !scan.failed.fetchAndAddOrdered(0);
+}
+
+DQColumnarResult DQSharedQuery::columns(QStringList fields){
+    DQColumnarResult res;
+
+    if (!fields.isEmpty()) {
+        data->fields = fields;
+        data->sql.text.clear();
+    }
+
+    if (exec()) {
+        res.read(m_query,data->metaInfo);
+        m_query.finish();
+    }
+
+    return res;
+}
+
+DQColumnarResult DQSharedQuery::aggregate(QList<DQAggregate> aggregates){
+    DQColumnarResult res;
+
+    QStringList fields = data->groupBy;
+    QMap<QString,DQColumnarResult::Type> types;
+
+    foreach (DQAggregate aggregate , aggregates) {
+        QString name = aggregate.name;
+        if (name.isEmpty())
+            name = QString("%1_%2").arg(aggregate.func).arg(aggregate.field == "*" ? "all" : aggregate.field);
+        fields << QString("%1(%2) AS %3").arg(aggregate.func).arg(aggregate.field).arg(name);
+
+        // The type of the result depends on the function
+        QString func = aggregate.func.toLower();
+        if (func == "count") {
+            types[name] = DQColumnarResult::Integer;
+        } else if (func == "avg" || func == "total") {
+            types[name] = DQColumnarResult::Real;
+        } else if (data->metaInfo && data->metaInfo->indexOf(aggregate.field) >= 0) {
+            // min() / max() / sum() keep the type of the field , e.g a QDateTime is read as Text
+            types[name] = DQColumnarResult::fieldType(data->metaInfo,aggregate.field);
+        } else {
+            types[name] = DQColumnarResult::Real;
+        }
+    }
+
+    DQSharedQuery query = select(fields);
+    if (query.exec()) {
+        res.read(query.m_query,data->metaInfo,types);
+        query.m_query.finish();
+    }
+
+    return res;
+}
+
+DQQueryPlan DQSharedQuery::explain(){
+    DQQueryPlan res;
+
+    QSqlQuery query = data->connection.query();
+    if (!query.prepare("EXPLAIN QUERY PLAN " + statement())) {
+        qWarning() << "DQSharedQuery::explain() - " << query.lastError().text();
+        data->connection.setLastQuery(query);
+        return res;
+    }
+
+    bindValues(query);
+
+    if (!query.exec()) {
+        qWarning() << "DQSharedQuery::explain() - " << query.lastError().text();
+        data->connection.setLastQuery(query);
+        return res;
+    }
+
+    // The columns are (id , parent , notused , detail) , or (selectid , order , from , detail) before SQLite 3.24
+    while (query.next()) {
+        DQQueryPlan::Step step;
+        step.id = query.value(0).toInt();
+        step.parent = query.value(1).toInt();
+        step.detail = query.value(3).toString();
+        res.append(step);
+    }
+
+    return res;
+}
+
+void DQSharedQuery::prefetchRelated(DQSharedList list){
+    DQModelMetaInfo *metaInfo = data->metaInfo;
+    int n = list.size();
+
+    foreach (QString name , data->prefetch) {
+        int index = metaInfo->indexOf(name);
+        DQModelMetaInfo *targetInfo = metaInfo->linkedMetaInfo(index);
+
+        if (!targetInfo) {
+            qWarning() << QString("DQSharedQuery::prefetch() - %1 is not a foreign key of %2").arg(name).arg(metaInfo->name());
+            continue;
+        }
+
+        // Collect the distinct key values
+        QList<QVariant> ids;
+        QSet<int> found;
+        for (int i = 0 ; i < n;i++) {
+            DQBaseForeignKey *key = static_cast<DQBaseForeignKey*>(metaInfo->field(list.at(i),index));
+            QVariant value = key->get();
+            if (value.isNull())
+                continue;
+            int id = value.toInt();
+            if (!found.contains(id)) {
+                found.insert(id);
+                ids << id;
+            }
+        }
+
+        QHash<int,DQAbstractModel*> linked;
+        for (int from = 0 ; from < ids.size() ; from += DQ_PREFETCH_BATCH_SIZE) {
+            DQSharedQuery query(data->connection);
+            query.setMetaInfo(targetInfo);
+            query = query.filter(DQWhere("id").in(ids.mid(from,DQ_PREFETCH_BATCH_SIZE)));
+
+            if (!query.exec())
+                break;
+
+            while (query.next()) {
+                DQAbstractModel *model = targetInfo->create();
+                query.recordTo(model);
+                int id = targetInfo->value(model,"id").toInt();
+                if (linked.contains(id))
+                    delete linked[id];
+                linked[id] = model;
+            }
+            query.finish();
+        }
+
+        for (int i = 0 ; i < n;i++) {
+            DQBaseForeignKey *key = static_cast<DQBaseForeignKey*>(metaInfo->field(list.at(i),index));
+            QVariant value = key->get();
+            if (value.isNull())
+                continue;
+            DQAbstractModel *model = linked.value(value.toInt(),0);
+            if (model)
+                key->setLinkedModel(model);
+        }
+
+        qDeleteAll(linked);
+    }
+}
+
 QSqlQuery DQSharedQuery::lastQuery(){
-    return data->query;
+    return m_query;
+}
+
+QSqlError DQSharedQuery::lastError(){
+    return m_lastError.isValid() ? m_lastError : m_query.lastError();
+}
+
+void DQSharedQuery::finish(){
+    if (m_query.isActive())
+        m_query.finish();
 }
 
 void DQSharedQuery::reset(){
@@ -157,28 +1203,43 @@ void DQSharedQuery::reset(){
     data.operator =(new DQSharedQueryPriv);
     data->connection = conn;
     data->metaInfo = metaInfo;
+    m_query = QSqlQuery();
+    m_lastError = QSqlError();
 }
 
 bool DQSharedQuery::next() {
-    return data->query.next();
+    return m_query.next();
 }
 
 QVariant DQSharedQuery::value() {
-    QSqlRecord record = data->query.record();
+    QSqlRecord record = m_query.record();
 
     QVariant res = record.value(0);
 
     return res;
 }
 
+QVariant DQSharedQuery::value(int index) {
+    return m_query.value(index);
+}
+
 int DQSharedQuery::count(){
     int res = 0;
     data->func = "count";
+    data->sql.text.clear();
+
+    if (data->connection.sql().isResultCacheEnabled()) {
+        QList<QVariantList> rows;
+        if (execCached(&rows) && rows.size() > 0 && rows.first().size() > 0)
+            res = rows.first().first().toInt();
+        return res;
+    }
 
     if (exec()) {
         if (next()){
             res = value().toInt();
         }
+        m_query.finish();
     }
     return res;
 }
@@ -186,12 +1247,21 @@ int DQSharedQuery::count(){
 QVariant DQSharedQuery::call(QString func , QStringList fields){
     data->func = func;
     data->fields = fields;
+    data->sql.text.clear();
 
     QVariant res;
+
+    if (data->connection.sql().isResultCacheEnabled()) {
+        QList<QVariantList> rows;
+        if (execCached(&rows) && rows.size() > 0 && rows.first().size() > 0)
+            res = rows.first().first();
+        return res;
+    }
     if (exec()) {
         if (next()){
             res = value();
         }
+        m_query.finish();
     }
 
     return res;
@@ -204,35 +1274,135 @@ QVariant DQSharedQuery::call(QString func , QString field){
 }
 
 bool DQSharedQuery::recordTo(DQAbstractModel *model) {
+    return hydrate(model,0);
+}
+
+bool DQSharedQuery::hydrate(DQAbstractModel *model,const QVariantList *row) {
     Q_ASSERT (data->metaInfo);
     Q_ASSERT (data->metaInfo == model->metaInfo() );
     bool res = true;
 
-    QSqlRecord record = data->query.record();
+    const QVector<int> &mapping = data->columnMapping;
+    const QVector<int> &relatedMapping = data->relatedMapping;
+    DQModelMetaInfo *metaInfo = data->metaInfo;
+    QSqlQuery &query = m_query;
 
-    int count = record.count();
+    bool hasRelated = !relatedMapping.isEmpty();
+    int count = mapping.size();
     for (int i = 0 ; i < count;i++){
-        QString field = record.fieldName(i);
-        res = data->metaInfo->setValue(model,field,record.value(i));
-        if (!res)
+        int index = mapping.at(i);
+        if (index < 0) {
+            // The column is not a field of the model
+            res = false;
             break;
+        }
+
+        QVariant value = row ? row->at(i) : query.value(i);
+
+        int relation = hasRelated ? relatedMapping.at(i) : -1;
+        if (relation < 0) {
+            metaInfo->setValue(model,index,value);
+        } else {
+            // The column of a "linked" model. The foreign key column is placed before it.
+            DQBaseForeignKey *key = static_cast<DQBaseForeignKey*>(metaInfo->field(model,data->relatedKeyIndex.at(relation)));
+            data->relatedMetaInfo.at(relation)->setValue(key->linkedModel(),index,value);
+        }
+    }
+
+    // The model is now identical to the record
+    metaInfo->setDirty(model,false);
+
+    const QVector<int> &deferredMapping = data->deferredMapping;
+    int n = deferredMapping.size();
+    for (int i = 0 ; i < n;i++) {
+        metaInfo->field(model,deferredMapping.at(i))->setDeferred(model);
+    }
+
+    const QVector<int> &sampledMapping = data->sampledMapping;
+    n = sampledMapping.size();
+    for (int i = 0 ; i < n;i++) {
+        metaInfo->field(model,sampledMapping.at(i))->setSampled(model);
+    }
+
+    // DQModel is the only derived class of DQAbstractModel
+    if (data->profile)
+        static_cast<DQModel*>(model)->m_fieldProfile = data->profile;
+    if (hasRelated) {
+        int n = data->relatedKeyIndex.size();
+        for (int i = 0 ; i < n;i++) {
+            if (!data->relatedMetaInfo.at(i))
+                continue;
+            DQBaseForeignKey *key = static_cast<DQBaseForeignKey*>(metaInfo->field(model,data->relatedKeyIndex.at(i)));
+            data->relatedMetaInfo.at(i)->setDirty(key->linkedModel(),false);
+        }
     }
 
     return res;
 }
 
+/// Get the id from a filter in form of "id = value"
+static bool _dqIdFilter(DQWhere where,QVariant *id) {
+    if (where.isNull() || where.op() != "=")
+        return false;
+
+    QVariant left = where.left();
+    if (left.userType() != qMetaTypeId<DQWhere>())
+        return false;
+
+    DQWhere field = left.value<DQWhere>();
+    if (!field.isField() || field.toString() != "id")
+        return false;
+
+    QVariant right = where.right();
+    if (right.isNull() || right.userType() >= (int) QVariant::UserType)
+        return false;
+
+    *id = right;
+    return true;
+}
+
 bool DQSharedQuery::get(DQAbstractModel* model){
     Q_ASSERT (data->metaInfo);
     Q_ASSERT (data->metaInfo == model->metaInfo() );
 
-    data->limit = 1;
+    if (data->limit != 1) {
+        data->limit = 1;
+        data->sql.text.clear();
+    }
     bool res = false;
 
+    // A lookup by id of the whole record could be served by the identity map
+    DQSql sql = data->connection.sql();
+    QVariant id;
+    bool identity = sql.isIdentityMapEnabled() &&
+                    data->fields.isEmpty() &&
+                    data->offset == 0 &&
+                    _dqIdFilter(data->where,&id);
+
+    if (identity && sql.lookupIdentity(data->metaInfo,id,model))
+        return true;
+
+    applyFieldProfile();
+
+    quint64 generation = sql.resultCacheGeneration();
+
     if ( exec() ) {
+        _DQProfiler* profiler = data->connection.profiler();
+        QElapsedTimer timer;
+        if (profiler)
+            timer.start();
+
         if (next()){
             res = recordTo(model);
         }
+        m_query.finish();
+
+        if (profiler)
+            profiler->addRows(res ? 1 : 0,timer.nsecsElapsed());
     }
 
+    if (res && identity)
+        sql.storeIdentity(data->metaInfo,model,generation);
+
     return res;
 }
@@ -3,12 +3,75 @@
 
 #include <QSharedDataPointer>
 #include <QExplicitlySharedDataPointer>
+#include <QFuture>
+#include <QVector>
+#include <QPair>
+#include <QSqlQuery>
+#include <QSqlError>
 #include <dqconnection.h>
 #include <dqwhere.h>
 #include <dqmodelmetainfo.h>
 #include <dqsharedlist.h>
+#include <dqcolumnarresult.h>
+#include <dqqueryplan.h>
 
 class DQSharedQueryPriv;
+
+/// The builder functions of DQSharedQuery have rvalue overloads
+/**
+  A builder function (e.g filter() ) called on a temporary query changes the
+  rules in place and moves the query to the result , instead of copying the
+  shared data. So a chain like DQQuery<T>().filter(..).orderBy(..).limit(..)
+  allocates the data once.
+ */
+#if defined(Q_COMPILER_RVALUE_REFS) && defined(Q_COMPILER_REF_QUALIFIERS)
+#define DQ_QUERY_REF_QUALIFIERS
+#define DQ_QUERY_LVALUE &
+#else
+#define DQ_QUERY_LVALUE
+#endif
+
+/// An aggregate function over a field used by DQSharedQuery::aggregate()
+class DQAggregate {
+public:
+    /**
+      @param func The function name (e.g sum , avg , count , max , ...)
+      @param field The field passed to the function
+      @param name The name of result column. The default name is "<func>_<field>" (e.g "sum_karma") , or "<func>_all" for "*"
+     */
+    inline DQAggregate(QString func , QString field = "*" , QString name = QString()) :
+        func(func) , field(field) , name(name) {
+    }
+
+    QString func;
+    QString field;
+    QString name;
+};
+
+/// The function run by DQSharedQuery::parallelForEach() (Internal use)
+class _DQForEachFunction {
+public:
+    virtual ~_DQForEachFunction() {
+    }
+
+    /// Process a record. It is called by several threads concurrently.
+    virtual void run(DQAbstractModel *model) = 0;
+};
+
+/// Wrap a function taking a model reference as _DQForEachFunction
+template <typename Model,typename Function>
+class _DQForEachFunctionImpl : public _DQForEachFunction {
+public:
+    inline _DQForEachFunctionImpl(Function fn) : fn(fn) {
+    }
+
+    void run(DQAbstractModel *model) {
+        fn(*static_cast<Model*>(model));
+    }
+
+    Function fn;
+};
+
 class DQConnection;
 class DQWhere;
 
@@ -41,6 +104,14 @@ public:
     /// Assignment operator overloading
     DQSharedQuery &operator=(const DQSharedQuery &);
 
+#ifdef Q_COMPILER_RVALUE_REFS
+    /// Move constructor. rhs is left as an empty query of the same connection and model.
+    DQSharedQuery(DQSharedQuery &&rhs);
+
+    /// Move assignment
+    DQSharedQuery &operator=(DQSharedQuery &&rhs);
+#endif
+
     /// Default destructor
     ~DQSharedQuery();
 
@@ -54,7 +125,7 @@ public:
 
         @remarks If you don't specific the "id" field. It will not load the field. If you save the model , it will insert a new entity to the database.
      */
-    DQSharedQuery select(QStringList fields);
+    DQSharedQuery select(QStringList fields) DQ_QUERY_LVALUE;
 
     /// Construct a new query object with only a single field in result
     /**
@@ -63,13 +134,60 @@ public:
 
         @remarks If the field is not the "id" field, and you call the save() method on the model. It will insert a new entity to the database
      */
-    DQSharedQuery select(QString field);
+    DQSharedQuery select(QString field) DQ_QUERY_LVALUE;
 
     /// Construct a new query object with assigned filter
-    DQSharedQuery filter(DQWhere where);
+    DQSharedQuery filter(DQWhere where) DQ_QUERY_LVALUE;
+
+    /// Construct a new query object with a new value of a filter parameter
+    /**
+      The values passed to filter() are the parameters of query. They are
+      numbered in the order of appearance in the filter (between() takes two
+      , in() takes one per item). bind() replaces the value of a parameter
+      and keeps the generated SQL statement , so a query of the same shape
+      could be run in a loop without walking the DQWhere tree or generating
+      the SQL again. The prepared statement is reused by the statement cache
+      of DQSql.
+
+      An in() list longer than DQ_IN_LIST_THRESHOLD (64 by default) is bound
+      as a single parameter holding a JSON array ( DQWhere::in() ). It takes
+      one position only , and its value is replaced by a JSON array text ,
+      e.g bind(0,"[150,160]"). Use parameterCount() to find out the no. of
+      positions instead of counting the values.
+
+      Example:
+\code
+    DQQuery<HealthCheck> query = DQQuery<HealthCheck>().filter(DQWhere("height") > 0 && DQWhere("name") == "");
+
+    foreach (QString name , names) {
+        DQList<HealthCheck> list = query.bind(0,150).bind(1,name).all();
+    }
+\endcode
+
+      @param index The position of parameter
+      @param value The new value
+      @remarks The DQWhere kept for after() is not changed.
+     */
+    DQSharedQuery bind(int index,QVariant value) DQ_QUERY_LVALUE;
+
+    /// No. of parameters in the filter
+    /**
+      It is the no. of positions accepted by bind() , which is not always
+      the no. of values passed to filter(). An in() list longer than
+      DQ_IN_LIST_THRESHOLD is counted as one. The parameters of having() are
+      not included.
+     */
+    int parameterCount();
 
     /// Construct a new query object with limitation no. of result
-    DQSharedQuery limit(int val);
+    DQSharedQuery limit(int val) DQ_QUERY_LVALUE;
+
+    /// Construct a new query object which skip the first n records of result
+    /**
+      It is usually used with limit() for pagination. For deep page, the skipped
+      records are still visited by database. Consider DQQuery::after() instead.
+     */
+    DQSharedQuery offset(int val) DQ_QUERY_LVALUE;
 
     /// Construct a new query object with required sorting order
     /**
@@ -92,13 +210,209 @@ public:
 \endcode
 
      */
-    DQSharedQuery orderBy(QStringList terms);
+    DQSharedQuery orderBy(QStringList terms) DQ_QUERY_LVALUE;
 
     /// Construct a new query object with required sorting order
     /**
       It is a overloaded function
      */
-    DQSharedQuery orderBy(QString term);
+    DQSharedQuery orderBy(QString term) DQ_QUERY_LVALUE;
+
+    /// Construct a new query object which sort the records by the relevance to a full text query
+    /**
+      The records are ordered by the bm25() score of the FTS5 index , the best match come first.
+      It is used with a filter of DQWhere::match() by the same query.
+
+      @remarks The score is looked up by rowid for every result record. It replaces the ordering terms set by orderBy().
+      @see DQWhere::match()
+     */
+    DQSharedQuery orderByRank(QString query);
+
+    /// Construct a new query object which group the records by fields
+    /**
+      It is used with aggregate() to compute the aggregate functions per group
+      in a single statement.
+
+\code
+    DQQuery<User> query;
+    DQColumnarResult result = query.groupBy("category")
+                                   .having(DQWhere("count_id") > 1)
+                                   .aggregate(QList<DQAggregate>() << DQAggregate("sum","karma") << DQAggregate("count","id"));
+
+    for (int i = 0 ; i < result.rowCount();i++) {
+        qDebug() << result.text(0,i) << result.integers(1).at(i) << result.integers(2).at(i);
+    }
+\endcode
+     */
+    DQSharedQuery groupBy(QStringList fields) DQ_QUERY_LVALUE;
+
+    /// Construct a new query object which group the records by a field
+    /**
+      It is a overloaded function
+     */
+    DQSharedQuery groupBy(QString field) DQ_QUERY_LVALUE;
+
+    /// Construct a new query object with the HAVING clause
+    /**
+      The filter is applied to the groups. The aggregate result could be referred by its name (e.g "sum_karma").
+      Without groupBy() the whole result is a single group , which requires SQLite 3.39 or later.
+     */
+    DQSharedQuery having(DQWhere where) DQ_QUERY_LVALUE;
+
+    /// Construct a new query object which prefetch the "linked" models of foreign keys
+    /**
+      @param fields The name of the foreign key fields
+
+      By default, DQForeignKey load the "linked" model on first access, which
+      runs a query per record. When prefetch is set, all() collects the
+      foreign key values of the whole result and loads the "linked" records
+      by a single "IN (...)" query per relation, then assigns them to
+      the foreign keys. No more query is needed to access them.
+
+      The call could be chained, the fields are appended.
+
+      Example:
+\code
+    DQQuery<FriendShip> query;
+    DQList<FriendShip> list = query.prefetch(QStringList() << "a" << "b").all();
+
+    qDebug() << list.at(0)->a->name; // It will not query the database
+\endcode
+
+      @remarks It is only applied by all()
+     */
+    DQSharedQuery prefetch(QStringList fields) DQ_QUERY_LVALUE;
+
+    /// Construct a new query object which prefetch the "linked" model of a foreign key
+    /**
+      It is a overloaded function
+     */
+    DQSharedQuery prefetch(QString field) DQ_QUERY_LVALUE;
+
+    /// Construct a new query object which read the "linked" models of foreign keys by JOIN
+    /**
+      @param fields The name of the foreign key fields
+
+      The "linked" tables are joined to the query by "LEFT JOIN", so that the
+      record and its "linked" models are read from a single result row.
+      It saves a round trip compare with prefetch(), and it is suitable for
+      small relations. The call could be chained, the fields are appended.
+
+      Example:
+\code
+    DQQuery<Config> query;
+    DQList<Config> list = query.selectRelated("uid").all();
+
+    qDebug() << list.at(0)->uid->name; // It will not query the database
+\endcode
+
+      The columns of linked model is named as "<foreign key>__<field>" in result.
+
+      @remarks It is ignored by call() and count()
+      @see prefetch()
+     */
+    DQSharedQuery selectRelated(QStringList fields) DQ_QUERY_LVALUE;
+
+    /// Construct a new query object which read the "linked" model of a foreign key by JOIN
+    /**
+      It is a overloaded function
+     */
+    DQSharedQuery selectRelated(QString field) DQ_QUERY_LVALUE;
+
+    /// Construct a new query object which leave out the fields from the result
+    /**
+      @param fields The name of fields. The call could be chained , the fields are appended.
+
+      The deferred fields are not read by all() / get(). They are loaded on first
+      access by a single column query of the record id, and they are not written by
+      save() if they are untouched. It is suitable for large TEXT / BLOB field.
+
+      The fields declared with DQDeferred clause are always deferred.
+
+\code
+    DQQuery<Document> query;
+    DQList<Document> list = query.defer("payload").all();
+
+    qDebug() << list.at(0)->title; // It will not query the database
+    qDebug() << list.at(0)->payload; // Load the payload of the record
+\endcode
+
+      @remarks It is ignored if the fields are selected explicitly by select() , or the record id is not read.
+      @see DQBaseField::isDeferred()
+     */
+    DQSharedQuery defer(QStringList fields) DQ_QUERY_LVALUE;
+
+    /// Construct a new query object which leave out a field from the result
+    /**
+      It is a overloaded function
+     */
+    DQSharedQuery defer(QString field) DQ_QUERY_LVALUE;
+
+    /// Construct a new query object which only read the fields into the records
+    /**
+      It is the opposite of defer(). The id and the given fields are read by all() / get(),
+      the other fields are deferred and loaded on first access. A narrow column list
+      could be served by a covering index without reading the whole row.
+
+\code
+    DQQuery<User> query;
+    DQList<User> list = query.only("name").filter(DQWhere("userId") == "ben").all();
+\endcode
+
+      @remarks The foreign keys used by selectRelated() should be included.
+     */
+    DQSharedQuery only(QStringList fields) DQ_QUERY_LVALUE;
+
+    /// Construct a new query object which only read a field into the records
+    /**
+      It is a overloaded function
+     */
+    DQSharedQuery only(QString field) DQ_QUERY_LVALUE;
+
+    /// Construct a new query object which learn the fields to be read from the access of its records
+    /**
+      @param samples No. of executions to be sampled
+
+      The first executions of the statement read all the fields, and the first access of
+      each field of the records is recorded. Then the query only reads the id and the
+      accessed fields as only() , the others are deferred. If a deferred field is loaded
+      later , it is read again by the next execution.
+
+      The profile is kept per statement , so a query built on every call of the same
+      code learns from the previous calls.
+
+\code
+    // The list only shows the names. After 10 calls , the other fields are not read.
+    DQList<User> list = DQQuery<User>().autoOnly().all();
+\endcode
+
+      @remarks It is ignored if the fields are selected explicitly by select() / only() , or selectRelated() is used.
+     */
+    DQSharedQuery autoOnly(int samples = 10) DQ_QUERY_LVALUE;
+
+#ifdef DQ_QUERY_REF_QUALIFIERS
+    /// The builder functions of a temporary query. The rules are changed in place and the query is moved to the result.
+    DQSharedQuery select(QStringList fields) &&;
+    DQSharedQuery select(QString field) &&;
+    DQSharedQuery filter(DQWhere where) &&;
+    DQSharedQuery bind(int index,QVariant value) &&;
+    DQSharedQuery limit(int val) &&;
+    DQSharedQuery offset(int val) &&;
+    DQSharedQuery orderBy(QStringList terms) &&;
+    DQSharedQuery orderBy(QString term) &&;
+    DQSharedQuery groupBy(QStringList fields) &&;
+    DQSharedQuery groupBy(QString field) &&;
+    DQSharedQuery having(DQWhere where) &&;
+    DQSharedQuery prefetch(QStringList fields) &&;
+    DQSharedQuery prefetch(QString field) &&;
+    DQSharedQuery selectRelated(QStringList fields) &&;
+    DQSharedQuery selectRelated(QString field) &&;
+    DQSharedQuery defer(QStringList fields) &&;
+    DQSharedQuery defer(QString field) &&;
+    DQSharedQuery only(QStringList fields) &&;
+    DQSharedQuery only(QString field) &&;
+    DQSharedQuery autoOnly(int samples = 10) &&;
+#endif
 
     /// Execute the query
     bool exec();
@@ -109,7 +423,13 @@ public:
     /// Retrieves the first field of the current record. It is useful for query like count() / max() , ... that will only have a single field result
     QVariant value();
 
+    /// Retrieves the field at index of the current record
+    QVariant value(int index);
+
     /// Execute the query and count no. of record retrieved
+    /**
+      @remarks all() , count() and call() may be served by the result cache. See DQSql::setResultCacheEnabled()
+     */
     int count();
 
     /// Execute the query and call specific function on the result
@@ -132,20 +452,301 @@ public:
      */
     bool remove();
 
+    /// Update all the records fullfill the filter rules by a single statement
+    /**
+      @param assignments A map of field name to the new value. The value could be a DQWhere expression of other fields.
+      @return No. of records updated. -1 if the operation is failed.
+
+      Example:
+\code
+    DQQuery<User> query;
+    QVariantMap assignments;
+    assignments["karma"] = DQWhere("karma") + 1;
+    assignments["lastLoginTime"] = QDateTime::currentDateTime();
+    query.filter(DQWhere("karma") < 100).update(assignments);
+\endcode
+
+      @remarks The limit() and orderBy() rules are not applied
+     */
+    int update(QVariantMap assignments);
+
     /// Execute the query and return all the record retrieved
     DQSharedList all();
 
+    /// Run all() on the worker thread of the connection
+    /**
+      Each connection has a dedicated worker thread which is started on the first
+      asynchronous call. It owns a clone of the database (QSqlDatabase::cloneDatabase()),
+      so the database latency do not block the calling thread. The queries are run one
+      by one in the order of submission.
+
+      Example:
+\code
+    QFuture<DQSharedList> future = DQQuery<User>().filter(DQWhere("karma") > 100).allAsync();
+    // ...
+    DQList<User> list = future.result();
+\endcode
+
+      Use QFutureWatcher to be notified by signal.
+
+      @remarks The worker only sees the committed data. It is not usable for in-memory database (":memory:") as the clone is a new database.
+      @remarks The future is canceled if the connection is closed before the query is run.
+     */
+    QFuture<DQSharedList> allAsync();
+
+    /// Run count() on the worker thread of the connection
+    /**
+      @see allAsync()
+     */
+    QFuture<int> countAsync();
+
+    /// Run call() on the worker thread of the connection
+    /**
+      @see allAsync()
+     */
+    QFuture<QVariant> callAsync(QString func , QStringList fields = QStringList());
+
+    /// Run a function on every record by several threads
+    /**
+      The id range of the result (min(id) to max(id) with the filter applied) is split
+      into small ranges. Each thread takes the next unprocessed range once it finishes
+      the current one , so a range crowded with records does not hold up the others.
+      Every range is read by a forward-only query on the connection of the thread, which is
+      the clone provided by DQConnectionPool (The default pool is used if it is installed
+      over the connection of the query). The calling thread takes part in the scan with
+      the connection of the query.
+
+      The function is called with a model reference (DQAbstractModel& , or T& for DQQuery<T>)
+      per record. The model is reused for the next record of the same thread, copy it
+      if it is needed after the call.
+
+\code
+    QAtomicInt total;
+    DQQuery<HealthCheck>().filter(DQWhere("height") > 150).parallelForEach(4,SumWeight(&total));
+\endcode
+
+      @param nThreads No. of threads including the calling thread
+      @param fn A function / functor object. It must be thread-safe.
+      @return TRUE if all the records are processed
+      @remarks The records are not visited in any order , orderBy() is ignored. limit() and offset() are not supported.
+      @remarks The journal mode should be WAL , otherwise the connections of threads are blocked by each other. In-memory database is scanned by the calling thread only.
+     */
+    template <typename Function>
+    bool parallelForEach(int nThreads , Function fn) {
+        _DQForEachFunctionImpl<DQAbstractModel,Function> function(fn);
+        return parallelScan(nThreads,&function);
+    }
+
+    /// Execute the query and return the records in column-oriented form
+    /**
+      No model is created. The values are read into a contiguous array per
+      column, which is suitable for aggregation over a large result.
+
+      @param fields The fields to be read. If it is empty , the fields set by select() (or all the fields) are read.
+      @see DQColumnarResult
+      @remarks It is not served by the result cache
+     */
+    DQColumnarResult columns(QStringList fields = QStringList());
+
+    /// Execute the query and compute the aggregate functions per group
+    /**
+      The result columns are the groupBy() fields followed by the aggregates. The
+      type of "count" is Integer , "avg" / "total" is Real , and others follow the type
+      of their field.
+
+      @see groupBy()
+      @remarks It is not served by the result cache
+     */
+    DQColumnarResult aggregate(QList<DQAggregate> aggregates);
+
+    /// Execute the query and return the values of a field without creating models
+    /**
+      The values are read by QSqlQuery::value() and converted to the template type
+      directly. No model is created or hydrated.
+
+\code
+    DQQuery<User> query;
+    QVector<QString> names = query.filter(DQWhere("karma") > 10).valuesList<QString>("name");
+\endcode
+
+      @remarks It is not served by the result cache
+     */
+    template <typename A>
+    QVector<A> valuesList(QString a) {
+        QVector<A> res;
+        DQSharedQuery query = select(a);
+        if (!query.exec())
+            return res;
+
+        while (query.next()) {
+            res << query.value(0).value<A>();
+        }
+        query.finish();
+        return res;
+    }
+
+    /// Execute the query and return the values of two fields as pairs without creating models
+    /**
+\code
+    QVector<QPair<int,QString> > list = query.valuesList<int,QString>("id","name");
+\endcode
+     */
+    template <typename A,typename B>
+    QVector<QPair<A,B> > valuesList(QString a,QString b) {
+        QVector<QPair<A,B> > res;
+        DQSharedQuery query = select(QStringList() << a << b);
+        if (!query.exec())
+            return res;
+
+        while (query.next()) {
+            res << qMakePair(query.value(0).value<A>(),query.value(1).value<B>());
+        }
+        query.finish();
+        return res;
+    }
+
+    /// Execute the query and write the values of fields to the members of a plain struct
+    /**
+      Each field is followed by the pointer to the member which should hold the value:
+
+\code
+    struct Row {
+        int id;
+        QString name;
+    };
+
+    QVector<Row> rows = query.valuesList("id",&Row::id,"name",&Row::name);
+\endcode
+
+      The struct must be default constructible. No model is created.
+     */
+    template <typename T,typename A>
+    QVector<T> valuesList(QString a,A T::*ma) {
+        QVector<T> res;
+        DQSharedQuery query = select(a);
+        if (!query.exec())
+            return res;
+
+        T t;
+        while (query.next()) {
+            t.*ma = query.value(0).value<A>();
+            res << t;
+        }
+        query.finish();
+        return res;
+    }
+
+    /// Execute the query and write the values of two fields to the members of a plain struct
+    template <typename T,typename A,typename B>
+    QVector<T> valuesList(QString a,A T::*ma,QString b,B T::*mb) {
+        QVector<T> res;
+        DQSharedQuery query = select(QStringList() << a << b);
+        if (!query.exec())
+            return res;
+
+        T t;
+        while (query.next()) {
+            t.*ma = query.value(0).value<A>();
+            t.*mb = query.value(1).value<B>();
+            res << t;
+        }
+        query.finish();
+        return res;
+    }
+
+    /// Execute the query and write the values of three fields to the members of a plain struct
+    template <typename T,typename A,typename B,typename C>
+    QVector<T> valuesList(QString a,A T::*ma,QString b,B T::*mb,QString c,C T::*mc) {
+        QVector<T> res;
+        DQSharedQuery query = select(QStringList() << a << b << c);
+        if (!query.exec())
+            return res;
+
+        T t;
+        while (query.next()) {
+            t.*ma = query.value(0).value<A>();
+            t.*mb = query.value(1).value<B>();
+            t.*mc = query.value(2).value<C>();
+            res << t;
+        }
+        query.finish();
+        return res;
+    }
+
+    /// Execute the query and write the values of four fields to the members of a plain struct
+    template <typename T,typename A,typename B,typename C,typename D>
+    QVector<T> valuesList(QString a,A T::*ma,QString b,B T::*mb,QString c,C T::*mc,QString d,D T::*md) {
+        QVector<T> res;
+        DQSharedQuery query = select(QStringList() << a << b << c << d);
+        if (!query.exec())
+            return res;
+
+        T t;
+        while (query.next()) {
+            t.*ma = query.value(0).value<A>();
+            t.*mb = query.value(1).value<B>();
+            t.*mc = query.value(2).value<C>();
+            t.*md = query.value(3).value<D>();
+            res << t;
+        }
+        query.finish();
+        return res;
+    }
+
+    /// Get the query plan of the SELECT statement of all()
+    /**
+      It runs "EXPLAIN QUERY PLAN" over the generated statement with the same bound values.
+      The query itself is not executed.
+
+      @return The plan. It is empty if it is failed.
+      @see DQIndexAdvisor
+     */
+    DQQueryPlan explain();
+
     /// Returns the QSqlQuery object being used
+    /**
+      @remarks The query is forward-only. It is empty after remove() / update() run by the
+      writer thread of DQConnection::setReadWriteSplitEnabled() , use lastError() instead.
+      It is also empty after all() / count() / call() served by the result cache , as no statement is run.
+     */
     QSqlQuery lastQuery();
 
+    /// The error of last operation
+    /**
+      It is the error of lastQuery() , or the error reported by the writer thread if
+      the last remove() / update() is run by it. It is invalid after a result cache hit.
+     */
+    QSqlError lastError();
+
+    /// Release the result of the executed query
+    /**
+      It should be called if you stop reading the record by next() before the end of result.
+      It is done automatically by all() , count() , call() ... functions.
+     */
+    void finish();
+
     /// Reset the query to initial status , but keep the connection and associated object unchanged.
     void reset();
 
 protected:
+    /// Run a _DQForEachFunction on every record by several threads
+    /**
+      @see parallelForEach()
+     */
+    bool parallelScan(int nThreads , _DQForEachFunction *function);
 
     /// Set the associated data model
     void setMetaInfo(DQModelMetaInfo *info);
 
+    /// Construct a new query object for the page after a record (keyset pagination)
+    /**
+      @param lastRow The last record of previous page. If it is null, it returns the first page.
+      @param term The ordering term (e.g "height" , "height desc")
+
+      @see DQQuery::after()
+     */
+    DQSharedQuery after(const DQAbstractModel *lastRow,QString term);
+
     /* The design of DQSharedQuery do not allow user to pass DQModel to any argument.
        Prevent invalid pointer type passed
      */
@@ -162,9 +763,58 @@ protected:
 
 
 private:
+    /// Execute a generated SQL statement
+    bool exec(const QString& sql);
+
+    /// The SELECT statement of the query. It is generated once until the rules are changed.
+    QString statement();
+
+    /// Bind the values of WHERE and HAVING clause
+    void bindValues(QSqlQuery &query);
+
+    /// A detached copy of the query for the async worker of connection
+    DQSharedQuery asyncCopy(DQConnection connection);
+
+    /// Execute the query by the result cache
+    /**
+      @param rows The retrieved records
+      @return TRUE if the records are read from the cache or database
+     */
+    bool execCached(QList<QVariantList> *rows);
+
+    /// Map the result columns to the fields of model
+    void resolveColumnMapping(const QStringList& columns);
+
+    /// Save the current record , or the "row" if it is not null, to a model
+    bool hydrate(DQAbstractModel *model,const QVariantList *row);
+
+    /// Load the "linked" models of the prefetch foreign keys
+    void prefetchRelated(DQSharedList list);
+
+    /// Count the execution in the profile of autoOnly() and apply the learned fields
+    void applyFieldProfile();
+
+#ifdef DQ_QUERY_REF_QUALIFIERS
+    /// Move the query changed in place by a builder function to the result
+    DQSharedQuery moveChanged();
+#endif
+
     QSharedDataPointer<DQSharedQueryPriv> data;
 
+    /// The result of execution
+    /**
+      It is not a part of the shared data , so iterating the result never detaches the rules.
+      A copy of the query shares the result until either of them is executed again.
+     */
+    QSqlQuery m_query;
+
+    /// The error of the operation run by the writer thread. It is invalid if m_query is run by this thread
+    QSqlError m_lastError;
+
     friend class DQQueryRules;
+    friend class DQWhere;
+    friend class _DQParallelScan;
+    friend class DQIndexAdvisor;
 };
 
 #endif // DQSHAREDQUERY_H
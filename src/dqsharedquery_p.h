@@ -2,12 +2,38 @@
 #define DQABSTRACTQUERY_P_H
 
 #include <QSqlQuery>
+#include <QVector>
 #include "dqconnection.h"
 #include "dqmodel.h"
 #include "dqmodelmetainfo.h"
 #include "dqwhere.h"
 #include "dqexpression.h"
 
+class _DQFieldProfile;
+
+/// The generated SQL statement of a query
+/**
+  It is not copied with DQSharedQueryPriv. As every rule changing function
+  of DQSharedQuery works on a detached copy (or clears it when a temporary
+  query is changed in place) , the statement is generated again after any
+  change of rules, while repeated execution (or bind() of new values) reuses it.
+ */
+class _DQStatementText {
+public:
+    inline _DQStatementText() {
+    }
+
+    inline _DQStatementText(const _DQStatementText&) {
+    }
+
+    inline _DQStatementText& operator=(const _DQStatementText&) {
+        text.clear();
+        return *this;
+    }
+
+    QString text;
+};
+
 /// DQSharedQuery private data
 
 class DQSharedQueryPriv : public QSharedData {
@@ -15,6 +41,10 @@ public:
     inline DQSharedQueryPriv() {
         metaInfo = 0;
         limit = -1; // No limit
+        offset = 0;
+        autoOnlySamples = 0;
+        profile = 0;
+        sampling = false;
     }
 
     DQConnection connection;
@@ -25,7 +55,11 @@ public:
     DQModelMetaInfo *metaInfo;
     int limit;
 
-    QSqlQuery query;
+    /// No. of records to be skipped
+    int offset;
+
+    /// The filter. It is kept for combining with other rules
+    DQWhere where;
 
     DQExpression expression;
 
@@ -33,6 +67,83 @@ public:
     QStringList fields;
 
     QStringList orderBy;
+
+    /// The foreign keys to be prefetched by all()
+    QStringList prefetch;
+
+    /// The foreign keys to be loaded by JOIN
+    QStringList related;
+
+    /// defer(fields)
+    QStringList deferred;
+
+    /// only(fields)
+    QStringList only;
+
+    /// No. of sampled executions of autoOnly(). 0 if it is disabled
+    int autoOnlySamples;
+
+    /// The field profile of autoOnly(). It is resolved on first execution
+    _DQFieldProfile *profile;
+
+    /// TRUE if the current execution is sampled by the profile
+    bool sampling;
+
+    /// The fields learned by the profile
+    QStringList learned;
+
+    /// The fields of GROUP BY
+    QStringList groupBy;
+
+    /// The HAVING clause. The bind names are prefixed by "having"
+    DQExpression having;
+
+    /// The filter of having(). It is kept for rebuilding the clause for other connection
+    DQWhere havingWhere;
+
+    /// The model index of each result column. -1 for the query model, otherwise it is the index in "related"
+    QVector<int> relatedMapping;
+
+    /// The field index of the foreign key in "related"
+    QVector<int> relatedKeyIndex;
+
+    /// The meta info of the linked model in "related"
+    QVector<DQModelMetaInfo*> relatedMetaInfo;
+
+    /// The field index of each result column. It is resolved once per exec()
+    QVector<int> columnMapping;
+
+    /// The index of fields to be marked as deferred on hydration. It is resolved with columnMapping
+    QVector<int> deferredMapping;
+
+    /// The index of fields to be marked as sampled on hydration
+    QVector<int> sampledMapping;
+
+    /// The generated SELECT statement
+    _DQStatementText sql;
+
+    /// The fields left out from the result. It is empty if the fields are selected explicitly
+    inline QStringList deferredFields() const {
+        QStringList res;
+        if (!metaInfo || !fields.isEmpty() || !func.isEmpty())
+            return res;
+
+        // The explicit only() take precedence over the learned fields
+        const QStringList &kept = only.isEmpty() ? learned : only;
+
+        int n = metaInfo->size();
+        for (int i = 0 ; i < n;i++) {
+            const DQModelMetaInfoField *field = metaInfo->at(i);
+            if (field->name == "id")
+                continue;
+
+            DQClause clause = field->clause;
+            if (deferred.contains(field->name) || clause.testFlag(DQClause::DEFERRED) ||
+                (!kept.isEmpty() && !kept.contains(field->name)))
+                res << field->name;
+        }
+        return res;
+    }
 };
 
 #endif // DQABSTRACTQUERY_P_H
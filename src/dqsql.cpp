@@ -1,26 +1,180 @@
 #include <QtCore>
 #include <QSqlError>
+#include <QSqlRecord>
 #include <QSharedDataPointer>
+#include <QThread>
 #include "dqmodel.h"
 #include "dqsql.h"
-#include "dqsqlitestatement.h"
+#include "dqsharedlist.h"
+#include "dqsqlstatement.h"
+
+/// Default no. of prepared statement cached per connection
+#define DQ_STATEMENT_CACHE_CAPACITY 32
+
+/// Default memory limit of result cache in bytes
+#define DQ_RESULT_CACHE_SIZE (4 * 1024 * 1024)
+
+/// A result stored in the result cache
+class _DQCachedResult {
+public:
+    QStringList columns;
+    QList<QVariantList> rows;
+
+    /// The version of dependent tables when the result is read
+    QHash<QString,int> versions;
+
+    /// Expiry time in msecs since the cache is created. Zero if it never expires
+    qint64 expiry;
+};
+
+/// Default no. of model stored in the identity map
+#define DQ_IDENTITY_MAP_CAPACITY 1000
+
+/// A model stored in the identity map
+class _DQIdentityEntry {
+public:
+    inline _DQIdentityEntry() : model(0) , version(0) {
+    }
+
+    inline ~_DQIdentityEntry() {
+        delete model;
+    }
+
+    DQAbstractModel *model;
+
+    /// The version of the table when the model is stored
+    int version;
+};
+
+/// Copy the fields from a model to another model of the same type
+static void _dqCopyFields(DQModelMetaInfo* info,const DQAbstractModel *from,DQAbstractModel *to) {
+    int n = info->size();
+    for (int i = 0 ; i < n;i++) {
+        // A deferred field is copied as deferred , it is not loaded by the copy
+        if (info->field(const_cast<DQAbstractModel*>(from),i)->isDeferred())
+            info->field(to,i)->setDeferred(to);
+        else
+            info->setValue(to,i,info->value(from,i));
+    }
+    info->setDirty(to,false);
+}
+
+/// The key of identity map
+static inline QString _dqIdentityKey(DQModelMetaInfo* info,const QVariant& id) {
+    return info->name() + ":" + id.toString();
+}
+
+/// Approximate memory usage of a value
+static int _dqValueCost(const QVariant &value) {
+    int res = sizeof(QVariant);
+    switch (value.type()) {
+    case QVariant::String:
+        res += value.toString().size() * 2;
+        break;
+    case QVariant::ByteArray:
+        res += value.toByteArray().size();
+        break;
+    default:
+        break;
+    }
+    return res;
+}
 
 class DQSqlPriv : public QSharedData {
 public:
     DQSqlPriv()  {
-    }
+        m_statementCache.setMaxCost(DQ_STATEMENT_CACHE_CAPACITY);
+        m_statementCacheHits = 0;
+        m_statementCacheMisses = 0;
+        m_transactionDepth = 0;
+        m_lastQueryEnabled = true;
+
+        m_resultCacheEnabled = false;
+        m_resultCache.setMaxCost(DQ_RESULT_CACHE_SIZE);
+        m_resultCacheTtl = 0;
+        m_resultCacheHits = 0;
+        m_resultCacheGeneration = 0;
+        m_resultCacheClock.start();
 
-    ~DQSqlPriv(){
+        m_identityMapEnabled = false;
+        m_identityMap.setMaxCost(DQ_IDENTITY_MAP_CAPACITY);
+        m_identityMapHits = 0;
+
+        m_schemaLoaded = false;
     }
 
     QSharedPointer<DQSqlStatement> m_statement;
 
     QSqlDatabase m_db;
 
-    /// The query object used in last operation
-    QSharedPointer<QSqlQuery> m_lastQuery;
+    /// Guard of m_lastQuery
+    QMutex m_lastQueryMutex;
+
+    /// The query object used in last operation of each thread
+    /**
+      They are released all together by setDatabase() , so the old database is not
+      referred by the threads which are still running.
+     */
+    QHash<QThread*,QSqlQuery> m_lastQuery;
 
+    /// TRUE if the last query should be recorded
+    bool m_lastQueryEnabled;
+
+    /// Guard of the statement cache
     QMutex m_mutex;
+
+    /// Prepared statement cache. The key is the SQL text
+    QCache<QString,QSqlQuery> m_statementCache;
+
+    /// The SQL of last cached statement. It holds the shared data of the interned statement
+    QString m_lastStatementSql;
+
+    /// The last cached statement
+    QSqlQuery m_lastStatement;
+
+    int m_statementCacheHits;
+
+    int m_statementCacheMisses;
+
+    /// The nesting level of transaction
+    int m_transactionDepth;
+
+    bool m_resultCacheEnabled;
+
+    /// Query result cache. The key is the SQL and bind values. Guarded by m_mutex
+    QCache<QString,_DQCachedResult> m_resultCache;
+
+    /// Time to live of cached result in msecs
+    int m_resultCacheTtl;
+
+    int m_resultCacheHits;
+
+    /// Increased on every table changes
+    quint64 m_resultCacheGeneration;
+
+    /// The table version. It is increased on every change of the table
+    QHash<QString,int> m_tableVersions;
+
+    /// No. of rows written per table. Guarded by m_mutex
+    QHash<QString,qint64> m_writeCounts;
+
+    QElapsedTimer m_resultCacheClock;
+
+    bool m_identityMapEnabled;
+
+    /// The identity map. The key is the table name and id. Guarded by m_mutex
+    QCache<QString,_DQIdentityEntry> m_identityMap;
+
+    int m_identityMapHits;
+
+    /// TRUE if the schema catalog is read. Guarded by m_mutex
+    bool m_schemaLoaded;
+
+    /// The tables in database and their columns. The column list is empty until it is read
+    QHash<QString,QStringList> m_schemaTables;
+
+    /// The indexes in database and their table
+    QHash<QString,QString> m_schemaIndexes;
 };
 
 /* DQSql */
@@ -55,7 +209,15 @@ DQSqlStatement* DQSql::statement() {
 }
 
 void DQSql::setDatabase(QSqlDatabase db){
+    clearStatementCache();
+    clearResultCache();
+    // They refer to the old database
+    d->m_lastQueryMutex.lock();
+    d->m_lastQuery.clear();
+    d->m_lastQueryMutex.unlock();
     d->m_db = db;
+    d->m_transactionDepth = 0;
+    clearSchemaCache();
 }
 
 QSqlDatabase DQSql::database(){
@@ -71,6 +233,12 @@ bool DQSql::createTableIfNotExists(DQModelMetaInfo* info){
     bool ret = q.exec(sql);
     setLastQuery(q);
 
+    if (ret && d->m_statement->boundSchema(info).isEmpty()) {
+        QMutexLocker locker(&d->m_mutex);
+        if (d->m_schemaLoaded)
+            d->m_schemaTables.insert(info->name(),QStringList());
+    }
+
     return ret;
 }
 
@@ -79,24 +247,396 @@ QSqlQuery DQSql::query(){
 }
 
 QSqlQuery DQSql::lastQuery(){
-    return QSqlQuery(*d->m_lastQuery);
+    QMutexLocker locker(&d->m_lastQueryMutex);
+    return d->m_lastQuery.value(QThread::currentThread());
 }
 
 void DQSql::setLastQuery(QSqlQuery value)
 {
-    d->m_mutex.lock();
-    if (d->m_lastQuery == 0) {
-        d->m_lastQuery = QSharedPointer<QSqlQuery>(new QSqlQuery(query()));
-    }
+    if (!d->m_lastQueryEnabled)
+        return;
 
     if (value.isActive())
         value.finish();
 
-    *d->m_lastQuery = value;
-    d->m_mutex.unlock();
+    QMutexLocker locker(&d->m_lastQueryMutex);
+    d->m_lastQuery[QThread::currentThread()] = value;
+}
+
+void DQSql::setLastQueryEnabled(bool enabled){
+    d->m_lastQueryEnabled = enabled;
+    if (!enabled) {
+        QMutexLocker locker(&d->m_lastQueryMutex);
+        d->m_lastQuery.clear();
+    }
+}
+
+bool DQSql::isLastQueryEnabled(){
+    return d->m_lastQueryEnabled;
+}
+
+QSqlQuery DQSql::prepare(const QString &sql){
+    QMutexLocker locker(&d->m_mutex);
+
+    /* The statements generated by _DQSqlBuilder are interned. The same
+       statement shares the data , it is matched by the pointer without
+       hashing and comparing the SQL text.
+     */
+    if (!sql.isEmpty() && sql.constData() == d->m_lastStatementSql.constData() &&
+        sql.size() == d->m_lastStatementSql.size() && !d->m_lastStatement.isActive()) {
+        d->m_statementCacheHits++;
+        return d->m_lastStatement;
+    }
+
+    QSqlQuery* cached = d->m_statementCache.object(sql);
+
+    if (cached && !cached->isActive()) {
+        d->m_statementCacheHits++;
+        d->m_lastStatementSql = sql;
+        d->m_lastStatement = *cached;
+        return *cached;
+    }
+
+    d->m_statementCacheMisses++;
+
+    QSqlQuery q = query();
+    q.setForwardOnly(true);
+    if (!q.prepare(sql)) {
+        return q;
+    }
+
+    /* The active one is in use by another query. Don't replace it,
+       otherwise it will be released from cache while it is still
+       running.
+     */
+    if (!cached && d->m_statementCache.maxCost() > 0) {
+        d->m_statementCache.insert(sql,new QSqlQuery(q));
+        d->m_lastStatementSql = sql;
+        d->m_lastStatement = q;
+    }
+
+    return q;
+}
+
+void DQSql::setStatementCacheCapacity(int capacity){
+    QMutexLocker locker(&d->m_mutex);
+    d->m_statementCache.setMaxCost(qMax(capacity,0));
+    if (capacity <= 0) {
+        d->m_lastStatementSql = QString();
+        d->m_lastStatement = QSqlQuery();
+    }
+}
+
+int DQSql::statementCacheCapacity(){
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_statementCache.maxCost();
+}
+
+int DQSql::statementCacheHits(){
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_statementCacheHits;
+}
+
+int DQSql::statementCacheMisses(){
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_statementCacheMisses;
+}
+
+void DQSql::clearStatementCache(){
+    QMutexLocker locker(&d->m_mutex);
+    d->m_statementCache.clear();
+    d->m_lastStatementSql = QString();
+    d->m_lastStatement = QSqlQuery();
+    d->m_statementCacheHits = 0;
+    d->m_statementCacheMisses = 0;
+}
+
+void DQSql::setResultCacheEnabled(bool enabled){
+    QMutexLocker locker(&d->m_mutex);
+    d->m_resultCacheEnabled = enabled;
+    if (!enabled)
+        d->m_resultCache.clear();
+}
+
+bool DQSql::isResultCacheEnabled(){
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_resultCacheEnabled;
+}
+
+void DQSql::setResultCacheTtl(int msecs){
+    QMutexLocker locker(&d->m_mutex);
+    d->m_resultCacheTtl = qMax(msecs,0);
+}
+
+int DQSql::resultCacheTtl(){
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_resultCacheTtl;
+}
+
+void DQSql::setResultCacheMaxSize(int bytes){
+    QMutexLocker locker(&d->m_mutex);
+    d->m_resultCache.setMaxCost(qMax(bytes,0));
+}
+
+int DQSql::resultCacheMaxSize(){
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_resultCache.maxCost();
+}
+
+int DQSql::resultCacheHits(){
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_resultCacheHits;
+}
+
+void DQSql::clearResultCache(){
+    QMutexLocker locker(&d->m_mutex);
+    d->m_resultCache.clear();
+    d->m_resultCacheHits = 0;
+    d->m_resultCacheGeneration++;
+}
+
+void DQSql::notifyTableChanged(QString table,int rows){
+    QMutexLocker locker(&d->m_mutex);
+    d->m_tableVersions[table]++;
+    d->m_writeCounts[table] += rows;
+    d->m_resultCacheGeneration++;
+}
+
+QHash<QString,qint64> DQSql::writeCounts(){
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_writeCounts;
+}
+
+quint64 DQSql::resultCacheGeneration(){
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_resultCacheGeneration;
+}
+
+bool DQSql::cachedResult(const QString &key,QStringList *columns,QList<QVariantList> *rows){
+    QMutexLocker locker(&d->m_mutex);
+    if (!d->m_resultCacheEnabled)
+        return false;
+
+    _DQCachedResult *result = d->m_resultCache.object(key);
+    if (!result)
+        return false;
+
+    bool valid = result->expiry == 0 || d->m_resultCacheClock.elapsed() < result->expiry;
+
+    QHashIterator<QString,int> iter(result->versions);
+    while (valid && iter.hasNext()) {
+        iter.next();
+        valid = d->m_tableVersions.value(iter.key(),0) == iter.value();
+    }
+
+    if (!valid) {
+        d->m_resultCache.remove(key);
+        return false;
+    }
+
+    d->m_resultCacheHits++;
+    *columns = result->columns;
+    *rows = result->rows;
+    return true;
+}
+
+void DQSql::storeResult(const QString &key,QStringList tables,QStringList columns,QList<QVariantList> rows,quint64 generation){
+    QMutexLocker locker(&d->m_mutex);
+
+    // A table may be changed during the query
+    if (!d->m_resultCacheEnabled || generation != d->m_resultCacheGeneration)
+        return;
+
+    int cost = key.size() * 2;
+    foreach (QVariantList row , rows) {
+        foreach (QVariant value , row) {
+            cost += _dqValueCost(value);
+        }
+    }
+
+    if (cost > d->m_resultCache.maxCost())
+        return;
+
+    _DQCachedResult *result = new _DQCachedResult();
+    result->columns = columns;
+    result->rows = rows;
+    result->expiry = 0;
+    if (d->m_resultCacheTtl > 0)
+        result->expiry = d->m_resultCacheClock.elapsed() + d->m_resultCacheTtl;
+
+    foreach (QString table , tables) {
+        result->versions[table] = d->m_tableVersions.value(table,0);
+    }
+
+    d->m_resultCache.insert(key,result,cost);
+}
+
+bool DQSql::exec(QString sql){
+    QSqlQuery q = query();
+    bool res = q.exec(sql);
+
+    setLastQuery(q);
+
+    return res;
+}
+
+QString DQSql::savepointName(int depth){
+    return QString("dq_savepoint_%1").arg(depth);
+}
+
+bool DQSql::transaction(){
+    bool res;
+    if (d->m_transactionDepth == 0) {
+        res = d->m_db.transaction();
+    } else {
+        res = exec(d->m_statement->savepoint(savepointName(d->m_transactionDepth)));
+    }
+
+    if (res)
+        d->m_transactionDepth++;
+
+    return res;
+}
+
+bool DQSql::commit(){
+    if (d->m_transactionDepth == 0) {
+        qWarning() << "DQSql::commit() - No transaction is started";
+        return false;
+    }
+
+    int depth = d->m_transactionDepth - 1;
+    bool res;
+    if (depth == 0) {
+        res = d->m_db.commit();
+    } else {
+        res = exec(d->m_statement->releaseSavepoint(savepointName(depth)));
+    }
+
+    // Failed to commit , the transaction is still opened.
+    if (res)
+        d->m_transactionDepth = depth;
+
+    return res;
+}
+
+bool DQSql::rollback(){
+    if (d->m_transactionDepth == 0) {
+        qWarning() << "DQSql::rollback() - No transaction is started";
+        return false;
+    }
+
+    int depth = d->m_transactionDepth - 1;
+    bool res;
+    if (depth == 0) {
+        res = d->m_db.rollback();
+    } else {
+        QString name = savepointName(depth);
+        res = exec(d->m_statement->rollbackToSavepoint(name)) &&
+              exec(d->m_statement->releaseSavepoint(name));
+    }
+
+    d->m_transactionDepth = depth;
+
+    // The cached results may contain the discarded changes
+    {
+        QMutexLocker locker(&d->m_mutex);
+        d->m_resultCache.clear();
+        d->m_resultCacheGeneration++;
+        d->m_identityMap.clear();
+    }
+
+    return res;
+}
+
+void DQSql::setIdentityMapEnabled(bool enabled){
+    QMutexLocker locker(&d->m_mutex);
+    d->m_identityMapEnabled = enabled;
+    if (!enabled)
+        d->m_identityMap.clear();
+}
+
+bool DQSql::isIdentityMapEnabled(){
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_identityMapEnabled;
+}
+
+void DQSql::setIdentityMapCapacity(int capacity){
+    QMutexLocker locker(&d->m_mutex);
+    d->m_identityMap.setMaxCost(qMax(capacity,0));
+}
+
+int DQSql::identityMapCapacity(){
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_identityMap.maxCost();
+}
+
+int DQSql::identityMapHits(){
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_identityMapHits;
+}
+
+void DQSql::clearIdentityMap(){
+    QMutexLocker locker(&d->m_mutex);
+    d->m_identityMap.clear();
+    d->m_identityMapHits = 0;
+}
+
+bool DQSql::lookupIdentity(DQModelMetaInfo* info,QVariant id,DQAbstractModel* model){
+    QMutexLocker locker(&d->m_mutex);
+    if (!d->m_identityMapEnabled || id.isNull())
+        return false;
+
+    QString key = _dqIdentityKey(info,id);
+    _DQIdentityEntry *entry = d->m_identityMap.object(key);
+    if (!entry)
+        return false;
+
+    if (entry->version != d->m_tableVersions.value(info->name(),0)) {
+        d->m_identityMap.remove(key);
+        return false;
+    }
+
+    d->m_identityMapHits++;
+    _dqCopyFields(info,entry->model,model);
+    return true;
+}
+
+void DQSql::storeIdentity(DQModelMetaInfo* info,const DQAbstractModel* model,quint64 generation){
+    QMutexLocker locker(&d->m_mutex);
+    QVariant id = info->value(model,"id");
+    if (!d->m_identityMapEnabled || id.isNull() || generation != d->m_resultCacheGeneration)
+        return;
+
+    _DQIdentityEntry *entry = new _DQIdentityEntry();
+    entry->model = info->create();
+    entry->version = d->m_tableVersions.value(info->name(),0);
+    _dqCopyFields(info,model,entry->model);
+
+    d->m_identityMap.insert(_dqIdentityKey(info,id),entry);
+}
+
+int DQSql::transactionDepth(){
+    return d->m_transactionDepth;
 }
 
 bool DQSql::dropTable(DQModelMetaInfo* info){
+    if (!info->fullTextNameList().isEmpty()) {
+        QString fts = DQSqlStatement::fullTextTable(info->name());
+        if (tables().contains(fts)) {
+            if (!exec(d->m_statement->dropFullTextIndex(info)))
+                return false;
+
+            // The shadow tables (e.g "_data") are dropped with the index
+            QMutexLocker locker(&d->m_mutex);
+            QMutableHashIterator<QString,QStringList> iter(d->m_schemaTables);
+            while (iter.hasNext()) {
+                iter.next();
+                if (iter.key() == fts || iter.key().startsWith(fts + "_"))
+                    iter.remove();
+            }
+        }
+    }
+
     QString sql = d->m_statement->dropTable(info);
 
     QSqlQuery q = query();
@@ -105,6 +645,23 @@ bool DQSql::dropTable(DQModelMetaInfo* info){
 
     setLastQuery(q);
 
+    if (res) {
+        notifyTableChanged(info->name());
+    }
+
+    if (res && d->m_statement->boundSchema(info).isEmpty()) {
+        QMutexLocker locker(&d->m_mutex);
+        d->m_schemaTables.remove(info->name());
+
+        // The indexes are dropped with the table
+        QMutableHashIterator<QString,QString> iter(d->m_schemaIndexes);
+        while (iter.hasNext()) {
+            iter.next();
+            if (iter.value() == info->name())
+                iter.remove();
+        }
+    }
+
     return res;
 
 //    QString sql = d->m_statement->dropTable(info);
@@ -114,6 +671,159 @@ bool DQSql::dropTable(DQModelMetaInfo* info){
 //    return d->m_lastQuery->exec(sql);
 }
 
+bool DQSql::addColumn(DQModelMetaInfo* info,QString field){
+    int index = info->indexOf(field);
+    if (index < 0) {
+        qWarning() << QString("DQSql::addColumn() - %1 is not a field of %2").arg(field).arg(info->name());
+        return false;
+    }
+
+    bool res = exec(d->m_statement->addColumn(info,index));
+
+    if (res) {
+        QMutexLocker locker(&d->m_mutex);
+        if (d->m_schemaTables.contains(info->name()))
+            d->m_schemaTables.insert(info->name(),QStringList()); // Read again on demand
+    }
+
+    return res;
+}
+
+bool DQSql::rebuildTable(DQModelMetaInfo* info,int batchSize){
+    if (d->m_db.driverName() != "QSQLITE") {
+        qWarning() << "DQSql::rebuildTable() - Only the QSQLITE driver is supported";
+        return false;
+    }
+
+    QString name = info->name();
+    QString target = name + "_dqrebuild";
+
+    QStringList existing = columns(name);
+    if (existing.isEmpty()) {
+        qWarning() << QString("DQSql::rebuildTable() - %1 is not existed").arg(name);
+        return false;
+    }
+
+    // The generated columns are computed by the new table
+    QStringList common;
+    foreach (QString column , info->writableFields(info->columnNameList())) {
+        if (existing.contains(column))
+            common << column;
+    }
+
+    // The index statements of old table
+    QStringList indexNames;
+    QStringList indexes;
+    QSqlQuery q = query();
+    q.prepare("SELECT name,sql FROM sqlite_master WHERE type = 'index' AND tbl_name = :table AND sql IS NOT NULL");
+    q.bindValue(":table",name);
+    if (!q.exec()) {
+        setLastQuery(q);
+        return false;
+    }
+    while (q.next()) {
+        indexNames << q.value(0).toString();
+        indexes << q.value(1).toString();
+    }
+    q.finish();
+
+    // The indexes on a removed column are not created again
+    QStringList removed = existing;
+    foreach (QString column , info->columnNameList())
+        removed.removeAll(column);
+
+    for (int i = indexes.size() - 1 ; i >= 0;i--) {
+        QSqlQuery columnQuery = query();
+        if (!columnQuery.exec(QString("PRAGMA index_info('%1')").arg(indexNames.at(i)))) {
+            setLastQuery(columnQuery);
+            return false;
+        }
+        while (columnQuery.next()) {
+            QString column = columnQuery.value(2).toString();
+            if (removed.contains(column)) {
+                qWarning() << QString("DQSql::rebuildTable() - The index %1 of removed column %2 is dropped").arg(indexNames.at(i)).arg(column);
+                indexNames.removeAt(i);
+                indexes.removeAt(i);
+                break;
+            }
+        }
+    }
+
+    if (!transaction())
+        return false;
+
+    bool res = exec(d->m_statement->createTableIfNotExists(info,target));
+
+    if (res && !common.isEmpty()) {
+        // The records are copied in batches ordered by id
+        QString columnList = common.join(",");
+        QString copy = QString("INSERT INTO %1 (%2) SELECT %2 FROM %3 WHERE id > :last ORDER BY id LIMIT %4;")
+                       .arg(target).arg(columnList).arg(name).arg(batchSize > 0 ? batchSize : -1);
+
+        QVariant last = -1;
+        for (;;) {
+            QSqlQuery insert = query();
+            insert.prepare(copy);
+            insert.bindValue(":last",last);
+            if (!insert.exec()) {
+                setLastQuery(insert);
+                res = false;
+                break;
+            }
+
+            if (insert.numRowsAffected() <= 0)
+                break;
+
+            QSqlQuery max = query();
+            if (!max.exec(QString("SELECT max(id) FROM %1").arg(target)) || !max.next()) {
+                setLastQuery(max);
+                res = false;
+                break;
+            }
+            last = max.value(0);
+        }
+    }
+
+    // Keep the AUTOINCREMENT sequence , the ids of removed records are not reused
+    if (res)
+        res = exec(QString("UPDATE sqlite_sequence SET seq = (SELECT max(seq) FROM sqlite_sequence WHERE name = '%1') "
+                           "WHERE name = '%2' AND EXISTS (SELECT 1 FROM sqlite_sequence WHERE name = '%1');").arg(name).arg(target));
+
+    if (res)
+        res = exec(d->m_statement->dropTable(info));
+
+    if (res)
+        res = exec(d->m_statement->renameTable(target,name));
+
+    if (res) {
+        foreach (QString sql , indexes) {
+            if (!exec(sql)) {
+                qWarning() << QString("DQSql::rebuildTable() - Failed to create the index of %1 again : %2").arg(name).arg(sql);
+                res = false;
+                break;
+            }
+        }
+    }
+
+    if (res) {
+        // The triggers of full text index are dropped with the old table
+        if (!createFullTextIndex(info))
+            qWarning() << QString("DQSql::rebuildTable() - Failed to create the full text index of %1 again").arg(name);
+    }
+
+    if (res) {
+        res = commit();
+    } else {
+        qWarning() << QString("DQSql::rebuildTable() - Failed to rebuild %1 : %2").arg(name).arg(lastQuery().lastError().text());
+        rollback();
+    }
+
+    clearSchemaCache();
+    notifyTableChanged(name);
+
+    return res;
+}
+
 bool DQSql::createIndexIfNotExists(const DQBaseIndex &index) {
     QString sql = d->m_statement->createIndexIfNotExists(index);
 
@@ -122,9 +832,45 @@ bool DQSql::createIndexIfNotExists(const DQBaseIndex &index) {
 
     setLastQuery(q);
 
+    if (res && d->m_statement->boundSchema(index.metaInfo()).isEmpty()) {
+        QMutexLocker locker(&d->m_mutex);
+        if (d->m_schemaLoaded)
+            d->m_schemaIndexes.insert(index.name(),index.metaInfo()->name());
+    }
+
     return res;
 }
 
+bool DQSql::createFullTextIndex(DQModelMetaInfo* info){
+    if (info->fullTextNameList().isEmpty())
+        return true;
+
+    QStringList statements = d->m_statement->createFullTextIndex(info);
+    if (statements.isEmpty()) {
+        qWarning() << QString("DQSql::createFullTextIndex() - Full text search is not supported by %1").arg(d->m_statement->driverName());
+        return false;
+    }
+
+    QString fts = DQSqlStatement::fullTextTable(info->name());
+    bool created = !tables().contains(fts);
+
+    foreach (QString sql , statements) {
+        if (!exec(sql))
+            return false;
+    }
+
+    if (created) {
+        // The records written before the index existed
+        if (!exec(d->m_statement->rebuildFullTextIndex(info)))
+            return false;
+
+        // The index comes with its shadow tables
+        clearSchemaCache();
+    }
+
+    return true;
+}
+
 bool DQSql::dropIndexIfExists(QString name){
     QString sql = d->m_statement->dropIndexIfExists(name);
 
@@ -133,23 +879,108 @@ bool DQSql::dropIndexIfExists(QString name){
 
     setLastQuery(q);
 
+    if (res) {
+        QMutexLocker locker(&d->m_mutex);
+        d->m_schemaIndexes.remove(name);
+    }
+
     return res;
 }
 
 bool DQSql::exists(DQModelMetaInfo* info){
-    if (d->m_db.driverName() != "QSQLITE") {
-        qWarning() << "Only QSQLITE dirver is supported.";
+    if (!d->m_statement->boundSchema(info).isEmpty()) {
+        // The schema cache only covers the main database. Probe the attached table directly
+        QSqlQuery q = query();
+        return q.exec(QString("SELECT 1 FROM %1 LIMIT 1").arg(d->m_statement->qualifiedName(info)));
+    }
+
+    QMutexLocker locker(&d->m_mutex);
+    if (!loadSchema())
         return false;
+
+    return d->m_schemaTables.contains(info->name());
+}
+
+QStringList DQSql::tables(){
+    QMutexLocker locker(&d->m_mutex);
+    if (!loadSchema())
+        return QStringList();
+
+    return d->m_schemaTables.keys();
+}
+
+QStringList DQSql::columns(QString table){
+    QMutexLocker locker(&d->m_mutex);
+    if (!loadSchema() || !d->m_schemaTables.contains(table))
+        return QStringList();
+
+    QStringList &res = d->m_schemaTables[table];
+    if (!res.isEmpty())
+        return res;
+
+    QSqlQuery q = query();
+    if (q.exec(d->m_statement->listColumns(table))) {
+        int name = q.record().indexOf("name");
+        while (q.next())
+            res << q.value(name).toString();
     }
+    setLastQuery(q);
 
-    QString sql = DQSqliteStatement::exists(info);
-//    qDebug() << sql;
+    return res;
+}
+
+QStringList DQSql::columns(DQModelMetaInfo* info){
+    if (d->m_statement->boundSchema(info).isEmpty())
+        return columns(info->name());
+
+    // The schema catalog only covers the main database
+    QStringList res;
     QSqlQuery q = query();
+    if (q.exec(d->m_statement->listColumns(info))) {
+        int name = q.record().indexOf("name");
+        while (q.next())
+            res << q.value(name).toString();
+    }
+    setLastQuery(q);
 
-    bool res = false;
-    if (q.exec(sql)) {
-        if (q.next())
-            res = true;
+    return res;
+}
+
+bool DQSql::indexExists(QString name){
+    QMutexLocker locker(&d->m_mutex);
+    if (!loadSchema())
+        return false;
+
+    return d->m_schemaIndexes.contains(name);
+}
+
+void DQSql::clearSchemaCache(){
+    QMutexLocker locker(&d->m_mutex);
+    d->m_schemaLoaded = false;
+    d->m_schemaTables.clear();
+    d->m_schemaIndexes.clear();
+}
+
+bool DQSql::loadSchema(){
+    if (d->m_schemaLoaded)
+        return true;
+
+    if (d->m_statement.isNull()) {
+        qWarning() << "DQSql::loadSchema() - No statement generator is set";
+        return false;
+    }
+
+    QSqlQuery q = query();
+    bool res = q.exec(d->m_statement->listSchema());
+    if (res) {
+        while (q.next()) {
+            QString name = q.value(1).toString();
+            if (q.value(0).toString() == "table")
+                d->m_schemaTables.insert(name,QStringList());
+            else
+                d->m_schemaIndexes.insert(name,q.value(2).toString());
+        }
+        d->m_schemaLoaded = true;
     }
 
     setLastQuery(q);
@@ -166,10 +997,9 @@ bool DQSql::replaceInto(DQModelMetaInfo* info,DQModel *model,QStringList fields,
 }
 
 bool DQSql::insertInto(DQModelMetaInfo* info,DQModel *model,QStringList fields,bool updateId,bool replace){
+    fields = info->writableFields(fields);
     QString sql;
 
-    QSqlQuery q = query();
-
     if (replace){
         sql = d->m_statement->replaceInto(info,fields);
     } else {
@@ -177,7 +1007,7 @@ bool DQSql::insertInto(DQModelMetaInfo* info,DQModel *model,QStringList fields,b
     }
 
 //    qDebug() << sql;
-    q.prepare(sql);
+    QSqlQuery q = prepare(sql);
 
     foreach (QString field , fields) {
         QVariant value;
@@ -190,8 +1020,13 @@ bool DQSql::insertInto(DQModelMetaInfo* info,DQModel *model,QStringList fields,b
 
     if (q.exec()) {
         res = true;
+        notifyTableChanged(info->name());
         if (updateId) {
-            int id = q.lastInsertId().toInt();
+            int id;
+            if (d->m_statement->returnsInsertId())
+                id = q.next() ? q.value(0).toInt() : model->id.get().toInt();
+            else
+                id = q.lastInsertId().toInt();
             if (model->id.get().toInt() != id)
                 model->id.set(id);
         }
@@ -201,3 +1036,245 @@ bool DQSql::insertInto(DQModelMetaInfo* info,DQModel *model,QStringList fields,b
 
     return res;
 }
+
+bool DQSql::upsert(DQModelMetaInfo* info,DQModel *model,QStringList fields,QStringList conflictColumns){
+    fields = info->writableFields(fields);
+    QString sql = d->m_statement->upsert(info,fields,conflictColumns);
+
+    QSqlQuery q = prepare(sql);
+
+    foreach (QString field , fields) {
+        q.bindValue(":" + field , info->value(model,field,true));
+    }
+
+    bool res = q.exec();
+
+    setLastQuery(q);
+
+    if (res)
+        notifyTableChanged(info->name());
+
+    return res;
+}
+
+int DQSql::update(DQModelMetaInfo* info,DQModel *model,QStringList fields){
+    fields = info->writableFields(fields);
+    QString sql = d->m_statement->update(info,fields);
+
+    QSqlQuery q = prepare(sql);
+
+    foreach (QString field , fields) {
+        q.bindValue(":" + field , info->value(model,field,true));
+    }
+    q.bindValue(":id" , model->id.get());
+
+    int res = -1;
+    if (q.exec()) {
+        res = q.numRowsAffected();
+        notifyTableChanged(info->name(),res);
+    }
+
+    setLastQuery(q);
+
+    return res;
+}
+
+bool DQSql::insertInto(DQModelMetaInfo* info,const QList<DQModel*> &models,QStringList fields,bool updateId) {
+    return insertInto(info,models,fields,updateId,false);
+}
+
+bool DQSql::replaceInto(DQModelMetaInfo* info,const QList<DQModel*> &models,QStringList fields,bool updateId){
+    return insertInto(info,models,fields,updateId,true);
+}
+
+bool DQSql::insertInto(DQModelMetaInfo* info,const QList<DQModel*> &models,QStringList fields,bool updateId,bool replace){
+    fields = info->writableFields(fields);
+    int n = models.size();
+    if (n == 0)
+        return true;
+
+    QString sql;
+
+    if (replace){
+        sql = d->m_statement->replaceInto(info,fields);
+    } else {
+        sql = d->m_statement->insertInto(info,fields);
+    }
+
+    QSqlQuery q = prepare(sql);
+
+    if (updateId && d->m_statement->returnsInsertId()) {
+        // The id of each record is read from its own "RETURNING id" result
+        bool res = true;
+        for (int i = 0 ; i < n && res; i++) {
+            DQModel *model = models.at(i);
+            foreach (QString field , fields) {
+                q.bindValue(":" + field , info->value(model,field,true));
+            }
+            res = q.exec();
+            if (res && q.next())
+                model->id.set(q.value(0).toInt());
+        }
+
+        if (res)
+            notifyTableChanged(info->name(),n);
+
+        setLastQuery(q);
+
+        return res;
+    }
+
+    foreach (QString field , fields) {
+        QVariantList values;
+        for (int i = 0 ; i < n ; i++) {
+            values << info->value(models.at(i),field,true);
+        }
+        q.bindValue(":" + field , values);
+    }
+
+    bool res = false;
+
+    if (q.execBatch()) {
+        res = true;
+        notifyTableChanged(info->name(),n);
+        if (updateId) {
+            /* The rowid of the records inserted by a single writer within a
+               transaction are sequential, so it could be derived from the
+               last one. It assumes the new rowid is max(rowid) + 1 , which
+               is always true for an AUTOINCREMENT table. A table without it
+               may reuse a free rowid once the max rowid is reached.
+             */
+            int id = q.lastInsertId().toInt() - n + 1;
+            for (int i = 0 ; i < n ; i++) {
+                models.at(i)->id.set(id + i);
+            }
+        }
+    }
+
+    setLastQuery(q);
+
+    return res;
+}
+
+int DQSql::removeIds(DQModelMetaInfo* info,QVariantList ids){
+    int n = ids.size();
+    if (n == 0)
+        return 0;
+
+    int chunkSize = qMax(d->m_statement->maxBindParameters() , 1);
+
+    if (!transaction())
+        return -1;
+
+    int res = 0;
+    QSqlQuery q;
+
+    for (int start = 0 ; start < n ; start += chunkSize) {
+        int rows = qMin(chunkSize , n - start);
+
+        q = prepare(d->m_statement->deleteRows(info,rows));
+        for (int i = 0 ; i < rows ; i++)
+            q.bindValue(i , ids.at(start + i));
+
+        if (!q.exec()) {
+            qWarning() << QString("DQSql::removeIds() - Failed to remove from %1 : %2").arg(info->name()).arg(q.lastError().text());
+            res = -1;
+            break;
+        }
+        res += q.numRowsAffected();
+        q.finish();
+    }
+
+    setLastQuery(q);
+
+    if (res >= 0 && !commit())
+        res = -1;
+
+    if (res < 0) {
+        rollback();
+        return -1;
+    }
+
+    notifyTableChanged(info->name(),res);
+
+    return res;
+}
+
+bool DQSql::bulkInsert(DQModelMetaInfo* info,DQSharedList list,QStringList fields,bool updateId){
+    fields = info->writableFields(fields);
+    int n = list.size();
+    if (n == 0)
+        return true;
+
+    QList<DQModel*> models;
+    QVariantList ids;
+    models.reserve(n);
+    for (int i = 0 ; i < n ; i++) {
+        models << static_cast<DQModel*>(list.at(i));
+        ids << models.at(i)->id.get();
+    }
+
+    if (fields.isEmpty()) {
+        // "DEFAULT VALUES" could not be written in multiple rows
+        return insertInto(info,models,fields,updateId,false);
+    }
+
+    int chunkSize = qMax(d->m_statement->maxBindParameters() / fields.size() , 1);
+    bool returnsId = d->m_statement->returnsInsertId();
+
+    if (!transaction())
+        return false;
+
+    bool res = true;
+    QSqlQuery q;
+
+    for (int start = 0 ; start < n && res; start += chunkSize) {
+        int rows = qMin(chunkSize , n - start);
+
+        // Full chunks share the same cached statement
+        q = prepare(d->m_statement->insertRows(info,fields,rows));
+
+        int pos = 0;
+        for (int i = start ; i < start + rows ; i++) {
+            DQModel *model = models.at(i);
+            foreach (QString field , fields) {
+                q.bindValue(pos++ , info->value(model,field,true));
+            }
+        }
+
+        if (!q.exec()) {
+            qWarning() << QString("DQSql::bulkInsert() - Failed to insert into %1 : %2").arg(info->name()).arg(q.lastError().text());
+            res = false;
+            break;
+        }
+
+        if (updateId && returnsId) {
+            for (int i = start ; i < start + rows && q.next() ; i++)
+                models.at(i)->id.set(q.value(0).toInt());
+        } else if (updateId) {
+            // The same assumption of contiguous rowid as insertInto()
+            int id = q.lastInsertId().toInt() - rows + 1;
+            for (int i = 0 ; i < rows ; i++)
+                models.at(start + i)->id.set(id + i);
+        }
+        q.finish();
+    }
+
+    setLastQuery(q);
+
+    if (res)
+        res = commit();
+
+    if (!res) {
+        rollback();
+        if (updateId) {
+            for (int i = 0 ; i < n ; i++)
+                models.at(i)->id.set(ids.at(i));
+        }
+        return false;
+    }
+
+    notifyTableChanged(info->name(),n);
+
+    return true;
+}
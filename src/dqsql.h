@@ -9,6 +9,7 @@
 class DQModelMetaInfo;
 class DQSqlStatement;
 class DQModel;
+class DQSharedList;
 
 class DQSqlStatement;
 
@@ -52,17 +53,83 @@ public:
     bool createTableIfNotExists(DQModelMetaInfo* info);
 
     /// Run drop table of a model
+    /**
+      The full text index of the model is dropped too.
+     */
     bool dropTable(DQModelMetaInfo* info);
 
+    /// Add the column of a field to existing table by "ALTER TABLE ... ADD COLUMN"
+    bool addColumn(DQModelMetaInfo* info,QString field);
+
+    /// Rebuild the table of a model by copying its records to a new table
+    /**
+      A new table is created from the model declaration. The columns exist in both
+      tables are copied by "INSERT ... SELECT" in batches of batchSize records ordered by id.
+      Then the old table is dropped and the new table is renamed. The indexes of old table
+      are created again if their columns are still existed.
+
+      All the steps are run in a single transaction. The table is unchanged on failure ,
+      including the failure to create an index of old table again (e.g an index on an
+      expression of removed column).
+
+      @remarks The foreign key constraint is not checked during the copy if "PRAGMA foreign_keys" is off.
+      If it is on , the records refer to the table may be deleted / rejected by dropping the old table.
+     */
+    bool rebuildTable(DQModelMetaInfo* info,int batchSize = 10000);
+
     /// Create index
     bool createIndexIfNotExists(const DQBaseIndex &index);
 
     /// Drop index
     bool dropIndexIfExists(QString name);
 
+    /// Create the full text index of the DQFullText fields of a model
+    /**
+      The index table and its triggers are created if they are not existed.
+      A new index is filled from the records of the table.
+
+      @return TRUE if the model has no DQFullText field or the index is created.
+      FALSE if the database do not support full text search.
+     */
+    bool createFullTextIndex(DQModelMetaInfo* info);
+
     /// Is the model exists on database?
+    /**
+      It is answered by the schema catalog. See tables()
+     */
     bool exists(DQModelMetaInfo* info);
 
+    /// The tables in database
+    /**
+      The tables and indexes are read by a single scan of "sqlite_master" on
+      first use, and kept in the schema catalog of the connection. The catalog
+      is updated by the DDL operations of DQSql (create / drop table and index).
+
+      @remarks The schema changes made by other connection, process or raw SQL are not detected. Call clearSchemaCache() for that case.
+     */
+    QStringList tables();
+
+    /// The column names of a table in declaration order
+    /**
+      It is read by "pragma table_xinfo" once per table and kept in the schema catalog.
+      @return The columns. It is empty if the table is not existed.
+     */
+    QStringList columns(QString table);
+
+    /// The column names of the table of a model in declaration order
+    /**
+      The table is looked up in the schema bound by DQSqlStatement::bindSchema(). The columns
+      of an attached table are not kept in the schema catalog , they are read on every call.
+      @return The columns. It is empty if the table is not existed.
+     */
+    QStringList columns(DQModelMetaInfo* info);
+
+    /// TRUE if the index is existed in database
+    bool indexExists(QString name);
+
+    /// Discard the schema catalog. It will be read again on next use
+    void clearSchemaCache();
+
     /// Insert the reocrd to the database.
     /**
       @param info The meta information of writing model
@@ -81,12 +148,269 @@ public:
      */
     bool replaceInto(DQModelMetaInfo* info,DQModel *model,QStringList fields,bool updateId);
 
+    /// Insert the record , or update the existing one which conflicts with it
+    /**
+      @param info The meta information of writing model
+      @param model The data source
+      @param fields A list of fields that should be saved
+      @param conflictColumns The columns of a UNIQUE / PRIMARY KEY constraint
+
+      @remarks The id of model is not updated, as the record may not be inserted.
+      @see DQSqlStatement::upsert()
+     */
+    bool upsert(DQModelMetaInfo* info,DQModel *model,QStringList fields,QStringList conflictColumns);
+
+    /// Update the fields of an existing record
+    /**
+      @param info The meta information of writing model
+      @param model The data source. The record is matched by its id
+      @param fields A list of fields that should be saved. It should not contain the "id" field.
+      @return No. of records updated. -1 if the operation is failed.
+     */
+    int update(DQModelMetaInfo* info,DQModel *model,QStringList fields);
+
+    /// Insert a set of records to the database with a single prepared statement
+    /**
+      All the models must be the instance of the same model and the
+      same set of fields is bound for every record. The values are bound by
+      QSqlQuery::execBatch().
+
+      @param info The meta information of writing model
+      @param models The data source
+      @param fields A list of fields that should be saved
+      @param updateId TRUE if the ID of the models should be updated after operation. It assumes the records do not contain the "id" field,
+      and the generated ids are sequential (It is true for a single writer within a transaction).
+     */
+    bool insertInto(DQModelMetaInfo* info,const QList<DQModel*> &models,QStringList fields,bool updateId);
+
+    /// Replace a set of records to the database with a single prepared statement
+    /**
+      @see insertInto(DQModelMetaInfo*,const QList<DQModel*>&,QStringList,bool)
+     */
+    bool replaceInto(DQModelMetaInfo* info,const QList<DQModel*> &models,QStringList fields,bool updateId);
+
+    /// Insert a list of records by multi-row "INSERT INTO ... VALUES (..),(..)" statements
+    /**
+      The records are split into chunks limited by DQSqlStatement::maxBindParameters() ,
+      and each chunk is written by a single statement within a transaction. It saves the
+      per-statement overhead of insertInto() on large loads.
+
+      @param info The meta information of writing model. All the models of list must be its instance.
+      @param list The data source
+      @param fields A list of fields that should be saved. It should not contain the "id" field.
+      @param updateId TRUE if the ID of the models should be updated after operation. The ids generated by
+      a single writer within a transaction are assumed to be sequential , see DQSharedList::saveAll().
+      @return TRUE if all the records are inserted. Nothing is inserted on failure , and the ids of the models are restored.
+     */
+    bool bulkInsert(DQModelMetaInfo* info,DQSharedList list,QStringList fields,bool updateId = true);
+
+    /// Remove a set of records by id
+    /**
+      The ids are removed by "DELETE ... WHERE id IN (...)" statements in chunks limited by
+      DQSqlStatement::maxBindParameters() , within a transaction.
+
+      @return No. of records removed. -1 if the operation is failed , nothing is removed in that case.
+     */
+    int removeIds(DQModelMetaInfo* info,QVariantList ids);
+
+    /// Begin a transaction
+    /**
+      Transactions could be nested. The outermost call begins a real
+      database transaction , the inner calls create a SAVEPOINT instead.
+
+      @see commit()
+      @see rollback()
+     */
+    bool transaction();
+
+    /// Commit the innermost transaction (or release the savepoint)
+    bool commit();
+
+    /// Rollback the innermost transaction (or rollback to the savepoint)
+    bool rollback();
+
+    /// The nesting level of transaction. Zero if no transaction is started by DQSql
+    int transactionDepth();
+
     /// Create a query object to the connected database
     QSqlQuery query();
 
-    /// The last query object
+    /// The last query object of the calling thread
     QSqlQuery lastQuery();
 
+    /// Enable / disable the recording of last query
+    /**
+      The last query is stored per thread. It is enabled by default.
+      The queries of all the threads are released by setDatabase().
+     */
+    void setLastQueryEnabled(bool enabled);
+
+    /// TRUE if the last query is recorded
+    bool isLastQueryEnabled();
+
+    /// Create a prepared query object for the SQL statement
+    /**
+      Prepared statements are kept in a per-connection LRU cache keyed
+      by the SQL text, so a repeated statement skips the parse / plan
+      cost of QSqlQuery::prepare(). A cached statement that is still
+      active (e.g. another query is iterating it) will not be shared,
+      a fresh one is prepared instead. A repeat of the last cached statement
+      which shares the string data (e.g. the interned SQL generated by
+      DQSqlStatement) is matched without hashing the SQL text.
+
+      Any value bound by previous user will be overwritten by caller,
+      so it is expected to bind every placeholder before exec().
+
+      The query is forward-only. The driver will not cache the retrieved
+      records for backward navigation, so the memory usage of reading a large
+      result is constant.
+     */
+    QSqlQuery prepare(const QString& sql);
+
+    /// Set the maximum no. of prepared statement stored in the cache
+    /**
+      @param capacity The no. of statement. Zero will disable the cache.
+     */
+    void setStatementCacheCapacity(int capacity);
+
+    /// The maximum no. of prepared statement stored in the cache
+    int statementCacheCapacity();
+
+    /// No. of prepare() call which is served by the cache
+    int statementCacheHits();
+
+    /// No. of prepare() call which required to prepare a new statement
+    int statementCacheMisses();
+
+    /// Remove all the cached statement and reset the counters
+    void clearStatementCache();
+
+    /// Enable / disable the query result cache. It is disabled by default.
+    /**
+      When it is enabled, the result of DQSharedQuery::all() / count() / call() is
+      stored in a per-connection cache keyed by the SQL and bind values. The
+      repeated query is served without touching the database until:
+
+      <ul>
+      <li> A table it read is changed through DQuest (insert / update / remove / drop) </li>
+      <li> The time to live is passed (setResultCacheTtl()) </li>
+      <li> It is evicted by the memory limit (setResultCacheMaxSize()) </li>
+      <li> A transaction is rolled back </li>
+      </ul>
+
+      @remarks The changes made by other connection, process or raw SQL are not detected. Call notifyTableChanged() or set a TTL for that case.
+      The raw SQL run through the connection is detected while DQConnection::watch() is active.
+     */
+    void setResultCacheEnabled(bool enabled);
+
+    /// TRUE if the result cache is enabled
+    bool isResultCacheEnabled();
+
+    /// Set the time to live of cached result in msecs. Zero means it never expires (the default)
+    void setResultCacheTtl(int msecs);
+
+    /// The time to live of cached result in msecs
+    int resultCacheTtl();
+
+    /// Set the approximate memory limit of the result cache in bytes
+    void setResultCacheMaxSize(int bytes);
+
+    /// The approximate memory limit of the result cache in bytes
+    int resultCacheMaxSize();
+
+    /// No. of query served by the result cache
+    int resultCacheHits();
+
+    /// Remove all the cached result and reset the counter
+    void clearResultCache();
+
+    /// Notify that the content of a table is changed. The cached results depend on it will be discarded.
+    /**
+      It is called automatically by DQuest's write operations.
+
+      @param rows No. of rows written. It is counted into writeCounts()
+     */
+    void notifyTableChanged(QString table , int rows = 1);
+
+    /// The no. of rows written to each table through notifyTableChanged()
+    /**
+      The counters are never reset. It is used by DQConnection::setMaintenanceEnabled()
+      to find the tables that changed a lot since the last maintenance.
+     */
+    QHash<QString,qint64> writeCounts();
+
+    /// A counter increased by every table change
+    /**
+      @remarks Internal use. The value should be read before the query, and passed to storeResult()
+     */
+    quint64 resultCacheGeneration();
+
+    /// Get a cached result
+    /**
+      @remarks Internal use
+      @return TRUE if it is found
+     */
+    bool cachedResult(const QString &key,QStringList *columns,QList<QVariantList> *rows);
+
+    /// Store a result to the cache
+    /**
+      @param key The SQL and bind values
+      @param tables The tables read by the query
+      @param columns The column names of result
+      @param rows The result
+      @param generation The value of resultCacheGeneration() before the query. The result will not be stored if any table is changed since then.
+
+      @remarks Internal use
+     */
+    void storeResult(const QString &key,QStringList tables,QStringList columns,QList<QVariantList> rows,quint64 generation);
+
+    /// Enable / disable the identity map. It is disabled by default.
+    /**
+      The identity map keeps a copy of the models loaded by id , keyed by
+      the table and id. A repeated lookup of the same record (e.g. loading
+      the same foreign key from many records) is served without touching
+      the database.
+
+      The entries of a table are invalidated by any change of the table made
+      through DQuest (save / remove / update / drop) and by rollback().
+
+      @remarks Like the result cache, the changes made by other connection, process or raw SQL are not detected.
+     */
+    void setIdentityMapEnabled(bool enabled);
+
+    /// TRUE if the identity map is enabled
+    bool isIdentityMapEnabled();
+
+    /// Set the maximum no. of model stored in the identity map
+    void setIdentityMapCapacity(int capacity);
+
+    /// The maximum no. of model stored in the identity map
+    int identityMapCapacity();
+
+    /// No. of lookup served by the identity map
+    int identityMapHits();
+
+    /// Remove all the models in the identity map and reset the counter
+    void clearIdentityMap();
+
+    /// Copy the model with the id from the identity map
+    /**
+      @return TRUE if it is found , the fields of model will be overwritten.
+
+      @remarks Internal use
+     */
+    bool lookupIdentity(DQModelMetaInfo* info,QVariant id,DQAbstractModel* model);
+
+    /// Store a copy of the model to the identity map
+    /**
+      @param info The meta info of the model
+      @param model The loaded model
+      @param generation The value of resultCacheGeneration() before the model is read. It will not be stored if any table is changed since then.
+
+      @remarks Internal use
+     */
+    void storeIdentity(DQModelMetaInfo* info,const DQAbstractModel* model,quint64 generation);
+
 protected:
     /**
       @param statement A instance of DQSqlStatement. The ownership will be taken.
@@ -109,8 +433,19 @@ protected:
 private:
     void setLastQuery(QSqlQuery query);
 
+    /// Run a statement which do not return any result
+    bool exec(QString sql);
+
+    /// The savepoint name of the nesting level
+    QString savepointName(int depth);
+
+    /// Read the schema catalog if it is not loaded. m_mutex must be locked
+    bool loadSchema();
+
     bool insertInto(DQModelMetaInfo* info,DQModel *model,QStringList fields,bool with_id,bool replace);
 
+    bool insertInto(DQModelMetaInfo* info,const QList<DQModel*> &models,QStringList fields,bool updateId,bool replace);
+
     QExplicitlySharedDataPointer<DQSqlPriv> d;
 
     friend class DQConnection;
@@ -0,0 +1,108 @@
+#include <QtCore>
+#include "dqsqlbuilder_p.h"
+
+/* Test cases:
+
+  coretests::sqlBuilder()
+
+ */
+
+/// The buffers and interned statements of a thread
+class _DQSqlBuilderData {
+public:
+    _DQSqlBuilderData() {
+        depth = 0;
+    }
+
+    ~_DQSqlBuilderData() {
+        qDeleteAll(buffers);
+    }
+
+    /// The buffer of each nesting level
+    QList<QString*> buffers;
+
+    /// The nesting level of the builders in use
+    int depth;
+
+    QSet<QString> interned;
+};
+
+static QThreadStorage<_DQSqlBuilderData*> m_builderData;
+
+static _DQSqlBuilderData* _dqBuilderData() {
+    if (!m_builderData.hasLocalData())
+        m_builderData.setLocalData(new _DQSqlBuilderData());
+    return m_builderData.localData();
+}
+
+_DQSqlBuilder::_DQSqlBuilder(){
+    _DQSqlBuilderData *data = _dqBuilderData();
+
+    if (data->depth == data->buffers.size()) {
+        QString *buffer = new QString();
+        buffer->reserve(DQ_SQL_BUFFER_RESERVE);
+        data->buffers.append(buffer);
+    }
+
+    m_sql = data->buffers.at(data->depth++);
+
+    // The reserved capacity is kept by resize()
+    m_sql->resize(0);
+}
+
+_DQSqlBuilder::~_DQSqlBuilder(){
+    _DQSqlBuilderData *data = _dqBuilderData();
+    data->depth--;
+
+    if (m_sql->capacity() > DQ_SQL_BUFFER_MAX) {
+        *m_sql = QString();
+        m_sql->reserve(DQ_SQL_BUFFER_RESERVE);
+    }
+}
+
+QString _DQSqlBuilder::result(){
+    return intern(*m_sql);
+}
+
+QString _DQSqlBuilder::intern(const QString &sql){
+    _DQSqlBuilderData *data = _dqBuilderData();
+
+    QSet<QString>::const_iterator iter = data->interned.constFind(sql);
+    if (iter != data->interned.constEnd())
+        return *iter;
+
+    if (data->interned.size() >= DQ_SQL_INTERN_CAPACITY)
+        data->interned.clear();
+
+    // A deep copy , the buffer must not be shared otherwise it is detached on next build
+    QString res(sql.constData(),sql.size());
+    data->interned.insert(res);
+    return res;
+}
+
+void _DQSqlBuilder::appendNumber(QString &sql,qint64 value){
+    char buffer[24];
+    int pos = sizeof(buffer);
+    bool negative = value < 0;
+    quint64 n = negative ? (quint64) 0 - (quint64) value : (quint64) value;
+
+    buffer[--pos] = '\0';
+    do {
+        buffer[--pos] = '0' + (char) (n % 10);
+        n /= 10;
+    } while (n > 0);
+
+    if (negative)
+        buffer[--pos] = '-';
+
+    sql += QLatin1String(buffer + pos);
+}
+
+void _DQSqlBuilder::appendJoined(QString &sql,const QStringList &list,char separator){
+    int n = list.size();
+    for (int i = 0 ; i < n;i++) {
+        if (i > 0)
+            sql += QLatin1Char(separator);
+        sql += list.at(i);
+    }
+}
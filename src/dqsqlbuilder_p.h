@@ -0,0 +1,62 @@
+#ifndef DQSQLBUILDER_P_H
+#define DQSQLBUILDER_P_H
+
+#include <QString>
+#include <QStringList>
+
+/// The initial capacity of the per-thread buffer of _DQSqlBuilder in characters
+#ifndef DQ_SQL_BUFFER_RESERVE
+#define DQ_SQL_BUFFER_RESERVE 1024
+#endif
+
+/// The buffer grown beyond this capacity is released after use
+#ifndef DQ_SQL_BUFFER_MAX
+#define DQ_SQL_BUFFER_MAX 65536
+#endif
+
+/// The max no. of statements kept by _DQSqlBuilder::intern() per thread
+#ifndef DQ_SQL_INTERN_CAPACITY
+#define DQ_SQL_INTERN_CAPACITY 1024
+#endif
+
+/// Build a SQL statement in a reusable per-thread buffer
+/**
+  The statement is appended to sql() , which keeps its capacity between the
+  builds , so the generation do not allocate once the buffer reached the size
+  of the statements. The builders could be nested , each level takes its own buffer.
+
+  result() returns the interned copy of the statement. The same statement
+  generated again returns the same shared string without allocation , and
+  the statement cache of DQSql compares it by the shared data.
+
+  @remarks It must be destroyed in the thread where it is created.
+ */
+class _DQSqlBuilder {
+public:
+    _DQSqlBuilder();
+    ~_DQSqlBuilder();
+
+    /// The buffer of the statement
+    inline QString& sql() {
+        return *m_sql;
+    }
+
+    /// The interned copy of the built statement
+    QString result();
+
+    /// The interned copy of a statement
+    static QString intern(const QString &sql);
+
+    /// Append a decimal number without a temporary string
+    static void appendNumber(QString &sql,qint64 value);
+
+    /// Append the items of a list separated by a character
+    static void appendJoined(QString &sql,const QStringList &list,char separator = ',');
+
+private:
+    Q_DISABLE_COPY(_DQSqlBuilder)
+
+    QString *m_sql;
+};
+
+#endif // DQSQLBUILDER_P_H
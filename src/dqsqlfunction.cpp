@@ -0,0 +1,162 @@
+#include <QtCore>
+#include "dqsqlfunction_p.h"
+#include "dqsqlite_p.h"
+
+/* Test cases:
+
+  sqlitetests::sqlFunction()
+
+ */
+
+#ifdef DQ_SQLITE_API
+static QVariant _dqFromSqliteValue(sqlite3_value *value) {
+    switch (sqlite3_value_type(value)) {
+    case SQLITE_INTEGER:
+        return QVariant((qlonglong) sqlite3_value_int64(value));
+    case SQLITE_FLOAT:
+        return QVariant(sqlite3_value_double(value));
+    case SQLITE_TEXT:
+        return QVariant(QString::fromUtf8((const char*) sqlite3_value_text(value),sqlite3_value_bytes(value)));
+    case SQLITE_BLOB:
+        return QVariant(QByteArray((const char*) sqlite3_value_blob(value),sqlite3_value_bytes(value)));
+    default:
+        return QVariant();
+    }
+}
+
+static QVariantList _dqArguments(int argc,sqlite3_value **argv) {
+    QVariantList res;
+    res.reserve(argc);
+    for (int i = 0 ; i < argc;i++)
+        res << _dqFromSqliteValue(argv[i]);
+    return res;
+}
+
+static void _dqSetResult(sqlite3_context *context,const QVariant &value) {
+    if (value.isNull()) {
+        sqlite3_result_null(context);
+        return;
+    }
+
+    switch (value.type()) {
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+        sqlite3_result_int64(context,value.toLongLong());
+        break;
+    case QVariant::Double:
+        sqlite3_result_double(context,value.toDouble());
+        break;
+    case QVariant::ByteArray: {
+        QByteArray data = value.toByteArray();
+        sqlite3_result_blob(context,data.constData(),data.size(),SQLITE_TRANSIENT);
+        break;
+    }
+    default: {
+        QByteArray text = value.toString().toUtf8();
+        sqlite3_result_text(context,text.constData(),text.size(),SQLITE_TRANSIENT);
+        break;
+    }
+    }
+}
+
+static void _dqScalarCallback(sqlite3_context *context,int argc,sqlite3_value **argv) {
+    _DQSqlFunction *function = static_cast<_DQSqlFunction*>(sqlite3_user_data(context));
+    _dqSetResult(context,function->function(_dqArguments(argc,argv),function->userData));
+}
+
+/// The state of a group is kept as a QVariant* in the aggregate context
+static QVariant* _dqAggregateState(sqlite3_context *context,bool create) {
+    QVariant **state = static_cast<QVariant**>(sqlite3_aggregate_context(context,create ? sizeof(QVariant*) : 0));
+    if (!state)
+        return 0;
+    if (!*state && create)
+        *state = new QVariant();
+    return *state;
+}
+
+static void _dqStepCallback(sqlite3_context *context,int argc,sqlite3_value **argv) {
+    _DQSqlFunction *function = static_cast<_DQSqlFunction*>(sqlite3_user_data(context));
+    QVariant *state = _dqAggregateState(context,true);
+    if (!state) {
+        sqlite3_result_error_nomem(context);
+        return;
+    }
+
+    function->step(*state,_dqArguments(argc,argv),function->userData);
+}
+
+static void _dqFinalCallback(sqlite3_context *context) {
+    _DQSqlFunction *function = static_cast<_DQSqlFunction*>(sqlite3_user_data(context));
+    QVariant *state = _dqAggregateState(context,false);
+
+    _dqSetResult(context,function->final(state ? *state : QVariant(),function->userData));
+
+    delete state;
+}
+
+static void _dqDestroyFunction(void *data) {
+    delete static_cast<_DQSqlFunction*>(data);
+}
+#endif
+
+_DQSqlFunction::_DQSqlFunction() {
+    nArgs = 0;
+    function = 0;
+    step = 0;
+    final = 0;
+    userData = 0;
+    deterministic = false;
+}
+
+bool _DQSqlFunction::isSame(const QString &name,int nArgs) const{
+    return this->nArgs == nArgs && this->name.compare(name,Qt::CaseInsensitive) == 0;
+}
+
+bool _DQSqlFunction::install(sqlite3 *handle) const{
+#ifndef DQ_SQLITE_API
+    Q_UNUSED(handle);
+    return false;
+#else
+    QByteArray utf8 = name.toUtf8();
+
+    int flags = SQLITE_UTF8;
+#ifdef SQLITE_DETERMINISTIC
+    if (deterministic && function)
+        flags |= SQLITE_DETERMINISTIC;
+#endif
+
+    _DQSqlFunction *copy = new _DQSqlFunction(*this);
+    int rc;
+    if (function) {
+        rc = sqlite3_create_function_v2(handle,utf8.constData(),nArgs,flags,copy,
+                                        _dqScalarCallback,0,0,_dqDestroyFunction);
+    } else {
+        rc = sqlite3_create_function_v2(handle,utf8.constData(),nArgs,flags,copy,
+                                        0,_dqStepCallback,_dqFinalCallback,_dqDestroyFunction);
+    }
+
+    // xDestroy is called on failure too , the copy must not be deleted here
+    if (rc != SQLITE_OK) {
+        qWarning() << QString("_DQSqlFunction::install() - Failed to create %1 : %2")
+                      .arg(name).arg(QString::fromUtf8(sqlite3_errmsg(handle)));
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+bool _DQSqlFunction::uninstall(sqlite3 *handle,const QString &name,int nArgs){
+#ifndef DQ_SQLITE_API
+    Q_UNUSED(handle);
+    Q_UNUSED(name);
+    Q_UNUSED(nArgs);
+    return false;
+#else
+    QByteArray utf8 = name.toUtf8();
+    return sqlite3_create_function_v2(handle,utf8.constData(),nArgs,SQLITE_UTF8,0,0,0,0,0) == SQLITE_OK;
+#endif
+}
@@ -0,0 +1,44 @@
+#ifndef DQSQLFUNCTION_P_H
+#define DQSQLFUNCTION_P_H
+
+#include <QString>
+#include "dqconnection.h"
+
+struct sqlite3;
+
+/// A SQL function registered by DQConnection::registerFunction() / registerAggregate()
+/**
+  The registration is kept by DQConnection , so it could be installed again
+  on every clone. Each install passes a heap copy to SQLite as the user data ,
+  it is deleted by SQLite when the function is replaced or the database is closed.
+
+  The arguments and result are converted between sqlite3_value and QVariant by
+  the storage class of the value.
+ */
+class _DQSqlFunction {
+public:
+    _DQSqlFunction();
+
+    QString name;
+    int nArgs;
+
+    /// The scalar function. NULL for an aggregate
+    DQSqlFunction function;
+
+    DQSqlAggregateStep step;
+    DQSqlAggregateFinal final;
+
+    void *userData;
+    bool deterministic;
+
+    /// TRUE if it is the same function (name and no. of arguments)
+    bool isSame(const QString &name,int nArgs) const;
+
+    /// Install the function on a handle
+    bool install(sqlite3 *handle) const;
+
+    /// Remove the function from a handle
+    static bool uninstall(sqlite3 *handle,const QString &name,int nArgs);
+};
+
+#endif // DQSQLFUNCTION_P_H
@@ -0,0 +1,42 @@
+#ifndef DQSQLITE_P_H
+#define DQSQLITE_P_H
+
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QVariant>
+
+#ifdef DQ_SQLITE_API
+#include <sqlite3.h>
+#else
+struct sqlite3;
+
+#ifdef SQLITE_ENABLE_SNAPSHOT
+#error "SQLITE_ENABLE_SNAPSHOT requires DQuest built with CONFIG += dquest_sqlite_api"
+#endif
+#endif
+
+/// Get the SQLite handle of a database. It is 0 if the database is not opened by the QSQLITE driver
+/**
+  The handle is used to call the SQLite C API which is not exposed by QtSql.
+
+  @remarks The QSQLITE driver must be built with the same SQLite library as DQuest (e.g Qt configured with -system-sqlite).
+  It is always 0 unless DQuest is built with CONFIG += dquest_sqlite_api , and the features depending on the C API
+  fall back to plain SQL (or fail with a warning).
+ */
+static inline sqlite3* _dqSqliteHandle(QSqlDatabase db) {
+#ifndef DQ_SQLITE_API
+    Q_UNUSED(db);
+    return 0;
+#else
+    if (!db.isOpen() || !db.driver())
+        return 0;
+
+    QVariant v = db.driver()->handle();
+    if (!v.isValid() || qstrcmp(v.typeName(),"sqlite3*") != 0)
+        return 0;
+
+    return *static_cast<sqlite3**>(v.data());
+#endif
+}
+
+#endif // DQSQLITE_P_H
@@ -8,7 +8,7 @@ DQSqliteStatement::DQSqliteStatement()
 {
 }
 
-QString DQSqliteStatement::_createTableIfNotExists(DQModelMetaInfo *info) {
+QString DQSqliteStatement::_createTableIfNotExists(DQModelMetaInfo *info,QString tableName) {
     QString statement = QString("%1 (\n%2\n);");
     QString createTable = QString("CREATE TABLE IF NOT EXISTS %1 ");
 
@@ -51,12 +51,110 @@ QString DQSqliteStatement::_createTableIfNotExists(DQModelMetaInfo *info) {
 
     QString sql;
     sql = statement
-          .arg(createTable.arg(info->name()))
+          .arg(createTable.arg(tableName))
           .arg(columnDefList.join(",\n"));
 
     return sql;
 }
 
+QString DQSqliteStatement::_columnDefinition(const DQModelMetaInfoField *field) {
+    DQClause clause = field->clause;
+    QString res = QString("%1 %2 %3")
+                  .arg(field->name)
+                  .arg(columnTypeName(field->type))
+                  .arg(columnConstraint(field->clause));
+
+    // The table constraint can't be added. Use column constraint instead.
+    if (clause.testFlag(DQClause::FOREIGN_KEY)) {
+        DQModelMetaInfo * targetInfo = (DQModelMetaInfo*) clause.flag(DQClause::FOREIGN_KEY).value<void *>();
+        res += QString(" REFERENCES %1(id)").arg(targetInfo->name());
+    }
+
+    return res;
+}
+
+bool DQSqliteStatement::canAddColumn(const DQModelMetaInfoField *field) {
+    DQClause clause = field->clause;
+
+    if (clause.testFlag(DQClause::PRIMARY_KEY) || clause.testFlag(DQClause::UNIQUE))
+        return false;
+
+    // Only a virtual generated column could be added
+    if (clause.testFlag(DQClause::STORED))
+        return false;
+
+    bool hasDefault = clause.testFlag(DQClause::DEFAULT) && !clause.flag(DQClause::DEFAULT).isNull();
+
+    if (clause.testFlag(DQClause::NOT_NULL) && !hasDefault)
+        return false;
+
+    if (hasDefault) {
+        QString value = clause.flag(DQClause::DEFAULT).toString().trimmed().toUpper();
+        if (value.startsWith("CURRENT_") || value.startsWith("("))
+            return false;
+    }
+
+    return true;
+}
+
+QString DQSqliteStatement::createIndexIfNotExists(const DQBaseIndex& index){
+    QString schema = boundSchema(index.metaInfo());
+    if (schema.isEmpty())
+        return DQSqlStatement::createIndexIfNotExists(index);
+
+    // CREATE INDEX schema.index ON table (...)
+    QString createIndex = "CREATE %1INDEX IF NOT EXISTS %2.%3 on %4 (%5)%6;";
+
+    QString sql = createIndex.arg(index.isUnique() ? "UNIQUE " : "")
+                             .arg(schema)
+                             .arg(index.name())
+                             .arg(index.metaInfo()->name())
+                             .arg(index.columnDefList().join(","))
+                             .arg(index.where().isEmpty() ? QString() : " WHERE " + index.where());
+
+    return sql;
+}
+
+QStringList DQSqliteStatement::createFullTextIndex(DQModelMetaInfo *info){
+    QStringList res;
+    QStringList fields = info->fullTextNameList();
+    if (fields.isEmpty())
+        return res;
+
+    QString table = info->name();
+    QString fts = fullTextTable(table);
+
+    QStringList newValues;
+    QStringList oldValues;
+    foreach (QString field , fields) {
+        newValues << "new." + field;
+        oldValues << "old." + field;
+    }
+
+    // The text is not copied. The index reads the content from the table by rowid , which is the id field.
+    res << QString("CREATE VIRTUAL TABLE IF NOT EXISTS %1 USING fts5(%2, content='%3', content_rowid='id');")
+           .arg(fts).arg(fields.join(", ")).arg(table);
+
+    QString insert = QString("INSERT INTO %1(rowid, %2) VALUES (new.id, %3);")
+                     .arg(fts).arg(fields.join(", ")).arg(newValues.join(", "));
+    QString remove = QString("INSERT INTO %1(%1, rowid, %2) VALUES ('delete', old.id, %3);")
+                     .arg(fts).arg(fields.join(", ")).arg(oldValues.join(", "));
+
+    res << QString("CREATE TRIGGER IF NOT EXISTS %1_ai AFTER INSERT ON %2 BEGIN %3 END;")
+           .arg(fts).arg(table).arg(insert);
+    res << QString("CREATE TRIGGER IF NOT EXISTS %1_ad AFTER DELETE ON %2 BEGIN %3 END;")
+           .arg(fts).arg(table).arg(remove);
+    res << QString("CREATE TRIGGER IF NOT EXISTS %1_au AFTER UPDATE OF id, %2 ON %3 BEGIN %4 %5 END;")
+           .arg(fts).arg(fields.join(", ")).arg(table).arg(remove).arg(insert);
+
+    return res;
+}
+
+QString DQSqliteStatement::rebuildFullTextIndex(DQModelMetaInfo *info){
+    QString fts = fullTextTable(info->name());
+    return QString("INSERT INTO %1(%1) VALUES ('rebuild');").arg(fts);
+}
+
 QString DQSqliteStatement::columnTypeName(QVariant::Type type) {
     QString res;
     switch (type){
@@ -92,6 +190,12 @@ QString DQSqliteStatement::columnTypeName(QVariant::Type type) {
 
 QString DQSqliteStatement::columnConstraint(DQClause clause){
     QStringList res;
+    if (clause.testFlag(DQClause::GENERATED)) {
+        res << QString("GENERATED ALWAYS AS (%1) %2")
+               .arg(clause.flag(DQClause::GENERATED).toString())
+               .arg(clause.testFlag(DQClause::STORED) ? "STORED" : "VIRTUAL");
+    }
+
     if (clause.testFlag(DQClause::NOT_NULL)) {
         res << "NOT NULL";
     }
@@ -120,6 +224,31 @@ QString DQSqliteStatement::driverName(){
     return "SQLITE";
 }
 
+QString DQSqliteStatement::listSchema(){
+    return schema();
+}
+
+QString DQSqliteStatement::listColumns(QString table){
+    return tableInfo(table);
+}
+
+QString DQSqliteStatement::listColumns(const DQModelMetaInfo *info){
+    QString schema = boundSchema(info);
+    if (schema.isEmpty())
+        return tableInfo(info->name());
+
+    return QString("PRAGMA %1.table_xinfo(%2)").arg(schema).arg(info->name());
+}
+
 QString DQSqliteStatement::exists(DQModelMetaInfo *info) {
     return QString("SELECT name FROM sqlite_master WHERE type='table' and name ='%1'").arg(info->name());
 }
+
+QString DQSqliteStatement::schema() {
+    return "SELECT type,name,tbl_name FROM sqlite_master WHERE type IN ('table','index')";
+}
+
+QString DQSqliteStatement::tableInfo(QString table) {
+    // table_info leaves out the generated columns
+    return QString("PRAGMA table_xinfo(%1)").arg(table);
+}
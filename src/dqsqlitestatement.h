@@ -20,12 +20,41 @@ public:
 
     virtual QString driverName();
 
+    /// Read the tables and indexes from sqlite_master
+    virtual QString listSchema();
+
+    /// PRAGMA table_xinfo
+    virtual QString listColumns(QString table);
+
+    /// PRAGMA table_xinfo on the bound schema (e.g "PRAGMA archive.table_xinfo(user)")
+    virtual QString listColumns(const DQModelMetaInfo *info);
+
+    /// SQLite can't add a PRIMARY KEY / UNIQUE column , a NOT NULL column without default value or a column with non-constant default value
+    virtual bool canAddColumn(const DQModelMetaInfoField *field);
+
+    /// The index of a table in attached database is qualified by the schema name instead of the table
+    virtual QString createIndexIfNotExists(const DQBaseIndex& index);
+
+    /// FTS5 external content table with the insert / delete / update triggers
+    virtual QStringList createFullTextIndex(DQModelMetaInfo *info);
+
+    /// The FTS5 'rebuild' command
+    virtual QString rebuildFullTextIndex(DQModelMetaInfo *info);
+
     /// Check is a table exist
     static QString exists(DQModelMetaInfo *info);
 
+    /// List all the tables and indexes. The result columns are type , name and tbl_name
+    static QString schema();
+
+    /// List the columns of a table
+    static QString tableInfo(QString table);
+
 protected:
 
-    virtual QString _createTableIfNotExists(DQModelMetaInfo *info);
+    virtual QString _createTableIfNotExists(DQModelMetaInfo *info,QString tableName);
+
+    virtual QString _columnDefinition(const DQModelMetaInfoField *field);
 
 private:
 
@@ -1,27 +1,131 @@
 #include <QStringList>
+#include <QDebug>
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
 
 #include "dqsqlstatement.h"
+#include "dqsqlitestatement.h"
+#include "dqpostgresstatement.h"
 #include "dqexpression.h"
+#include "dqsqlbuilder_p.h"
+
+/* Test cases:
+
+  coretests::statementRegistry()
+  coretests::postgresStatement()
+  coretests::sqlBuilder()
+  sqlitetests::attach()
+
+ */
+
+/// The default no. of bind parameters allowed in a statement
+#ifndef DQ_MAX_BIND_PARAMETERS
+#define DQ_MAX_BIND_PARAMETERS 999
+#endif
+
+static DQSqlStatement* _dqCreateSqliteStatement() {
+    return new DQSqliteStatement();
+}
+
+static DQSqlStatement* _dqCreatePostgresStatement() {
+    return new DQPostgresStatement();
+}
+
+/// The registered statement generators
+static QHash<QString,DQSqlStatementCreateFunc> m_statementRegistry;
+
+/// Guard of m_statementRegistry
+static QMutex m_statementRegistryMutex;
+
+/// Register the built-in generators. The mutex should be locked
+static void _dqInitStatementRegistry() {
+    static bool initialized = false;
+    if (initialized)
+        return;
+    initialized = true;
+
+    m_statementRegistry.insert("QSQLITE",_dqCreateSqliteStatement);
+    m_statementRegistry.insert("QPSQL",_dqCreatePostgresStatement);
+}
 
 DQSqlStatement::DQSqlStatement()
 {
 }
 
+DQSqlStatement::~DQSqlStatement()
+{
+}
+
+void DQSqlStatement::registerStatement(QString driverName,DQSqlStatementCreateFunc func){
+    QMutexLocker locker(&m_statementRegistryMutex);
+    _dqInitStatementRegistry();
+    m_statementRegistry.insert(driverName,func);
+}
+
+DQSqlStatement* DQSqlStatement::create(QString driverName){
+    QMutexLocker locker(&m_statementRegistryMutex);
+    _dqInitStatementRegistry();
+
+    DQSqlStatementCreateFunc func = m_statementRegistry.value(driverName,0);
+    if (!func)
+        return 0;
+
+    return func();
+}
+
+QStringList DQSqlStatement::registeredDrivers(){
+    QMutexLocker locker(&m_statementRegistryMutex);
+    _dqInitStatementRegistry();
+
+    QStringList res = m_statementRegistry.keys();
+    res.sort();
+    return res;
+}
+
+QString DQSqlStatement::listColumns(const DQModelMetaInfo *info){
+    return listColumns(info->name());
+}
+
+bool DQSqlStatement::returnsInsertId(){
+    return false;
+}
+
 QString DQSqlStatement::dropTable(DQModelMetaInfo *info) {
-    QString sql = QString("drop table %1;").arg(info->name());
+    QString sql = QString("drop table %1;").arg(qualifiedName(info));
     return sql;
 }
 
 QString DQSqlStatement::createTableIfNotExists(DQModelMetaInfo *info){
-    return _createTableIfNotExists(info);
+    return _createTableIfNotExists(info,qualifiedName(info));
+}
+
+QString DQSqlStatement::createTableIfNotExists(DQModelMetaInfo *info,QString tableName){
+    return _createTableIfNotExists(info,tableName);
+}
+
+QString DQSqlStatement::renameTable(QString from,QString to){
+    return QString("ALTER TABLE %1 RENAME TO %2;").arg(from).arg(to);
+}
+
+QString DQSqlStatement::addColumn(DQModelMetaInfo *info,int index){
+    return QString("ALTER TABLE %1 ADD COLUMN %2;").arg(qualifiedName(info)).arg(_columnDefinition(info->at(index)));
+}
+
+bool DQSqlStatement::canAddColumn(const DQModelMetaInfoField *field){
+    Q_UNUSED(field);
+    return true;
 }
 
 QString DQSqlStatement::createIndexIfNotExists(const DQBaseIndex& index){
-    QString createIndex = "CREATE INDEX IF NOT EXISTS %1 on %2 (%3);";
+    QString createIndex = "CREATE %1INDEX IF NOT EXISTS %2 on %3 (%4)%5;";
 
-    QString sql = createIndex.arg(index.name())
-                             .arg(index.metaInfo()->name())
-                             .arg(index.columnDefList().join(","));
+    QString sql = createIndex.arg(index.isUnique() ? "UNIQUE " : "")
+                             .arg(index.name())
+                             .arg(qualifiedName(index.metaInfo()))
+                             .arg(index.columnDefList().join(","))
+                             .arg(index.where().isEmpty() ? QString() : " WHERE " + index.where());
 
     return sql;
 }
@@ -34,121 +138,405 @@ QString DQSqlStatement::dropIndexIfExists(QString name){
     return sql;
 }
 
-QString DQSqlStatement::insertInto(DQModelMetaInfo *info,QStringList fields){
-    return _insertInto(info,"INSERT",fields);
+QStringList DQSqlStatement::createFullTextIndex(DQModelMetaInfo *info){
+    Q_UNUSED(info);
+    return QStringList();
 }
 
-QString DQSqlStatement::replaceInto(DQModelMetaInfo *info,QStringList fields){
-    return _insertInto(info,"REPLACE",fields);
+QString DQSqlStatement::rebuildFullTextIndex(DQModelMetaInfo *info){
+    Q_UNUSED(info);
+    return QString();
 }
 
-QString DQSqlStatement::_insertInto(DQModelMetaInfo *info ,QString type, QStringList fields){
-    QString sql,format;
-    QStringList values;
+QString DQSqlStatement::dropFullTextIndex(DQModelMetaInfo *info){
+    return QString("DROP TABLE IF EXISTS %1;").arg(fullTextTable(info->name()));
+}
 
-    format = QString("%4 INTO %1 (%2) values (%3);");
+QString DQSqlStatement::fullTextTable(QString table){
+    return table + "_fts";
+}
+
+QString DQSqlStatement::insertInto(DQModelMetaInfo *info,const QStringList &fields){
+    _DQSqlBuilder builder;
+    _insertInto(builder.sql(),info,"INSERT",fields);
+    return builder.result();
+}
+
+QString DQSqlStatement::replaceInto(DQModelMetaInfo *info,const QStringList &fields){
+    _DQSqlBuilder builder;
+    _insertInto(builder.sql(),info,"REPLACE",fields);
+    return builder.result();
+}
+
+QString DQSqlStatement::upsert(DQModelMetaInfo *info,QStringList fields,QStringList conflictColumns){
+    QString sql;
+    _insertInto(sql,info,"INSERT",fields);
+    sql.chop(1); // Remove the ";"
 
+    QStringList assignments;
     foreach (QString f, fields) {
-        values << ":" + f;
+        if (f == "id" || conflictColumns.contains(f))
+            continue;
+        assignments << QString("%1 = excluded.%1").arg(f);
     }
 
-    sql = format.arg(info->name(), fields.join(","),values.join(",") , type);
+    QString action = "DO NOTHING";
+    if (assignments.size() > 0)
+        action = QString("DO UPDATE SET %1").arg(assignments.join(","));
 
-    return sql;
+    return QString("%1 ON CONFLICT(%2) %3;").arg(sql).arg(conflictColumns.join(",")).arg(action);
+}
+
+QString DQSqlStatement::insertRows(DQModelMetaInfo *info,QStringList fields,int rows){
+    QStringList placeholders;
+    int n = fields.size();
+    for (int i = 0 ; i < n;i++)
+        placeholders << "?";
+
+    QString row = QString("(%1)").arg(placeholders.join(","));
+
+    QStringList values;
+    values.reserve(rows);
+    for (int i = 0 ; i < rows;i++)
+        values << row;
+
+    return QString("INSERT INTO %1 (%2) values %3;").arg(qualifiedName(info), fields.join(","), values.join(","));
+}
+
+QString DQSqlStatement::deleteRows(DQModelMetaInfo *info,int rows){
+    QStringList placeholders;
+    for (int i = 0 ; i < rows;i++)
+        placeholders << "?";
+
+    return QString("DELETE FROM %1 WHERE id IN (%2);").arg(qualifiedName(info)).arg(placeholders.join(","));
+}
+
+int DQSqlStatement::maxBindParameters(){
+    return DQ_MAX_BIND_PARAMETERS;
+}
+
+bool DQSqlStatement::supportsJsonInList(){
+    return true;
+}
+
+QString DQSqlStatement::update(DQModelMetaInfo *info,const QStringList &fields){
+    _DQSqlBuilder builder;
+    QString &sql = builder.sql();
+
+    sql += QLatin1String("UPDATE ");
+    appendQualifiedName(sql,info);
+    sql += QLatin1String(" SET ");
+
+    int n = fields.size();
+    for (int i = 0 ; i < n;i++) {
+        if (i > 0)
+            sql += QLatin1Char(',');
+        const QString &f = fields.at(i);
+        sql += f;
+        sql += QLatin1String(" = :");
+        sql += f;
+    }
+
+    sql += QLatin1String(" WHERE id = :id;");
+
+    return builder.result();
+}
+
+void DQSqlStatement::_insertInto(QString &sql,DQModelMetaInfo *info ,const char *type, const QStringList &fields){
+    sql += QLatin1String(type);
+    sql += QLatin1String(" INTO ");
+    appendQualifiedName(sql,info);
+    sql += QLatin1String(" (");
+    _DQSqlBuilder::appendJoined(sql,fields);
+    sql += QLatin1String(") values (");
+
+    int n = fields.size();
+    for (int i = 0 ; i < n;i++) {
+        if (i > 0)
+            sql += QLatin1Char(',');
+        sql += QLatin1Char(':');
+        sql += fields.at(i);
+    }
+
+    sql += QLatin1String(");");
 }
 
 
-QString DQSqlStatement::select(DQSharedQuery query) {
+QString DQSqlStatement::select(const DQSharedQuery &query) {
     DQQueryRules rules;
     rules =  query;
-    QStringList sql;
 
-    sql << selectCore(rules);
-    if (rules.limit() > 0 ) {
-        sql << limitAndOffset(rules.limit());
+    _DQSqlBuilder builder;
+    QString &sql = builder.sql();
+
+    if (rules.related().size() > 0 && rules.func().isEmpty()) {
+        selectRelated(sql,rules);
+    } else {
+        selectBody(sql,rules);
+    }
+
+    sql += QLatin1String(" ;");
+
+    return builder.result();
+}
+
+void DQSqlStatement::selectBody(QString &sql,const DQQueryRules &rules){
+    selectCore(sql,rules);
+
+    QStringList groupBy = rules.groupBy();
+    if (groupBy.size() > 0) {
+        sql += QLatin1String(" GROUP BY ");
+        _DQSqlBuilder::appendJoined(sql,groupBy);
+    }
+
+    // Without GROUP BY the whole result is a single group
+    DQExpression having = rules.having();
+    if (!having.isNull()) {
+        sql += QLatin1String(" HAVING ");
+        sql += having.string();
     }
 
     if (rules.orderBy().size() > 0) {
-        sql << orderBy(rules);
+        sql += QLatin1Char(' ');
+        orderBy(sql,rules);
     }
 
-    sql << ";";
+    if (rules.limit() > 0 || rules.offset() > 0) {
+        sql += QLatin1Char(' ');
+        limitAndOffset(sql,rules.limit(),rules.offset());
+    }
+}
 
-    return sql.join(" ");
+static inline bool _dqIsIdentifierChar(QChar c) {
+    return c.isLetterOrNumber() || c == '_';
 }
 
-QString DQSqlStatement::deleteFrom(DQSharedQuery query) {
+/// Prefix the field names of model in an ordering term by "m." , e.g "lower(name) desc" => "lower(m.name) desc"
+static void _dqAppendQualifiedTerm(QString &sql,const QString &term,const DQModelMetaInfo *info) {
+    int n = term.size();
+    int i = 0;
+    while (i < n) {
+        QChar c = term.at(i);
+
+        if (c == '\'' || c == '"') {
+            int end = term.indexOf(c,i + 1);
+            if (end < 0)
+                end = n - 1;
+            sql += term.mid(i,end - i + 1);
+            i = end + 1;
+            continue;
+        }
+
+        if (!_dqIsIdentifierChar(c)) {
+            sql += c;
+            i++;
+            continue;
+        }
+
+        int start = i;
+        while (i < n && _dqIsIdentifierChar(term.at(i)))
+            i++;
+        QString word = term.mid(start,i - start);
+
+        // Skip the qualified names , function names and parameters
+        int next = i;
+        while (next < n && term.at(next).isSpace())
+            next++;
+        bool qualified = start > 0 && (term.at(start - 1) == '.' || term.at(start - 1) == ':');
+        bool function = next < n && (term.at(next) == '(' || term.at(next) == '.');
+
+        if (!qualified && !function && !c.isDigit() && info->indexOf(word) >= 0)
+            sql += QLatin1String("m.");
+        sql += word;
+    }
+}
+
+void DQSqlStatement::selectRelated(QString &sql,const DQQueryRules &rules){
+    DQModelMetaInfo *info = rules.metaInfo();
+    QStringList related = rules.related();
+    QVector<DQModelMetaInfo*> targets(related.size(),0);
+
+    sql += QLatin1String("SELECT m.*");
+
+    int n = related.size();
+    for (int i = 0 ; i < n;i++) {
+        const QString &key = related.at(i);
+        DQModelMetaInfo *target = info->linkedMetaInfo(info->indexOf(key));
+        if (!target) {
+            qWarning() << QString("DQSqlStatement::selectRelated() - %1 is not a foreign key of %2").arg(key).arg(info->name());
+            continue;
+        }
+        targets[i] = target;
+
+        int size = target->size();
+        for (int j = 0 ; j < size;j++) {
+            const QString &name = target->at(j)->name;
+            sql += QLatin1String(",r");
+            _DQSqlBuilder::appendNumber(sql,i);
+            sql += QLatin1Char('.');
+            sql += name;
+            sql += QLatin1String(" AS ");
+            sql += key;
+            sql += QLatin1String("__");
+            sql += name;
+        }
+    }
+
+    sql += QLatin1String(" FROM ( ");
+    selectBody(sql,rules);
+    sql += QLatin1String(" ) AS m");
+
+    for (int i = 0 ; i < n;i++) {
+        if (!targets.at(i))
+            continue;
+
+        sql += QLatin1String(" LEFT JOIN ");
+        appendQualifiedName(sql,targets.at(i));
+        sql += QLatin1String(" AS r");
+        _DQSqlBuilder::appendNumber(sql,i);
+        sql += QLatin1String(" ON m.");
+        sql += related.at(i);
+        sql += QLatin1String(" = r");
+        _DQSqlBuilder::appendNumber(sql,i);
+        sql += QLatin1String(".id");
+    }
+
+    /* The ordering of subquery is not guaranteed to be kept. The field
+       names in the terms are qualified by "m" , as the linked tables may
+       have the columns of the same name (e.g "id" , "name").
+     */
+    QStringList terms = rules.orderBy();
+    int size = terms.size();
+    if (size > 0) {
+        sql += QLatin1String(" ORDER BY ");
+        for (int i = 0 ; i < size;i++) {
+            if (i > 0)
+                sql += QLatin1Char(',');
+            _dqAppendQualifiedTerm(sql,terms.at(i),info);
+        }
+    }
+}
+
+QString DQSqlStatement::update(const DQSharedQuery &query,const QStringList &assignments) {
     DQQueryRules rules;
     rules =  query;
-    QStringList sql;
 
-    sql << QString("DELETE FROM %1").arg(rules.metaInfo()->name());
+    _DQSqlBuilder builder;
+    QString &sql = builder.sql();
+
+    sql += QLatin1String("UPDATE ");
+    appendQualifiedName(sql,rules.metaInfo());
+    sql += QLatin1String(" SET ");
+    _DQSqlBuilder::appendJoined(sql,assignments);
 
     DQExpression expression = rules.expression();
     if (!expression.isNull()) {
+        sql += QLatin1String(" WHERE ");
+        sql += expression.string();
+    }
+
+    sql += QLatin1String(" ;");
 
-//        sql << QString("WHERE %1").arg(where.toString());
-        sql << QString("WHERE %1").arg(expression.string());
+    return builder.result();
+}
+
+QString DQSqlStatement::deleteFrom(const DQSharedQuery &query) {
+    DQQueryRules rules;
+    rules =  query;
 
+    _DQSqlBuilder builder;
+    QString &sql = builder.sql();
+
+    sql += QLatin1String("DELETE FROM ");
+    appendQualifiedName(sql,rules.metaInfo());
+
+    DQExpression expression = rules.expression();
+    if (!expression.isNull()) {
+        sql += QLatin1String(" WHERE ");
+        sql += expression.string();
     }
 
     /// @todo Implemente order by
 
     if (rules.limit() > 0) {
-        sql << limitAndOffset(rules.limit());
+        sql += QLatin1Char(' ');
+        limitAndOffset(sql,rules.limit());
     }
 
-    sql << ";";
+    sql += QLatin1String(" ;");
 
-    return sql.join(" ");
+    return builder.result();
 }
 
-QString DQSqlStatement::selectCore(DQQueryRules rules){
-    QStringList res;
-
-    res << QString("SELECT %1 %2 FROM %3").arg("ALL").arg(selectResultColumn(rules)).arg(rules.metaInfo()->name());
+void DQSqlStatement::selectCore(QString &sql,const DQQueryRules &rules){
+    sql += QLatin1String("SELECT ALL ");
+    selectResultColumn(sql,rules);
+    sql += QLatin1String(" FROM ");
+    appendQualifiedName(sql,rules.metaInfo());
 
     DQExpression expression = rules.expression();
     if (!expression.isNull()) {
-//        res << QString("WHERE %1").arg(where.toString());
-        res << QString("WHERE %1").arg(expression.string());
+        sql += QLatin1String(" WHERE ");
+        sql += expression.string();
     }
-
-    return res.join(" ");
 }
 
-QString DQSqlStatement::selectResultColumn(DQQueryRules rules){
-    QString res;
-    QStringList fields = rules.fields();
-    if (fields.size() == 0)
-        res = "*";
-    else
-        res = fields.join(",");
-
-    QString func;
-    func = rules.func();
+void DQSqlStatement::selectResultColumn(QString &sql,const DQQueryRules &rules){
+    QString func = rules.func();
     if (!func.isEmpty()) {
-        res = QString("%1(%2)").arg(func).arg(res);
+        sql += func;
+        sql += QLatin1Char('(');
     }
-    return res;
+
+    QStringList fields = rules.fields();
+    QStringList deferred = rules.deferred();
+    bool empty = fields.isEmpty();
+
+    _DQSqlBuilder::appendJoined(sql,fields);
+
+    if (deferred.size() > 0) {
+        foreach (const QString &column , rules.metaInfo()->columnNameList()) {
+            if (deferred.contains(column))
+                continue;
+            if (!empty)
+                sql += QLatin1Char(',');
+            sql += column;
+            empty = false;
+        }
+    }
+
+    if (empty)
+        sql += QLatin1Char('*');
+
+    if (!func.isEmpty())
+        sql += QLatin1Char(')');
 }
 
-QString DQSqlStatement::limitAndOffset(int limit, int offset) {
-    QStringList res;
-    res << QString("LIMIT %1").arg(limit);
+void DQSqlStatement::limitAndOffset(QString &sql,int limit, int offset) {
+    // OFFSET must follow a LIMIT. Negative value is no limit.
+    sql += QLatin1String("LIMIT ");
+    _DQSqlBuilder::appendNumber(sql,limit > 0 ? limit : -1);
     if (offset > 0) {
-        res << QString("OFFSET %1").arg(offset);
+        sql += QLatin1String(" OFFSET ");
+        _DQSqlBuilder::appendNumber(sql,offset);
     }
-    return res.join(" ");
 }
 
-QString DQSqlStatement::orderBy(DQQueryRules rules){
-    QStringList orderingTerms;
+void DQSqlStatement::orderBy(QString &sql,const DQQueryRules &rules){
+    sql += QLatin1String("ORDER BY ");
+    _DQSqlBuilder::appendJoined(sql,rules.orderBy());
+}
+
+QString DQSqlStatement::savepoint(QString name){
+    return QString("SAVEPOINT %1;").arg(name);
+}
 
-    orderingTerms << "ORDER BY";
-    orderingTerms << rules.orderBy().join(",");
+QString DQSqlStatement::releaseSavepoint(QString name){
+    return QString("RELEASE SAVEPOINT %1;").arg(name);
+}
 
-    return orderingTerms.join(" ");
+QString DQSqlStatement::rollbackToSavepoint(QString name){
+    return QString("ROLLBACK TO SAVEPOINT %1;").arg(name);
 }
 
 QString DQSqlStatement::formatValue(QVariant value,bool trimStrings) {
@@ -175,3 +563,36 @@ QString DQSqlStatement::formatValue(QVariant value,bool trimStrings) {
 
     return res;
 }
+
+void DQSqlStatement::bindSchema(const DQModelMetaInfo *info,QString schema){
+    if (schema.isEmpty())
+        m_schemas.remove(info);
+    else
+        m_schemas.insert(info,schema);
+}
+
+QString DQSqlStatement::boundSchema(const DQModelMetaInfo *info) const{
+    return m_schemas.value(info);
+}
+
+QHash<const DQModelMetaInfo*,QString> DQSqlStatement::schemaBindings() const{
+    return m_schemas;
+}
+
+void DQSqlStatement::appendQualifiedName(QString &sql,const DQModelMetaInfo *info) const{
+    if (!m_schemas.isEmpty()) {
+        QHash<const DQModelMetaInfo*,QString>::const_iterator iter = m_schemas.constFind(info);
+        if (iter != m_schemas.constEnd()) {
+            sql += iter.value();
+            sql += QLatin1Char('.');
+        }
+    }
+    sql += info->name();
+}
+
+QString DQSqlStatement::qualifiedName(const DQModelMetaInfo *info) const{
+    QString schema = m_schemas.value(info);
+    if (schema.isEmpty())
+        return info->name();
+    return schema + "." + info->name();
+}
@@ -2,6 +2,8 @@
 #define DQSQLSTATEMENT_H
 
 #include <QString>
+#include <QStringList>
+#include <QHash>
 
 #include <dqmodelmetainfo.h>
 #include <dqsharedquery.h>
@@ -11,7 +13,26 @@
 class DQSharedQuery;
 class DQQueryRules;
 
+class DQSqlStatement;
+
+/// The factory function of a SQL statement generator
+typedef DQSqlStatement* (*DQSqlStatementCreateFunc)();
+
 /// Sql Statement generator abstract interface
+/**
+  DQConnection picks the generator by the driver name of QSqlDatabase from a
+  registry. DQSqliteStatement ("QSQLITE") and DQPostgresStatement ("QPSQL")
+  are registered by default. Support of other database could be added by
+  a derived class and registerStatement():
+
+\code
+static DQSqlStatement* createMyStatement() {
+    return new MyStatement();
+}
+
+    DQSqlStatement::registerStatement("QMYSQL",createMyStatement);
+\endcode
+ */
 
 class DQSqlStatement
 {
@@ -19,14 +40,56 @@ public:
     /// Default constructor
     DQSqlStatement();
 
+    virtual ~DQSqlStatement();
+
+    /// Register a statement generator for a QtSql driver
+    /**
+      @param driverName The driver name of QSqlDatabase (e.g "QSQLITE")
+      @param func The function to create the generator. The registered one of the same driver is replaced.
+      @threadsafe
+     */
+    static void registerStatement(QString driverName,DQSqlStatementCreateFunc func);
+
+    /// Create the statement generator for a QtSql driver
+    /**
+      @return The generator. It is NULL if the driver is not supported. The caller takes the ownership.
+      @threadsafe
+     */
+    static DQSqlStatement* create(QString driverName);
+
+    /// The driver names with registered statement generator
+    static QStringList registeredDrivers();
+
     /// Get the supported driver name
     virtual QString driverName() = 0;
 
+    /// The statement to list the tables and indexes
+    /**
+      The result columns are "type" ("table" or "index") , "name" and "tbl_name" (The table of an index).
+     */
+    virtual QString listSchema() = 0;
+
+    /// The statement to list the columns of a table. The result should contain a "name" column.
+    virtual QString listColumns(QString table) = 0;
+
+    /// The statement to list the columns of the table of a model in its bound schema
+    /**
+      The default implementation calls listColumns(QString) with the table name ,
+      it is correct for the models in the main database.
+     */
+    virtual QString listColumns(const DQModelMetaInfo *info);
+
+    /// TRUE if the INSERT statements return the id of new record as the result ("RETURNING id")
+    /**
+      Otherwise the id is read by QSqlQuery::lastInsertId().
+     */
+    virtual bool returnsInsertId();
+
     /// "CREATE TABLE IF NOT EXISTS" statement
     template <typename T>
     QString createTableIfNotExists() {
         DQModelMetaInfo *info = dqMetaInfo<T>();
-        return _createTableIfNotExists(info);
+        return _createTableIfNotExists(info,info->name());
     }
 
     /// "CREATE TABLE IF NOT EXISTS" statement
@@ -42,48 +105,186 @@ public:
     /// Drop table statement
     virtual QString dropTable(DQModelMetaInfo *info);
 
+    /// "CREATE TABLE IF NOT EXISTS" statement of a model with other table name
+    /**
+      It is used to rebuild a table.
+     */
+    virtual QString createTableIfNotExists(DQModelMetaInfo *info,QString tableName);
+
+    /// "ALTER TABLE ... RENAME TO" statement
+    virtual QString renameTable(QString from,QString to);
+
+    /// "ALTER TABLE ... ADD COLUMN" statement of a field
+    /**
+      @param info The model
+      @param index The index of field
+     */
+    virtual QString addColumn(DQModelMetaInfo *info,int index);
+
+    /// TRUE if the field could be added to existing table by addColumn()
+    /**
+      Otherwise the table should be rebuilt.
+     */
+    virtual bool canAddColumn(const DQModelMetaInfoField *field);
+
     /// Create index statement
     virtual QString createIndexIfNotExists(const DQBaseIndex& index);
 
     /// Drop the index
     virtual QString dropIndexIfExists(QString name);
 
+    /// The statements to create the full text index of the DQFullText fields and the triggers to maintain it
+    /**
+      @return An empty list if full text search is not supported by the database
+     */
+    virtual QStringList createFullTextIndex(DQModelMetaInfo *info);
+
+    /// The statement to rebuild the full text index from the content of table
+    virtual QString rebuildFullTextIndex(DQModelMetaInfo *info);
+
+    /// The statement to drop the full text index. The triggers are dropped with the table.
+    virtual QString dropFullTextIndex(DQModelMetaInfo *info);
+
+    /// The name of full text index table of a table
+    static QString fullTextTable(QString table);
+
     /// Insert into statement
     /**
       @param with_id TRUE if the "id" field should be included.
      */
-    virtual QString insertInto(DQModelMetaInfo *info,QStringList fields);
+    virtual QString insertInto(DQModelMetaInfo *info,const QStringList &fields);
 
     /// Replace into statement
     /**
       @param with_id TRUE if the "id" field should be included.
      */
-    virtual QString replaceInto(DQModelMetaInfo *info,QStringList fields);
+    virtual QString replaceInto(DQModelMetaInfo *info,const QStringList &fields);
+
+    /// "INSERT ... ON CONFLICT DO UPDATE" statement
+    /**
+      Insert a record. If it violates the uniqueness of conflictColumns , the existing
+      record is updated by the other fields instead. Unlike "REPLACE", the
+      row is not deleted, so its id and the index entries of unchanged columns are kept.
+
+      @param info The meta information of writing model
+      @param fields A list of fields that should be saved
+      @param conflictColumns The columns of a UNIQUE / PRIMARY KEY constraint
+     */
+    virtual QString upsert(DQModelMetaInfo *info,QStringList fields,QStringList conflictColumns);
+
+    /// Multi-row "INSERT INTO ... VALUES (..),(..)" statement
+    /**
+      The values are bound by position ("?") , row by row in the order of fields.
+
+      @param info The meta information of writing model
+      @param fields A list of fields that should be saved. It must not be empty.
+      @param rows No. of rows inserted by the statement
+     */
+    virtual QString insertRows(DQModelMetaInfo *info,QStringList fields,int rows);
+
+    /// "DELETE FROM ... WHERE id IN (?,?,..)" statement
+    /**
+      The ids are bound by position.
+      @param rows No. of ids in the statement
+     */
+    virtual QString deleteRows(DQModelMetaInfo *info,int rows);
+
+    /// The max no. of bind parameters of a statement
+    /**
+      It limits the no. of rows written by insertRows(). The default value is 999 ,
+      the limit of SQLite before 3.32.
+     */
+    virtual int maxBindParameters();
+
+    /// TRUE if a long DQWhere::in() list could be bound as a single JSON array and expanded by json_each()
+    virtual bool supportsJsonInList();
+
+    /// "UPDATE" statement of a record
+    /**
+      The record is matched by the "id" field. The value of fields and id should be bound by the field name (e.g :field).
+     */
+    virtual QString update(DQModelMetaInfo *info,const QStringList &fields);
 
     /// Select statement
-    virtual QString select(DQSharedQuery query);
+    virtual QString select(const DQSharedQuery &query);
+
+    /// "UPDATE" statement of the records matched by a query
+    /**
+      @param query The query. Its filter is used as the WHERE clause
+      @param assignments The assignment terms in form of "field = expression"
+     */
+    virtual QString update(const DQSharedQuery &query,const QStringList &assignments);
 
     /// Delete from statement
-    virtual QString deleteFrom(DQSharedQuery query);
+    virtual QString deleteFrom(const DQSharedQuery &query);
+
+    /// Create a savepoint with the name
+    virtual QString savepoint(QString name);
+
+    /// Release (commit) the savepoint
+    virtual QString releaseSavepoint(QString name);
+
+    /// Rollback to the savepoint. Only the changes after the savepoint is discarded, it is not released.
+    virtual QString rollbackToSavepoint(QString name);
 
     /// Returns a string representation of the QVariant for SQL statement
     virtual QString formatValue(QVariant value,bool trimStrings = false);
 
+    /// Bind the table of a model to a schema (e.g an attached database)
+    /**
+      The table name in the generated statements is qualified by the schema (e.g "archive.user").
+
+      @param schema The schema name. An empty string remove the binding.
+      @see DQConnection::bindSchema()
+     */
+    void bindSchema(const DQModelMetaInfo *info,QString schema);
+
+    /// The schema bound to the table of a model. It is empty for the main database
+    QString boundSchema(const DQModelMetaInfo *info) const;
+
+    /// All the schema bindings
+    QHash<const DQModelMetaInfo*,QString> schemaBindings() const;
+
+    /// The table name of a model qualified by its bound schema
+    QString qualifiedName(const DQModelMetaInfo *info) const;
+
 protected:
     /// The real function for create table if not exists
-    virtual QString _createTableIfNotExists(DQModelMetaInfo *info) = 0;
+    virtual QString _createTableIfNotExists(DQModelMetaInfo *info,QString tableName) = 0;
+
+    /// The column definition of a field used by addColumn()
+    virtual QString _columnDefinition(const DQModelMetaInfoField *field) = 0;
+
+    /* The statements are built by appending to a reusable buffer. The
+       functions below append their clause to "sql" instead of returning it ,
+       so no intermediate string is created.
+     */
 
     /// The real function for "insert into / replace into" statement
-    virtual QString _insertInto(DQModelMetaInfo *info ,QString type, QStringList fields);
+    /**
+      @param type "INSERT" or "REPLACE"
+     */
+    virtual void _insertInto(QString &sql,DQModelMetaInfo *info ,const char *type, const QStringList &fields);
+
+    /// The select statement without ";" , before the LEFT JOIN of related()
+    virtual void selectBody(QString &sql,const DQQueryRules &rules);
+
+    virtual void selectCore(QString &sql,const DQQueryRules &rules);
+
+    virtual void selectResultColumn(QString &sql,const DQQueryRules &rules);
 
-    virtual QString selectCore(DQQueryRules rules);
+    virtual void limitAndOffset(QString &sql,int limit, int offset = 0);
 
-    virtual QString selectResultColumn(DQQueryRules rules);
+    virtual void orderBy(QString &sql,const DQQueryRules &rules);
 
-    virtual QString limitAndOffset(int limit, int offset = 0);
+    /// Wrap the select statement of selectBody() by LEFT JOIN with the "linked" tables of DQQueryRules::related()
+    virtual void selectRelated(QString &sql,const DQQueryRules &rules);
 
-    virtual QString orderBy(DQQueryRules rules);
+    /// Append the table name of a model qualified by its bound schema
+    void appendQualifiedName(QString &sql,const DQModelMetaInfo *info) const;
 
+private:
+    QHash<const DQModelMetaInfo*,QString> m_schemas;
 };
 
 
@@ -0,0 +1,59 @@
+#include <QtCore>
+#include <QTimer>
+#include "dqstatsreporter.h"
+
+/* Test cases:
+
+  sqlitetests::connectionStats()
+
+ */
+
+DQStatsReporter::DQStatsReporter(DQConnection connection,int interval,QObject *parent) :
+    QObject(parent) , m_connection(connection) , m_exactRowCount(false) {
+    qRegisterMetaType<DQConnectionStats>();
+
+    m_timer = new QTimer(this);
+    m_timer->setInterval(interval);
+    connect(m_timer,SIGNAL(timeout()),this,SLOT(report()));
+    m_timer->start();
+}
+
+void DQStatsReporter::setPath(const QString &path){
+    m_path = path;
+}
+
+QString DQStatsReporter::path() const{
+    return m_path;
+}
+
+void DQStatsReporter::setExactRowCount(bool exact){
+    m_exactRowCount = exact;
+}
+
+DQConnectionStats DQStatsReporter::lastStats() const{
+    return m_lastStats;
+}
+
+void DQStatsReporter::report(){
+    if (!m_connection.isOpen())
+        return;
+
+    m_lastStats = m_connection.stats(m_exactRowCount);
+
+    if (!m_path.isEmpty()) {
+        // Written to a temporary file and then renamed , so the reader never see a partial file
+        QString tmp = m_path + ".tmp";
+        QFile file(tmp);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            file.write(m_lastStats.toText().toUtf8());
+            file.close();
+            QFile::remove(m_path);
+            if (!QFile::rename(tmp,m_path))
+                qWarning() << QString("DQStatsReporter::report() - Failed to rename %1").arg(tmp);
+        } else {
+            qWarning() << QString("DQStatsReporter::report() - Failed to write %1 : %2").arg(tmp).arg(file.errorString());
+        }
+    }
+
+    emit reported(m_lastStats);
+}
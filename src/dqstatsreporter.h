@@ -0,0 +1,65 @@
+#ifndef DQSTATSREPORTER_H
+#define DQSTATSREPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <dqconnection.h>
+#include <dqconnectionstats.h>
+
+class QTimer;
+
+/// Collect the stats of a connection periodically
+/**
+  The stats are collected by the event loop of the reporter's thread , which
+  must be the thread of the connection. On every interval the reported()
+  signal is emitted , and if a path is set , DQConnectionStats::toText() is
+  written to the file. The file is replaced by rename , a scraper never reads
+  a partial file.
+
+\code
+    DQStatsReporter *reporter = new DQStatsReporter(connection,60000,this);
+    reporter->setPath("/var/lib/node_exporter/dquest.prom");
+\endcode
+ */
+class DQStatsReporter : public QObject
+{
+    Q_OBJECT
+public:
+    /// Start to report the stats of a connection
+    /**
+      @param interval The interval in msecs
+     */
+    DQStatsReporter(DQConnection connection,int interval,QObject *parent = 0);
+
+    /// Set the file written on each report. Empty path disables the file.
+    void setPath(const QString &path);
+
+    /// The file written on each report
+    QString path() const;
+
+    /// Set TRUE to count the rows of all tables on each report. It is FALSE by default.
+    /**
+      @see DQConnection::stats()
+     */
+    void setExactRowCount(bool exact);
+
+    /// The last reported stats
+    DQConnectionStats lastStats() const;
+
+public slots:
+    /// Collect and report the stats now
+    void report();
+
+signals:
+    /// The stats are collected
+    void reported(DQConnectionStats stats);
+
+private:
+    DQConnection m_connection;
+    QTimer *m_timer;
+    QString m_path;
+    bool m_exactRowCount;
+    DQConnectionStats m_lastStats;
+};
+
+#endif // DQSTATSREPORTER_H
@@ -0,0 +1,35 @@
+#include "dqtransaction.h"
+
+DQTransaction::DQTransaction(DQConnection connection) : m_connection(connection)
+{
+    m_active = m_connection.transaction();
+}
+
+DQTransaction::~DQTransaction()
+{
+    if (m_active)
+        rollback();
+}
+
+bool DQTransaction::commit(){
+    if (!m_active)
+        return false;
+
+    bool res = m_connection.commit();
+    if (res)
+        m_active = false;
+
+    return res;
+}
+
+bool DQTransaction::rollback(){
+    if (!m_active)
+        return false;
+
+    m_active = false;
+    return m_connection.rollback();
+}
+
+bool DQTransaction::isActive() const {
+    return m_active;
+}
@@ -0,0 +1,59 @@
+#ifndef DQTRANSACTION_H
+#define DQTRANSACTION_H
+
+#include <dqconnection.h>
+
+/// A scope guard of database transaction
+/**
+  DQTransaction begins a transaction on the connection when it is
+  constructed. If commit() is not called before it is destroyed, the
+  transaction will be rolled back automatically.
+
+  Transactions could be nested. The inner DQTransaction is implemented by
+  SAVEPOINT, rollback of it will only discard the changes made within its
+  own scope.
+
+  Example:
+
+\code
+    DQTransaction transaction(connection);
+
+    user.save();
+    config.save();
+
+    if (!transaction.commit()) {
+        // Error handling
+    }
+
+    // Or leave the scope without commit() to rollback the changes
+\endcode
+
+  @see DQConnection::transaction()
+ */
+
+class DQTransaction
+{
+public:
+    /// Begin a transaction on the connection
+    explicit DQTransaction(DQConnection connection = DQConnection::defaultConnection());
+
+    /// Rollback the transaction if it is not committed
+    ~DQTransaction();
+
+    /// Commit the transaction
+    bool commit();
+
+    /// Rollback the transaction
+    bool rollback();
+
+    /// Returns TRUE if the transaction is started and not finished yet.
+    bool isActive() const;
+
+private:
+    Q_DISABLE_COPY(DQTransaction)
+
+    DQConnection m_connection;
+    bool m_active;
+};
+
+#endif // DQTRANSACTION_H
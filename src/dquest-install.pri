@@ -6,4 +6,4 @@ QT += sql
 
 QMAKE_CXXFLAGS += -Wno-invalid-offsetof
 
-LIBS += -L$$PWD/../../lib/dquest -ldquest
+LIBS += -L$$PWD/../../lib/dquest -ldquest -lsqlite3
@@ -4,6 +4,24 @@
 /* DQuest general header file*/
 #include <dqmodel.h>
 #include <dqlistwriter.h>
+#include <dqbulkwriter.h>
 #include <dqstream.h>
+#include <dqtransaction.h>
+#include <dqcursor.h>
+#include <dqconnectionpool.h>
+#include <dqshardedconnection.h>
+#include <dqconnectionoptions.h>
+#include <dqmaintenanceoptions.h>
+#include <dqretrypolicy.h>
+#include <dqcolumnarresult.h>
+#include <dqevaluator.h>
+#include <dqquerystats.h>
+#include <dqconnectionstats.h>
+#include <dqstatsreporter.h>
+#include <dqqueryplan.h>
+#include <dqindexadvisor.h>
+#include <dqblobstream.h>
+#include <dqserializer.h>
+#include <dqchangenotifier.h>
 
 #endif // DQUEST_H
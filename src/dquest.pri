@@ -2,6 +2,20 @@ INCLUDEPATH += $$PWD
 DEPENDPATH += $$PWD
 QT += sql
 
+# DQBlobStream , the busy handler , SQL functions , change notification , backup
+# and the other native features call the SQLite C API on the handle of QSQLITE
+# driver. It requires the driver linked to the same SQLite library as DQuest
+# (e.g Qt configured with -system-sqlite). Add "CONFIG += dquest_sqlite_api" to
+# enable them , otherwise the plain SQL code paths are used.
+dquest_sqlite_api {
+    DEFINES += DQ_SQLITE_API
+    LIBS += -lsqlite3
+}
+
+# Uncomment if the SQLite library is built with SQLITE_ENABLE_SNAPSHOT (requires dquest_sqlite_api).
+# DQConnection::snapshot() could then share a snapshot between connections.
+# DEFINES += SQLITE_ENABLE_SNAPSHOT
+
 QMAKE_CXXFLAGS += -Wno-invalid-offsetof
 
 DQUEST_HEADERS += \
@@ -9,9 +23,14 @@ DQUEST_HEADERS += \
     $$PWD/dqmodelmetainfo.h \
     $$PWD/dqmodel.h \
     $$PWD/dqconnection.h \
+    $$PWD/dqconnectionoptions.h \
+    $$PWD/dqretrypolicy.h \
+    $$PWD/dqmaintenanceoptions.h \
+    $$PWD/dqshardedconnection.h \
     $$PWD/dqbasefield.h \
     $$PWD/dqsqlstatement.h \
     $$PWD/dqsqlitestatement.h \
+    $$PWD/dqpostgresstatement.h \
     $$PWD/dqwhere.h \
     $$PWD/dqsql.h \
     $$PWD/dqfield.h \
@@ -26,12 +45,40 @@ DQUEST_HEADERS += \
     $$PWD/dqindex.h \
     $$PWD/dqstream.h \
     $$PWD/dqlistwriter.h \
+    $$PWD/dqbulkwriter.h \
+    $$PWD/dqchangenotifier.h \
+    $$PWD/dqtransaction.h \
+    $$PWD/dqcursor.h \
+    $$PWD/dqconnectionpool.h \
+    $$PWD/dqcolumnarresult.h \
+    $$PWD/dqevaluator.h \
+    $$PWD/dqquerystats.h \
+    $$PWD/dqconnectionstats.h \
+    $$PWD/dqstatsreporter.h \
+    $$PWD/dqqueryplan.h \
+    $$PWD/dqindexadvisor.h \
+    $$PWD/dqblobstream.h \
+    $$PWD/dqserializer.h \
     $$PWD/dquest.h
 
 DQUEST_PRIV_HEADERS = \
     $$PWD/dqwhere_p.h \
     $$PWD/dqsharedquery_p.h \
-    $$PWD/dqmetainfoquery_p.h
+    $$PWD/dqmetainfoquery_p.h \
+    $$PWD/dqclonethread_p.h \
+    $$PWD/dqasyncworker_p.h \
+    $$PWD/dqwritebehind_p.h \
+    $$PWD/dqwriterthread_p.h \
+    $$PWD/dqpersister_p.h \
+    $$PWD/dqsqlfunction_p.h \
+    $$PWD/dqprofiler_p.h \
+    $$PWD/dqmaintenance_p.h \
+    $$PWD/dqcheckpointer_p.h \
+    $$PWD/dqbusyhandler_p.h \
+    $$PWD/dqfieldprofile_p.h \
+    $$PWD/dqsqlite_p.h \
+    $$PWD/dqchangehook_p.h \
+    $$PWD/dqsqlbuilder_p.h
 
 HEADERS += $$DQUEST_HEADERS
 HEADERS += $$DQUEST_PRIV_HEADERS
@@ -41,9 +88,15 @@ SOURCES += \
     $$PWD/dqmodelmetainfo.cpp \
     $$PWD/dqmodel.cpp \
     $$PWD/dqconnection.cpp \
+    $$PWD/dqconnectionoptions.cpp \
+    $$PWD/dqretrypolicy.cpp \
+    $$PWD/dqmaintenanceoptions.cpp \
+    $$PWD/dqshardedconnection.cpp \
     $$PWD/dqbasefield.cpp \
     $$PWD/dqsqlstatement.cpp \
+    $$PWD/dqsqlbuilder.cpp \
     $$PWD/dqsqlitestatement.cpp \
+    $$PWD/dqpostgresstatement.cpp \
     $$PWD/dqwhere.cpp \
     $$PWD/dqsql.cpp \
     $$PWD/dqfield.cpp \
@@ -54,4 +107,28 @@ SOURCES += \
     $$PWD/dqsharedlist.cpp \
     $$PWD/dqindex.cpp \
     $$PWD/dqstream.cpp \
-    $$PWD/dqlistwriter.cpp
+    $$PWD/dqlistwriter.cpp \
+    $$PWD/dqbulkwriter.cpp \
+    $$PWD/dqchangenotifier.cpp \
+    $$PWD/dqtransaction.cpp \
+    $$PWD/dqconnectionpool.cpp \
+    $$PWD/dqcolumnarresult.cpp \
+    $$PWD/dqevaluator.cpp \
+    $$PWD/dqclonethread.cpp \
+    $$PWD/dqasyncworker.cpp \
+    $$PWD/dqwritebehind.cpp \
+    $$PWD/dqwriterthread.cpp \
+    $$PWD/dqpersister.cpp \
+    $$PWD/dqsqlfunction.cpp \
+    $$PWD/dqquerystats.cpp \
+    $$PWD/dqconnectionstats.cpp \
+    $$PWD/dqstatsreporter.cpp \
+    $$PWD/dqqueryplan.cpp \
+    $$PWD/dqindexadvisor.cpp \
+    $$PWD/dqblobstream.cpp \
+    $$PWD/dqserializer.cpp \
+    $$PWD/dqprofiler.cpp \
+    $$PWD/dqmaintenance.cpp \
+    $$PWD/dqcheckpointer.cpp \
+    $$PWD/dqbusyhandler.cpp \
+    $$PWD/dqfieldprofile.cpp
@@ -1,12 +1,16 @@
 #include <QtCore>
 #include "dqwhere.h"
 #include "dqwhere_p.h"
+#include "dqsharedquery.h"
+#include "dqsharedquery_p.h"
 
 /* Test cases:
 
   coretests::where()
 
   sqlitetests::querySelectWhere()
+  sqlitetests::subquery()
+  sqlitetests::fullText()
 
  */
 
@@ -38,6 +42,30 @@ DQWhereDataPriv::Type DQWhereDataPriv::type(){
     return m_type;
 }
 
+QString DQWhereDataPriv::text(){
+    return m_text;
+}
+
+void DQWhereDataPriv::setText(QString text){
+    m_text = text;
+}
+
+QStringList DQWhereDataPriv::names(){
+    return m_names;
+}
+
+void DQWhereDataPriv::setNames(QStringList names){
+    m_names = names;
+}
+
+QStringList DQWhereDataPriv::tables(){
+    return m_tables;
+}
+
+void DQWhereDataPriv::setTables(QStringList tables){
+    m_tables = tables;
+}
+
 /// A private datastructure to represent the database field in DQWhere
 class DQWhereFieldPriv : public QString {
 };
@@ -217,11 +245,11 @@ DQWhere DQWhere::operator!=(QVariant right){
 }
 
 DQWhere DQWhere::operator+(QVariant right){
-    return expr("*",right);
+    return expr("+",right);
 }
 
 DQWhere DQWhere::operator-(QVariant right){
-    return expr("*",right);
+    return expr("-",right);
 }
 
 DQWhere DQWhere::operator*(QVariant right){
@@ -271,6 +299,85 @@ DQWhere DQWhere::notIn (QList<QVariant> list) {
     return expr("not in",v);
 }
 
+DQWhere DQWhere::in(DQSharedQuery query){
+    return expr("in",subquery(query,true));
+}
+
+DQWhere DQWhere::notIn(DQSharedQuery query){
+    return expr("not in",subquery(query,true));
+}
+
+DQWhere DQWhere::exists(DQSharedQuery query){
+    return unary("exists",subquery(query,false));
+}
+
+DQWhere DQWhere::notExists(DQSharedQuery query){
+    return unary("not exists",subquery(query,false));
+}
+
+QVariant DQWhere::subquery(DQSharedQuery query,bool singleColumn){
+    DQWhereDataPriv data(DQWhereDataPriv::Subquery);
+
+    if (!query.data->metaInfo) {
+        qWarning() << "DQWhere::subquery() - The subquery has no model";
+        QVariant v;
+        v.setValue<DQWhereDataPriv>(data);
+        return v;
+    }
+
+    if (singleColumn && query.data->fields.isEmpty() && query.data->func.isEmpty())
+        query = query.select("id");
+
+    QString sql = query.statement().trimmed();
+    if (sql.endsWith(';'))
+        sql.chop(1);
+    data.setText(sql.trimmed());
+
+    QStringList names;
+    QList<QVariant> values;
+    QStringList tables;
+    tables << query.data->metaInfo->name();
+
+    DQExpression* expressions[] = { &query.data->expression , &query.data->having };
+    for (int e = 0 ; e < 2 ; e++) {
+        DQExpression& expression = *expressions[e];
+        names << expression.bindNames();
+        values << expression.bindValueList();
+        tables << expression.tables();
+    }
+
+    data.setNames(names);
+    data.setList(values);
+    data.setTables(tables);
+
+    QVariant v;
+    v.setValue<DQWhereDataPriv>(data);
+    return v;
+}
+
+DQWhere DQWhere::match(QString query){
+    DQWhereDataPriv data(DQWhereDataPriv::Match);
+    data << query;
+    QVariant v;
+    v.setValue<DQWhereDataPriv>(data);
+
+    return DQWhere("id").expr("in",v);
+}
+
+DQWhere DQWhere::match(QString field,QString query){
+    return match(QString("{%1} : (%2)").arg(field).arg(query));
+}
+
+DQWhere DQWhere::unary(QString op,QVariant right){
+    DQWhere w;
+
+    w.m_right = right;
+    w.m_op = op;
+    w.m_isNull = false;
+
+    return w;
+}
+
 DQWhere DQWhere::like (QVariant other){
     return expr("like",other);
 }
@@ -3,6 +3,8 @@
 
 #include <QVariant>
 
+class DQSharedQuery;
+
 /// The filter rules
 /**
    The DQWhere object represent an expression / rules in query for filter the result
@@ -174,11 +176,80 @@ public:
     DQWhere between(QVariant v1,QVariant v2);
 
     /// Return a DQWhere object which is the expression of "this in (list)"
+    /**
+      Each value is bound as a separated parameter. A list longer than
+      DQ_IN_LIST_THRESHOLD (64 by default) is bound as a single JSON array
+      and expanded by "json_each()" of SQLite instead, so the statement
+      keeps the same shape (and stays in the statement cache) regardless of
+      the no. of values , and it is not limited by the max. no. of parameters.
+
+      @remarks The JSON array is not used if the list contains a QByteArray or user type value , or the
+      driver do not have json_each() (DQSqlStatement::supportsJsonInList() , e.g QPSQL).
+     */
     DQWhere in (QList<QVariant> list);
 
     /// Return a DQWhere object which is the expression of "this not in (list)"
     DQWhere notIn (QList<QVariant> list);
 
+    /// Return a DQWhere object which is the expression of "this in (subquery)"
+    /**
+      The SQL of the subquery is embedded in the statement and its bound values
+      are merged , so the filtering is done by the database in a single statement.
+      The subquery should select a single field. "id" is selected if none is given.
+
+\code
+    // The users who have a friend
+    DQQuery<User> query = DQQuery<User>().filter(DQWhere("id").in(DQQuery<Friendship>().select("a")));
+\endcode
+
+      @remarks The statement of the subquery is generated on this call. Later changes of the query are not applied.
+     */
+    DQWhere in (DQSharedQuery query);
+
+    /// Return a DQWhere object which is the expression of "this not in (subquery)"
+    DQWhere notIn (DQSharedQuery query);
+
+    /// Return a DQWhere object which is the expression of "exists (subquery)"
+    /**
+      A correlated subquery could refer the field of outer query by table name:
+
+\code
+    DQWhere where = DQWhere::exists(DQQuery<Friendship>().filter(DQWhere("a") == DQWhere("user.id")));
+\endcode
+     */
+    static DQWhere exists(DQSharedQuery query);
+
+    /// Return a DQWhere object which is the expression of "not exists (subquery)"
+    static DQWhere notExists(DQSharedQuery query);
+
+    /// Return a DQWhere object which select the records matched by a full text query
+    /**
+      The fields declared with DQFullText are searched by the FTS5 index created by
+      DQConnection::createTables(). The expression is compiled to a lookup of the
+      index instead of a scan of the table:
+
+\code
+    id in (SELECT rowid FROM article_fts WHERE article_fts MATCH :arg0)
+\endcode
+
+      The query uses the FTS5 syntax (e.g "sqlite AND (index OR search*)").
+
+\code
+    DQQuery<Article> query = DQQuery<Article>().filter(DQWhere::match("sqlite"))
+                                               .orderByRank("sqlite");
+\endcode
+
+      @remarks The table is resolved by the query which the expression is passed to by DQSharedQuery::filter()
+      @see DQSharedQuery::orderByRank()
+     */
+    static DQWhere match(QString query);
+
+    /// Return a DQWhere object which select the records with a field matched by a full text query
+    /**
+      It is equal to match("{field} : (query)") , which is restricted to a single field.
+     */
+    static DQWhere match(QString field,QString query);
+
     /// Return a DQWhere object which is the expression of "this" "like"  "v"
     DQWhere like (QVariant other);
 
@@ -195,6 +266,12 @@ public:
     operator QVariant() const;
 
 private:
+    /// Wrap the statement and bound values of a subquery as an operand
+    static QVariant subquery(DQSharedQuery query,bool singleColumn);
+
+    /// Form an expression without left operand (e.g "exists (subquery)")
+    static DQWhere unary(QString op,QVariant right);
+
     /// left Operand
     QVariant m_left;
 
@@ -2,6 +2,7 @@
 #define DQWHERE_P_H
 
 #include <QVariant>
+#include <QStringList>
 
 /// A private database structure used by DQWhere & DQExpression
 /** It is used to store the data for special operator.
@@ -13,7 +14,9 @@ public:
     enum Type {
         None,
         In,
-        Between
+        Between,
+        Subquery,
+        Match
     };
 
     DQWhereDataPriv();
@@ -28,9 +31,28 @@ public:
 
     Type type();
 
+    /// The SQL statement of subquery
+    QString text();
+
+    void setText(QString text);
+
+    /// The placeholders of subquery in the order of list()
+    QStringList names();
+
+    void setNames(QStringList names);
+
+    /// The tables read by subquery
+    QStringList tables();
+
+    void setTables(QStringList tables);
+
 private:
     QList<QVariant> m_list;
     Type m_type;
+
+    QString m_text;
+    QStringList m_names;
+    QStringList m_tables;
 };
 
 Q_DECLARE_METATYPE(DQWhereDataPriv)
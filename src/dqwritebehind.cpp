@@ -0,0 +1,202 @@
+#include <QtCore>
+#include "dqwritebehind_p.h"
+#include "dqmodel.h"
+#include "dqsharedlist.h"
+#include "dqsql.h"
+
+/* Test cases:
+
+  sqlitetests::writeBehind()
+
+ */
+
+static inline int _dqLoad(QAtomicInt &value) {
+#if QT_VERSION >= 0x050000
+    return value.loadAcquire();
+#else
+    return value;
+#endif
+}
+
+static inline _DQWriteNode* _dqLoad(QAtomicPointer<_DQWriteNode> &value) {
+#if QT_VERSION >= 0x050000
+    return value.loadAcquire();
+#else
+    return value;
+#endif
+}
+
+_DQWriteBehind::_DQWriteBehind(DQConnection* base,int batchSize,int window,int capacity) :
+    _DQCloneThread(base,"dqwritebehind","write-behind writer") ,
+    m_batchSize(batchSize) , m_window(window) , m_capacity(capacity) ,
+    m_head(0) , m_flushRequested(false) , m_flushWaiters(0) , m_failures(0) {
+
+    if (m_batchSize <= 0)
+        m_batchSize = 1;
+    if (m_capacity < m_batchSize)
+        m_capacity = m_batchSize;
+
+    startClone();
+}
+
+_DQWriteBehind::~_DQWriteBehind(){
+    stopClone(); // The pending rows are written before the thread is finished
+}
+
+void _DQWriteBehind::stopping(){
+    m_done.wakeAll();
+}
+
+void _DQWriteBehind::enqueue(DQModel* model,bool forceInsert,bool forceAllField){
+    if (_dqLoad(m_queued) - _dqLoad(m_written) >= m_capacity) {
+        // Back-pressure. Wait until the writer make some room
+        QMutexLocker locker(&m_mutex);
+        m_flushRequested = true;
+        m_wake.wakeAll();
+        while (!m_stop && _dqLoad(m_queued) - _dqLoad(m_written) >= m_capacity)
+            m_done.wait(&m_mutex);
+    }
+
+    _DQWriteNode* node = new _DQWriteNode();
+    node->model = model;
+    node->forceInsert = forceInsert;
+    node->forceAllField = forceAllField;
+
+    // Counted before the row is published , so the writer never sees more rows than queued
+    int queued = m_queued.fetchAndAddOrdered(1) + 1;
+
+    do {
+        node->next = _dqLoad(m_head);
+    } while (!m_head.testAndSetOrdered(node->next,node));
+
+    /* The writer tests pending() with the mutex locked , so the wake up is not lost.
+       A waiter of waitForFlush() may have counted the row before it is published ,
+       the writer could have drained the stack without it , so it is flushed again.
+     */
+    bool waiting = _dqLoad(m_flushWaiters) > 0;
+    if (waiting || queued - _dqLoad(m_written) >= m_batchSize) {
+        QMutexLocker locker(&m_mutex);
+        if (waiting)
+            m_flushRequested = true;
+        m_wake.wakeAll();
+    }
+}
+
+void _DQWriteBehind::flush(){
+    QMutexLocker locker(&m_mutex);
+    m_flushRequested = true;
+    m_wake.wakeAll();
+}
+
+bool _DQWriteBehind::waitForFlush(QSet<QString> &tables){
+    // Registered before the target is read , the rows counted in target will wake up the writer again
+    m_flushWaiters.fetchAndAddOrdered(1);
+    int target = _dqLoad(m_queued);
+
+    QMutexLocker locker(&m_mutex);
+    m_flushRequested = true;
+    m_wake.wakeAll();
+
+    while (!m_stop && _dqLoad(m_written) - target < 0)
+        m_done.wait(&m_mutex);
+
+    m_flushWaiters.fetchAndAddOrdered(-1);
+
+    tables = m_tables;
+    m_tables.clear();
+
+    bool res = m_failures == 0;
+    m_failures = 0;
+    return res;
+}
+
+int _DQWriteBehind::pending(){
+    return _dqLoad(m_queued) - _dqLoad(m_written);
+}
+
+void _DQWriteBehind::process(){
+    m_mutex.lock();
+    while (!m_stop) {
+        if (!m_flushRequested && pending() < m_batchSize) {
+            if (m_window > 0)
+                m_wake.wait(&m_mutex,m_window);
+            else
+                m_wake.wait(&m_mutex);
+        }
+        m_flushRequested = false;
+        m_mutex.unlock();
+
+        drain();
+
+        m_mutex.lock();
+    }
+    m_mutex.unlock();
+
+    drain();
+
+    m_mutex.lock();
+    m_done.wakeAll();
+    m_mutex.unlock();
+}
+
+void _DQWriteBehind::drain(){
+    _DQWriteNode* node = m_head.fetchAndStoreOrdered(0);
+    if (!node) {
+        // The waiters re-check their target after every pass
+        m_mutex.lock();
+        m_done.wakeAll();
+        m_mutex.unlock();
+        return;
+    }
+
+    // The stack is in LIFO order
+    _DQWriteNode* list = 0;
+    while (node) {
+        _DQWriteNode* next = node->next;
+        node->next = list;
+        list = node;
+        node = next;
+    }
+
+    int count = 0;
+    int failures = 0;
+    QSet<QString> tables;
+
+    while (list) {
+        // The consecutive rows of the same type and options are written by a single call
+        DQSharedList batch;
+        DQModelMetaInfo* metaInfo = list->model->metaInfo();
+        DQSharedList::BulkOptions options;
+        options.forceInsert = list->forceInsert;
+        options.forceAllField = list->forceAllField;
+        options.updateId = false; // Nobody could read the copy
+        options.batchSize = m_batchSize;
+
+        while (list && list->model->metaInfo() == metaInfo &&
+               list->forceInsert == options.forceInsert &&
+               list->forceAllField == options.forceAllField) {
+            _DQWriteNode* next = list->next;
+            list->model->setConnection(m_connection);
+            if (!batch.append(list->model))
+                delete list->model;
+            delete list;
+            list = next;
+            count++;
+        }
+
+        tables << metaInfo->name();
+
+        if (!batch.saveAll(options)) {
+            qWarning() << QString("DQConnection - Failed to write %1 rows to %2 in write-behind mode")
+                          .arg(batch.size()).arg(metaInfo->name());
+            failures++;
+        }
+    }
+
+    m_mutex.lock();
+    m_written.fetchAndAddOrdered(count);
+    m_failures += failures;
+    m_tables.unite(tables);
+    m_done.wakeAll();
+    m_mutex.unlock();
+}
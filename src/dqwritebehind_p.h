@@ -0,0 +1,95 @@
+#ifndef DQWRITEBEHIND_P_H
+#define DQWRITEBEHIND_P_H
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QSet>
+#include "dqclonethread_p.h"
+
+class DQModel;
+
+/// A model queued by _DQWriteBehind
+class _DQWriteNode {
+public:
+    /// The copy of the saving model. It is owned by the node until written
+    DQModel* model;
+
+    bool forceInsert;
+    bool forceAllField;
+
+    _DQWriteNode* next;
+};
+
+/// The background writer of a connection in write-behind mode
+/**
+  The saving models are pushed to a lock-free stack by any number of
+  producers. The writer thread takes the whole stack at once and writes it
+  in FIFO order with DQSharedList::saveAll() , so every batch costs a
+  single transaction.
+
+  The batch is written when the no. of pending rows reach the batch size ,
+  flush() is called or the time window is elapsed, whichever comes first.
+  The producer is blocked if the no. of pending rows reach the capacity.
+
+  The writer owns a clone of the connection's database (_DQCloneThread).
+ */
+class _DQWriteBehind : public _DQCloneThread {
+public:
+    /// Start the writer. It blocks until the database is cloned.
+    _DQWriteBehind(DQConnection* base,int batchSize,int window,int capacity);
+
+    /// Write all the pending rows and stop the writer
+    ~_DQWriteBehind();
+
+    /// Queue a copy of the model. The ownership is taken.
+    void enqueue(DQModel* model,bool forceInsert,bool forceAllField);
+
+    /// Wake up the writer to write the pending rows now
+    void flush();
+
+    /// Block until all the rows queued before the call are written
+    /**
+      @param tables Return the tables written since last call
+      @return TRUE if no write is failed since last call
+     */
+    bool waitForFlush(QSet<QString> &tables);
+
+    /// No. of rows queued but not written yet
+    int pending();
+
+protected:
+    void process();
+
+    void stopping();
+
+private:
+    /// Take all the queued rows and write them
+    void drain();
+
+    int m_batchSize;
+    int m_window;
+    int m_capacity;
+
+    /// Top of the lock-free stack of queued rows
+    QAtomicPointer<_DQWriteNode> m_head;
+
+    QAtomicInt m_queued;
+    QAtomicInt m_written;
+
+    /// Notify the waiting producers that some rows are written
+    QWaitCondition m_done;
+
+    /// TRUE if the writer should write the pending rows without waiting. Guarded by m_mutex
+    bool m_flushRequested;
+
+    /// No. of threads blocked in waitForFlush()
+    QAtomicInt m_flushWaiters;
+
+    /// No. of failed write since last waitForFlush()
+    int m_failures;
+
+    /// The tables written but not reported by waitForFlush()
+    QSet<QString> m_tables;
+};
+
+#endif // DQWRITEBEHIND_P_H
@@ -0,0 +1,293 @@
+#include <QtCore>
+#include "dqwriterthread_p.h"
+#include "dqmodel.h"
+#include "dqsql.h"
+
+/* Test cases:
+
+  sqlitetests::readWriteSplit()
+
+ */
+
+/// DQModel::save() by the writer
+class _DQSaveJob : public _DQWriterJob {
+public:
+    DQModel* model;
+    bool forceInsert;
+    bool forceAllField;
+
+    /// TRUE if the model is inserted as a new record
+    bool inserted;
+
+    virtual void run(DQConnection connection) {
+        inserted = forceInsert || model->id->isNull();
+
+        DQConnection original = model->connection();
+        model->setConnection(connection);
+        ok = model->save(forceInsert,forceAllField);
+        model->setConnection(original);
+
+        rows = ok ? 1 : 0;
+    }
+
+    virtual void abort() {
+        if (inserted)
+            model->id->clear();
+        model->metaInfo()->setDirty(model,true);
+    }
+};
+
+/// DQSharedList::saveAll() by the writer
+class _DQSaveAllJob : public _DQWriterJob {
+public:
+    DQSharedList list;
+    DQSharedList::BulkOptions options;
+
+    /// The models inserted as new records
+    QList<DQModel*> inserted;
+
+    /// The ids of inserted models before writing
+    QVariantList ids;
+
+    virtual void run(DQConnection connection) {
+        int n = list.size();
+        QList<DQConnection> originals;
+        for (int i = 0 ; i < n ; i++) {
+            DQModel* model = static_cast<DQModel*>(list.at(i));
+            if (options.forceInsert || model->id->isNull()) {
+                inserted << model;
+                ids << model->id.get();
+            }
+            originals << model->connection();
+            model->setConnection(connection);
+        }
+
+        ok = list.saveAll(options);
+
+        for (int i = 0 ; i < n ; i++)
+            static_cast<DQModel*>(list.at(i))->setConnection(originals.at(i));
+
+        rows = ok ? n : 0;
+    }
+
+    virtual void abort() {
+        for (int i = 0 ; i < inserted.size() ; i++)
+            inserted.at(i)->id.set(ids.at(i));
+
+        int n = list.size();
+        for (int i = 0 ; i < n ; i++) {
+            DQModel* model = static_cast<DQModel*>(list.at(i));
+            model->metaInfo()->setDirty(model,true);
+        }
+    }
+};
+
+/// DQSharedList::removeAll() by the writer
+class _DQRemoveAllJob : public _DQWriterJob {
+public:
+    DQSharedList list;
+
+    /// The ids before removal
+    QVariantList ids;
+
+    virtual void run(DQConnection connection) {
+        int n = list.size();
+        QList<DQConnection> originals;
+        for (int i = 0 ; i < n ; i++) {
+            DQModel* model = static_cast<DQModel*>(list.at(i));
+            ids << model->id.get();
+            originals << model->connection();
+            model->setConnection(connection);
+        }
+
+        ok = list.removeAll();
+
+        for (int i = 0 ; i < n ; i++)
+            static_cast<DQModel*>(list.at(i))->setConnection(originals.at(i));
+
+        rows = ok ? n : 0;
+    }
+
+    virtual void abort() {
+        int n = list.size();
+        for (int i = 0 ; i < n ; i++)
+            static_cast<DQModel*>(list.at(i))->id.set(ids.at(i));
+    }
+};
+
+/// DQSharedQuery::remove() by the writer
+class _DQRemoveJob : public _DQWriterJob {
+public:
+    DQSharedQuery query;
+
+    /// The error of the executed query
+    QSqlError error;
+
+    virtual void run(DQConnection connection) {
+        Q_UNUSED(connection);
+        ok = query.remove();
+        rows = ok ? query.lastQuery().numRowsAffected() : 0;
+        error = query.lastError();
+        query.reset(); // The result is released by the writer thread
+    }
+};
+
+/// DQSharedQuery::update() by the writer
+class _DQUpdateJob : public _DQWriterJob {
+public:
+    DQSharedQuery query;
+    QVariantMap assignments;
+
+    /// The error of the executed query
+    QSqlError error;
+
+    virtual void run(DQConnection connection) {
+        Q_UNUSED(connection);
+        rows = query.update(assignments);
+        ok = rows >= 0;
+        error = query.lastError();
+        query.reset();
+    }
+};
+
+_DQWriterThread::_DQWriterThread(DQConnection* base,int batchSize) :
+    _DQCloneThread(base,"dqwriter","writer") , m_batchSize(batchSize) , m_transactions(0) {
+
+    if (m_batchSize <= 0)
+        m_batchSize = 1;
+
+    startClone();
+}
+
+_DQWriterThread::~_DQWriterThread(){
+    stopClone(); // The queued jobs are run before the thread is finished
+}
+
+bool _DQWriterThread::save(DQModel* model,bool forceInsert,bool forceAllField){
+    _DQSaveJob job;
+    job.model = model;
+    job.forceInsert = forceInsert;
+    job.forceAllField = forceAllField;
+    job.inserted = false;
+    submit(&job);
+    return job.ok;
+}
+
+bool _DQWriterThread::saveAll(DQSharedList list,DQSharedList::BulkOptions options){
+    _DQSaveAllJob job;
+    job.list = list;
+    job.options = options;
+    submit(&job);
+    return job.ok;
+}
+
+bool _DQWriterThread::removeAll(DQSharedList list){
+    _DQRemoveAllJob job;
+    job.list = list;
+    submit(&job);
+    return job.ok;
+}
+
+int _DQWriterThread::remove(DQSharedQuery query,QSqlError* error){
+    _DQRemoveJob job;
+    job.query = query;
+    submit(&job);
+    if (error)
+        *error = job.error;
+    return job.ok ? job.rows : -1;
+}
+
+int _DQWriterThread::update(DQSharedQuery query,QVariantMap assignments,QSqlError* error){
+    _DQUpdateJob job;
+    job.query = query;
+    job.assignments = assignments;
+    submit(&job);
+    if (error)
+        *error = job.error;
+    return job.ok ? job.rows : -1;
+}
+
+int _DQWriterThread::transactions(){
+    QMutexLocker locker(&m_mutex);
+    return m_transactions;
+}
+
+void _DQWriterThread::submit(_DQWriterJob* job){
+    QMutexLocker locker(&m_mutex);
+    if (m_stop) {
+        qWarning() << "DQConnection - The writer is stopped";
+        return;
+    }
+
+    m_queue << job;
+    m_wake.wakeAll();
+
+    while (!job->done)
+        m_done.wait(&m_mutex);
+}
+
+void _DQWriterThread::process(){
+    m_mutex.lock();
+    while (!m_stop || !m_queue.isEmpty()) {
+        if (m_queue.isEmpty()) {
+            m_wake.wait(&m_mutex);
+            continue;
+        }
+
+        // The jobs queued during the last transaction are committed together
+        QList<_DQWriterJob*> jobs = m_queue.mid(0,m_batchSize);
+        m_queue = m_queue.mid(jobs.size());
+        m_mutex.unlock();
+
+        runGroup(jobs);
+
+        m_mutex.lock();
+        foreach (_DQWriterJob* job , jobs)
+            job->done = true;
+        m_done.wakeAll();
+    }
+    m_mutex.unlock();
+}
+
+void _DQWriterThread::runGroup(const QList<_DQWriterJob*> &jobs){
+    if (!m_connection.isOpen())
+        return;
+
+    DQSql sql = m_connection.sql();
+
+    if (!sql.transaction()) {
+        // Run the jobs one by one
+        foreach (_DQWriterJob* job , jobs)
+            job->run(m_connection);
+        return;
+    }
+
+    foreach (_DQWriterJob* job , jobs) {
+        if (!sql.transaction()) {
+            job->ok = false;
+            continue;
+        }
+
+        job->run(m_connection);
+
+        if (job->ok)
+            job->ok = sql.commit();
+        if (!job->ok)
+            sql.rollback();
+    }
+
+    if (!sql.commit()) {
+        qWarning() << QString("DQConnection - Failed to commit %1 write operations").arg(jobs.size());
+        sql.rollback();
+        foreach (_DQWriterJob* job , jobs) {
+            if (job->ok)
+                job->abort();
+            job->ok = false;
+            job->rows = 0;
+        }
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_transactions++;
+}
@@ -0,0 +1,108 @@
+#ifndef DQWRITERTHREAD_P_H
+#define DQWRITERTHREAD_P_H
+
+#include <QList>
+#include <QVariant>
+#include "dqclonethread_p.h"
+#include "dqsharedlist.h"
+#include "dqsharedquery.h"
+
+class DQModel;
+
+/// A write operation run by _DQWriterThread
+class _DQWriterJob {
+public:
+    _DQWriterJob() : done(false) , ok(false) , rows(0) {
+    }
+
+    virtual ~_DQWriterJob() {
+    }
+
+    /// Run the operation by the connection of writer
+    virtual void run(DQConnection connection) = 0;
+
+    /// Restore the state of the models if the transaction of the job is failed to commit
+    virtual void abort() {
+    }
+
+    /// TRUE if the job is finished
+    bool done;
+
+    /// TRUE if the job is succeeded and committed
+    bool ok;
+
+    /// No. of rows written
+    int rows;
+};
+
+/// The single writer of a connection in read / write split mode
+/**
+  The write operations of all the threads are queued and run by the writer
+  thread in FIFO order. The caller is blocked until its operation is committed ,
+  so the result (and the generated id) is the same as a direct write.
+
+  The jobs queued while the writer is busy are run in a single transaction
+  (group commit). Every job is wrapped by a SAVEPOINT , a failed job does not
+  roll back the others of the group.
+
+  The writer owns a clone of the connection's database (_DQCloneThread).
+ */
+class _DQWriterThread : public _DQCloneThread {
+public:
+    /// Start the writer. It blocks until the database is cloned.
+    /**
+      @param batchSize The max. no. of jobs in a transaction
+     */
+    _DQWriterThread(DQConnection* base,int batchSize);
+
+    /// Run the queued jobs and stop the writer
+    ~_DQWriterThread();
+
+    /// Save a model by the writer
+    bool save(DQModel* model,bool forceInsert,bool forceAllField);
+
+    /// Run DQSharedList::saveAll() by the writer
+    bool saveAll(DQSharedList list,DQSharedList::BulkOptions options);
+
+    /// Run DQSharedList::removeAll() by the writer
+    bool removeAll(DQSharedList list);
+
+    /// Run DQSharedQuery::remove() by the writer
+    /**
+      @param query A copy of the query for the connection of writer
+      @param error If it is not null , it is set to the error of the executed query
+      @return No. of rows removed. -1 if it is failed
+     */
+    int remove(DQSharedQuery query,QSqlError* error = 0);
+
+    /// Run DQSharedQuery::update() by the writer
+    /**
+      @param query A copy of the query for the connection of writer
+      @param error If it is not null , it is set to the error of the executed query
+     */
+    int update(DQSharedQuery query,QVariantMap assignments,QSqlError* error = 0);
+
+    /// No. of transactions committed by the writer
+    int transactions();
+
+protected:
+    void process();
+
+private:
+    /// Queue a job and block until it is finished
+    void submit(_DQWriterJob* job);
+
+    /// Run a group of jobs in a transaction
+    void runGroup(const QList<_DQWriterJob*> &jobs);
+
+    int m_batchSize;
+
+    QList<_DQWriterJob*> m_queue;
+
+    /// Notify the callers that some jobs are finished
+    QWaitCondition m_done;
+
+    int m_transactions;
+};
+
+#endif // DQWRITERTHREAD_P_H
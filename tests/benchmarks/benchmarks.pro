@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# Benchmarks of the ORM hot paths
+#
+#-------------------------------------------------
+
+QT       += core
+QT       += testlib
+QT       -= gui
+
+TARGET = benchmarks
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += main.cpp \
+    ormbenchmarks.cpp
+
+HEADERS += \
+    ormbenchmarks.h
+
+include (../../src/dquest.pri)
+include(../models/models.pri)
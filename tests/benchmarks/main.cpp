@@ -0,0 +1,12 @@
+#include <QCoreApplication>
+#include <QtTest/QtTest>
+#include "ormbenchmarks.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    OrmBenchmarks benchmarks;
+
+    return QTest::qExec(&benchmarks,argc,argv);
+}
@@ -0,0 +1,208 @@
+#include "ormbenchmarks.h"
+
+/* Benchmarks:
+
+  saveSingle()
+  saveBulk()
+  hydrate()
+  count()
+  call()
+  whereCompile()
+  foreignKeyDereference()
+  listWriterFill()
+
+ */
+
+/// No. of rows used by count() / call()
+#define AGGREGATE_ROWS 100000
+
+/// No. of rows written per batch by fill()
+#define FILL_BATCH 10000
+
+OrmBenchmarks::OrmBenchmarks(QObject* parent) : QObject(parent)
+{
+}
+
+void OrmBenchmarks::initTestCase(){
+    QFile::remove("benchmarks.db");
+
+    db = QSqlDatabase::addDatabase("QSQLITE");
+    db.setDatabaseName( "benchmarks.db" );
+
+    QVERIFY( db.open() );
+    QVERIFY( connect.open(db) );
+
+    QVERIFY( connect.addModel<HealthCheck>() );
+    QVERIFY( connect.addModel<User>() );
+    QVERIFY( connect.addModel<ExamResult>() );
+    QVERIFY( connect.createTables() );
+}
+
+void OrmBenchmarks::cleanupTestCase(){
+    connect.dropTables();
+    connect.close();
+    db.close();
+    QFile::remove("benchmarks.db");
+}
+
+bool OrmBenchmarks::fill(int rows){
+    DQQuery<HealthCheck> query;
+    if (query.count() == rows)
+        return true;
+
+    if (!query.remove())
+        return false;
+
+    DQSharedList::BulkOptions options;
+    options.updateId = false;
+
+    int i = 0;
+    while (i < rows) {
+        DQList<HealthCheck> list;
+        int n = qMin(FILL_BATCH , rows - i);
+        for (int j = 0 ; j < n;j++,i++) {
+            HealthCheck *record = new HealthCheck();
+            record->name = QString("Tester %1").arg(i);
+            record->height = 100 + i % 100;
+            record->weight = 40 + i % 80;
+            record->recordDate = QDate(2014,1,1).addDays(i % 365);
+            list.append(record);
+        }
+
+        if (!list.saveAll(options))
+            return false;
+    }
+
+    return true;
+}
+
+void OrmBenchmarks::saveSingle(){
+    QVERIFY(DQQuery<HealthCheck>().remove());
+
+    int i = 0;
+    QBENCHMARK {
+        HealthCheck record;
+        record.name = QString("Tester %1").arg(i);
+        record.height = 100 + i % 100;
+        record.weight = 40 + i % 80;
+        i++;
+        record.save();
+    }
+}
+
+void OrmBenchmarks::saveBulk_data(){
+    QTest::addColumn<int>("rows");
+
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+}
+
+void OrmBenchmarks::saveBulk(){
+    QFETCH(int,rows);
+
+    // New models are inserted on every iteration. Creating them is cheap compared to the writes
+    QBENCHMARK {
+        DQList<HealthCheck> list;
+        for (int i = 0 ; i < rows;i++) {
+            HealthCheck *record = new HealthCheck();
+            record->name = QString("Tester %1").arg(i);
+            record->height = 100 + i % 100;
+            record->weight = 40 + i % 80;
+            list.append(record);
+        }
+
+        QVERIFY(list.save());
+    }
+
+    QVERIFY(DQQuery<HealthCheck>().remove());
+}
+
+void OrmBenchmarks::hydrate_data(){
+    QTest::addColumn<int>("rows");
+
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void OrmBenchmarks::hydrate(){
+    QFETCH(int,rows);
+    QVERIFY(fill(rows));
+
+    DQQuery<HealthCheck> query;
+    QBENCHMARK {
+        DQList<HealthCheck> list = query.all();
+        QCOMPARE(list.size() , rows);
+    }
+}
+
+void OrmBenchmarks::count(){
+    QVERIFY(fill(AGGREGATE_ROWS));
+
+    DQQuery<HealthCheck> query = DQQuery<HealthCheck>().filter(DQWhere("height") > 150);
+    QBENCHMARK {
+        query.count();
+    }
+}
+
+void OrmBenchmarks::call(){
+    QVERIFY(fill(AGGREGATE_ROWS));
+
+    DQQuery<HealthCheck> query;
+    QBENCHMARK {
+        query.call("max","weight");
+    }
+}
+
+void OrmBenchmarks::whereCompile(){
+    QBENCHMARK {
+        DQWhere where = (DQWhere("height") > 150 && DQWhere("weight") < 100) ||
+                        DQWhere("name") == "Tester 1";
+        DQExpression expression(where);
+        expression.string();
+    }
+}
+
+void OrmBenchmarks::foreignKeyDereference(){
+    int rows = 1000;
+
+    User user;
+    user.userId = "benchmark";
+    user.name = "Benchmark";
+    user.passwd = "benchmark-passwd";
+    QVERIFY(user.save());
+
+    DQList<ExamResult> results;
+    for (int i = 0 ; i < rows;i++) {
+        ExamResult *result = new ExamResult();
+        result->uid = user;
+        result->subject = QString("Subject %1").arg(i % 10);
+        result->mark = i % 100;
+        results.append(result);
+    }
+    QVERIFY(results.saveAll());
+
+    DQQuery<ExamResult> query;
+    QBENCHMARK {
+        DQList<ExamResult> list = query.all();
+        int n = list.size();
+        for (int i = 0 ; i < n;i++) {
+            list.at(i)->uid->name.get();
+        }
+    }
+
+    QVERIFY(query.remove());
+    QVERIFY(user.remove());
+}
+
+void OrmBenchmarks::listWriterFill(){
+    int rows = 1000;
+
+    QBENCHMARK {
+        DQList<HealthCheck> list;
+        DQListWriter writer(&list);
+        for (int i = 0 ; i < rows;i++) {
+            writer << "Tester" << 100 + i % 100 << 40 + i % 80 << writer.next();
+        }
+    }
+}
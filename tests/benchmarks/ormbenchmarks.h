@@ -0,0 +1,68 @@
+#ifndef ORMBENCHMARKS_H
+#define ORMBENCHMARKS_H
+
+#include <QObject>
+#include <QtCore/QString>
+#include <QtTest/QtTest>
+#include <QSqlDatabase>
+#include <dqconnection.h>
+#include <dqquery.h>
+#include <dqlistwriter.h>
+#include <dqexpression.h>
+
+#include "user.h"
+#include "misc.h"
+
+/// The benchmarks of ORM hot paths
+/**
+  The results are reported by QTestLib. Use its output options for a
+  machine-readable report , e.g "benchmarks -o result.xml,xml" (Qt 5) or
+  "benchmarks -xml -o result.xml" (Qt 4).
+ */
+
+class OrmBenchmarks : public QObject
+{
+    Q_OBJECT
+
+public:
+    OrmBenchmarks(QObject* parent = 0);
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    /// DQModel::save() of a new record
+    void saveSingle();
+
+    /// DQSharedList::save() of new records
+    void saveBulk_data();
+    void saveBulk();
+
+    /// DQQuery::all() hydration
+    void hydrate_data();
+    void hydrate();
+
+    /// DQQuery::count()
+    void count();
+
+    /// DQQuery::call()
+    void call();
+
+    /// DQWhere to SQL expression
+    void whereCompile();
+
+    /// Dereference of DQForeignKey
+    void foreignKeyDereference();
+
+    /// DQListWriter fill
+    void listWriterFill();
+
+private:
+    /// Make the healthcheck table contains exactly the no. of rows
+    bool fill(int rows);
+
+    QSqlDatabase db;
+    DQConnection connect;
+};
+
+#endif // ORMBENCHMARKS_H
@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# Concurrent read / write benchmarks
+#
+#-------------------------------------------------
+
+QT       += core
+QT       += testlib
+QT       -= gui
+
+TARGET = concurrency
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += main.cpp \
+    concurrencybenchmarks.cpp
+
+HEADERS += \
+    concurrencybenchmarks.h
+
+include (../../src/dquest.pri)
+include(../models/models.pri)
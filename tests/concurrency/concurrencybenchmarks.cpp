@@ -0,0 +1,269 @@
+#include <algorithm>
+#include "concurrencybenchmarks.h"
+
+/* Benchmarks:
+
+  mixedLoad()
+
+ */
+
+/// No. of records looked up by the readers
+#define LOOKUP_ROWS 1000
+
+/// The interval of passive checkpoint run by the main thread in msecs
+#define CHECKPOINT_INTERVAL 200
+
+/// The default duration of a row in msecs
+#define DEFAULT_DURATION 2000
+
+/// A reader or writer thread working on its own clone of the connection
+class ConcurrencyWorker : public QThread {
+public:
+    ConcurrencyWorker(DQConnection *base,bool writer,int id,int duration) :
+        failures(0) , retries(0) , busyTime(0) ,
+        m_base(base) , m_writer(writer) , m_id(id) , m_duration(duration) {
+    }
+
+    /// The latency of each operation in microseconds
+    QVector<qint64> latencies;
+
+    int failures;
+    int retries;
+    qint64 busyTime;
+
+protected:
+    void run() {
+        QString name = QString("concurrency_worker_%1").arg(m_id);
+        {
+            DQConnection connection = m_base->clone(name);
+            if (!connection.isOpen()) {
+                failures++;
+                return;
+            }
+            QSqlDatabase db = connection.sql().database();
+
+            QElapsedTimer clock;
+            QElapsedTimer op;
+            clock.start();
+
+            for (int i = 0 ; clock.elapsed() < m_duration;i++) {
+                bool ok;
+                op.start();
+                if (m_writer) {
+                    HealthCheck record;
+                    record.setConnection(connection);
+                    record.name = QString("Writer %1").arg(m_id);
+                    record.height = 100 + i % 100;
+                    record.weight = 40 + i % 80;
+                    ok = record.save();
+                } else {
+                    DQQuery<HealthCheck> query(connection);
+                    ok = query.filter(DQWhere("id") == 1 + (i * 7 + m_id) % LOOKUP_ROWS).all().size() == 1;
+                }
+                latencies << op.nsecsElapsed() / 1000;
+                if (!ok)
+                    failures++;
+            }
+
+            foreach (DQQueryStats stats , connection.busyStats()) {
+                retries += stats.retries;
+                busyTime += stats.busyTime;
+            }
+
+            connection.close();
+            connection = DQConnection();
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(name);
+    }
+
+private:
+    DQConnection *m_base;
+    bool m_writer;
+    int m_id;
+    int m_duration;
+};
+
+/// The latency at a quantile of sorted latencies
+static qint64 percentile(const QVector<qint64> &sorted,double q){
+    if (sorted.isEmpty())
+        return 0;
+    int index = qMin(sorted.size() - 1 , (int) (q * sorted.size()));
+    return sorted.at(index);
+}
+
+/// Format the throughput and latencies of a kind of operation
+static QString summary(QVector<qint64> latencies,int duration){
+    std::sort(latencies.begin(),latencies.end());
+    return QString("%1 ops/s p50 %2 p99 %3 p999 %4 us")
+            .arg((qint64) latencies.size() * 1000 / qMax(duration,1))
+            .arg(percentile(latencies,0.5))
+            .arg(percentile(latencies,0.99))
+            .arg(percentile(latencies,0.999));
+}
+
+ConcurrencyBenchmarks::ConcurrencyBenchmarks(QObject* parent) : QObject(parent)
+{
+}
+
+void ConcurrencyBenchmarks::cleanupTestCase(){
+    close();
+}
+
+bool ConcurrencyBenchmarks::open(const QString &mode){
+    close();
+
+    DQConnectionOptions options;
+    if (mode == "file" || mode == "split") {
+        QFile::remove("concurrency.db");
+        db = QSqlDatabase::addDatabase("QSQLITE","concurrency");
+        db.setDatabaseName("concurrency.db");
+        if (!db.open())
+            return false;
+
+        options = DQConnectionOptions::profile("balanced");
+        options.retryPolicy = DQRetryPolicy(10000);
+        if (!connect.open(db,options))
+            return false;
+    } else {
+        options.retryPolicy = DQRetryPolicy(10000);
+        if (!connect.openInMemory(QString(),0,options))
+            return false;
+    }
+
+    if (!connect.addModel<HealthCheck>() || !connect.createTables())
+        return false;
+
+    DQList<HealthCheck> list;
+    for (int i = 0 ; i < LOOKUP_ROWS;i++) {
+        HealthCheck *record = new HealthCheck();
+        record->setConnection(connect);
+        record->name = QString("Lookup %1").arg(i);
+        record->height = 100 + i % 100;
+        list.append(record);
+    }
+
+    if (!list.saveAll())
+        return false;
+
+    // The writes of the clones are funneled to the writer thread
+    if (mode == "split") {
+        connect.setReadWriteSplitEnabled(true);
+        if (!connect.isReadWriteSplitEnabled())
+            return false;
+    }
+
+    return true;
+}
+
+void ConcurrencyBenchmarks::close(){
+    if (connect.isOpen()) {
+        connect.setReadWriteSplitEnabled(false);
+        connect.close();
+    }
+
+    if (db.isValid()) {
+        db.close();
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase("concurrency");
+    }
+
+    QFile::remove("concurrency.db");
+    QFile::remove("concurrency.db-wal");
+    QFile::remove("concurrency.db-shm");
+}
+
+void ConcurrencyBenchmarks::mixedLoad_data(){
+    QTest::addColumn<QString>("mode");
+    QTest::addColumn<int>("readers");
+    QTest::addColumn<int>("writers");
+
+    QList<QPair<int,int> > mixes;
+    mixes << qMakePair(0,1) << qMakePair(0,4) << qMakePair(1,1) << qMakePair(4,1)
+          << qMakePair(8,1) << qMakePair(8,2) << qMakePair(16,4);
+
+#if QT_VERSION >= 0x050E00
+    QStringList extra = QString(qgetenv("DQUEST_BENCH_MIX")).split(",",Qt::SkipEmptyParts);
+#else
+    QStringList extra = QString(qgetenv("DQUEST_BENCH_MIX")).split(",",QString::SkipEmptyParts);
+#endif
+    foreach (QString mix , extra) {
+        QStringList pair = mix.split(":");
+        if (pair.size() == 2)
+            mixes << qMakePair(pair.at(0).toInt(),pair.at(1).toInt());
+    }
+
+    QStringList modes;
+    modes << "file" << "split" << "memory";
+    foreach (QString mode , modes) {
+        for (int i = 0 ; i < mixes.size();i++) {
+            QString name = QString("%1-%2r%3w").arg(mode).arg(mixes.at(i).first).arg(mixes.at(i).second);
+            QTest::newRow(name.toLatin1().constData()) << mode << mixes.at(i).first << mixes.at(i).second;
+        }
+    }
+}
+
+void ConcurrencyBenchmarks::mixedLoad(){
+    QFETCH(QString,mode);
+    QFETCH(int,readers);
+    QFETCH(int,writers);
+
+    int duration = qgetenv("DQUEST_BENCH_DURATION").toInt();
+    if (duration <= 0)
+        duration = DEFAULT_DURATION;
+
+    QVERIFY(open(mode));
+
+    QList<ConcurrencyWorker*> workers;
+    for (int i = 0 ; i < readers + writers;i++) {
+        workers << new ConcurrencyWorker(&connect,i >= readers,i,duration);
+    }
+
+    foreach (ConcurrencyWorker *worker , workers) {
+        worker->start();
+    }
+
+    // Checkpoint while the workers are running , and sample the size of WAL
+    qint64 walPeak = 0;
+    foreach (ConcurrencyWorker *worker , workers) {
+        while (!worker->wait(CHECKPOINT_INTERVAL)) {
+            walPeak = qMax(walPeak,connect.walSize());
+            if (mode != "memory")
+                connect.checkpoint(DQConnection::PassiveCheckpoint);
+        }
+    }
+    walPeak = qMax(walPeak,connect.walSize());
+
+    QVector<qint64> reads;
+    QVector<qint64> writes;
+    int failures = 0;
+    int retries = 0;
+    qint64 busyTime = 0;
+    foreach (ConcurrencyWorker *worker , workers) {
+        if (workers.indexOf(worker) >= readers)
+            writes += worker->latencies;
+        else
+            reads += worker->latencies;
+        failures += worker->failures;
+        retries += worker->retries;
+        busyTime += worker->busyTime;
+        delete worker;
+    }
+
+    DQQueryStats checkpoints = connect.checkpointStats();
+
+    QString line = QString("%1 %2r/%3w : read %4 | write %5 | retries %6 busy %7 ms failures %8 | "
+                           "checkpoints %9 max %10 ms | wal peak %11 bytes")
+            .arg(mode).arg(readers).arg(writers)
+            .arg(summary(reads,duration))
+            .arg(summary(writes,duration))
+            .arg(retries).arg(busyTime / 1000).arg(failures)
+            .arg(checkpoints.calls).arg(checkpoints.maxTime / 1000)
+            .arg(walPeak);
+    qDebug() << qPrintable(line);
+
+    QVERIFY(writes.size() > 0 || writers == 0);
+    QVERIFY(reads.size() > 0 || readers == 0);
+
+    close();
+}
@@ -0,0 +1,69 @@
+#ifndef CONCURRENCYBENCHMARKS_H
+#define CONCURRENCYBENCHMARKS_H
+
+#include <QObject>
+#include <QtCore/QString>
+#include <QtTest/QtTest>
+#include <QSqlDatabase>
+#include <dqconnection.h>
+#include <dqquery.h>
+#include <dqsql.h>
+
+#include "misc.h"
+
+/// The concurrent read / write benchmarks
+/**
+  Each row runs a mix of reader and writer threads for a fixed duration. Every
+  thread works on its own clone of a connection , like the connections of
+  DQConnectionPool. The writers insert HealthCheck records and the readers
+  look up records by id. The row is run on a WAL file database (the
+  "balanced" profile) , on the same file database with the read / write
+  split enabled ("split" , the writes are funneled to the writer thread of
+  DQConnection::setReadWriteSplitEnabled()) and on an in-memory database
+  shared by the "memdb" VFS.
+
+  A line is printed per row:
+
+\code
+    file 8r/2w : read 41250 ops/s p50 95 p99 410 p999 2300 us | write 3100 ops/s p50 210 p99 1900 p999 15000 us |
+                 retries 42 busy 310 ms failures 0 | checkpoints 10 max 12 ms | wal peak 4128768 bytes
+\endcode
+
+  The main thread runs a passive checkpoint every CHECKPOINT_INTERVAL msecs
+  while the workers are running. The longest checkpoint and the peak WAL
+  size show whether the checkpoints could keep up with the writers.
+
+  The environment variables:
+
+  <ul>
+  <li> DQUEST_BENCH_DURATION - The duration of a row in msecs. The default value is 2000 </li>
+  <li> DQUEST_BENCH_MIX - Extra mixes of readers:writers separated by comma , e.g "16:4,32:8" </li>
+  </ul>
+
+  Run a single row by its name , e.g "concurrency mixedLoad:file-8r2w".
+ */
+class ConcurrencyBenchmarks : public QObject
+{
+    Q_OBJECT
+
+public:
+    ConcurrencyBenchmarks(QObject* parent = 0);
+
+private Q_SLOTS:
+    void cleanupTestCase();
+
+    /// Readers and writers on clones of a connection
+    void mixedLoad_data();
+    void mixedLoad();
+
+private:
+    /// Open the connection on a file , a split or an in-memory database with the records looked up by the readers
+    bool open(const QString &mode);
+
+    void close();
+
+    QSqlDatabase db;
+    DQConnection connect;
+};
+
+#endif // CONCURRENCYBENCHMARKS_H
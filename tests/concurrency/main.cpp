@@ -0,0 +1,12 @@
+#include <QCoreApplication>
+#include <QtTest/QtTest>
+#include "concurrencybenchmarks.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    ConcurrencyBenchmarks benchmarks;
+
+    return QTest::qExec(&benchmarks,argc,argv);
+}
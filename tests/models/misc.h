@@ -69,6 +69,95 @@ DQ_DECLARE_MODEL(AllType,
                  );
 
 
+/// A model with typed storage fields
+class TypedModel : public DQModel {
+    DQ_MODEL
+public:
+    DQTypedField<QString> name;
+    DQTypedField<int> count;
+    DQTypedField<double> weight;
+    DQTypedField<QStringList> tags;
+};
+
+DQ_DECLARE_MODEL(TypedModel,
+                 "typedmodel",
+                 DQ_FIELD(name , DQNotNull),
+                 DQ_FIELD(count),
+                 DQ_FIELD(weight),
+                 DQ_FIELD(tags),
+                 DQ_INDEX(typedmodel_count , count , weight DESC),
+                 DQ_UNIQUE_INDEX(typedmodel_name , name),
+                 DQ_PARTIAL_INDEX(typedmodel_heavy , "weight > 100" , weight , substr(name,1,3))
+                 );
+
+/// A model used to test schema migration
+class MigrationModel : public DQModel {
+    DQ_MODEL
+public:
+    DQField<QString> name;
+    DQField<int> count;
+    DQField<QString> code;
+};
+
+DQ_DECLARE_MODEL(MigrationModel,
+                 "migrationmodel",
+                 DQ_FIELD(name),
+                 DQ_FIELD(count , DQNotNull | DQDefault(0)),
+                 DQ_FIELD(code , DQUnique),
+                 DQ_INDEX(migrationmodel_count , count)
+                 );
+
+/// A model with full text indexed fields
+class Article : public DQModel {
+    DQ_MODEL
+public:
+    DQField<QString> title;
+    DQField<QString> body;
+    DQField<int> views;
+};
+
+DQ_DECLARE_MODEL(Article,
+                 "article",
+                 DQ_FIELD(title , DQFullText),
+                 DQ_FIELD(body , DQFullText),
+                 DQ_FIELD(views)
+                 );
+
+/// A model with generated columns
+class Account : public DQModel {
+    DQ_MODEL
+public:
+    DQField<QString> email;
+    DQField<int> created;
+    DQField<QString> emailKey;
+    DQField<int> day;
+};
+
+DQ_DECLARE_MODEL(Account,
+                 "account",
+                 DQ_FIELD(email),
+                 DQ_FIELD(created),
+                 DQ_FIELD(emailKey , DQGenerated("lower(email)")),
+                 DQ_FIELD(day , DQStoredGenerated("created / 86400")),
+                 DQ_INDEX(account_day , day)
+                 );
+
+/// A model with two independent UNIQUE columns
+class Product : public DQModel {
+    DQ_MODEL
+public:
+    DQField<QString> sku;
+    DQField<QString> barcode;
+    DQField<QString> name;
+};
+
+DQ_DECLARE_MODEL(Product,
+                 "product",
+                 DQ_FIELD(sku , DQUnique),
+                 DQ_FIELD(barcode , DQUnique),
+                 DQ_FIELD(name)
+                 );
+
 /// A database model with private field
 class PrivateFieldModel : public DQModel {
     DQ_MODEL
@@ -83,4 +172,16 @@ DQ_DECLARE_MODEL(PrivateFieldModel,
 
                  );
 
+/// A model derived from ExamResult with the clauses of inherited fields changed
+class ExamDraft : public ExamResult {
+    DQ_MODEL
+};
+
+DQ_DECLARE_MODEL2(ExamDraft,
+                  "examdraft",
+                  ExamResult,
+                  DQ_FIELD(uid),
+                  DQ_FIELD(subject , DQFullText)
+                  );
+
 #endif // MISC_H
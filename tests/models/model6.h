@@ -0,0 +1,66 @@
+/**
+ * @author Ben Lau
+ */
+
+#ifndef MODEL6_H
+#define MODEL6_H
+
+#include "dqmodel.h"
+
+/// Model6 - Contruct a model same as model1 but declare the fields by value
+/**
+  Model6 is written by hand like Model1 , but the fields are declared by
+  _dqMetaInfoField() and _dqMetaInfoFields() , which DQ_DECLARE_MODEL uses.
+  It do not need a dummy instance of the model.
+ */
+
+class Model6 : public DQModel
+{
+public:
+    enum { DQModelDefined = 1 };
+
+    virtual inline QString tableName();
+    static inline QString TableName();
+    virtual inline DQModelMetaInfo *metaInfo() const;
+
+    DQField<QString> key;
+    DQField<QString> value;
+};
+
+template<>
+class DQModelMetaInfoHelper<Model6> {
+public:
+    typedef Model6 Table;
+
+    enum {DQModelDefined = 1 };
+
+    static inline QString className() {
+        return "Model6";
+    }
+
+    static inline QList<DQModelMetaInfoField> fields() {
+        QList<DQModelMetaInfoField> result;
+        result << DQModelMetaInfoHelper<DQModel>::fields() ;
+        const DQModelMetaInfoField list[] = {
+                _dqMetaInfoField("key",&Table::key,offsetof(Table,key),DQNotNull),
+                _dqMetaInfoField("value",&Table::value,offsetof(Table,value))
+                };
+
+        result << _dqMetaInfoFields(list,sizeof(list) / sizeof(list[0]));
+        return result;
+    }
+};
+
+inline DQModelMetaInfo *Model6::metaInfo() const {
+    return dqMetaInfo<Model6>();
+}
+
+inline QString Model6::tableName() {
+    return "model6";
+}
+
+inline QString Model6::TableName(){
+    return "model6";
+}
+
+#endif // MODEL6_H
@@ -11,4 +11,5 @@ HEADERS += \
     $$PWD/config.h \
     $$PWD/user.h \
     $$PWD/model5.h \
+    $$PWD/model6.h \
     $$PWD/misc.h
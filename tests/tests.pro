@@ -3,5 +3,5 @@
 ######################################################################
 
 TEMPLATE = subdirs
-SUBDIRS = unittests
+SUBDIRS = unittests benchmarks concurrency
 
@@ -1,5 +1,33 @@
 #include "coretests.h"
 
+/// A model only used by metaInfoThreads() , so its meta info is created there
+class ThreadModel : public DQModel {
+    DQ_MODEL
+public:
+    DQField<QString> name;
+};
+
+DQ_DECLARE_MODEL(ThreadModel,
+                 "threadmodel",
+                 DQ_FIELD(name)
+                 );
+
+/// A thread that read the meta info of ThreadModel
+class MetaInfoThread : public QThread {
+public:
+    MetaInfoThread() : metaInfo(0) , found(0) {
+    }
+
+    DQModelMetaInfo *metaInfo;
+    DQModelMetaInfo *found;
+
+protected:
+    void run() {
+        metaInfo = dqMetaInfo<ThreadModel>();
+        found = dqFindMetaInfo("threadmodel");
+    }
+};
+
 CoreTests::CoreTests(QObject *parent) : QObject(parent)
 {
 }
@@ -32,6 +60,18 @@ void CoreTests::metaInfo(){
     QVERIFY(initialData.at(0)->key == "initial0");
     QVERIFY(initialData.at(4)->key == "initial4");
 
+    // Test indexOf()
+    QCOMPARE(metaInfo2->indexOf("id") , 0);
+    QCOMPARE(metaInfo2->indexOf("key") , 1);
+    QCOMPARE(metaInfo2->indexOf("value") , 2);
+    QCOMPARE(metaInfo2->indexOf("unknown") , -1);
+    QVERIFY(metaInfo2->value(initialData.at(0),metaInfo2->size()).isNull()); // Out of range
+
+    // Test the cached name lists
+    DQModelMetaInfo* userInfo = dqMetaInfo<User>();
+    QCOMPARE(userInfo->columnNameList().join(",") , QString("id,userId,name,passwd,creationTime,lastLoginTime"));
+    QCOMPARE(userInfo->fieldNameList().join(",") , QString("creationTime,id,lastLoginTime,name,passwd,userId"));
+    QCOMPARE(dqMetaInfo<ExamResult>()->foreignKeyNameList() , QStringList("uid"));
 }
 
 void CoreTests::sqliteColumnConstraint(){
@@ -147,6 +187,12 @@ void CoreTests::where(){
     filter = price.notEqual(qty);
     QVERIFY(filter.toString() == "price <> qty");
 
+    filter = price + 1;
+    QVERIFY(filter.toString() == "price + 1");
+
+    filter = price - 1;
+    QVERIFY(filter.toString() == "price - 1");
+
 }
 
 void CoreTests::expression(){
@@ -156,6 +202,55 @@ void CoreTests::expression(){
     qDebug() << expression.string();
     QVERIFY(expression.string() == "(key = :arg0) and (length > :arg1)");
 
+    DQExpression prefixed(where,"p");
+    QVERIFY(prefixed.string() == "(key = :p0) and (length > :p1)");
+    QVERIFY(prefixed.bindValues()[":p1"] == 5);
+
+}
+
+void CoreTests::largeInList(){
+    QList<QVariant> small,large,larger;
+    for (int i = 0 ; i < 1000;i++) {
+        if (i < 10)
+            small << i;
+        if (i < 100)
+            large << i;
+        larger << i;
+    }
+
+    DQExpression expression(DQWhere("id").in(small));
+    QVERIFY(expression.string() == "id in (:arg0,:arg1,:arg2,:arg3,:arg4,:arg5,:arg6,:arg7,:arg8,:arg9)");
+
+    expression = DQExpression(DQWhere("id").in(large));
+    QVERIFY(expression.string() == "id in (SELECT value FROM json_each(:arg0))");
+    QVERIFY(expression.bindNames().size() == 1);
+    QVERIFY(expression.bindValues()[":arg0"].toString().startsWith("[0,1,2,"));
+
+    // The statement is not changed by the no. of values
+    DQExpression expression2(DQWhere("id").in(larger));
+    QVERIFY(expression.string() == expression2.string());
+
+    QList<QVariant> names;
+    for (int i = 0 ; i < 100;i++) {
+        names << QString("Tester \"%1\"").arg(i);
+    }
+    names << QVariant();
+    expression = DQExpression(DQWhere("name").in(names));
+    QString json = expression.bindValues()[":arg0"].toString();
+    QVERIFY(json.startsWith("[\"Tester \\\"0\\\"\","));
+    QVERIFY(json.endsWith(",null]"));
+
+    // QByteArray can't be compared after conversion. The values are bound one by one.
+    names << QByteArray("data");
+    expression = DQExpression(DQWhere("name").in(names));
+    QVERIFY(expression.bindNames().size() == 102);
+
+    // A dialect without json_each() binds the values one by one
+    DQPostgresStatement postgres;
+    QVERIFY(!postgres.supportsJsonInList());
+    expression = DQExpression(DQWhere("id").in(large),"arg",QString(),postgres.supportsJsonInList());
+    QVERIFY(!expression.string().contains("json_each"));
+    QVERIFY(expression.bindNames().size() == 100);
 }
 
 
@@ -210,6 +305,30 @@ void CoreTests::model1_equalTo_model2(){
 
 }
 
+void CoreTests::model6_equalTo_model1(){
+    DQModelMetaInfo* info1 = dqMetaInfo<Model1>();
+    DQModelMetaInfo* info6 = dqMetaInfo<Model6>();
+
+    QVERIFY(info1 != info6);
+    QVERIFY(info6->name() == "model6");
+    QVERIFY(Model6().metaInfo() == info6);
+
+    QCOMPARE(info6->size() , info1->size());
+    for (int i = 0 ; i < info1->size() ;i++){
+        QCOMPARE(info6->at(i)->name , info1->at(i)->name);
+        QCOMPARE(info6->at(i)->offset , info1->at(i)->offset);
+        QCOMPARE(info6->at(i)->type , info1->at(i)->type);
+        DQClause clause1 = info1->at(i)->clause;
+        DQClause clause6 = info6->at(i)->clause;
+        QCOMPARE(clause6.testFlag(DQClause::NOT_NULL) , clause1.testFlag(DQClause::NOT_NULL));
+    }
+
+    Model6 model;
+    QVariant v("test");
+    QVERIFY(info6->setValue(&model,"key",v));
+    QVERIFY(model.key.get() == v);
+}
+
 void CoreTests::model2(){
     DQModelMetaInfo* info1 = dqMetaInfo<Model2>();
     Model2 *model = new Model2();
@@ -248,6 +367,23 @@ void CoreTests::model4() {
 
 }
 
+void CoreTests::overriddenField() {
+    DQModelMetaInfo* parent = dqMetaInfo<ExamResult>();
+    DQModelMetaInfo* info = dqMetaInfo<ExamDraft>();
+
+    QCOMPARE(info->columnNameList() , parent->columnNameList());
+    QCOMPARE(info->foreignKeyNameList() , QStringList() << "uid");
+    QCOMPARE(info->fullTextNameList() , QStringList() << "subject");
+    QVERIFY(parent->fullTextNameList().isEmpty());
+
+    // The foreign key list keeps the field of the latest declaration
+    QList<DQModelMetaInfoField> foreignKeys = info->foreignKeyList();
+    QCOMPARE(foreignKeys.size() , 1);
+    QVERIFY(!foreignKeys.first().clause.testFlag(DQClause::NOT_NULL));
+    QVERIFY(parent->foreignKeyList().first().clause.testFlag(DQClause::NOT_NULL));
+    QVERIFY(info->linkedMetaInfo(info->indexOf("uid")) == dqMetaInfo<User>());
+}
+
 void CoreTests::model5() {
     DQSqliteStatement statement;
     QString sql = statement.createTableIfNotExists<Model5>();
@@ -360,6 +496,267 @@ void CoreTests::stringlistField_data() {
 
 }
 
+void CoreTests::typedField(){
+    DQTypedField<int> field;
+    QVERIFY(field.type() == QVariant::Int);
+    QVERIFY(field.isNull());
+    QVERIFY(field.get().isNull());
+
+    field = 10;
+    QVERIFY(!field.isNull());
+    QVERIFY(field == 10);
+    QVERIFY(field.get() == 10);
+
+    QVERIFY(field.set(QString("20")));
+    QCOMPARE(field.value() , 20);
+
+    QVERIFY(field.set(QVariant()));
+    QVERIFY(field.isNull());
+    QVERIFY(field != 0);
+
+    DQTypedField<QString> string;
+    string = "test";
+    QCOMPARE(string->size() , 4);
+    QVERIFY(string == "test");
+
+    DQTypedField<QStringList> list;
+    list = QStringList() << "a" << "b&c";
+    QCOMPARE(list.get(true).toString() , QString("a & b&amp;c"));
+    list.set(QString("a & b&amp;c"));
+    QCOMPARE(list.value() , QStringList() << "a" << "b&c");
+
+    QVERIFY(sizeof(DQTypedField<int>) < sizeof(DQField<int>));
+
+    TypedModel model;
+    DQModelMetaInfo* metaInfo = model.metaInfo();
+    QVERIFY(metaInfo->setValue(&model,"count",5));
+    QCOMPARE(model.count.value() , 5);
+    QVERIFY(metaInfo->value(&model,"weight").isNull());
+}
+
+void CoreTests::dirtyField(){
+    HealthCheck model;
+    QVERIFY(!model.name.isDirty());
+
+    model.name = "tester";
+    QVERIFY(model.name.isDirty());
+    QVERIFY(!model.height.isDirty());
+
+    model.metaInfo()->setDirty(&model,false);
+    QVERIFY(!model.name.isDirty());
+
+    model.metaInfo()->setValue(&model,"height",150);
+    QVERIFY(model.height.isDirty());
+
+    // Read only access do not change the state
+    const HealthCheck &constModel = model;
+    QVERIFY(!constModel.weight->isValid());
+    QVERIFY(!model.weight.isDirty());
+
+    model.weight->setValue(60.5);
+    QVERIFY(model.weight.isDirty());
+
+    TypedModel typed;
+    typed.count = 1;
+    QVERIFY(typed.count.isDirty());
+    QVERIFY(!typed.name.isDirty());
+}
+
+void CoreTests::sharedListArena(){
+    DQList<Model2> list;
+    DQModelMetaInfo *metaInfo = dqMetaInfo<Model2>();
+
+    // Larger than the first block of arena
+    for (int i = 0 ; i < 1000;i++) {
+        Model2 *model = static_cast<Model2*>(list.appendNew(metaInfo));
+        QVERIFY(model);
+        model->key = QString("arena%1").arg(i);
+    }
+
+    Model2 item;
+    item.key = "heap";
+    QVERIFY(list.append(item));
+    QCOMPARE(list.size() , 1001);
+
+    for (int i = 0 ; i < 1000;i++) {
+        QVERIFY(list.at(i)->key == QString("arena%1").arg(i));
+    }
+    QVERIFY(list.at(1000)->key == "heap");
+
+    // Type checking
+    QVERIFY(list.appendNew(dqMetaInfo<HealthCheck>()) == 0);
+
+    list.removeAt(0);
+    QCOMPARE(list.size() , 1000);
+    QVERIFY(list.at(0)->key == "arena1");
+
+    list.removeAt(999);
+    QVERIFY(list.at(998)->key == "arena999");
+
+    list.clear();
+    QCOMPARE(list.size() , 0);
+
+    // The list is still usable after clear()
+    QVERIFY(list.appendNew(metaInfo));
+    QCOMPARE(list.size() , 1);
+}
+
+void CoreTests::evaluator(){
+    DQList<HealthCheck> list;
+    for (int i = 0 ; i < 10;i++) {
+        HealthCheck model;
+        model.name = QString("tester %1").arg(i);
+        model.height = 150 + i * 5;
+        if (i % 3 != 0)
+            model.weight = 50.0 + i;
+        QVERIFY(list.append(model));
+    }
+
+    DQEvaluator all;
+    QVERIFY(all.isNull());
+    QCOMPARE(all.select(list).size() , 10);
+    QCOMPARE(all.call("count",list).toInt() , 10);
+
+    DQEvaluator tall(DQWhere("height") > 170);
+    QVERIFY(!tall.match(list.at(0)));
+    QVERIFY(tall.match(list.at(9)));
+    QCOMPARE(tall.select(list) , QVector<int>() << 5 << 6 << 7 << 8 << 9);
+    QCOMPARE(tall.call("sum",list,"height").toInt() , 175 + 180 + 185 + 190 + 195);
+    QCOMPARE(tall.call("max",list,"height").toInt() , 195);
+
+    // Null values are skipped
+    QCOMPARE(tall.call("count",list,"weight").toInt() , 3);
+    QCOMPARE(tall.call("avg",list,"weight").toDouble() , (55.0 + 57.0 + 58.0) / 3);
+
+    QCOMPARE(DQEvaluator(DQWhere("height").between(160,170)).select(list).size() , 3);
+    QCOMPARE(DQEvaluator(DQWhere("height").in(QList<QVariant>() << 150 << 155 << 300)).select(list).size() , 2);
+    QCOMPARE(DQEvaluator(DQWhere("height").notIn(QList<QVariant>() << 150 << 155)).select(list).size() , 8);
+    QCOMPARE(DQEvaluator(DQWhere("name").like("TESTER 1%")).select(list).size() , 1);
+    QCOMPARE(DQEvaluator(DQWhere("name").glob("tester [0-2]")).select(list).size() , 3);
+    QCOMPARE(DQEvaluator(DQWhere("weight").is(QVariant())).select(list).size() , 4);
+    QCOMPARE(DQEvaluator(DQWhere("weight") > 0).select(list).size() , 6);
+    QCOMPARE(DQEvaluator(DQWhere("height") + 10 > 195).select(list).size() , 2);
+
+    DQWhere where = (DQWhere("height") < 160 || DQWhere("height") >= 190) && DQWhere("name") != "tester 0";
+    QCOMPARE(DQEvaluator(where).select(list) , QVector<int>() << 1 << 8 << 9);
+}
+
+void CoreTests::connectionOptions(){
+    DQConnectionOptions none;
+    QVERIFY(none.isNull());
+    QVERIFY(none.pragmas().isEmpty());
+
+    QCOMPARE(DQConnectionOptions::profileNames().size() , 4);
+    foreach (QString name , DQConnectionOptions::profileNames()) {
+        DQConnectionOptions options = DQConnectionOptions::profile(name);
+        QCOMPARE(options.name , name);
+        QVERIFY(!options.isNull());
+    }
+
+    DQConnectionOptions balanced = DQConnectionOptions::profile("balanced");
+    QStringList pragmas = balanced.pragmas();
+    QCOMPARE(pragmas.first() , QString("PRAGMA busy_timeout = 5000"));
+    QVERIFY(pragmas.contains("PRAGMA journal_mode = WAL"));
+    QVERIFY(pragmas.contains("PRAGMA synchronous = NORMAL"));
+    QVERIFY(pragmas.contains("PRAGMA cache_size = -16000"));
+    QVERIFY(pragmas.contains("PRAGMA temp_store = MEMORY"));
+
+    DQConnectionOptions readOnly = DQConnectionOptions::profile("read-only-mmap");
+    QVERIFY(readOnly.journalMode.isEmpty());
+    QVERIFY(readOnly.pragmas().contains("PRAGMA mmap_size = 268435456"));
+    QVERIFY(readOnly.pragmas().contains("PRAGMA query_only = 1"));
+
+    // Modify a profile
+    DQConnectionOptions bulk = DQConnectionOptions::profile("bulk-load");
+    bulk.synchronous = "NORMAL";
+    QVERIFY(bulk.pragmas().contains("PRAGMA synchronous = NORMAL"));
+
+    QVERIFY(DQConnectionOptions::profile("unknown").isNull());
+}
+
+void CoreTests::queryStats(){
+    QCOMPARE(DQQueryStats::normalize("SELECT id FROM user WHERE id = :p0 LIMIT 10") ,
+             QString("SELECT id FROM user WHERE id = ? LIMIT ?"));
+    QCOMPARE(DQQueryStats::normalize("SELECT * FROM t1 WHERE name = 'it''s' AND \"col 2\" > 3.5") ,
+             QString("SELECT * FROM t1 WHERE name = ? AND \"col 2\" > ?"));
+    QCOMPARE(DQQueryStats::normalize("SELECT * FROM model WHERE id IN (:p0,:p1,:p2)") ,
+             DQQueryStats::normalize("SELECT * FROM model WHERE id IN (:p0,:p1)"));
+
+    QCOMPARE(DQQueryStats::bucketOf(0) , 0);
+    QCOMPARE(DQQueryStats::bucketOf(1) , 0);
+    QCOMPARE(DQQueryStats::bucketOf(2) , 1);
+    QCOMPARE(DQQueryStats::bucketOf(1000) , 9); // [512,1024)
+    QCOMPARE(DQQueryStats::bucketOf(Q_INT64_C(1) << 40) , (int) DQQueryStats::BucketCount - 1);
+
+    DQQueryStats stats;
+    QCOMPARE(stats.histogram.size() , (int) DQQueryStats::BucketCount);
+    QCOMPARE(stats.averageTime() , 0.0);
+}
+
+void CoreTests::queryPlan(){
+    DQQueryPlan plan;
+    QVERIFY(plan.isEmpty());
+
+    DQQueryPlan::Step scan;
+    scan.id = 2;
+    scan.detail = "SCAN TABLE healthcheck";
+    plan.append(scan);
+
+    DQQueryPlan::Step search;
+    search.id = 3;
+    search.parent = 2;
+    search.detail = "SEARCH user USING INTEGER PRIMARY KEY (rowid=?)";
+    plan.append(search);
+
+    DQQueryPlan::Step covering;
+    covering.id = 4;
+    covering.detail = "SCAN config USING COVERING INDEX config_key";
+    plan.append(covering);
+
+    QCOMPARE(plan.size() , 3);
+    QVERIFY(plan.at(0).isFullScan());
+    QCOMPARE(plan.at(0).table() , QString("healthcheck"));
+    QVERIFY(!plan.at(1).isFullScan());
+    QCOMPARE(plan.at(1).table() , QString("user"));
+    QVERIFY(!plan.at(2).isFullScan());
+
+    QVERIFY(plan.hasFullScan());
+    QCOMPARE(plan.fullScanTables() , QStringList() << "healthcheck");
+    QCOMPARE(plan.toString() , QString("SCAN TABLE healthcheck\n  SEARCH user USING INTEGER PRIMARY KEY (rowid=?)\nSCAN config USING COVERING INDEX config_key"));
+}
+
+void CoreTests::declaredIndex(){
+    DQModelMetaInfo *metaInfo = dqMetaInfo<TypedModel>();
+    QCOMPARE(metaInfo->size() , 5); // The index is not a field
+    QVERIFY(metaInfo->indexOf("typedmodel_count") < 0);
+
+    QList<DQModelMetaInfoIndex> list = metaInfo->indexList();
+    QCOMPARE(list.size() , 3);
+
+    QCOMPARE(list.at(0).name , QString("typedmodel_count"));
+    QCOMPARE(list.at(0).columns , QStringList() << "count" << "weight DESC");
+    QVERIFY(!list.at(0).unique);
+    QVERIFY(list.at(0).where.isEmpty());
+
+    QVERIFY(list.at(1).unique);
+    QCOMPARE(list.at(1).columns , QStringList() << "name");
+
+    QCOMPARE(list.at(2).where , QString("weight > 100"));
+    QCOMPARE(list.at(2).columns , QStringList() << "weight" << "substr(name,1,3)");
+
+    DQBaseIndex index(metaInfo,list.at(2).name);
+    index.setColumnDefList(list.at(2).columns);
+    index.setWhere(list.at(2).where);
+    DQSqliteStatement sql;
+    QCOMPARE(sql.createIndexIfNotExists(index) ,
+             QString("CREATE INDEX IF NOT EXISTS typedmodel_heavy on typedmodel (weight,substr(name,1,3)) WHERE weight > 100;"));
+
+    index.setWhere(QString());
+    index.setUnique(true);
+    QCOMPARE(sql.createIndexIfNotExists(index) ,
+             QString("CREATE UNIQUE INDEX IF NOT EXISTS typedmodel_heavy on typedmodel (weight,substr(name,1,3));"));
+}
+
 void CoreTests::stream() {
     HealthCheck record;
     DQStream stream(&record);
@@ -407,3 +804,387 @@ void CoreTests::listWriter() {
     QVERIFY(list.size() == 5);
 
 }
+
+void CoreTests::statementRegistry() {
+    DQSqlStatement *statement = DQSqlStatement::create("QSQLITE");
+    QVERIFY(statement);
+    QVERIFY(statement->driverName() == "SQLITE");
+    QVERIFY(!statement->returnsInsertId());
+    delete statement;
+
+    statement = DQSqlStatement::create("QPSQL");
+    QVERIFY(statement);
+    QVERIFY(statement->driverName() == "POSTGRESQL");
+    QVERIFY(statement->returnsInsertId());
+    delete statement;
+
+    QVERIFY(DQSqlStatement::create("QUNKNOWN") == 0);
+
+    QStringList drivers = DQSqlStatement::registeredDrivers();
+    QVERIFY(drivers.contains("QSQLITE"));
+    QVERIFY(drivers.contains("QPSQL"));
+}
+
+void CoreTests::postgresStatement() {
+    DQPostgresStatement sql;
+    DQModelMetaInfo *info = dqMetaInfo<Model1>();
+
+    QString create = sql.createTableIfNotExists(info);
+    QVERIFY(create.contains("id SERIAL PRIMARY KEY"));
+    QVERIFY(!create.contains("AUTOINCREMENT"));
+
+    QStringList fields;
+    fields << "key" << "value";
+    QVERIFY(sql.insertInto(info,fields) == "INSERT INTO model1 (key,value) values (:key,:value) RETURNING id;");
+
+    // Without id , it is a plain insert
+    QVERIFY(sql.replaceInto(info,fields) == sql.insertInto(info,fields));
+
+    fields.prepend("id");
+    QVERIFY(sql.replaceInto(info,fields) ==
+            "INSERT INTO model1 (id,key,value) values (:id,:key,:value) ON CONFLICT(id) DO UPDATE SET key = excluded.key,value = excluded.value RETURNING id;");
+
+    DQQuery<Model1> query;
+    QVERIFY(sql.select(query.offset(10)).contains("LIMIT ALL OFFSET 10"));
+    QVERIFY(sql.select(query.limit(5).offset(10)).contains("LIMIT 5 OFFSET 10"));
+
+    QString remove = sql.deleteFrom(query.filter(DQWhere("key") == "test").limit(1));
+    QVERIFY(remove.startsWith("DELETE FROM model1 WHERE id IN (SELECT id FROM model1 WHERE"));
+    QVERIFY(remove.contains("LIMIT 1)"));
+}
+
+void CoreTests::metaInfoThreads() {
+    QList<MetaInfoThread*> threads;
+    for (int i = 0 ; i < 8;i++) {
+        threads << new MetaInfoThread();
+    }
+
+    foreach (MetaInfoThread* thread , threads) {
+        thread->start();
+    }
+
+    DQModelMetaInfo *metaInfo = dqMetaInfo<ThreadModel>();
+    QVERIFY(metaInfo);
+    QVERIFY(metaInfo->className() == "ThreadModel");
+    QCOMPARE(metaInfo->size() , 2);
+
+    foreach (MetaInfoThread* thread , threads) {
+        QVERIFY(thread->wait(10000));
+        QVERIFY(thread->metaInfo == metaInfo);
+        QVERIFY(thread->found == metaInfo);
+    }
+
+    QVERIFY(ThreadModel().metaInfo() == metaInfo);
+    QVERIFY(dqFindMetaInfo("threadmodel") == metaInfo);
+
+    qDeleteAll(threads);
+}
+
+void CoreTests::expressionIndex() {
+    DQIndex<HealthCheck> index("healthcheck_expression");
+    index << DQWhere("lower(name)") << DQWhere("weight") / 100 << "height";
+    QCOMPARE(index.columnDefList() , QStringList() << "lower(name)" << "weight / 100" << "height");
+
+    index.setWhere(DQWhere("name") != "it's");
+    QCOMPARE(index.where() , QString("name <> 'it''s'"));
+
+    DQSqliteStatement sql;
+    QVERIFY(sql.createIndexIfNotExists(index).contains("(lower(name),weight / 100,height) WHERE name <> 'it''s'"));
+
+    DQModelMetaInfo *info = dqMetaInfo<Account>();
+    QCOMPARE(info->generatedNameList() , QStringList() << "emailKey" << "day");
+    QCOMPARE(info->writableFields(info->columnNameList()) , QStringList() << "id" << "email" << "created");
+
+    QString create = sql.createTableIfNotExists(info);
+    QVERIFY(create.contains("emailKey TEXT GENERATED ALWAYS AS (lower(email)) VIRTUAL"));
+    QVERIFY(create.contains("day INTEGER GENERATED ALWAYS AS (created / 86400) STORED"));
+
+    // Only the virtual one could be added to existing table
+    QVERIFY(sql.canAddColumn(info->at(info->indexOf("emailKey"))));
+    QVERIFY(!sql.canAddColumn(info->at(info->indexOf("day"))));
+}
+
+void CoreTests::retryPolicy() {
+    QVERIFY(DQRetryPolicy().isNull());
+    QVERIFY(DQConnectionOptions().isNull());
+
+    DQRetryPolicy policy(1000);
+    QVERIFY(!policy.isNull());
+    QCOMPARE(policy.timeout , 1000);
+
+    // Exponential backoff without jitter
+    QCOMPARE(policy.delay(0,0) , 1);
+    QCOMPARE(policy.delay(1,0) , 2);
+    QCOMPARE(policy.delay(3,0) , 8);
+    QCOMPARE(policy.delay(6,0) , 64);
+    QCOMPARE(policy.delay(7,0) , 100); // Capped by maxDelay
+    QCOMPARE(policy.delay(1000,0) , 100);
+
+    // The jitter reduce the delay by at most the fraction
+    QCOMPARE(policy.delay(7,1) , 50);
+    QCOMPARE(policy.delay(0,1) , 1); // At least 1 ms
+
+    policy.jitter = 0;
+    QCOMPARE(policy.delay(7,1) , 100);
+
+    DQConnectionOptions options;
+    options.retryPolicy = policy;
+    QVERIFY(!options.isNull());
+    QVERIFY(options.pragmas().isEmpty());
+}
+
+void CoreTests::queryBuilder() {
+    DQSqliteStatement statement;
+
+    DQQuery<Model1> base = DQQuery<Model1>().filter(DQWhere("key") == "test");
+
+    // Changed in place
+    DQQuery<Model1> chained = DQQuery<Model1>().filter(DQWhere("key") == "test").orderBy("key").limit(10).offset(5);
+
+    // Built on a detached copy
+    DQQuery<Model1> copied = base.orderBy("key").limit(10).offset(5);
+
+    DQQueryRules rules;
+    rules = base;
+    QCOMPARE(rules.limit() , -1);
+    QVERIFY(rules.orderBy().isEmpty());
+
+    rules = chained;
+    QCOMPARE(rules.limit() , 10);
+    QCOMPARE(rules.offset() , 5);
+    QCOMPARE(rules.orderBy() , QStringList() << "key");
+    QVERIFY(rules.metaInfo() == dqMetaInfo<Model1>());
+
+    QCOMPARE(statement.select(chained) , statement.select(copied));
+
+    // The generated statement of the previous rules is not reused
+    QString sql = statement.select(base);
+    DQQuery<Model1> limited = DQQuery<Model1>(base).limit(1);
+    QVERIFY(statement.select(limited) != sql);
+    QCOMPARE(statement.select(base) , sql);
+
+    DQQuery<Model1> only = DQQuery<Model1>().only("key").defer("value");
+    rules = only;
+    QCOMPARE(rules.deferred() , QStringList() << "value");
+
+#ifdef Q_COMPILER_RVALUE_REFS
+    // The moved-from query is an empty query of the same model
+    DQSharedQuery source = chained;
+    DQSharedQuery moved(std::move(source));
+    rules = moved;
+    QCOMPARE(rules.limit() , 10);
+    rules = source;
+    QCOMPARE(rules.limit() , -1);
+    QVERIFY(rules.metaInfo() == dqMetaInfo<Model1>());
+    QCOMPARE(statement.select(source) , statement.select(DQQuery<Model1>()));
+#endif
+}
+
+void CoreTests::listSort(){
+    DQList<HealthCheck> list;
+    int heights[] = { 170 , 160 , 180 , 160 , 150 };
+    for (int i = 0 ; i < 5;i++) {
+        HealthCheck *record = new HealthCheck();
+        record->name = QString("Sort %1").arg(i);
+        record->height = heights[i];
+        record->recordDate = QDate(2014,1,1).addDays(-i);
+        list.append(record);
+    }
+
+    HealthCheck *empty = static_cast<HealthCheck*>(list.appendNew(dqMetaInfo<HealthCheck>()));
+    empty->name = "Sort 5";
+
+    QVERIFY(!list.sortBy("unknown"));
+    QCOMPARE(list.at(0)->name.get().toString() , QString("Sort 0"));
+
+    // NULL first. The equal keys keep their order
+    QVERIFY(list.sortBy("height"));
+    QStringList names;
+    for (int i = 0 ; i < list.size();i++)
+        names << list.at(i)->name.get().toString();
+    QCOMPARE(names , QStringList() << "Sort 5" << "Sort 4" << "Sort 1" << "Sort 3" << "Sort 0" << "Sort 2");
+
+    QVERIFY(list.sortBy("recordDate",Qt::DescendingOrder));
+    QCOMPARE(list.at(0)->name.get().toString() , QString("Sort 0"));
+    QCOMPARE(list.at(5)->name.get().toString() , QString("Sort 5"));
+
+    QVERIFY(list.topK("height",2,Qt::DescendingOrder));
+    QCOMPARE(list.size() , 2);
+    QCOMPARE(list.at(0)->height.get().toInt() , 180);
+    QCOMPARE(list.at(1)->height.get().toInt() , 170);
+
+    // k-way merge
+    QList<DQList<HealthCheck> > lists;
+    for (int i = 0 ; i < 3;i++) {
+        DQList<HealthCheck> input;
+        for (int j = 0 ; j < 4;j++) {
+            HealthCheck *record = static_cast<HealthCheck*>(input.appendNew(dqMetaInfo<HealthCheck>()));
+            record->name = QString("Merge %1").arg(i);
+            record->height = j * 3 + i;
+        }
+        lists << input;
+    }
+
+    DQList<HealthCheck> merged = DQList<HealthCheck>::merge(lists,"height",Qt::AscendingOrder,10);
+    QCOMPARE(merged.size() , 10);
+    QVERIFY(merged.metaInfo() == dqMetaInfo<HealthCheck>());
+    for (int i = 0 ; i < 10;i++) {
+        QCOMPARE(merged.at(i)->height.get().toInt() , i);
+    }
+    foreach (DQList<HealthCheck> input , lists) {
+        QCOMPARE(input.size() , 0);
+    }
+
+    // The merged models are still valid after the input lists are cleared
+    lists.clear();
+    QCOMPARE(merged.at(9)->name.get().toString() , QString("Merge 0"));
+
+    // A large list is sorted in parallel
+    DQList<HealthCheck> large;
+    for (int i = 0 ; i < 60000;i++) {
+        HealthCheck *record = static_cast<HealthCheck*>(large.appendNew(dqMetaInfo<HealthCheck>()));
+        record->name = QString("Tester %1").arg((i * 7919) % 60000);
+    }
+    QVERIFY(large.sortBy("name"));
+    for (int i = 1 ; i < large.size();i++) {
+        QVERIFY(large.at(i - 1)->name.get().toString() <= large.at(i)->name.get().toString());
+    }
+}
+
+void CoreTests::serializer(){
+    DQList<AllType> list;
+    for (int i = 0 ; i < 3;i++) {
+        AllType *record = new AllType();
+        record->string = QString("Tester \"%1\"\n").arg(i) + QChar(0xe9);
+        record->integer = i - 1;
+        record->d = 0.1 * i;
+        record->lastModifiedTime = QDateTime(QDate(2014,1,1 + i),QTime(12,30,15));
+        record->data = QByteArray("\x00\x01\xff",3);
+        record->b = i % 2 == 0;
+        record->sl = QStringList() << "a" << QString("b%1").arg(i);
+        list.append(record);
+    }
+    list.at(1)->string = QVariant(); // Null field
+
+    QByteArray json = list.toJson();
+    QVERIFY(json.startsWith("[{"));
+    QVERIFY(json.endsWith("}]"));
+    QVERIFY(json.contains("\"string\":\"Tester \\\"0\\\"\\n\xc3\xa9\""));
+    QVERIFY(json.contains("\"string\":null"));
+    QVERIFY(json.contains("\"data\":\"AAH/\""));
+    QVERIFY(json.contains("\"sl\":[\"a\",\"b2\"]"));
+
+    QByteArray cbor = list.toCbor();
+    QCOMPARE((uchar) cbor.at(0) , (uchar) 0x9f);
+    QCOMPARE((uchar) cbor.at(cbor.size() - 1) , (uchar) 0xff);
+
+    QByteArray binary;
+    QBuffer device(&binary);
+    device.open(QIODevice::WriteOnly);
+    QVERIFY(list.writeBinary(&device));
+    device.close();
+    QVERIFY(binary.size() < json.size());
+
+    for (int format = 0 ; format < 3;format++) {
+        DQList<AllType> output;
+        switch (format) {
+        case 0:
+            QVERIFY(output.fromJson(json));
+            break;
+        case 1:
+            QVERIFY(output.fromCbor(cbor));
+            break;
+        default:
+            device.open(QIODevice::ReadOnly);
+            QVERIFY(output.readBinary(&device));
+            device.close();
+            break;
+        }
+
+        QCOMPARE(output.size() , 3);
+        for (int i = 0 ; i < 3;i++) {
+            AllType *a = list.at(i);
+            AllType *b = output.at(i);
+            QVERIFY(a->string.get() == b->string.get());
+            QCOMPARE(b->integer.get().toInt() , i - 1);
+            QCOMPARE(b->d.get().toDouble() , 0.1 * i);
+            QCOMPARE(b->lastModifiedTime.get().toDateTime() , a->lastModifiedTime.get().toDateTime());
+            QCOMPARE(b->data.get().toByteArray() , QByteArray("\x00\x01\xff",3));
+            QCOMPARE(b->b.get().toBool() , i % 2 == 0);
+            QCOMPARE(b->sl.get().toStringList() , a->sl.get().toStringList());
+        }
+        QVERIFY(output.at(1)->string.get().isNull());
+    }
+
+    // Streaming from a cursor-like loop , and the unknown field is skipped
+    QByteArray stream("[ {\"string\" : \"first\", \"unknown\" : {\"x\" : [1,2]}, \"integer\" : 5} ,"
+                      " {\"integer\" : -2e1} ]");
+    QBuffer input(&stream);
+    input.open(QIODevice::ReadOnly);
+    DQDeserializer reader(&input,DQSerializer::Json);
+    AllType record;
+    QVERIFY(reader.next(&record));
+    QCOMPARE(record.string.get().toString() , QString("first"));
+    QCOMPARE(record.integer.get().toInt() , 5);
+    QVERIFY(reader.next(&record));
+    QVERIFY(record.string.get().isNull());
+    QCOMPARE(record.integer.get().toInt() , -20);
+    QVERIFY(!reader.next(&record));
+    QVERIFY(!reader.hasError());
+
+    // Truncated input
+    DQList<AllType> truncated;
+    QVERIFY(!truncated.fromJson(json.left(json.size() / 2)));
+    QVERIFY(truncated.size() < 3);
+}
+
+void CoreTests::sqlBuilder() {
+    DQSqliteStatement statement;
+    DQModelMetaInfo *info = dqMetaInfo<Model1>();
+
+    QStringList fields;
+    fields << "key" << "value";
+    QCOMPARE(statement.insertInto(info,fields) , QString("INSERT INTO model1 (key,value) values (:key,:value);"));
+    QCOMPARE(statement.replaceInto(info,fields) , QString("REPLACE INTO model1 (key,value) values (:key,:value);"));
+    QCOMPARE(statement.update(info,fields) , QString("UPDATE model1 SET key = :key,value = :value WHERE id = :id;"));
+
+    QCOMPARE(statement.select(DQQuery<Model1>()) , QString("SELECT ALL * FROM model1 ;"));
+    QCOMPARE(statement.select(DQQuery<Model1>().orderBy("key").limit(10).offset(5)) ,
+             QString("SELECT ALL * FROM model1 ORDER BY key LIMIT 10 OFFSET 5 ;"));
+    QCOMPARE(statement.select(DQQuery<Model1>().offset(1234567)) , QString("SELECT ALL * FROM model1 LIMIT -1 OFFSET 1234567 ;"));
+    QCOMPARE(statement.select(DQQuery<Model1>().select(fields).groupBy("key")) ,
+             QString("SELECT ALL key,value FROM model1 GROUP BY key ;"));
+    QCOMPARE(statement.deleteFrom(DQQuery<Model1>()) , QString("DELETE FROM model1 ;"));
+    QCOMPARE(statement.deleteFrom(DQQuery<Model1>().limit(3)) , QString("DELETE FROM model1 LIMIT 3 ;"));
+    QCOMPARE(statement.update(DQQuery<Model1>(),QStringList() << "key = 'a'") , QString("UPDATE model1 SET key = 'a' ;"));
+
+    // The columns of linked model are selected by the nested select
+    QString related = statement.select(DQQuery<ExamResult>().selectRelated("uid").orderBy("mark"));
+    QVERIFY(related.startsWith("SELECT m.*,r0.id AS uid__id,"));
+    QVERIFY(related.contains(" FROM ( SELECT ALL * FROM examresult ORDER BY mark ) AS m LEFT JOIN user AS r0 ON m.uid = r0.id ORDER BY m.mark ;"));
+
+    // The field names in the outer ordering are qualified , the function names and literals are kept
+    related = statement.select(DQQuery<ExamResult>().selectRelated("uid").orderBy(QStringList() << "lower(subject) desc" << "id"));
+    QVERIFY(related.endsWith(" LEFT JOIN user AS r0 ON m.uid = r0.id ORDER BY lower(m.subject) desc,m.id ;"));
+
+    // The same statement is interned
+    DQQuery<Model1> filtered = DQQuery<Model1>().filter(DQWhere("key") == "test");
+    QString first = statement.select(filtered);
+    QString second = statement.select(DQQuery<Model1>().filter(DQWhere("key") == "test"));
+    QCOMPARE(first , second);
+    QVERIFY(first.constData() == second.constData());
+
+    // The result is not changed by the next build in the same buffer
+    QString other = statement.select(DQQuery<Model1>().limit(1));
+    QCOMPARE(statement.select(filtered) , first);
+    QVERIFY(other != first);
+
+    // A large statement
+    QStringList many;
+    for (int i = 0 ; i < 2000;i++)
+        many << QString("field%1").arg(i);
+    QString large = statement.insertInto(info,many);
+    QVERIFY(large.startsWith("INSERT INTO model1 (field0,field1,"));
+    QVERIFY(large.endsWith(":field1998,:field1999);"));
+    QCOMPARE(statement.insertInto(info,fields) , QString("INSERT INTO model1 (key,value) values (:key,:value);"));
+}
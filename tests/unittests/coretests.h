@@ -9,8 +9,10 @@
 #include "dqwhere.h"
 #include "dqclause.h"
 #include "dqsqlitestatement.h"
+#include "dqpostgresstatement.h"
 #include "model1.h"
 #include "model2.h"
+#include "model6.h"
 #include "model3.h"
 #include "model4.h"
 #include "model5.h"
@@ -18,9 +20,11 @@
 #include "dqquery.h"
 #include "dqexpression.h"
 #include "dqlist.h"
+#include "dqevaluator.h"
 #include "misc.h"
 #include "dqstream.h"
 #include "dqlistwriter.h"
+#include "dqserializer.h"
 
 /// A set of tests which don't involve database access
 
@@ -50,12 +54,18 @@ private Q_SLOTS:
 
     void expression();
 
+    /// Test the JSON array binding of long DQWhere::in() list
+    void largeInList();
+
     /// Test Model1 declaration
     void mode1l();
 
     void model1_accessFields();
     void model1_equalTo_model2();
 
+    /// The fields declared by value are same as the legacy declaration of Model1
+    void model6_equalTo_model1();
+
     void model2();
 
     void model3();
@@ -64,6 +74,9 @@ private Q_SLOTS:
 
     void model5();
 
+    /// The field re-declared by a derived model replaces the clause of parent
+    void overriddenField();
+
     void queryrules();
 
     void dqList();
@@ -72,12 +85,63 @@ private Q_SLOTS:
     void stringlistField();
     void stringlistField_data();
 
+    /// Test DQTypedField
+    void typedField();
+
+    /// Test the dirty state of fields
+    void dirtyField();
+
+    /// Test the models constructed by DQSharedList::appendNew()
+    void sharedListArena();
+
+    /// Test DQSharedList::sortBy() , topK() and merge()
+    void listSort();
+
+    /// Test DQSerializer and DQDeserializer
+    void serializer();
+
+    /// Test DQEvaluator over DQList
+    void evaluator();
+
+    /// Test the profiles of DQConnectionOptions
+    void connectionOptions();
+
+    /// Test DQQueryStats::normalize() and the histogram bucket
+    void queryStats();
+
+    /// Test the step parsing of DQQueryPlan
+    void queryPlan();
+
+    /// Test DQ_INDEX declaration
+    void declaredIndex();
+
     /// test DQStream
     void stream();
 
     /// Test DQListWriter
     void listWriter();
 
+    /// Test the registry of DQSqlStatement
+    void statementRegistry();
+
+    /// Test the statements generated by DQPostgresStatement
+    void postgresStatement();
+
+    /// Test the first use of dqMetaInfo() from several threads
+    void metaInfoThreads();
+
+    /// Test DQIndex with expression terms and the generated column declaration
+    void expressionIndex();
+
+    /// Test the backoff of DQRetryPolicy
+    void retryPolicy();
+
+    /// Test the builder chain on temporary and named queries
+    void queryBuilder();
+
+    /// Test the SQL text generated in the per-thread buffer of DQSqlStatement
+    void sqlBuilder();
+
 };
 
 
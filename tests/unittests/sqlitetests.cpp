@@ -4,6 +4,50 @@ SqliteTests::SqliteTests(QObject* parent) : QObject(parent)
 {
 }
 
+/// A thread that count the records through the default connection
+class CountingThread : public QThread {
+public:
+    CountingThread() : count(-1) {
+    }
+
+    void run() {
+        DQConnection connection = DQConnection::defaultConnection();
+        opened = connection.isOpen();
+        lastQueryIsEmpty = mainConnection.lastQuery().lastQuery().isEmpty(); // Last query is stored per thread
+        isDefault = (connection == mainConnection);
+
+        DQQuery<HealthCheck> query;
+        count = query.count();
+    }
+
+    DQConnection mainConnection;
+    int count;
+    bool opened;
+    bool isDefault;
+    bool lastQueryIsEmpty;
+};
+
+/// A thread that save the records through the default connection
+class SavingThread : public QThread {
+public:
+    SavingThread() : rows(0) , saved(0) {
+    }
+
+    void run() {
+        for (int i = 0 ; i < rows;i++) {
+            HealthCheck model;
+            model.name = QString("%1 %2").arg(prefix).arg(i);
+            model.height = 150 + i;
+            if (model.save() && !model.id->isNull())
+                saved++;
+        }
+    }
+
+    QString prefix;
+    int rows;
+    int saved;
+};
+
 void SqliteTests::initTestCase()
 {
     verifyCreateTable();
@@ -44,11 +88,20 @@ void SqliteTests::initTestCase()
     QVERIFY ( connect.addModel<ExamResult>() );
     QVERIFY ( connect.addModel<AllType>() );
     QVERIFY ( connect.addModel<HealthCheck>());
+    QVERIFY ( connect.addModel<TypedModel>());
 
     QVERIFY( connect.dropTables() );
 
     QVERIFY( connect.createTables() ); // recreate table
 
+    // The indexes declared by DQ_INDEX are created
+    QSqlQuery indexQuery = connect.query();
+    QVERIFY(indexQuery.exec("SELECT name FROM sqlite_master WHERE type = 'index' AND tbl_name = 'typedmodel' AND name LIKE 'typedmodel_%' ORDER BY name"));
+    QStringList indexes;
+    while (indexQuery.next())
+        indexes << indexQuery.value(0).toString();
+    QCOMPARE(indexes , QStringList() << "typedmodel_count" << "typedmodel_heavy" << "typedmodel_name");
+
     /* Create index */
 
     DQIndex<Model1> index1("index1");
@@ -549,3 +602,2887 @@ void SqliteTests::queryOrderBy(){
 
 }
 
+
+void SqliteTests::statementCache(){
+    DQSql sql = connect.sql();
+    DQQuery<HealthCheck> query;
+
+    sql.clearStatementCache();
+    QVERIFY(sql.statementCacheCapacity() > 0);
+
+    query = query.filter(DQWhere("height") > 100);
+    query.all();
+    QCOMPARE(sql.statementCacheMisses() , 1);
+    QCOMPARE(sql.statementCacheHits() , 0);
+
+    // Same SQL text with different bind value
+    query = query.filter(DQWhere("height") > 150);
+    QCOMPARE(query.all().size() , 1);
+    QCOMPARE(sql.statementCacheMisses() , 1);
+    QCOMPARE(sql.statementCacheHits() , 1);
+
+    // A copy of the SQL text which do not share the data is matched by the cache
+    QString text = query.lastQuery().lastQuery();
+    QString copy(text.constData(),text.size());
+    QVERIFY(copy.constData() != text.constData());
+    sql.prepare(copy);
+    QCOMPARE(sql.statementCacheMisses() , 1);
+    QCOMPARE(sql.statementCacheHits() , 2);
+
+    // The cache is disabled
+    sql.setStatementCacheCapacity(0);
+    sql.clearStatementCache();
+    query.all();
+    query.all();
+    QCOMPARE(sql.statementCacheHits() , 0);
+    QCOMPARE(sql.statementCacheMisses() , 2);
+
+    sql.setStatementCacheCapacity(32);
+}
+
+void SqliteTests::saveAll(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    DQList<HealthCheck> list;
+    DQListWriter writer(&list);
+
+    for (int i = 0 ; i < 100;i++) {
+        writer << QString("bulk %1").arg(i) << 100 + i << 50 + i << writer.next();
+    }
+    writer.close();
+
+    DQSharedList::BulkOptions options;
+    options.batchSize = 30;
+    QVERIFY(list.saveAll(options));
+
+    QCOMPARE(query.count() , 100);
+
+    for (int i = 1 ; i < list.size();i++) {
+        QVERIFY(!list.at(i)->id->isNull());
+        QCOMPARE(list.at(i)->id->toInt() , list.at(i-1)->id->toInt() + 1);
+    }
+
+    HealthCheck check;
+    QVERIFY(check.load(DQWhere("id") == list.at(50)->id));
+    QVERIFY(check.name == "bulk 50");
+
+    // Save again. It should update the records instead of insert
+    list.at(50)->height = 300;
+    QVERIFY(list.saveAll());
+    QCOMPARE(query.count() , 100);
+    QCOMPARE(query.filter(DQWhere("height") == 300).count() , 1);
+
+    // The ids given to forceInsert are kept after rollback
+    DQList<HealthCheck> failed;
+    for (int i = 0 ; i < 2;i++) {
+        HealthCheck *record = new HealthCheck();
+        record->id = 1000 + i;
+        record->name = QString("rollback %1").arg(i);
+        failed.append(record);
+    }
+    failed.at(1)->name = QVariant(); // name is NOT NULL
+
+    DQSharedList::BulkOptions forceInsert;
+    forceInsert.forceInsert = true;
+    forceInsert.forceAllField = true;
+    QVERIFY(!failed.saveAll(forceInsert));
+    QCOMPARE(query.count() , 100);
+    QCOMPARE(failed.at(0)->id->toInt() , 1000);
+    QCOMPARE(failed.at(1)->id->toInt() , 1001);
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::transaction(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    HealthCheck check;
+    check.name = "transaction";
+
+    QVERIFY(connect.transaction());
+    QVERIFY(check.save());
+
+    {
+        // Nested transaction is rolled back
+        DQTransaction transaction(connect);
+        QVERIFY(transaction.isActive());
+        HealthCheck check2;
+        check2.name = "rollback";
+        QVERIFY(check2.save());
+        QCOMPARE(query.count() , 2);
+    }
+
+    QCOMPARE(connect.sql().transactionDepth() , 1);
+    QCOMPARE(query.count() , 1);
+
+    {
+        DQTransaction transaction(connect);
+        HealthCheck check3;
+        check3.name = "commit";
+        QVERIFY(check3.save());
+        QVERIFY(transaction.commit());
+        QVERIFY(!transaction.isActive());
+    }
+
+    QVERIFY(connect.commit());
+    QCOMPARE(connect.sql().transactionDepth() , 0);
+    QCOMPARE(query.count() , 2);
+
+    QVERIFY(connect.transaction());
+    QVERIFY(query.remove());
+    QVERIFY(connect.rollback());
+    QCOMPARE(query.count() , 2);
+
+    QVERIFY(!connect.commit()); // No transaction
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::cursor(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    DQList<HealthCheck> list;
+    DQListWriter writer(&list);
+
+    writer << "tester 1" << 160 << 120 << writer.next()
+           << "tester 2" << 120 << 170 << writer.next()
+           << "tester 3" << 140 << 110 << writer.next();
+    writer.close();
+    QVERIFY(list.save());
+
+    DQCursor<HealthCheck> cursor(query.orderBy("height asc"));
+    QStringList names;
+    HealthCheck* model = &cursor.model();
+
+    while (cursor.next()) {
+        QVERIFY(&cursor.model() == model); // The model instance is reused
+        names << cursor->name;
+    }
+    QCOMPARE(names.join(",") , QString("tester 2,tester 3,tester 1"));
+    QVERIFY(!cursor.next());
+
+    DQCursor<HealthCheck> cursor2(query.filter(DQWhere("height") > 130));
+    int count = 0;
+    DQCursor<HealthCheck>::iterator iter;
+    for (iter = cursor2.begin() ; iter != cursor2.end() ; ++iter) {
+        QVERIFY(iter->height > 130);
+        count++;
+    }
+    QCOMPARE(count , 2);
+
+    // Postfix increment returns the previous iterator
+    DQCursor<HealthCheck> cursor3(query.orderBy("height asc"));
+    iter = cursor3.begin();
+    DQCursor<HealthCheck>::iterator prev = iter++;
+    QVERIFY(prev != cursor3.end());
+    QVERIFY(iter != cursor3.end());
+    iter++;
+    prev = iter++;
+    QVERIFY(prev != cursor3.end());
+    QVERIFY(iter == cursor3.end());
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::connectionPool(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    DQList<HealthCheck> list;
+    DQListWriter writer(&list);
+    writer << "tester 1" << 160 << 120 << writer.next()
+           << "tester 2" << 120 << 170 << writer.next();
+    writer.close();
+    QVERIFY(list.save());
+
+    DQConnectionPool pool(connect);
+    QVERIFY(pool.connection() == connect); // The owner thread use the base connection
+    pool.setToDefaultPool();
+    QVERIFY(DQConnectionPool::defaultPool() == &pool);
+
+    CountingThread thread1,thread2;
+    thread1.mainConnection = connect;
+    thread2.mainConnection = connect;
+    thread1.start();
+    thread2.start();
+    QVERIFY(thread1.wait());
+    QVERIFY(thread2.wait());
+
+    QVERIFY(thread1.opened);
+    QVERIFY(!thread1.isDefault);
+    QVERIFY(thread1.lastQueryIsEmpty);
+    QVERIFY(!connect.lastQuery().lastQuery().isEmpty());
+    QCOMPARE(thread1.count , 2);
+    QCOMPARE(thread2.count , 2);
+
+    QCOMPARE(pool.size() , 0); // The clones are released on thread exit
+
+    connect.setToDefaultConnection();
+    QVERIFY(DQConnection::defaultConnection() == connect);
+
+    // Disable the recording of last query
+    connect.setLastQueryEnabled(false);
+    QCOMPARE(query.count() , 2);
+    QVERIFY(connect.lastQuery().lastQuery().isEmpty());
+    connect.setLastQueryEnabled(true);
+}
+
+void SqliteTests::prefetch(){
+    DQQuery<Config> query;
+    QVERIFY(query.remove());
+
+    for (int i = 0 ; i < 3;i++) {
+        User user;
+        user.userId = QString("prefetch%1").arg(i);
+        user.name = QString("prefetch user %1").arg(i);
+        user.passwd = "12345678";
+        QVERIFY(user.save());
+
+        // Two config records per user
+        for (int j = 0 ; j < 2;j++) {
+            Config config;
+            config.key = QString("prefetch%1").arg(j);
+            config.value = user.name;
+            config.uid = user.id;
+            QVERIFY(config.save());
+        }
+    }
+
+    DQList<Config> list = query.orderBy("id").all();
+    QCOMPARE(list.size() , 6);
+    QVERIFY(!list.at(0)->uid.isLoaded());
+
+    list = query.prefetch("uid").orderBy("id").all();
+    QCOMPARE(list.size() , 6);
+
+    for (int i = 0 ; i < list.size();i++) {
+        Config* config = list.at(i);
+        QVERIFY(config->uid.isLoaded());
+        QVERIFY(config->uid->name == config->value);
+    }
+
+    // A copy hold its own linked model
+    Config copy = *list.at(0);
+    QVERIFY(copy.uid.isLoaded());
+    QVERIFY(copy.uid->name == list.at(0)->value);
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::selectRelated(){
+    DQQuery<Config> query;
+    QVERIFY(query.remove());
+
+    User user;
+    user.userId = "selectRelated";
+    user.name = "selectRelated user";
+    user.passwd = "12345678";
+    QVERIFY(user.save());
+
+    Config config;
+    config.key = "selectRelated";
+    config.value = "1";
+    config.uid = user.id;
+    QVERIFY(config.save());
+
+    DQSqliteStatement statement;
+    QString sql = statement.select(query.selectRelated("uid"));
+    QVERIFY(sql.startsWith("SELECT m.*,r0.id AS uid__id,r0.userId AS uid__userId,"));
+    QVERIFY(sql.contains("FROM ( SELECT ALL * FROM config ) AS m LEFT JOIN user AS r0 ON m.uid = r0.id"));
+
+    DQList<Config> list = query.selectRelated("uid").filter(DQWhere("key") == "selectRelated").all();
+    QCOMPARE(list.size() , 1);
+    QVERIFY(list.at(0)->key == "selectRelated");
+    QVERIFY(list.at(0)->uid.isLoaded());
+    QVERIFY(list.at(0)->uid->name == "selectRelated user");
+    QVERIFY(list.at(0)->uid->userId == "selectRelated");
+
+    // "id" is a column of both tables
+    list = query.selectRelated("uid").orderBy(QStringList() << "lower(key)" << "id desc").all();
+    QCOMPARE(list.size() , 1);
+    QVERIFY(list.at(0)->uid->name == "selectRelated user");
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::typedField(){
+    TypedModel model1;
+    model1.name = "typed";
+    model1.count = 3;
+    model1.tags = QStringList() << "a" << "b";
+    QVERIFY(model1.save());
+
+    TypedModel model2;
+    QVERIFY(model2.load(DQWhere("id") == model1.id()));
+    QVERIFY(model2.name == "typed");
+    QCOMPARE(model2.count.value() , 3);
+    QVERIFY(model2.weight.isNull()); // Null field is skipped on save
+    QCOMPARE(model2.tags.value() , QStringList() << "a" << "b");
+
+    QVERIFY(model2.remove());
+}
+
+void SqliteTests::dirtyUpdate(){
+    HealthCheck model1;
+    model1.name = "dirtyUpdate";
+    model1.height = 150;
+    model1.weight = 50;
+    QVERIFY(model1.save());
+    QVERIFY(!model1.name.isDirty());
+    QVERIFY(!model1.id.isDirty());
+
+    HealthCheck model2;
+    QVERIFY(model2.load(DQWhere("id") == model1.id()));
+    QVERIFY(!model2.height.isDirty());
+
+    // Nothing is changed. No statement is executed
+    QString last = connect.lastQuery().lastQuery();
+    QVERIFY(model2.save());
+    QCOMPARE(connect.lastQuery().lastQuery() , last);
+
+    model2.height = 160;
+    QVERIFY(model2.save());
+    QCOMPARE(connect.lastQuery().lastQuery() , QString("UPDATE healthcheck SET height = :height WHERE id = :id;"));
+    QVERIFY(model2.id == model1.id());
+
+    HealthCheck model3;
+    QVERIFY(model3.load(DQWhere("id") == model1.id()));
+    QVERIFY(model3.height == 160);
+    QVERIFY(model3.weight == 50.0);
+
+    // The record is removed by other, it is inserted again
+    QVERIFY(model3.remove());
+    model2.weight = 55;
+    QVERIFY(model2.save());
+    QVERIFY(model3.load(DQWhere("id") == model1.id()));
+    QVERIFY(model3.height == 160);
+    QVERIFY(model3.weight == 55.0);
+
+    QVERIFY(model3.remove());
+}
+
+void SqliteTests::upsert(){
+    DQSqliteStatement statement;
+    QString sql = statement.upsert(dqMetaInfo<User>(),QStringList() << "userId" << "name",QStringList("userId"));
+    QCOMPARE(sql , QString("INSERT INTO user (userId,name) values (:userId,:name) ON CONFLICT(userId) DO UPDATE SET name = excluded.name;"));
+
+    User user1;
+    user1.userId = "upsert";
+    user1.name = "upsert 1";
+    user1.passwd = "12345678";
+    QVERIFY(user1.upsert());
+    QVERIFY(!user1.id->isNull());
+
+    // Conflict with user1 on the unique field "userId"
+    User user2;
+    user2.userId = "upsert";
+    user2.name = "upsert 2";
+    user2.passwd = "87654321";
+    QVERIFY(user2.upsert());
+    QVERIFY(user2.id == user1.id()); // The row is updated in place
+
+    DQQuery<User> query = DQQuery<User>().filter(DQWhere("userId") == "upsert");
+    QCOMPARE(query.count() , 1);
+
+    User user3;
+    QVERIFY(user3.load(DQWhere("userId") == "upsert"));
+    QVERIFY(user3.name == "upsert 2");
+    QVERIFY(user3.passwd == "87654321");
+
+    QVERIFY(user3.remove());
+
+    // The target is the first DQUnique field , not all of them
+    QVERIFY(connect.addModel<Product>());
+    QVERIFY(connect.createTables());
+    QVERIFY(DQQuery<Product>().remove());
+
+    Product product1;
+    product1.sku = "A-1";
+    product1.barcode = "1001";
+    product1.name = "first";
+    QVERIFY(product1.upsert());
+
+    Product product2;
+    product2.sku = "A-1";
+    product2.barcode = "1002";
+    product2.name = "second";
+    QVERIFY(product2.upsert());
+    QVERIFY(product2.id == product1.id());
+    QCOMPARE(DQQuery<Product>().count() , 1);
+
+    // A NULL conflict column never conflicts , the record is inserted
+    Product product3;
+    product3.barcode = "1003";
+    product3.name = "third";
+    QVERIFY(product3.upsert());
+    QVERIFY(!product3.id->isNull());
+    QVERIFY(product3.id != product1.id());
+
+    // Another UNIQUE column is given explicitly
+    Product product4;
+    product4.sku = "A-4";
+    product4.barcode = "1003";
+    product4.name = "fourth";
+    QVERIFY(product4.upsert(QStringList("barcode")));
+    QVERIFY(product4.id == product3.id());
+    QCOMPARE(DQQuery<Product>().count() , 2);
+
+    QVERIFY(DQQuery<Product>().remove());
+}
+
+void SqliteTests::bulkUpdate(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    DQList<HealthCheck> list;
+    DQListWriter writer(&list);
+    writer << "tester 1" << 160 << 50 << writer.next()
+           << "tester 2" << 120 << 30 << writer.next()
+           << "tester 3" << 170 << 60 << writer.next();
+    writer.close();
+    QVERIFY(list.save());
+
+    QVariantMap assignments;
+    assignments["height"] = DQWhere("height") + 10;
+    assignments["weight"] = 45;
+
+    QCOMPARE(query.filter(DQWhere("height") > 150).update(assignments) , 2);
+    QVERIFY(connect.lastQuery().lastQuery().startsWith("UPDATE healthcheck SET height = height + :set0_0,weight = :set1 WHERE"));
+
+    QCOMPARE(query.filter(DQWhere("height") == 170).count() , 1);
+    QCOMPARE(query.filter(DQWhere("height") == 180).count() , 1);
+    QCOMPARE(query.filter(DQWhere("weight") == 45).count() , 2);
+    QCOMPARE(query.filter(DQWhere("height") == 120).count() , 1); // Not matched
+
+    QCOMPARE(query.update(QVariantMap()) , 0);
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::pagination(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    DQList<HealthCheck> list;
+    DQListWriter writer(&list);
+    writer << "tester 1" << 160 << 50 << writer.next()
+           << "tester 2" << 120 << 30 << writer.next()
+           << "tester 3" << 170 << 60 << writer.next()
+           << "tester 4" << 160 << 55 << writer.next()
+           << "tester 5" << 150 << 40 << writer.next();
+    writer.close();
+    QVERIFY(list.save());
+
+    DQSqliteStatement statement;
+    QString sql = statement.select(query.orderBy("height").limit(2).offset(1));
+    QCOMPARE(sql , QString("SELECT ALL * FROM healthcheck ORDER BY height LIMIT 2 OFFSET 1 ;"));
+
+    sql = statement.select(query.offset(3));
+    QCOMPARE(sql , QString("SELECT ALL * FROM healthcheck LIMIT -1 OFFSET 3 ;"));
+
+    DQList<HealthCheck> page = query.orderBy("height").limit(2).offset(1).all();
+    QCOMPARE(page.size() , 2);
+    QVERIFY(page.at(0)->height == 150);
+
+    // Keyset pagination. "height" is not unique
+    QStringList names;
+    DQQuery<HealthCheck> pageQuery = query.filter(DQWhere("weight") > 35).limit(2);
+    page = pageQuery.orderBy(QStringList() << "height" << "id").all(); // First page
+    int pages = 0;
+    while (page.size() > 0) {
+        pages++;
+        for (int i = 0 ; i < page.size();i++)
+            names << page.at(i)->name;
+        page = pageQuery.after(*page.at(page.size() - 1),"height").all();
+    }
+    QCOMPARE(pages , 2);
+    QCOMPARE(names.join(",") , QString("tester 5,tester 1,tester 4,tester 3"));
+
+    // Descending order
+    names.clear();
+    page = pageQuery.orderBy(QStringList() << "height desc" << "id desc").all();
+    while (page.size() > 0) {
+        for (int i = 0 ; i < page.size();i++)
+            names << page.at(i)->name;
+        page = pageQuery.after(*page.at(page.size() - 1),"height desc").all();
+    }
+    QCOMPARE(names.join(",") , QString("tester 3,tester 4,tester 1,tester 5"));
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::resultCache(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    HealthCheck model;
+    model.name = "tester 1";
+    model.height = 160;
+    QVERIFY(model.save());
+
+    DQSql sql = connect.sql();
+    sql.setResultCacheEnabled(true);
+    sql.clearResultCache();
+
+    QCOMPARE(DQQuery<HealthCheck>().count() , 1);
+    QCOMPARE(DQQuery<HealthCheck>().count() , 1);
+    QCOMPARE(sql.resultCacheHits() , 1);
+
+    DQList<HealthCheck> list = query.filter(DQWhere("height") > 150).all();
+    QCOMPARE(list.size() , 1);
+    list = query.filter(DQWhere("height") > 150).all();
+    QCOMPARE(list.size() , 1);
+    QVERIFY(list.at(0)->name == "tester 1");
+    QCOMPARE(sql.resultCacheHits() , 2);
+
+    // A hit leaves no state of the previous execution
+    DQQuery<HealthCheck> reused = query.filter(DQWhere("height") > 155);
+    QCOMPARE(reused.count() , 1);
+    QVERIFY(reused.lastQuery().lastQuery().contains("count"));
+    QCOMPARE(reused.count() , 1);
+    QCOMPARE(sql.resultCacheHits() , 3);
+    QVERIFY(reused.lastQuery().lastQuery().isEmpty());
+    QVERIFY(!reused.lastError().isValid());
+
+    // Different bind values
+    QCOMPARE(query.filter(DQWhere("height") > 170).all().size() , 0);
+    QCOMPARE(sql.resultCacheHits() , 3);
+
+    // The values differ beyond the precision of QVariant::toString()
+    QCOMPARE(query.filter(DQWhere("height") > 159.99999999999997).count() , 1);
+    QCOMPARE(query.filter(DQWhere("height") > 160.00000000000003).count() , 0);
+    QCOMPARE(sql.resultCacheHits() , 3);
+
+    // Writes invalidate the cached results
+    HealthCheck model2;
+    model2.name = "tester 2";
+    model2.height = 180;
+    QVERIFY(model2.save());
+    QCOMPARE(DQQuery<HealthCheck>().count() , 2);
+    QCOMPARE(query.filter(DQWhere("height") > 150).all().size() , 2);
+    QCOMPARE(sql.resultCacheHits() , 3);
+
+    QVERIFY(query.filter(DQWhere("height") > 170).remove());
+    QCOMPARE(DQQuery<HealthCheck>().count() , 1);
+
+    // Result larger than the memory limit is not cached
+    sql.setResultCacheMaxSize(1);
+    QCOMPARE(DQQuery<HealthCheck>().count() , 1);
+    QCOMPARE(DQQuery<HealthCheck>().count() , 1);
+    QCOMPARE(sql.resultCacheHits() , 3);
+
+    sql.setResultCacheMaxSize(4 * 1024 * 1024);
+    sql.setResultCacheEnabled(false);
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::identityMap(){
+    DQQuery<Config> query;
+    QVERIFY(query.remove());
+    QVERIFY(DQQuery<User>().filter(DQWhere("userId").like("identity%")).remove());
+
+    User user;
+    user.userId = "identity0";
+    user.name = "identity user";
+    user.passwd = "12345678";
+    QVERIFY(user.save());
+
+    for (int i = 0 ; i < 3;i++) {
+        Config config;
+        config.key = QString("identity%1").arg(i);
+        config.uid = user.id;
+        QVERIFY(config.save());
+    }
+
+    DQSql sql = connect.sql();
+    connect.setIdentityMapEnabled(true,10);
+    QVERIFY(connect.isIdentityMapEnabled());
+    QCOMPARE(sql.identityMapCapacity() , 10);
+    sql.clearIdentityMap();
+
+    // The linked user is read from database once only
+    DQList<Config> list = query.orderBy("id").all();
+    QCOMPARE(list.size() , 3);
+    for (int i = 0 ; i < list.size();i++) {
+        QVERIFY(list.at(i)->uid->name == "identity user");
+    }
+    QCOMPARE(sql.identityMapHits() , 2);
+
+    User copy;
+    QVERIFY(copy.load(DQWhere("id") == user.id()));
+    QVERIFY(copy.userId == "identity0");
+    QCOMPARE(sql.identityMapHits() , 3);
+
+    // Save invalidates the entries of the table
+    user.name = "identity user 2";
+    QVERIFY(user.save());
+    QVERIFY(copy.load(DQWhere("id") == user.id()));
+    QVERIFY(copy.name == "identity user 2");
+    QCOMPARE(sql.identityMapHits() , 3);
+
+    // Remove
+    QVERIFY(user.remove());
+    QVERIFY(!copy.load(DQWhere("id") == copy.id()));
+
+    // Other filters are not served by the identity map
+    QVERIFY(!copy.load(DQWhere("userId") == "identity0"));
+    QCOMPARE(sql.identityMapHits() , 3);
+
+    connect.setIdentityMapEnabled(false);
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::columnarResult(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    // More than 32 records to use multiple words of the null bitmap
+    for (int i = 0 ; i < 40;i++) {
+        HealthCheck model;
+        model.name = QString("tester %1").arg(i % 4);
+        model.height = 150 + i;
+        if (i % 10 != 0)
+            model.weight = 50.5 + i;
+        QVERIFY(model.save());
+    }
+
+    DQColumnarResult result = query.orderBy("id").columns(QStringList() << "height" << "weight" << "name");
+    QCOMPARE(result.rowCount() , 40);
+    QCOMPARE(result.columnCount() , 3);
+    QCOMPARE(result.indexOf("weight") , 1);
+    QVERIFY(result.type(0) == DQColumnarResult::Integer);
+    QVERIFY(result.type(1) == DQColumnarResult::Real);
+    QVERIFY(result.type(2) == DQColumnarResult::Text);
+
+    const QVector<qint64> &height = result.integers(0);
+    const QVector<double> &weight = result.reals(1);
+    QCOMPARE(height.size() , 40);
+    QCOMPARE(weight.size() , 40);
+    QCOMPARE(result.nullBitmap(1).size() , 2);
+
+    qint64 total = 0;
+    for (int i = 0 ; i < height.size();i++) {
+        total += height[i];
+    }
+    QCOMPARE(total , (qint64) DQQuery<HealthCheck>().call("sum","height").toLongLong());
+
+    for (int i = 0 ; i < 40;i++) {
+        QCOMPARE(result.isNull(1,i) , i % 10 == 0);
+        if (i % 10 != 0)
+            QCOMPARE(weight[i] , 50.5 + i);
+    }
+    QVERIFY(result.value(1,0).isNull());
+
+    // Repeated strings are stored once
+    QCOMPARE(result.textPool(2).size() , 4);
+    QCOMPARE(result.text(2,5) , QString("tester 1"));
+    QCOMPARE(result.value(2,6).toString() , QString("tester 2"));
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::evaluatorColumnar(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    for (int i = 0 ; i < 40;i++) {
+        HealthCheck model;
+        model.name = QString("tester %1").arg(i % 4);
+        model.height = 150 + i;
+        if (i % 10 != 0)
+            model.weight = 50.5 + i;
+        QVERIFY(model.save());
+    }
+
+    DQColumnarResult result = query.orderBy("id").columns(QStringList() << "height" << "weight" << "name");
+    DQList<HealthCheck> list = query.orderBy("id").all();
+
+    // The in-memory result should be equal to SQL
+    QList<DQWhere> filters;
+    filters << (DQWhere("height") > 170)
+            << (DQWhere("weight") <= 70.5)
+            << DQWhere("height").between(155,165)
+            << DQWhere("height").in(QList<QVariant>() << 150 << 160 << 500)
+            << DQWhere("height").notIn(QList<QVariant>() << 150 << 160)
+            << (DQWhere("name") == "tester 1")
+            << DQWhere("name").like("%3")
+            << (DQWhere("height") * 2 > 350)
+            << (DQWhere("name") == "tester 2" || DQWhere("weight") > 80);
+
+    foreach (DQWhere where , filters) {
+        DQEvaluator evaluator(where);
+        int count = query.filter(where).count();
+        QCOMPARE(evaluator.select(result).size() , count);
+        QCOMPARE(evaluator.select(list).size() , count);
+        QCOMPARE(evaluator.call("count",result).toInt() , count);
+
+        QCOMPARE(evaluator.call("sum",result,"height").toLongLong() , query.filter(where).call("sum","height").toLongLong());
+        QCOMPARE(evaluator.call("sum",list,"height").toLongLong() , query.filter(where).call("sum","height").toLongLong());
+        QCOMPARE(evaluator.call("max",result,"weight") , query.filter(where).call("max","weight"));
+        QCOMPARE(evaluator.call("min",result,"name").toString() , query.filter(where).call("min","name").toString());
+    }
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::bindParameters(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    for (int i = 0 ; i < 10;i++) {
+        HealthCheck model;
+        model.name = QString("tester %1").arg(i % 2);
+        model.height = 150 + i * 5;
+        QVERIFY(model.save());
+    }
+
+    DQQuery<HealthCheck> filtered = query.filter(DQWhere("height") > 0 && DQWhere("name") == "");
+    QCOMPARE(filtered.parameterCount() , 2);
+    QCOMPARE(filtered.count() , 0);
+
+    DQSql sql = connect.sql();
+    filtered = query.filter(DQWhere("height") > 0 && DQWhere("name") == "");
+    filtered.all();
+    int hits = sql.statementCacheHits();
+
+    for (int i = 0 ; i < 10;i++) {
+        int height = 150 + i * 5;
+        DQList<HealthCheck> list = filtered.bind(0,height).bind(1,"tester 0").all();
+        QCOMPARE(list.size() , (9 - i) / 2);
+        for (int j = 0 ; j < list.size();j++) {
+            QVERIFY(list.at(j)->height > height);
+            QVERIFY(list.at(j)->name == "tester 0");
+        }
+    }
+
+    // The prepared statement is reused
+    QCOMPARE(sql.statementCacheHits() , hits + 10);
+
+    // The original query is not changed
+    QCOMPARE(filtered.all().size() , 0);
+
+    // Changing the rules generates the statement again
+    QCOMPARE(filtered.bind(1,"tester 1").limit(2).all().size() , 2);
+
+    DQQuery<HealthCheck> between = query.filter(DQWhere("height").between(0,0));
+    QCOMPARE(between.parameterCount() , 2);
+    QCOMPARE(between.bind(0,160).bind(1,170).count() , 3);
+
+    // A short in() takes one position per item
+    DQQuery<HealthCheck> shortIn = query.filter(DQWhere("height").in(QList<QVariant>() << 150 << 155 << 160) &&
+                                                DQWhere("name") == "");
+    QCOMPARE(shortIn.parameterCount() , 4);
+    QCOMPARE(shortIn.bind(3,"tester 0").count() , 2);
+
+    // A long in() is bound as a single JSON array
+    QList<QVariant> heights;
+    for (int i = 0 ; i < 100;i++) {
+        heights << 100 + i;
+    }
+    DQQuery<HealthCheck> longIn = query.filter(DQWhere("height").in(heights) && DQWhere("name") == "");
+    QCOMPARE(longIn.parameterCount() , 2);
+    QCOMPARE(longIn.bind(1,"tester 0").count() , 5);
+    QCOMPARE(longIn.bind(0,"[150,155]").bind(1,"tester 0").count() , 1);
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::asyncQuery(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    for (int i = 0 ; i < 5;i++) {
+        HealthCheck model;
+        model.name = QString("tester %1").arg(i);
+        model.height = 150 + i * 10;
+        QVERIFY(model.save());
+    }
+
+    QFuture<DQSharedList> all = query.filter(DQWhere("height") > 160).orderBy("height").allAsync();
+    QFuture<int> count = query.countAsync();
+    QFuture<QVariant> max = query.callAsync("max",QStringList() << "height");
+
+    DQList<HealthCheck> list = all.result();
+    QCOMPARE(list.size() , 3);
+    QVERIFY(list.at(0)->name == "tester 2");
+    QVERIFY(list.at(2)->height == 190);
+
+    QCOMPARE(count.result() , 5);
+    QCOMPARE(max.result().toInt() , 190);
+
+    // The query object itself is not changed by the async call
+    QCOMPARE(query.all().size() , 5);
+
+    // A closed connection do not run the query
+    DQConnection closed;
+    DQQuery<HealthCheck> other;
+    other.setConnection(closed);
+    QFuture<int> canceled = other.countAsync();
+    canceled.waitForFinished();
+    QVERIFY(canceled.isCanceled());
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::writeBehind(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    // Only written on batch size or flush
+    connect.setWriteBehindEnabled(true,10,0,20);
+    QVERIFY(connect.isWriteBehindEnabled());
+
+    for (int i = 0 ; i < 25;i++) {
+        HealthCheck model;
+        model.name = QString("writer %1").arg(i);
+        model.height = 100 + i;
+        QVERIFY(model.save());
+        QVERIFY(model.id->isNull()); // Not updated in write-behind mode
+    }
+
+    QVERIFY(connect.waitForFlush());
+    QCOMPARE(connect.pendingWrites() , 0);
+    QCOMPARE(query.filter(DQWhere("name").like("writer%")).count() , 25);
+
+    HealthCheck last;
+    QVERIFY(last.load(DQWhere("name") == "writer 24"));
+    QVERIFY(last.height == 124);
+
+    // The pending rows are written on disable
+    for (int i = 0 ; i < 5;i++) {
+        HealthCheck model;
+        model.name = QString("later %1").arg(i);
+        QVERIFY(model.save());
+    }
+    connect.setWriteBehindEnabled(false);
+    QVERIFY(!connect.isWriteBehindEnabled());
+    QCOMPARE(query.filter(DQWhere("name").like("later%")).count() , 5);
+
+    QVERIFY(query.remove());
+}
+
+/// Read a PRAGMA value
+static QVariant pragmaValue(DQConnection connection,QString name) {
+    QSqlQuery query = connection.query();
+    if (!query.exec(QString("PRAGMA %1").arg(name)) || !query.next())
+        return QVariant();
+    return query.value(0);
+}
+
+void SqliteTests::connectionOptions(){
+    {
+        QSqlDatabase optionsDb = QSqlDatabase::addDatabase("QSQLITE","options");
+        optionsDb.setDatabaseName( "options.db" );
+        QVERIFY(optionsDb.open());
+
+        DQConnection connection;
+        QVERIFY(connection.open(optionsDb,DQConnectionOptions::profile("balanced")));
+        QVERIFY(connection != connect); // The default connection is not changed
+        QCOMPARE(connection.options().name , QString("balanced"));
+
+        QCOMPARE(pragmaValue(connection,"journal_mode").toString() , QString("wal"));
+        QCOMPARE(pragmaValue(connection,"synchronous").toInt() , 1);
+        QCOMPARE(pragmaValue(connection,"cache_size").toInt() , -16000);
+        QCOMPARE(pragmaValue(connection,"temp_store").toInt() , 2);
+        QCOMPARE(pragmaValue(connection,"busy_timeout").toInt() , 5000);
+
+        // The clone inherits the options
+        DQConnection clone = connection.clone("options_clone");
+        QVERIFY(clone.isOpen());
+        QCOMPARE(clone.options().name , QString("balanced"));
+        QCOMPARE(pragmaValue(clone,"synchronous").toInt() , 1);
+        QCOMPARE(pragmaValue(clone,"temp_store").toInt() , 2);
+
+        clone.close();
+        connection.close();
+
+        // The connection is closed if an option could not be applied
+        DQConnectionOptions invalid;
+        invalid.journalMode = "(";
+        QVERIFY(!connection.open(optionsDb,invalid));
+        QVERIFY(!connection.isOpen());
+        QVERIFY(connection.options().isNull());
+        QVERIFY(optionsDb.isOpen()); // The database is owned by the caller
+
+        optionsDb.close();
+    }
+    QSqlDatabase::removeDatabase("options_clone");
+    QSqlDatabase::removeDatabase("options");
+}
+
+void SqliteTests::profiling(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    for (int i = 0 ; i < 5;i++) {
+        HealthCheck model;
+        model.name = QString("profile %1").arg(i);
+        model.height = 150 + i;
+        QVERIFY(model.save());
+    }
+
+    QVERIFY(!connect.isProfilingEnabled());
+    QVERIFY(connect.queryStats().isEmpty());
+
+    connect.setProfilingEnabled(true);
+    QVERIFY(connect.isProfilingEnabled());
+
+    for (int i = 0 ; i < 3;i++) {
+        DQList<HealthCheck> list = query.filter(DQWhere("height") >= 150 + i).all();
+        QCOMPARE(list.size() , 5 - i);
+    }
+    QCOMPARE(query.filter(DQWhere("height") > 0).count() , 5);
+
+    QList<DQQueryStats> stats = connect.queryStats();
+    QCOMPARE(stats.size() , 2); // The select of different values is aggregated
+
+    DQQueryStats select;
+    foreach (DQQueryStats item , stats) {
+        if (item.rows > 0)
+            select = item;
+    }
+    QCOMPARE(select.calls , 3);
+    QCOMPARE(select.rows , Q_INT64_C(12));
+    QCOMPARE(select.failures , 0);
+    QVERIFY(!select.sql.contains(":"));
+
+    int histogramCalls = 0;
+    foreach (int calls , select.histogram) {
+        histogramCalls += calls;
+    }
+    QCOMPARE(histogramCalls , 3);
+    QVERIFY(select.maxTime <= select.totalTime());
+
+    connect.resetQueryStats();
+    QVERIFY(connect.queryStats().isEmpty());
+
+    connect.setProfilingEnabled(false);
+    query.all();
+    QVERIFY(connect.queryStats().isEmpty());
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::explain(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    DQQuery<HealthCheck> tall = query.filter(DQWhere("height") > 170).orderBy("weight");
+    DQQueryPlan plan = tall.explain();
+    QVERIFY(!plan.isEmpty());
+    QVERIFY(plan.hasFullScan());
+    QCOMPARE(plan.fullScanTables() , QStringList() << "healthcheck");
+
+    // A lookup by id do not scan
+    QVERIFY(!query.filter(DQWhere("id") == 1).explain().hasFullScan());
+
+    QCOMPARE(DQIndexAdvisor::indexColumns(tall) , QStringList() << "height");
+    QCOMPARE(DQIndexAdvisor::indexColumns(query.filter(DQWhere("name") == "a" && DQWhere("height") > 150)) ,
+             QStringList() << "name" << "height");
+    QCOMPARE(DQIndexAdvisor::indexColumns(query.filter(DQWhere("name") == "a").orderBy("weight desc")) ,
+             QStringList() << "name" << "weight");
+    QVERIFY(DQIndexAdvisor::indexColumns(query.filter(DQWhere("id") == 1)).isEmpty());
+
+    // Watch the queries run on connection
+    DQIndexAdvisor advisor;
+    connect.setIndexAdvisor(&advisor);
+
+    for (int i = 0 ; i < 3;i++) {
+        tall.bind(0,170 + i).all();
+    }
+    query.filter(DQWhere("id") == 1).all();
+
+    connect.setIndexAdvisor(0);
+    QVERIFY(connect.indexAdvisor() == 0);
+
+    QCOMPARE(advisor.analyzedCount() , 2);
+    QList<DQIndexAdvisor::Advice> advices = advisor.advices();
+    QCOMPARE(advices.size() , 1);
+    QCOMPARE(advices.first().name , QString("dq_healthcheck_height"));
+    QCOMPARE(advices.first().columns , QStringList() << "height");
+    QCOMPARE(advices.first().hits , 3);
+    QVERIFY(advices.first().statement.contains("CREATE INDEX"));
+
+    QVERIFY(advisor.apply(connect));
+    QVERIFY(!tall.explain().hasFullScan());
+
+    QVERIFY(connect.dropIndex("dq_healthcheck_height"));
+    advisor.clear();
+    QVERIFY(advisor.advices().isEmpty());
+}
+
+void SqliteTests::deferredField(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    DQList<HealthCheck> list;
+    DQListWriter writer(&list);
+
+    writer << "Tester 1 - Alvin" << 180 << 150 << writer.next()
+           << "Tester 2 - Ben" << 170 << 120 << writer.next();
+    QVERIFY(list.save());
+
+    DQQuery<HealthCheck> deferred = query.defer("name").orderBy("height");
+    list = deferred.all();
+    QCOMPARE(list.size() , 2);
+
+    QString sql = deferred.lastQuery().lastQuery();
+    QVERIFY(!sql.contains("name"));
+    QVERIFY(list.at(0)->name.isDeferred());
+    QVERIFY(!list.at(0)->height.isDeferred());
+    QVERIFY(list.at(0)->height == 170);
+
+    // Loaded on first access
+    QVERIFY(list.at(0)->name == "Tester 2 - Ben");
+    QVERIFY(!list.at(0)->name.isDeferred());
+    QVERIFY(!list.at(0)->name.isDirty());
+
+    // The untouched deferred field is not written
+    HealthCheck *record = list.at(1);
+    QVERIFY(record->name.isDeferred());
+    record->height = 181;
+    QVERIFY(record->save());
+    QVERIFY(record->name.isDeferred());
+    sql = connect.lastQuery().lastQuery();
+    QVERIFY(sql.startsWith("UPDATE"));
+    QVERIFY(!sql.contains("name"));
+
+    HealthCheck check;
+    QVERIFY(check.load(DQWhere("id") == record->id.get()));
+    QVERIFY(check.name == "Tester 1 - Alvin");
+    QVERIFY(check.height == 181);
+
+    // Assignment cancel the loading
+    list = deferred.all();
+    list.at(0)->name = "Tester 2 - Bob";
+    QVERIFY(!list.at(0)->name.isDeferred());
+    QVERIFY(list.at(0)->save());
+    QVERIFY(check.load(DQWhere("id") == list.at(0)->id.get()));
+    QVERIFY(check.name == "Tester 2 - Bob");
+
+    // Explicit select is not deferred
+    list = deferred.select(QStringList() << "id" << "name").all();
+    QVERIFY(!list.at(0)->name.isDeferred());
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::autoOnly(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    DQList<HealthCheck> list;
+    DQListWriter writer(&list);
+
+    writer << "Tester 1 - Alvin" << 180 << 150 << writer.next()
+           << "Tester 2 - Ben" << 170 << 120 << writer.next();
+    QVERIFY(list.save());
+
+    // Explicit column list
+    DQQuery<HealthCheck> only = query.only("name").orderBy("height");
+    list = only.all();
+    QCOMPARE(list.size() , 2);
+    QString sql = only.lastQuery().lastQuery();
+    QVERIFY(sql.startsWith("SELECT ALL id,name FROM"));
+    QVERIFY(!list.at(0)->name.isDeferred());
+    QVERIFY(list.at(0)->weight.isDeferred());
+    QVERIFY(list.at(0)->height == 170);
+
+    // The first 2 executions are sampled. Only the name is accessed.
+    for (int i = 0 ; i < 2;i++) {
+        list = DQQuery<HealthCheck>().filter(DQWhere("weight") > -1).autoOnly(2).all();
+        QCOMPARE(list.size() , 2);
+        QVERIFY(!list.at(0)->height.isDeferred());
+        QVERIFY(!list.at(1)->name.get().toString().isEmpty());
+    }
+
+    list = DQQuery<HealthCheck>().filter(DQWhere("weight") > -1).autoOnly(2).all();
+    sql = connect.lastQuery().lastQuery();
+    QVERIFY(sql.contains("name"));
+    QVERIFY(!sql.contains("height"));
+    QVERIFY(!list.at(0)->name.isDeferred());
+    QVERIFY(list.at(0)->height.isDeferred());
+    QVERIFY(list.at(0)->recordDate.isDeferred());
+
+    // The field loaded on demand is read by the next execution
+    QVERIFY(list.at(0)->height == 180 || list.at(0)->height == 170);
+    list = DQQuery<HealthCheck>().filter(DQWhere("weight") > -1).autoOnly(2).all();
+    QVERIFY(!list.at(0)->height.isDeferred());
+    QVERIFY(list.at(0)->recordDate.isDeferred());
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::blobStream(){
+    AllType record;
+    record.data = QByteArray("small");
+
+    // The record is not saved
+    DQBlobStream unsaved(&record,"data");
+    QVERIFY(!unsaved.open(QIODevice::ReadOnly));
+
+    QVERIFY(record.save());
+
+    DQBlobStream missing(&record,"missing");
+    QVERIFY(!missing.open(QIODevice::ReadOnly));
+
+    // Write in chunks
+    int chunk = 1000;
+    int count = 10;
+    QVERIFY(DQBlobStream::allocate(&record,"data",chunk * count));
+
+    DQBlobStream writer(&record,"data");
+    QVERIFY(writer.open(QIODevice::WriteOnly));
+    QCOMPARE(writer.size() , (qint64) chunk * count);
+    for (int i = 0 ; i < count;i++) {
+        QByteArray data(chunk,'a' + i);
+        QCOMPARE(writer.write(data) , (qint64) chunk);
+    }
+
+    // It could not grow
+    QVERIFY(writer.write("overflow") < 0);
+    writer.close();
+
+    // Random access read
+    DQBlobStream reader(&record,"data");
+    QVERIFY(reader.open(QIODevice::ReadOnly));
+    QVERIFY(reader.seek(chunk * 3));
+    QByteArray data = reader.read(chunk);
+    QVERIFY(data == QByteArray(chunk,'d'));
+    QVERIFY(reader.seek(chunk * count - 1));
+    QVERIFY(reader.read(10) == QByteArray(1,'j'));
+    QVERIFY(reader.atEnd());
+    reader.close();
+
+    // The model is not changed but the database is
+    QVERIFY(record.data == QByteArray("small"));
+    AllType loaded;
+    QVERIFY(loaded.load(DQWhere("id") == record.id.get()));
+    QByteArray value = loaded.data;
+    QCOMPARE(value.size() , chunk * count);
+    QVERIFY(value.mid(chunk * 9) == QByteArray(chunk,'j'));
+
+    QVERIFY(record.remove());
+}
+
+void SqliteTests::schemaCatalog(){
+    DQSql sql = connect.sql();
+
+    QVERIFY(sql.tables().contains("healthcheck"));
+    QCOMPARE(sql.columns("healthcheck") , dqMetaInfo<HealthCheck>()->columnNameList());
+    QVERIFY(sql.columns("not_existed").isEmpty());
+    QVERIFY(sql.indexExists("typedmodel_count"));
+
+    // Updated by DDL of DQSql
+    QVERIFY(sql.dropTable(dqMetaInfo<Model1>()));
+    QVERIFY(!sql.exists(dqMetaInfo<Model1>()));
+    QVERIFY(sql.createTableIfNotExists<Model1>());
+    QVERIFY(sql.exists(dqMetaInfo<Model1>()));
+    QCOMPARE(sql.columns(dqMetaInfo<Model1>()->name()) , dqMetaInfo<Model1>()->columnNameList());
+
+    DQIndex<HealthCheck> index("healthcheck_catalog");
+    index << "height";
+    QVERIFY(connect.createIndex(index));
+    QVERIFY(sql.indexExists("healthcheck_catalog"));
+    QVERIFY(connect.dropIndex("healthcheck_catalog"));
+    QVERIFY(!sql.indexExists("healthcheck_catalog"));
+
+    // Raw SQL is not detected until the catalog is cleared
+    QSqlQuery q = connect.query();
+    QVERIFY(q.exec("CREATE TABLE catalog_raw (id INTEGER PRIMARY KEY , value TEXT)"));
+    QVERIFY(!sql.tables().contains("catalog_raw"));
+    sql.clearSchemaCache();
+    QVERIFY(sql.tables().contains("catalog_raw"));
+    QCOMPARE(sql.columns("catalog_raw") , QStringList() << "id" << "value");
+
+    QVERIFY(q.exec("DROP TABLE catalog_raw"));
+    sql.clearSchemaCache();
+    QVERIFY(!sql.tables().contains("catalog_raw"));
+}
+
+void SqliteTests::migration(){
+    DQSql sql = connect.sql();
+    DQModelMetaInfo *info = dqMetaInfo<MigrationModel>();
+
+    // The table of an old version of the model
+    QSqlQuery q = connect.query();
+    QVERIFY(q.exec("DROP TABLE IF EXISTS migrationmodel"));
+    QVERIFY(q.exec("CREATE TABLE migrationmodel (id INTEGER PRIMARY KEY AUTOINCREMENT , name TEXT , obsolete TEXT)"));
+    QVERIFY(q.exec("INSERT INTO migrationmodel (name,obsolete) VALUES ('a','x'),('b','y'),('c','z')"));
+    QVERIFY(q.exec("DELETE FROM migrationmodel WHERE name = 'c'"));
+    sql.clearSchemaCache();
+
+    QVERIFY(connect.addModel<MigrationModel>());
+
+    // "code" is UNIQUE, it can't be added
+    QVERIFY(!connect.migrate());
+    QStringList columns = sql.columns(info->name());
+    QCOMPARE(columns , QStringList() << "id" << "name" << "obsolete" << "count");
+    QVERIFY(sql.indexExists("migrationmodel_count"));
+
+    DQQuery<MigrationModel> query;
+    QCOMPARE(query.count() , 2);
+
+    MigrationModel record;
+    QVERIFY(record.load(DQWhere("name") == "b"));
+    QVERIFY(record.count == 0);
+
+    // The index of an expression could not be created again , the table is unchanged
+    QVERIFY(q.exec("CREATE INDEX migrationmodel_expression ON migrationmodel (obsolete || name)"));
+    QVERIFY(!connect.rebuildTable<MigrationModel>(1));
+    QCOMPARE(sql.columns(info->name()) , columns);
+    QVERIFY(sql.indexExists("migrationmodel_expression"));
+    QCOMPARE(query.count() , 2);
+    QVERIFY(q.exec("DROP INDEX migrationmodel_expression"));
+
+    // The explicit rebuild. The index of removed column is dropped
+    QVERIFY(q.exec("CREATE INDEX migrationmodel_obsolete ON migrationmodel (obsolete)"));
+    sql.clearSchemaCache();
+    QVERIFY(connect.rebuildTable<MigrationModel>(1));
+    QCOMPARE(sql.columns(info->name()) , info->columnNameList());
+    QVERIFY(sql.indexExists("migrationmodel_count"));
+    QVERIFY(!sql.indexExists("migrationmodel_obsolete"));
+    QCOMPARE(query.count() , 2);
+    QVERIFY(record.load(DQWhere("name") == "b"));
+    QCOMPARE(record.id.get().toInt() , 2);
+
+    // The AUTOINCREMENT sequence is kept
+    MigrationModel added;
+    added.name = "d";
+    added.code = "D";
+    QVERIFY(added.save());
+    QCOMPARE(added.id.get().toInt() , 4);
+
+    // UNIQUE is enforced
+    QVERIFY(!q.exec("INSERT INTO migrationmodel (name,code) VALUES ('e','D')"));
+
+    QVERIFY(connect.migrate());
+
+    QVERIFY(sql.dropTable(info));
+}
+
+/// The row type of valuesList() test
+struct HealthCheckRow {
+    QString name;
+    int height;
+    double weight;
+};
+
+void SqliteTests::valuesList(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    DQList<HealthCheck> list;
+    DQListWriter writer(&list);
+
+    writer << "Tester 1 - Alvin" << 180 << 150.5 << writer.next()
+           << "Tester 2 - Ben" << 170 << 120 << writer.next()
+           << "Tester 3 - Candy" << 150 << 180 << writer.next();
+    QVERIFY(list.save());
+
+    DQQuery<HealthCheck> sorted = query.orderBy("height");
+
+    QVector<int> heights = sorted.valuesList<int>("height");
+    QCOMPARE(heights.size() , 3);
+    QCOMPARE(heights.at(0) , 150);
+    QCOMPARE(heights.at(2) , 180);
+
+    QVector<QPair<QString,int> > pairs = sorted.filter(DQWhere("height") > 160).valuesList<QString,int>("name","height");
+    QCOMPARE(pairs.size() , 2);
+    QCOMPARE(pairs.at(0).first , QString("Tester 2 - Ben"));
+    QCOMPARE(pairs.at(0).second , 170);
+
+    QVector<HealthCheckRow> rows = sorted.valuesList("name",&HealthCheckRow::name,
+                                                     "height",&HealthCheckRow::height,
+                                                     "weight",&HealthCheckRow::weight);
+    QCOMPARE(rows.size() , 3);
+    QCOMPARE(rows.at(2).name , QString("Tester 1 - Alvin"));
+    QCOMPARE(rows.at(2).height , 180);
+    QCOMPARE(rows.at(2).weight , 150.5);
+
+    // Invalid field
+    QVERIFY(sorted.valuesList<int>("not_existed").isEmpty());
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::aggregate(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    DQList<HealthCheck> list;
+    DQListWriter writer(&list);
+
+    writer << "A" << 180 << 150 << writer.next()
+           << "A" << 170 << 120 << writer.next()
+           << "B" << 150 << 180 << writer.next()
+           << "C" << 130 << 130 << writer.next()
+           << "C" << 140 << 100 << writer.next()
+           << "C" << 160 << 90 << writer.next();
+    for (int i = 0 ; i < list.size();i++) {
+        list.at(i)->recordDate = QDate(2014,3,1).addDays(i);
+    }
+    QVERIFY(list.save());
+
+    QList<DQAggregate> aggregates;
+    aggregates << DQAggregate("sum","height") << DQAggregate("count") << DQAggregate("avg","weight","mean");
+
+    DQColumnarResult result = query.groupBy("name").orderBy("name").aggregate(aggregates);
+    QCOMPARE(result.rowCount() , 3);
+    QCOMPARE(result.columnNames() , QStringList() << "name" << "sum_height" << "count_all" << "mean");
+    QCOMPARE(result.type(1) , DQColumnarResult::Integer);
+    QCOMPARE(result.type(2) , DQColumnarResult::Integer);
+    QCOMPARE(result.type(3) , DQColumnarResult::Real);
+
+    QCOMPARE(result.text(0,0) , QString("A"));
+    QCOMPARE(result.integers(1).at(0) , (qint64) 350);
+    QCOMPARE(result.integers(2).at(2) , (qint64) 3);
+    QCOMPARE(result.reals(3).at(0) , 135.0);
+
+    // HAVING with the bound values of WHERE
+    result = query.filter(DQWhere("height") > 135)
+                  .groupBy("name")
+                  .having(DQWhere("count_all") > 1)
+                  .orderBy("name")
+                  .aggregate(aggregates);
+    QCOMPARE(result.rowCount() , 2);
+    QCOMPARE(result.text(0,1) , QString("C"));
+    QCOMPARE(result.integers(1).at(1) , (qint64) 300);
+
+    // Without groupBy() , it is a single row
+    result = query.aggregate(QList<DQAggregate>() << DQAggregate("max","height"));
+    QCOMPARE(result.rowCount() , 1);
+    QCOMPARE(result.integers(0).at(0) , (qint64) 180);
+
+    // max() of a date keeps the type of field
+    result = query.aggregate(QList<DQAggregate>() << DQAggregate("max","recordDate"));
+    QCOMPARE(result.rowCount() , 1);
+    QCOMPARE(result.type(0) , DQColumnarResult::Text);
+    QCOMPARE(QDate::fromString(result.text(0,0),Qt::ISODate) , QDate(2014,3,6));
+
+    // HAVING is kept without groupBy()
+    QString sql = connect.sql().statement()->select(query.having(DQWhere("count(*)") > 1));
+    QVERIFY(sql.contains(" HAVING count(*) > "));
+    QVERIFY(!sql.contains("GROUP BY"));
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::subquery(){
+    QVERIFY(DQQuery<ExamResult>().remove());
+    QVERIFY(DQQuery<User>().remove());
+
+    QStringList names;
+    names << "Alvin" << "Ben" << "Candy";
+    DQList<User> users;
+    foreach (QString name , names) {
+        User *user = new User();
+        user->userId = name.toLower();
+        user->name = name;
+        user->passwd = "12345678";
+        users.append(user);
+    }
+    QVERIFY(users.save());
+
+    int marks[] = { 40 , 90 , 70 };
+    for (int i = 0 ; i < 2;i++) {
+        for (int j = 0 ; j < 3;j++) {
+            ExamResult result;
+            result.uid = *users.at(i);
+            result.subject = QString("Subject %1").arg(j);
+            result.mark = marks[j] - i * 30;
+            QVERIFY(result.save());
+        }
+    }
+
+    // Alvin: 40,90,70 Ben: 10,60,40 Candy: none
+    DQQuery<ExamResult> passed = DQQuery<ExamResult>().filter(DQWhere("mark") > 80);
+
+    DQQuery<User> query = DQQuery<User>().filter(DQWhere("name") != "Ben" &&
+                                                 DQWhere("id").in(passed.select("uid")));
+    QCOMPARE(query.parameterCount() , 2);
+    QCOMPARE(query.count() , 1);
+    QCOMPARE(query.call("max","name").toString() , QString("Alvin"));
+
+    // Select "id" if no field is given
+    QCOMPARE(DQQuery<User>().filter(DQWhere("id").in(DQQuery<User>().filter(DQWhere("name") == "Ben"))).count() , 1);
+
+    QCOMPARE(DQQuery<User>().filter(DQWhere("id").notIn(DQQuery<ExamResult>().select("uid"))).count() , 1);
+
+    // Correlated subquery
+    DQWhere hasFailed = DQWhere::exists(DQQuery<ExamResult>().filter(DQWhere("uid") == DQWhere("user.id") &&
+                                                                       DQWhere("mark") < 50));
+    QCOMPARE(DQQuery<User>().filter(hasFailed).count() , 2);
+    QCOMPARE(DQQuery<User>().filter(hasFailed && DQWhere("name") == "Ben").count() , 1);
+    QCOMPARE(DQQuery<User>().filter(DQWhere::notExists(DQQuery<ExamResult>().filter(DQWhere("uid") == DQWhere("user.id"))))
+             .call("max","name").toString() , QString("Candy"));
+
+    QVERIFY(DQQuery<ExamResult>().remove());
+    QVERIFY(DQQuery<User>().remove());
+}
+
+void SqliteTests::largeInList(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    DQList<HealthCheck> list;
+    for (int i = 0 ; i < 2000;i++) {
+        HealthCheck *record = new HealthCheck();
+        record->name = QString("Tester \"%1\"").arg(i);
+        record->height = i;
+        record->weight = 50;
+        list.append(record);
+    }
+    QVERIFY(list.saveAll());
+
+    // Exceed the default limit of SQLite (999 parameters)
+    QList<QVariant> heights;
+    for (int i = 0 ; i < 3000;i+= 2) {
+        heights << i;
+    }
+    QCOMPARE(query.filter(DQWhere("height").in(heights)).count() , 1000);
+    QCOMPARE(query.filter(DQWhere("height").notIn(heights)).count() , 1000);
+
+    QList<QVariant> names;
+    for (int i = 0 ; i < 100;i++) {
+        names << QString("Tester \"%1\"").arg(i * 10);
+    }
+    QCOMPARE(query.filter(DQWhere("name").in(names)).count() , 100);
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::sharedCopy(){
+    QVERIFY(DQQuery<ExamResult>().remove());
+    QVERIFY(DQQuery<User>().remove());
+
+    User user;
+    user.userId = "shared";
+    user.name = "Shared";
+    user.passwd = "12345678";
+    QVERIFY(user.save());
+
+    ExamResult result;
+    result.uid = user;
+    result.subject = "English";
+    result.mark = 50;
+    QVERIFY(result.save());
+
+    // The copy shares the "linked" model until it is accessed
+    ExamResult copy(result);
+    QVERIFY(copy.uid.isLoaded());
+    QVERIFY(copy.uid.get() == user.id.get());
+
+    copy.uid->name = "Changed";
+    QCOMPARE(copy.uid->name.get().toString() , QString("Changed"));
+    QCOMPARE(result.uid->name.get().toString() , QString("Shared"));
+
+    ExamResult assigned;
+    assigned = result;
+    assigned.uid->name = "Assigned";
+    QCOMPARE(result.uid->name.get().toString() , QString("Shared"));
+
+    DQList<ExamResult> list;
+    for (int i = 0 ; i < 10;i++) {
+        result.subject = QString("Subject %1").arg(i);
+        QVERIFY(list.append(result));
+    }
+    QCOMPARE(list.at(9)->uid->name.get().toString() , QString("Shared"));
+    QCOMPARE(list.at(9)->subject.get().toString() , QString("Subject 9"));
+
+#ifdef Q_COMPILER_RVALUE_REFS
+    ExamResult moved(std::move(copy));
+    QCOMPARE(moved.uid->name.get().toString() , QString("Changed"));
+    QCOMPARE(moved.mark.get().toInt() , 50);
+
+    QVERIFY(list.append(std::move(moved)));
+    QCOMPARE(list.size() , 11);
+    QCOMPARE(list.at(10)->uid->name.get().toString() , QString("Changed"));
+#endif
+
+    QVERIFY(DQQuery<ExamResult>().remove());
+    QVERIFY(DQQuery<User>().remove());
+}
+
+void SqliteTests::snapshot(){
+    QFile::remove("snapshot.db");
+    {
+        QSqlDatabase snapshotDb = QSqlDatabase::addDatabase("QSQLITE","snapshot");
+        snapshotDb.setDatabaseName( "snapshot.db" );
+        QVERIFY(snapshotDb.open());
+
+        DQConnection connection;
+        QVERIFY(connection.open(snapshotDb,DQConnectionOptions::profile("balanced")));
+        QVERIFY(connection.addModel<HealthCheck>());
+        QVERIFY(connection.createTables());
+        QVERIFY(!connection.isSnapshot());
+
+        for (int i = 0 ; i < 3;i++) {
+            HealthCheck model;
+            model.setConnection(connection);
+            model.name = QString("snapshot %1").arg(i);
+            model.height = 150 + i;
+            QVERIFY(model.save());
+        }
+
+        DQConnection report = connection.snapshot("snapshot_report");
+        QVERIFY(report.isOpen());
+        QVERIFY(report.isSnapshot());
+        QCOMPARE(DQQuery<HealthCheck>(report).count() , 3);
+
+        // The writer is not blocked by the snapshot
+        for (int i = 3 ; i < 5;i++) {
+            HealthCheck model;
+            model.setConnection(connection);
+            model.name = QString("snapshot %1").arg(i);
+            model.height = 150 + i;
+            QVERIFY(model.save());
+        }
+        QCOMPARE(DQQuery<HealthCheck>(connection).count() , 5);
+
+        // The snapshot does not see the new records
+        QCOMPARE(DQQuery<HealthCheck>(report).count() , 3);
+        QCOMPARE(DQQuery<HealthCheck>(report).call("max","height").toInt() , 152);
+
+        // It is read-only
+        HealthCheck readOnly;
+        readOnly.setConnection(report);
+        readOnly.name = "read only";
+        QVERIFY(!readOnly.save());
+
+        DQConnection shared = report.snapshot("snapshot_shared");
+#ifdef SQLITE_ENABLE_SNAPSHOT
+        QVERIFY(shared.isOpen());
+        QCOMPARE(DQQuery<HealthCheck>(shared).count() , 3);
+        shared.close();
+#else
+        QVERIFY(!shared.isOpen());
+#endif
+
+        report.close();
+        QVERIFY(!report.isSnapshot());
+
+        // A new snapshot sees the latest state
+        report = connection.snapshot("snapshot_report2");
+        QCOMPARE(DQQuery<HealthCheck>(report).count() , 5);
+        report.close();
+
+        connection.close();
+        snapshotDb.close();
+    }
+    QSqlDatabase::removeDatabase("snapshot_shared");
+    QSqlDatabase::removeDatabase("snapshot_report2");
+    QSqlDatabase::removeDatabase("snapshot_report");
+    QSqlDatabase::removeDatabase("snapshot");
+    QFile::remove("snapshot.db");
+}
+
+/// Sum the height of HealthCheck records from several threads
+struct HeightSum {
+    HeightSum(QAtomicInt *sum,QAtomicInt *count) : sum(sum) , count(count) {
+    }
+
+    void operator()(HealthCheck& model) {
+        sum->fetchAndAddOrdered(model.height().toInt());
+        count->fetchAndAddOrdered(1);
+    }
+
+    QAtomicInt *sum;
+    QAtomicInt *count;
+};
+
+/// Count the records of any model
+struct RecordCount {
+    RecordCount(QAtomicInt *count) : count(count) {
+    }
+
+    void operator()(DQAbstractModel& model) {
+        Q_UNUSED(model);
+        count->fetchAndAddOrdered(1);
+    }
+
+    QAtomicInt *count;
+};
+
+void SqliteTests::parallelForEach(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    QAtomicInt sum,count;
+    QVERIFY(query.parallelForEach(4,HeightSum(&sum,&count))); // No record
+    QCOMPARE(count.fetchAndAddOrdered(0) , 0);
+
+    DQList<HealthCheck> list;
+    for (int i = 0 ; i < 1000;i++) {
+        HealthCheck *record = new HealthCheck();
+        record->name = QString("Tester %1").arg(i);
+        record->height = i % 100;
+        list.append(record);
+    }
+    QVERIFY(list.saveAll());
+
+    DQQuery<HealthCheck> tall = query.filter(DQWhere("height") >= 50);
+    QVERIFY(tall.parallelForEach(4,HeightSum(&sum,&count)));
+    QCOMPARE(count.fetchAndAddOrdered(0) , 500);
+    QCOMPARE(sum.fetchAndAddOrdered(0) , 37250);
+
+    // The query of caller is not changed by the scan
+    QCOMPARE(tall.all().size() , 500);
+
+    // Single thread
+    QAtomicInt all;
+    QVERIFY(query.parallelForEach(1,RecordCount(&all)));
+    QCOMPARE(all.fetchAndAddOrdered(0) , 1000);
+
+    DQSharedQuery shared = query;
+    all = 0;
+    QVERIFY(shared.parallelForEach(3,RecordCount(&all)));
+    QCOMPARE(all.fetchAndAddOrdered(0) , 1000);
+
+    QVERIFY(!query.limit(10).parallelForEach(2,RecordCount(&all)));
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::bulkInsert(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    DQSql sql = connect.sql();
+    DQModelMetaInfo *info = dqMetaInfo<HealthCheck>();
+
+    QStringList fields;
+    fields << "name" << "height" << "weight";
+    QVERIFY(sql.statement()->insertRows(info,fields,2) ==
+            "INSERT INTO healthcheck (name,height,weight) values (?,?,?),(?,?,?);");
+
+    // It is written in more than one chunk
+    int rows = sql.statement()->maxBindParameters() / fields.size() * 3 + 10;
+
+    DQList<HealthCheck> list;
+    for (int i = 0 ; i < rows;i++) {
+        HealthCheck *record = new HealthCheck();
+        record->name = QString("bulk %1").arg(i);
+        record->height = 100 + i % 100;
+        record->weight = 40 + i % 80;
+        list.append(record);
+    }
+
+    QVERIFY(sql.bulkInsert(info,list,fields));
+    QCOMPARE(query.count() , rows);
+
+    for (int i = 1 ; i < list.size();i++) {
+        QCOMPARE(list.at(i)->id->toInt() , list.at(i-1)->id->toInt() + 1);
+    }
+
+    HealthCheck check;
+    QVERIFY(check.load(DQWhere("id") == list.at(rows - 1)->id));
+    QVERIFY(check.name == QString("bulk %1").arg(rows - 1));
+
+    // A failed chunk rolls back the whole list
+    DQList<HealthCheck> invalid;
+    for (int i = 0 ; i < rows;i++) {
+        HealthCheck *record = new HealthCheck();
+        if (i < rows - 1) // The last one violates "NOT NULL"
+            record->name = QString("invalid %1").arg(i);
+        invalid.append(record);
+    }
+    QVERIFY(!sql.bulkInsert(info,invalid,fields));
+    QCOMPARE(query.count() , rows);
+    QVERIFY(invalid.at(0)->id->isNull());
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::removeAll(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    // More than a chunk of ids
+    int rows = connect.sql().statement()->maxBindParameters() + 10;
+
+    DQList<HealthCheck> list;
+    for (int i = 0 ; i < rows;i++) {
+        HealthCheck *record = new HealthCheck();
+        record->name = QString("remove %1").arg(i);
+        list.append(record);
+    }
+    QVERIFY(list.saveAll());
+    QCOMPARE(query.count() , rows);
+
+    DQList<HealthCheck> loaded = query.all();
+    QCOMPARE(loaded.size() , rows);
+    QVERIFY(loaded.removeAll());
+    QCOMPARE(query.count() , 0);
+    for (int i = 0 ; i < loaded.size();i++) {
+        QVERIFY(loaded.at(i)->id->isNull());
+    }
+
+    // Models without id are skipped
+    QVERIFY(loaded.removeAll());
+
+    QVariantList ids;
+    for (int i = 0 ; i < 3;i++) {
+        HealthCheck record;
+        record.name = QString("remove %1").arg(i);
+        QVERIFY(record.save());
+        if (i < 2)
+            ids << record.id.get();
+    }
+    ids << 999999; // Not existed
+
+    QCOMPARE(connect.removeIds<HealthCheck>(ids) , 2);
+    QCOMPARE(query.count() , 1);
+    QCOMPARE(connect.removeIds<HealthCheck>(QVariantList()) , 0);
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::bulkWriter(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    {
+        DQBulkWriter writer(dqMetaInfo<HealthCheck>(),connect,100);
+        QVERIFY(writer.fields() == QStringList() << "name" << "height" << "weight" << "recordDate");
+
+        for (int i = 0 ; i < 250;i++) {
+            writer << QString("Bulk %1").arg(i) << 100 + i % 100 << 40 + i % 80 << writer.next();
+        }
+
+        QCOMPARE(writer.writtenRows() , 200);
+        QCOMPARE(writer.pendingRows() , 50);
+        QCOMPARE(query.count() , 200);
+
+        QVERIFY(writer.close());
+        QCOMPARE(writer.writtenRows() , 250);
+        QCOMPARE(writer.pendingRows() , 0);
+    }
+    QCOMPARE(query.count() , 250);
+
+    HealthCheck check;
+    QVERIFY(check.load(DQWhere("name") == "Bulk 120"));
+    QCOMPARE(check.height->toInt() , 120);
+    QCOMPARE(check.weight->toInt() , 80);
+    QVERIFY(check.recordDate->isNull());
+
+    // The values in the order of setFields()
+    DQBulkWriter writer(dqMetaInfo<HealthCheck>(),connect,0);
+    QVERIFY(!writer.setFields(QStringList() << "name" << "unknown"));
+    QVERIFY(writer.setFields(QStringList() << "height" << "name"));
+    writer << 200 << "Ordered";
+    QCOMPARE(writer.pendingRows() , 1);
+    QVERIFY(writer.flush());
+    QVERIFY(check.load(DQWhere("name") == "Ordered"));
+    QCOMPARE(check.height->toInt() , 200);
+
+    // A failed batch is discarded
+    writer << 201 << "Valid" << 202 << QVariant(); // name is NOT NULL
+    QVERIFY(!writer.flush());
+    QCOMPARE(writer.pendingRows() , 0);
+    QCOMPARE(query.count() , 251);
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::exportSnapshot(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    for (int i = 0 ; i < 10;i++) {
+        HealthCheck model;
+        model.name = QString("export %1").arg(i);
+        model.height = 150 + i;
+        QVERIFY(model.save());
+    }
+
+    QList<DQModelMetaInfo*> models;
+    models << dqMetaInfo<HealthCheck>();
+    QVERIFY(connect.exportSnapshot(models,"export.db"));
+    QVERIFY(QFile::exists("export.db"));
+
+    // The main database is not changed
+    QCOMPARE(query.count() , 10);
+
+    QFile::remove("edge.db");
+    {
+        QSqlDatabase edgeDb = QSqlDatabase::addDatabase("QSQLITE","edge");
+        edgeDb.setDatabaseName( "edge.db" );
+        QVERIFY(edgeDb.open());
+
+        DQConnection edge;
+        QVERIFY(edge.open(edgeDb));
+        QVERIFY(edge.addModel<HealthCheck>());
+
+        QVERIFY(!edge.importSnapshot("not-existed.db"));
+        QVERIFY(edge.importSnapshot("export.db","snapshot",64 * 1024 * 1024));
+
+        DQQuery<HealthCheck> edgeQuery(edge);
+        QCOMPARE(edgeQuery.count() , 10);
+        QCOMPARE(edgeQuery.filter(DQWhere("height") >= 155).count() , 5);
+
+        HealthCheck check;
+        check.setConnection(edge);
+        QVERIFY(check.load(DQWhere("name") == "export 3"));
+        QCOMPARE(check.height->toInt() , 153);
+
+        QVERIFY(edge.detachSnapshot());
+        QVERIFY(!edge.detachSnapshot());
+
+        edge.close();
+        edgeDb.close();
+    }
+    QSqlDatabase::removeDatabase("edge");
+
+    QFile::remove("edge.db");
+    QFile::remove("export.db");
+    QVERIFY(query.remove());
+}
+
+/// The progress of backupTo(). It aborts when the no. of steps reaches the limit
+struct BackupProgress {
+    BackupProgress() : steps(0) , limit(-1) , remaining(-1) , total(-1) {
+    }
+
+    int steps;
+    int limit;
+    int remaining;
+    int total;
+
+    static bool report(int remaining,int total,void *userData) {
+        BackupProgress *progress = static_cast<BackupProgress*>(userData);
+        progress->steps++;
+        progress->remaining = remaining;
+        progress->total = total;
+        return progress->limit < 0 || progress->steps < progress->limit;
+    }
+};
+
+void SqliteTests::backupTo(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    DQList<HealthCheck> list;
+    for (int i = 0 ; i < 500;i++) {
+        HealthCheck *record = new HealthCheck();
+        record->name = QString("backup %1 %2").arg(i).arg(QString(200,'x'));
+        list.append(record);
+    }
+    QVERIFY(list.saveAll());
+
+    BackupProgress progress;
+    QVERIFY(connect.backupTo("backup.db",1,0,BackupProgress::report,&progress));
+#ifdef DQ_SQLITE_API
+    QVERIFY(progress.steps > 1); // Copied in more than one step
+#else
+    QCOMPARE(progress.steps , 1); // Exported by VACUUM INTO
+#endif
+    QCOMPARE(progress.remaining , 0);
+    QVERIFY(progress.total > 0);
+
+    {
+        QSqlDatabase backupDb = QSqlDatabase::addDatabase("QSQLITE","backup");
+        backupDb.setDatabaseName( "backup.db" );
+        QVERIFY(backupDb.open());
+
+        DQConnection backup;
+        QVERIFY(backup.open(backupDb));
+        QCOMPARE(DQQuery<HealthCheck>(backup).count() , 500);
+
+        backup.close();
+        backupDb.close();
+    }
+    QSqlDatabase::removeDatabase("backup");
+
+    // Abort by the callback
+    BackupProgress abort;
+    abort.limit = 1;
+    QVERIFY(!connect.backupTo("backup.db",1,0,BackupProgress::report,&abort));
+    QCOMPARE(abort.steps , 1);
+    QVERIFY(!QFile::exists("backup.db"));
+
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::watch(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+#ifndef DQ_SQLITE_API
+    // The hooks could only be installed by the C API
+    QVERIFY(connect.watch<HealthCheck>() == 0);
+#else
+
+    DQChangeNotifier *notifier = connect.watch<HealthCheck>();
+    QVERIFY(notifier);
+    QVERIFY(notifier->tables() == QStringList("healthcheck"));
+
+    DQChangeNotifier *all = connect.watch();
+    QVERIFY(all->tables().isEmpty());
+
+    QSignalSpy spy(notifier,SIGNAL(changed(QList<DQChange>)));
+    QSignalSpy allSpy(all,SIGNAL(changed(QList<DQChange>)));
+
+    HealthCheck model;
+    model.name = "watch";
+    model.height = 150;
+
+    // The changes within a transaction are coalesced
+    QVERIFY(connect.transaction());
+    QVERIFY(model.save());
+    model.height = 151;
+    QVERIFY(model.save());
+
+    HealthCheck removed;
+    removed.name = "removed";
+    QVERIFY(removed.save());
+    qint64 removedId = removed.id->toLongLong();
+    QVERIFY(removed.remove());
+    QVERIFY(connect.commit());
+
+    QCOMPARE(spy.size() , 0); // It is emitted by the event loop
+    QCoreApplication::processEvents();
+    QCOMPARE(spy.size() , 1);
+
+    QList<DQChange> changes = spy.at(0).at(0).value<QList<DQChange> >();
+    QCOMPARE(changes.size() , 1);
+    QVERIFY(changes.at(0).table == "healthcheck");
+    QVERIFY(changes.at(0).operation == DQChange::Insert);
+    QCOMPARE(changes.at(0).rowid , model.id->toLongLong());
+    QVERIFY(changes.at(0).rowid != removedId);
+
+    // Other tables are only reported to "all"
+    User user;
+    user.userId = "watch";
+    user.name = "Watch";
+    user.passwd = "watch";
+    QVERIFY(user.save());
+    QCoreApplication::processEvents();
+    QCOMPARE(spy.size() , 1);
+    QCOMPARE(allSpy.size() , 2);
+
+    // Rolled back changes are discarded
+    QVERIFY(connect.transaction());
+    model.height = 152;
+    QVERIFY(model.save());
+    QVERIFY(connect.rollback());
+    QCoreApplication::processEvents();
+    QCOMPARE(spy.size() , 1);
+
+    // Raw SQL is reported and invalidates the result cache
+    connect.sql().setResultCacheEnabled(true);
+    QCOMPARE(query.filter(DQWhere("height") == 160).count() , 0);
+    QSqlQuery q = connect.query();
+    QVERIFY(q.exec(QString("UPDATE healthcheck SET height = 160 WHERE id = %1").arg(model.id->toInt())));
+    QCOMPARE(query.filter(DQWhere("height") == 160).count() , 1);
+    connect.sql().setResultCacheEnabled(false);
+
+    QCoreApplication::processEvents();
+    QCOMPARE(spy.size() , 2);
+    changes = spy.at(1).at(0).value<QList<DQChange> >();
+    QVERIFY(changes.at(0).operation == DQChange::Update);
+
+    connect.unwatch(notifier);
+    connect.unwatch(all);
+
+    QVERIFY(user.remove());
+#endif
+    QVERIFY(query.remove());
+}
+
+void SqliteTests::fullText(){
+    DQSql sql = connect.sql();
+    DQModelMetaInfo *info = dqMetaInfo<Article>();
+    QCOMPARE(info->fullTextNameList() , QStringList() << "title" << "body");
+
+    // The records written before the index are indexed on creation
+    QVERIFY(sql.createTableIfNotExists(info));
+    Article early;
+    early.title = "Indexing";
+    early.body = "A b-tree index speeds up the lookup";
+    early.views = 5;
+    QVERIFY(early.save());
+
+    QVERIFY(connect.addModel<Article>());
+    QVERIFY(connect.createTables());
+    QVERIFY(sql.tables().contains("article_fts"));
+
+    QStringList titles;
+    titles << "SQLite" << "Full text" << "Cooking";
+    QStringList bodies;
+    bodies << "SQLite is an embedded database with full text search"
+           << "FTS5 builds an inverted index of the text . Search the text by the index"
+           << "Boil the pasta";
+
+    DQList<Article> articles;
+    for (int i = 0 ; i < titles.size();i++) {
+        Article *article = new Article();
+        article->title = titles.at(i);
+        article->body = bodies.at(i);
+        article->views = i;
+        articles.append(article);
+    }
+    QVERIFY(articles.saveAll());
+
+    DQQuery<Article> query;
+    query = query.filter(DQWhere::match("index"));
+    QVERIFY(sql.statement()->select(query).contains("article_fts MATCH"));
+    QCOMPARE(query.count() , 2);
+
+    // Restricted to a field
+    query = DQQuery<Article>().filter(DQWhere::match("title","index*"));
+    QCOMPARE(query.count() , 1);
+
+    // Combined with other rules
+    query = DQQuery<Article>().filter(DQWhere::match("text OR pasta") && DQWhere("views") >= 1);
+    QCOMPARE(query.count() , 2);
+
+    // The one mentioned "index" twice is more relevant
+    DQQuery<Article> ranked = DQQuery<Article>().filter(DQWhere::match("index")).orderByRank("index");
+    DQList<Article> list = ranked.all();
+    QCOMPARE(list.size() , 2);
+    QCOMPARE(list.at(0)->title.get().toString() , QString("Full text"));
+
+    // The triggers keep the index in sync
+    Article *cooking = articles.at(2);
+    cooking->body = "Boil the pasta with the index finger";
+    QVERIFY(cooking->save());
+    QCOMPARE(DQQuery<Article>().filter(DQWhere::match("pasta AND finger")).count() , 1);
+
+    QVERIFY(early.remove());
+    QCOMPARE(DQQuery<Article>().filter(DQWhere::match("lookup")).count() , 0);
+    QCOMPARE(DQQuery<Article>().filter(DQWhere::match("index")).count() , 2);
+
+    // The index content is consistent with the table
+    QSqlQuery q = connect.query();
+    QVERIFY(q.exec("INSERT INTO article_fts(article_fts) VALUES ('integrity-check')"));
+
+    // The index is removed with the table
+    QVERIFY(sql.dropTable(info));
+    QVERIFY(!sql.tables().contains("article_fts"));
+}
+
+void SqliteTests::generatedColumn(){
+    DQSql sql = connect.sql();
+    DQModelMetaInfo *info = dqMetaInfo<Account>();
+
+    QVERIFY(connect.addModel<Account>());
+    QVERIFY(connect.createTables());
+    QCOMPARE(sql.columns(info->name()) , info->columnNameList());
+
+    Account account;
+    account.email = "Ben@Example.com";
+    account.created = 86400 * 3 + 5;
+    QVERIFY(account.save());
+
+    Account loaded;
+    QVERIFY(loaded.load(DQWhere("id") == account.id.get()));
+    QVERIFY(loaded.emailKey == "ben@example.com");
+    QVERIFY(loaded.day == 3);
+
+    // The generated fields are skipped on write
+    loaded.email = "BOB@example.com";
+    QVERIFY(loaded.save());
+    QVERIFY(loaded.save(true));
+    QCOMPARE(DQQuery<Account>().filter(DQWhere("emailKey") == "bob@example.com").count() , 2);
+
+    DQList<Account> list = DQQuery<Account>().all();
+    QVERIFY(list.saveAll());
+
+    // Served by the index of the stored column
+    DQQueryPlan plan = DQQuery<Account>().filter(DQWhere("day") == 3).explain();
+    QVERIFY(!plan.isEmpty());
+    QVERIFY(!plan.hasFullScan());
+
+    // Served by the expression index
+    DQIndex<Account> index("account_email");
+    index << DQWhere("lower(email)");
+    QVERIFY(connect.createIndex(index));
+    plan = DQQuery<Account>().filter(DQWhere("lower(email)") == "bob@example.com").explain();
+    QVERIFY(!plan.hasFullScan());
+
+    // The migration do not add it again
+    QVERIFY(connect.migrate());
+
+    QVERIFY(sql.dropTable(info));
+}
+
+void SqliteTests::maintenance(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    QVERIFY(!connect.isMaintenanceEnabled());
+    QVERIFY(connect.maintenanceStats().isEmpty());
+
+    DQMaintenanceOptions options;
+    options.interval = 0; // Only run by runMaintenance()
+    options.analyzeThreshold = 10;
+
+    connect.setMaintenanceEnabled(true,options);
+    QVERIFY(connect.isMaintenanceEnabled());
+
+    qint64 before = connect.sql().writeCounts().value("healthcheck");
+
+    DQList<HealthCheck> list;
+    for (int i = 0 ; i < 5;i++) {
+        HealthCheck *model = new HealthCheck();
+        model->name = QString("maintenance %1").arg(i);
+        model->height = 150 + i;
+        list.append(model);
+    }
+    QVERIFY(list.saveAll());
+    QCOMPARE(connect.sql().writeCounts().value("healthcheck") - before , Q_INT64_C(5));
+
+    // Below the threshold
+    connect.runMaintenance();
+    QVERIFY(connect.maintenanceStats().isEmpty());
+
+    QVariantMap assignments;
+    assignments["weight"] = 60;
+    QCOMPARE(query.filter(DQWhere("height") >= 150).update(assignments) , 5);
+    QCOMPARE(connect.sql().writeCounts().value("healthcheck") - before , Q_INT64_C(10));
+
+    connect.runMaintenance();
+    QList<DQQueryStats> stats = connect.maintenanceStats();
+    QStringList statements;
+    foreach (DQQueryStats item , stats) {
+        QCOMPARE(item.calls , 1);
+        QCOMPARE(item.failures , 0);
+        statements << item.sql;
+    }
+    QVERIFY(statements.contains("ANALYZE healthcheck;"));
+    QVERIFY(statements.contains("PRAGMA optimize;"));
+
+    // Nothing is written since the last run
+    connect.runMaintenance();
+    QCOMPARE(connect.maintenanceStats().first().calls , 1);
+
+    connect.setMaintenanceEnabled(false);
+    QVERIFY(!connect.isMaintenanceEnabled());
+    QVERIFY(connect.maintenanceStats().isEmpty());
+}
+
+void SqliteTests::checkpoint(){
+    QFile::remove("checkpoint.db");
+    {
+        QSqlDatabase walDb = QSqlDatabase::addDatabase("QSQLITE","checkpoint");
+        walDb.setDatabaseName( "checkpoint.db" );
+        QVERIFY(walDb.open());
+
+        DQConnectionOptions options = DQConnectionOptions::profile("balanced");
+        options.walAutoCheckpoint = 0;
+
+        DQConnection connection;
+        QVERIFY(connection.open(walDb,options));
+        QCOMPARE(pragmaValue(connection,"wal_autocheckpoint").toInt() , 0);
+
+        QSqlQuery q = connection.query();
+        QVERIFY(q.exec("CREATE TABLE wal_test (value INTEGER)"));
+        for (int i = 0 ; i < 10;i++)
+            QVERIFY(q.exec(QString("INSERT INTO wal_test VALUES (%1)").arg(i)));
+
+        QVERIFY(connection.walSize() > 0); // Nothing is checkpointed automatically
+        QCOMPARE(connection.checkpointStats().calls , 0);
+
+        QVERIFY(connection.checkpoint(DQConnection::TruncateCheckpoint));
+        QCOMPARE(connection.walSize() , Q_INT64_C(0));
+
+        DQQueryStats stats = connection.checkpointStats();
+        QCOMPARE(stats.calls , 1);
+        QCOMPARE(stats.failures , 0);
+        QVERIFY(stats.rows > 0);
+
+        // Checkpoint by size on the maintenance thread
+        DQMaintenanceOptions maintenance;
+        maintenance.interval = 0;
+        maintenance.checkpointSize = 1;
+        connection.setMaintenanceEnabled(true,maintenance);
+        QVERIFY(connection.isMaintenanceEnabled());
+
+        QVERIFY(q.exec("INSERT INTO wal_test VALUES (10)"));
+        QVERIFY(connection.walSize() > 0);
+
+        connection.runMaintenance();
+        QVERIFY(connection.checkpointStats().calls >= 2);
+
+        QStringList statements;
+        foreach (DQQueryStats item , connection.maintenanceStats())
+            statements << item.sql;
+        QVERIFY(statements.contains("PRAGMA wal_checkpoint(PASSIVE);"));
+
+        // The automatic checkpoint setting is restored
+        connection.setMaintenanceEnabled(false);
+        QCOMPARE(pragmaValue(connection,"wal_autocheckpoint").toInt() , 0);
+
+        q.finish();
+        q = QSqlQuery();
+        connection.close();
+        walDb.close();
+    }
+    QSqlDatabase::removeDatabase("checkpoint");
+    QFile::remove("checkpoint.db");
+}
+
+void SqliteTests::busyRetry(){
+    QFile::remove("busy.db");
+    {
+        QSqlDatabase writerDb = QSqlDatabase::addDatabase("QSQLITE","busy_writer");
+        writerDb.setDatabaseName( "busy.db" );
+        QVERIFY(writerDb.open());
+
+        QSqlDatabase blockedDb = QSqlDatabase::addDatabase("QSQLITE","busy_blocked");
+        blockedDb.setDatabaseName( "busy.db" );
+        QVERIFY(blockedDb.open());
+
+        DQConnection writer;
+        QVERIFY(writer.open(writerDb));
+
+        DQConnectionOptions options;
+        options.retryPolicy = DQRetryPolicy(200);
+        DQConnection blocked;
+        QVERIFY(blocked.open(blockedDb,options));
+        QCOMPARE(blocked.retryPolicy().timeout , 200);
+        QVERIFY(blocked.busyStats().isEmpty());
+
+        QSqlQuery w = writer.query();
+        QVERIFY(w.exec("CREATE TABLE busy_test (value INTEGER)"));
+
+        // Hold the write lock
+        QVERIFY(w.exec("BEGIN IMMEDIATE"));
+        QVERIFY(w.exec("INSERT INTO busy_test VALUES (1)"));
+
+        QElapsedTimer timer;
+        timer.start();
+        QSqlQuery b = blocked.query();
+        QVERIFY(!b.exec("INSERT INTO busy_test VALUES (2)"));
+        QVERIFY(timer.elapsed() >= 150); // Retried until the timeout
+
+#ifdef DQ_SQLITE_API
+        QList<DQQueryStats> stats = blocked.busyStats();
+        QCOMPARE(stats.size() , 1);
+        QCOMPARE(stats.first().sql , QString("INSERT INTO busy_test VALUES (?)"));
+        QCOMPARE(stats.first().calls , 1);
+        QCOMPARE(stats.first().failures , 1);
+        QVERIFY(stats.first().retries > 1);
+        QVERIFY(stats.first().busyTime > 0);
+#else
+        // The timeout is applied by busy_timeout , the waits are not tracked
+        QVERIFY(blocked.busyStats().isEmpty());
+#endif
+
+        QVERIFY(w.exec("COMMIT"));
+        QVERIFY(b.exec("INSERT INTO busy_test VALUES (2)"));
+
+        blocked.resetBusyStats();
+        QVERIFY(blocked.busyStats().isEmpty());
+
+        // The null policy restores the busy timeout of options
+        QVERIFY(blocked.setRetryPolicy(DQRetryPolicy()));
+        QVERIFY(blocked.retryPolicy().isNull());
+        QVERIFY(blocked.busyStats().isEmpty());
+
+        w = QSqlQuery();
+        b = QSqlQuery();
+        blocked.close();
+        writer.close();
+        blockedDb.close();
+        writerDb.close();
+    }
+    QSqlDatabase::removeDatabase("busy_blocked");
+    QSqlDatabase::removeDatabase("busy_writer");
+    QFile::remove("busy.db");
+}
+
+void SqliteTests::readWriteSplit(){
+    DQQuery<HealthCheck> query;
+    QVERIFY(query.remove());
+
+    QVERIFY(DQConnectionPool::defaultPool() == 0);
+    QVERIFY(!connect.isReadWriteSplitEnabled());
+    QVERIFY(connect.readerPool() == 0);
+
+    // The readers should not block the commit of writer
+    QSqlQuery pragma = connect.query();
+    QVERIFY(pragma.exec("PRAGMA journal_mode = WAL"));
+    pragma.finish();
+
+    connect.setReadWriteSplitEnabled(true);
+    QVERIFY(connect.isReadWriteSplitEnabled());
+    QVERIFY(connect.readerPool() != 0);
+    QVERIFY(DQConnectionPool::defaultPool() == connect.readerPool()); // It is the default connection
+
+    // The save is run by the writer , and the id is returned
+    HealthCheck model;
+    model.name = "split";
+    model.height = 170;
+    QVERIFY(model.save());
+    QVERIFY(!model.id->isNull());
+    QCOMPARE(query.filter(DQWhere("name") == "split").count() , 1);
+
+    model.height = 171;
+    QVERIFY(model.save());
+    HealthCheck loaded;
+    QVERIFY(loaded.load(DQWhere("id") == model.id.get()));
+    QCOMPARE(loaded.height.get().toInt() , 171);
+
+    // The writes of the readers are funneled to the writer
+    QList<SavingThread*> threads;
+    for (int i = 0 ; i < 4;i++) {
+        SavingThread *thread = new SavingThread();
+        thread->prefix = QString("thread %1").arg(i);
+        thread->rows = 20;
+        threads << thread;
+        thread->start();
+    }
+    foreach (SavingThread *thread , threads) {
+        QVERIFY(thread->wait(30000));
+        QCOMPARE(thread->saved , 20);
+        delete thread;
+    }
+    QCOMPARE(query.count() , 81);
+
+    // Bulk write
+    DQList<HealthCheck> list;
+    for (int i = 0 ; i < 5;i++) {
+        HealthCheck *record = new HealthCheck();
+        record->name = QString("bulk %1").arg(i);
+        record->height = 150;
+        list.append(record);
+    }
+    QVERIFY(list.saveAll());
+    QVERIFY(!list.at(4)->id->isNull());
+    QCOMPARE(query.count() , 86);
+    QVERIFY(list.removeAll());
+    QVERIFY(list.at(4)->id->isNull());
+
+    QVariantMap assignments;
+    assignments["weight"] = 55;
+    QCOMPARE(query.filter(DQWhere("name") == "split").update(assignments) , 1);
+
+    // The write within a transaction of the connection is not queued
+    {
+        DQTransaction transaction(connect);
+        HealthCheck inTransaction;
+        inTransaction.name = "transaction";
+        QVERIFY(inTransaction.save());
+        transaction.rollback();
+    }
+    QCOMPARE(query.filter(DQWhere("name") == "transaction").count() , 0);
+
+    QVERIFY(model.remove());
+    QCOMPARE(query.count() , 80);
+
+    // The result of the writer is not shared with the calling thread , only its error is returned
+    QVariantMap invalid;
+    invalid["name"] = QVariant(); // name is NOT NULL
+    QCOMPARE(query.update(invalid) , -1);
+    QVERIFY(query.lastQuery().lastQuery().isEmpty());
+    QVERIFY(query.lastError().isValid());
+
+    QVERIFY(query.remove());
+    QVERIFY(!query.lastError().isValid());
+    QCOMPARE(query.count() , 0);
+
+    connect.setReadWriteSplitEnabled(false);
+    QVERIFY(!connect.isReadWriteSplitEnabled());
+    QVERIFY(connect.readerPool() == 0);
+    QVERIFY(DQConnectionPool::defaultPool() == 0);
+
+    QVERIFY(pragma.exec("PRAGMA journal_mode = DELETE"));
+    pragma.finish();
+}
+
+void SqliteTests::shardedConnection(){
+    int shardCount = 3;
+    for (int i = 0 ; i < shardCount;i++)
+        QFile::remove(QString("shard%1.db").arg(i));
+
+    {
+        DQShardedConnection sharded;
+        QCOMPARE(sharded.shardOf(dqMetaInfo<HealthCheck>(),"shard 0") , -1);
+
+        for (int i = 0 ; i < shardCount;i++) {
+            QSqlDatabase shardDb = QSqlDatabase::addDatabase("QSQLITE",QString("shard%1").arg(i));
+            shardDb.setDatabaseName( QString("shard%1.db").arg(i) );
+            QVERIFY(shardDb.open());
+
+            DQConnection connection;
+            QVERIFY(connection.open(shardDb));
+            sharded.addShard(connection);
+        }
+        QCOMPARE(sharded.size() , shardCount);
+
+        QVERIFY(sharded.addModel<HealthCheck>());
+        QVERIFY(sharded.createTables());
+        sharded.setShardKey<HealthCheck>("name");
+
+        // The default shard function is stable
+        QCOMPARE(DQShardedConnection::hash(7,3) , 1);
+        QCOMPARE(DQShardedConnection::hash(Q_INT64_C(-9223372036854775807) - 1,3) , 2);
+        QCOMPARE(DQShardedConnection::hash(Q_UINT64_C(18446744073709551615),3) , 0);
+        QCOMPARE(DQShardedConnection::hash("shard 7",3) , 0);
+        QCOMPARE(sharded.shardOf(dqMetaInfo<HealthCheck>(),"shard 7") , 0);
+
+        for (int i = 0 ; i < 30;i++) {
+            HealthCheck model;
+            model.name = QString("shard %1").arg(i);
+            model.height = 100 + i;
+            QVERIFY(sharded.save(&model));
+            QVERIFY(model.connection() == sharded.shard(sharded.shardOf(&model)));
+        }
+
+        HealthCheck noKey;
+        QVERIFY(!sharded.save(&noKey));
+
+        QCOMPARE(DQQuery<HealthCheck>(sharded.shard(0)).count() , 11);
+        QCOMPARE(DQQuery<HealthCheck>(sharded.shard(1)).count() , 10);
+        QCOMPARE(DQQuery<HealthCheck>(sharded.shard(2)).count() , 9);
+
+        // Scatter-gather
+        DQQuery<HealthCheck> query;
+        QCOMPARE(sharded.count(query) , 30);
+        QCOMPARE(sharded.count(query.filter(DQWhere("height") >= 120)) , 10);
+
+        DQList<HealthCheck> list = sharded.all(query);
+        QCOMPARE(list.size() , 30);
+        for (int i = 0 ; i < list.size();i++) {
+            QVERIFY(list.at(i)->connection() == sharded.shard(sharded.shardOf(list.at(i))));
+        }
+
+        QCOMPARE(sharded.call(query,"sum","height").toInt() , 3435);
+        QCOMPARE(sharded.call(query,"max","height").toInt() , 129);
+        QCOMPARE(sharded.call(query,"min","height").toInt() , 100);
+        QCOMPARE(sharded.call(query,"avg","height").toDouble() , 114.5);
+        QVERIFY(sharded.call(query,"group_concat","name").isNull());
+
+        // Point lookup by the shard key
+        HealthCheck loaded;
+        QVERIFY(sharded.load(&loaded,DQWhere("name") == "shard 7","shard 7"));
+        QCOMPARE(loaded.height.get().toInt() , 107);
+        QVERIFY(loaded.connection() == sharded.shard(0));
+
+        HealthCheck searched;
+        QVERIFY(sharded.load(&searched,DQWhere("name") == "shard 8"));
+        QCOMPARE(searched.height.get().toInt() , 108);
+        QVERIFY(!sharded.load(&searched,DQWhere("name") == "missing"));
+
+        // The loaded model is saved back to its shard
+        loaded.height = 170;
+        QVERIFY(loaded.save());
+        QCOMPARE(sharded.call(query,"max","height").toInt() , 170);
+
+        QVERIFY(sharded.remove(query.filter(DQWhere("height") < 110)));
+        QCOMPARE(sharded.count(query) , 21);
+
+        list.clear();
+        QVERIFY(sharded.dropTables());
+
+        for (int i = 0 ; i < shardCount;i++) {
+            DQConnection connection = sharded.shard(i);
+            QSqlDatabase shardDb = connection.sql().database();
+            connection.close();
+            shardDb.close();
+        }
+    }
+
+    for (int i = 0 ; i < shardCount;i++) {
+        QSqlDatabase::removeDatabase(QString("shard%1").arg(i));
+        QFile::remove(QString("shard%1.db").arg(i));
+    }
+}
+
+void SqliteTests::attach(){
+    QFile::remove("hot.db");
+    QFile::remove("archive.db");
+    {
+        QSqlDatabase hotDb = QSqlDatabase::addDatabase("QSQLITE","attach_hot");
+        hotDb.setDatabaseName( "hot.db" );
+        QVERIFY(hotDb.open());
+
+        DQConnection hot;
+        QVERIFY(hot.open(hotDb));
+
+        QVERIFY(!hot.attach("archive.db","main"));
+        QVERIFY(hot.attach("archive.db","archive"));
+        QCOMPARE(hot.attachedSchemas() , QStringList() << "archive");
+
+        QVERIFY(hot.addModel<HealthCheck>());
+        QVERIFY(hot.addModel<User>());
+        hot.bindSchema<HealthCheck>("archive");
+
+        DQSqlStatement *statement = hot.sql().statement();
+        QCOMPARE(statement->qualifiedName(dqMetaInfo<HealthCheck>()) , QString("archive.healthcheck"));
+        QCOMPARE(statement->qualifiedName(dqMetaInfo<User>()) , QString("user"));
+
+        QVERIFY(hot.createTables());
+        QVERIFY(hot.createTables()); // The attached table is found
+
+        // The columns are read from the attached table , so nothing is added by migrate()
+        QVERIFY(hot.sql().columns(dqMetaInfo<HealthCheck>()).contains("height"));
+        QVERIFY(hot.migrate());
+
+        // The full text index is kept in the main database
+        hot.bindSchema<Article>("archive");
+        QVERIFY(statement->boundSchema(dqMetaInfo<Article>()).isEmpty());
+
+        HealthCheck model;
+        model.setConnection(hot);
+        model.name = "archived";
+        model.height = 160;
+        QVERIFY(model.save());
+
+        User user;
+        user.setConnection(hot);
+        user.userId = "attach";
+        user.name = "archived";
+        user.passwd = "attach-passwd";
+        QVERIFY(user.save());
+
+        DQQuery<HealthCheck> query(hot);
+        QCOMPARE(query.count() , 1);
+
+        // The table is created in archive.db only
+        QSqlQuery q = hot.query();
+        QVERIFY(q.exec("SELECT count(*) FROM main.sqlite_master WHERE name = 'healthcheck'"));
+        QVERIFY(q.next());
+        QCOMPARE(q.value(0).toInt() , 0);
+        QVERIFY(q.exec("SELECT count(*) FROM archive.sqlite_master WHERE name = 'healthcheck'"));
+        QVERIFY(q.next());
+        QCOMPARE(q.value(0).toInt() , 1);
+
+        // Join across the files
+        QVERIFY(q.exec("SELECT u.userId FROM user u JOIN archive.healthcheck h ON h.name = u.name"));
+        QVERIFY(q.next());
+        QCOMPARE(q.value(0).toString() , QString("attach"));
+        q = QSqlQuery();
+
+        // The clone of async worker attaches the file too
+        QFuture<int> future = query.countAsync();
+        future.waitForFinished();
+        QCOMPARE(future.result() , 1);
+
+        QVERIFY(hot.detach("archive"));
+        QVERIFY(hot.attachedSchemas().isEmpty());
+        QVERIFY(statement->boundSchema(dqMetaInfo<HealthCheck>()).isEmpty());
+        QVERIFY(!hot.detach("archive"));
+
+        hot.close();
+        hotDb.close();
+    }
+    QSqlDatabase::removeDatabase("attach_hot");
+    QFile::remove("hot.db");
+    QFile::remove("archive.db");
+}
+
+/// Count the records of HealthCheck in a database file. -1 if it is failed
+static int _persistedRows(QString path) {
+    int res = -1;
+    {
+        QSqlDatabase file = QSqlDatabase::addDatabase("QSQLITE","persisted_rows");
+        file.setDatabaseName(path);
+        if (file.open()) {
+            QSqlQuery q(file);
+            if (q.exec("SELECT count(*) FROM healthcheck") && q.next())
+                res = q.value(0).toInt();
+        }
+        file.close();
+    }
+    QSqlDatabase::removeDatabase("persisted_rows");
+    return res;
+}
+
+void SqliteTests::inMemory(){
+    QFile::remove("memory.db");
+#ifndef DQ_SQLITE_API
+    {
+        // Persisting requires the C API
+        DQConnection memory;
+        QVERIFY(!memory.openInMemory("memory.db",50));
+        QVERIFY(!memory.isOpen());
+    }
+#else
+    {
+        DQConnection memory;
+        QVERIFY(memory.openInMemory("memory.db",50));
+        QVERIFY(memory.isOpen());
+        QVERIFY(memory.addModel<HealthCheck>());
+        QVERIFY(memory.createTables());
+
+        for (int i = 0 ; i < 10;i++) {
+            HealthCheck model;
+            model.setConnection(memory);
+            model.name = QString("memory %1").arg(i);
+            model.height = 150 + i;
+            QVERIFY(model.save());
+        }
+
+        QVERIFY(memory.persist());
+        QCOMPARE(_persistedRows("memory.db") , 10);
+
+        // The clones share the database
+        DQQuery<HealthCheck> query(memory);
+        QFuture<int> future = query.countAsync();
+        future.waitForFinished();
+        QCOMPARE(future.result() , 10);
+
+        // Persisted in background
+        HealthCheck model;
+        model.setConnection(memory);
+        model.name = "background";
+        QVERIFY(model.save());
+
+        int rows = 0;
+        for (int i = 0 ; i < 100 && rows != 11;i++) {
+            QTest::qWait(50);
+            rows = _persistedRows("memory.db");
+        }
+        QCOMPARE(rows , 11);
+
+        HealthCheck last;
+        last.setConnection(memory);
+        last.name = "last";
+        QVERIFY(last.save());
+
+        memory.close(); // The last change is written
+        QVERIFY(!memory.persist());
+    }
+    QCOMPARE(_persistedRows("memory.db") , 12);
+
+    {
+        // Load on open
+        DQConnection memory;
+        QVERIFY(memory.openInMemory("memory.db",0));
+        QVERIFY(memory.addModel<HealthCheck>());
+        QVERIFY(memory.createTables());
+        QCOMPARE(DQQuery<HealthCheck>(memory).count() , 12);
+        QCOMPARE(DQQuery<HealthCheck>(memory).filter(DQWhere("name") == "last").count() , 1);
+        memory.close();
+    }
+#endif
+
+    {
+        // Not persisted
+        DQConnection transient;
+        QVERIFY(transient.openInMemory(QString()));
+        QVERIFY(transient.addModel<HealthCheck>());
+        QVERIFY(transient.createTables());
+        QCOMPARE(DQQuery<HealthCheck>(transient).count() , 0);
+        QVERIFY(!transient.persist());
+        transient.close();
+    }
+
+    QFile::remove("memory.db");
+}
+
+static QVariant _bmi(const QVariantList &args,void *) {
+    double height = args.at(0).toDouble() / 100;
+    if (height <= 0)
+        return QVariant();
+    return args.at(1).toDouble() / (height * height);
+}
+
+static void _productStep(QVariant &state,const QVariantList &args,void *userData) {
+    (*static_cast<int*>(userData))++;
+    state = (state.isNull() ? 1.0 : state.toDouble()) * args.at(0).toDouble();
+}
+
+static QVariant _productFinal(const QVariant &state,void *) {
+    return state;
+}
+
+void SqliteTests::sqlFunction(){
+    QFile::remove("function.db");
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE","sql_function");
+        db.setDatabaseName( "function.db" );
+        QVERIFY(db.open());
+
+        DQConnection connection;
+        QVERIFY(connection.open(db));
+        QVERIFY(connection.addModel<HealthCheck>());
+        QVERIFY(connection.createTables());
+
+        for (int i = 1 ; i <= 4;i++) {
+            HealthCheck record;
+            record.setConnection(connection);
+            record.name = QString("Function %1").arg(i);
+            record.height = 150 + i * 10;
+            record.weight = 40 + i * 10;
+            QVERIFY(record.save());
+        }
+
+#ifndef DQ_SQLITE_API
+        // The functions could only be installed by the C API
+        QVERIFY(!connection.registerFunction("bmi",2,_bmi));
+        QVERIFY(!connection.registerAggregate("product",1,_productStep,_productFinal,0));
+#else
+        int steps = 0;
+        QVERIFY(connection.registerFunction("bmi",2,_bmi));
+        QVERIFY(connection.registerAggregate("product",1,_productStep,_productFinal,&steps));
+        QVERIFY(!connection.registerFunction("bmi",2,0));
+
+        // bmi of the records : 19.53 , 20.76 , 21.60 , 22.16
+        DQQuery<HealthCheck> query = DQQuery<HealthCheck>(connection).filter(DQWhere("bmi(height,weight)") > 21)
+                                                                     .orderBy("bmi(height,weight) desc");
+        DQList<HealthCheck> list = query.all();
+        QCOMPARE(list.size() , 2);
+        QCOMPARE(list.at(0)->name.get().toString() , QString("Function 4"));
+        QCOMPARE(query.count() , 2);
+
+        QVariant product = DQQuery<HealthCheck>(connection).call("product","weight");
+        QCOMPARE(product.toDouble() , 50.0 * 60 * 70 * 80);
+        QCOMPARE(steps , 4);
+
+        // NULL is returned for an empty group
+        product = DQQuery<HealthCheck>(connection).filter(DQWhere("height") > 1000).call("product","weight");
+        QVERIFY(product.isNull());
+
+        // The functions are installed on the clone of async worker
+        QFuture<int> future = query.countAsync();
+        future.waitForFinished();
+        QCOMPARE(future.result() , 2);
+
+        QVERIFY(connection.unregisterFunction("bmi",2));
+        QVERIFY(!connection.unregisterFunction("bmi",2));
+        QVERIFY(!connection.query().exec("SELECT bmi(height,weight) FROM healthcheck"));
+#endif
+
+        connection.close();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("sql_function");
+    QFile::remove("function.db");
+}
+
+void SqliteTests::connectionStats(){
+    QVERIFY(DQQuery<HealthCheck>().remove());
+
+    DQList<HealthCheck> list;
+    for (int i = 0 ; i < 50;i++) {
+        HealthCheck *record = new HealthCheck();
+        record->name = QString("Stats %1").arg(i);
+        record->height = 150 + i;
+        list.append(record);
+    }
+    QVERIFY(list.saveAll());
+
+    DQConnectionStats stats = connect.stats(true);
+    QVERIFY(stats.tables.size() >= 3);
+
+    DQTableStats table = stats.table("healthcheck");
+    QCOMPARE(table.name , QString("healthcheck"));
+    QCOMPARE(table.schema , QString("main"));
+    QCOMPARE(table.rows , (qint64) 50);
+    QVERIFY(!table.estimated);
+    QVERIFY(table.written > 0);
+    QVERIFY(stats.table("unknown").name.isEmpty());
+
+    QVERIFY(stats.pageSize > 0);
+    QVERIFY(stats.pageCount > 0);
+    QVERIFY(stats.freePages >= 0);
+    QCOMPARE(stats.statementCacheCapacity , connect.sql().statementCacheCapacity());
+    QVERIFY(stats.cacheHitRatio() >= 0 && stats.cacheHitRatio() <= 1);
+
+    if (table.pages >= 0) {
+        // dbstat is available
+        QVERIFY(table.bytes >= table.pages * 512);
+    }
+
+    // The estimate of ANALYZE is used
+    QVERIFY(connect.query().exec("ANALYZE healthcheck"));
+    stats = connect.stats();
+    table = stats.table("healthcheck");
+    QVERIFY(table.estimated);
+    QCOMPARE(table.rows , (qint64) 50);
+
+    QString text = stats.toText();
+    QVERIFY(text.contains("dquest_table_rows_estimated{table=\"healthcheck\",schema=\"main\"} 50\n"));
+    QVERIFY(text.contains(QString("dquest_page_size_bytes %1\n").arg(stats.pageSize)));
+
+    // Periodic dump
+    QFile::remove("stats.prom");
+    DQStatsReporter reporter(connect,60000);
+    reporter.setPath("stats.prom");
+    QSignalSpy spy(&reporter,SIGNAL(reported(DQConnectionStats)));
+    reporter.report();
+    QCOMPARE(spy.count() , 1);
+    QCOMPARE(reporter.lastStats().table("healthcheck").rows , (qint64) 50);
+
+    QFile file("stats.prom");
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.readAll().contains("dquest_pages "));
+    file.close();
+    QFile::remove("stats.prom");
+
+    connect.query().exec("DROP TABLE sqlite_stat1");
+    QVERIFY(DQQuery<HealthCheck>().remove());
+}
+
+void SqliteTests::schemaFingerprint(){
+    QFile::remove("fingerprint.db");
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE","schema_fingerprint");
+        db.setDatabaseName( "fingerprint.db" );
+        QVERIFY(db.open());
+
+        DQConnection connection;
+        QVERIFY(connection.open(db));
+        QVERIFY(connection.addModel<HealthCheck>());
+        QVERIFY(!connection.isSchemaFingerprintEnabled());
+
+        // Nothing is stored if it is disabled
+        QVERIFY(connection.createTables());
+        QSqlQuery q = connection.query();
+        QVERIFY(q.exec("PRAGMA user_version") && q.next());
+        QCOMPARE(q.value(0).toInt() , 0);
+
+        connection.setSchemaFingerprintEnabled(true);
+        int fingerprint = connection.schemaFingerprint();
+        QVERIFY(fingerprint > 0);
+        QCOMPARE(connection.schemaFingerprint() , fingerprint);
+
+        QVERIFY(connection.createTables());
+        QVERIFY(q.exec("PRAGMA user_version") && q.next());
+        QCOMPARE(q.value(0).toInt() , fingerprint);
+
+        // The fingerprint matches , no DDL is run. The table dropped behind its back is not created again.
+        QVERIFY(q.exec("DROP TABLE healthcheck"));
+        QVERIFY(connection.createTables());
+        QVERIFY(!q.exec("SELECT count(*) FROM healthcheck"));
+
+        QVERIFY(connection.clearSchemaFingerprint());
+        QVERIFY(connection.createTables());
+        QVERIFY(q.exec("SELECT count(*) FROM healthcheck"));
+
+        // Adding a model changes the fingerprint
+        QVERIFY(connection.addModel<TypedModel>());
+        QVERIFY(connection.schemaFingerprint() != fingerprint);
+        QVERIFY(connection.createTables());
+        QVERIFY(q.exec("SELECT count(*) FROM typedmodel"));
+        QVERIFY(connection.sql().indexExists("typedmodel_count"));
+        QVERIFY(q.exec("PRAGMA user_version") && q.next());
+        QCOMPARE(q.value(0).toInt() , connection.schemaFingerprint());
+
+        // The clone has the same setting
+        {
+            DQConnection clone = connection.clone("schema_fingerprint_clone");
+            QVERIFY(clone.isSchemaFingerprintEnabled());
+            QCOMPARE(clone.schemaFingerprint() , connection.schemaFingerprint());
+            clone.close();
+        }
+        QSqlDatabase::removeDatabase("schema_fingerprint_clone");
+
+        QVERIFY(connection.dropTables());
+        QVERIFY(q.exec("PRAGMA user_version") && q.next());
+        QCOMPARE(q.value(0).toInt() , 0);
+
+        q = QSqlQuery();
+        connection.close();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("schema_fingerprint");
+    QFile::remove("fingerprint.db");
+}
@@ -11,6 +11,16 @@
 #include <dqquery.h>
 #include <dqsql.h>
 #include <dqlistwriter.h>
+#include <dqtransaction.h>
+#include <dqcursor.h>
+#include <dqconnectionpool.h>
+#include <dqshardedconnection.h>
+#include <dqevaluator.h>
+#include <dqindexadvisor.h>
+#include <dqblobstream.h>
+#include <dqbulkwriter.h>
+#include <dqchangenotifier.h>
+#include <dqstatsreporter.h>
 
 #include "model1.h"
 #include "model2.h"
@@ -76,6 +86,162 @@ private Q_SLOTS:
 
     void queryOrderBy();
 
+    /// Verify the prepared statement cache of DQSql
+    void statementCache();
+
+    /// Test DQSharedList::saveAll()
+    void saveAll();
+
+    /// Test nested transaction and DQTransaction
+    void transaction();
+
+    /// Test DQCursor
+    void cursor();
+
+    /// Test DQConnectionPool
+    void connectionPool();
+
+    /// Test DQSharedQuery::prefetch()
+    void prefetch();
+
+    /// Test DQSharedQuery::selectRelated()
+    void selectRelated();
+
+    /// Test the save and load of DQTypedField
+    void typedField();
+
+    /// Test DQModel::save() with dirty fields
+    void dirtyUpdate();
+
+    /// Test DQModel::upsert()
+    void upsert();
+
+    /// Test DQSharedQuery::update()
+    void bulkUpdate();
+
+    /// Test offset() and keyset pagination by DQQuery::after()
+    void pagination();
+
+    /// Test the result cache of DQSql
+    void resultCache();
+
+    /// Test the identity map of DQSql
+    void identityMap();
+
+    /// Test DQSharedQuery::columns()
+    void columnarResult();
+
+    /// Test DQEvaluator over DQColumnarResult
+    void evaluatorColumnar();
+
+    /// Test DQSharedQuery::bind()
+    void bindParameters();
+
+    /// Test allAsync() , countAsync() and callAsync()
+    void asyncQuery();
+
+    /// Test DQConnection::setWriteBehindEnabled()
+    void writeBehind();
+
+    /// Test DQConnectionOptions on open() and clone()
+    void connectionOptions();
+
+    /// Test DQConnection::setProfilingEnabled()
+    void profiling();
+
+    /// Test DQSharedQuery::explain() and DQIndexAdvisor
+    void explain();
+
+    /// Test DQSharedQuery::defer()
+    void deferredField();
+
+    /// Test DQSharedQuery::only() and autoOnly()
+    void autoOnly();
+
+    /// Test DQBlobStream
+    void blobStream();
+
+    /// Test the schema catalog of DQSql
+    void schemaCatalog();
+
+    /// Test DQConnection::migrate() and rebuildTable()
+    void migration();
+
+    /// Test DQSharedQuery::valuesList()
+    void valuesList();
+
+    /// Test DQSharedQuery::groupBy() and aggregate()
+    void aggregate();
+
+    /// Test DQWhere::in(DQSharedQuery) and DQWhere::exists()
+    void subquery();
+
+    /// Test DQWhere::in() with a list longer than the limit of parameters
+    void largeInList();
+
+    /// Test the copy-on-write "linked" model of DQForeignKey and move of models
+    void sharedCopy();
+
+    /// Test DQConnection::snapshot()
+    void snapshot();
+
+    /// Test DQSharedQuery::parallelForEach()
+    void parallelForEach();
+
+    /// Test DQSql::bulkInsert()
+    void bulkInsert();
+
+    /// Test DQSharedList::removeAll() and DQConnection::removeIds()
+    void removeAll();
+
+    /// Test DQBulkWriter
+    void bulkWriter();
+
+    /// Test DQConnection::exportSnapshot() and importSnapshot()
+    void exportSnapshot();
+
+    /// Test DQConnection::backupTo()
+    void backupTo();
+
+    /// Test DQConnection::watch()
+    void watch();
+
+    /// Test DQFullText , DQWhere::match() and DQSharedQuery::orderByRank()
+    void fullText();
+
+    /// Test DQGenerated fields and the expression index
+    void generatedColumn();
+
+    /// Test DQConnection::setMaintenanceEnabled() and DQSql::writeCounts()
+    void maintenance();
+
+    /// Test DQConnection::checkpoint() and DQMaintenanceOptions::checkpointSize
+    void checkpoint();
+
+    /// Test DQConnection::setRetryPolicy() and busyStats()
+    void busyRetry();
+
+    /// Test DQConnection::setReadWriteSplitEnabled()
+    void readWriteSplit();
+
+    /// Test DQShardedConnection
+    void shardedConnection();
+
+    /// Test DQConnection::attach() and bindSchema()
+    void attach();
+
+    /// Test DQConnection::openInMemory() and persist()
+    void inMemory();
+
+    /// Test DQConnection::registerFunction() and registerAggregate()
+    void sqlFunction();
+
+    /// Test DQConnection::stats() and DQStatsReporter
+    void connectionStats();
+
+    /// Test the schema fingerprint of DQConnection::createTables()
+    void schemaFingerprint();
+
 private:
     DQConnection connect;
     QSqlDatabase db;